@@ -41,3 +41,30 @@ void fillAes4Rx4(void *state, size_t outputSize, void *buffer);
 
 template<bool softAes>
 void hashAndFillAes1Rx4(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+
+//Hardware AES versions that process two lanes per instruction using VAES.
+//The output is identical to the functions above. If the library was built
+//without VAES support, they forward to the 128-bit implementation.
+bool aesVaesCompiled();
+
+void hashAes1Rx4Vaes(const void *input, size_t inputSize, void *hash);
+
+void fillAes1Rx4Vaes(void *state, size_t outputSize, void *buffer);
+
+void fillAes4Rx4Vaes(void *state, size_t outputSize, void *buffer);
+
+void hashAndFillAes1Rx4Vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
+
+//Constant-time software AES versions that compute the S-box with vector byte
+//shuffles (SSSE3 pshufb, NEON tbl) instead of table lookups. The output is
+//identical to the functions above. If the library was built without SSSE3
+//or NEON support, they forward to the table-based implementation.
+bool aesVpermCompiled();
+
+void hashAes1Rx4Vperm(const void *input, size_t inputSize, void *hash);
+
+void fillAes1Rx4Vperm(void *state, size_t outputSize, void *buffer);
+
+void fillAes4Rx4Vperm(void *state, size_t outputSize, void *buffer);
+
+void hashAndFillAes1Rx4Vperm(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state);
@@ -0,0 +1,221 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "aes_hash.hpp"
+#include "aes_hash_constants.hpp"
+#include <cassert>
+#include <cstdint>
+
+#if defined(__VAES__) || (defined(_MSC_VER) && defined(_M_X64))
+
+#include <immintrin.h>
+
+//The 4 lanes of the 128-bit implementation alternate between encryption
+//and decryption, so the lanes are paired as (0, 2) and (1, 3) in 256-bit
+//registers. One VAES instruction then performs the same rounds as two
+//AES-NI instructions and the memory layout is restored when storing.
+
+#define PAIR_I128(lo, hi) _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1)
+#define SET_PAIR(lo, hi) PAIR_I128(_mm_set_epi32(lo), _mm_set_epi32(hi))
+#define BROADCAST_I128(x) _mm256_broadcastsi128_si256(_mm_set_epi32(x))
+
+//[x0, x1], [x2, x3] <-> [x0, x2], [x1, x3]
+static inline void loadPairs(const void* ptr, __m256i& even, __m256i& odd) {
+	__m256i a = _mm256_loadu_si256((const __m256i*)ptr + 0);
+	__m256i b = _mm256_loadu_si256((const __m256i*)ptr + 1);
+	even = _mm256_permute2x128_si256(a, b, 0x20);
+	odd = _mm256_permute2x128_si256(a, b, 0x31);
+}
+
+static inline void storePairs(void* ptr, __m256i even, __m256i odd) {
+	_mm256_storeu_si256((__m256i*)ptr + 0, _mm256_permute2x128_si256(even, odd, 0x20));
+	_mm256_storeu_si256((__m256i*)ptr + 1, _mm256_permute2x128_si256(even, odd, 0x31));
+}
+
+bool aesVaesCompiled() {
+	return true;
+}
+
+void hashAes1Rx4Vaes(const void *input, size_t inputSize, void *hash) {
+	assert(inputSize % 64 == 0);
+	const uint8_t* inptr = (uint8_t*)input;
+	const uint8_t* inputEnd = inptr + inputSize;
+
+	//state0, state2 are encrypted, state1, state3 are decrypted
+	__m256i stateEnc = SET_PAIR(AES_HASH_1R_STATE0, AES_HASH_1R_STATE2);
+	__m256i stateDec = SET_PAIR(AES_HASH_1R_STATE1, AES_HASH_1R_STATE3);
+	__m256i inEnc, inDec;
+
+	while (inptr < inputEnd) {
+		loadPairs(inptr, inEnc, inDec);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, inEnc);
+		stateDec = _mm256_aesdec_epi128(stateDec, inDec);
+		inptr += 64;
+	}
+
+	//two extra rounds to achieve full diffusion
+	__m256i xkey0 = BROADCAST_I128(AES_HASH_1R_XKEY0);
+	__m256i xkey1 = BROADCAST_I128(AES_HASH_1R_XKEY1);
+
+	stateEnc = _mm256_aesenc_epi128(stateEnc, xkey0);
+	stateDec = _mm256_aesdec_epi128(stateDec, xkey0);
+	stateEnc = _mm256_aesenc_epi128(stateEnc, xkey1);
+	stateDec = _mm256_aesdec_epi128(stateDec, xkey1);
+
+	storePairs(hash, stateEnc, stateDec);
+}
+
+void fillAes1Rx4Vaes(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
+	uint8_t* outptr = (uint8_t*)buffer;
+	const uint8_t* outputEnd = outptr + outputSize;
+
+	//state0, state2 are decrypted, state1, state3 are encrypted
+	const __m256i keyDec = SET_PAIR(AES_GEN_1R_KEY0, AES_GEN_1R_KEY2);
+	const __m256i keyEnc = SET_PAIR(AES_GEN_1R_KEY1, AES_GEN_1R_KEY3);
+	__m256i stateDec, stateEnc;
+
+	loadPairs(state, stateDec, stateEnc);
+
+	while (outptr < outputEnd) {
+		stateDec = _mm256_aesdec_epi128(stateDec, keyDec);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, keyEnc);
+		storePairs(outptr, stateDec, stateEnc);
+		outptr += 64;
+	}
+
+	storePairs(state, stateDec, stateEnc);
+}
+
+void fillAes4Rx4Vaes(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
+	uint8_t* outptr = (uint8_t*)buffer;
+	const uint8_t* outputEnd = outptr + outputSize;
+
+	//lanes 0, 1 use keys 0-3 and lanes 2, 3 use keys 4-7
+	const __m256i key0 = SET_PAIR(AES_GEN_4R_KEY0, AES_GEN_4R_KEY4);
+	const __m256i key1 = SET_PAIR(AES_GEN_4R_KEY1, AES_GEN_4R_KEY5);
+	const __m256i key2 = SET_PAIR(AES_GEN_4R_KEY2, AES_GEN_4R_KEY6);
+	const __m256i key3 = SET_PAIR(AES_GEN_4R_KEY3, AES_GEN_4R_KEY7);
+	__m256i stateDec, stateEnc;
+
+	loadPairs(state, stateDec, stateEnc);
+
+	while (outptr < outputEnd) {
+		stateDec = _mm256_aesdec_epi128(stateDec, key0);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, key0);
+
+		stateDec = _mm256_aesdec_epi128(stateDec, key1);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, key1);
+
+		stateDec = _mm256_aesdec_epi128(stateDec, key2);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, key2);
+
+		stateDec = _mm256_aesdec_epi128(stateDec, key3);
+		stateEnc = _mm256_aesenc_epi128(stateEnc, key3);
+
+		storePairs(outptr, stateDec, stateEnc);
+		outptr += 64;
+	}
+}
+
+void hashAndFillAes1Rx4Vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	uint8_t* scratchpadPtr = (uint8_t*)scratchpad;
+	const uint8_t* scratchpadEnd = scratchpadPtr + scratchpadSize;
+
+	__m256i hashEnc = SET_PAIR(AES_HASH_1R_STATE0, AES_HASH_1R_STATE2);
+	__m256i hashDec = SET_PAIR(AES_HASH_1R_STATE1, AES_HASH_1R_STATE3);
+
+	const __m256i keyDec = SET_PAIR(AES_GEN_1R_KEY0, AES_GEN_1R_KEY2);
+	const __m256i keyEnc = SET_PAIR(AES_GEN_1R_KEY1, AES_GEN_1R_KEY3);
+	__m256i fillDec, fillEnc;
+
+	loadPairs(fill_state, fillDec, fillEnc);
+
+	constexpr int PREFETCH_DISTANCE = 4096;
+	const char* prefetchPtr = ((const char*)scratchpad) + PREFETCH_DISTANCE;
+	scratchpadEnd -= PREFETCH_DISTANCE;
+
+	for (int i = 0; i < 2; ++i) {
+		while (scratchpadPtr < scratchpadEnd) {
+			__m256i inEnc, inDec;
+			loadPairs(scratchpadPtr, inEnc, inDec);
+			hashEnc = _mm256_aesenc_epi128(hashEnc, inEnc);
+			hashDec = _mm256_aesdec_epi128(hashDec, inDec);
+
+			fillDec = _mm256_aesdec_epi128(fillDec, keyDec);
+			fillEnc = _mm256_aesenc_epi128(fillEnc, keyEnc);
+
+			storePairs(scratchpadPtr, fillDec, fillEnc);
+
+			_mm_prefetch(prefetchPtr, _MM_HINT_T0);
+
+			scratchpadPtr += 64;
+			prefetchPtr += 64;
+		}
+		prefetchPtr = (const char*) scratchpad;
+		scratchpadEnd += PREFETCH_DISTANCE;
+	}
+
+	storePairs(fill_state, fillDec, fillEnc);
+
+	//two extra rounds to achieve full diffusion
+	__m256i xkey0 = BROADCAST_I128(AES_HASH_1R_XKEY0);
+	__m256i xkey1 = BROADCAST_I128(AES_HASH_1R_XKEY1);
+
+	hashEnc = _mm256_aesenc_epi128(hashEnc, xkey0);
+	hashDec = _mm256_aesdec_epi128(hashDec, xkey0);
+	hashEnc = _mm256_aesenc_epi128(hashEnc, xkey1);
+	hashDec = _mm256_aesdec_epi128(hashDec, xkey1);
+
+	storePairs(hash, hashEnc, hashDec);
+}
+
+#else
+
+bool aesVaesCompiled() {
+	return false;
+}
+
+void hashAes1Rx4Vaes(const void *input, size_t inputSize, void *hash) {
+	hashAes1Rx4<false>(input, inputSize, hash);
+}
+
+void fillAes1Rx4Vaes(void *state, size_t outputSize, void *buffer) {
+	fillAes1Rx4<false>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4Vaes(void *state, size_t outputSize, void *buffer) {
+	fillAes4Rx4<false>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4Vaes(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	hashAndFillAes1Rx4<false>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#endif
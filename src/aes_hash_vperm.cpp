@@ -0,0 +1,374 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "aes_hash.hpp"
+#include "aes_hash_constants.hpp"
+#include <cassert>
+#include <cstdint>
+
+#if defined(__SSSE3__) || (defined(_MSC_VER) && defined(_M_X64)) || defined(__aarch64__)
+
+//Software AES without secret-dependent memory accesses. SubBytes is computed
+//with 16-entry byte shuffles (pshufb/tbl): the byte is mapped to the tower
+//field GF((2^4)^2) with y^2 = y + 8 over GF(2^4) = GF(2)[z]/(z^4 + z + 1),
+//inverted there using log/exp tables of GF(2^4) and mapped back. The input
+//and output maps also apply the AES affine transformation, so encryption and
+//decryption only differ in their tables.
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+typedef uint8x16_t vec_t;
+
+#define VEC_LOAD(p) vld1q_u8((const uint8_t*)(p))
+#define VEC_STORE(p, x) vst1q_u8((uint8_t*)(p), x)
+#define VEC_LOOKUP(t, i) vqtbl1q_u8(t, i) //indices >= 16 return 0
+#define VEC_XOR veorq_u8
+#define VEC_AND vandq_u8
+#define VEC_ADD8 vaddq_u8
+#define VEC_SUB8 vsubq_u8
+#define VEC_GT8(a, b) vcgtq_s8(vreinterpretq_s8_u8(a), vreinterpretq_s8_u8(b))
+#define VEC_SPLAT8 vdupq_n_u8
+#define VEC_HI4(x) vshrq_n_u8(x, 4)
+
+static inline vec_t vecSetInt(int i3, int i2, int i1, int i0) {
+	const int32_t data[4] = { i0, i1, i2, i3 };
+	return vreinterpretq_u8_s32(vld1q_s32(data));
+}
+
+#else
+
+#include <tmmintrin.h>
+
+typedef __m128i vec_t;
+
+#define VEC_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define VEC_STORE(p, x) _mm_storeu_si128((__m128i*)(p), x)
+#define VEC_LOOKUP(t, i) _mm_shuffle_epi8(t, i) //indices with bit 7 set return 0
+#define VEC_XOR _mm_xor_si128
+#define VEC_AND _mm_and_si128
+#define VEC_ADD8 _mm_add_epi8
+#define VEC_SUB8 _mm_sub_epi8
+#define VEC_GT8 _mm_cmpgt_epi8
+#define VEC_SPLAT8(x) _mm_set1_epi8((char)(x))
+#define VEC_HI4(x) _mm_and_si128(_mm_srli_epi16(x, 4), VEC_SPLAT8(0x0f))
+#define vecSetInt _mm_set_epi32
+
+#endif
+
+#define VEC_LO4(x) VEC_AND(x, VEC_SPLAT8(0x0f))
+
+//log2 of GF(2^4) elements (generator z), log(0) = 0xc0 keeps the sum of two
+//logarithms negative, so the exp lookup returns 0
+alignas(16) static const uint8_t gfLog[16] = { 0xc0, 0x00, 0x01, 0x04, 0x02, 0x08, 0x05, 0x0a, 0x03, 0x0e, 0x09, 0x07, 0x06, 0x0d, 0x0b, 0x0c };
+alignas(16) static const uint8_t gfExp[16] = { 0x01, 0x02, 0x04, 0x08, 0x03, 0x06, 0x0c, 0x0b, 0x05, 0x0a, 0x07, 0x0e, 0x0f, 0x0d, 0x09, 0x00 };
+//log(1/x)
+alignas(16) static const uint8_t gfLogInv[16] = { 0xc0, 0x00, 0x0e, 0x0b, 0x0d, 0x07, 0x0a, 0x05, 0x0c, 0x01, 0x06, 0x08, 0x09, 0x02, 0x04, 0x03 };
+//8 * x^2
+alignas(16) static const uint8_t gfLambdaSquare[16] = { 0x00, 0x08, 0x06, 0x0e, 0x0b, 0x03, 0x0d, 0x05, 0x0a, 0x02, 0x0c, 0x04, 0x01, 0x09, 0x07, 0x0f };
+
+//AES field -> tower field (decryption: inverse affine transformation first)
+alignas(16) static const uint8_t encInLo[16] = { 0x00, 0x01, 0x20, 0x21, 0x46, 0x47, 0x66, 0x67, 0x4c, 0x4d, 0x6c, 0x6d, 0x0a, 0x0b, 0x2a, 0x2b };
+alignas(16) static const uint8_t encInHi[16] = { 0x00, 0x3c, 0xd5, 0xe9, 0x34, 0x08, 0xe1, 0xdd, 0xe5, 0xd9, 0x30, 0x0c, 0xd1, 0xed, 0x04, 0x38 };
+alignas(16) static const uint8_t decInLo[16] = { 0x47, 0x1f, 0xd8, 0x80, 0xdf, 0x87, 0x40, 0x18, 0x6f, 0x37, 0xf0, 0xa8, 0xf7, 0xaf, 0x68, 0x30 };
+alignas(16) static const uint8_t decInHi[16] = { 0x00, 0x76, 0x79, 0x0f, 0xf9, 0x8f, 0x80, 0xf6, 0x92, 0xe4, 0xeb, 0x9d, 0x6b, 0x1d, 0x12, 0x64 };
+
+//tower field -> AES field (encryption: affine transformation included)
+alignas(16) static const uint8_t encOutLo[16] = { 0x63, 0x7c, 0xd1, 0xce, 0xc8, 0xd7, 0x7a, 0x65, 0x55, 0x4a, 0xe7, 0xf8, 0xfe, 0xe1, 0x4c, 0x53 };
+alignas(16) static const uint8_t encOutHi[16] = { 0x00, 0x52, 0x3e, 0x6c, 0x65, 0x37, 0x5b, 0x09, 0x60, 0x32, 0x5e, 0x0c, 0x05, 0x57, 0x3b, 0x69 };
+alignas(16) static const uint8_t decOutLo[16] = { 0x00, 0x01, 0x5c, 0x5d, 0xe0, 0xe1, 0xbc, 0xbd, 0x50, 0x51, 0x0c, 0x0d, 0xb0, 0xb1, 0xec, 0xed };
+alignas(16) static const uint8_t decOutHi[16] = { 0x00, 0xa2, 0x02, 0xa0, 0xb8, 0x1a, 0xba, 0x18, 0xdb, 0x79, 0xd9, 0x7b, 0x63, 0xc1, 0x61, 0xc3 };
+
+alignas(16) static const uint8_t shiftRows[16] = { 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 };
+alignas(16) static const uint8_t invShiftRows[16] = { 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 };
+alignas(16) static const uint8_t rotateColumn1[16] = { 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 };
+alignas(16) static const uint8_t rotateColumn2[16] = { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 };
+alignas(16) static const uint8_t rotateColumn3[16] = { 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14 };
+
+//a * b in GF(2^4) given log(a) and log(b)
+static inline vec_t gfMulLog(vec_t logA, vec_t logB) {
+	vec_t sum = VEC_ADD8(logA, logB);
+	sum = VEC_SUB8(sum, VEC_AND(VEC_GT8(sum, VEC_SPLAT8(14)), VEC_SPLAT8(15)));
+	return VEC_LOOKUP(VEC_LOAD(gfExp), sum);
+}
+
+static inline vec_t subBytes(vec_t x, const uint8_t* inLo, const uint8_t* inHi, const uint8_t* outLo, const uint8_t* outHi) {
+	const vec_t logTable = VEC_LOAD(gfLog);
+	vec_t t = VEC_XOR(VEC_LOOKUP(VEC_LOAD(inLo), VEC_LO4(x)), VEC_LOOKUP(VEC_LOAD(inHi), VEC_HI4(x)));
+	//x = h * y + l, 1/x = (h * y + h + l) / (8 * h^2 + l * (h + l))
+	vec_t h = VEC_HI4(t);
+	vec_t hl = VEC_XOR(h, VEC_LO4(t));
+	vec_t logL = VEC_LOOKUP(logTable, VEC_LO4(t));
+	vec_t logHl = VEC_LOOKUP(logTable, hl);
+	vec_t d = VEC_XOR(VEC_LOOKUP(VEC_LOAD(gfLambdaSquare), h), gfMulLog(logL, logHl));
+	vec_t logInvD = VEC_LOOKUP(VEC_LOAD(gfLogInv), d);
+	vec_t invH = gfMulLog(VEC_LOOKUP(logTable, h), logInvD);
+	vec_t invL = gfMulLog(logHl, logInvD);
+	return VEC_XOR(VEC_LOOKUP(VEC_LOAD(outHi), invH), VEC_LOOKUP(VEC_LOAD(outLo), invL));
+}
+
+static inline vec_t xtime(vec_t x) {
+	vec_t carry = VEC_AND(VEC_GT8(VEC_SPLAT8(0), x), VEC_SPLAT8(0x1b));
+	return VEC_XOR(VEC_ADD8(x, x), carry);
+}
+
+static inline vec_t mixColumns(vec_t x) {
+	vec_t r1 = VEC_LOOKUP(x, VEC_LOAD(rotateColumn1));
+	vec_t r2 = VEC_LOOKUP(x, VEC_LOAD(rotateColumn2));
+	vec_t r3 = VEC_LOOKUP(x, VEC_LOAD(rotateColumn3));
+	//2 * x0 + 3 * x1 + x2 + x3
+	return VEC_XOR(VEC_XOR(xtime(VEC_XOR(x, r1)), r1), VEC_XOR(r2, r3));
+}
+
+static inline vec_t invMixColumns(vec_t x) {
+	//InvMixColumns = MixColumns * (1 + 4 * (1 + y^2)) with y = column rotation
+	vec_t r2 = VEC_LOOKUP(x, VEC_LOAD(rotateColumn2));
+	x = VEC_XOR(x, xtime(xtime(VEC_XOR(x, r2))));
+	return mixColumns(x);
+}
+
+//same results as the AESENC and AESDEC instructions
+static inline vec_t aesenc(vec_t state, vec_t key) {
+	state = VEC_LOOKUP(state, VEC_LOAD(shiftRows));
+	state = subBytes(state, encInLo, encInHi, encOutLo, encOutHi);
+	return VEC_XOR(mixColumns(state), key);
+}
+
+static inline vec_t aesdec(vec_t state, vec_t key) {
+	state = VEC_LOOKUP(state, VEC_LOAD(invShiftRows));
+	state = subBytes(state, decInLo, decInHi, decOutLo, decOutHi);
+	return VEC_XOR(invMixColumns(state), key);
+}
+
+bool aesVpermCompiled() {
+	return true;
+}
+
+void hashAes1Rx4Vperm(const void *input, size_t inputSize, void *hash) {
+	assert(inputSize % 64 == 0);
+	const uint8_t* inptr = (uint8_t*)input;
+	const uint8_t* inputEnd = inptr + inputSize;
+
+	vec_t state0 = vecSetInt(AES_HASH_1R_STATE0);
+	vec_t state1 = vecSetInt(AES_HASH_1R_STATE1);
+	vec_t state2 = vecSetInt(AES_HASH_1R_STATE2);
+	vec_t state3 = vecSetInt(AES_HASH_1R_STATE3);
+
+	while (inptr < inputEnd) {
+		state0 = aesenc(state0, VEC_LOAD(inptr + 0));
+		state1 = aesdec(state1, VEC_LOAD(inptr + 16));
+		state2 = aesenc(state2, VEC_LOAD(inptr + 32));
+		state3 = aesdec(state3, VEC_LOAD(inptr + 48));
+		inptr += 64;
+	}
+
+	const vec_t xkey0 = vecSetInt(AES_HASH_1R_XKEY0);
+	const vec_t xkey1 = vecSetInt(AES_HASH_1R_XKEY1);
+
+	state0 = aesenc(aesenc(state0, xkey0), xkey1);
+	state1 = aesdec(aesdec(state1, xkey0), xkey1);
+	state2 = aesenc(aesenc(state2, xkey0), xkey1);
+	state3 = aesdec(aesdec(state3, xkey0), xkey1);
+
+	uint8_t* outptr = (uint8_t*)hash;
+	VEC_STORE(outptr + 0, state0);
+	VEC_STORE(outptr + 16, state1);
+	VEC_STORE(outptr + 32, state2);
+	VEC_STORE(outptr + 48, state3);
+}
+
+void fillAes1Rx4Vperm(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
+	uint8_t* outptr = (uint8_t*)buffer;
+	const uint8_t* outputEnd = outptr + outputSize;
+	uint8_t* stateptr = (uint8_t*)state;
+
+	const vec_t key0 = vecSetInt(AES_GEN_1R_KEY0);
+	const vec_t key1 = vecSetInt(AES_GEN_1R_KEY1);
+	const vec_t key2 = vecSetInt(AES_GEN_1R_KEY2);
+	const vec_t key3 = vecSetInt(AES_GEN_1R_KEY3);
+
+	vec_t state0 = VEC_LOAD(stateptr + 0);
+	vec_t state1 = VEC_LOAD(stateptr + 16);
+	vec_t state2 = VEC_LOAD(stateptr + 32);
+	vec_t state3 = VEC_LOAD(stateptr + 48);
+
+	while (outptr < outputEnd) {
+		state0 = aesdec(state0, key0);
+		state1 = aesenc(state1, key1);
+		state2 = aesdec(state2, key2);
+		state3 = aesenc(state3, key3);
+
+		VEC_STORE(outptr + 0, state0);
+		VEC_STORE(outptr + 16, state1);
+		VEC_STORE(outptr + 32, state2);
+		VEC_STORE(outptr + 48, state3);
+
+		outptr += 64;
+	}
+
+	VEC_STORE(stateptr + 0, state0);
+	VEC_STORE(stateptr + 16, state1);
+	VEC_STORE(stateptr + 32, state2);
+	VEC_STORE(stateptr + 48, state3);
+}
+
+void fillAes4Rx4Vperm(void *state, size_t outputSize, void *buffer) {
+	assert(outputSize % 64 == 0);
+	uint8_t* outptr = (uint8_t*)buffer;
+	const uint8_t* outputEnd = outptr + outputSize;
+	const uint8_t* stateptr = (const uint8_t*)state;
+
+	const vec_t key0 = vecSetInt(AES_GEN_4R_KEY0);
+	const vec_t key1 = vecSetInt(AES_GEN_4R_KEY1);
+	const vec_t key2 = vecSetInt(AES_GEN_4R_KEY2);
+	const vec_t key3 = vecSetInt(AES_GEN_4R_KEY3);
+	const vec_t key4 = vecSetInt(AES_GEN_4R_KEY4);
+	const vec_t key5 = vecSetInt(AES_GEN_4R_KEY5);
+	const vec_t key6 = vecSetInt(AES_GEN_4R_KEY6);
+	const vec_t key7 = vecSetInt(AES_GEN_4R_KEY7);
+
+	vec_t state0 = VEC_LOAD(stateptr + 0);
+	vec_t state1 = VEC_LOAD(stateptr + 16);
+	vec_t state2 = VEC_LOAD(stateptr + 32);
+	vec_t state3 = VEC_LOAD(stateptr + 48);
+
+	while (outptr < outputEnd) {
+		state0 = aesdec(state0, key0);
+		state1 = aesenc(state1, key0);
+		state2 = aesdec(state2, key4);
+		state3 = aesenc(state3, key4);
+
+		state0 = aesdec(state0, key1);
+		state1 = aesenc(state1, key1);
+		state2 = aesdec(state2, key5);
+		state3 = aesenc(state3, key5);
+
+		state0 = aesdec(state0, key2);
+		state1 = aesenc(state1, key2);
+		state2 = aesdec(state2, key6);
+		state3 = aesenc(state3, key6);
+
+		state0 = aesdec(state0, key3);
+		state1 = aesenc(state1, key3);
+		state2 = aesdec(state2, key7);
+		state3 = aesenc(state3, key7);
+
+		VEC_STORE(outptr + 0, state0);
+		VEC_STORE(outptr + 16, state1);
+		VEC_STORE(outptr + 32, state2);
+		VEC_STORE(outptr + 48, state3);
+
+		outptr += 64;
+	}
+}
+
+void hashAndFillAes1Rx4Vperm(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	uint8_t* scratchpadPtr = (uint8_t*)scratchpad;
+	const uint8_t* scratchpadEnd = scratchpadPtr + scratchpadSize;
+	uint8_t* stateptr = (uint8_t*)fill_state;
+
+	vec_t hash_state0 = vecSetInt(AES_HASH_1R_STATE0);
+	vec_t hash_state1 = vecSetInt(AES_HASH_1R_STATE1);
+	vec_t hash_state2 = vecSetInt(AES_HASH_1R_STATE2);
+	vec_t hash_state3 = vecSetInt(AES_HASH_1R_STATE3);
+
+	const vec_t key0 = vecSetInt(AES_GEN_1R_KEY0);
+	const vec_t key1 = vecSetInt(AES_GEN_1R_KEY1);
+	const vec_t key2 = vecSetInt(AES_GEN_1R_KEY2);
+	const vec_t key3 = vecSetInt(AES_GEN_1R_KEY3);
+
+	vec_t fill_state0 = VEC_LOAD(stateptr + 0);
+	vec_t fill_state1 = VEC_LOAD(stateptr + 16);
+	vec_t fill_state2 = VEC_LOAD(stateptr + 32);
+	vec_t fill_state3 = VEC_LOAD(stateptr + 48);
+
+	//the scratchpad is hashed before it's overwritten by the fill
+	while (scratchpadPtr < scratchpadEnd) {
+		hash_state0 = aesenc(hash_state0, VEC_LOAD(scratchpadPtr + 0));
+		hash_state1 = aesdec(hash_state1, VEC_LOAD(scratchpadPtr + 16));
+		hash_state2 = aesenc(hash_state2, VEC_LOAD(scratchpadPtr + 32));
+		hash_state3 = aesdec(hash_state3, VEC_LOAD(scratchpadPtr + 48));
+
+		fill_state0 = aesdec(fill_state0, key0);
+		fill_state1 = aesenc(fill_state1, key1);
+		fill_state2 = aesdec(fill_state2, key2);
+		fill_state3 = aesenc(fill_state3, key3);
+
+		VEC_STORE(scratchpadPtr + 0, fill_state0);
+		VEC_STORE(scratchpadPtr + 16, fill_state1);
+		VEC_STORE(scratchpadPtr + 32, fill_state2);
+		VEC_STORE(scratchpadPtr + 48, fill_state3);
+
+		scratchpadPtr += 64;
+	}
+
+	VEC_STORE(stateptr + 0, fill_state0);
+	VEC_STORE(stateptr + 16, fill_state1);
+	VEC_STORE(stateptr + 32, fill_state2);
+	VEC_STORE(stateptr + 48, fill_state3);
+
+	const vec_t xkey0 = vecSetInt(AES_HASH_1R_XKEY0);
+	const vec_t xkey1 = vecSetInt(AES_HASH_1R_XKEY1);
+
+	hash_state0 = aesenc(aesenc(hash_state0, xkey0), xkey1);
+	hash_state1 = aesdec(aesdec(hash_state1, xkey0), xkey1);
+	hash_state2 = aesenc(aesenc(hash_state2, xkey0), xkey1);
+	hash_state3 = aesdec(aesdec(hash_state3, xkey0), xkey1);
+
+	uint8_t* outptr = (uint8_t*)hash;
+	VEC_STORE(outptr + 0, hash_state0);
+	VEC_STORE(outptr + 16, hash_state1);
+	VEC_STORE(outptr + 32, hash_state2);
+	VEC_STORE(outptr + 48, hash_state3);
+}
+
+#else
+
+bool aesVpermCompiled() {
+	return false;
+}
+
+void hashAes1Rx4Vperm(const void *input, size_t inputSize, void *hash) {
+	hashAes1Rx4<true>(input, inputSize, hash);
+}
+
+void fillAes1Rx4Vperm(void *state, size_t outputSize, void *buffer) {
+	fillAes1Rx4<true>(state, outputSize, buffer);
+}
+
+void fillAes4Rx4Vperm(void *state, size_t outputSize, void *buffer) {
+	fillAes4Rx4<true>(state, outputSize, buffer);
+}
+
+void hashAndFillAes1Rx4Vperm(void *scratchpad, size_t scratchpadSize, void *hash, void* fill_state) {
+	hashAndFillAes1Rx4<true>(scratchpad, scratchpadSize, hash, fill_state);
+}
+
+#endif
@@ -35,10 +35,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace randomx {
 
 	template<size_t alignment>
-	void* AlignedAllocator<alignment>::allocMemory(size_t count) {
+	void* AlignedAllocator<alignment>::allocMemory(size_t count, randomx_page_backing* backing) {
 		void *mem = rx_aligned_alloc(count, alignment);
 		if (mem == nullptr)
 			throw std::bad_alloc();
+		if (backing != nullptr)
+			*backing = RANDOMX_PAGES_STANDARD;
 		return mem;
 	}
 
@@ -48,11 +50,19 @@ namespace randomx {
 	}
 
 	template struct AlignedAllocator<CacheLineSize>;
+	template struct AlignedAllocator<CacheAlignment>;
 
-	void* LargePageAllocator::allocMemory(size_t count) {
+	void* LargePageAllocator::allocMemory(size_t count, randomx_page_backing* backing) {
+		randomx_page_backing type = RANDOMX_PAGES_LARGE;
 		void *mem = allocLargePagesMemory(count);
+		if (mem == nullptr) {
+			mem = allocTransparentHugePagesMemory(count);
+			type = RANDOMX_PAGES_TRANSPARENT;
+		}
 		if (mem == nullptr)
 			throw std::bad_alloc();
+		if (backing != nullptr)
+			*backing = type;
 		return mem;
 	}
 
@@ -60,4 +70,64 @@ namespace randomx {
 		freePagedMemory(ptr, count);
 	};
 
+	void* GigaPageAllocator::allocMemory(size_t count, randomx_page_backing* backing) {
+		void *mem = allocGigaPagesMemory(count);
+		if (mem == nullptr)
+			throw std::bad_alloc();
+		if (backing != nullptr)
+			*backing = RANDOMX_PAGES_1GB;
+		return mem;
+	}
+
+	void GigaPageAllocator::freeMemory(void* ptr, size_t count) {
+		freeGigaPagesMemory(ptr, count);
+	};
+
+	static randomx_allocator customAllocator = {};
+
+	bool hasCustomAllocator() {
+		return customAllocator.alloc != nullptr;
+	}
+
+	void setCustomAllocator(const randomx_allocator* allocator) {
+		if (allocator != nullptr)
+			customAllocator = *allocator;
+		else
+			customAllocator = {};
+	}
+
+	template<randomx_memory_purpose purpose>
+	void* CustomAllocator<purpose>::allocMemory(size_t count, randomx_page_backing* backing) {
+		size_t alignment = purpose == RANDOMX_MEMORY_JIT ? getPageSize() : CacheLineSize;
+		void *mem = customAllocator.alloc(count, alignment, purpose, customAllocator.userData);
+		if (mem == nullptr)
+			throw std::bad_alloc();
+		if (backing != nullptr)
+			*backing = RANDOMX_PAGES_CUSTOM;
+		return mem;
+	}
+
+	template<randomx_memory_purpose purpose>
+	void CustomAllocator<purpose>::freeMemory(void* ptr, size_t count) {
+		customAllocator.free(ptr, count, purpose, customAllocator.userData);
+	}
+
+	template struct CustomAllocator<RANDOMX_MEMORY_CACHE>;
+	template struct CustomAllocator<RANDOMX_MEMORY_DATASET>;
+	template struct CustomAllocator<RANDOMX_MEMORY_SCRATCHPAD>;
+	template struct CustomAllocator<RANDOMX_MEMORY_JIT>;
+
+	void* allocCodeMemory(size_t count) {
+		if (hasCustomAllocator())
+			return customAllocator.alloc(count, getPageSize(), RANDOMX_MEMORY_JIT, customAllocator.userData);
+		return allocMemoryPages(count);
+	}
+
+	void freeCodeMemory(void* ptr, size_t count) {
+		if (hasCustomAllocator())
+			customAllocator.free(ptr, count, RANDOMX_MEMORY_JIT, customAllocator.userData);
+		else
+			freePagedMemory(ptr, count);
+	}
+
 }
@@ -29,18 +29,39 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <cstddef>
+#include "randomx.h"
 
 namespace randomx {
 
 	template<size_t alignment>
 	struct AlignedAllocator {
-		static void* allocMemory(size_t);
+		static void* allocMemory(size_t, randomx_page_backing* backing = nullptr);
 		static void freeMemory(void*, size_t);
 	};
 
+	//falls back to transparent huge pages if no large pages are reserved
 	struct LargePageAllocator {
-		static void* allocMemory(size_t);
+		static void* allocMemory(size_t, randomx_page_backing* backing = nullptr);
 		static void freeMemory(void*, size_t);
 	};
 
+	struct GigaPageAllocator {
+		static void* allocMemory(size_t, randomx_page_backing* backing = nullptr);
+		static void freeMemory(void*, size_t);
+	};
+
+	//uses the callbacks set with randomx_set_allocator
+	template<randomx_memory_purpose purpose>
+	struct CustomAllocator {
+		static void* allocMemory(size_t, randomx_page_backing* backing = nullptr);
+		static void freeMemory(void*, size_t);
+	};
+
+	bool hasCustomAllocator();
+	void setCustomAllocator(const randomx_allocator*);
+
+	//memory for JIT compiled code, page aligned
+	void* allocCodeMemory(size_t);
+	void freeCodeMemory(void*, size_t);
+
 }
\ No newline at end of file
@@ -151,7 +151,9 @@ typedef enum Argon2_ErrorCodes {
 
 	ARGON2_DECODING_LENGTH_FAIL = -34,
 
-	ARGON2_VERIFY_MISMATCH = -35
+	ARGON2_VERIFY_MISMATCH = -35,
+
+	ARGON2_ABORTED = -36
 } argon2_error_codes;
 
 /* Memory allocator types --- for external allocation */
@@ -255,6 +257,8 @@ void randomx_argon2_fill_segment_ref(const argon2_instance_t* instance,
 
 randomx_argon2_impl *randomx_argon2_impl_ssse3();
 randomx_argon2_impl *randomx_argon2_impl_avx2();
+randomx_argon2_impl *randomx_argon2_impl_avx512();
+randomx_argon2_impl *randomx_argon2_impl_neon();
 
 #if defined(__cplusplus)
 }
@@ -155,6 +155,7 @@ void randomx_argon2_fill_segment_avx2(const argon2_instance_t* instance,
 		/* 2 Creating a new block */
 		ref_block =
 			instance->memory + instance->lane_length * ref_lane + ref_index;
+		ARGON2_PREFETCH_BLOCK(ref_block);
 		curr_block = instance->memory + curr_offset;
 		if (ARGON2_VERSION_10 == instance->version) {
 			/* version 1.2.1 and earlier: overwrite, not XOR */
@@ -49,6 +49,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "argon2_core.h"
 #include "blake2/blake2.h"
 #include "blake2/blake2-impl.h"
+#include "tracepoints.h"
 
 #ifdef GENKAT
 #include "genkat.h"
@@ -160,8 +161,10 @@ uint32_t randomx_argon2_index_alpha(const argon2_instance_t *instance,
 }
 
 /* Single-threaded version for p=1 case */
-static int fill_memory_blocks_st(argon2_instance_t *instance) {
+static int fill_memory_blocks_st(argon2_instance_t *instance, randomx_argon2_segment_cbk *callback, void *data) {
 	uint32_t r, s, l;
+	uint32_t done = 0;
+	uint32_t total = instance->passes * ARGON2_SYNC_POINTS * instance->lanes;
 
 	for (r = 0; r < instance->passes; ++r) {
 		for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
@@ -169,8 +172,13 @@ static int fill_memory_blocks_st(argon2_instance_t *instance) {
 				argon2_position_t position = { r, l, (uint8_t)s, 0 };
 				//fill the segment using the selected implementation
 				instance->impl(instance, position);
+				++done;
+				if (callback != NULL && callback(data, done, total) != 0) {
+					return ARGON2_ABORTED;
+				}
 			}
 		}
+		RANDOMX_TRACE2(argon2_pass, instance->memory, r);
 	}
 	return ARGON2_OK;
 }
@@ -179,7 +187,14 @@ int randomx_argon2_fill_memory_blocks(argon2_instance_t *instance) {
 	if (instance == NULL || instance->lanes == 0) {
 		return ARGON2_INCORRECT_PARAMETER;
 	}
-	return fill_memory_blocks_st(instance);
+	return fill_memory_blocks_st(instance, NULL, NULL);
+}
+
+int randomx_argon2_fill_memory_blocks_cbk(argon2_instance_t *instance, randomx_argon2_segment_cbk *callback, void *data) {
+	if (instance == NULL || instance->lanes == 0) {
+		return ARGON2_INCORRECT_PARAMETER;
+	}
+	return fill_memory_blocks_st(instance, callback, data);
 }
 
 int randomx_argon2_validate_inputs(const argon2_context *context) {
@@ -44,6 +44,25 @@ extern "C" {
 
 #define CONST_CAST(x) (x)(uintptr_t)
 
+/* Requests all cache lines of a memory block at once, so that the cache misses
+   of a pseudo-random reference block overlap instead of being taken one by one */
+#if defined(__GNUC__)
+#define ARGON2_PREFETCH(x) __builtin_prefetch((x), 0, 3)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define ARGON2_PREFETCH(x) _mm_prefetch((const char *)(x), _MM_HINT_T0)
+#else
+#define ARGON2_PREFETCH(x)
+#endif
+
+#define ARGON2_PREFETCH_BLOCK(b) \
+	do { \
+		unsigned prefetch_line_; \
+		for (prefetch_line_ = 0; prefetch_line_ < ARGON2_BLOCK_SIZE; prefetch_line_ += 64) { \
+			ARGON2_PREFETCH((const uint8_t *)(b) + prefetch_line_); \
+		} \
+	} while ((void)0, 0)
+
  /**********************Argon2 internal constants*******************************/
 
 enum argon2_core_constants {
@@ -156,6 +175,23 @@ int randomx_argon2_initialize(argon2_instance_t *instance, argon2_context *conte
  */
 int randomx_argon2_fill_memory_blocks(argon2_instance_t* instance);
 
+/*
+ * Called after each filled segment with the number of finished segments
+ * (passes * ARGON2_SYNC_POINTS * lanes in total). A non-zero return value stops
+ * the filling.
+ */
+typedef int randomx_argon2_segment_cbk(void* data, uint32_t done, uint32_t total);
+
+/*
+ * Same as randomx_argon2_fill_memory_blocks, but reports every filled segment
+ * @param instance Pointer to the current instance
+ * @param callback Function called after each segment
+ * @param data Passed to the callback
+ * @return ARGON2_OK if all segments were filled, ARGON2_ABORTED if the callback
+ * stopped the filling
+ */
+int randomx_argon2_fill_memory_blocks_cbk(argon2_instance_t* instance, randomx_argon2_segment_cbk* callback, void* data);
+
 #if defined(__cplusplus)
 }
 #endif
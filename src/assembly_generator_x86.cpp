@@ -27,6 +27,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <climits>
+#include <iomanip>
 #include "assembly_generator_x86.hpp"
 #include "common.hpp"
 #include "reciprocal.h"
@@ -51,6 +52,16 @@ namespace randomx {
 	static const char* regIc8 = "bl";
 	static const char* regScratchpadAddr = "rsi";
 
+	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
+	static const uint64_t superscalarAdd[] = { 0, 9298411001130361340ULL, 12065312585734608966ULL, 9306329213124626780ULL,
+		5281919268842080866ULL, 10536153434571861004ULL, 3398623926847679864ULL, 9549104520008361294ULL };
+
+	static std::string hex64(uint64_t value) {
+		std::ostringstream os;
+		os << "0x" << std::hex << std::setw(16) << std::setfill('0') << value << "ULL";
+		return os.str();
+	}
+
 	void AssemblyGeneratorX86::generateProgram(Program& prog) {
 		for (unsigned i = 0; i < RegistersCount; ++i) {
 			registerUsage[i] = -1;
@@ -139,9 +150,9 @@ namespace randomx {
 		}
 	}
 
-	void AssemblyGeneratorX86::generateC(SuperscalarProgram& prog) {
-		asmCode.str(std::string()); //clear
+	void AssemblyGeneratorX86::generateCHelpers() {
 		asmCode << "#include <stdint.h>" << std::endl;
+		asmCode << "#include <string.h>" << std::endl;
 		asmCode << "#if defined(__SIZEOF_INT128__)" << std::endl;
 		asmCode << "	static inline uint64_t mulh(uint64_t a, uint64_t b) {" << std::endl;
 		asmCode << "		return ((unsigned __int128)a * b) >> 64;" << std::endl;
@@ -185,52 +196,122 @@ namespace randomx {
 		asmCode << "#if !defined(HAVE_MULH) || !defined(HAVE_SMULH) || !defined(HAVE_ROTR)" << std::endl;
 		asmCode << "	#error \"Required functions are not defined\"" << std::endl;
 		asmCode << "#endif" << std::endl;
+		asmCode << "static inline uint64_t load64(const uint8_t* p) {" << std::endl;
+		asmCode << "	uint64_t v;" << std::endl;
+		asmCode << "	memcpy(&v, p, sizeof(v));" << std::endl;
+		asmCode << "	return v;" << std::endl;
+		asmCode << "}" << std::endl;
+		asmCode << "#if defined(_MSC_VER)" << std::endl;
+		asmCode << "	#include <xmmintrin.h>" << std::endl;
+		asmCode << "	#define PREFETCH(addr) _mm_prefetch((const char*)(addr), _MM_HINT_NTA)" << std::endl;
+		asmCode << "#elif defined(__GNUC__)" << std::endl;
+		asmCode << "	#define PREFETCH(addr) __builtin_prefetch((addr), 0, 0)" << std::endl;
+		asmCode << "#else" << std::endl;
+		asmCode << "	#define PREFETCH(addr)" << std::endl;
+		asmCode << "#endif" << std::endl;
+	}
+
+	void AssemblyGeneratorX86::generateCInstruction(Instruction& instr) {
+		switch ((SuperscalarInstructionType)instr.opcode)
+		{
+		case SuperscalarInstructionType::ISUB_R:
+			asmCode << regR[instr.dst] << " -= " << regR[instr.src] << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IXOR_R:
+			asmCode << regR[instr.dst] << " ^= " << regR[instr.src] << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IADD_RS:
+			asmCode << regR[instr.dst] << " += " << regR[instr.src] << "*" << (1 << (instr.getModShift())) << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IMUL_R:
+			asmCode << regR[instr.dst] << " *= " << regR[instr.src] << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IROR_C:
+			asmCode << regR[instr.dst] << " = rotr(" << regR[instr.dst] << ", " << instr.getImm32() << ");" << std::endl;
+			break;
+		case SuperscalarInstructionType::IADD_C7:
+		case SuperscalarInstructionType::IADD_C8:
+		case SuperscalarInstructionType::IADD_C9:
+			asmCode << regR[instr.dst] << " += " << hex64((int32_t)instr.getImm32()) << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IXOR_C7:
+		case SuperscalarInstructionType::IXOR_C8:
+		case SuperscalarInstructionType::IXOR_C9:
+			asmCode << regR[instr.dst] << " ^= " << hex64((int32_t)instr.getImm32()) << ";" << std::endl;
+			break;
+		case SuperscalarInstructionType::IMULH_R:
+			asmCode << regR[instr.dst] << " = mulh(" << regR[instr.dst] << ", " << regR[instr.src] << ");" << std::endl;
+			break;
+		case SuperscalarInstructionType::ISMULH_R:
+			asmCode << regR[instr.dst] << " = smulh(" << regR[instr.dst] << ", " << regR[instr.src] << ");" << std::endl;
+			break;
+		case SuperscalarInstructionType::IMUL_RCP:
+			asmCode << regR[instr.dst] << " *= " << hex64(randomx_reciprocal(instr.getImm32())) << ";" << std::endl;
+			break;
+		default:
+			UNREACHABLE;
+		}
+	}
+
+	void AssemblyGeneratorX86::generateC(SuperscalarProgram& prog) {
+		asmCode.str(std::string()); //clear
+		generateCHelpers();
 		asmCode << "void superScalar(uint64_t r[8]) {" << std::endl;
 		asmCode << "uint64_t r8 = r[0], r9 = r[1], r10 = r[2], r11 = r[3], r12 = r[4], r13 = r[5], r14 = r[6], r15 = r[7];" << std::endl;
 		for (unsigned i = 0; i < prog.getSize(); ++i) {
-			Instruction& instr = prog(i);
-			switch ((SuperscalarInstructionType)instr.opcode)
-			{
-			case SuperscalarInstructionType::ISUB_R:
-				asmCode << regR[instr.dst] << " -= " << regR[instr.src] << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IXOR_R:
-				asmCode << regR[instr.dst] << " ^= " << regR[instr.src] << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IADD_RS:
-				asmCode << regR[instr.dst] << " += " << regR[instr.src] << "*" << (1 << (instr.getModShift())) << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IMUL_R:
-				asmCode << regR[instr.dst] << " *= " << regR[instr.src] << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IROR_C:
-				asmCode << regR[instr.dst] << " = rotr(" << regR[instr.dst] << ", " << instr.getImm32() << ");" << std::endl;
-				break;
-			case SuperscalarInstructionType::IADD_C7:
-			case SuperscalarInstructionType::IADD_C8:
-			case SuperscalarInstructionType::IADD_C9:
-				asmCode << regR[instr.dst] << " += " << (int32_t)instr.getImm32() << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IXOR_C7:
-			case SuperscalarInstructionType::IXOR_C8:
-			case SuperscalarInstructionType::IXOR_C9:
-				asmCode << regR[instr.dst] << " ^= " << (int32_t)instr.getImm32() << ";" << std::endl;
-				break;
-			case SuperscalarInstructionType::IMULH_R:
-				asmCode << regR[instr.dst] << " = mulh(" << regR[instr.dst] << ", " << regR[instr.src] << ");" << std::endl;
-				break;
-			case SuperscalarInstructionType::ISMULH_R:
-				asmCode << regR[instr.dst] << " = smulh(" << regR[instr.dst] << ", " << regR[instr.src] << ");" << std::endl;
-				break;
-			case SuperscalarInstructionType::IMUL_RCP:
-				asmCode << regR[instr.dst] << " *= " << (int64_t)randomx_reciprocal(instr.getImm32()) << ";" << std::endl;
-				break;
-			default:
-				UNREACHABLE;
+			generateCInstruction(prog(i));
+		}
+		asmCode << "r[0] = r8; r[1] = r9; r[2] = r10; r[3] = r11; r[4] = r12; r[5] = r13; r[6] = r14; r[7] = r15;" << std::endl;
+		asmCode << "}" << std::endl;
+	}
+
+	static void generateHashBytes(std::ostream& os, const uint8_t (&hash)[32]) {
+		os << "\t{";
+		for (unsigned i = 0; i < 32; ++i) {
+			os << (i % 8 == 0 ? "\n\t\t" : " ") << "0x" << std::hex << std::setw(2) << std::setfill('0') << (unsigned)hash[i] << std::dec << ",";
+		}
+		os << "\n\t}," << std::endl;
+	}
+
+	void AssemblyGeneratorX86::generateDatasetC(SuperscalarProgram (&programs)[RANDOMX_CACHE_ACCESSES], const uint8_t (&keyHash)[32], const uint8_t (&configHash)[32], const char* name) {
+		asmCode.str(std::string()); //clear
+		asmCode << "/* Generated by randomx-codegen --genDatasetC. Only valid for the key and configuration hashed below. */" << std::endl;
+		generateCHelpers();
+		asmCode << "#include \"randomx.h\"" << std::endl;
+		asmCode << "static void initItem(const void* cacheMemory, void* output, uint64_t itemNumber) {" << std::endl;
+		asmCode << "const uint8_t* cache = (const uint8_t*)cacheMemory;" << std::endl;
+		asmCode << "const uint8_t* mix;" << std::endl;
+		asmCode << "uint64_t r8, r9, r10, r11, r12, r13, r14, r15, address = itemNumber;" << std::endl;
+		asmCode << "uint64_t r[8];" << std::endl;
+		asmCode << "r8 = (itemNumber + 1) * " << hex64(superscalarMul0) << ";" << std::endl;
+		for (unsigned j = 1; j < RegistersCount; ++j) {
+			asmCode << regR[j] << " = r8 ^ " << hex64(superscalarAdd[j]) << ";" << std::endl;
+		}
+		for (unsigned i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			SuperscalarProgram& prog = programs[i];
+			asmCode << "mix = cache + (address & " << hex64(CacheSize / CacheLineSize - 1) << ") * " << CacheLineSize << ";" << std::endl;
+			asmCode << "PREFETCH(mix);" << std::endl;
+			for (unsigned j = 0; j < prog.getSize(); ++j) {
+				generateCInstruction(prog(j));
+			}
+			for (unsigned j = 0; j < RegistersCount; ++j) {
+				asmCode << regR[j] << " ^= load64(mix + " << 8 * j << ");" << std::endl;
+			}
+			if (i + 1 < RANDOMX_CACHE_ACCESSES) {
+				asmCode << "address = " << regR[prog.getAddressRegister()] << ";" << std::endl;
 			}
 		}
 		asmCode << "r[0] = r8; r[1] = r9; r[2] = r10; r[3] = r11; r[4] = r12; r[5] = r13; r[6] = r14; r[7] = r15;" << std::endl;
+		asmCode << "memcpy(output, r, sizeof(r));" << std::endl;
 		asmCode << "}" << std::endl;
+		asmCode << "#if defined(__cplusplus)" << std::endl;
+		asmCode << "extern \"C\"" << std::endl;
+		asmCode << "#endif" << std::endl;
+		asmCode << "const randomx_aot_module " << name << " = {" << std::endl;
+		generateHashBytes(asmCode, keyHash);
+		generateHashBytes(asmCode, configHash);
+		asmCode << "\t&initItem" << std::endl;
+		asmCode << "};" << std::endl;
 	}
 
 	void AssemblyGeneratorX86::traceint(Instruction& instr) {
@@ -45,10 +45,13 @@ namespace randomx {
 		void generateProgram(Program& prog);
 		void generateAsm(SuperscalarProgram& prog);
 		void generateC(SuperscalarProgram& prog);
+		void generateDatasetC(SuperscalarProgram (&programs)[RANDOMX_CACHE_ACCESSES], const uint8_t (&keyHash)[32], const uint8_t (&configHash)[32], const char* name);
 		void printCode(std::ostream& os) {
 			os << asmCode.rdbuf();
 		}
 	private:
+		void generateCHelpers();
+		void generateCInstruction(Instruction&);
 		void genAddressReg(Instruction&, const char*);
 		void genAddressRegDst(Instruction&, int);
 		int32_t genAddressImm(Instruction&);
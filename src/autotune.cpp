@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include "autotune.hpp"
+#include "dataset.hpp"
+#include "cpu.hpp"
+#include "argon2_core.h"
+
+namespace randomx {
+
+	constexpr int TuningFileVersion = 1;
+	constexpr unsigned DefaultHashCount = 8;
+	//the Argon2 implementations are compared on a fill of 4 MiB
+	constexpr uint32_t ArgonTuneBlocks = 4096;
+
+	static double now() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static double measureArgon2(randomx_argon2_impl* impl, block* memory) {
+		argon2_instance_t instance = {};
+		instance.version = ARGON2_VERSION_NUMBER;
+		instance.memory = memory;
+		instance.passes = RANDOMX_ARGON_ITERATIONS;
+		instance.memory_blocks = ArgonTuneBlocks;
+		instance.segment_length = ArgonTuneBlocks / (RANDOMX_ARGON_LANES * ARGON2_SYNC_POINTS);
+		instance.lane_length = instance.segment_length * ARGON2_SYNC_POINTS;
+		instance.lanes = RANDOMX_ARGON_LANES;
+		instance.threads = 1;
+		instance.type = Argon2_d;
+		instance.impl = impl;
+		double best = 0;
+		for (int i = 0; i < 3; ++i) {
+			double start = now();
+			randomx_argon2_fill_memory_blocks(&instance);
+			double elapsed = now() - start;
+			if (i == 0 || elapsed < best)
+				best = elapsed;
+		}
+		//scaled to the fill of the whole cache
+		return best * RANDOMX_ARGON_MEMORY / ArgonTuneBlocks;
+	}
+
+	//The shared item and result caches would let each candidate reuse the work of the previous
+	//ones, so they are detached while the hashes are measured.
+	class DetachedCaches {
+	public:
+		explicit DetachedCaches(randomx_cache* cache) : cache(cache) {
+			if (cache != nullptr) {
+				itemCache = cache->itemCache;
+				resultCache = cache->resultCache;
+				cache->itemCache = nullptr;
+				cache->resultCache = nullptr;
+			}
+		}
+		~DetachedCaches() {
+			if (cache != nullptr) {
+				cache->itemCache = itemCache;
+				cache->resultCache = resultCache;
+			}
+		}
+		DetachedCaches(const DetachedCaches&) = delete;
+		DetachedCaches& operator=(const DetachedCaches&) = delete;
+	private:
+		randomx_cache* cache;
+		SharedItemCache* itemCache = nullptr;
+		SharedResultCache* resultCache = nullptr;
+	};
+
+	//fastest hash (after one warmup hash), 0 if the flags are not supported
+	//the inputs are unique to each candidate
+	static double measureHashes(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned candidate, unsigned hashCount) {
+		randomx_vm* vm = randomx_create_vm(flags, cache, dataset);
+		if (vm == nullptr)
+			return 0;
+		uint8_t input[76] = { 0 };
+		memcpy(input + 1, &candidate, sizeof(candidate));
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(vm, input, sizeof(input), hash);
+		double best = 0;
+		for (unsigned i = 0; i < hashCount; ++i) {
+			input[0] = (uint8_t)i + 1;
+			double start = now();
+			randomx_calculate_hash(vm, input, sizeof(input), hash);
+			double elapsed = now() - start;
+			if (i == 0 || elapsed < best)
+				best = elapsed;
+		}
+		randomx_destroy_vm(vm);
+		return best;
+	}
+
+	static bool readTuningFile(const char* path, uint32_t signature, randomx_flags baseFlags, randomx_tuning* tuning) {
+		FILE* file = fopen(path, "r");
+		if (file == nullptr)
+			return false;
+		int version;
+		unsigned fileSignature, fileBase, flags;
+		double hashSeconds, argon2Seconds;
+		bool ok = fscanf(file, "randomx-autotune %d %x %x %x %lg %lg", &version, &fileSignature, &fileBase, &flags, &hashSeconds, &argon2Seconds) == 6;
+		fclose(file);
+		if (!ok || version != TuningFileVersion || fileSignature != signature || fileBase != (unsigned)baseFlags)
+			return false;
+		tuning->flags = (randomx_flags)flags;
+		tuning->cpuSignature = signature;
+		tuning->hashSeconds = hashSeconds;
+		tuning->argon2Seconds = argon2Seconds;
+		tuning->fromFile = 1;
+		return true;
+	}
+
+	static void writeTuningFile(const char* path, randomx_flags baseFlags, const randomx_tuning* tuning) {
+		FILE* file = fopen(path, "w");
+		if (file == nullptr)
+			return;
+		fprintf(file, "randomx-autotune %d %08x %x %x %.9g %.9g\n", TuningFileVersion, tuning->cpuSignature, (unsigned)baseFlags, (unsigned)tuning->flags, tuning->hashSeconds, tuning->argon2Seconds);
+		fclose(file);
+	}
+
+	bool autotune(randomx_cache* cache, randomx_dataset* dataset, unsigned hashCount, const char* path, randomx_tuning* tuning) {
+		const uint32_t signature = Cpu().getSignature();
+		//the candidates depend on the features detected by randomx_get_flags and the memory mode
+		randomx_flags baseFlags = randomx_get_flags();
+		if (dataset != nullptr)
+			baseFlags |= RANDOMX_FLAG_FULL_MEM;
+		if (path != nullptr && readTuningFile(path, signature, baseFlags, tuning))
+			return true;
+		if (hashCount == 0)
+			hashCount = DefaultHashCount;
+
+		//Argon2 implementations, measured on their own
+		const randomx_flags argonFlags[] = { RANDOMX_FLAG_ARGON2_AVX512, RANDOMX_FLAG_ARGON2_AVX2, RANDOMX_FLAG_ARGON2_SSSE3, RANDOMX_FLAG_ARGON2_NEON, RANDOMX_FLAG_DEFAULT };
+		randomx_flags bestArgon = RANDOMX_FLAG_DEFAULT;
+		double argon2Seconds = 0;
+		std::vector<block> memory(ArgonTuneBlocks);
+		for (randomx_flags argon : argonFlags) {
+			if (argon != RANDOMX_FLAG_DEFAULT && !(baseFlags & argon))
+				continue;
+			double seconds = measureArgon2(selectArgonImpl(argon), memory.data());
+			if (argon2Seconds == 0 || seconds < argon2Seconds) {
+				argon2Seconds = seconds;
+				bestArgon = argon;
+			}
+		}
+
+		//each alternative is tried with the best choices of the other groups so far
+		std::vector<std::vector<randomx_flags>> groups;
+		if (baseFlags & RANDOMX_FLAG_HARD_AES) {
+			groups.push_back({ RANDOMX_FLAG_HARD_AES, RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_VAES });
+		}
+		else {
+			groups.push_back({ RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_AES_VPERM });
+		}
+		if (baseFlags & RANDOMX_FLAG_JIT) {
+#if defined(_M_X64) || defined(__x86_64__)
+			groups.push_back({ RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_PREFETCH_T0, RANDOMX_FLAG_PREFETCH_SCRATCHPAD, RANDOMX_FLAG_PREFETCH_T0 | RANDOMX_FLAG_PREFETCH_SCRATCHPAD });
+#elif defined(__aarch64__)
+			groups.push_back({ RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_JIT_SCHEDULE });
+#endif
+		}
+		const randomx_flags vmFlags = baseFlags & (RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE | RANDOMX_FLAG_FULL_MEM);
+		std::vector<randomx_flags> chosen;
+		for (auto& group : groups)
+			chosen.push_back(group[0]);
+		auto combine = [&](size_t group, randomx_flags alternative) {
+			randomx_flags flags = vmFlags;
+			for (size_t k = 0; k < groups.size(); ++k)
+				flags |= k == group ? alternative : chosen[k];
+			return flags;
+		};
+		DetachedCaches detached(cache);
+		unsigned candidate = 0;
+		randomx_flags bestFlags = combine(0, chosen[0]);
+		double hashSeconds = measureHashes(bestFlags, cache, dataset, candidate++, hashCount);
+		for (size_t i = 0; i < groups.size(); ++i) {
+			for (size_t j = 1; j < groups[i].size(); ++j) {
+				randomx_flags flags = combine(i, groups[i][j]);
+				double seconds = measureHashes(flags, cache, dataset, candidate++, hashCount);
+				if (seconds > 0 && (hashSeconds == 0 || seconds < hashSeconds)) {
+					hashSeconds = seconds;
+					bestFlags = flags;
+					chosen[i] = groups[i][j];
+				}
+			}
+		}
+		if (hashSeconds == 0)
+			return false;
+
+		tuning->flags = bestFlags | bestArgon | (baseFlags & RANDOMX_FLAG_DATASET_AVX512);
+		tuning->cpuSignature = signature;
+		tuning->hashSeconds = hashSeconds;
+		tuning->argon2Seconds = argon2Seconds;
+		tuning->fromFile = 0;
+		if (path != nullptr)
+			writeTuningFile(path, baseFlags, tuning);
+		return true;
+	}
+}
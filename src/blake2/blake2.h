@@ -37,6 +37,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdint.h>
 #include <limits.h>
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -92,6 +93,9 @@ extern "C" {
 #define blake2b_final       randomx_blake2b_final
 #define blake2b             randomx_blake2b
 #define blake2b_long        randomx_blake2b_long
+#define blake2b_multi       randomx_blake2b_multi
+#define blake2b_compress_4way_avx2   randomx_blake2b_compress_4way_avx2
+#define blake2b_compress_8way_avx512 randomx_blake2b_compress_8way_avx512
 
 	/* Streaming API */
 	int blake2b_init(blake2b_state *S, size_t outlen);
@@ -109,6 +113,24 @@ extern "C" {
 	int blake2b_long(void *out, size_t outlen, const void *in, size_t inlen);
 	/* Argon2 Team - End Code */
 
+	/* Multi-buffer API */
+	enum { BLAKE2B_MAX_LANES = 8 };
+
+	/* Compresses one block of each of N independent messages. The state and message words
+	 * of the lanes are interleaved: h[i * N + lane], m[i * N + lane]. */
+	typedef void blake2b_compress_multi(uint64_t *h, const uint64_t *m, uint64_t t, uint64_t f);
+
+	/* Return NULL if the library was compiled without support for the instruction set */
+	blake2b_compress_multi *blake2b_compress_4way_avx2(void);
+	blake2b_compress_multi *blake2b_compress_8way_avx512(void);
+
+	/* Hashes count unkeyed messages in[i] || in2[i] of equal length, using compress for groups
+	 * of lanes messages (the last group may fill only half of the lanes) and the scalar code
+	 * for the rest. in2 can be NULL if in2len is 0.
+	 * The hash of message i is stored at out + i * outlen. */
+	void blake2b_multi(void *out, size_t outlen, const void *const *in, size_t inlen,
+		const void *const *in2, size_t in2len, size_t count, blake2b_compress_multi *compress, unsigned lanes);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -38,27 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "blake2.h"
 #include "blake2-impl.h"
-
-static const uint64_t blake2b_IV[8] = {
-	UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b),
-	UINT64_C(0x3c6ef372fe94f82b), UINT64_C(0xa54ff53a5f1d36f1),
-	UINT64_C(0x510e527fade682d1), UINT64_C(0x9b05688c2b3e6c1f),
-	UINT64_C(0x1f83d9abfb41bd6b), UINT64_C(0x5be0cd19137e2179) };
-
-static const unsigned int blake2b_sigma[12][16] = {
-	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
-	{14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
-	{11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
-	{7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
-	{9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
-	{2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
-	{12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
-	{13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
-	{6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
-	{10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
-	{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
-	{14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
-};
+#include "blake2b-tables.h"
 
 static FORCE_INLINE void blake2b_set_lastnode(blake2b_state *S) {
 	S->f[1] = (uint64_t)-1;
@@ -407,3 +387,75 @@ fail:
 }
 /* Argon2 Team - End Code */
 
+
+void blake2b_multi(void *out, size_t outlen, const void *const *in, size_t inlen,
+	const void *const *in2, size_t in2len, size_t count, blake2b_compress_multi *compress, unsigned lanes) {
+	uint64_t h[8 * BLAKE2B_MAX_LANES];
+	uint64_t m[16 * BLAKE2B_MAX_LANES];
+	uint8_t block[BLAKE2B_BLOCKBYTES];
+	uint8_t *pout = (uint8_t *)out;
+	const size_t total = inlen + in2len;
+	size_t done = 0;
+	unsigned i, lane;
+
+	if (compress == NULL || lanes < 2 || lanes > BLAKE2B_MAX_LANES ||
+		outlen == 0 || outlen > BLAKE2B_OUTBYTES) {
+		lanes = 0;
+	}
+
+	/* all messages have the same length, so the lanes share the counter and the final block flag;
+	   a group that fills at least half of the lanes is padded by repeating its last message */
+	while (lanes != 0 && 2 * (count - done) >= lanes) {
+		const size_t group = count - done < lanes ? count - done : lanes;
+		size_t pos = 0;
+		for (i = 0; i < 8; ++i) {
+			for (lane = 0; lane < lanes; ++lane) {
+				h[i * lanes + lane] = blake2b_IV[i];
+			}
+		}
+		for (lane = 0; lane < lanes; ++lane) {
+			h[lane] ^= UINT64_C(0x01010000) ^ outlen; /* fanout = depth = 1 */
+		}
+		for (;;) {
+			const size_t size = total - pos < BLAKE2B_BLOCKBYTES ? total - pos : BLAKE2B_BLOCKBYTES;
+			const int last = pos + BLAKE2B_BLOCKBYTES >= total;
+			for (lane = 0; lane < lanes; ++lane) {
+				const size_t index = done + (lane < group ? lane : group - 1);
+				const uint8_t *msg = (const uint8_t *)in[index];
+				const uint8_t *msg2 = in2 != NULL ? (const uint8_t *)in2[index] : NULL;
+				size_t first = pos < inlen ? inlen - pos : 0;
+				if (first > size)
+					first = size;
+				memset(block, 0, sizeof(block));
+				if (first > 0)
+					memcpy(block, msg + pos, first);
+				if (size > first)
+					memcpy(block + first, msg2 + (pos + first - inlen), size - first);
+				for (i = 0; i < 16; ++i) {
+					m[i * lanes + lane] = load64(block + i * sizeof(uint64_t));
+				}
+			}
+			compress(h, m, pos + size, last ? (uint64_t)-1 : 0);
+			if (last)
+				break;
+			pos += BLAKE2B_BLOCKBYTES;
+		}
+		for (lane = 0; lane < group; ++lane) {
+			uint8_t buffer[BLAKE2B_OUTBYTES];
+			for (i = 0; i < 8; ++i) {
+				store64(buffer + i * sizeof(uint64_t), h[i * lanes + lane]);
+			}
+			memcpy(pout + (done + lane) * outlen, buffer, outlen);
+		}
+		done += group;
+	}
+
+	for (; done < count; ++done) {
+		blake2b_state S;
+		blake2b_init(&S, outlen);
+		blake2b_update(&S, in[done], inlen);
+		if (in2len > 0)
+			blake2b_update(&S, in2[done], in2len);
+		blake2b_final(&S, pout + done * outlen, outlen);
+	}
+}
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+
+#include "blake2.h"
+
+#if defined(__AVX512F__)
+
+#include "blake2b-tables.h"
+
+#ifdef __GNUC__
+#include <x86intrin.h>
+#else
+#include <intrin.h>
+#endif
+
+#define ROTR32(x) _mm512_ror_epi64(x, 32)
+#define ROTR24(x) _mm512_ror_epi64(x, 24)
+#define ROTR16(x) _mm512_ror_epi64(x, 16)
+#define ROTR63(x) _mm512_ror_epi64(x, 63)
+
+#define G(r, i, a, b, c, d)                                                    \
+    do {                                                                       \
+        a = _mm512_add_epi64(_mm512_add_epi64(a, b), m[blake2b_sigma[r][2 * i + 0]]); \
+        d = ROTR32(_mm512_xor_si512(d, a));                                    \
+        c = _mm512_add_epi64(c, d);                                            \
+        b = ROTR24(_mm512_xor_si512(b, c));                                    \
+        a = _mm512_add_epi64(_mm512_add_epi64(a, b), m[blake2b_sigma[r][2 * i + 1]]); \
+        d = ROTR16(_mm512_xor_si512(d, a));                                    \
+        c = _mm512_add_epi64(c, d);                                            \
+        b = ROTR63(_mm512_xor_si512(b, c));                                    \
+    } while ((void)0, 0)
+
+#define ROUND(r)                                                               \
+    do {                                                                       \
+        G(r, 0, v[0], v[4], v[8], v[12]);                                      \
+        G(r, 1, v[1], v[5], v[9], v[13]);                                      \
+        G(r, 2, v[2], v[6], v[10], v[14]);                                     \
+        G(r, 3, v[3], v[7], v[11], v[15]);                                     \
+        G(r, 4, v[0], v[5], v[10], v[15]);                                     \
+        G(r, 5, v[1], v[6], v[11], v[12]);                                     \
+        G(r, 6, v[2], v[7], v[8], v[13]);                                      \
+        G(r, 7, v[3], v[4], v[9], v[14]);                                      \
+    } while ((void)0, 0)
+
+static void blake2b_compress_8way(uint64_t *h, const uint64_t *m_in, uint64_t t, uint64_t f) {
+	__m512i m[16];
+	__m512i v[16];
+	unsigned int i, r;
+
+	for (i = 0; i < 16; ++i) {
+		m[i] = _mm512_loadu_si512((__m512i *)(m_in + i * 8));
+	}
+
+	for (i = 0; i < 8; ++i) {
+		v[i] = _mm512_loadu_si512((__m512i *)(h + i * 8));
+		v[i + 8] = _mm512_set1_epi64((int64_t)blake2b_IV[i]);
+	}
+
+	v[12] = _mm512_xor_si512(v[12], _mm512_set1_epi64((int64_t)t));
+	v[14] = _mm512_xor_si512(v[14], _mm512_set1_epi64((int64_t)f));
+
+	for (r = 0; r < 12; ++r) {
+		ROUND(r);
+	}
+
+	for (i = 0; i < 8; ++i) {
+		_mm512_storeu_si512((__m512i *)(h + i * 8), _mm512_xor_si512(_mm512_loadu_si512((__m512i *)(h + i * 8)), _mm512_xor_si512(v[i], v[i + 8])));
+	}
+}
+
+#undef G
+#undef ROUND
+
+#endif
+
+blake2b_compress_multi *blake2b_compress_8way_avx512(void) {
+#if defined(__AVX512F__)
+	return &blake2b_compress_8way;
+#endif
+	return NULL;
+}
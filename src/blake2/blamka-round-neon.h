@@ -0,0 +1,144 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Original code from Argon2 reference source code package used under CC0 Licence
+ * https://github.com/P-H-C/phc-winner-argon2
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+*/
+
+
+#ifndef BLAKE_ROUND_MKA_OPT_NEON_H
+#define BLAKE_ROUND_MKA_OPT_NEON_H
+
+#include "blake2-impl.h"
+
+#include <arm_neon.h>
+
+/* rotations by 24, 16 and 63 use shift right and insert */
+#define rotr32(x) vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)))
+#define rotr24(x) vsriq_n_u64(vshlq_n_u64((x), 40), (x), 24)
+#define rotr16(x) vsriq_n_u64(vshlq_n_u64((x), 48), (x), 16)
+#define rotr63(x) vsriq_n_u64(vshlq_n_u64((x), 1), (x), 63)
+
+static FORCE_INLINE uint64x2_t fBlaMka(uint64x2_t x, uint64x2_t y) {
+    const uint64x2_t z = vmull_u32(vmovn_u64(x), vmovn_u64(y));
+    return vaddq_u64(vaddq_u64(x, y), vaddq_u64(z, z));
+}
+
+#define G1_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do { \
+        A0 = fBlaMka(A0, B0); \
+        A1 = fBlaMka(A1, B1); \
+        \
+        D0 = veorq_u64(D0, A0); \
+        D1 = veorq_u64(D1, A1); \
+        \
+        D0 = rotr32(D0); \
+        D1 = rotr32(D1); \
+        \
+        C0 = fBlaMka(C0, D0); \
+        C1 = fBlaMka(C1, D1); \
+        \
+        B0 = veorq_u64(B0, C0); \
+        B1 = veorq_u64(B1, C1); \
+        \
+        B0 = rotr24(B0); \
+        B1 = rotr24(B1); \
+    } while((void)0, 0);
+
+#define G2_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do { \
+        A0 = fBlaMka(A0, B0); \
+        A1 = fBlaMka(A1, B1); \
+        \
+        D0 = veorq_u64(D0, A0); \
+        D1 = veorq_u64(D1, A1); \
+        \
+        D0 = rotr16(D0); \
+        D1 = rotr16(D1); \
+        \
+        C0 = fBlaMka(C0, D0); \
+        C1 = fBlaMka(C1, D1); \
+        \
+        B0 = veorq_u64(B0, C0); \
+        B1 = veorq_u64(B1, C1); \
+        \
+        B0 = rotr63(B0); \
+        B1 = rotr63(B1); \
+    } while((void)0, 0);
+
+/* vextq_u64(x, y, 1) is the equivalent of _mm_alignr_epi8(y, x, 8) */
+#define DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do { \
+        uint64x2_t t0 = vextq_u64(B0, B1, 1); \
+        uint64x2_t t1 = vextq_u64(B1, B0, 1); \
+        B0 = t0; \
+        B1 = t1; \
+        \
+        t0 = C0; \
+        C0 = C1; \
+        C1 = t0; \
+        \
+        t0 = vextq_u64(D0, D1, 1); \
+        t1 = vextq_u64(D1, D0, 1); \
+        D0 = t1; \
+        D1 = t0; \
+    } while((void)0, 0);
+
+#define UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do { \
+        uint64x2_t t0 = vextq_u64(B1, B0, 1); \
+        uint64x2_t t1 = vextq_u64(B0, B1, 1); \
+        B0 = t0; \
+        B1 = t1; \
+        \
+        t0 = C0; \
+        C0 = C1; \
+        C1 = t0; \
+        \
+        t0 = vextq_u64(D1, D0, 1); \
+        t1 = vextq_u64(D0, D1, 1); \
+        D0 = t1; \
+        D1 = t0; \
+    } while((void)0, 0);
+
+#define BLAKE2_ROUND(A0, A1, B0, B1, C0, C1, D0, D1) \
+    do { \
+        G1_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+        G2_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+        \
+        DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+        \
+        G1_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+        G2_NEON(A0, B0, C0, D0, A1, B1, C1, D1) \
+        \
+        UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    } while((void)0, 0);
+
+#endif /* BLAKE_ROUND_MKA_OPT_NEON_H */
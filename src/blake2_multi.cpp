@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "blake2_multi.hpp"
+#include "blake2/blake2.h"
+#include "cpu.hpp"
+
+namespace randomx {
+
+	struct Blake2bMulti {
+		blake2b_compress_multi *compress4;
+		blake2b_compress_multi *compress8;
+	};
+
+	//detects the multi-buffer Blake2b kernels supported by the build and the CPU
+	static Blake2bMulti selectBlake2bMulti() {
+		Cpu cpu;
+		Blake2bMulti impl;
+		impl.compress4 = cpu.hasAvx2() ? blake2b_compress_4way_avx2() : nullptr;
+		impl.compress8 = cpu.hasAvx512f() ? blake2b_compress_8way_avx512() : nullptr;
+		return impl;
+	}
+
+	void hashMulti(void *out, size_t outlen, const void *const *in, size_t inlen, const void *const *in2, size_t in2len, size_t count) {
+		static const Blake2bMulti impl = selectBlake2bMulti();
+		if (impl.compress8 != nullptr && (count > 4 || impl.compress4 == nullptr)) {
+			blake2b_multi(out, outlen, in, inlen, in2, in2len, count, impl.compress8, 8);
+		}
+		else {
+			blake2b_multi(out, outlen, in, inlen, in2, in2len, count, impl.compress4, 4);
+		}
+	}
+}
@@ -78,403 +78,496 @@ namespace randomx {
 		}
 	}
 
+#if RANDOMX_THREADED_BYTECODE
+#define INSTR_LABEL(x) &&op_ ## x,
+
+#define INSTR_THREADED(x) op_ ## x: \
+	exe_ ## x(bytecode[pc], pc, scratchpad, config); \
+	INSTR_DISPATCH();
+
+#define INSTR_DISPATCH() \
+	if (++pc == RANDOMX_PROGRAM_SIZE) \
+		return; \
+	goto *dispatchTable[(int)bytecode[pc].type]
+
+	void BytecodeMachine::executeBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_SIZE], uint8_t* scratchpad, ProgramConfiguration& config) {
+		//indexed by InstructionType, every handler jumps straight to the next one
+		static void* const dispatchTable[] = {
+			INSTR_LABEL(IADD_RS)
+			INSTR_LABEL(IADD_M)
+			INSTR_LABEL(ISUB_R)
+			INSTR_LABEL(ISUB_M)
+			INSTR_LABEL(IMUL_R)
+			INSTR_LABEL(IMUL_M)
+			INSTR_LABEL(IMULH_R)
+			INSTR_LABEL(IMULH_M)
+			INSTR_LABEL(ISMULH_R)
+			INSTR_LABEL(ISMULH_M)
+			INSTR_LABEL(IMUL_RCP)
+			INSTR_LABEL(INEG_R)
+			INSTR_LABEL(IXOR_R)
+			INSTR_LABEL(IXOR_M)
+			INSTR_LABEL(IROR_R)
+			INSTR_LABEL(IROL_R)
+			INSTR_LABEL(ISWAP_R)
+			INSTR_LABEL(FSWAP_R)
+			INSTR_LABEL(FADD_R)
+			INSTR_LABEL(FADD_M)
+			INSTR_LABEL(FSUB_R)
+			INSTR_LABEL(FSUB_M)
+			INSTR_LABEL(FSCAL_R)
+			INSTR_LABEL(FMUL_R)
+			INSTR_LABEL(FDIV_M)
+			INSTR_LABEL(FSQRT_R)
+			INSTR_LABEL(CBRANCH)
+			INSTR_LABEL(CFROUND)
+			INSTR_LABEL(ISTORE)
+			INSTR_LABEL(NOP)
+		};
+		static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == (int)InstructionType::NOP + 1, "Invalid dispatch table size");
+
+		int pc = 0;
+		goto *dispatchTable[(int)bytecode[pc].type];
+
+		INSTR_THREADED(IADD_RS)
+		INSTR_THREADED(IADD_M)
+		INSTR_THREADED(ISUB_R)
+		INSTR_THREADED(ISUB_M)
+		INSTR_THREADED(IMUL_R)
+		INSTR_THREADED(IMUL_M)
+		INSTR_THREADED(IMULH_R)
+		INSTR_THREADED(IMULH_M)
+		INSTR_THREADED(ISMULH_R)
+		INSTR_THREADED(ISMULH_M)
+		INSTR_THREADED(INEG_R)
+		INSTR_THREADED(IXOR_R)
+		INSTR_THREADED(IXOR_M)
+		INSTR_THREADED(IROR_R)
+		INSTR_THREADED(IROL_R)
+		INSTR_THREADED(ISWAP_R)
+		INSTR_THREADED(FSWAP_R)
+		INSTR_THREADED(FADD_R)
+		INSTR_THREADED(FADD_M)
+		INSTR_THREADED(FSUB_R)
+		INSTR_THREADED(FSUB_M)
+		INSTR_THREADED(FSCAL_R)
+		INSTR_THREADED(FMUL_R)
+		INSTR_THREADED(FDIV_M)
+		INSTR_THREADED(FSQRT_R)
+		INSTR_THREADED(CBRANCH)
+		INSTR_THREADED(CFROUND)
+		INSTR_THREADED(ISTORE)
+
+	op_NOP:
+		INSTR_DISPATCH();
+
+	op_IMUL_RCP: //executed as IMUL_R
+		UNREACHABLE;
+	}
+
+#undef INSTR_DISPATCH
+#undef INSTR_THREADED
+#undef INSTR_LABEL
+#endif
+
 	void BytecodeMachine::compileInstruction(RANDOMX_GEN_ARGS) {
-		int opcode = instr.opcode;
-
-		if (opcode < ceil_IADD_RS) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IADD_RS;
-			ibc.idst = &nreg->r[dst];
-			if (dst != RegisterNeedsDisplacement) {
-				ibc.isrc = &nreg->r[src];
-				ibc.shift = instr.getModShift();
-				ibc.imm = 0;
+		switch (instr.getType())
+		{
+			case InstructionType::IADD_RS: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IADD_RS;
+				ibc.idst = &nreg->r[dst];
+				if (dst != RegisterNeedsDisplacement) {
+					ibc.isrc = &nreg->r[src];
+					ibc.shift = instr.getModShift();
+					ibc.imm = 0;
+				}
+				else {
+					ibc.isrc = &nreg->r[src];
+					ibc.shift = instr.getModShift();
+					ibc.imm = signExtend2sCompl(instr.getImm32());
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			else {
-				ibc.isrc = &nreg->r[src];
-				ibc.shift = instr.getModShift();
+
+			case InstructionType::IADD_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IADD_M;
+				ibc.idst = &nreg->r[dst];
 				ibc.imm = signExtend2sCompl(instr.getImm32());
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IADD_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IADD_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+			case InstructionType::ISUB_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::ISUB_R;
+				ibc.idst = &nreg->r[dst];
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+				}
+				else {
+					ibc.imm = signExtend2sCompl(instr.getImm32());
+					ibc.isrc = &ibc.imm;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_ISUB_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::ISUB_R;
-			ibc.idst = &nreg->r[dst];
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
-			}
-			else {
+			case InstructionType::ISUB_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::ISUB_M;
+				ibc.idst = &nreg->r[dst];
 				ibc.imm = signExtend2sCompl(instr.getImm32());
-				ibc.isrc = &ibc.imm;
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_ISUB_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::ISUB_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+			case InstructionType::IMUL_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IMUL_R;
+				ibc.idst = &nreg->r[dst];
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+				}
+				else {
+					ibc.imm = signExtend2sCompl(instr.getImm32());
+					ibc.isrc = &ibc.imm;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+
+			case InstructionType::IMUL_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IMUL_M;
+				ibc.idst = &nreg->r[dst];
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IMUL_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IMUL_R;
-			ibc.idst = &nreg->r[dst];
-			if (src != dst) {
+			case InstructionType::IMULH_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IMULH_R;
+				ibc.idst = &nreg->r[dst];
 				ibc.isrc = &nreg->r[src];
+				registerUsage[dst] = i;
+				return;
 			}
-			else {
+
+			case InstructionType::IMULH_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IMULH_M;
+				ibc.idst = &nreg->r[dst];
 				ibc.imm = signExtend2sCompl(instr.getImm32());
-				ibc.isrc = &ibc.imm;
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IMUL_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IMUL_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
+			case InstructionType::ISMULH_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::ISMULH_R;
+				ibc.idst = &nreg->r[dst];
 				ibc.isrc = &nreg->r[src];
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
-
-		if (opcode < ceil_IMULH_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IMULH_R;
-			ibc.idst = &nreg->r[dst];
-			ibc.isrc = &nreg->r[src];
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IMULH_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IMULH_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+			case InstructionType::ISMULH_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::ISMULH_M;
+				ibc.idst = &nreg->r[dst];
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+
+			case InstructionType::IMUL_RCP: {
+				const uint32_t divisor = instr.getImm32();
+				if (!isZeroOrPowerOf2(divisor)) {
+					auto dst = instr.dst % RegistersCount;
+					ibc.type = InstructionType::IMUL_R;
+					ibc.idst = &nreg->r[dst];
+					ibc.imm = randomx_reciprocal(divisor);
+					ibc.isrc = &ibc.imm;
+					registerUsage[dst] = i;
+				}
+				else {
+					ibc.type = InstructionType::NOP;
+				}
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_ISMULH_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::ISMULH_R;
-			ibc.idst = &nreg->r[dst];
-			ibc.isrc = &nreg->r[src];
-			registerUsage[dst] = i;
-			return;
-		}
+			case InstructionType::INEG_R: {
+				auto dst = instr.dst % RegistersCount;
+				ibc.type = InstructionType::INEG_R;
+				ibc.idst = &nreg->r[dst];
+				registerUsage[dst] = i;
+				return;
+			}
 
-		if (opcode < ceil_ISMULH_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::ISMULH_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+			case InstructionType::IXOR_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IXOR_R;
+				ibc.idst = &nreg->r[dst];
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+				}
+				else {
+					ibc.imm = signExtend2sCompl(instr.getImm32());
+					ibc.isrc = &ibc.imm;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+
+			case InstructionType::IXOR_M: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IXOR_M;
+				ibc.idst = &nreg->r[dst];
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				}
+				else {
+					ibc.isrc = &zero;
+					ibc.memMask = ScratchpadL3Mask;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IMUL_RCP) {
-			const uint32_t divisor = instr.getImm32();
-			if (!isZeroOrPowerOf2(divisor)) {
+			case InstructionType::IROR_R: {
 				auto dst = instr.dst % RegistersCount;
-				ibc.type = InstructionType::IMUL_R;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IROR_R;
 				ibc.idst = &nreg->r[dst];
-				ibc.imm = randomx_reciprocal(divisor);
-				ibc.isrc = &ibc.imm;
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+				}
+				else {
+					ibc.imm = instr.getImm32();
+					ibc.isrc = &ibc.imm;
+				}
 				registerUsage[dst] = i;
+				return;
 			}
-			else {
-				ibc.type = InstructionType::NOP;
+
+			case InstructionType::IROL_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::IROL_R;
+				ibc.idst = &nreg->r[dst];
+				if (src != dst) {
+					ibc.isrc = &nreg->r[src];
+				}
+				else {
+					ibc.imm = instr.getImm32();
+					ibc.isrc = &ibc.imm;
+				}
+				registerUsage[dst] = i;
+				return;
 			}
-			return;
-		}
 
-		if (opcode < ceil_INEG_R) {
-			auto dst = instr.dst % RegistersCount;
-			ibc.type = InstructionType::INEG_R;
-			ibc.idst = &nreg->r[dst];
-			registerUsage[dst] = i;
-			return;
-		}
+			case InstructionType::ISWAP_R: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				if (src != dst) {
+					ibc.idst = &nreg->r[dst];
+					ibc.isrc = &nreg->r[src];
+					ibc.type = InstructionType::ISWAP_R;
+					registerUsage[dst] = i;
+					registerUsage[src] = i;
+				}
+				else {
+					ibc.type = InstructionType::NOP;
+				}
+				return;
+			}
 
-		if (opcode < ceil_IXOR_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IXOR_R;
-			ibc.idst = &nreg->r[dst];
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
+			case InstructionType::FSWAP_R: {
+				auto dst = instr.dst % RegistersCount;
+				ibc.type = InstructionType::FSWAP_R;
+				if (dst < RegisterCountFlt)
+					ibc.fdst = &nreg->f[dst];
+				else
+					ibc.fdst = &nreg->e[dst - RegisterCountFlt];
+				return;
 			}
-			else {
-				ibc.imm = signExtend2sCompl(instr.getImm32());
-				ibc.isrc = &ibc.imm;
+
+			case InstructionType::FADD_R: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegisterCountFlt;
+				ibc.type = InstructionType::FADD_R;
+				ibc.fdst = &nreg->f[dst];
+				ibc.fsrc = &nreg->a[src];
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IXOR_M) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IXOR_M;
-			ibc.idst = &nreg->r[dst];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (src != dst) {
+			case InstructionType::FADD_M: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::FADD_M;
+				ibc.fdst = &nreg->f[dst];
 				ibc.isrc = &nreg->r[src];
 				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				return;
 			}
-			else {
-				ibc.isrc = &zero;
-				ibc.memMask = ScratchpadL3Mask;
+
+			case InstructionType::FSUB_R: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegisterCountFlt;
+				ibc.type = InstructionType::FSUB_R;
+				ibc.fdst = &nreg->f[dst];
+				ibc.fsrc = &nreg->a[src];
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IROR_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IROR_R;
-			ibc.idst = &nreg->r[dst];
-			if (src != dst) {
+			case InstructionType::FSUB_M: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::FSUB_M;
+				ibc.fdst = &nreg->f[dst];
 				ibc.isrc = &nreg->r[src];
+				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				return;
 			}
-			else {
-				ibc.imm = instr.getImm32();
-				ibc.isrc = &ibc.imm;
-			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_IROL_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::IROL_R;
-			ibc.idst = &nreg->r[dst];
-			if (src != dst) {
-				ibc.isrc = &nreg->r[src];
+			case InstructionType::FSCAL_R: {
+				auto dst = instr.dst % RegisterCountFlt;
+				ibc.fdst = &nreg->f[dst];
+				ibc.type = InstructionType::FSCAL_R;
+				return;
 			}
-			else {
-				ibc.imm = instr.getImm32();
-				ibc.isrc = &ibc.imm;
+
+			case InstructionType::FMUL_R: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegisterCountFlt;
+				ibc.type = InstructionType::FMUL_R;
+				ibc.fdst = &nreg->e[dst];
+				ibc.fsrc = &nreg->a[src];
+				return;
 			}
-			registerUsage[dst] = i;
-			return;
-		}
 
-		if (opcode < ceil_ISWAP_R) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			if (src != dst) {
-				ibc.idst = &nreg->r[dst];
+			case InstructionType::FDIV_M: {
+				auto dst = instr.dst % RegisterCountFlt;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::FDIV_M;
+				ibc.fdst = &nreg->e[dst];
 				ibc.isrc = &nreg->r[src];
-				ibc.type = InstructionType::ISWAP_R;
-				registerUsage[dst] = i;
-				registerUsage[src] = i;
-			}
-			else {
-				ibc.type = InstructionType::NOP;
+				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				return;
 			}
-			return;
-		}
-
-		if (opcode < ceil_FSWAP_R) {
-			auto dst = instr.dst % RegistersCount;
-			ibc.type = InstructionType::FSWAP_R;
-			if (dst < RegisterCountFlt)
-				ibc.fdst = &nreg->f[dst];
-			else
-				ibc.fdst = &nreg->e[dst - RegisterCountFlt];
-			return;
-		}
-
-		if (opcode < ceil_FADD_R) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegisterCountFlt;
-			ibc.type = InstructionType::FADD_R;
-			ibc.fdst = &nreg->f[dst];
-			ibc.fsrc = &nreg->a[src];
-			return;
-		}
 
-		if (opcode < ceil_FADD_M) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::FADD_M;
-			ibc.fdst = &nreg->f[dst];
-			ibc.isrc = &nreg->r[src];
-			ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			return;
-		}
-
-		if (opcode < ceil_FSUB_R) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegisterCountFlt;
-			ibc.type = InstructionType::FSUB_R;
-			ibc.fdst = &nreg->f[dst];
-			ibc.fsrc = &nreg->a[src];
-			return;
-		}
-
-		if (opcode < ceil_FSUB_M) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::FSUB_M;
-			ibc.fdst = &nreg->f[dst];
-			ibc.isrc = &nreg->r[src];
-			ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			return;
-		}
-
-		if (opcode < ceil_FSCAL_R) {
-			auto dst = instr.dst % RegisterCountFlt;
-			ibc.fdst = &nreg->f[dst];
-			ibc.type = InstructionType::FSCAL_R;
-			return;
-		}
-
-		if (opcode < ceil_FMUL_R) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegisterCountFlt;
-			ibc.type = InstructionType::FMUL_R;
-			ibc.fdst = &nreg->e[dst];
-			ibc.fsrc = &nreg->a[src];
-			return;
-		}
-
-		if (opcode < ceil_FDIV_M) {
-			auto dst = instr.dst % RegisterCountFlt;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::FDIV_M;
-			ibc.fdst = &nreg->e[dst];
-			ibc.isrc = &nreg->r[src];
-			ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			return;
-		}
-
-		if (opcode < ceil_FSQRT_R) {
-			auto dst = instr.dst % RegisterCountFlt;
-			ibc.type = InstructionType::FSQRT_R;
-			ibc.fdst = &nreg->e[dst];
-			return;
-		}
+			case InstructionType::FSQRT_R: {
+				auto dst = instr.dst % RegisterCountFlt;
+				ibc.type = InstructionType::FSQRT_R;
+				ibc.fdst = &nreg->e[dst];
+				return;
+			}
 
-		if (opcode < ceil_CBRANCH) {
-			ibc.type = InstructionType::CBRANCH;
-			//jump condition
-			int creg = instr.dst % RegistersCount;
-			ibc.idst = &nreg->r[creg];
-			ibc.target = registerUsage[creg];
-			int shift = instr.getModCond() + ConditionOffset;
-			ibc.imm = signExtend2sCompl(instr.getImm32()) | (1ULL << shift);
-			if (ConditionOffset > 0 || shift > 0) //clear the bit below the condition mask - this limits the number of successive jumps to 2
-				ibc.imm &= ~(1ULL << (shift - 1));
-			ibc.memMask = ConditionMask << shift;
-			//mark all registers as used
-			for (unsigned j = 0; j < RegistersCount; ++j) {
-				registerUsage[j] = i;
+			case InstructionType::CBRANCH: {
+				ibc.type = InstructionType::CBRANCH;
+				//jump condition
+				int creg = instr.dst % RegistersCount;
+				ibc.idst = &nreg->r[creg];
+				ibc.target = registerUsage[creg];
+				int shift = instr.getModCond() + ConditionOffset;
+				ibc.imm = signExtend2sCompl(instr.getImm32()) | (1ULL << shift);
+				if (ConditionOffset > 0 || shift > 0) //clear the bit below the condition mask - this limits the number of successive jumps to 2
+					ibc.imm &= ~(1ULL << (shift - 1));
+				ibc.memMask = ConditionMask << shift;
+				//mark all registers as used
+				for (unsigned j = 0; j < RegistersCount; ++j) {
+					registerUsage[j] = i;
+				}
+				return;
 			}
-			return;
-		}
 
-		if (opcode < ceil_CFROUND) {
-			auto src = instr.src % RegistersCount;
-			ibc.isrc = &nreg->r[src];
-			ibc.type = InstructionType::CFROUND;
-			ibc.imm = instr.getImm32() & 63;
-			return;
-		}
+			case InstructionType::CFROUND: {
+				auto src = instr.src % RegistersCount;
+				ibc.isrc = &nreg->r[src];
+				ibc.type = InstructionType::CFROUND;
+				ibc.imm = instr.getImm32() & 63;
+				return;
+			}
 
-		if (opcode < ceil_ISTORE) {
-			auto dst = instr.dst % RegistersCount;
-			auto src = instr.src % RegistersCount;
-			ibc.type = InstructionType::ISTORE;
-			ibc.idst = &nreg->r[dst];
-			ibc.isrc = &nreg->r[src];
-			ibc.imm = signExtend2sCompl(instr.getImm32());
-			if (instr.getModCond() < StoreL3Condition)
-				ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
-			else
-				ibc.memMask = ScratchpadL3Mask;
-			return;
-		}
+			case InstructionType::ISTORE: {
+				auto dst = instr.dst % RegistersCount;
+				auto src = instr.src % RegistersCount;
+				ibc.type = InstructionType::ISTORE;
+				ibc.idst = &nreg->r[dst];
+				ibc.isrc = &nreg->r[src];
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				if (instr.getModCond() < StoreL3Condition)
+					ibc.memMask = (instr.getModMem() ? ScratchpadL1Mask : ScratchpadL2Mask);
+				else
+					ibc.memMask = ScratchpadL3Mask;
+				return;
+			}
 
-		if (opcode < ceil_NOP) {
-			ibc.type = InstructionType::NOP;
-			return;
+			case InstructionType::NOP: {
+				ibc.type = InstructionType::NOP;
+				return;
+			}
 		}
 
 		UNREACHABLE;
@@ -33,6 +33,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "instruction.hpp"
 #include "program.hpp"
 
+//Direct-threaded bytecode dispatch needs the "labels as values" extension.
+//Build with -DRANDOMX_THREADED_BYTECODE=0 to use the switch-based interpreter.
+#ifndef RANDOMX_THREADED_BYTECODE
+#if defined(__GNUC__)
+#define RANDOMX_THREADED_BYTECODE 1
+#else
+#define RANDOMX_THREADED_BYTECODE 0
+#endif
+#endif
+
 namespace randomx {
 
 	//register file in machine byte order
@@ -123,7 +133,16 @@ namespace randomx {
 			}
 		}
 
-		static void executeBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_SIZE], uint8_t* scratchpad, ProgramConfiguration& config) {
+		static void executeBytecode(InstructionByteCode bytecode[RANDOMX_PROGRAM_SIZE], uint8_t* scratchpad, ProgramConfiguration& config)
+#if RANDOMX_THREADED_BYTECODE
+		;
+#else
+		{
+			executeBytecodeSwitch(bytecode, scratchpad, config);
+		}
+#endif
+
+		static void executeBytecodeSwitch(InstructionByteCode bytecode[RANDOMX_PROGRAM_SIZE], uint8_t* scratchpad, ProgramConfiguration& config) {
 			for (int pc = 0; pc < RANDOMX_PROGRAM_SIZE; ++pc) {
 				auto& ibc = bytecode[pc];
 				executeInstruction(ibc, pc, scratchpad, config);
@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <vector>
+#include <mutex>
+#include "code_region.hpp"
+#include "virtual_memory.h"
+#include "allocator.hpp"
+
+namespace randomx {
+
+	struct CodeRegion {
+		uint8_t* memory;
+		uint8_t* memoryExec;
+		size_t slotSize;
+		bool dualMapped;
+		std::vector<unsigned> freeSlots;
+		unsigned slotCount;
+	};
+
+	static std::mutex regionMutex;
+	static std::vector<CodeRegion*> regions;
+
+	static CodeRegion* allocRegion(size_t slotSize, bool dualMapped) {
+		void* exec = nullptr;
+		uint8_t* memory;
+		if (dualMapped) {
+			memory = (uint8_t*)allocDualMappedLargePages(CodeRegionSize, &exec);
+		}
+		else {
+			memory = (uint8_t*)allocLargePagesMemory(CodeRegionSize);
+			if (memory == nullptr)
+				memory = (uint8_t*)allocTransparentHugePagesMemory(CodeRegionSize);
+			if (memory != nullptr) {
+				setPagesRWX(memory, CodeRegionSize);
+				exec = memory;
+			}
+		}
+		if (memory == nullptr)
+			return nullptr;
+		CodeRegion* region = new CodeRegion();
+		region->memory = memory;
+		region->memoryExec = (uint8_t*)exec;
+		region->slotSize = slotSize;
+		region->dualMapped = dualMapped;
+		region->slotCount = CodeRegionSize / slotSize;
+		for (unsigned i = region->slotCount; i > 0; --i) {
+			region->freeSlots.push_back(i - 1);
+		}
+		return region;
+	}
+
+	static void freeRegion(CodeRegion* region) {
+		if (region->dualMapped)
+			freeDualMappedPages(region->memory, region->memoryExec, CodeRegionSize);
+		else
+			freePagedMemory(region->memory, CodeRegionSize);
+		delete region;
+	}
+
+	bool allocSharedCode(size_t size, bool dualMapped, SharedCode& slot) {
+		//JIT memory from a custom allocator is never shared
+		if (hasCustomAllocator() || size > CodeRegionSize)
+			return false;
+		size = alignSize(size, getPageSize());
+		std::lock_guard<std::mutex> lock(regionMutex);
+		CodeRegion* region = nullptr;
+		for (auto r : regions) {
+			if (r->slotSize == size && r->dualMapped == dualMapped && !r->freeSlots.empty()) {
+				region = r;
+				break;
+			}
+		}
+		if (region == nullptr) {
+			region = allocRegion(size, dualMapped);
+			if (region == nullptr)
+				return false;
+			regions.push_back(region);
+		}
+		unsigned index = region->freeSlots.back();
+		region->freeSlots.pop_back();
+		slot.code = region->memory + (size_t)index * size;
+		slot.codeExec = region->memoryExec + (size_t)index * size;
+		return true;
+	}
+
+	void freeSharedCode(const SharedCode& slot) {
+		std::lock_guard<std::mutex> lock(regionMutex);
+		for (auto it = regions.begin(); it != regions.end(); ++it) {
+			CodeRegion* region = *it;
+			if (slot.code >= region->memory && slot.code < region->memory + CodeRegionSize) {
+				region->freeSlots.push_back((unsigned)((slot.code - region->memory) / region->slotSize));
+				if (region->freeSlots.size() == region->slotCount) {
+					regions.erase(it);
+					freeRegion(region);
+				}
+				return;
+			}
+		}
+	}
+
+}
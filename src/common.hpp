@@ -80,6 +80,7 @@ namespace randomx {
 	static_assert(ArgonSaltSize >= 8, "RANDOMX_ARGON_SALT must be at least 8 characters long");
 	constexpr int SuperscalarMaxSize = 3 * RANDOMX_SUPERSCALAR_LATENCY + 2;
 	constexpr size_t CacheLineSize = RANDOMX_DATASET_ITEM_SIZE;
+	constexpr size_t CacheAlignment = 4096; //no Argon2 block of the cache straddles a page boundary
 	constexpr int ScratchpadSize = RANDOMX_SCRATCHPAD_L3;
 	constexpr uint32_t CacheLineAlignMask = (RANDOMX_DATASET_BASE_SIZE - 1) & ~(CacheLineSize - 1);
 	constexpr uint32_t CacheSize = RANDOMX_ARGON_MEMORY * ArgonBlockSize;
@@ -116,21 +117,25 @@ namespace randomx {
 
 #if defined(_M_X64) || defined(__x86_64__)
 	#define RANDOMX_HAVE_COMPILER 1
+	#define RANDOMX_HAVE_INTERLEAVED 1
 	#define RANDOMX_COMPILER_X86
 	class JitCompilerX86;
 	using JitCompiler = JitCompilerX86;
 #elif defined(__aarch64__)
 	#define RANDOMX_HAVE_COMPILER 1
+	#define RANDOMX_HAVE_INTERLEAVED 0
 	#define RANDOMX_COMPILER_A64
 	class JitCompilerA64;
 	using JitCompiler = JitCompilerA64;
 #elif defined(__riscv) && __riscv_xlen == 64
 	#define RANDOMX_HAVE_COMPILER 1
+	#define RANDOMX_HAVE_INTERLEAVED 0
 	#define RANDOMX_COMPILER_RV64
 	class JitCompilerRV64;
 	using JitCompiler = JitCompilerRV64;
 #else
 	#define RANDOMX_HAVE_COMPILER 0
+	#define RANDOMX_HAVE_INTERLEAVED 0
 	class JitCompilerFallback;
 	using JitCompiler = JitCompilerFallback;
 #endif
@@ -185,10 +190,26 @@ namespace randomx {
 		fpu_reg_t a[RegisterCountFlt];
 	};
 
+	//per-lane state of an interleaved program (the layout is used by the generated code)
+	struct InterleavedLane {
+		RegisterFile* reg;
+		MemoryRegisters* mem;
+		uint8_t* scratchpad;
+		uint32_t mxcsr;
+		uint32_t reserved;
+	};
+
+	constexpr int MaxInterleavedLanes = 4;
+	constexpr unsigned MaxNumaNodes = 16;
+
 	typedef void(ProgramFunc)(RegisterFile&, MemoryRegisters&, uint8_t* /* scratchpad */, uint64_t);
+	typedef void(InterleavedProgramFunc)(InterleavedLane* /* lanes */, uint64_t);
 	typedef void(DatasetInitFunc)(randomx_cache* cache, uint8_t* dataset, uint32_t startBlock, uint32_t endBlock);
 
 	typedef void(DatasetDeallocFunc)(randomx_dataset*);
 	typedef void(CacheDeallocFunc)(randomx_cache*);
-	typedef void(CacheInitializeFunc)(randomx_cache*, const void*, size_t);
+	typedef void*(MemoryAllocFunc)(size_t, randomx_page_backing*);
+	typedef void(MemoryFreeFunc)(void*, size_t);
+	struct InitProgress;
+	typedef bool(CacheInitializeFunc)(randomx_cache*, const void*, size_t, const InitProgress*, unsigned /* threads */);
 }
@@ -33,11 +33,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	#if defined(_MSC_VER)
 		#include <intrin.h>
 		#define cpuid(info, x) __cpuidex(info, x, 0)
+		#define xgetbv0() _xgetbv(0)
 	#else //GCC
 		#include <cpuid.h>
 		void cpuid(int info[4], int InfoType) {
 			__cpuid_count(InfoType, 0, info[0], info[1], info[2], info[3]);
 		}
+		static unsigned long long xgetbv0() {
+			unsigned eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return ((unsigned long long)edx << 32) | eax;
+		}
 	#endif
 #endif
 
@@ -46,21 +52,68 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	#include <asm/hwcap.h>
 #endif
 
+#if defined(__riscv) && defined(__linux__)
+	#define HAVE_HWPROBE
+	#include <cstdint>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+	#ifndef __NR_riscv_hwprobe
+		#define __NR_riscv_hwprobe 258
+	#endif
+	//values from <asm/hwprobe.h>, which is missing in older kernel headers
+	struct rx_riscv_hwprobe {
+		int64_t key;
+		uint64_t value;
+	};
+	constexpr int64_t HWPROBE_KEY_IMA_EXT_0 = 4;
+	constexpr uint64_t HWPROBE_IMA_V = 1ULL << 2;
+	constexpr uint64_t HWPROBE_EXT_ZKND = 1ULL << 11;
+	constexpr uint64_t HWPROBE_EXT_ZKNE = 1ULL << 12;
+	constexpr uint64_t HWPROBE_EXT_ZVKNED = 1ULL << 21;
+#endif
+
 namespace randomx {
 
-	Cpu::Cpu() : aes_(false), ssse3_(false), avx2_(false) {
+	Cpu::Cpu() : aes_(false), ssse3_(false), avx2_(false), avx512f_(false), avx512dq_(false), avx512vl_(false), vaes_(false), jccErratum_(false), signature_(0) {
 #ifdef HAVE_CPUID
 		int info[4];
 		cpuid(info, 0);
 		int nIds = info[0];
+		//"GenuineIntel" in EBX, EDX, ECX
+		bool intel = info[1] == 0x756e6547 && info[3] == 0x49656e69 && info[2] == 0x6c65746e;
+		bool ymmState = false, zmmState = false;
 		if (nIds >= 0x00000001) {
 			cpuid(info, 0x00000001);
+			signature_ = (uint32_t)info[0];
+			int family = (info[0] >> 8) & 0xf;
+			int model = ((info[0] >> 4) & 0xf) | ((info[0] >> 12) & 0xf0);
+			if (intel && family == 6) {
+				switch (model) {
+				case 0x4e: case 0x5e: //Skylake
+				case 0x55: //Skylake-SP, Cascade Lake, Cooper Lake
+				case 0x8e: case 0x9e: //Kaby Lake, Coffee Lake, Whiskey Lake, Amber Lake
+				case 0xa5: case 0xa6: //Comet Lake
+					jccErratum_ = true;
+					break;
+				default:
+					break;
+				}
+			}
 			ssse3_ = (info[2] & (1 << 9)) != 0;
 			aes_ = (info[2] & (1 << 25)) != 0;
+			//256-bit VAES needs the OS to save the YMM registers,
+			//AVX-512 also needs the opmask and ZMM registers
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			ymmState = osxsave && (xgetbv0() & 0x06) == 0x06;
+			zmmState = osxsave && (xgetbv0() & 0xe6) == 0xe6;
 		}
 		if (nIds >= 0x00000007) {
 			cpuid(info, 0x00000007);
 			avx2_ = (info[1] & (1 << 5)) != 0;
+			avx512f_ = zmmState && (info[1] & (1 << 16)) != 0;
+			avx512dq_ = avx512f_ && (info[1] & (1 << 17)) != 0;
+			avx512vl_ = avx512f_ && (info[1] & (1u << 31)) != 0;
+			vaes_ = aes_ && avx2_ && ymmState && (info[2] & (1 << 9)) != 0;
 		}
 #elif defined(__aarch64__)
 	#if defined(HWCAP_AES)
@@ -69,6 +122,20 @@ namespace randomx {
 	#elif defined(__APPLE__)
 		aes_ = true;
 	#endif
+#elif defined(HAVE_HWPROBE)
+		//report the extension used by rx_aesenc_vec_i128 in this build,
+		//without either of them hardware AES is not available
+	#if defined(__riscv_zkne) && defined(__riscv_zknd)
+		const uint64_t required = HWPROBE_EXT_ZKNE | HWPROBE_EXT_ZKND;
+	#elif defined(__riscv_zvkned)
+		const uint64_t required = HWPROBE_IMA_V | HWPROBE_EXT_ZVKNED;
+	#else
+		const uint64_t required = 0;
+	#endif
+		rx_riscv_hwprobe probe = { HWPROBE_KEY_IMA_EXT_0, 0 };
+		if (required != 0 && syscall(__NR_riscv_hwprobe, &probe, 1, 0, nullptr, 0) == 0 && probe.key == HWPROBE_KEY_IMA_EXT_0) {
+			aes_ = (probe.value & required) == required;
+		}
 #endif
 		//TODO POWER8 AES
 	}
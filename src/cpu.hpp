@@ -28,6 +28,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <cstdint>
+
 namespace randomx {
 
 	class Cpu {
@@ -42,8 +44,30 @@ namespace randomx {
 		bool hasAvx2() const {
 			return avx2_;
 		}
+		bool hasAvx512f() const {
+			return avx512f_;
+		}
+		bool hasAvx512dq() const {
+			return avx512dq_;
+		}
+		bool hasAvx512vl() const {
+			return avx512vl_;
+		}
+		bool hasVaes() const {
+			return vaes_;
+		}
+		//Skylake-derived Intel cores (up to Cascade Lake and Comet Lake) where a jump that
+		//crosses or ends on a 32-byte boundary is not cached in the decoded ICache
+		bool hasJccErratum() const {
+			return jccErratum_;
+		}
+		//family, model and stepping (CPUID leaf 1 EAX on x86-64), 0 on other platforms
+		uint32_t getSignature() const {
+			return signature_;
+		}
 	private:
-		bool aes_, ssse3_, avx2_;
+		bool aes_, ssse3_, avx2_, avx512f_, avx512dq_, avx512vl_, vaes_, jccErratum_;
+		uint32_t signature_;
 	};
 
 }
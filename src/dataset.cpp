@@ -33,12 +33,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <new>
+#include <cstddef>
 #include <algorithm>
 #include <stdexcept>
 #include <cstring>
 #include <limits>
 #include <cstring>
 #include <cassert>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <system_error>
+#include <vector>
 
 #include "common.hpp"
 #include "dataset.hpp"
@@ -51,6 +58,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "argon2_core.h"
 #include "jit_compiler.hpp"
 #include "intrin_portable.h"
+#include "thread_affinity.hpp"
+#include "blake2/blake2.h"
+#include "tracepoints.h"
 
 static_assert(RANDOMX_ARGON_MEMORY % (RANDOMX_ARGON_LANES * ARGON2_SYNC_POINTS) == 0, "RANDOMX_ARGON_MEMORY - invalid value");
 static_assert(ARGON2_BLOCK_SIZE == randomx::ArgonBlockSize, "Unpexpected value of ARGON2_BLOCK_SIZE");
@@ -63,12 +73,72 @@ namespace randomx {
 			Allocator::freeMemory(cache->memory, CacheSize);
 		if (cache->jit != nullptr)
 			delete cache->jit;
+		if (cache->itemCache != nullptr)
+			delete cache->itemCache;
+		if (cache->resultCache != nullptr)
+			delete cache->resultCache;
 	}
 
-	template void deallocCache<DefaultAllocator>(randomx_cache* cache);
+	template void deallocCache<CacheAllocator>(randomx_cache* cache);
 	template void deallocCache<LargePageAllocator>(randomx_cache* cache);
+	template void deallocCache<CustomAllocator<RANDOMX_MEMORY_CACHE>>(randomx_cache* cache);
 
-	void initCache(randomx_cache* cache, const void* key, size_t keySize) {
+	static int reportArgonProgress(void* data, uint32_t done, uint32_t) {
+		auto progress = (const InitProgress*)data;
+		progress->report(done, CacheInitUnits);
+		return progress->isCancelled() ? 1 : 0;
+	}
+
+	static void compileSuperscalarBytecode(randomx_cache* cache) {
+		cache->superscalarBytecode.clear();
+		for (auto& prog : cache->programs) {
+			compileSuperscalar(prog, cache->reciprocalCache, cache->superscalarBytecode);
+		}
+	}
+
+	//the lanes of a slice only reference blocks of finished slices in the other lanes,
+	//so they are filled in parallel and the threads are joined at the end of every slice
+	static bool fillMemoryBlocksParallel(argon2_instance_t* instance, const InitProgress* progress) {
+		const uint32_t total = instance->passes * ARGON2_SYNC_POINTS * instance->lanes;
+		uint32_t done = 0;
+		for (uint32_t r = 0; r < instance->passes; ++r) {
+			for (uint32_t s = 0; s < ARGON2_SYNC_POINTS; ++s) {
+				std::atomic<uint32_t> nextLane(0);
+				auto worker = [&]() {
+					for (uint32_t l = nextLane++; l < instance->lanes; l = nextLane++) {
+						argon2_position_t position = { r, l, (uint8_t)s, 0 };
+						instance->impl(instance, position);
+					}
+				};
+				std::vector<std::thread> threads;
+				for (uint32_t i = 1; i < instance->threads; ++i) {
+					try {
+						threads.emplace_back(worker);
+					}
+					catch (std::system_error&) {
+						break; //the remaining lanes are filled by the threads already running
+					}
+				}
+				worker();
+				for (auto& thread : threads) {
+					thread.join();
+				}
+				done += instance->lanes;
+				if (progress != nullptr && reportArgonProgress(const_cast<InitProgress*>(progress), done, total) != 0)
+					return false;
+			}
+			RANDOMX_TRACE2(argon2_pass, instance->memory, r);
+		}
+		return true;
+	}
+
+	bool initCache(randomx_cache* cache, const void* key, size_t keySize, const InitProgress* progress, unsigned threadCount) {
+		RANDOMX_TRACE2(cache_init_start, cache, keySize);
+		cache->aotItem = nullptr;
+		if (cache->itemCache != nullptr)
+			cache->itemCache->invalidate();
+		if (cache->resultCache != nullptr)
+			cache->resultCache->invalidate();
 		uint32_t memory_blocks, segment_length;
 		argon2_instance_t instance;
 		argon2_context context;
@@ -86,7 +156,7 @@ namespace randomx {
 		context.t_cost = RANDOMX_ARGON_ITERATIONS;
 		context.m_cost = RANDOMX_ARGON_MEMORY;
 		context.lanes = RANDOMX_ARGON_LANES;
-		context.threads = 1;
+		context.threads = std::max(threadCount, 1u);
 		context.allocate_cbk = NULL;
 		context.free_cbk = NULL;
 		context.flags = ARGON2_DEFAULT_FLAGS;
@@ -122,7 +192,26 @@ namespace randomx {
 		 */
 		randomx_argon2_initialize(&instance, &context);
 
-		randomx_argon2_fill_memory_blocks(&instance);
+		bool filled;
+		if (progress != nullptr && progress->isCancelled()) {
+			filled = false;
+		}
+		else if (instance.threads > 1) {
+			filled = fillMemoryBlocksParallel(&instance, progress);
+		}
+		else if (progress != nullptr) {
+			filled = randomx_argon2_fill_memory_blocks_cbk(&instance, &reportArgonProgress, const_cast<InitProgress*>(progress)) == ARGON2_OK;
+		}
+		else {
+			filled = randomx_argon2_fill_memory_blocks(&instance) == ARGON2_OK;
+		}
+		if (!filled) {
+			//the previous contents of the cache have been overwritten
+			cache->programs[0].setSize(0);
+			cache->cacheKey.clear();
+			RANDOMX_TRACE2(cache_init_end, cache, 0);
+			return false;
+		}
 
 		cache->reciprocalCache.clear();
 		randomx::Blake2Generator gen(key, keySize);
@@ -131,22 +220,31 @@ namespace randomx {
 			for (unsigned j = 0; j < cache->programs[i].getSize(); ++j) {
 				auto& instr = cache->programs[i](j);
 				if ((SuperscalarInstructionType)instr.opcode == SuperscalarInstructionType::IMUL_RCP) {
-					auto rcp = randomx_reciprocal(instr.getImm32());
+					auto rcp = randomx_reciprocal_fast(instr.getImm32());
 					instr.setImm32(cache->reciprocalCache.size());
 					cache->reciprocalCache.push_back(rcp);
 				}
 			}
 		}
+		compileSuperscalarBytecode(cache);
+		RANDOMX_TRACE2(cache_init_end, cache, 1);
+		return true;
 	}
 
-	void initCacheCompile(randomx_cache* cache, const void* key, size_t keySize) {
-		initCache(cache, key, keySize);
+	static void compileCache(randomx_cache* cache) {
 		cache->jit->enableWriting();
 		cache->jit->generateSuperscalarHash(cache->programs, cache->reciprocalCache);
 		cache->jit->generateDatasetInitCode();
 		cache->jit->enableExecution();
 	}
 
+	bool initCacheCompile(randomx_cache* cache, const void* key, size_t keySize, const InitProgress* progress, unsigned threadCount) {
+		if (!initCache(cache, key, keySize, progress, threadCount))
+			return false;
+		compileCache(cache);
+		return true;
+	}
+
 	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
 	constexpr uint64_t superscalarAdd1 = 9298411001130361340ULL;
 	constexpr uint64_t superscalarAdd2 = 12065312585734608966ULL;
@@ -162,6 +260,10 @@ namespace randomx {
 	}
 
 	void initDatasetItem(randomx_cache* cache, uint8_t* out, uint64_t itemNumber) {
+		if (cache->aotItem != nullptr) {
+			cache->aotItem(cache->memory, out, itemNumber);
+			return;
+		}
 		int_reg_t rl[8];
 		uint8_t* mixBlock;
 		uint64_t registerValue = itemNumber;
@@ -173,24 +275,531 @@ namespace randomx {
 		rl[5] = rl[0] ^ superscalarAdd5;
 		rl[6] = rl[0] ^ superscalarAdd6;
 		rl[7] = rl[0] ^ superscalarAdd7;
+		assert(!cache->superscalarBytecode.empty());
+		const SuperscalarByteCode* code = cache->superscalarBytecode.data();
 		for (unsigned i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
 			mixBlock = getMixBlock(registerValue, cache->memory);
 			rx_prefetch_nta(mixBlock);
-			SuperscalarProgram& prog = cache->programs[i];
 
-			executeSuperscalar(rl, prog, &cache->reciprocalCache);
+			code = executeSuperscalarBytecode(rl, code);
 
 			for (unsigned q = 0; q < 8; ++q)
 				rl[q] ^= load64_native(mixBlock + 8 * q);
 
-			registerValue = rl[prog.getAddressRegister()];
+			//the end marker of the program holds its address register
+			registerValue = rl[code->dst];
+			++code;
 		}
 
 		memcpy(out, &rl, CacheLineSize);
 	}
 
+	static_assert(DatasetItemGroupSize == SuperscalarGroupSize, "Invalid dataset item group size");
+
+	void readDatasetItem(randomx_cache* cache, uint8_t* out, uint32_t itemNumber) {
+		SharedItemCache* itemCache = cache->itemCache;
+		if (itemCache == nullptr) {
+			initDatasetItem(cache, out, itemNumber);
+		}
+		else if (!itemCache->lookup(itemNumber, out)) {
+			initDatasetItem(cache, out, itemNumber);
+			itemCache->insert(itemNumber, out);
+		}
+	}
+
+	void initDatasetItems(randomx_cache* cache, uint8_t* out, uint64_t firstItem, unsigned count) {
+		assert(count <= DatasetItemGroupSize);
+		//registers are stored by register number first, so each instruction is applied to consecutive
+		//values; unused slots of a partial group calculate the following items, which are discarded
+		int_reg_t rl[8][DatasetItemGroupSize];
+		uint64_t registerValue[DatasetItemGroupSize];
+		uint8_t* mixBlock[DatasetItemGroupSize];
+		for (unsigned k = 0; k < DatasetItemGroupSize; ++k) {
+			const uint64_t itemNumber = firstItem + k;
+			registerValue[k] = itemNumber;
+			rl[0][k] = (itemNumber + 1) * superscalarMul0;
+			rl[1][k] = rl[0][k] ^ superscalarAdd1;
+			rl[2][k] = rl[0][k] ^ superscalarAdd2;
+			rl[3][k] = rl[0][k] ^ superscalarAdd3;
+			rl[4][k] = rl[0][k] ^ superscalarAdd4;
+			rl[5][k] = rl[0][k] ^ superscalarAdd5;
+			rl[6][k] = rl[0][k] ^ superscalarAdd6;
+			rl[7][k] = rl[0][k] ^ superscalarAdd7;
+		}
+		assert(!cache->superscalarBytecode.empty());
+		const SuperscalarByteCode* code = cache->superscalarBytecode.data();
+		for (unsigned i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			//the cache lines of all items are requested before the program runs
+			for (unsigned k = 0; k < DatasetItemGroupSize; ++k) {
+				mixBlock[k] = getMixBlock(registerValue[k], cache->memory);
+				rx_prefetch_nta(mixBlock[k]);
+			}
+
+			code = executeSuperscalarBytecodeGroup(rl, code);
+
+			for (unsigned k = 0; k < DatasetItemGroupSize; ++k) {
+				for (unsigned q = 0; q < 8; ++q)
+					rl[q][k] ^= load64_native(mixBlock[k] + 8 * q);
+				//the end marker of the program holds its address register
+				registerValue[k] = rl[code->dst][k];
+			}
+			++code;
+		}
+
+		for (unsigned k = 0; k < count; ++k) {
+			for (unsigned q = 0; q < 8; ++q)
+				memcpy(out + k * CacheLineSize + 8 * q, &rl[q][k], sizeof(int_reg_t));
+		}
+	}
+
+	bool verifyDatasetSample(randomx_cache* cache, const uint8_t* dataset, uint64_t sampleCount, const void* seed, size_t seedSize) {
+		constexpr uint32_t itemCount = DatasetSize / CacheLineSize;
+		//the seed is hashed first, so all of it affects the selection
+		uint8_t seedHash[32];
+		blake2b(seedHash, sizeof(seedHash), seed, seedSize, nullptr, 0);
+		Blake2Generator gen(seedHash, sizeof(seedHash));
+		const bool all = sampleCount >= itemCount;
+		if (all)
+			sampleCount = itemCount;
+		uint8_t item[CacheLineSize];
+		for (uint64_t i = 0; i < sampleCount; ++i) {
+			const uint32_t itemNumber = all ? (uint32_t)i : gen.getUInt32() % itemCount;
+			initDatasetItem(cache, item, itemNumber);
+			if (memcmp(item, dataset + itemNumber * (uint64_t)CacheLineSize, CacheLineSize) != 0)
+				return false;
+		}
+		return true;
+	}
+
 	void initDataset(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem) {
-		for (uint32_t itemNumber = startItem; itemNumber < endItem; ++itemNumber, dataset += CacheLineSize)
-			initDatasetItem(cache, dataset, itemNumber);
+		if (cache->aotItem != nullptr) {
+			//the compiled module is faster than the grouped bytecode
+			for (uint32_t itemNumber = startItem; itemNumber < endItem; ++itemNumber, dataset += CacheLineSize)
+				cache->aotItem(cache->memory, dataset, itemNumber);
+			return;
+		}
+		for (uint32_t itemNumber = startItem; itemNumber < endItem; itemNumber += DatasetItemGroupSize, dataset += DatasetItemGroupSize * CacheLineSize)
+			initDatasetItems(cache, dataset, itemNumber, std::min<uint32_t>(endItem - itemNumber, DatasetItemGroupSize));
+	}
+
+	//the bytecode is passed to backends as is
+	static_assert(sizeof(SuperscalarByteCode) == sizeof(randomx_superscalar_instruction), "Invalid superscalar instruction size");
+	static_assert(offsetof(SuperscalarByteCode, type) == offsetof(randomx_superscalar_instruction, opcode), "Invalid superscalar instruction layout");
+	static_assert((int)SuperscalarInstructionType::IMUL_RCP == RANDOMX_SUPERSCALAR_IMUL_RCP, "Invalid superscalar opcode");
+	static_assert((int)SuperscalarInstructionType::COUNT == RANDOMX_SUPERSCALAR_END, "Invalid superscalar opcode");
+
+	void getDatasetInitContext(randomx_cache* cache, randomx_dataset_init_context* context) {
+		assert(!cache->superscalarBytecode.empty());
+		context->cacheMemory = cache->memory;
+		context->cacheSize = CacheSize;
+		context->programs = (const randomx_superscalar_instruction*)cache->superscalarBytecode.data();
+		context->programsLength = cache->superscalarBytecode.size();
+	}
+
+#if defined(RANDOMX_COMPILER_X86)
+	void initDatasetAvx512(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem) {
+		//the vectorized code calculates groups of 8 items, the remainder is left to the scalar code
+		constexpr uint32_t groupSize = JitCompilerX86Avx512::ItemsPerIteration;
+		uint32_t vectorEnd = startItem + (endItem - startItem) / groupSize * groupSize;
+		if (vectorEnd != startItem)
+			cache->jit->getDatasetInitAvx512Func()(cache, dataset, startItem, vectorEnd);
+		if (vectorEnd != endItem)
+			cache->jit->getDatasetInitFunc()(cache, dataset + (vectorEnd - startItem) * CacheLineSize, vectorEnd, endItem);
+	}
+#endif
+
+	//Threads claim chunks of items from a shared counter until the range is exhausted,
+	//so a slow or preempted thread delays at most one chunk.
+	static void initDatasetChunks(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem, std::atomic<uint32_t>& nextChunk) {
+		const uint32_t chunkCount = (endItem - startItem + DatasetInitChunkSize - 1) / DatasetInitChunkSize;
+		for (uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+			uint32_t first = startItem + chunk * DatasetInitChunkSize;
+			uint32_t last = std::min(first + DatasetInitChunkSize, endItem);
+			cache->datasetInit(cache, dataset + (first - startItem) * CacheLineSize, first, last);
+			RANDOMX_TRACE2(dataset_chunk, first, last);
+		}
+	}
+
+	void initDatasetParallel(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem, unsigned threadCount, uint64_t affinityMask) {
+		std::atomic<uint32_t> nextChunk(0);
+		auto worker = [&]() {
+			initDatasetChunks(cache, dataset, startItem, endItem, nextChunk);
+		};
+		std::vector<std::thread> threads;
+		for (unsigned i = 1; i < threadCount; ++i) {
+			try {
+				threads.emplace_back([&, i]() {
+					if (affinityMask != 0) {
+						setThreadAffinity(cpuFromMask(affinityMask, i));
+					}
+					worker();
+				});
+			}
+			catch (std::system_error&) {
+				break; //the remaining chunks are processed by the threads already running
+			}
+		}
+		worker();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void initDatasetParallel(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem, const std::vector<unsigned>& cpus) {
+		std::atomic<uint32_t> nextChunk(0);
+		std::vector<std::thread> threads;
+		for (unsigned cpu : cpus) {
+			try {
+				threads.emplace_back([&, cpu]() {
+					setThreadAffinity(cpu);
+					initDatasetChunks(cache, dataset, startItem, endItem, nextChunk);
+				});
+			}
+			catch (std::system_error&) {
+				break;
+			}
+		}
+		if (threads.empty()) {
+			initDatasetChunks(cache, dataset, startItem, endItem, nextChunk);
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	constexpr size_t PrefaultChunkSize = 32 * 1024 * 1024;
+
+	void prefaultMemory(uint8_t* memory, size_t size, size_t pageSize, unsigned threadCount, uint64_t affinityMask) {
+		//The first write to each page allocates it, so the pages are placed on the node
+		//of the touching thread unless the memory is bound to a node.
+		std::atomic<size_t> nextChunk(0);
+		const size_t chunkCount = (size + PrefaultChunkSize - 1) / PrefaultChunkSize;
+		auto worker = [&]() {
+			for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+				size_t first = chunk * PrefaultChunkSize;
+				size_t last = std::min(first + PrefaultChunkSize, size);
+				for (size_t offset = first; offset < last; offset += pageSize) {
+					((volatile uint8_t*)memory)[offset] = 0;
+				}
+			}
+		};
+		std::vector<std::thread> threads;
+		for (unsigned i = 1; i < threadCount; ++i) {
+			try {
+				threads.emplace_back([&, i]() {
+					if (affinityMask != 0) {
+						setThreadAffinity(cpuFromMask(affinityMask, i));
+					}
+					worker();
+				});
+			}
+			catch (std::system_error&) {
+				break;
+			}
+		}
+		worker();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	randomx_dataset* getDatasetReplica(randomx_dataset* dataset, int node) {
+		if (node < 0 || dataset->replicaCount == 0)
+			return dataset;
+		return dataset->replicas[node % dataset->replicaCount];
+	}
+
+	void copyDatasetReplicas(randomx_dataset* dataset, uint64_t offset, uint64_t size, bool parallel) {
+		//each replica is written by a thread of its own node, so pages are placed locally also
+		//on systems where bindMemoryToNode is not supported
+		auto copy = [=](unsigned node) {
+			if (parallel) {
+				auto cpus = getNumaNodeCpus(node);
+				if (!cpus.empty())
+					setThreadAffinity(cpus[0]);
+			}
+			memcpy(dataset->replicas[node]->memory + offset, dataset->memory + offset, size);
+		};
+		std::vector<std::thread> threads;
+		for (unsigned node = 1; node < dataset->replicaCount; ++node) {
+			if (parallel) {
+				try {
+					threads.emplace_back(copy, node);
+					continue;
+				}
+				catch (std::system_error&) {
+				}
+			}
+			memcpy(dataset->replicas[node]->memory + offset, dataset->memory + offset, size);
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void prefaultDataset(randomx_dataset* dataset) {
+		auto start = std::chrono::steady_clock::now();
+		if (dataset->replicaCount == 0) {
+			prefaultMemory(dataset->memory, DatasetSize, dataset->pageSize, std::max(std::thread::hardware_concurrency(), 1u), 0);
+		}
+		else {
+			//all nodes are pre-faulted at the same time, each by the threads of its node
+			auto prefault = [=](unsigned node, bool pin) {
+				auto cpus = getNumaNodeCpus(node);
+				uint64_t mask = 0;
+				for (unsigned cpu : cpus) {
+					if (cpu < 64)
+						mask |= 1ULL << cpu;
+				}
+				if (pin && mask != 0)
+					setThreadAffinity(cpuFromMask(mask, 0));
+				randomx_dataset* replica = dataset->replicas[node];
+				prefaultMemory(replica->memory, DatasetSize, replica->pageSize, std::max((unsigned)cpus.size(), 1u), mask);
+			};
+			std::vector<std::thread> threads;
+			for (unsigned node = 0; node < dataset->replicaCount; ++node) {
+				try {
+					threads.emplace_back(prefault, node, true);
+				}
+				catch (std::system_error&) {
+					prefault(node, false);
+				}
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		dataset->prefaultTime = elapsed.count();
+	}
+
+	void hashConfiguration(void* out) {
+		const uint64_t parameters[] = {
+			RANDOMX_ARGON_MEMORY, RANDOMX_ARGON_ITERATIONS, RANDOMX_ARGON_LANES, RANDOMX_CACHE_ACCESSES,
+			RANDOMX_SUPERSCALAR_LATENCY, RANDOMX_DATASET_BASE_SIZE, RANDOMX_DATASET_EXTRA_SIZE
+		};
+		blake2b_state state;
+		blake2b_init(&state, ConfigurationHashSize);
+		blake2b_update(&state, parameters, sizeof(parameters));
+		blake2b_update(&state, RANDOMX_ARGON_SALT, sizeof(RANDOMX_ARGON_SALT) - 1);
+		blake2b_final(&state, out, ConfigurationHashSize);
+	}
+
+	//Dataset files start with a header padded to the size of a large page, so the dataset
+	//stays aligned when the file is placed on hugetlbfs.
+	constexpr char DatasetFileMagic[8] = { 'R', 'a', 'n', 'd', 'o', 'm', 'X', 'D' };
+	constexpr uint32_t DatasetFileVersion = 1;
+	constexpr size_t DatasetFileHeaderSize = 2 * 1024 * 1024;
+	constexpr size_t DatasetFileSize = alignSize(DatasetFileHeaderSize + DatasetSize, DatasetFileHeaderSize);
+
+	struct DatasetFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t datasetSize;
+		uint8_t configHash[ConfigurationHashSize];
+		uint8_t keyHash[32];
+	};
+
+	static void initDatasetFileHeader(DatasetFileHeader& header, const void* key, size_t keySize) {
+		memcpy(header.magic, DatasetFileMagic, sizeof(header.magic));
+		header.version = DatasetFileVersion;
+		header.headerSize = DatasetFileHeaderSize;
+		header.datasetSize = DatasetSize;
+		hashConfiguration(header.configHash);
+		blake2b(header.keyHash, sizeof(header.keyHash), key, keySize, nullptr, 0);
+	}
+
+	bool saveDatasetFile(const uint8_t* dataset, const void* key, size_t keySize, const char* path) {
+		uint8_t* file = (uint8_t*)mapFileMemory(path, DatasetFileSize, 1);
+		if (file == nullptr)
+			return false;
+		DatasetFileHeader header = {};
+		initDatasetFileHeader(header, key, keySize);
+		memcpy(file + DatasetFileHeaderSize, dataset, DatasetSize);
+		//the header goes last, so an interrupted save never produces a valid file
+		memcpy(file, &header, sizeof(header));
+		unmapFileMemory(file, DatasetFileSize);
+		return true;
+	}
+
+	uint8_t* mapDatasetFile(const char* path, const void* key, size_t keySize) {
+		uint8_t* file = (uint8_t*)mapFileMemory(path, DatasetFileSize, 0);
+		if (file == nullptr)
+			return nullptr;
+		DatasetFileHeader expected = {};
+		initDatasetFileHeader(expected, key, keySize);
+		if (memcmp(file, &expected, sizeof(expected)) != 0) {
+			unmapFileMemory(file, DatasetFileSize);
+			return nullptr;
+		}
+		return file + DatasetFileHeaderSize;
+	}
+
+	void deallocMappedDataset(randomx_dataset* dataset) {
+		if (dataset->memory != nullptr)
+			unmapFileMemory(dataset->memory - DatasetFileHeaderSize, DatasetFileSize);
+	}
+
+	//Shared datasets use the dataset file layout. The generation counter is odd while the
+	//creator initializes the dataset and is incremented to an even value when it's published.
+	struct SharedDatasetHeader {
+		DatasetFileHeader info;
+		std::atomic<uint32_t> generation;
+	};
+
+	static_assert(sizeof(SharedDatasetHeader) <= DatasetFileHeaderSize, "Invalid shared dataset header size");
+
+	static SharedDatasetHeader* getSharedDatasetHeader(const uint8_t* dataset) {
+		return (SharedDatasetHeader*)(dataset - DatasetFileHeaderSize);
+	}
+
+	uint8_t* createSharedDataset(const char* name) {
+		uint8_t* shared = (uint8_t*)mapSharedMemory(name, DatasetFileSize, 1);
+		if (shared == nullptr)
+			return nullptr;
+		auto header = (SharedDatasetHeader*)shared;
+		uint32_t generation = header->generation.load();
+		if (generation % 2 == 0)
+			header->generation.store(generation + 1);
+		return shared + DatasetFileHeaderSize;
+	}
+
+	void publishSharedDataset(uint8_t* dataset, const void* key, size_t keySize) {
+		auto header = getSharedDatasetHeader(dataset);
+		initDatasetFileHeader(header->info, key, keySize);
+		header->generation.store(header->generation.load() | 1, std::memory_order_relaxed);
+		header->generation.fetch_add(1, std::memory_order_release);
+	}
+
+	uint8_t* attachSharedDataset(const char* name, const void* key, size_t keySize) {
+		uint8_t* shared = (uint8_t*)mapSharedMemory(name, DatasetFileSize, 0);
+		if (shared == nullptr)
+			return nullptr;
+		auto header = (SharedDatasetHeader*)shared;
+		DatasetFileHeader expected = {};
+		initDatasetFileHeader(expected, key, keySize);
+		uint32_t generation = header->generation.load(std::memory_order_acquire);
+		if (generation == 0 || generation % 2 != 0 || memcmp(&header->info, &expected, sizeof(expected)) != 0) {
+			unmapFileMemory(shared, DatasetFileSize);
+			return nullptr;
+		}
+		return shared + DatasetFileHeaderSize;
+	}
+
+	uint32_t getSharedDatasetGeneration(const uint8_t* dataset) {
+		return getSharedDatasetHeader(dataset)->generation.load(std::memory_order_acquire);
+	}
+
+	//Cache file layout: header, key, programs (size, address register, instructions), reciprocals, Argon2 memory
+	constexpr char CacheFileMagic[8] = { 'R', 'a', 'n', 'd', 'o', 'm', 'X', 'C' };
+	constexpr uint32_t CacheFileVersion = 1;
+
+	struct CacheFileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t keySize;
+		uint32_t programCount;
+		uint32_t reciprocalCount;
+		uint64_t memorySize;
+		uint8_t configHash[ConfigurationHashSize];
+	};
+
+	static bool writeCacheFile(randomx_cache* cache, FILE* file) {
+		CacheFileHeader header = {};
+		memcpy(header.magic, CacheFileMagic, sizeof(header.magic));
+		header.version = CacheFileVersion;
+		header.keySize = (uint32_t)cache->cacheKey.size();
+		header.programCount = RANDOMX_CACHE_ACCESSES;
+		header.reciprocalCount = (uint32_t)cache->reciprocalCache.size();
+		header.memorySize = CacheSize;
+		hashConfiguration(header.configHash);
+		if (fwrite(&header, sizeof(header), 1, file) != 1)
+			return false;
+		if (header.keySize > 0 && fwrite(cache->cacheKey.data(), header.keySize, 1, file) != 1)
+			return false;
+		for (auto& prog : cache->programs) {
+			const uint32_t info[] = { prog.getSize(), (uint32_t)prog.getAddressRegister() };
+			if (fwrite(info, sizeof(info), 1, file) != 1)
+				return false;
+			if (fwrite(prog.programBuffer, sizeof(Instruction), prog.getSize(), file) != prog.getSize())
+				return false;
+		}
+		if (header.reciprocalCount > 0 && fwrite(cache->reciprocalCache.data(), sizeof(uint64_t), header.reciprocalCount, file) != header.reciprocalCount)
+			return false;
+		return fwrite(cache->memory, CacheSize, 1, file) == 1;
+	}
+
+	static bool readCacheFile(randomx_cache* cache, FILE* file) {
+		CacheFileHeader header, expected = {};
+		if (cache->itemCache != nullptr)
+			cache->itemCache->invalidate();
+		if (cache->resultCache != nullptr)
+			cache->resultCache->invalidate();
+		memcpy(expected.magic, CacheFileMagic, sizeof(expected.magic));
+		hashConfiguration(expected.configHash);
+		if (fread(&header, sizeof(header), 1, file) != 1)
+			return false;
+		if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != CacheFileVersion)
+			return false;
+		if (memcmp(header.configHash, expected.configHash, sizeof(header.configHash)) != 0)
+			return false;
+		if (header.programCount != RANDOMX_CACHE_ACCESSES || header.memorySize != CacheSize)
+			return false;
+		if (header.reciprocalCount > RANDOMX_CACHE_ACCESSES * SuperscalarMaxSize)
+			return false;
+		cache->cacheKey.resize(header.keySize);
+		if (header.keySize > 0 && fread(&cache->cacheKey[0], header.keySize, 1, file) != 1)
+			return false;
+		for (auto& prog : cache->programs) {
+			uint32_t info[2];
+			if (fread(info, sizeof(info), 1, file) != 1)
+				return false;
+			if (info[0] == 0 || info[0] > SuperscalarMaxSize || info[1] >= RegistersCount)
+				return false;
+			if (fread(prog.programBuffer, sizeof(Instruction), info[0], file) != info[0])
+				return false;
+			for (unsigned j = 0; j < info[0]; ++j) {
+				auto& instr = prog.programBuffer[j];
+				if (instr.opcode >= (uint8_t)SuperscalarInstructionType::COUNT || instr.dst >= RegistersCount || instr.src >= RegistersCount)
+					return false;
+				if ((SuperscalarInstructionType)instr.opcode == SuperscalarInstructionType::IMUL_RCP && instr.getImm32() >= header.reciprocalCount)
+					return false;
+			}
+			prog.setSize(info[0]);
+			prog.setAddressRegister(info[1]);
+		}
+		cache->reciprocalCache.resize(header.reciprocalCount);
+		if (header.reciprocalCount > 0 && fread(cache->reciprocalCache.data(), sizeof(uint64_t), header.reciprocalCount, file) != header.reciprocalCount)
+			return false;
+		compileSuperscalarBytecode(cache);
+		return fread(cache->memory, CacheSize, 1, file) == 1;
+	}
+
+	bool saveCacheFile(randomx_cache* cache, const char* path) {
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+			return false;
+		bool ok = writeCacheFile(cache, file);
+		ok = (fclose(file) == 0) && ok;
+		return ok;
+	}
+
+	bool loadCacheFile(randomx_cache* cache, const char* path) {
+		cache->aotItem = nullptr;
+		FILE* file = fopen(path, "rb");
+		bool ok = file != nullptr && readCacheFile(cache, file);
+		if (file != nullptr)
+			fclose(file);
+		if (!ok) {
+			//the cache may have been partially overwritten
+			cache->programs[0].setSize(0);
+			cache->cacheKey.clear();
+			return false;
+		}
+		if (cache->jit != nullptr) {
+			compileCache(cache);
+		}
+		return true;
 	}
 }
@@ -31,32 +31,56 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstdint>
 #include <vector>
 #include <type_traits>
+#include <atomic>
 #include "common.hpp"
 #include "superscalar_program.hpp"
 #include "allocator.hpp"
 #include "argon2.h"
+#include "item_cache.hpp"
+#include "result_cache.hpp"
 
 /* Global scope for C binding */
 struct randomx_dataset {
 	uint8_t* memory = nullptr;
 	randomx::DatasetDeallocFunc* dealloc;
+	randomx_dataset* replicas[randomx::MaxNumaNodes] = {}; //one copy per NUMA node, replicas[0] is the dataset itself
+	unsigned replicaCount = 0;                           //0 if the dataset is not replicated
+	size_t pageSize = 0;                                 //size of the pages backing the memory
+	randomx_page_backing pageBacking = RANDOMX_PAGES_STANDARD;
+	double prefaultTime = 0;                             //seconds spent pre-faulting the memory of all copies
 };
 
 /* Global scope for C binding */
 struct randomx_cache {
 	uint8_t* memory = nullptr;
 	randomx::CacheDeallocFunc* dealloc;
+	randomx::MemoryAllocFunc* allocMemory;
+	randomx::MemoryFreeFunc* freeMemory;
 	randomx::JitCompiler* jit;
 	randomx::CacheInitializeFunc* initialize;
 	randomx::DatasetInitFunc* datasetInit;
 	randomx::SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES];
 	std::vector<uint64_t> reciprocalCache;
+	std::vector<randomx::SuperscalarByteCode> superscalarBytecode; //all programs, used by initDatasetItem
 	std::string cacheKey;
 	randomx_argon2_impl* argonImpl;
+	randomx_page_backing pageBacking = RANDOMX_PAGES_STANDARD;
+	randomx::SharedItemCache* itemCache = nullptr; //dataset items shared by interpreted light-mode VMs
+	randomx::SharedResultCache* resultCache = nullptr; //hash results shared by light-mode VMs
+	randomx_dataset_item_func* aotItem = nullptr; //SuperscalarHash compiled ahead of time for the current key
 
 	bool isInitialized() {
 		return programs[0].getSize() != 0;
 	}
+
+	//the memory was released or handed over after the dataset was initialized
+	bool isDrained() {
+		return memory == nullptr;
+	}
+};
+
+struct randomx_cancel_token {
+	std::atomic<bool> cancelled{ false };
 };
 
 //A pointer to a standard-layout struct object points to its initial member
@@ -76,6 +100,28 @@ static_assert(std::is_standard_layout<randomx_cache>(), "randomx_cache must be a
 namespace randomx {
 
 	using DefaultAllocator = AlignedAllocator<CacheLineSize>;
+	using CacheAllocator = AlignedAllocator<CacheAlignment>;
+
+	constexpr size_t ConfigurationHashSize = 32;
+	constexpr uint32_t DatasetInitChunkSize = 16384; //1 MiB of dataset items per work unit
+
+	//progress reporting and cancellation of an initialization
+	struct InitProgress {
+		randomx_progress_callback* callback;
+		void* userData;
+		randomx_cancel_token* cancel;
+
+		bool isCancelled() const {
+			return cancel != nullptr && cancel->cancelled.load(std::memory_order_relaxed);
+		}
+		void report(uint64_t done, uint64_t total) const {
+			if (callback != nullptr)
+				callback(userData, done, total);
+		}
+	};
+
+	//Argon2 segments followed by the SuperscalarHash programs
+	constexpr uint64_t CacheInitUnits = (uint64_t)RANDOMX_ARGON_ITERATIONS * ARGON2_SYNC_POINTS * RANDOMX_ARGON_LANES + 1;
 
 	template<class Allocator>
 	void deallocDataset(randomx_dataset* dataset) {
@@ -86,12 +132,45 @@ namespace randomx {
 	template<class Allocator>
 	void deallocCache(randomx_cache* cache);
 
-	void initCache(randomx_cache*, const void*, size_t);
-	void initCacheCompile(randomx_cache*, const void*, size_t);
+	bool initCache(randomx_cache*, const void*, size_t, const InitProgress*, unsigned);
+	bool initCacheCompile(randomx_cache*, const void*, size_t, const InitProgress*, unsigned);
 	void initDatasetItem(randomx_cache* cache, uint8_t* out, uint64_t blockNumber);
+	//like initDatasetItem, but takes the item from the shared item cache if possible
+	void readDatasetItem(randomx_cache* cache, uint8_t* out, uint32_t itemNumber);
+	//number of items calculated at once by initDatasetItems
+	constexpr unsigned DatasetItemGroupSize = 8;
+	void initDatasetItems(randomx_cache* cache, uint8_t* out, uint64_t firstItem, unsigned count);
 	void initDataset(randomx_cache* cache, uint8_t* dataset, uint32_t startBlock, uint32_t endBlock);
+	//describes the cache to a randomx_dataset_backend
+	void getDatasetInitContext(randomx_cache* cache, randomx_dataset_init_context* context);
+	void initDatasetAvx512(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem);
+	void initDatasetParallel(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem, unsigned threadCount, uint64_t affinityMask);
+	//one thread pinned to each of the CPUs, the calling thread only waits for them
+	void initDatasetParallel(randomx_cache* cache, uint8_t* dataset, uint32_t startItem, uint32_t endItem, const std::vector<unsigned>& cpus);
+	void prefaultMemory(uint8_t* memory, size_t size, size_t pageSize, unsigned threadCount, uint64_t affinityMask);
+	randomx_dataset* getDatasetReplica(randomx_dataset* dataset, int node);
+	void copyDatasetReplicas(randomx_dataset* dataset, uint64_t offset, uint64_t size, bool parallel);
+	//recalculates sampleCount items selected by the seed and compares them with the dataset
+	bool verifyDatasetSample(randomx_cache* cache, const uint8_t* dataset, uint64_t sampleCount, const void* seed, size_t seedSize);
+	void prefaultDataset(randomx_dataset* dataset);
+	void hashConfiguration(void* out);
+	bool saveDatasetFile(const uint8_t* dataset, const void* key, size_t keySize, const char* path);
+	uint8_t* mapDatasetFile(const char* path, const void* key, size_t keySize);
+	void deallocMappedDataset(randomx_dataset* dataset);
+	uint8_t* createSharedDataset(const char* name);
+	void publishSharedDataset(uint8_t* dataset, const void* key, size_t keySize);
+	uint8_t* attachSharedDataset(const char* name, const void* key, size_t keySize);
+	uint32_t getSharedDatasetGeneration(const uint8_t* dataset);
+	bool saveCacheFile(randomx_cache* cache, const char* path);
+	bool loadCacheFile(randomx_cache* cache, const char* path);
 
 	inline randomx_argon2_impl* selectArgonImpl(randomx_flags flags) {
+		if (flags & RANDOMX_FLAG_ARGON2_NEON) {
+			return randomx_argon2_impl_neon();
+		}
+		if (flags & RANDOMX_FLAG_ARGON2_AVX512) {
+			return randomx_argon2_impl_avx512();
+		}
 		if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
 			return randomx_argon2_impl_avx2();
 		}
@@ -0,0 +1,305 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <cassert>
+#include "engine.hpp"
+
+namespace randomx {
+
+	ThreadAutoscaler::ThreadAutoscaler(unsigned minThreads, unsigned maxThreads, unsigned threads) : minThreads(minThreads), maxThreads(maxThreads), threads(threads) {
+		assert(minThreads >= 1 && minThreads <= threads && threads <= maxThreads);
+	}
+
+	unsigned ThreadAutoscaler::change(unsigned newThreads, State newState) {
+		threads = newThreads;
+		state = newState;
+		//the first interval after a change also includes the old thread count
+		settling = true;
+		return threads;
+	}
+
+	unsigned ThreadAutoscaler::update(double hashrate, bool saturated) {
+		if (settling) {
+			settling = false;
+			return threads;
+		}
+		if (!saturated) {
+			//limited by the requests, not the threads
+			if (state != State::Stable)
+				return change(state == State::ProbeUp ? threads - 1 : threads + 1, State::Stable);
+			baseline = 0;
+			return threads;
+		}
+		switch (state) {
+		case State::Stable:
+			if (baseline == 0) {
+				baseline = hashrate;
+				stableIntervals = 0;
+				return threads;
+			}
+			if (hashrate < baseline * (1 - Tolerance)) {
+				//other processes take bandwidth, fewer threads might be faster now
+				baseline = hashrate;
+				stableIntervals = 0;
+				if (threads > minThreads)
+					return change(threads - 1, State::ProbeDown);
+				return threads;
+			}
+			baseline = (baseline + hashrate) / 2;
+			if (++stableIntervals < ProbePeriod)
+				return threads;
+			stableIntervals = 0;
+			probeUpNext = !probeUpNext;
+			if ((probeUpNext || threads == minThreads) && threads < maxThreads)
+				return change(threads + 1, State::ProbeUp);
+			if (threads > minThreads)
+				return change(threads - 1, State::ProbeDown);
+			return threads;
+		case State::ProbeUp:
+			if (hashrate > baseline * (1 + Tolerance)) {
+				baseline = hashrate;
+				if (threads < maxThreads)
+					return change(threads + 1, State::ProbeUp);
+				state = State::Stable;
+				return threads;
+			}
+			return change(threads - 1, State::Stable);
+		case State::ProbeDown:
+			//with the same hashrate, fewer threads leave more bandwidth to other processes
+			if (hashrate >= baseline) {
+				baseline = hashrate;
+				if (threads > minThreads)
+					return change(threads - 1, State::ProbeDown);
+				state = State::Stable;
+				return threads;
+			}
+			return change(threads + 1, State::Stable);
+		}
+		return threads;
+	}
+}
+
+randomx_engine::RequestQueue::RequestQueue() : head(&stub), tail(&stub) {
+	stub.next.store(nullptr);
+}
+
+void randomx_engine::RequestQueue::push(Request* request) {
+	request->next.store(nullptr, std::memory_order_relaxed);
+	Request* prev = head.exchange(request);
+	prev->next.store(request, std::memory_order_release);
+}
+
+//Returns nullptr if the queue is empty or a producer has not finished linking its request yet.
+randomx_engine::Request* randomx_engine::RequestQueue::pop() {
+	Request* last = tail;
+	Request* next = last->next.load(std::memory_order_acquire);
+	if (last == &stub) {
+		if (next == nullptr)
+			return nullptr;
+		tail = next;
+		last = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+	if (next != nullptr) {
+		tail = next;
+		return last;
+	}
+	if (last != head.load())
+		return nullptr;
+	push(&stub);
+	next = last->next.load(std::memory_order_acquire);
+	if (next != nullptr) {
+		tail = next;
+		return last;
+	}
+	return nullptr;
+}
+
+randomx_engine::randomx_engine(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned threadCount) : activeWorkers(threadCount) {
+	try {
+		for (unsigned i = 0; i < threadCount; ++i) {
+			Worker* worker = new Worker();
+			worker->index = i;
+			workers.push_back(worker);
+			worker->vm = randomx_create_vm(flags, cache, dataset);
+			if (worker->vm == nullptr)
+				throw std::bad_alloc();
+		}
+		for (auto worker : workers) {
+			worker->thread = std::thread(&randomx_engine::run, this, std::ref(*worker));
+		}
+	}
+	catch (...) {
+		stopping.store(true);
+		for (auto worker : workers) {
+			if (worker->thread.joinable()) {
+				{
+					std::lock_guard<std::mutex> lock(worker->mutex);
+					worker->wakeup.notify_one();
+				}
+				worker->thread.join();
+			}
+			if (worker->vm != nullptr)
+				randomx_destroy_vm(worker->vm);
+			delete worker;
+		}
+		throw;
+	}
+}
+
+//Waits until the workers have processed all submitted requests.
+randomx_engine::~randomx_engine() {
+	stopControl();
+	stopping.store(true);
+	for (auto worker : workers) {
+		{
+			std::lock_guard<std::mutex> lock(worker->mutex);
+			worker->wakeup.notify_one();
+		}
+		worker->thread.join();
+		randomx_destroy_vm(worker->vm);
+		delete worker;
+	}
+}
+
+void randomx_engine::submit(const void* input, size_t inputSize, randomx_hash_callback* callback, void* userData) {
+	Request* request = new Request();
+	request->input.assign((const uint8_t*)input, (const uint8_t*)input + inputSize);
+	request->callback = callback;
+	request->userData = userData;
+	Worker& worker = *workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % activeWorkers.load(std::memory_order_relaxed)];
+	worker.queue.push(request);
+	if (worker.sleeping.load()) {
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.wakeup.notify_one();
+	}
+}
+
+void randomx_engine::complete(Request* request, const void* hash) {
+	request->callback(request->userData, hash);
+	delete request;
+	completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+//Stopped workers finish their queued requests, so the controller has no effect on pending hashes.
+void randomx_engine::setAutoscale(unsigned minThreads, unsigned intervalMs) {
+	stopControl();
+	activeWorkers.store(workers.size());
+	if (intervalMs == 0)
+		return;
+	assert(minThreads >= 1 && minThreads <= workers.size());
+	controlStopping = false;
+	controller = std::thread(&randomx_engine::control, this, minThreads, std::chrono::milliseconds(intervalMs));
+}
+
+void randomx_engine::stopControl() {
+	if (!controller.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(controlMutex);
+		controlStopping = true;
+		controlWakeup.notify_one();
+	}
+	controller.join();
+	hashrate = 0;
+}
+
+void randomx_engine::control(unsigned minThreads, std::chrono::milliseconds interval) {
+	randomx::ThreadAutoscaler autoscaler(minThreads, workers.size(), workers.size());
+	auto start = std::chrono::steady_clock::now();
+	uint64_t startCompleted = completed.load();
+	uint64_t startIdleWaits = idleWaits.load();
+	std::unique_lock<std::mutex> lock(controlMutex);
+	while (!controlWakeup.wait_for(lock, interval, [this]() { return controlStopping; })) {
+		auto now = std::chrono::steady_clock::now();
+		uint64_t nowCompleted = completed.load();
+		uint64_t nowIdleWaits = idleWaits.load();
+		std::chrono::duration<double> elapsed = now - start;
+		hashrate = (nowCompleted - startCompleted) / elapsed.count();
+		activeWorkers.store(autoscaler.update(hashrate, nowIdleWaits == startIdleWaits));
+		start = now;
+		startCompleted = nowCompleted;
+		startIdleWaits = nowIdleWaits;
+	}
+}
+
+void randomx_engine::getStats(randomx_engine_stats* stats) {
+	std::lock_guard<std::mutex> lock(controlMutex);
+	stats->hashes = completed.load();
+	stats->hashrate = hashrate;
+	stats->threadCount = workers.size();
+	stats->activeThreads = activeWorkers.load();
+}
+
+//Returns the next request of the worker, or nullptr if the engine is stopping and the queue is empty.
+randomx_engine::Request* randomx_engine::waitForRequest(Worker& worker) {
+	for (;;) {
+		Request* request = worker.queue.pop();
+		if (request != nullptr)
+			return request;
+		if (!worker.queue.isEmpty()) {
+			std::this_thread::yield(); //a producer is linking its request
+			continue;
+		}
+		//stopped workers run out of work as intended
+		if (worker.index < activeWorkers.load(std::memory_order_relaxed))
+			idleWaits.fetch_add(1, std::memory_order_relaxed);
+		std::unique_lock<std::mutex> lock(worker.mutex);
+		worker.sleeping.store(true);
+		//a producer that didn't see the flag pushed before it was set, so the queue is not empty
+		worker.wakeup.wait(lock, [&]() { return !worker.queue.isEmpty() || stopping.load(); });
+		worker.sleeping.store(false);
+		if (worker.queue.isEmpty())
+			return nullptr;
+	}
+}
+
+//When more requests are queued, the hashes are calculated with randomx_calculate_hash_next,
+//which overlaps the initialization of the next hash with the end of the previous one.
+void randomx_engine::run(Worker& worker) {
+	alignas(16) uint8_t hash[RANDOMX_HASH_SIZE];
+	Request* request;
+	while ((request = waitForRequest(worker)) != nullptr) {
+		Request* next = worker.queue.pop();
+		if (next == nullptr) {
+			randomx_calculate_hash(worker.vm, request->input.data(), request->input.size(), hash);
+			complete(request, hash);
+			continue;
+		}
+		randomx_calculate_hash_first(worker.vm, request->input.data(), request->input.size());
+		while (next != nullptr) {
+			randomx_calculate_hash_next(worker.vm, next->input.data(), next->input.size(), hash);
+			complete(request, hash);
+			request = next;
+			next = worker.queue.pop();
+		}
+		randomx_calculate_hash_last(worker.vm, hash);
+		complete(request, hash);
+	}
+}
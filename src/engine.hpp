@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <new>
+#include "common.hpp"
+#include "allocator.hpp"
+
+namespace randomx {
+
+	//Hill climbing on the number of threads. Past a host-specific count, more threads lower the
+	//total hashrate because dataset reads saturate the memory bandwidth, and the count that gives
+	//the maximum changes when other processes compete for the bandwidth.
+	class ThreadAutoscaler {
+	public:
+		ThreadAutoscaler(unsigned minThreads, unsigned maxThreads, unsigned threads);
+		//Takes the hashrate measured with the current number of threads during the last interval
+		//and returns the number of threads to use during the next one. Intervals in which some
+		//threads ran out of work only measure the demand, so they don't change the count.
+		unsigned update(double hashrate, bool saturated);
+		unsigned getThreads() const {
+			return threads;
+		}
+		//relative change of the hashrate that is not considered noise
+		static constexpr double Tolerance = 0.02;
+		//number of stable intervals before the neighbouring thread counts are probed again
+		static constexpr unsigned ProbePeriod = 8;
+	private:
+		enum class State {
+			Stable,
+			ProbeUp,
+			ProbeDown,
+		};
+		unsigned change(unsigned newThreads, State newState);
+		unsigned minThreads, maxThreads, threads;
+		State state = State::Stable;
+		bool settling = false;
+		bool probeUpNext = false;
+		unsigned stableIntervals = 0;
+		double baseline = 0;
+	};
+}
+
+/* Global scope for C binding */
+class randomx_engine {
+public:
+	randomx_engine(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned threadCount);
+	~randomx_engine();
+	void submit(const void* input, size_t inputSize, randomx_hash_callback* callback, void* userData);
+	void setAutoscale(unsigned minThreads, unsigned intervalMs);
+	void getStats(randomx_engine_stats* stats);
+private:
+	struct Request {
+		std::atomic<Request*> next;
+		std::vector<uint8_t> input;
+		randomx_hash_callback* callback;
+		void* userData;
+	};
+	//Intrusive multi-producer single-consumer queue (D. Vyukov). Producers only swap the head
+	//pointer, the worker owning the queue pops from the tail.
+	class RequestQueue {
+	public:
+		RequestQueue();
+		void push(Request* request);
+		Request* pop();
+		bool isEmpty() const {
+			return tail == &stub && head.load() == &stub;
+		}
+	private:
+		alignas(randomx::CacheLineSize) std::atomic<Request*> head;
+		alignas(randomx::CacheLineSize) Request* tail;
+		Request stub;
+	};
+	//the queue is cache line aligned, which plain operator new doesn't guarantee in C++11
+	struct Worker {
+		void* operator new(size_t size) {
+			void* ptr = randomx::AlignedAllocator<randomx::CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			randomx::AlignedAllocator<randomx::CacheLineSize>::freeMemory(ptr, sizeof(Worker));
+		}
+		unsigned index;
+		randomx_vm* vm = nullptr;
+		RequestQueue queue;
+		std::atomic<bool> sleeping{ false };
+		std::mutex mutex;
+		std::condition_variable wakeup;
+		std::thread thread;
+	};
+	void run(Worker& worker);
+	void control(unsigned minThreads, std::chrono::milliseconds interval);
+	void stopControl();
+	Request* waitForRequest(Worker& worker);
+	void complete(Request* request, const void* hash);
+	std::vector<Worker*> workers;
+	std::atomic<unsigned> nextWorker{ 0 };
+	std::atomic<unsigned> activeWorkers; //requests are only submitted to the first activeWorkers workers
+	std::atomic<uint64_t> completed{ 0 };
+	std::atomic<uint64_t> idleWaits{ 0 }; //times a worker found its queue empty
+	std::atomic<bool> stopping{ false };
+	std::thread controller;
+	std::mutex controlMutex;
+	std::condition_variable controlWakeup;
+	bool controlStopping = false;
+	double hashrate = 0;
+};
@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <system_error>
+#include "epoch.hpp"
+#include "virtual_machine.hpp"
+#include "thread_affinity.hpp"
+
+randomx_epoch::randomx_epoch(randomx_flags flags, unsigned threadCount) : threadCount(threadCount), generation(0) {
+	for (auto& slot : slots) {
+		slot.cache = randomx_alloc_cache((randomx_flags)(flags & ~(RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_NUMA)));
+		if (slot.cache == nullptr) {
+			release();
+			throw std::bad_alloc();
+		}
+		if (flags & RANDOMX_FLAG_FULL_MEM) {
+			slot.dataset = randomx_alloc_dataset(flags);
+			if (slot.dataset == nullptr) {
+				release();
+				throw std::bad_alloc();
+			}
+		}
+	}
+}
+
+randomx_epoch::~randomx_epoch() {
+	if (builder.joinable()) {
+		builder.join();
+	}
+	release();
+}
+
+void randomx_epoch::release() {
+	for (auto& slot : slots) {
+		if (slot.cache != nullptr)
+			randomx_release_cache(slot.cache);
+		if (slot.dataset != nullptr)
+			randomx_release_dataset(slot.dataset);
+	}
+}
+
+bool randomx_epoch::prepare(const void* key, size_t keySize) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (building) {
+		return false;
+	}
+	if (builder.joinable()) {
+		builder.join();
+	}
+	ready = false;
+	building = true;
+	try {
+		builder = std::thread(&randomx_epoch::build, this, std::string((const char*)key, keySize));
+	}
+	catch (std::system_error&) {
+		building = false;
+		return false;
+	}
+	return true;
+}
+
+void randomx_epoch::build(std::string key) {
+	randomx::setThreadLowPriority();
+	int next;
+	{
+		//the current slot doesn't change while building; wait until the virtual machines
+		//that used the other slot before the last switch have moved on
+		std::unique_lock<std::mutex> lock(mutex);
+		next = current ^ 1;
+		changed.wait(lock, [&] { return slots[next].users == 0; });
+	}
+	Slot& slot = slots[next];
+	randomx_init_cache_parallel(slot.cache, key.data(), key.size(), threadCount);
+	if (slot.dataset != nullptr) {
+		randomx_init_dataset_parallel(slot.dataset, slot.cache, threadCount, 0);
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	building = false;
+	ready = true;
+	changed.notify_all();
+}
+
+bool randomx_epoch::switchNext(bool wait) {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (wait) {
+		changed.wait(lock, [this] { return !building; });
+	}
+	if (!ready) {
+		return false;
+	}
+	ready = false;
+	current ^= 1;
+	generation.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+void randomx_epoch::syncVm(randomx_vm* machine) {
+	if (machine->epochGeneration == generation.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	if (machine->epochSlot >= 0) {
+		slots[machine->epochSlot].users--;
+		changed.notify_all();
+	}
+	Slot& slot = slots[current];
+	slot.users++;
+	machine->epochSlot = current;
+	machine->epochGeneration = generation.load(std::memory_order_relaxed);
+	randomx_vm_set_cache(machine, slot.cache);
+	if (slot.dataset != nullptr) {
+		randomx_vm_set_dataset(machine, slot.dataset);
+	}
+}
+
+void randomx_epoch::detachVm(randomx_vm* machine) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (machine->epochSlot >= 0) {
+		slots[machine->epochSlot].users--;
+		changed.notify_all();
+	}
+	machine->epochSlot = -1;
+	machine->epochGeneration = 0;
+}
+
+randomx_cache* randomx_epoch::getCache() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return generation.load(std::memory_order_relaxed) != 0 ? slots[current].cache : nullptr;
+}
+
+randomx_dataset* randomx_epoch::getDataset() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return generation.load(std::memory_order_relaxed) != 0 ? slots[current].dataset : nullptr;
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "randomx.h"
+
+/* Global scope for C binding */
+class randomx_epoch {
+public:
+	randomx_epoch(randomx_flags flags, unsigned threadCount);
+	~randomx_epoch();
+	bool prepare(const void* key, size_t keySize);
+	bool switchNext(bool wait);
+	void syncVm(randomx_vm* machine);
+	void detachVm(randomx_vm* machine);
+	randomx_cache* getCache();
+	randomx_dataset* getDataset();
+	uint32_t getGeneration() {
+		return generation.load(std::memory_order_acquire);
+	}
+private:
+	struct Slot {
+		randomx_cache* cache = nullptr;
+		randomx_dataset* dataset = nullptr;
+		unsigned users = 0; //number of virtual machines using the slot
+	};
+	void build(std::string key);
+	void release();
+	Slot slots[2];
+	int current = 0;    //the slot used by virtual machines, the other slot is prepared in the background
+	bool building = false;
+	bool ready = false;
+	unsigned threadCount;
+	std::atomic<uint32_t> generation; //incremented by every switch, 0 before the first switch
+	std::thread builder;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
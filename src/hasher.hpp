@@ -0,0 +1,174 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "randomx.h"
+#include "dataset.hpp"
+#include "blake2/blake2.h"
+#include "vm_interpreted.hpp"
+#include "vm_interpreted_light.hpp"
+#include "vm_compiled.hpp"
+#include "vm_compiled_light.hpp"
+
+#if defined(__SSE__) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP > 0))
+#include <xmmintrin.h>
+#define RANDOMX_HASHER_CSR
+#else
+#include <cfenv>
+#endif
+
+namespace randomx {
+
+	struct CacheDeleter {
+		void operator()(randomx_cache* cache) const {
+			randomx_release_cache(cache);
+		}
+	};
+
+	struct DatasetDeleter {
+		void operator()(randomx_dataset* dataset) const {
+			randomx_release_dataset(dataset);
+		}
+	};
+
+	using CachePtr = std::unique_ptr<randomx_cache, CacheDeleter>;
+	using DatasetPtr = std::unique_ptr<randomx_dataset, DatasetDeleter>;
+
+	//allocates and initializes a cache, throws std::bad_alloc on failure
+	inline CachePtr makeCache(randomx_flags flags, const void* key, size_t keySize) {
+		CachePtr cache(randomx_alloc_cache(flags));
+		if (!cache)
+			throw std::bad_alloc();
+		randomx_init_cache(cache.get(), key, keySize);
+		return cache;
+	}
+
+	//allocates a dataset and initializes all of its items from the cache, throws std::bad_alloc on failure
+	inline DatasetPtr makeDataset(randomx_flags flags, randomx_cache* cache, unsigned threadCount = 1) {
+		DatasetPtr dataset(randomx_alloc_dataset(flags));
+		if (!dataset)
+			throw std::bad_alloc();
+		randomx_init_dataset_parallel(dataset.get(), cache, threadCount, 0);
+		return dataset;
+	}
+
+	//Calculates hashes with a virtual machine of a fixed type. All calls into the machine are
+	//qualified with Vm, so they are resolved at compile time instead of through the vtable.
+	//The cache or dataset must outlive the Hasher.
+	template<class Vm>
+	class Hasher {
+	public:
+		Hasher(randomx_cache* cache, randomx_dataset* dataset = nullptr) : vm(new Vm()) {
+			if (cache != nullptr) {
+				vm->Vm::setCache(cache);
+				vm->cacheKey = cache->cacheKey;
+			}
+			if (dataset != nullptr)
+				vm->Vm::setDataset(dataset);
+			vm->Vm::allocate();
+		}
+		Hasher(Hasher&&) = default;
+		Hasher& operator=(Hasher&&) = default;
+		Hasher(const Hasher&) = delete;
+		Hasher& operator=(const Hasher&) = delete;
+
+		//switches a light-mode machine to a cache initialized with a new key
+		void setCache(randomx_cache* cache) {
+			if (vm->cacheKey != cache->cacheKey || vm->getMemory() != cache->memory) {
+				vm->Vm::setCache(cache);
+				vm->cacheKey = cache->cacheKey;
+			}
+		}
+
+		void hash(const void* input, size_t inputSize, void* output) {
+			FloatState fpstate;
+			alignas(16) uint64_t tempHash[8];
+			blake2b(tempHash, sizeof(tempHash), input, inputSize, nullptr, 0);
+			vm->Vm::initScratchpad(tempHash);
+			runPrograms(tempHash);
+			vm->Vm::getFinalResult(output, RANDOMX_HASH_SIZE);
+		}
+
+		//same results as randomx_calculate_hash_batch: the scratchpad of each hash is filled
+		//while the previous one is finalized
+		void hashBatch(const void* const* inputs, const size_t* inputSizes, size_t count, void* output) {
+			if (count == 0)
+				return;
+			FloatState fpstate;
+			uint64_t* tempHash = vm->tempHash;
+			uint8_t* out = (uint8_t*)output;
+			blake2b(tempHash, sizeof(vm->tempHash), inputs[0], inputSizes[0], nullptr, 0);
+			vm->Vm::initScratchpad(tempHash);
+			for (size_t i = 1; i < count; ++i, out += RANDOMX_HASH_SIZE) {
+				runPrograms(tempHash);
+				blake2b(tempHash, sizeof(vm->tempHash), inputs[i], inputSizes[i], nullptr, 0);
+				vm->Vm::hashAndFill(out, RANDOMX_HASH_SIZE, tempHash);
+			}
+			runPrograms(tempHash);
+			vm->Vm::getFinalResult(out, RANDOMX_HASH_SIZE);
+		}
+
+		Vm& machine() {
+			return *vm;
+		}
+	private:
+		//restores the floating point environment of the caller
+		class FloatState {
+		public:
+#ifdef RANDOMX_HASHER_CSR
+			FloatState() : csr(_mm_getcsr()) { }
+			~FloatState() { _mm_setcsr(csr); }
+		private:
+			unsigned int csr;
+#else
+			FloatState() { fegetenv(&env); }
+			~FloatState() { fesetenv(&env); }
+		private:
+			fenv_t env;
+#endif
+		};
+
+		void runPrograms(uint64_t* tempHash) {
+			vm->Vm::resetRoundingMode();
+			for (int chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
+				vm->Vm::run(tempHash);
+				blake2b(tempHash, 64, vm->getRegisterFile(), sizeof(RegisterFile), nullptr, 0);
+			}
+			vm->Vm::run(tempHash);
+		}
+
+		std::unique_ptr<Vm> vm;
+	};
+}
+
+#undef RANDOMX_HASHER_CSR
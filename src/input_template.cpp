@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cassert>
+#include "input_template.hpp"
+#include "blake2/endian.h"
+
+randomx_input_template::randomx_input_template(const void* input, size_t size, size_t nonceOffset)
+	: input((const uint8_t*)input), inputSize(size), nonceOffset(nonceOffset)
+{
+	absorbPrefix();
+}
+
+randomx_input_template::randomx_input_template(std::vector<uint8_t>&& input, size_t nonceOffset)
+	: storage(std::move(input)), input(storage.data()), inputSize(storage.size()), nonceOffset(nonceOffset)
+{
+	absorbPrefix();
+}
+
+void randomx_input_template::absorbPrefix() {
+	assert(nonceOffset + sizeof(uint32_t) <= inputSize);
+	blake2b_init(&prefix, BLAKE2B_OUTBYTES);
+	//every complete block before the nonce is compressed now, the rest stays buffered
+	blake2b_update(&prefix, input, nonceOffset);
+}
+
+void randomx_input_template::seed(uint32_t nonce, void* out) const {
+	blake2b_state state = prefix;
+	uint8_t nonceBytes[sizeof(uint32_t)];
+	store32(nonceBytes, nonce);
+	blake2b_update(&state, nonceBytes, sizeof(nonceBytes));
+	const size_t suffixOffset = nonceOffset + sizeof(uint32_t);
+	blake2b_update(&state, input + suffixOffset, inputSize - suffixOffset);
+	blake2b_final(&state, out, BLAKE2B_OUTBYTES);
+}
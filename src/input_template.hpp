@@ -0,0 +1,62 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "blake2/blake2.h"
+
+/* Global scope for C binding */
+class randomx_input_template {
+public:
+	//references the input, which must stay valid while the template is used
+	randomx_input_template(const void* input, size_t size, size_t nonceOffset);
+	//keeps a copy of the input
+	randomx_input_template(std::vector<uint8_t>&& input, size_t nonceOffset);
+	//calculates the 64-byte Blake2b hash of the input with the nonce patched in,
+	//starting from the state after the bytes before the nonce field
+	void seed(uint32_t nonce, void* out) const;
+	const uint8_t* data() const {
+		return input;
+	}
+	size_t size() const {
+		return inputSize;
+	}
+	size_t getNonceOffset() const {
+		return nonceOffset;
+	}
+private:
+	void absorbPrefix();
+	std::vector<uint8_t> storage;
+	const uint8_t* input;
+	size_t inputSize;
+	size_t nonceOffset;
+	blake2b_state prefix;
+};
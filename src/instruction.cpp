@@ -320,6 +320,40 @@ namespace randomx {
 #include "instruction_weights.hpp"
 #define INST_NAME(x) REPN(#x, WT(x))
 #define INST_HANDLE(x) REPN(&Instruction::h_##x, WT(x))
+#define INST_TYPE(x) REPN(InstructionType::x, WT(x))
+
+	const InstructionType Instruction::types[256] = {
+		INST_TYPE(IADD_RS)
+		INST_TYPE(IADD_M)
+		INST_TYPE(ISUB_R)
+		INST_TYPE(ISUB_M)
+		INST_TYPE(IMUL_R)
+		INST_TYPE(IMUL_M)
+		INST_TYPE(IMULH_R)
+		INST_TYPE(IMULH_M)
+		INST_TYPE(ISMULH_R)
+		INST_TYPE(ISMULH_M)
+		INST_TYPE(IMUL_RCP)
+		INST_TYPE(INEG_R)
+		INST_TYPE(IXOR_R)
+		INST_TYPE(IXOR_M)
+		INST_TYPE(IROR_R)
+		INST_TYPE(IROL_R)
+		INST_TYPE(ISWAP_R)
+		INST_TYPE(FSWAP_R)
+		INST_TYPE(FADD_R)
+		INST_TYPE(FADD_M)
+		INST_TYPE(FSUB_R)
+		INST_TYPE(FSUB_M)
+		INST_TYPE(FSCAL_R)
+		INST_TYPE(FMUL_R)
+		INST_TYPE(FDIV_M)
+		INST_TYPE(FSQRT_R)
+		INST_TYPE(CBRANCH)
+		INST_TYPE(CFROUND)
+		INST_TYPE(ISTORE)
+		INST_TYPE(NOP)
+	};
 
 	const char* Instruction::names[256] = {
 		INST_NAME(IADD_RS)
@@ -96,6 +96,10 @@ namespace randomx {
 		int getModCond() const {
 			return mod >> 4; //bits 4-7
 		}
+		//decoded with a table built from the instruction frequencies
+		InstructionType getType() const {
+			return types[opcode];
+		}
 		void setMod(uint8_t val) {
 			mod = val;
 		}
@@ -107,6 +111,7 @@ namespace randomx {
 		uint32_t imm32;
 	private:
 		void print(std::ostream&) const;
+		static const InstructionType types[256];
 		static const char* names[256];
 		static InstructionFormatter engine[256];
 		void genAddressReg(std::ostream& os, int) const;
@@ -131,7 +131,57 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 	#define HAVE_SMULH
 #endif
 
-#ifdef RANDOMX_DEFAULT_FENV
+#if defined(RANDOMX_DEFAULT_FENV) && defined(__aarch64__) && defined(__GNUC__)
+
+//the rounding mode is kept in FPCR.RMode (bits 22-23), which is accessed directly rather
+//than through fesetround; the write is skipped if the mode doesn't change
+constexpr int fpcrRoundingShift = 22;
+static const uint64_t fpcrRoundingMode[4] = { 0 /* RN */, 2 /* RM */, 1 /* RP */, 3 /* RZ */ };
+static const uint32_t fpcrToRoundingMode[4] = { RoundToNearest, RoundUp, RoundDown, RoundToZero };
+
+void rx_set_rounding_mode(uint32_t mode) {
+	const uint64_t fpcr = rx_read_fpcr();
+	const uint64_t newFpcr = (fpcr & ~(3ULL << fpcrRoundingShift)) | (fpcrRoundingMode[mode & 3] << fpcrRoundingShift);
+	if (newFpcr != fpcr)
+		rx_write_fpcr(newFpcr);
+}
+
+void rx_reset_float_state() {
+	rx_set_rounding_mode(RoundToNearest);
+}
+
+uint32_t rx_get_rounding_mode() {
+	return fpcrToRoundingMode[(rx_read_fpcr() >> fpcrRoundingShift) & 3];
+}
+
+#elif defined(RANDOMX_DEFAULT_FENV) && defined(__riscv) && defined(__riscv_flen) && defined(__GNUC__)
+
+//the rounding mode is kept in the frm CSR, which is accessed directly rather than
+//through fesetround; the write is skipped if the mode doesn't change
+static const uint32_t frmRoundingMode[4] = { 0 /* RNE */, 2 /* RDN */, 3 /* RUP */, 1 /* RTZ */ };
+static const uint32_t frmToRoundingMode[4] = { RoundToNearest, RoundToZero, RoundDown, RoundUp };
+
+static uint32_t readFrm() {
+	uint32_t frm;
+	__asm__ volatile("frrm %0" : "=r"(frm));
+	return frm;
+}
+
+void rx_set_rounding_mode(uint32_t mode) {
+	const uint32_t frm = frmRoundingMode[mode & 3];
+	if (readFrm() != frm)
+		__asm__ volatile("fsrm %0" : : "r"(frm));
+}
+
+void rx_reset_float_state() {
+	rx_set_rounding_mode(RoundToNearest);
+}
+
+uint32_t rx_get_rounding_mode() {
+	return frmToRoundingMode[readFrm() & 3];
+}
+
+#elif defined(RANDOMX_DEFAULT_FENV)
 
 void rx_reset_float_state() {
 	setRoundMode_(FE_TONEAREST);
@@ -174,6 +224,117 @@ uint32_t rx_get_rounding_mode() {
 
 #endif
 
+#ifdef RANDOMX_EMULATE_FENV
+
+thread_local uint32_t rx_emulated_rounding_mode = RoundToNearest;
+
+void rx_reset_float_state() {
+	rx_emulated_rounding_mode = RoundToNearest;
+}
+
+void rx_set_rounding_mode(uint32_t mode) {
+	rx_emulated_rounding_mode = mode & 3;
+}
+
+uint32_t rx_get_rounding_mode() {
+	return rx_emulated_rounding_mode;
+}
+
+#endif
+
+//The result rounded to nearest is at most half an ulp away from the exact
+//result, so the directed result is either the same value or its neighbor.
+//The error terms below come from error-free transformations and are exact
+//unless the computation overflows or the result is subnormal.
+static double roundDirected(double x, double err, uint32_t mode) {
+	if (!(err < 0 || err > 0) || std::isinf(x)) //exact, overflow or NaN
+		return x;
+	switch (mode & 3) {
+	case RoundDown:
+		return err < 0 ? std::nextafter(x, -HUGE_VAL) : x;
+	case RoundUp:
+		return err > 0 ? std::nextafter(x, HUGE_VAL) : x;
+	case RoundToZero:
+		return (x > 0) != (err > 0) ? std::nextafter(x, 0.0) : x;
+	default:
+		return x;
+	}
+}
+
+static double roundOverflow(double x, uint32_t mode) {
+	const double maxFinite = 1.7976931348623157e308;
+	switch (mode & 3) {
+	case RoundDown:
+		return x > 0 ? maxFinite : x;
+	case RoundUp:
+		return x < 0 ? -maxFinite : x;
+	case RoundToZero:
+		return x > 0 ? maxFinite : -maxFinite;
+	default:
+		return x;
+	}
+}
+
+//The error terms must be calculated exactly. With hardware FMA, they are fused explicitly.
+//Otherwise Dekker's product is used, which breaks if the compiler contracts its expressions
+//into fused operations, so this file is built with -ffp-contract=off (see CMakeLists.txt).
+#if defined(FP_FAST_FMA) || defined(__FP_FAST_FMA)
+//a * b - p
+static double productError(double a, double b, double p) {
+	return std::fma(a, b, -p);
+}
+
+//a - x * y
+static double productResidual(double a, double x, double y) {
+	return std::fma(-x, y, a);
+}
+#else
+static double productError(double a, double b, double p) {
+	const double splitter = 134217729.0; //2^27 + 1
+	double ca = splitter * a, cb = splitter * b;
+	double ah = ca - (ca - a), al = a - ah;
+	double bh = cb - (cb - b), bl = b - bh;
+	return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+static double productResidual(double a, double x, double y) {
+	double p = x * y;
+	return (a - p) - productError(x, y, p);
+}
+#endif
+
+double rx_add_rounded(double a, double b, uint32_t mode) {
+	double s = a + b;
+	if (std::isinf(s) && std::isfinite(a) && std::isfinite(b))
+		return roundOverflow(s, mode);
+	double bb = s - a;
+	return roundDirected(s, (a - (s - bb)) + (b - bb), mode);
+}
+
+double rx_sub_rounded(double a, double b, uint32_t mode) {
+	return rx_add_rounded(a, -b, mode);
+}
+
+double rx_mul_rounded(double a, double b, uint32_t mode) {
+	double p = a * b;
+	if (std::isinf(p) && std::isfinite(a) && std::isfinite(b))
+		return roundOverflow(p, mode);
+	return roundDirected(p, productError(a, b, p), mode);
+}
+
+double rx_div_rounded(double a, double b, uint32_t mode) {
+	double q = a / b;
+	if (std::isinf(q) && std::isfinite(a) && b != 0)
+		return roundOverflow(q, mode);
+	double rem = productResidual(a, q, b);
+	return roundDirected(q, b > 0 ? rem : -rem, mode);
+}
+
+double rx_sqrt_rounded(double a, uint32_t mode) {
+	double s = rx_sqrt(a);
+	return roundDirected(s, productResidual(a, s, s), mode);
+}
+
 #ifdef RANDOMX_USE_X87
 
 #if defined(_MSC_VER) && defined(_M_IX86)
@@ -48,6 +48,15 @@ constexpr int RoundDown = 1;
 constexpr int RoundUp = 2;
 constexpr int RoundToZero = 3;
 
+//Directed rounding computed with round-to-nearest arithmetic only, for targets
+//where the rounding mode cannot be changed (WebAssembly). Results are exact
+//for the normal range of values used by RandomX programs.
+double rx_add_rounded(double a, double b, uint32_t mode);
+double rx_sub_rounded(double a, double b, uint32_t mode);
+double rx_mul_rounded(double a, double b, uint32_t mode);
+double rx_div_rounded(double a, double b, uint32_t mode);
+double rx_sqrt_rounded(double a, uint32_t mode);
+
 //MSVC doesn't define __SSE2__, so we have to define it manually if SSE2 is available
 #if !defined(__SSE2__) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP == 2))
 #define __SSE2__ 1
@@ -517,6 +526,122 @@ FORCE_INLINE rx_vec_f128 rx_cvt_packed_int_vec_f128(const void* addr) {
 
 #define RANDOMX_DEFAULT_FENV
 
+#elif defined(__wasm_simd128__)
+
+#include <stdlib.h>
+#include <wasm_simd128.h>
+
+typedef v128_t rx_vec_i128;
+typedef v128_t rx_vec_f128;
+
+//WebAssembly always rounds to nearest, the other modes are emulated per lane
+extern thread_local uint32_t rx_emulated_rounding_mode;
+
+inline void* rx_aligned_alloc(size_t size, size_t align) {
+	void* p;
+	if (posix_memalign(&p, align, size) == 0)
+		return p;
+
+	return 0;
+};
+
+#define rx_aligned_free(a) free(a)
+#define rx_prefetch_nta(x)
+#define rx_prefetch_t0(x)
+
+FORCE_INLINE rx_vec_f128 rx_load_vec_f128(const double* pd) {
+	return wasm_v128_load(pd);
+}
+
+FORCE_INLINE void rx_store_vec_f128(double* mem_addr, rx_vec_f128 a) {
+	wasm_v128_store(mem_addr, a);
+}
+
+FORCE_INLINE rx_vec_f128 rx_swap_vec_f128(rx_vec_f128 a) {
+	return wasm_i64x2_shuffle(a, a, 1, 0);
+}
+
+#define RANDOMX_WASM_ROUNDED_OP(op, fn) \
+	if (rx_emulated_rounding_mode == RoundToNearest) \
+		return op(a, b); \
+	return wasm_f64x2_make( \
+		fn(wasm_f64x2_extract_lane(a, 0), wasm_f64x2_extract_lane(b, 0), rx_emulated_rounding_mode), \
+		fn(wasm_f64x2_extract_lane(a, 1), wasm_f64x2_extract_lane(b, 1), rx_emulated_rounding_mode))
+
+FORCE_INLINE rx_vec_f128 rx_add_vec_f128(rx_vec_f128 a, rx_vec_f128 b) {
+	RANDOMX_WASM_ROUNDED_OP(wasm_f64x2_add, rx_add_rounded);
+}
+
+FORCE_INLINE rx_vec_f128 rx_sub_vec_f128(rx_vec_f128 a, rx_vec_f128 b) {
+	RANDOMX_WASM_ROUNDED_OP(wasm_f64x2_sub, rx_sub_rounded);
+}
+
+FORCE_INLINE rx_vec_f128 rx_mul_vec_f128(rx_vec_f128 a, rx_vec_f128 b) {
+	RANDOMX_WASM_ROUNDED_OP(wasm_f64x2_mul, rx_mul_rounded);
+}
+
+FORCE_INLINE rx_vec_f128 rx_div_vec_f128(rx_vec_f128 a, rx_vec_f128 b) {
+	RANDOMX_WASM_ROUNDED_OP(wasm_f64x2_div, rx_div_rounded);
+}
+
+#undef RANDOMX_WASM_ROUNDED_OP
+
+FORCE_INLINE rx_vec_f128 rx_sqrt_vec_f128(rx_vec_f128 a) {
+	if (rx_emulated_rounding_mode == RoundToNearest)
+		return wasm_f64x2_sqrt(a);
+	return wasm_f64x2_make(
+		rx_sqrt_rounded(wasm_f64x2_extract_lane(a, 0), rx_emulated_rounding_mode),
+		rx_sqrt_rounded(wasm_f64x2_extract_lane(a, 1), rx_emulated_rounding_mode));
+}
+
+FORCE_INLINE rx_vec_f128 rx_set_vec_f128(uint64_t x1, uint64_t x0) {
+	return wasm_i64x2_make(x0, x1);
+}
+
+FORCE_INLINE rx_vec_f128 rx_set1_vec_f128(uint64_t x) {
+	return wasm_i64x2_splat(x);
+}
+
+#define rx_xor_vec_f128 wasm_v128_xor
+#define rx_and_vec_f128 wasm_v128_and
+#define rx_or_vec_f128 wasm_v128_or
+
+FORCE_INLINE int rx_vec_i128_x(rx_vec_i128 a) {
+	return wasm_i32x4_extract_lane(a, 0);
+}
+
+FORCE_INLINE int rx_vec_i128_y(rx_vec_i128 a) {
+	return wasm_i32x4_extract_lane(a, 1);
+}
+
+FORCE_INLINE int rx_vec_i128_z(rx_vec_i128 a) {
+	return wasm_i32x4_extract_lane(a, 2);
+}
+
+FORCE_INLINE int rx_vec_i128_w(rx_vec_i128 a) {
+	return wasm_i32x4_extract_lane(a, 3);
+}
+
+FORCE_INLINE rx_vec_i128 rx_set_int_vec_i128(int i3, int i2, int i1, int i0) {
+	return wasm_i32x4_make(i0, i1, i2, i3);
+}
+
+#define rx_xor_vec_i128 wasm_v128_xor
+
+FORCE_INLINE rx_vec_i128 rx_load_vec_i128(const rx_vec_i128* mem_addr) {
+	return wasm_v128_load(mem_addr);
+}
+
+FORCE_INLINE void rx_store_vec_i128(rx_vec_i128* mem_addr, rx_vec_i128 val) {
+	wasm_v128_store(mem_addr, val);
+}
+
+FORCE_INLINE rx_vec_f128 rx_cvt_packed_int_vec_f128(const void* addr) {
+	return wasm_f64x2_convert_low_i32x4(wasm_v128_load64_zero(addr));
+}
+
+#define RANDOMX_EMULATE_FENV
+
 #else //portable fallback
 
 #include <cstdint>
@@ -713,6 +838,60 @@ FORCE_INLINE rx_vec_f128 rx_cvt_packed_int_vec_f128(const void* addr) {
 	return x;
 }
 
+#if defined(__riscv) && __riscv_xlen == 64 && defined(__riscv_zkne) && defined(__riscv_zknd)
+
+//scalar crypto: each instruction calculates one 64-bit half of the round
+#define rx_aes64_op(op, rs1, rs2, rd) __asm__(op " %0, %1, %2" : "=r"(rd) : "r"(rs1), "r"(rs2))
+
+FORCE_INLINE rx_vec_i128 rx_aesenc_vec_i128(rx_vec_i128 v, rx_vec_i128 rkey) {
+	uint64_t lo, hi;
+	rx_aes64_op("aes64esm", v.u64[0], v.u64[1], lo);
+	rx_aes64_op("aes64esm", v.u64[1], v.u64[0], hi);
+	rx_vec_i128 c;
+	c.u64[0] = lo ^ rkey.u64[0];
+	c.u64[1] = hi ^ rkey.u64[1];
+	return c;
+}
+
+FORCE_INLINE rx_vec_i128 rx_aesdec_vec_i128(rx_vec_i128 v, rx_vec_i128 rkey) {
+	uint64_t lo, hi;
+	rx_aes64_op("aes64dsm", v.u64[0], v.u64[1], lo);
+	rx_aes64_op("aes64dsm", v.u64[1], v.u64[0], hi);
+	rx_vec_i128 c;
+	c.u64[0] = lo ^ rkey.u64[0];
+	c.u64[1] = hi ^ rkey.u64[1];
+	return c;
+}
+
+#define HAVE_AES 1
+
+#elif defined(__riscv) && __riscv_xlen == 64 && defined(__riscv_zvkned)
+
+#include <riscv_vector.h>
+
+//vector crypto operates on 128-bit element groups of four 32-bit elements
+FORCE_INLINE rx_vec_i128 rx_aesenc_vec_i128(rx_vec_i128 v, rx_vec_i128 rkey) {
+	vuint32m1_t state = __riscv_vle32_v_u32m1(v.u32, 4);
+	vuint32m1_t key = __riscv_vle32_v_u32m1(rkey.u32, 4);
+	state = __riscv_vaesem_vv_u32m1(state, key, 4);
+	rx_vec_i128 c;
+	__riscv_vse32_v_u32m1(c.u32, state, 4);
+	return c;
+}
+
+FORCE_INLINE rx_vec_i128 rx_aesdec_vec_i128(rx_vec_i128 v, rx_vec_i128 rkey) {
+	//vaesdm adds the round key before InvMixColumns, so the key is applied separately
+	vuint32m1_t state = __riscv_vle32_v_u32m1(v.u32, 4);
+	state = __riscv_vaesdm_vv_u32m1(state, __riscv_vmv_v_x_u32m1(0, 4), 4);
+	rx_vec_i128 c;
+	__riscv_vse32_v_u32m1(c.u32, state, 4);
+	return rx_xor_vec_i128(c, rkey);
+}
+
+#define HAVE_AES 1
+
+#endif
+
 #define RANDOMX_DEFAULT_FENV
 
 #endif
@@ -734,7 +913,7 @@ FORCE_INLINE rx_vec_i128 rx_aesdec_vec_i128(rx_vec_i128 v, rx_vec_i128 rkey) {
 
 #endif
 
-#ifdef RANDOMX_DEFAULT_FENV
+#if defined(RANDOMX_DEFAULT_FENV) || defined(RANDOMX_EMULATE_FENV)
 
 void rx_reset_float_state();
 
@@ -744,6 +923,77 @@ uint32_t rx_get_rounding_mode();
 
 #endif
 
+//floating point state of the calling thread, saved and restored around hash calculations
+#if defined(__SSE__) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP > 0))
+
+#include <xmmintrin.h>
+
+typedef unsigned int rx_float_state;
+
+FORCE_INLINE rx_float_state rx_save_float_state() {
+	return _mm_getcsr();
+}
+
+FORCE_INLINE void rx_restore_float_state(rx_float_state state) {
+	_mm_setcsr(state);
+}
+
+#elif defined(__aarch64__) && defined(__GNUC__)
+
+typedef uint64_t rx_float_state;
+
+FORCE_INLINE uint64_t rx_read_fpcr() {
+	uint64_t fpcr;
+	__asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+	return fpcr;
+}
+
+//writing FPCR is much slower than reading it, so callers skip writes that don't change it
+FORCE_INLINE void rx_write_fpcr(uint64_t fpcr) {
+	__asm__ volatile("msr fpcr, %0" : : "r"(fpcr));
+}
+
+FORCE_INLINE rx_float_state rx_save_float_state() {
+	return rx_read_fpcr();
+}
+
+FORCE_INLINE void rx_restore_float_state(rx_float_state state) {
+	if (rx_read_fpcr() != state)
+		rx_write_fpcr(state);
+}
+
+#elif defined(__riscv) && defined(__riscv_flen) && defined(__GNUC__)
+
+typedef uint32_t rx_float_state;
+
+FORCE_INLINE rx_float_state rx_save_float_state() {
+	uint32_t fcsr;
+	__asm__ volatile("frcsr %0" : "=r"(fcsr));
+	return fcsr;
+}
+
+FORCE_INLINE void rx_restore_float_state(rx_float_state state) {
+	__asm__ volatile("fscsr %0" : : "r"(state));
+}
+
+#else
+
+#include <cfenv>
+
+typedef fenv_t rx_float_state;
+
+FORCE_INLINE rx_float_state rx_save_float_state() {
+	fenv_t state;
+	fegetenv(&state);
+	return state;
+}
+
+FORCE_INLINE void rx_restore_float_state(const rx_float_state& state) {
+	fesetenv(&state);
+}
+
+#endif
+
 double loadDoublePortable(const void* addr);
 uint64_t mulh(uint64_t, uint64_t);
 int64_t smulh(int64_t, int64_t);
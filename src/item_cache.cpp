@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include "item_cache.hpp"
+#include "allocator.hpp"
+#include "common.hpp"
+
+namespace randomx {
+
+	constexpr size_t ItemWords = CacheLineSize / sizeof(uint64_t);
+
+	SharedItemCache::SharedItemCache(size_t size) : generation(0) {
+		const size_t setSize = Ways * (CacheLineSize + sizeof(Slot));
+		setCount = 1;
+		while (setCount < (1U << 31) && 2 * (uint64_t)setCount * setSize <= size)
+			setCount *= 2;
+		const size_t slotCount = (size_t)setCount * Ways;
+		memorySize = slotCount * (CacheLineSize + sizeof(Slot));
+		memory = (uint8_t*)AlignedAllocator<CacheLineSize>::allocMemory(memorySize);
+		items = (std::atomic<uint64_t>*)memory;
+		slots = (Slot*)(memory + slotCount * CacheLineSize);
+		for (size_t i = 0; i < slotCount * ItemWords; ++i) {
+			new (&items[i]) std::atomic<uint64_t>(0);
+		}
+		for (size_t i = 0; i < slotCount; ++i) {
+			new (&slots[i].sequence) std::atomic<uint64_t>(0);
+			new (&slots[i].tag) std::atomic<uint64_t>(0);
+		}
+	}
+
+	SharedItemCache::~SharedItemCache() {
+		AlignedAllocator<CacheLineSize>::freeMemory(memory, memorySize);
+	}
+
+	bool SharedItemCache::lookup(uint32_t itemNumber, uint8_t* out) const {
+		const uint64_t tag = makeTag(itemNumber);
+		const size_t first = (size_t)(itemNumber & (setCount - 1)) * Ways;
+		uint64_t* words = (uint64_t*)out;
+		for (size_t slot = first; slot < first + Ways; ++slot) {
+			uint64_t sequence = slots[slot].sequence.load(std::memory_order_acquire);
+			if ((sequence & 1) != 0 || slots[slot].tag.load(std::memory_order_relaxed) != tag)
+				continue;
+			const std::atomic<uint64_t>* item = items + slot * ItemWords;
+			for (size_t q = 0; q < ItemWords; ++q) {
+				words[q] = item[q].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			//the copy is valid only if no writer has touched the slot meanwhile
+			if (slots[slot].sequence.load(std::memory_order_relaxed) == sequence)
+				return true;
+		}
+		return false;
+	}
+
+	void SharedItemCache::insert(uint32_t itemNumber, const uint8_t* item) {
+		const uint64_t tag = makeTag(itemNumber);
+		const size_t first = (size_t)(itemNumber & (setCount - 1)) * Ways;
+		//prefer an empty slot or a slot of an old generation, otherwise replace a slot picked by the item number
+		size_t victim = first + ((itemNumber / setCount) & (Ways - 1));
+		for (size_t slot = first; slot < first + Ways; ++slot) {
+			uint64_t slotTag = slots[slot].tag.load(std::memory_order_relaxed);
+			if (slotTag == 0 || (slotTag >> 32) != (tag >> 32)) {
+				victim = slot;
+				break;
+			}
+		}
+		Slot& slot = slots[victim];
+		uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		if ((sequence & 1) != 0 || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+			return; //another thread is writing the slot
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.tag.store(tag, std::memory_order_relaxed);
+		std::atomic<uint64_t>* words = items + victim * ItemWords;
+		for (size_t q = 0; q < ItemWords; ++q) {
+			words[q].store(((const uint64_t*)item)[q], std::memory_order_relaxed);
+		}
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace randomx {
+
+	//Dataset items shared by the light-mode virtual machines of one cache.
+	//The table is set-associative and each slot is guarded by a sequence number that is odd
+	//while the slot is being written, so lookups and inserts never wait for each other.
+	//The tags include a generation that is changed when the cache is initialized with a new key.
+	class SharedItemCache {
+	public:
+		static constexpr unsigned Ways = 4;
+		SharedItemCache(size_t size);
+		~SharedItemCache();
+		bool lookup(uint32_t itemNumber, uint8_t* out) const;
+		void insert(uint32_t itemNumber, const uint8_t* item);
+		void invalidate() {
+			generation.fetch_add(1, std::memory_order_relaxed);
+		}
+		size_t getSize() const {
+			return memorySize;
+		}
+	private:
+		struct Slot {
+			std::atomic<uint64_t> sequence;
+			std::atomic<uint64_t> tag; //generation and item number + 1, 0 if the slot is empty
+		};
+		uint64_t makeTag(uint32_t itemNumber) const {
+			return ((uint64_t)generation.load(std::memory_order_relaxed) << 32) | (itemNumber + 1ULL);
+		}
+		uint32_t setCount; //power of 2
+		size_t memorySize;
+		uint8_t* memory;
+		Slot* slots;
+		std::atomic<uint64_t>* items;
+		std::atomic<uint32_t> generation;
+	};
+
+}
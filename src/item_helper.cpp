@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include "item_helper.hpp"
+#include "dataset.hpp"
+#include "thread_affinity.hpp"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace randomx {
+
+	//number of polls before the helper waits for the next post (between hashes)
+	constexpr unsigned HelperSpinCount = 16384;
+
+	static inline void cpuRelax() {
+#if defined(__SSE2__) || defined(_M_X64)
+		_mm_pause();
+#elif defined(__aarch64__)
+		asm volatile("yield");
+#endif
+	}
+
+	ItemHelper::ItemHelper(int cpu) : stopping(false), sleeping(false) {
+		for (auto& slot : slots) {
+			slot.state.store(Idle, std::memory_order_relaxed);
+		}
+		thread = std::thread(&ItemHelper::work, this, cpu);
+	}
+
+	ItemHelper::~ItemHelper() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeup.notify_one();
+		thread.join();
+	}
+
+	void ItemHelper::post(randomx_cache* cache, uint32_t itemNumber) {
+		//the other slot holds the item read in this iteration
+		unsigned next = latest ^ 1;
+		Slot& slot = slots[next];
+		if (slot.state.load(std::memory_order_acquire) != Idle)
+			return;
+		slot.itemNumber = itemNumber;
+		slot.order.store(++postCount, std::memory_order_relaxed);
+		slot.cache = cache;
+		slot.state.store(Posted);
+		latest = next;
+		if (sleeping.load()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			wakeup.notify_one();
+		}
+	}
+
+	void ItemHelper::read(randomx_cache* cache, uint8_t* out, uint32_t itemNumber) {
+		for (auto& slot : slots) {
+			uint32_t state = slot.state.load(std::memory_order_acquire);
+			if (state == Idle || slot.itemNumber != itemNumber)
+				continue;
+			for (;;) {
+				if (state == Done) {
+					memcpy(out, slot.item, CacheLineSize);
+					slot.state.store(Idle, std::memory_order_release);
+					return;
+				}
+				if (state == Posted && slot.state.compare_exchange_strong(state, Idle, std::memory_order_acquire)) {
+					break; //not started yet, faster to compute it here
+				}
+				cpuRelax();
+				state = slot.state.load(std::memory_order_acquire);
+			}
+			break;
+		}
+		readDatasetItem(cache, out, itemNumber);
+	}
+
+	void ItemHelper::drain() {
+		for (auto& slot : slots) {
+			uint32_t state = slot.state.load(std::memory_order_acquire);
+			while (state != Idle) {
+				if (state == Done) {
+					slot.state.store(Idle, std::memory_order_relaxed);
+					break;
+				}
+				if (state == Posted && slot.state.compare_exchange_strong(state, Idle, std::memory_order_acquire)) {
+					break;
+				}
+				cpuRelax();
+				state = slot.state.load(std::memory_order_acquire);
+			}
+		}
+	}
+
+	void ItemHelper::work(int cpu) {
+		if (cpu >= 0) {
+			setThreadAffinity(cpu);
+		}
+		unsigned polls = 0;
+		while (!stopping.load(std::memory_order_relaxed)) {
+			//take the oldest posted item
+			Slot* slot = nullptr;
+			for (auto& s : slots) {
+				if (s.state.load(std::memory_order_acquire) == Posted && (slot == nullptr || s.order.load(std::memory_order_relaxed) < slot->order.load(std::memory_order_relaxed)))
+					slot = &s;
+			}
+			uint32_t expected = Posted;
+			if (slot != nullptr && slot->state.compare_exchange_strong(expected, Busy, std::memory_order_acquire)) {
+				readDatasetItem(slot->cache, slot->item, slot->itemNumber);
+				slot->state.store(Done, std::memory_order_release);
+				polls = 0;
+				continue;
+			}
+			if (++polls < HelperSpinCount) {
+				cpuRelax();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			sleeping = true;
+			wakeup.wait(lock, [this] { return stopping || hasPosted(); });
+			sleeping = false;
+			polls = 0;
+		}
+	}
+}
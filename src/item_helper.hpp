@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <new>
+#include "common.hpp"
+#include "allocator.hpp"
+
+namespace randomx {
+
+	//A thread that computes dataset items for a light-mode virtual machine one iteration ahead.
+	//The virtual machine posts the item it will read in the next iteration and takes it over
+	//when it's read, so the superscalar hash runs in parallel with the program (ideally on the
+	//SMT sibling of the virtual machine's thread). Each of the 2 slots has a single producer
+	//and consumer; a posted item that the helper hasn't started yet is computed by the reader.
+	class ItemHelper {
+	public:
+		void* operator new(size_t size) {
+			void* ptr = AlignedAllocator<CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(ItemHelper));
+		}
+		ItemHelper(int cpu);
+		~ItemHelper();
+		void post(randomx_cache* cache, uint32_t itemNumber);
+		void read(randomx_cache* cache, uint8_t* out, uint32_t itemNumber);
+		void drain();
+	private:
+		enum SlotState : uint32_t {
+			Idle,
+			Posted,
+			Busy,
+			Done
+		};
+		struct alignas(CacheLineSize) Slot {
+			uint8_t item[CacheLineSize];
+			std::atomic<uint32_t> state;
+			uint32_t itemNumber;
+			std::atomic<uint64_t> order;
+			randomx_cache* cache;
+		};
+		bool hasPosted() const {
+			return slots[0].state.load() == Posted || slots[1].state.load() == Posted;
+		}
+		void work(int cpu);
+		Slot slots[2];
+		unsigned latest = 0;
+		uint64_t postCount = 0;
+		std::atomic<bool> stopping;
+		std::atomic<bool> sleeping;
+		std::mutex mutex;
+		std::condition_variable wakeup;
+		std::thread thread;
+	};
+
+}
@@ -66,6 +66,7 @@ namespace randomx {
 
 #if defined(RANDOMX_COMPILER_X86)
 #include "jit_compiler_x86.hpp"
+#include "jit_compiler_x86_avx512.hpp"
 #elif defined(RANDOMX_COMPILER_A64)
 #include "jit_compiler_a64.hpp"
 #elif defined(RANDOMX_COMPILER_RV64)
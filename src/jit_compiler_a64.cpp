@@ -32,10 +32,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "program.hpp"
 #include "reciprocal.h"
 #include "virtual_memory.h"
+#include "allocator.hpp"
+#include "program_scheduler.hpp"
+#ifdef __APPLE__
+#include <libkern/OSCacheControl.h>
+#endif
 
 namespace ARMV8A {
 
 constexpr uint32_t B           = 0x14000000;
+constexpr uint32_t BL          = 0x94000000;
 constexpr uint32_t EOR         = 0xCA000000;
 constexpr uint32_t EOR32       = 0x4A000000;
 constexpr uint32_t ADD         = 0x8B000000;
@@ -68,6 +74,18 @@ static const size_t CodeSize = ((uint8_t*)randomx_init_dataset_aarch64_end) - ((
 static const size_t MainLoopBegin = ((uint8_t*)randomx_program_aarch64_main_loop) - ((uint8_t*)randomx_program_aarch64);
 static const size_t PrologueSize = ((uint8_t*)randomx_program_aarch64_vm_instructions) - ((uint8_t*)randomx_program_aarch64);
 static const size_t ImulRcpLiteralsEnd = ((uint8_t*)randomx_program_aarch64_imul_rcp_literals_end) - ((uint8_t*)randomx_program_aarch64);
+static const size_t PairCallPos = ((uint8_t*)randomx_init_dataset_aarch64_pair_call) - ((uint8_t*)randomx_program_aarch64);
+static const size_t UpdateSpMix1Pos = ((uint8_t*)randomx_program_aarch64_update_spMix1) - ((uint8_t*)randomx_program_aarch64);
+static const size_t LightDatasetOffsetPos = ((uint8_t*)randomx_program_aarch64_light_dataset_offset) - ((uint8_t*)randomx_program_aarch64);
+
+static void flushInstructionCache(uint8_t* begin, uint8_t* end)
+{
+#if defined(__APPLE__)
+	sys_icache_invalidate(begin, end - begin);
+#elif defined(__GNUC__)
+	__builtin___clear_cache(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end));
+#endif
+}
 
 static const size_t CalcDatasetItemSize =
 	// Prologue
@@ -84,65 +102,106 @@ static const size_t CalcDatasetItemSize =
 	// Epilogue
 	((uint8_t*)randomx_calc_dataset_item_aarch64_end - (uint8_t*)randomx_calc_dataset_item_aarch64_store_result);
 
+static const size_t CalcDatasetItem2Size =
+	// Prologue
+	((uint8_t*)randomx_calc_dataset_item2_aarch64_prefetch - (uint8_t*)randomx_calc_dataset_item2_aarch64) +
+	// Main loop
+	RANDOMX_CACHE_ACCESSES * (
+		// Main loop prologue
+		((uint8_t*)randomx_calc_dataset_item2_aarch64_mix - ((uint8_t*)randomx_calc_dataset_item2_aarch64_prefetch)) + 4 +
+		// Inner main loop (instructions of both items)
+		((RANDOMX_SUPERSCALAR_LATENCY * 3) + 2) * 32 +
+		// Main loop epilogue
+		((uint8_t*)randomx_calc_dataset_item2_aarch64_store_result - (uint8_t*)randomx_calc_dataset_item2_aarch64_mix) + 8
+	) +
+	// Epilogue
+	((uint8_t*)randomx_calc_dataset_item2_aarch64_end - (uint8_t*)randomx_calc_dataset_item2_aarch64_store_result);
+
+static const size_t SuperscalarSize = CalcDatasetItemSize + CalcDatasetItem2Size;
+
 constexpr uint32_t IntRegMap[8] = { 4, 5, 6, 7, 12, 13, 14, 15 };
 
 template<typename T> static constexpr size_t Log2(T value) { return (value > 1) ? (Log2(value / 2) + 1) : 0; }
 
 JitCompilerA64::JitCompilerA64()
-	: code((uint8_t*) allocMemoryPages(CodeSize + CalcDatasetItemSize))
+	: code((uint8_t*) allocCodeMemory(CodeSize + SuperscalarSize))
 	, literalPos(ImulRcpLiteralsEnd)
 	, num32bitLiterals(0)
+	, programEnd(PrologueSize)
+	, lightProgram(false)
+	, scheduling(false)
 {
 	if (code == nullptr)
-		throw std::runtime_error("allocMemoryPages");
+		throw std::runtime_error("allocCodeMemory");
 	memset(reg_changed_offset, 0, sizeof(reg_changed_offset));
 	memcpy(code, (void*) randomx_program_aarch64, CodeSize);
 
-#ifdef __GNUC__
-	__builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code + CodeSize));
-#endif
+	// The masks depend only on the build parameters, so they are patched once here
+	// and the prologue and epilogue are never rewritten by generateProgram
+	uint32_t codePos = MainLoopBegin + 4;
+
+	// and w16, w10, ScratchpadL3Mask64
+	emit32(0x121A0000 | 16 | (10 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
+
+	// and w17, w20, ScratchpadL3Mask64
+	emit32(0x121A0000 | 17 | (20 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
+
+	// and w20, w20, CacheLineAlignMask
+	codePos = (((uint8_t*)randomx_program_aarch64_cacheline_align_mask1) - ((uint8_t*)randomx_program_aarch64));
+	emit32(0x121A0000 | 20 | (20 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
+
+	// and w10, w10, CacheLineAlignMask
+	codePos = (((uint8_t*)randomx_program_aarch64_cacheline_align_mask2) - ((uint8_t*)randomx_program_aarch64));
+	emit32(0x121A0000 | 10 | (10 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
+
+	// and w2, w9, CacheLineAlignMask
+	codePos = (((uint8_t*)randomx_program_aarch64_light_cacheline_align_mask) - ((uint8_t*)randomx_program_aarch64));
+	emit32(0x121A0000 | 2 | (9 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
+
+	flushInstructionCache(code, code + CodeSize);
 }
 
 JitCompilerA64::~JitCompilerA64()
 {
-	freePagedMemory(code, CodeSize + CalcDatasetItemSize);
+	freeCodeMemory(code, CodeSize + SuperscalarSize);
 }
 
+//On macOS, MAP_JIT memory is switched between writable and executable per thread, which
+//avoids a page protection change on every program. The instruction cache does not need
+//to be flushed here because every generate function flushes the range it has written.
 void JitCompilerA64::enableWriting()
 {
-	setPagesRW(code, CodeSize + CalcDatasetItemSize);
+	if (!setJitWriteProtect(0))
+		setPagesRW(code, CodeSize + SuperscalarSize);
 }
 
 void JitCompilerA64::enableExecution()
 {
-	setPagesRX(code, CodeSize + CalcDatasetItemSize);
+	if (!setJitWriteProtect(1))
+		setPagesRX(code, CodeSize + SuperscalarSize);
 }
 
 void JitCompilerA64::enableAll()
 {
-	setPagesRWX(code, CodeSize + CalcDatasetItemSize);
+	setPagesRWX(code, CodeSize + SuperscalarSize);
 }
 
 void JitCompilerA64::generateProgram(Program& program, ProgramConfiguration& config)
 {
-	uint32_t codePos = MainLoopBegin + 4;
-
-	// and w16, w10, ScratchpadL3Mask64
-	emit32(0x121A0000 | 16 | (10 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
-
-	// and w17, w20, ScratchpadL3Mask64
-	emit32(0x121A0000 | 17 | (20 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
-
-	codePos = PrologueSize;
+	uint32_t codePos = PrologueSize;
 	literalPos = ImulRcpLiteralsEnd;
 	num32bitLiterals = 0;
 
 	for (uint32_t i = 0; i < RegistersCount; ++i)
 		reg_changed_offset[i] = codePos;
 
+	uint32_t order[RANDOMX_PROGRAM_SIZE];
+	if (scheduling)
+		scheduleProgram(program, order);
+
 	for (uint32_t i = 0; i < program.getSize(); ++i)
 	{
-		Instruction& instr = program(i);
+		Instruction& instr = program(scheduling ? order[i] : i);
 		instr.src %= RegistersCount;
 		instr.dst %= RegistersCount;
 		(this->*engine[instr.opcode])(instr, codePos);
@@ -155,45 +214,33 @@ void JitCompilerA64::generateProgram(Program& program, ProgramConfiguration& con
 	// Jump back to the main loop
 	const uint32_t offset = (((uint8_t*)randomx_program_aarch64_vm_instructions_end) - ((uint8_t*)randomx_program_aarch64)) - codePos;
 	emit32(ARMV8A::B | (offset / 4), code, codePos);
-
-	// and w20, w20, CacheLineAlignMask
-	codePos = (((uint8_t*)randomx_program_aarch64_cacheline_align_mask1) - ((uint8_t*)randomx_program_aarch64));
-	emit32(0x121A0000 | 20 | (20 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
-
-	// and w10, w10, CacheLineAlignMask
-	codePos = (((uint8_t*)randomx_program_aarch64_cacheline_align_mask2) - ((uint8_t*)randomx_program_aarch64));
-	emit32(0x121A0000 | 10 | (10 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
+	programEnd = codePos;
 
 	// Update spMix1
 	// eor x10, config.readReg0, config.readReg1
-	codePos = ((uint8_t*)randomx_program_aarch64_update_spMix1) - ((uint8_t*)randomx_program_aarch64);
+	codePos = UpdateSpMix1Pos;
 	emit32(ARMV8A::EOR | 10 | (IntRegMap[config.readReg0] << 5) | (IntRegMap[config.readReg1] << 16), code, codePos);
 
-#ifdef __GNUC__
-	__builtin___clear_cache(reinterpret_cast<char*>(code + MainLoopBegin), reinterpret_cast<char*>(code + codePos));
-#endif
+	lightProgram = false;
+	flushProgram();
 }
 
 void JitCompilerA64::generateProgramLight(Program& program, ProgramConfiguration& config, uint32_t datasetOffset)
 {
-	uint32_t codePos = MainLoopBegin + 4;
-
-	// and w16, w10, ScratchpadL3Mask64
-	emit32(0x121A0000 | 16 | (10 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
-
-	// and w17, w20, ScratchpadL3Mask64
-	emit32(0x121A0000 | 17 | (20 << 5) | ((Log2(RANDOMX_SCRATCHPAD_L3) - 7) << 10), code, codePos);
-
-	codePos = PrologueSize;
+	uint32_t codePos = PrologueSize;
 	literalPos = ImulRcpLiteralsEnd;
 	num32bitLiterals = 0;
 
 	for (uint32_t i = 0; i < RegistersCount; ++i)
 		reg_changed_offset[i] = codePos;
 
+	uint32_t order[RANDOMX_PROGRAM_SIZE];
+	if (scheduling)
+		scheduleProgram(program, order);
+
 	for (uint32_t i = 0; i < program.getSize(); ++i)
 	{
-		Instruction& instr = program(i);
+		Instruction& instr = program(scheduling ? order[i] : i);
 		instr.src %= RegistersCount;
 		instr.dst %= RegistersCount;
 		(this->*engine[instr.opcode])(instr, codePos);
@@ -206,18 +253,15 @@ void JitCompilerA64::generateProgramLight(Program& program, ProgramConfiguration
 	// Jump back to the main loop
 	const uint32_t offset = (((uint8_t*)randomx_program_aarch64_vm_instructions_end_light) - ((uint8_t*)randomx_program_aarch64)) - codePos;
 	emit32(ARMV8A::B | (offset / 4), code, codePos);
-
-	// and w2, w9, CacheLineAlignMask
-	codePos = (((uint8_t*)randomx_program_aarch64_light_cacheline_align_mask) - ((uint8_t*)randomx_program_aarch64));
-	emit32(0x121A0000 | 2 | (9 << 5) | ((Log2(RANDOMX_DATASET_BASE_SIZE) - 7) << 10), code, codePos);
+	programEnd = codePos;
 
 	// Update spMix1
 	// eor x10, config.readReg0, config.readReg1
-	codePos = ((uint8_t*)randomx_program_aarch64_update_spMix1) - ((uint8_t*)randomx_program_aarch64);
+	codePos = UpdateSpMix1Pos;
 	emit32(ARMV8A::EOR | 10 | (IntRegMap[config.readReg0] << 5) | (IntRegMap[config.readReg1] << 16), code, codePos);
 
 	// Apply dataset offset
-	codePos = ((uint8_t*)randomx_program_aarch64_light_dataset_offset) - ((uint8_t*)randomx_program_aarch64);
+	codePos = LightDatasetOffsetPos;
 
 	datasetOffset /= CacheLineSize;
 	const uint32_t imm_lo = datasetOffset & ((1 << 12) - 1);
@@ -226,9 +270,18 @@ void JitCompilerA64::generateProgramLight(Program& program, ProgramConfiguration
 	emit32(ARMV8A::ADD_IMM_LO | 2 | (2 << 5) | (imm_lo << 10), code, codePos);
 	emit32(ARMV8A::ADD_IMM_HI | 2 | (2 << 5) | (imm_hi << 10), code, codePos);
 
-#ifdef __GNUC__
-	__builtin___clear_cache(reinterpret_cast<char*>(code + MainLoopBegin), reinterpret_cast<char*>(code + codePos));
-#endif
+	lightProgram = true;
+	flushProgram();
+}
+
+void JitCompilerA64::flushProgram()
+{
+	// Only the program body and the instructions patched with the program configuration
+	// are rewritten, the literals are read as data and need no instruction cache flush
+	flushInstructionCache(code + PrologueSize, code + programEnd);
+	flushInstructionCache(code + UpdateSpMix1Pos, code + UpdateSpMix1Pos + 4);
+	if (lightProgram)
+		flushInstructionCache(code + LightDatasetOffsetPos, code + LightDatasetOffsetPos + 8);
 }
 
 template<size_t N>
@@ -242,7 +295,6 @@ void JitCompilerA64::generateSuperscalarHash(SuperscalarProgram(&programs)[N], s
 	codePos += p2 - p1;
 
 	num32bitLiterals = 64;
-	constexpr uint32_t tmp_reg = 12;
 
 	for (size_t i = 0; i < N; ++i)
 	{
@@ -257,100 +309,171 @@ void JitCompilerA64::generateSuperscalarHash(SuperscalarProgram(&programs)[N], s
 		SuperscalarProgram& prog = programs[i];
 		const size_t progSize = prog.getSize();
 
-		uint32_t jmp_pos = codePos;
-		codePos += 4;
+		uint32_t literal_pos = emitSuperscalarLiterals(prog, reciprocalCache, codePos);
 
-		// Fill in literal pool
 		for (size_t j = 0; j < progSize; ++j)
 		{
 			const Instruction& instr = prog(j);
+			emitSuperscalarInstruction(instr, 0, literal_pos, code, codePos);
 			if (static_cast<SuperscalarInstructionType>(instr.opcode) == randomx::SuperscalarInstructionType::IMUL_RCP)
-				emit64(reciprocalCache[instr.getImm32()], code, codePos);
+				literal_pos += 8;
 		}
 
-		// Jump over literal pool
-		uint32_t literal_pos = jmp_pos;
-		emit32(ARMV8A::B | ((codePos - jmp_pos) / 4), code, literal_pos);
+		p1 = (uint8_t*)randomx_calc_dataset_item_aarch64_mix;
+		p2 = (uint8_t*)randomx_calc_dataset_item_aarch64_store_result;
+		memcpy(code + codePos, p1, p2 - p1);
+		codePos += p2 - p1;
+
+		// Update registerValue
+		emit32(ARMV8A::MOV_REG | 10 | (prog.getAddressRegister() << 16), code, codePos);
+	}
+
+	p1 = (uint8_t*)randomx_calc_dataset_item_aarch64_store_result;
+	p2 = (uint8_t*)randomx_calc_dataset_item_aarch64_end;
+	memcpy(code + codePos, p1, p2 - p1);
+	codePos += p2 - p1;
+
+	// Dataset initialization calculates 2 items at once: the first item uses x0-x7, the second one x21-x28.
+	// Instructions of both items are interleaved to hide the latency of multiplications and mix block loads.
+	const uint32_t calcItem2Pos = codePos;
+	constexpr uint32_t regBase2 = 21;
+
+	p1 = (uint8_t*)randomx_calc_dataset_item2_aarch64;
+	p2 = (uint8_t*)randomx_calc_dataset_item2_aarch64_prefetch;
+	memcpy(code + codePos, p1, p2 - p1);
+	codePos += p2 - p1;
+
+	for (size_t i = 0; i < N; ++i)
+	{
+		uint32_t k = codePos;
+		p1 = (uint8_t*)randomx_calc_dataset_item2_aarch64_prefetch;
+		p2 = (uint8_t*)randomx_calc_dataset_item2_aarch64_mix;
+		memcpy(code + codePos, p1, p2 - p1);
+		codePos += p2 - p1;
+
+		// and x11, x10, CacheSize / CacheLineSize - 1
+		emit32(0x92400000 | 11 | (10 << 5) | ((Log2(CacheSize / CacheLineSize) - 1) << 10), code, k);
+		k += 8;
+
+		// and x15, x14, CacheSize / CacheLineSize - 1
+		emit32(0x92400000 | 15 | (14 << 5) | ((Log2(CacheSize / CacheLineSize) - 1) << 10), code, k);
+
+		SuperscalarProgram& prog = programs[i];
+		const size_t progSize = prog.getSize();
+
+		uint32_t literal_pos = emitSuperscalarLiterals(prog, reciprocalCache, codePos);
 
 		for (size_t j = 0; j < progSize; ++j)
 		{
 			const Instruction& instr = prog(j);
-			const uint32_t src = instr.src;
-			const uint32_t dst = instr.dst;
-
-			switch (static_cast<SuperscalarInstructionType>(instr.opcode))
-			{
-			case randomx::SuperscalarInstructionType::ISUB_R:
-				emit32(ARMV8A::SUB | dst | (dst << 5) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IXOR_R:
-				emit32(ARMV8A::EOR | dst | (dst << 5) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IADD_RS:
-				emit32(ARMV8A::ADD | dst | (dst << 5) | (instr.getModShift() << 10) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IMUL_R:
-				emit32(ARMV8A::MUL | dst | (dst << 5) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IROR_C:
-				emit32(ARMV8A::ROR_IMM | dst | (dst << 5) | ((instr.getImm32() & 63) << 10) | (dst << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IADD_C7:
-			case randomx::SuperscalarInstructionType::IADD_C8:
-			case randomx::SuperscalarInstructionType::IADD_C9:
-				emitAddImmediate(dst, dst, instr.getImm32(), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IXOR_C7:
-			case randomx::SuperscalarInstructionType::IXOR_C8:
-			case randomx::SuperscalarInstructionType::IXOR_C9:
-				emitMovImmediate(tmp_reg, instr.getImm32(), code, codePos);
-				emit32(ARMV8A::EOR | dst | (dst << 5) | (tmp_reg << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IMULH_R:
-				emit32(ARMV8A::UMULH | dst | (dst << 5) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::ISMULH_R:
-				emit32(ARMV8A::SMULH | dst | (dst << 5) | (src << 16), code, codePos);
-				break;
-			case randomx::SuperscalarInstructionType::IMUL_RCP:
-				{
-					int32_t offset = (literal_pos - codePos) / 4;
-					offset &= (1 << 19) - 1;
-					literal_pos += 8;
-
-					// ldr tmp_reg, reciprocal
-					emit32(ARMV8A::LDR_LITERAL | tmp_reg | (offset << 5), code, codePos);
-
-					// mul dst, dst, tmp_reg
-					emit32(ARMV8A::MUL | dst | (dst << 5) | (tmp_reg << 16), code, codePos);
-				}
-				break;
-			default:
-				break;
-			}
+			emitSuperscalarInstruction(instr, 0, literal_pos, code, codePos);
+			emitSuperscalarInstruction(instr, regBase2, literal_pos, code, codePos);
+			if (static_cast<SuperscalarInstructionType>(instr.opcode) == randomx::SuperscalarInstructionType::IMUL_RCP)
+				literal_pos += 8;
 		}
 
-		p1 = (uint8_t*)randomx_calc_dataset_item_aarch64_mix;
-		p2 = (uint8_t*)randomx_calc_dataset_item_aarch64_store_result;
+		p1 = (uint8_t*)randomx_calc_dataset_item2_aarch64_mix;
+		p2 = (uint8_t*)randomx_calc_dataset_item2_aarch64_store_result;
 		memcpy(code + codePos, p1, p2 - p1);
 		codePos += p2 - p1;
 
-		// Update registerValue
+		// Update registerValue of both items
 		emit32(ARMV8A::MOV_REG | 10 | (prog.getAddressRegister() << 16), code, codePos);
+		emit32(ARMV8A::MOV_REG | 14 | ((regBase2 + prog.getAddressRegister()) << 16), code, codePos);
 	}
 
-	p1 = (uint8_t*)randomx_calc_dataset_item_aarch64_store_result;
-	p2 = (uint8_t*)randomx_calc_dataset_item_aarch64_end;
+	p1 = (uint8_t*)randomx_calc_dataset_item2_aarch64_store_result;
+	p2 = (uint8_t*)randomx_calc_dataset_item2_aarch64_end;
 	memcpy(code + codePos, p1, p2 - p1);
 	codePos += p2 - p1;
 
-#ifdef __GNUC__
-	__builtin___clear_cache(reinterpret_cast<char*>(code + CodeSize), reinterpret_cast<char*>(code + codePos));
-#endif
+	// bl randomx_calc_dataset_item2_aarch64
+	uint32_t k = PairCallPos;
+	emit32(ARMV8A::BL | (((calcItem2Pos - PairCallPos) / 4) & ((1 << 26) - 1)), code, k);
+
+	flushInstructionCache(code + PairCallPos, code + PairCallPos + 4);
+	flushInstructionCache(code + CodeSize, code + codePos);
 }
 
 template void JitCompilerA64::generateSuperscalarHash(SuperscalarProgram(&programs)[RANDOMX_CACHE_ACCESSES], std::vector<uint64_t> &reciprocalCache);
 
+uint32_t JitCompilerA64::emitSuperscalarLiterals(SuperscalarProgram& prog, std::vector<uint64_t> &reciprocalCache, uint32_t& codePos)
+{
+	uint32_t jmp_pos = codePos;
+	codePos += 4;
+
+	// Fill in literal pool
+	for (size_t j = 0; j < prog.getSize(); ++j)
+	{
+		const Instruction& instr = prog(j);
+		if (static_cast<SuperscalarInstructionType>(instr.opcode) == randomx::SuperscalarInstructionType::IMUL_RCP)
+			emit64(reciprocalCache[instr.getImm32()], code, codePos);
+	}
+
+	// Jump over literal pool
+	uint32_t literal_pos = jmp_pos;
+	emit32(ARMV8A::B | ((codePos - jmp_pos) / 4), code, literal_pos);
+
+	return literal_pos;
+}
+
+void JitCompilerA64::emitSuperscalarInstruction(const Instruction& instr, uint32_t regBase, uint32_t literal_pos, uint8_t* code, uint32_t& codePos)
+{
+	constexpr uint32_t tmp_reg = 12;
+	const uint32_t src = regBase + instr.src;
+	const uint32_t dst = regBase + instr.dst;
+
+	switch (static_cast<SuperscalarInstructionType>(instr.opcode))
+	{
+	case randomx::SuperscalarInstructionType::ISUB_R:
+		emit32(ARMV8A::SUB | dst | (dst << 5) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IXOR_R:
+		emit32(ARMV8A::EOR | dst | (dst << 5) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IADD_RS:
+		emit32(ARMV8A::ADD | dst | (dst << 5) | (instr.getModShift() << 10) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IMUL_R:
+		emit32(ARMV8A::MUL | dst | (dst << 5) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IROR_C:
+		emit32(ARMV8A::ROR_IMM | dst | (dst << 5) | ((instr.getImm32() & 63) << 10) | (dst << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IADD_C7:
+	case randomx::SuperscalarInstructionType::IADD_C8:
+	case randomx::SuperscalarInstructionType::IADD_C9:
+		emitAddImmediate(dst, dst, instr.getImm32(), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IXOR_C7:
+	case randomx::SuperscalarInstructionType::IXOR_C8:
+	case randomx::SuperscalarInstructionType::IXOR_C9:
+		emitMovImmediate(tmp_reg, instr.getImm32(), code, codePos);
+		emit32(ARMV8A::EOR | dst | (dst << 5) | (tmp_reg << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IMULH_R:
+		emit32(ARMV8A::UMULH | dst | (dst << 5) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::ISMULH_R:
+		emit32(ARMV8A::SMULH | dst | (dst << 5) | (src << 16), code, codePos);
+		break;
+	case randomx::SuperscalarInstructionType::IMUL_RCP:
+		{
+			int32_t offset = (literal_pos - codePos) / 4;
+			offset &= (1 << 19) - 1;
+
+			// ldr tmp_reg, reciprocal
+			emit32(ARMV8A::LDR_LITERAL | tmp_reg | (offset << 5), code, codePos);
+
+			// mul dst, dst, tmp_reg
+			emit32(ARMV8A::MUL | dst | (dst << 5) | (tmp_reg << 16), code, codePos);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 DatasetInitFunc* JitCompilerA64::getDatasetInitFunc()
 {
 	return (DatasetInitFunc*)(code + (((uint8_t*)randomx_init_dataset_aarch64) - ((uint8_t*)randomx_program_aarch64)));
@@ -51,11 +51,13 @@ namespace randomx {
 
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void flushProgram();
 
 		template<size_t N>
 		void generateSuperscalarHash(SuperscalarProgram(&programs)[N], std::vector<uint64_t> &);
 
 		void generateDatasetInitCode() {}
+		bool useSuperscalarHash(const JitCompilerA64&) { return false; }
 
 		ProgramFunc* getProgramFunc() { return reinterpret_cast<ProgramFunc*>(code); }
 		DatasetInitFunc* getDatasetInitFunc();
@@ -65,6 +67,11 @@ namespace randomx {
 		void enableWriting();
 		void enableExecution();
 		void enableAll();
+		bool enableDualMapping() { return false; }
+		bool enableSharedCode(bool) { return false; }
+		void setPrefetchMode(bool, bool) {}
+		void setScheduling(bool enabled) { scheduling = enabled; }
+		void setBranchAlignment(bool) {}
 
 	private:
 		static InstructionGeneratorA64 engine[256];
@@ -72,6 +79,9 @@ namespace randomx {
 		uint8_t* code;
 		uint32_t literalPos;
 		uint32_t num32bitLiterals;
+		uint32_t programEnd;
+		bool lightProgram;
+		bool scheduling;
 
 		static void emit32(uint32_t val, uint8_t* code, uint32_t& codePos)
 		{
@@ -85,6 +95,9 @@ namespace randomx {
 			codePos += sizeof(val);
 		}
 
+		uint32_t emitSuperscalarLiterals(SuperscalarProgram& prog, std::vector<uint64_t> &reciprocalCache, uint32_t& codePos);
+		void emitSuperscalarInstruction(const Instruction& instr, uint32_t regBase, uint32_t literal_pos, uint8_t* code, uint32_t& codePos);
+
 		void emitMovImmediate(uint32_t dst, uint32_t imm, uint8_t* code, uint32_t& codePos);
 		void emitAddImmediate(uint32_t dst, uint32_t src, uint32_t imm, uint8_t* code, uint32_t& codePos);
 
@@ -42,10 +42,16 @@ extern "C" {
 	void randomx_program_aarch64_light_cacheline_align_mask();
 	void randomx_program_aarch64_light_dataset_offset();
 	void randomx_init_dataset_aarch64();
+	void randomx_init_dataset_aarch64_pair_call();
 	void randomx_init_dataset_aarch64_end();
 	void randomx_calc_dataset_item_aarch64();
 	void randomx_calc_dataset_item_aarch64_prefetch();
 	void randomx_calc_dataset_item_aarch64_mix();
 	void randomx_calc_dataset_item_aarch64_store_result();
 	void randomx_calc_dataset_item_aarch64_end();
+	void randomx_calc_dataset_item2_aarch64();
+	void randomx_calc_dataset_item2_aarch64_prefetch();
+	void randomx_calc_dataset_item2_aarch64_mix();
+	void randomx_calc_dataset_item2_aarch64_store_result();
+	void randomx_calc_dataset_item2_aarch64_end();
 }
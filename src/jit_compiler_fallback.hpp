@@ -56,6 +56,9 @@ namespace randomx {
 		}
 		void generateDatasetInitCode() {
 
+		}
+		bool useSuperscalarHash(const JitCompilerFallback&) {
+			return false;
 		}
 		ProgramFunc* getProgramFunc() {
 			return nullptr;
@@ -72,5 +75,11 @@ namespace randomx {
 		void enableWriting() {}
 		void enableExecution() {}
 		void enableAll() {}
+		bool enableDualMapping() { return false; }
+		bool enableSharedCode(bool) { return false; }
+		void setPrefetchMode(bool, bool) {}
+		void flushProgram() {}
+		void setScheduling(bool) {}
+		void setBranchAlignment(bool) {}
 	};
 }
\ No newline at end of file
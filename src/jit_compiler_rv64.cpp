@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "program.hpp"
 #include "reciprocal.h"
 #include "virtual_memory.h"
+#include "allocator.hpp"
 
 
 namespace {
@@ -283,9 +284,9 @@ namespace randomx {
 	static const int32_t LoopTopPos = LiteralPoolSize + sizeDataInit + sizePrologue;
 	static const int32_t RandomXCodePos = LoopTopPos + sizeLoopBegin;
 
-	static void clearCache(CodeBuffer& buf) {
+	static void clearCache(CodeBuffer& buf, int32_t begin, int32_t end) {
 #ifdef __GNUC__
-		__builtin___clear_cache((char*)buf.code, (char*)(buf.code + CodeSize));
+		__builtin___clear_cache((char*)(buf.code + begin), (char*)(buf.code + end));
 #endif
 	}
 
@@ -596,19 +597,22 @@ namespace randomx {
 	}
 
 	JitCompilerRV64::JitCompilerRV64() {
-		state.code = (uint8_t*)allocMemoryPages(CodeSize);
+		state.code = (uint8_t*)allocCodeMemory(CodeSize);
 		if (state.code == nullptr)
-			throw std::runtime_error("allocMemoryPages");
+			throw std::runtime_error("allocCodeMemory");
 		state.emitAt(LiteralPoolOffset, codeLiterals, sizeLiterals);
 		state.emitAt(LiteralPoolSize, codeDataInit, sizeDataInit + sizePrologue + sizeLoopBegin);
 		entryDataInit = state.code + LiteralPoolSize;
 		entryProgram = state.code + LiteralPoolSize + sizeDataInit;
 		//jal x1, SuperscalarHash
 		emitJump(state, ReturnReg, LiteralPoolSize + offsetFixDataCall, SuperScalarHashOffset);
+		//the prologue is never rewritten after this point
+		clearCache(state, LiteralPoolSize, RandomXCodePos);
+		programEnd = RandomXCodePos;
 	}
 
 	JitCompilerRV64::~JitCompilerRV64() {
-		freePagedMemory(state.code, CodeSize);
+		freeCodeMemory(state.code, CodeSize);
 	}
 
 	void JitCompilerRV64::enableAll() {
@@ -623,6 +627,12 @@ namespace randomx {
 		setPagesRX(entryDataInit, ExecutableSize);
 	}
 
+	void JitCompilerRV64::flushProgram() {
+		//the literal pool is only read as data, so the code emitted after the
+		//invariant prologue is the only range that needs to be flushed
+		clearCache(state, RandomXCodePos, programEnd);
+	}
+
 	void JitCompilerRV64::generateProgram(Program& prog, ProgramConfiguration& pcfg) {
 		emitProgramPrefix(state, prog, pcfg);
 		int32_t fixPos = state.codePos;
@@ -630,7 +640,8 @@ namespace randomx {
 		//xor x8, x{readReg2}, x{readReg3}
 		state.emitAt(fixPos, rvi(rv64::XOR, Tmp1Reg, regR(pcfg.readReg2), regR(pcfg.readReg3)));
 		emitProgramSuffix(state, pcfg);
-		clearCache(state);
+		programEnd = state.codePos;
+		flushProgram();
 	}
 
 	void JitCompilerRV64::generateProgramLight(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset) {
@@ -650,7 +661,8 @@ namespace randomx {
 		//jal x1, SuperscalarHash
 		emitJump(state, ReturnReg, fixPos, SuperScalarHashOffset);
 		emitProgramSuffix(state, pcfg);
-		clearCache(state);
+		programEnd = state.codePos;
+		flushProgram();
 	}
 
 	void JitCompilerRV64::generateSuperscalarHash(SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES], std::vector<uint64_t>& reciprocalCache) {
@@ -672,7 +684,7 @@ namespace randomx {
 			}
 		}
 		state.emit(rvc(rv64::C_RET, 0, 0));
-		clearCache(state);
+		clearCache(state, SuperScalarHashOffset, state.codePos);
 	}
 
 	static void v1_IADD_RS(HANDLER_ARGS) {
@@ -46,8 +46,12 @@ namespace randomx {
 		~JitCompilerRV64();
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void flushProgram();
 		void generateSuperscalarHash(SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES], std::vector<uint64_t>&);
 		void generateDatasetInitCode() {}
+		bool useSuperscalarHash(const JitCompilerRV64&) {
+			return false;
+		}
 		ProgramFunc* getProgramFunc() {
 			return (ProgramFunc*)entryProgram;
 		}
@@ -61,9 +65,22 @@ namespace randomx {
 		void enableWriting();
 		void enableExecution();
 		void enableAll();
+		bool enableDualMapping() {
+			return false;
+		}
+		bool enableSharedCode(bool) {
+			return false;
+		}
+		void setPrefetchMode(bool, bool) {
+		}
+		void setScheduling(bool) {
+		}
+		void setBranchAlignment(bool) {
+		}
 	private:
 		CompilerState state;
 		void* entryDataInit;
 		void* entryProgram;
+		int32_t programEnd;
 	};
 }
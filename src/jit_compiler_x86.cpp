@@ -29,12 +29,18 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdexcept>
 #include <cstring>
 #include <climits>
+#include <cstddef>
+#include <cassert>
 #include "jit_compiler_x86.hpp"
 #include "jit_compiler_x86_static.hpp"
+#include "jit_compiler_x86_avx512.hpp"
 #include "superscalar.hpp"
 #include "program.hpp"
 #include "reciprocal.h"
+#include "program_scheduler.hpp"
+#include "cpu.hpp"
 #include "virtual_memory.h"
+#include "allocator.hpp"
 
 namespace randomx {
 	/*
@@ -90,7 +96,25 @@ namespace randomx {
 	static_assert(RandomXCodeSize < INT32_MAX / 2, "RandomXCodeSize is too large");
 	static_assert(SuperscalarSize < INT32_MAX / 2, "SuperscalarSize is too large");
 
-	constexpr uint32_t CodeSize = RandomXCodeSize + SuperscalarSize;
+	//Interleaved programs keep the state of each lane in a stack frame while the other lanes execute:
+	constexpr int32_t LaneStateR = 0;            //r0-r7
+	constexpr int32_t LaneStateF = 64;           //f0-f3, e0-e3 (xmm0-xmm7)
+	constexpr int32_t LaneStateA = 192;          //a0-a3 (xmm8-xmm11)
+	constexpr int32_t LaneStateSpAddr = 256;     //spAddr0, spAddr1 (rax, rdx)
+	constexpr int32_t LaneStateMem = 272;        //ma, mx (rbp)
+	constexpr int32_t LaneStateScratchpad = 280; //rsi
+	constexpr int32_t LaneStateDataset = 288;    //rdi
+	constexpr int32_t LaneStateMxcsr = 296;
+	constexpr int32_t LaneStateSize = 304;       //must be a multiple of 16
+
+	constexpr size_t ReserveLaneCodeSize = 1024;      //lane switch + loop load/store
+	constexpr int32_t InterleavedConstSize = 128;     //mantissaMask, scaleMask, eMask of each lane
+	constexpr size_t InterleavedCodeSize = alignSize(ReserveCodeSize + (ReserveLaneCodeSize + MaxRandomXInstrCodeSize * RANDOMX_PROGRAM_SIZE) * MaxInterleavedLanes, CodeAlign);
+
+	static_assert(32 + 16 * MaxInterleavedLanes <= InterleavedConstSize, "InterleavedConstSize is too small");
+	static_assert(InterleavedCodeSize < INT32_MAX / 2, "InterleavedCodeSize is too large");
+
+	constexpr uint32_t CodeSize = RandomXCodeSize + SuperscalarSize > InterleavedCodeSize ? RandomXCodeSize + SuperscalarSize : InterleavedCodeSize;
 
 	constexpr int32_t superScalarHashOffset = RandomXCodeSize;
 
@@ -131,6 +155,10 @@ namespace randomx {
 
 	const int32_t epilogueOffset = CodeSize - epilogueSize;
 
+	//The program body is followed by a jump to the loop tail, which is generated once at a fixed offset
+	//past the largest possible body. ReserveCodeSize leaves enough space for the tail.
+	const int32_t programTailOffset = alignSize((prologueSize + loopLoadSize + MaxRandomXInstrCodeSize * RANDOMX_PROGRAM_SIZE + 5), 64);
+
 	static const uint8_t REX_ADD_RR[] = { 0x4d, 0x03 };
 	static const uint8_t REX_ADD_RM[] = { 0x4c, 0x03 };
 	static const uint8_t REX_SUB_RR[] = { 0x4d, 0x2b };
@@ -200,6 +228,7 @@ namespace randomx {
 	static const uint8_t REX_PADD[] = { 0x66, 0x44, 0x0f };
 	static const uint8_t PADD_OPCODES[] = { 0xfc, 0xfd, 0xfe, 0xd4 };
 	static const uint8_t CALL = 0xe8;
+	static const uint8_t CALL_M[] = { 0xff, 0x15 };
 	static const uint8_t REX_ADD_I[] = { 0x49, 0x81 };
 	static const uint8_t REX_TEST[] = { 0x49, 0xF7 };
 	static const uint8_t JZ[] = { 0x0f, 0x84 };
@@ -208,6 +237,24 @@ namespace randomx {
 	static const uint8_t MOVNTI[] = { 0x4c, 0x0f, 0xc3 };
 	static const uint8_t ADD_EBX_I[] = { 0x81, 0xc3 };
 
+	static const uint8_t PUSH_NONVOLATILE[] = { 0x53, 0x55, 0x57, 0x56, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 };
+	static const uint8_t POP_NONVOLATILE[] = { 0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5e, 0x5f, 0x5d, 0x5b };
+	static const uint8_t SUB_RSP_I[] = { 0x48, 0x81, 0xec };
+	static const uint8_t ADD_RSP_I[] = { 0x48, 0x81, 0xc4 };
+#if defined(_WIN32) || defined(__CYGWIN__)
+	static const uint8_t MOV_INTERLEAVED_ARGS[] = { 0x48, 0x89, 0xd3 };
+#else
+	static const uint8_t MOV_INTERLEAVED_ARGS[] = { 0x48, 0x89, 0xf3, 0x48, 0x89, 0xf9 };
+#endif
+	static const uint8_t MXCSR[] = { 0x0f, 0xae };
+	static const uint8_t MOV_R32_M[] = { 0x8b };
+	static const uint8_t MOV_M_R32[] = { 0x89 };
+	static const uint8_t XOR_R8_R8[] = { 0x4d, 0x31, 0xc0 };
+	static const uint8_t MOV_RAX_RBP_ROR_RBP[] = { 0x48, 0x89, 0xe8, 0x48, 0xc1, 0xcd, 0x20 };
+	static const uint8_t MOV_RDX_RAX_ROR_RDX[] = { 0x48, 0x89, 0xc2, 0x48, 0xc1, 0xca, 0x20 };
+	static const uint8_t AND_EDX_I[] = { 0x81, 0xe2 };
+	static const uint8_t PREFETCHT0_SP_NEXT_LINE[] = { 0x0f, 0x18, 0x4c, 0x06, 0x40, 0x0f, 0x18, 0x4c, 0x16, 0x40 };
+
 	static const uint8_t NOP1[] = { 0x90 };
 	static const uint8_t NOP2[] = { 0x66, 0x90 };
 	static const uint8_t NOP3[] = { 0x66, 0x66, 0x90 };
@@ -219,54 +266,547 @@ namespace randomx {
 
 	static const uint8_t* NOPX[] = { NOP1, NOP2, NOP3, NOP4, NOP5, NOP6, NOP7, NOP8 };
 
+	//nop; vpternlogq xmm4-xmm7, xmm13, xmm14, 0xea (dst = (dst & xmm13) | xmm14)
+	static const uint8_t LOOP_LOAD_EMASK_AVX512[] = {
+		0x0F, 0x1F, 0x40, 0x00,
+		0x62, 0xD3, 0x95, 0x08, 0x25, 0xE6, 0xEA,
+		0x62, 0xD3, 0x95, 0x08, 0x25, 0xEE, 0xEA,
+		0x62, 0xD3, 0x95, 0x08, 0x25, 0xF6, 0xEA,
+		0x62, 0xD3, 0x95, 0x08, 0x25, 0xFE, 0xEA,
+	};
+
+	//Instructions that are emitted from precomputed templates. Their code depends only on the registers,
+	//the immediate value and the modifier class returned by getTemplateClass.
+	enum class TemplateMod { None, Mem, Shift, Store };
+	enum class TemplateEffect { Dst, FloatDst, None };
+
+	struct TemplateKind {
+		InstructionType type;
+		TemplateMod mod;
+		TemplateEffect effect;
+	};
+
+	static const TemplateKind templateKinds[] = {
+		{ InstructionType::IADD_RS, TemplateMod::Shift, TemplateEffect::Dst },
+		{ InstructionType::IADD_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::ISUB_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::ISUB_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::IMUL_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::IMUL_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::IMULH_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::IMULH_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::ISMULH_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::ISMULH_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::INEG_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::IXOR_R, TemplateMod::None, TemplateEffect::Dst },
+		{ InstructionType::IXOR_M, TemplateMod::Mem, TemplateEffect::Dst },
+		{ InstructionType::FADD_M, TemplateMod::Mem, TemplateEffect::FloatDst },
+		{ InstructionType::FSUB_M, TemplateMod::Mem, TemplateEffect::FloatDst },
+		{ InstructionType::FDIV_M, TemplateMod::Mem, TemplateEffect::FloatDst },
+		{ InstructionType::ISTORE, TemplateMod::Store, TemplateEffect::None },
+	};
+
+	constexpr int TemplateKindCount = sizeof(templateKinds) / sizeof(templateKinds[0]);
+	constexpr int TemplateClassCount = 4;
+	constexpr int TemplateTypeCount = (int)InstructionType::NOP + 1;
+
+	static int8_t templateKindIndex[TemplateTypeCount];
+
+	static int getTemplateClass(TemplateMod mod, const Instruction& instr) {
+		switch (mod)
+		{
+		case TemplateMod::Mem:
+			return instr.getModMem() ? 1 : 0;
+		case TemplateMod::Shift:
+			return instr.getModShift();
+		case TemplateMod::Store:
+			return instr.getModCond() < StoreL3Condition ? (instr.getModMem() ? 1 : 0) : 2;
+		default:
+			return 0;
+		}
+	}
+
+	//a modifier value that belongs to the class, or -1 if the class is not used
+	static int getTemplateClassMod(TemplateMod mod, int cls) {
+		switch (mod)
+		{
+		case TemplateMod::Mem:
+			return cls < 2 ? cls : -1;
+		case TemplateMod::Shift:
+			return cls << 2;
+		case TemplateMod::Store:
+			return cls < 2 ? cls : (cls == 2 ? StoreL3Condition << 4 : -1);
+		default:
+			return cls == 0 ? 0 : -1;
+		}
+	}
+
+	static int getTemplateIndex(int kind, const Instruction& instr) {
+		int cls = getTemplateClass(templateKinds[kind].mod, instr);
+		return ((kind * RegistersCount + instr.dst) * RegistersCount + instr.src) * TemplateClassCount + cls;
+	}
+
 	size_t JitCompilerX86::getCodeSize() {
 		return CodeSize;
 	}
 
 	JitCompilerX86::JitCompilerX86() {
-		code = (uint8_t*)allocMemoryPages(CodeSize);
+		code = (uint8_t*)allocCodeMemory(CodeSize);
 		if (code == nullptr)
-			throw std::runtime_error("allocMemoryPages");
+			throw std::runtime_error("allocCodeMemory");
+		codeExec = code;
 		memcpy(code, codePrologue, prologueSize);
 		memcpy(code + epilogueOffset, codeEpilogue, epilogueSize);
+		Cpu cpu;
+		alignBranches = cpu.hasJccErratum();
+		avx512Loop = cpu.hasAvx512vl();
+	}
+
+	//The template path measures the same as the handlers, so it's off by default and the
+	//templates are only built (once per process) when it's enabled.
+	void JitCompilerX86::setTemplateEmission(bool enabled) {
+		if (enabled && encodingTemplates == nullptr) {
+			static const std::vector<EncodingTemplate> templates = buildEncodingTemplates();
+			encodingTemplates = templates.data();
+		}
+		templateEmission = enabled;
+	}
+
+	//The templates are produced by the instruction handlers, so both ways of emitting code always agree.
+	//Each combination is compiled with two different immediate values to locate the immediate field.
+	std::vector<JitCompilerX86::EncodingTemplate> JitCompilerX86::buildEncodingTemplates() {
+		std::vector<EncodingTemplate> templates(TemplateKindCount * RegistersCount * RegistersCount * TemplateClassCount);
+		uint8_t* const savedCode = code;
+		const int32_t savedPos = codePos;
+		uint8_t buffer[2][2 * sizeof(EncodingTemplate::code)];
+		for (int t = 0; t < TemplateTypeCount; ++t) {
+			templateKindIndex[t] = -1;
+		}
+		for (int kind = 0; kind < TemplateKindCount; ++kind) {
+			const TemplateKind& tk = templateKinds[kind];
+			templateKindIndex[(int)tk.type] = kind;
+			Instruction instr;
+			memset(&instr, 0, sizeof(instr));
+			while (instr.getType() != tk.type)
+				instr.opcode++;
+			for (int dst = 0; dst < RegistersCount; ++dst) {
+				for (int src = 0; src < RegistersCount; ++src) {
+					for (int cls = 0; cls < TemplateClassCount; ++cls) {
+						int mod = getTemplateClassMod(tk.mod, cls);
+						if (mod < 0)
+							continue;
+						int32_t size[2];
+						for (int v = 0; v < 2; ++v) {
+							Instruction copy = instr;
+							copy.dst = dst;
+							copy.src = src;
+							copy.setMod(mod);
+							copy.setImm32(v == 0 ? 0 : UINT32_MAX);
+							memset(buffer[v], 0, sizeof(buffer[v]));
+							code = buffer[v];
+							codePos = 0;
+							(this->*engine[copy.opcode])(copy, 0);
+							size[v] = codePos;
+						}
+						assert(size[0] == size[1] && size[0] <= (int32_t)sizeof(EncodingTemplate::code));
+						EncodingTemplate& et = templates[((kind * RegistersCount + dst) * RegistersCount + src) * TemplateClassCount + cls];
+						memcpy(et.code, buffer[0], sizeof(et.code));
+						et.size = size[0];
+						et.immOffset = -1;
+						et.immMask = 0;
+						for (int32_t j = 0; j < size[0]; ++j) {
+							if (buffer[0][j] != buffer[1][j]) {
+								if (et.immOffset < 0) {
+									et.immOffset = j;
+									memcpy(&et.immMask, buffer[1] + j, sizeof(et.immMask));
+								}
+								assert(j < et.immOffset + 4);
+							}
+						}
+					}
+				}
+			}
+		}
+		code = savedCode;
+		codePos = savedPos;
+		return templates;
+	}
+
+	void JitCompilerX86::emitTemplate(Instruction& instr, int i, int kind) {
+		const EncodingTemplate& et = encodingTemplates[getTemplateIndex(kind, instr)];
+		memcpy(code + codePos, et.code, sizeof(et.code));
+		if (et.immOffset >= 0) {
+			uint32_t imm = instr.getImm32() & et.immMask;
+			memcpy(code + codePos + et.immOffset, &imm, sizeof(imm));
+		}
+		codePos += et.size;
+		switch (templateKinds[kind].effect)
+		{
+		case TemplateEffect::Dst:
+			registerUsage[instr.dst] = i;
+			break;
+		case TemplateEffect::FloatDst:
+			instr.dst %= RegisterCountFlt;
+			break;
+		default:
+			break;
+		}
 	}
 
 	JitCompilerX86::~JitCompilerX86() {
-		freePagedMemory(code, CodeSize);
+		delete datasetInitAvx512;
+		if (sharedCode)
+			freeSharedCode(sharedSlot);
+		else if (dualMapped)
+			freeDualMappedPages(code, codeExec, CodeSize);
+		else
+			freeCodeMemory(code, CodeSize);
+	}
+
+	void JitCompilerX86::setPrefetchMode(bool datasetT0, bool scratchpadNextLine) {
+		if (datasetT0 != prefetchDatasetT0 || scratchpadNextLine != prefetchScratchpadNextLine) {
+			prefetchDatasetT0 = datasetT0;
+			prefetchScratchpadNextLine = scratchpadNextLine;
+			programTemplate = ProgramTemplate::None;
+		}
+	}
+
+	void JitCompilerX86::setAvx512Loop(bool enabled) {
+		if (enabled != avx512Loop) {
+			avx512Loop = enabled;
+			programTemplate = ProgramTemplate::None;
+		}
+	}
+
+	//The loop load ends with the 'and' and 'or' of the E group (andps/orps xmm4-xmm7, 32 bytes).
+	//With AVX-512VL, each pair is replaced by a single vpternlogq, padded to the same size.
+	void JitCompilerX86::genLoopLoad(int32_t pos) {
+		memcpy(code + pos, codeLoopLoad, loopLoadSize);
+		if (avx512Loop) {
+			memcpy(code + pos + loopLoadSize - sizeof(LOOP_LOAD_EMASK_AVX512), LOOP_LOAD_EMASK_AVX512, sizeof(LOOP_LOAD_EMASK_AVX512));
+		}
+	}
+
+	void JitCompilerX86::emitReadDataset() {
+		const int32_t pos = codePos;
+		emit(codeReadDataset, readDatasetSize);
+		if (prefetchDatasetT0) {
+			//turn prefetchnta into prefetcht0 by setting the reg field of its ModR/M byte to 1
+			for (int32_t i = pos; i + 2 < codePos; ++i) {
+				if (code[i] == 0x0f && code[i + 1] == 0x18 && (code[i + 2] & 0x38) == 0) {
+					code[i + 2] |= 0x08;
+					break;
+				}
+			}
+		}
 	}
 
+	void JitCompilerX86::emitPrefetchScratchpad() {
+		emit(ADDR(randomx_prefetch_scratchpad), ADDR(randomx_prefetch_scratchpad_end) - ADDR(randomx_prefetch_scratchpad));
+		if (prefetchScratchpadNextLine) {
+			emit(PREFETCHT0_SP_NEXT_LINE);
+		}
+	}
+
+	bool JitCompilerX86::enableDualMapping() {
+		if (dualMapped)
+			return true;
+		void* exec;
+		uint8_t* rw = (uint8_t*)allocDualMappedPages(CodeSize, &exec);
+		if (rw == nullptr)
+			return false;
+		memcpy(rw, code, CodeSize);
+		freeCodeMemory(code, CodeSize);
+		code = rw;
+		codeExec = (uint8_t*)exec;
+		dualMapped = true;
+		return true;
+	}
+
+	//Moves the code buffer to a region of large pages shared with other compilers. With dual mapping,
+	//the region is never writable and executable at the same time.
+	bool JitCompilerX86::enableSharedCode(bool dualMapping) {
+		if (sharedCode)
+			return dualMapped == dualMapping;
+		SharedCode slot;
+		if (!allocSharedCode(CodeSize, dualMapping, slot))
+			return false;
+		memcpy(slot.code, code, CodeSize);
+		if (dualMapped)
+			freeDualMappedPages(code, codeExec, CodeSize);
+		else
+			freeCodeMemory(code, CodeSize);
+		code = slot.code;
+		codeExec = slot.codeExec;
+		dualMapped = dualMapping;
+		sharedCode = true;
+		sharedSlot = slot;
+		return true;
+	}
+
+	//shared code regions keep the protection they were allocated with
 	void JitCompilerX86::enableAll() {
-		setPagesRWX(code, CodeSize);
+		if (!sharedCode)
+			setPagesRWX(code, CodeSize);
+		if (datasetInitAvx512 != nullptr)
+			datasetInitAvx512->enableAll();
 	}
 
 	void JitCompilerX86::enableWriting() {
-		setPagesRW(code, CodeSize);
+		if (!dualMapped && !sharedCode)
+			setPagesRW(code, CodeSize);
+		if (datasetInitAvx512 != nullptr)
+			datasetInitAvx512->enableWriting();
 	}
 
 	void JitCompilerX86::enableExecution() {
-		setPagesRX(code, CodeSize);
+		if (!dualMapped && !sharedCode)
+			setPagesRX(code, CodeSize);
+		if (datasetInitAvx512 != nullptr)
+			datasetInitAvx512->enableExecution();
+	}
+
+	void JitCompilerX86::enableDatasetInitAvx512() {
+		if (datasetInitAvx512 == nullptr)
+			datasetInitAvx512 = new JitCompilerX86Avx512();
+	}
+
+	DatasetInitFunc* JitCompilerX86::getDatasetInitAvx512Func() {
+		return datasetInitAvx512->getDatasetInitFunc();
 	}
 
 	void JitCompilerX86::generateProgram(Program& prog, ProgramConfiguration& pcfg) {
+		if (programTemplate != ProgramTemplate::Full)
+			generateProgramTemplate(ProgramTemplate::Full);
 		generateProgramPrologue(prog, pcfg);
-		memcpy(code + codePos, codeReadDataset, readDatasetSize);
-		codePos += readDatasetSize;
 		generateProgramEpilogue(prog, pcfg);
 	}
 
 	void JitCompilerX86::generateProgramLight(Program& prog, ProgramConfiguration& pcfg, uint32_t datasetOffset) {
+		if (programTemplate != ProgramTemplate::Light)
+			generateProgramTemplate(ProgramTemplate::Light);
 		generateProgramPrologue(prog, pcfg);
-		emit(codeReadDatasetLightSshInit, readDatasetLightInitSize);
-		emit(ADD_EBX_I);
-		emit32(datasetOffset / CacheLineSize);
-		emitByte(CALL);
-		emit32(superScalarHashOffset - (codePos + 4));
-		emit(codeReadDatasetLightSshFin, readDatasetLightFinSize);
+		uint32_t datasetItemOffset = datasetOffset / CacheLineSize;
+		memcpy(code + tailDatasetOffsetPos, &datasetItemOffset, sizeof(datasetItemOffset));
+		if (sharedSuperscalarHash != nullptr)
+			memcpy(code + superScalarHashOffset, &sharedSuperscalarHash, sizeof(sharedSuperscalarHash));
 		generateProgramEpilogue(prog, pcfg);
 	}
 
+	//Generates the parts of the program loop that don't depend on the program. The register
+	//operands that depend on ProgramConfiguration and the dataset offset are patched later.
+	void JitCompilerX86::generateProgramTemplate(ProgramTemplate type) {
+		genLoopLoad(prologueSize);
+		codePos = programTailOffset;
+		emit(REX_MOV_RR);
+		tailReadReg2Pos = codePos;
+		emitByte(0xc0);
+		emit(REX_XOR_EAX);
+		tailReadReg3Pos = codePos;
+		emitByte(0xc0);
+		if (type == ProgramTemplate::Full) {
+			emitReadDataset();
+		}
+		else {
+			emit(codeReadDatasetLightSshInit, readDatasetLightInitSize);
+			emit(ADD_EBX_I);
+			tailDatasetOffsetPos = codePos;
+			emit32(0);
+			if (sharedSuperscalarHash != nullptr) {
+				//call the function whose address is stored at the start of the unused SuperscalarHash area
+				emit(CALL_M);
+			}
+			else {
+				emitByte(CALL);
+			}
+			emit32(superScalarHashOffset - (codePos + 4));
+			emit(codeReadDatasetLightSshFin, readDatasetLightFinSize);
+		}
+		emit(REX_MOV_RR64);
+		tailReadReg0Pos = codePos;
+		emitByte(0xc0);
+		emit(REX_XOR_RAX_R64);
+		tailReadReg1Pos = codePos;
+		emitByte(0xc0);
+		emitPrefetchScratchpad();
+		emit(codeLoopStore, loopStoreSize);
+		emit(SUB_EBX);
+		emit(JNZ);
+		emit32(prologueSize - codePos - 4);
+		emitByte(JMP);
+		emit32(epilogueOffset - codePos - 4);
+		programTemplate = type;
+	}
+
+	InterleavedProgramFunc* JitCompilerX86::getInterleavedProgramFunc() {
+		return (InterleavedProgramFunc*)(codeExec + InterleavedConstSize);
+	}
+
+	void JitCompilerX86::generateProgramInterleaved(Program* progs[], ProgramConfiguration* pcfgs[], int lanes) {
+		constexpr int RAX = 0, RCX = 1, RDX = 2, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R8 = 8;
+		const int32_t lanesPtrOffset = lanes * LaneStateSize;
+		const int32_t mxcsrOffset = lanesPtrOffset + 8;
+#if defined(_WIN32) || defined(__CYGWIN__)
+		const int32_t xmmSaveOffset = lanesPtrOffset + 16;
+		const int32_t frameSize = xmmSaveOffset + 10 * 16 + 8;
+#else
+		const int32_t frameSize = lanesPtrOffset + 16 + 8;
+#endif
+		programTemplate = ProgramTemplate::None;
+		//constants
+		memcpy(code, codePrologue + prologueSize - 64, 16);
+		memcpy(code + 16, codePrologue + prologueSize - 32, 16);
+		for (int lane = 0; lane < lanes; ++lane) {
+			memcpy(code + 32 + 16 * lane, &pcfgs[lane]->eMask, sizeof(pcfgs[lane]->eMask));
+		}
+		codePos = InterleavedConstSize;
+
+		//prologue (8 pushes + frameSize leave the stack 16-byte aligned)
+		emit(PUSH_NONVOLATILE);
+		emit(SUB_RSP_I);
+		emit32(frameSize);
+#if defined(_WIN32) || defined(__CYGWIN__)
+		for (int i = 6; i < 16; ++i) {
+			genStoreXmm(i, RSP, xmmSaveOffset + 16 * (i - 6));
+		}
+#endif
+		emit(MOV_INTERLEAVED_ARGS);
+		genStore64(RCX, RSP, lanesPtrOffset);
+		emit(MXCSR);
+		genMemOperand(3, RSP, mxcsrOffset);
+		genLoadXmmConst(13, 0);
+		genLoadXmmConst(15, 16);
+		emit(XOR_R8_R8);
+		for (int lane = 0; lane < lanes; ++lane) {
+			const int32_t state = lane * LaneStateSize;
+			const int32_t lanePtr = lane * sizeof(InterleavedLane);
+			genLoad64(RAX, RCX, lanePtr + offsetof(InterleavedLane, mem));
+			genLoad64(RBP, RAX, offsetof(MemoryRegisters, mx));
+			genLoad64(RDI, RAX, offsetof(MemoryRegisters, memory));
+			genLoad64(RSI, RCX, lanePtr + offsetof(InterleavedLane, scratchpad));
+			genLoad64(RAX, RCX, lanePtr + offsetof(InterleavedLane, reg));
+			for (int i = 0; i < RegisterCountFlt; ++i) {
+				genLoadXmm(8 + i, RAX, offsetof(RegisterFile, a) + 16 * i);
+				genStoreXmm(8 + i, RSP, state + LaneStateA + 16 * i);
+			}
+			emit(MOV_R32_M);
+			genMemOperand(RAX, RCX, lanePtr + offsetof(InterleavedLane, mxcsr));
+			emit(MOV_M_R32);
+			genMemOperand(RAX, RSP, state + LaneStateMxcsr);
+			emit(MOV_RAX_RBP_ROR_RBP);
+			emit(MOV_RDX_RAX_ROR_RDX);
+			emitByte(AND_EAX_I);
+			emit32(ScratchpadL3Mask64);
+			emit(AND_EDX_I);
+			emit32(ScratchpadL3Mask64);
+			genStore64(RAX, RSP, state + LaneStateSpAddr);
+			genStore64(RDX, RSP, state + LaneStateSpAddr + 8);
+			genStore64(RBP, RSP, state + LaneStateMem);
+			genStore64(RSI, RSP, state + LaneStateScratchpad);
+			genStore64(RDI, RSP, state + LaneStateDataset);
+			for (int i = 0; i < RegistersCount; ++i) {
+				genStore64(R8, RSP, state + LaneStateR + 8 * i);
+			}
+		}
+
+		//main loop: one iteration of each lane, the dataset read of one lane overlaps with the execution of the others
+		const int32_t loopBegin = codePos;
+		for (int lane = 0; lane < lanes; ++lane) {
+			const int32_t state = lane * LaneStateSize;
+			Program& prog = *progs[lane];
+			ProgramConfiguration& pcfg = *pcfgs[lane];
+			instructionOffsets.clear();
+			for (unsigned i = 0; i < RegistersCount; ++i) {
+				registerUsage[i] = -1;
+			}
+			for (int i = 0; i < RegistersCount; ++i) {
+				genLoad64(R8 + i, RSP, state + LaneStateR + 8 * i);
+			}
+			genLoad64(RAX, RSP, state + LaneStateSpAddr);
+			genLoad64(RDX, RSP, state + LaneStateSpAddr + 8);
+			genLoad64(RBP, RSP, state + LaneStateMem);
+			genLoad64(RSI, RSP, state + LaneStateScratchpad);
+			genLoad64(RDI, RSP, state + LaneStateDataset);
+			for (int i = 0; i < RegisterCountFlt; ++i) {
+				genLoadXmm(8 + i, RSP, state + LaneStateA + 16 * i);
+			}
+			genLoadXmmConst(14, 32 + 16 * lane);
+			emit(MXCSR);
+			genMemOperand(2, RSP, state + LaneStateMxcsr);
+			genLoopLoad(codePos);
+			codePos += loopLoadSize;
+			beginProgramCode(prog);
+			for (unsigned i = 0; i < prog.getSize(); ++i) {
+				Instruction& instr = prog(i);
+				instr.src %= RegistersCount;
+				instr.dst %= RegistersCount;
+				generateCode(instr, i);
+			}
+			emit(REX_MOV_RR);
+			emitByte(0xc0 + pcfg.readReg2);
+			emit(REX_XOR_EAX);
+			emitByte(0xc0 + pcfg.readReg3);
+			emitReadDataset();
+			emit(REX_MOV_RR64);
+			emitByte(0xc0 + pcfg.readReg0);
+			emit(REX_XOR_RAX_R64);
+			emitByte(0xc0 + pcfg.readReg1);
+			emitPrefetchScratchpad();
+			emit(codeLoopStore, loopStoreSize);
+			for (int i = 0; i < RegistersCount; ++i) {
+				genStore64(R8 + i, RSP, state + LaneStateR + 8 * i);
+			}
+			genStore64(RAX, RSP, state + LaneStateSpAddr);
+			genStore64(RDX, RSP, state + LaneStateSpAddr + 8);
+			genStore64(RBP, RSP, state + LaneStateMem);
+			for (int i = 0; i < 2 * RegisterCountFlt; ++i) {
+				genStoreXmm(i, RSP, state + LaneStateF + 16 * i);
+			}
+			emit(MXCSR);
+			genMemOperand(3, RSP, state + LaneStateMxcsr);
+		}
+		emit(SUB_EBX);
+		emit(JNZ);
+		emit32(loopBegin - codePos - 4);
+
+		//epilogue: store the register file and the rounding mode of each lane
+		genLoad64(RCX, RSP, lanesPtrOffset);
+		for (int lane = 0; lane < lanes; ++lane) {
+			const int32_t state = lane * LaneStateSize;
+			const int32_t lanePtr = lane * sizeof(InterleavedLane);
+			genLoad64(RAX, RCX, lanePtr + offsetof(InterleavedLane, reg));
+			for (int i = 0; i < RegistersCount; ++i) {
+				genLoad64(RDX, RSP, state + LaneStateR + 8 * i);
+				genStore64(RDX, RAX, offsetof(RegisterFile, r) + 8 * i);
+			}
+			for (int i = 0; i < 2 * RegisterCountFlt; ++i) {
+				genLoadXmm(0, RSP, state + LaneStateF + 16 * i);
+				genStoreXmm(0, RAX, offsetof(RegisterFile, f) + 16 * i);
+			}
+			emit(MOV_R32_M);
+			genMemOperand(RDX, RSP, state + LaneStateMxcsr);
+			emit(MOV_M_R32);
+			genMemOperand(RDX, RCX, lanePtr + offsetof(InterleavedLane, mxcsr));
+		}
+		emit(MXCSR);
+		genMemOperand(2, RSP, mxcsrOffset);
+#if defined(_WIN32) || defined(__CYGWIN__)
+		for (int i = 6; i < 16; ++i) {
+			genLoadXmm(i, RSP, xmmSaveOffset + 16 * (i - 6));
+		}
+#endif
+		emit(ADD_RSP_I);
+		emit32(frameSize);
+		emit(POP_NONVOLATILE);
+		emitByte(RET);
+	}
+
 	template<size_t N>
 	void JitCompilerX86::generateSuperscalarHash(SuperscalarProgram(&programs)[N], std::vector<uint64_t> &reciprocalCache) {
+		if (sharedSuperscalarHash != nullptr) {
+			sharedSuperscalarHash = nullptr;
+			programTemplate = ProgramTemplate::None;
+		}
 		memcpy(code + superScalarHashOffset, codeShhInit, codeSshInitSize);
 		codePos = superScalarHashOffset + codeSshInitSize;
 		for (unsigned j = 0; j < N; ++j) {
@@ -292,12 +832,24 @@ namespace randomx {
 			}
 		}
 		emitByte(RET);
+		if (datasetInitAvx512 != nullptr)
+			datasetInitAvx512->generateDatasetInitCode(programs, N, reciprocalCache);
 	}
 
 	template
 		void JitCompilerX86::generateSuperscalarHash(SuperscalarProgram(&programs)[RANDOMX_CACHE_ACCESSES], std::vector<uint64_t> &reciprocalCache);
 
+	//Light mode programs will call the SuperscalarHash function compiled by another
+	//compiler (normally the one owned by the cache) instead of compiling their own.
+	bool JitCompilerX86::useSuperscalarHash(const JitCompilerX86& source) {
+		if (sharedSuperscalarHash == nullptr)
+			programTemplate = ProgramTemplate::None;
+		sharedSuperscalarHash = source.codeExec + superScalarHashOffset;
+		return true;
+	}
+
 	void JitCompilerX86::generateDatasetInitCode() {
+		programTemplate = ProgramTemplate::None;
 		memcpy(code, codeDatasetInit, datasetInitSize);
 	}
 
@@ -309,37 +861,136 @@ namespace randomx {
 
 		codePos = prologueSize;
 		memcpy(code + codePos - 48, &pcfg.eMask, sizeof(pcfg.eMask));
-		memcpy(code + codePos, codeLoopLoad, loopLoadSize);
 		codePos += loopLoadSize;
+		beginProgramCode(prog);
 		for (unsigned i = 0; i < prog.getSize(); ++i) {
 			Instruction& instr = prog(i);
 			instr.src %= RegistersCount;
 			instr.dst %= RegistersCount;
 			generateCode(instr, i);
 		}
-		emit(REX_MOV_RR);
-		emitByte(0xc0 + pcfg.readReg2);
-		emit(REX_XOR_EAX);
-		emitByte(0xc0 + pcfg.readReg3);
+		code[tailReadReg2Pos] = 0xc0 + pcfg.readReg2;
+		code[tailReadReg3Pos] = 0xc0 + pcfg.readReg3;
 	}
 
 	void JitCompilerX86::generateProgramEpilogue(Program& prog, ProgramConfiguration& pcfg) {
-		emit(REX_MOV_RR64);
-		emitByte(0xc0 + pcfg.readReg0);
-		emit(REX_XOR_RAX_R64);
-		emitByte(0xc0 + pcfg.readReg1);
-		emit(ADDR(randomx_prefetch_scratchpad), ADDR(randomx_prefetch_scratchpad_end) - ADDR(randomx_prefetch_scratchpad));
-		memcpy(code + codePos, codeLoopStore, loopStoreSize);
-		codePos += loopStoreSize;
-		emit(SUB_EBX);
-		emit(JNZ);
-		emit32(prologueSize - codePos - 4);
+		code[tailReadReg0Pos] = 0xc0 + pcfg.readReg0;
+		code[tailReadReg1Pos] = 0xc0 + pcfg.readReg1;
 		emitByte(JMP);
-		emit32(epilogueOffset - codePos - 4);
+		emit32(programTailOffset - codePos - 4);
+		//templates are copied in whole blocks, fill their leftover bytes past the jump with int3
+		int32_t padding = programTailOffset - codePos;
+		if (padding > (int32_t)MaxRandomXInstrCodeSize)
+			padding = MaxRandomXInstrCodeSize;
+		memset(code + codePos, 0xcc, padding);
+	}
+
+	void JitCompilerX86::genMemOperand(int reg, int base, int32_t disp) {
+		emitByte(0x80 + 8 * (reg % 8) + base % 8);
+		if (base % 8 == 4)
+			emitByte(0x24);
+		emit32(disp);
+	}
+
+	void JitCompilerX86::genLoad64(int reg, int base, int32_t disp) {
+		emitByte(0x48 + (reg / 8) * 4 + base / 8);
+		emitByte(0x8b);
+		genMemOperand(reg, base, disp);
+	}
+
+	void JitCompilerX86::genStore64(int reg, int base, int32_t disp) {
+		emitByte(0x48 + (reg / 8) * 4 + base / 8);
+		emitByte(0x89);
+		genMemOperand(reg, base, disp);
+	}
+
+	void JitCompilerX86::genLoadXmm(int xmm, int base, int32_t disp) {
+		emitByte(0x66);
+		if (xmm >= 8 || base >= 8)
+			emitByte(0x40 + (xmm / 8) * 4 + base / 8);
+		emitByte(0x0f);
+		emitByte(0x28);
+		genMemOperand(xmm, base, disp);
+	}
+
+	void JitCompilerX86::genStoreXmm(int xmm, int base, int32_t disp) {
+		emitByte(0x66);
+		if (xmm >= 8 || base >= 8)
+			emitByte(0x40 + (xmm / 8) * 4 + base / 8);
+		emitByte(0x0f);
+		emitByte(0x29);
+		genMemOperand(xmm, base, disp);
+	}
+
+	void JitCompilerX86::genLoadXmmConst(int xmm, int32_t target) {
+		emitByte(0x66);
+		if (xmm >= 8)
+			emitByte(0x44);
+		emitByte(0x0f);
+		emitByte(0x28);
+		emitByte(0x05 + 8 * (xmm % 8));
+		emit32(target - (codePos + 4));
+	}
+
+	void JitCompilerX86::beginProgramCode(Program& prog) {
+		programCodeBegin = codePos;
+		if (alignBranches)
+			findBranchTargets(prog, branchTargets);
+	}
+
+	void JitCompilerX86::emitNops(int count) {
+		while (count > 0) {
+			int nopSize = count < 8 ? count : 8;
+			emit(NOPX[nopSize - 1], nopSize);
+			count -= nopSize;
+		}
+	}
+
+	//Keeps CBRANCH targets away from the end of a 32-byte block and keeps the macro-fused
+	//test/jz pair of CBRANCH from crossing or ending on a 32-byte boundary (JCC erratum).
+	//The padding only uses the space that previous instructions left unused from their
+	//MaxRandomXInstrCodeSize budget, so the program always fits the code buffer.
+	void JitCompilerX86::emitBranchPadding(Instruction& instr, int i) {
+		constexpr int BoundaryMask = 31;
+		constexpr int CbranchAddSize = 7;
+		constexpr int CbranchFusedSize = 13;
+		constexpr int CbranchCodeSize = 20;
+		constexpr int MaxPrefixes = 4;
+		int32_t budget = programCodeBegin + i * (int32_t)MaxRandomXInstrCodeSize - codePos;
+		if (branchTargets[i]) {
+			int padding = -codePos & BoundaryMask;
+			if (padding > 0 && padding < 8 && padding <= budget) {
+				emitNops(padding);
+				budget -= padding;
+			}
+		}
+		if (engine[instr.opcode] == &JitCompilerX86::h_CBRANCH) {
+			int offset = (codePos + CbranchAddSize) & BoundaryMask;
+			if (offset + CbranchFusedSize >= BoundaryMask + 1) {
+				int padding = BoundaryMask + 1 - offset;
+				//CBRANCH is shorter than MaxRandomXInstrCodeSize, the rest of its slot can be used as well
+				if (padding <= budget + (int)MaxRandomXInstrCodeSize - CbranchCodeSize) {
+					//redundant segment prefixes on the add avoid executing extra NOPs
+					int prefixes = padding < MaxPrefixes ? padding : MaxPrefixes;
+					emitNops(padding - prefixes);
+					for (int j = 0; j < prefixes; ++j)
+						emitByte(0x2e);
+				}
+			}
+		}
 	}
 
 	void JitCompilerX86::generateCode(Instruction& instr, int i) {
+		if (alignBranches)
+			emitBranchPadding(instr, i);
 		instructionOffsets.push_back(codePos);
+		if (templateEmission) {
+			int kind = templateKindIndex[(int)instr.getType()];
+			if (kind >= 0) {
+				emitTemplate(instr, i, kind);
+				return;
+			}
+		}
 		auto generator = engine[instr.opcode];
 		(this->*generator)(instr, i);
 	}
@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstring>
 #include <vector>
 #include "common.hpp"
+#include "code_region.hpp"
 
 namespace randomx {
 
@@ -39,6 +40,7 @@ namespace randomx {
 	struct ProgramConfiguration;
 	class SuperscalarProgram;
 	class JitCompilerX86;
+	class JitCompilerX86Avx512;
 	class Instruction;
 
 	typedef void(JitCompilerX86::*InstructionGeneratorX86)(Instruction&, int);
@@ -49,15 +51,20 @@ namespace randomx {
 		~JitCompilerX86();
 		void generateProgram(Program&, ProgramConfiguration&);
 		void generateProgramLight(Program&, ProgramConfiguration&, uint32_t);
+		void generateProgramInterleaved(Program* [], ProgramConfiguration* [], int);
 		template<size_t N>
 		void generateSuperscalarHash(SuperscalarProgram (&programs)[N], std::vector<uint64_t> &);
 		void generateDatasetInitCode();
+		bool useSuperscalarHash(const JitCompilerX86&);
 		ProgramFunc* getProgramFunc() {
-			return (ProgramFunc*)code;
+			return (ProgramFunc*)codeExec;
 		}
+		InterleavedProgramFunc* getInterleavedProgramFunc();
 		DatasetInitFunc* getDatasetInitFunc() {
-			return (DatasetInitFunc*)code;
+			return (DatasetInitFunc*)codeExec;
 		}
+		void enableDatasetInitAvx512();
+		DatasetInitFunc* getDatasetInitAvx512Func();
 		uint8_t* getCode() {
 			return code;
 		}
@@ -65,19 +72,69 @@ namespace randomx {
 		void enableWriting();
 		void enableExecution();
 		void enableAll();
+		bool enableDualMapping();
+		bool enableSharedCode(bool dualMapping);
+		void setPrefetchMode(bool datasetT0, bool scratchpadNextLine);
+		void flushProgram() {} //x86 instruction caches are coherent with stores
+		void setScheduling(bool) {}
+		void setBranchAlignment(bool enabled) { alignBranches = enabled; }
+		void setAvx512Loop(bool enabled);
+		void setTemplateEmission(bool enabled);
 	private:
+		enum class ProgramTemplate { None, Full, Light };
+
+		//machine code of one instruction for a fixed combination of registers and modifiers
+		struct EncodingTemplate {
+			uint8_t code[32];
+			uint8_t size;
+			int8_t immOffset; //-1 if the code doesn't depend on the immediate
+			uint32_t immMask;
+		};
+
 		static InstructionGeneratorX86 engine[256];
 		std::vector<int32_t> instructionOffsets;
 		int registerUsage[RegistersCount];
 		uint8_t* code;
+		uint8_t* codeExec;
+		bool dualMapped = false;
+		bool sharedCode = false;
+		SharedCode sharedSlot;
 		int32_t codePos;
-
+		JitCompilerX86Avx512* datasetInitAvx512 = nullptr;
+		const uint8_t* sharedSuperscalarHash = nullptr;
+		ProgramTemplate programTemplate = ProgramTemplate::None;
+		int32_t tailReadReg0Pos, tailReadReg1Pos, tailReadReg2Pos, tailReadReg3Pos;
+		int32_t tailDatasetOffsetPos;
+		bool prefetchDatasetT0 = false;
+		bool prefetchScratchpadNextLine = false;
+		bool alignBranches;
+		bool branchTargets[RANDOMX_PROGRAM_SIZE];
+		int32_t programCodeBegin;
+		bool avx512Loop;
+		bool templateEmission = false;
+		const EncodingTemplate* encodingTemplates = nullptr;
+
+		std::vector<EncodingTemplate> buildEncodingTemplates();
+		void emitTemplate(Instruction&, int, int);
+		void generateProgramTemplate(ProgramTemplate);
+		void genLoopLoad(int32_t pos);
+		void emitReadDataset();
+		void emitPrefetchScratchpad();
+		void beginProgramCode(Program&);
+		void emitBranchPadding(Instruction&, int);
+		void emitNops(int);
 		void generateProgramPrologue(Program&, ProgramConfiguration&);
 		void generateProgramEpilogue(Program&, ProgramConfiguration&);
 		void genAddressReg(Instruction&, bool);
 		void genAddressRegDst(Instruction&);
 		void genAddressImm(Instruction&);
 		void genSIB(int scale, int index, int base);
+		void genMemOperand(int reg, int base, int32_t disp);
+		void genLoad64(int reg, int base, int32_t disp);
+		void genStore64(int reg, int base, int32_t disp);
+		void genLoadXmm(int xmm, int base, int32_t disp);
+		void genStoreXmm(int xmm, int base, int32_t disp);
+		void genLoadXmmConst(int xmm, int32_t target);
 
 		void generateCode(Instruction&, int);
 		void generateSuperscalarCode(Instruction &, std::vector<uint64_t> &);
@@ -0,0 +1,342 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdexcept>
+#include "jit_compiler_x86_avx512.hpp"
+#include "superscalar.hpp"
+#include "virtual_memory.h"
+#include "allocator.hpp"
+
+namespace randomx {
+	/*
+
+	REGISTER ALLOCATION:
+
+	; rax -> temporary
+	; rbx -> end item number
+	; rsi -> dataset pointer
+	; rdi -> cache memory pointer
+	; rbp -> item number of lane 0
+	; rsp -> stack pointer, 64-byte spill area for the mix block offsets
+	; zmm0 -> mix block offsets (registerValue & mask) * 64
+	; zmm1 -> dataset item offsets 0, 64, 128, ..., 448
+	; zmm2 -> lane numbers 0, 1, 2, ..., 7
+	; zmm3 -> cache line mask
+	; zmm4 -> 0x00000000ffffffff
+	; zmm16-zmm23 -> temporaries, mix block words
+	; zmm24 -> "r0"
+	; zmm25 -> "r1"
+	; zmm26 -> "r2"
+	; zmm27 -> "r3"
+	; zmm28 -> "r4"
+	; zmm29 -> "r5"
+	; zmm30 -> "r6"
+	; zmm31 -> "r7"
+
+	Only zmm0-zmm5 and zmm16-zmm31 are used, so none of the callee-saved
+	xmm6-xmm15 registers of the Windows x64 calling convention are modified.
+
+	*/
+
+	constexpr size_t MaxSuperscalarInstrSize = 136;  //ISMULH_R requires up to 19 AVX-512 instructions
+	constexpr size_t SuperscalarProgramHeader = 256; //prefetch + gather per superscalar program
+	constexpr size_t CodeAlign = 4096;               //align code size to a multiple of 4 KiB
+	constexpr size_t ReserveCodeSize = CodeAlign;    //function prologue/epilogue + reserve
+	constexpr size_t ReserveConstSize = 256;         //constants that don't depend on the programs
+
+	constexpr size_t ConstPoolSize = alignSize(ReserveConstSize + sizeof(uint64_t) * SuperscalarMaxSize * RANDOMX_CACHE_ACCESSES, CodeAlign);
+	constexpr size_t CodeSize = alignSize(ConstPoolSize + ReserveCodeSize + (SuperscalarProgramHeader + MaxSuperscalarInstrSize * SuperscalarMaxSize) * RANDOMX_CACHE_ACCESSES, CodeAlign);
+
+	static_assert(CodeSize < INT32_MAX / 2, "CodeSize is too large");
+
+	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
+	constexpr uint64_t superscalarAdd[] = {
+		9298411001130361340ULL, 12065312585734608966ULL, 9306329213124626780ULL, 5281919268842080866ULL,
+		10536153434571861004ULL, 3398623926847679864ULL, 9549104520008361294ULL
+	};
+
+	constexpr int RegR = 24;   //zmm24-zmm31
+	constexpr int RegTmp = 16; //zmm16-zmm23
+	constexpr int RegAddr = 0;
+	constexpr int RegOutOffsets = 1;
+	constexpr int RegLanes = 2;
+	constexpr int RegLineMask = 3;
+	constexpr int RegLowMask = 4;
+
+	constexpr int Map0F = 1;
+	constexpr int Map0F38 = 2;
+	constexpr int Pp66 = 1;
+	constexpr int PpF3 = 2;
+
+	constexpr int RBP = 5;
+	constexpr int RSI = 6;
+	constexpr int RDI = 7;
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+	static const uint8_t PROLOGUE[] = { 0x53, 0x55, 0x57, 0x56, 0x48, 0x89, 0xcf, 0x48, 0x89, 0xd6, 0x44, 0x89, 0xc5, 0x44, 0x89, 0xcb };
+	static const uint8_t EPILOGUE[] = { 0x48, 0x83, 0xc4, 0x40, 0xc5, 0xf8, 0x77, 0x5e, 0x5f, 0x5d, 0x5b, 0xc3 };
+#else
+	static const uint8_t PROLOGUE[] = { 0x53, 0x55, 0x89, 0xd5, 0x89, 0xcb };
+	static const uint8_t EPILOGUE[] = { 0x48, 0x83, 0xc4, 0x40, 0xc5, 0xf8, 0x77, 0x5d, 0x5b, 0xc3 };
+#endif
+	static const uint8_t MOV_RDI_MEM_SUB_RSP[] = { 0x48, 0x8b, 0x3f, 0x48, 0x83, 0xec, 0x40 };
+	static const uint8_t MOV_RAX_RSP8[] = { 0x48, 0x8b, 0x44, 0x24 };
+	static const uint8_t PREFETCHNTA_RDI_RAX[] = { 0x0f, 0x18, 0x04, 0x07 };
+	static const uint8_t KXNORW_K1[] = { 0xc5, 0xf4, 0x46, 0xc9 };
+	static const uint8_t LOOP_INCREMENT[] = { 0x48, 0x81, 0xc6, 0x00, 0x02, 0x00, 0x00, 0x83, 0xc5, 0x08, 0x39, 0xdd };
+	static const uint8_t JB_REL32[] = { 0x0f, 0x82 };
+
+	static const uint8_t VPADDQ = 0xd4;
+	static const uint8_t VPSUBQ = 0xfb;
+	static const uint8_t VPANDQ = 0xdb;
+	static const uint8_t VPXORQ = 0xef;
+	static const uint8_t VPMULUDQ = 0xf4;
+	static const uint8_t VPMULLQ = 0x40;         //0F38
+	static const uint8_t VPBROADCASTQ_R = 0x7c;  //0F38
+	static const uint8_t VPBROADCASTQ_M = 0x59;  //0F38
+	static const uint8_t VMOVDQ64_LOAD = 0x6f;
+	static const uint8_t VMOVDQ64_STORE = 0x7f;
+	static const uint8_t VPGATHERQQ = 0x91;      //0F38
+	static const uint8_t VPSCATTERQQ = 0xa1;     //0F38
+	static const uint8_t SHIFT_73 = 0x73;        //vpsrlq /2, vpsllq /6
+	static const uint8_t SHIFT_72 = 0x72;        //vprorq /0, vpsraq /4
+
+	JitCompilerX86Avx512::JitCompilerX86Avx512() {
+		code = (uint8_t*)allocCodeMemory(CodeSize);
+		if (code == nullptr)
+			throw std::runtime_error("allocCodeMemory");
+	}
+
+	JitCompilerX86Avx512::~JitCompilerX86Avx512() {
+		freeCodeMemory(code, CodeSize);
+	}
+
+	void JitCompilerX86Avx512::enableAll() {
+		setPagesRWX(code, CodeSize);
+	}
+
+	void JitCompilerX86Avx512::enableWriting() {
+		setPagesRW(code, CodeSize);
+	}
+
+	void JitCompilerX86Avx512::enableExecution() {
+		setPagesRX(code, CodeSize);
+	}
+
+	int32_t JitCompilerX86Avx512::addConstant(uint64_t value) {
+		int32_t pos = constPos;
+		memcpy(code + constPos, &value, sizeof value);
+		constPos += sizeof value;
+		return pos;
+	}
+
+	//EVEX prefix of a 512-bit instruction with W1. 'reg' and 'vvvv' are full 5-bit register numbers,
+	//'x' and 'b' are the extension bits of the ModRM.rm register or of the SIB index and base.
+	void JitCompilerX86Avx512::genEvex(int map, int pp, int reg, int vvvv, int x, int b, bool broadcast, int mask) {
+		emitByte(0x62);
+		emitByte((~reg & 8) << 4 | (~x & 1) << 6 | (~b & 1) << 5 | (~reg & 16) | map);
+		emitByte(0x80 | (~vvvv & 15) << 3 | 4 | pp);
+		emitByte(0x40 | (broadcast ? 0x10 : 0) | (~vvvv & 16) >> 1 | mask);
+	}
+
+	void JitCompilerX86Avx512::genRR(int map, uint8_t opcode, int dst, int src1, int src2) {
+		genEvex(map, Pp66, dst, src1, src2 >> 4, src2 >> 3, false, 0);
+		emitByte(opcode);
+		emitByte(0xc0 | (dst & 7) << 3 | (src2 & 7));
+	}
+
+	void JitCompilerX86Avx512::genShift(uint8_t opcode, int ext, int dst, int src, uint8_t imm) {
+		genEvex(Map0F, Pp66, ext, dst, src >> 4, src >> 3, false, 0);
+		emitByte(opcode);
+		emitByte(0xc0 | ext << 3 | (src & 7));
+		emitByte(imm);
+	}
+
+	void JitCompilerX86Avx512::genRipConst(int map, int pp, uint8_t opcode, int reg, int vvvv, int32_t target, bool broadcast) {
+		genEvex(map, pp, reg, vvvv, 0, 0, broadcast, 0);
+		emitByte(opcode);
+		emitByte(0x05 | (reg & 7) << 3);
+		emit32(target - (codePos + 4));
+	}
+
+	//vpgatherqq/vpscatterqq with the 'k1' mask and the address [base + index + 8 * word]
+	void JitCompilerX86Avx512::genVsib(uint8_t opcode, int reg, int base, int index, int word) {
+		emit(KXNORW_K1);
+		genEvex(Map0F38, Pp66, reg, index & 16, index >> 3, base >> 3, false, 1);
+		emitByte(opcode);
+		emitByte(0x44 | (reg & 7) << 3);
+		emitByte((index & 7) << 3 | (base & 7));
+		emitByte(word); //disp8 is scaled by the element size
+	}
+
+	//T5 + T1 = high 64 bits of the unsigned product dst * src, assembled from four 32x32-bit products
+	void JitCompilerX86Avx512::genMulhUnsigned(int dst, int src) {
+		constexpr int T0 = RegTmp + 0, T1 = RegTmp + 1, T2 = RegTmp + 2, T3 = RegTmp + 3, T5 = RegTmp + 5;
+		genShift(SHIFT_73, 2, T0, dst, 32);
+		genShift(SHIFT_73, 2, T1, src, 32);
+		genRR(Map0F, VPMULUDQ, T2, dst, src);
+		genRR(Map0F, VPMULUDQ, T3, dst, T1);
+		genRR(Map0F, VPMULUDQ, T5, T0, T1);
+		genRR(Map0F, VPMULUDQ, T0, T0, src);
+		genShift(SHIFT_73, 2, T2, T2, 32);
+		genRR(Map0F, VPADDQ, T2, T2, T0);
+		genRR(Map0F, VPANDQ, T1, T2, RegLowMask);
+		genShift(SHIFT_73, 2, T2, T2, 32);
+		genRR(Map0F, VPADDQ, T1, T1, T3);
+		genShift(SHIFT_73, 2, T1, T1, 32);
+		genRR(Map0F, VPADDQ, T5, T5, T2);
+	}
+
+	void JitCompilerX86Avx512::generateSuperscalarCode(Instruction& instr, std::vector<uint64_t> &reciprocalCache) {
+		constexpr int T0 = RegTmp + 0, T1 = RegTmp + 1, T2 = RegTmp + 2, T5 = RegTmp + 5;
+		const int dst = RegR + instr.dst;
+		const int src = RegR + instr.src;
+		switch ((SuperscalarInstructionType)instr.opcode)
+		{
+		case randomx::SuperscalarInstructionType::ISUB_R:
+			genRR(Map0F, VPSUBQ, dst, dst, src);
+			break;
+		case randomx::SuperscalarInstructionType::IXOR_R:
+			genRR(Map0F, VPXORQ, dst, dst, src);
+			break;
+		case randomx::SuperscalarInstructionType::IADD_RS:
+			if (instr.getModShift() != 0) {
+				genShift(SHIFT_73, 6, T0, src, instr.getModShift());
+				genRR(Map0F, VPADDQ, dst, dst, T0);
+			}
+			else {
+				genRR(Map0F, VPADDQ, dst, dst, src);
+			}
+			break;
+		case randomx::SuperscalarInstructionType::IMUL_R:
+			genRR(Map0F38, VPMULLQ, dst, dst, src);
+			break;
+		case randomx::SuperscalarInstructionType::IROR_C:
+			genShift(SHIFT_72, 0, dst, dst, instr.getImm32() & 63);
+			break;
+		case randomx::SuperscalarInstructionType::IADD_C7:
+		case randomx::SuperscalarInstructionType::IADD_C8:
+		case randomx::SuperscalarInstructionType::IADD_C9:
+			genRipConst(Map0F, Pp66, VPADDQ, dst, dst, addConstant((int32_t)instr.getImm32()), true);
+			break;
+		case randomx::SuperscalarInstructionType::IXOR_C7:
+		case randomx::SuperscalarInstructionType::IXOR_C8:
+		case randomx::SuperscalarInstructionType::IXOR_C9:
+			genRipConst(Map0F, Pp66, VPXORQ, dst, dst, addConstant((int32_t)instr.getImm32()), true);
+			break;
+		case randomx::SuperscalarInstructionType::IMULH_R:
+			genMulhUnsigned(dst, src);
+			genRR(Map0F, VPADDQ, dst, T5, T1);
+			break;
+		case randomx::SuperscalarInstructionType::ISMULH_R:
+			//signed high product = unsigned high product - (dst < 0 ? src : 0) - (src < 0 ? dst : 0)
+			genMulhUnsigned(dst, src);
+			genShift(SHIFT_72, 4, T0, dst, 63);
+			genRR(Map0F, VPANDQ, T0, T0, src);
+			genShift(SHIFT_72, 4, T2, src, 63);
+			genRR(Map0F, VPANDQ, T2, T2, dst);
+			genRR(Map0F, VPSUBQ, T5, T5, T0);
+			genRR(Map0F, VPSUBQ, T5, T5, T2);
+			genRR(Map0F, VPADDQ, dst, T5, T1);
+			break;
+		case randomx::SuperscalarInstructionType::IMUL_RCP:
+			genRipConst(Map0F38, Pp66, VPMULLQ, dst, dst, addConstant(reciprocalCache[instr.getImm32()]), true);
+			break;
+		default:
+			UNREACHABLE;
+		}
+	}
+
+	void JitCompilerX86Avx512::generateDatasetInitCode(SuperscalarProgram* programs, size_t programCount, std::vector<uint64_t> &reciprocalCache) {
+		constPos = 0;
+		const int32_t lineMask = addConstant(CacheSize / CacheLineSize - 1);
+		const int32_t lowMask = addConstant(0xffffffff);
+		const int32_t one = addConstant(1);
+		const int32_t mul0 = addConstant(superscalarMul0);
+		int32_t add[7];
+		for (unsigned i = 0; i < 7; ++i)
+			add[i] = addConstant(superscalarAdd[i]);
+		const int32_t lanes = constPos;
+		for (unsigned i = 0; i < ItemsPerIteration; ++i)
+			addConstant(i);
+		const int32_t outOffsets = constPos;
+		for (unsigned i = 0; i < ItemsPerIteration; ++i)
+			addConstant(i * CacheLineSize);
+
+		codePos = codeOffset = ConstPoolSize;
+		emit(PROLOGUE);
+		emit(MOV_RDI_MEM_SUB_RSP);
+		genRipConst(Map0F, PpF3, VMOVDQ64_LOAD, RegOutOffsets, 0, outOffsets, false);
+		genRipConst(Map0F, PpF3, VMOVDQ64_LOAD, RegLanes, 0, lanes, false);
+		genRipConst(Map0F38, Pp66, VPBROADCASTQ_M, RegLineMask, 0, lineMask, false);
+		genRipConst(Map0F38, Pp66, VPBROADCASTQ_M, RegLowMask, 0, lowMask, false);
+
+		const int32_t loopStart = codePos;
+		//registerValue = itemNumber, r0 = (itemNumber + 1) * superscalarMul0, rN = r0 ^ superscalarAddN
+		genRR(Map0F38, VPBROADCASTQ_R, RegAddr, 0, RBP);
+		genRR(Map0F, VPADDQ, RegAddr, RegAddr, RegLanes);
+		genRipConst(Map0F, Pp66, VPADDQ, RegR, RegAddr, one, true);
+		genRipConst(Map0F38, Pp66, VPMULLQ, RegR, RegR, mul0, true);
+		for (unsigned i = 0; i < 7; ++i)
+			genRipConst(Map0F, Pp66, VPXORQ, RegR + 1 + i, RegR, add[i], true);
+
+		for (size_t j = 0; j < programCount; ++j) {
+			SuperscalarProgram& prog = programs[j];
+			genRR(Map0F, VPANDQ, RegAddr, RegAddr, RegLineMask);
+			genShift(SHIFT_73, 6, RegAddr, RegAddr, 6);
+			//there is no vector prefetch, so the mix block offsets go through the stack
+			genEvex(Map0F, PpF3, RegAddr, 0, 0, 0, false, 0);
+			emitByte(VMOVDQ64_STORE);
+			emitByte(0x04 | (RegAddr & 7) << 3);
+			emitByte(0x24);
+			for (unsigned i = 0; i < ItemsPerIteration; ++i) {
+				emit(MOV_RAX_RSP8);
+				emitByte(8 * i);
+				emit(PREFETCHNTA_RDI_RAX);
+			}
+			for (unsigned i = 0; i < prog.getSize(); ++i) {
+				Instruction& instr = prog(i);
+				generateSuperscalarCode(instr, reciprocalCache);
+			}
+			for (int q = 0; q < 8; ++q)
+				genVsib(VPGATHERQQ, RegTmp + q, RDI, RegAddr, q);
+			for (int q = 0; q < 8; ++q)
+				genRR(Map0F, VPXORQ, RegR + q, RegR + q, RegTmp + q);
+			if (j < programCount - 1) {
+				genRR(Map0F, VMOVDQ64_LOAD, RegAddr, 0, RegR + prog.getAddressRegister());
+			}
+		}
+
+		for (int q = 0; q < 8; ++q)
+			genVsib(VPSCATTERQQ, RegR + q, RSI, RegOutOffsets, q);
+		emit(LOOP_INCREMENT);
+		emit(JB_REL32);
+		emit32(loopStart - (codePos + 4));
+		emit(EPILOGUE);
+	}
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "common.hpp"
+
+namespace randomx {
+
+	class SuperscalarProgram;
+	class Instruction;
+
+	//Compiles the SuperscalarHash programs into a dataset initialization function
+	//that calculates 8 consecutive dataset items at once, one item per 64-bit lane
+	//of the AVX-512 registers. The function has the DatasetInitFunc signature, but
+	//the number of items must be a non-zero multiple of ItemsPerIteration.
+	class JitCompilerX86Avx512 {
+	public:
+		static constexpr uint32_t ItemsPerIteration = 8;
+		JitCompilerX86Avx512();
+		~JitCompilerX86Avx512();
+		void generateDatasetInitCode(SuperscalarProgram* programs, size_t programCount, std::vector<uint64_t> &reciprocalCache);
+		DatasetInitFunc* getDatasetInitFunc() {
+			return (DatasetInitFunc*)(code + codeOffset);
+		}
+		void enableWriting();
+		void enableExecution();
+		void enableAll();
+	private:
+		uint8_t* code;
+		int32_t codePos;
+		int32_t constPos;
+		int32_t codeOffset;
+
+		int32_t addConstant(uint64_t value);
+		void genEvex(int map, int pp, int reg, int vvvv, int x, int b, bool broadcast, int mask);
+		void genRR(int map, uint8_t opcode, int dst, int src1, int src2);
+		void genShift(uint8_t opcode, int ext, int dst, int src, uint8_t imm);
+		void genRipConst(int map, int pp, uint8_t opcode, int reg, int vvvv, int32_t target, bool broadcast);
+		void genVsib(uint8_t opcode, int reg, int base, int index, int word);
+		void genMulhUnsigned(int dst, int src);
+		void generateSuperscalarCode(Instruction& instr, std::vector<uint64_t> &reciprocalCache);
+
+		void emitByte(uint8_t val) {
+			code[codePos] = val;
+			codePos++;
+		}
+
+		void emit32(uint32_t val) {
+			memcpy(code + codePos, &val, sizeof val);
+			codePos += sizeof val;
+		}
+
+		template<size_t N>
+		void emit(const uint8_t (&src)[N]) {
+			memcpy(code + codePos, src, N);
+			codePos += N;
+		}
+	};
+}
@@ -0,0 +1,193 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "merkle.hpp"
+#include "blake2_multi.hpp"
+#include "blake2/blake2.h"
+#include <algorithm>
+#include <cstring>
+
+namespace randomx {
+
+	static void hashPair(const void* left, const void* right, void* out) {
+		blake2b_state state;
+		blake2b_init(&state, MerkleNodeSize);
+		blake2b_update(&state, left, MerkleNodeSize);
+		blake2b_update(&state, right, MerkleNodeSize);
+		blake2b_final(&state, out, MerkleNodeSize);
+	}
+
+	//hashes a level of count nodes into the (count + 1) / 2 nodes of the next level;
+	//the siblings are adjacent, so each pair is one 64-byte message for the multi-buffer kernel
+	static size_t reduceLevel(const uint8_t* nodes, size_t count, uint8_t* out) {
+		constexpr size_t ChunkSize = 64;
+		const void* pairs[ChunkSize];
+		const size_t pairCount = count / 2;
+		for (size_t done = 0; done < pairCount; done += ChunkSize) {
+			const size_t chunk = std::min(pairCount - done, ChunkSize);
+			for (size_t i = 0; i < chunk; ++i) {
+				pairs[i] = nodes + (done + i) * 2 * MerkleNodeSize;
+			}
+			hashMulti(out + done * MerkleNodeSize, MerkleNodeSize, pairs, 2 * MerkleNodeSize, nullptr, 0, chunk);
+		}
+		if (count & 1) {
+			const uint8_t* last = nodes + (count - 1) * MerkleNodeSize;
+			hashPair(last, last, out + pairCount * MerkleNodeSize);
+		}
+		return (count + 1) / 2;
+	}
+
+	unsigned merkleDepth(size_t count) {
+		unsigned depth = 0;
+		while (depth < 64 && ((size_t)1 << depth) < count)
+			depth++;
+		return depth;
+	}
+
+	size_t merkleScratchSize(size_t count) {
+		//odd and even levels alternate between two buffers
+		return ((count + 1) / 2 + (count + 3) / 4) * MerkleNodeSize;
+	}
+
+	void merkleRoot(const void* leaves, size_t count, void* root, void* paths, uint8_t* scratch) {
+		const unsigned depth = merkleDepth(count);
+		uint8_t* buffers[2] = { scratch, scratch + (count + 1) / 2 * MerkleNodeSize };
+		uint8_t* path = (uint8_t*)paths;
+		const uint8_t* level = (const uint8_t*)leaves;
+		size_t levelCount = count;
+		for (unsigned d = 0; d < depth; ++d) {
+			if (path != nullptr) {
+				for (size_t i = 0; i < count; ++i) {
+					size_t sibling = std::min((i >> d) ^ 1, levelCount - 1);
+					memcpy(path + (i * depth + d) * MerkleNodeSize, level + sibling * MerkleNodeSize, MerkleNodeSize);
+				}
+			}
+			uint8_t* next = buffers[d & 1];
+			levelCount = reduceLevel(level, levelCount, next);
+			level = next;
+		}
+		memcpy(root, level, MerkleNodeSize);
+	}
+
+	bool merkleVerify(const void* leaf, size_t index, size_t count, const void* path, const void* root) {
+		uint8_t node[MerkleNodeSize];
+		memcpy(node, leaf, MerkleNodeSize);
+		const uint8_t* sibling = (const uint8_t*)path;
+		for (unsigned d = 0; d < merkleDepth(count); ++d, sibling += MerkleNodeSize) {
+			if ((index >> d) & 1)
+				hashPair(sibling, node, node);
+			else
+				hashPair(node, sibling, node);
+		}
+		return memcmp(node, root, MerkleNodeSize) == 0;
+	}
+}
+
+randomx_merkle_builder::randomx_merkle_builder() : count(0), pending(0), subtreeMask(0) {
+	chunk.resize(ChunkLeaves * randomx::MerkleNodeSize);
+	scratch.resize(randomx::merkleScratchSize(ChunkLeaves));
+}
+
+void randomx_merkle_builder::reset() {
+	count = 0;
+	pending = 0;
+	subtreeMask = 0;
+}
+
+void randomx_merkle_builder::add(const void* leaves, size_t leafCount) {
+	const uint8_t* input = (const uint8_t*)leaves;
+	while (leafCount > 0) {
+		const size_t take = std::min(leafCount, ChunkLeaves - pending);
+		if (take == ChunkLeaves) {
+			//complete chunks are hashed straight from the caller's buffer
+			addChunk(input);
+		}
+		else {
+			memcpy(chunk.data() + pending * randomx::MerkleNodeSize, input, take * randomx::MerkleNodeSize);
+			pending += take;
+			if (pending == ChunkLeaves) {
+				addChunk(chunk.data());
+				pending = 0;
+			}
+		}
+		input += take * randomx::MerkleNodeSize;
+		leafCount -= take;
+		count += take;
+	}
+}
+
+void randomx_merkle_builder::addChunk(const uint8_t* leaves) {
+	uint8_t node[randomx::MerkleNodeSize];
+	randomx::merkleRoot(leaves, ChunkLeaves, node, nullptr, scratch.data());
+	pushSubtree(node, ChunkLevels);
+}
+
+void randomx_merkle_builder::pushSubtree(const uint8_t* subtree, unsigned level) {
+	uint8_t node[randomx::MerkleNodeSize];
+	memcpy(node, subtree, sizeof(node));
+	while (subtreeMask & ((uint64_t)1 << level)) {
+		randomx::hashPair(subtrees[level], node, node);
+		subtreeMask &= ~((uint64_t)1 << level);
+		level++;
+	}
+	memcpy(subtrees[level], node, sizeof(node));
+	subtreeMask |= (uint64_t)1 << level;
+}
+
+bool randomx_merkle_builder::getRoot(void* root) {
+	if (count == 0)
+		return false;
+	const unsigned depth = randomx::merkleDepth(count);
+	uint8_t node[randomx::MerkleNodeSize];
+	bool partial = pending > 0;
+	unsigned level = ChunkLevels;
+	if (partial) {
+		//the leaves of the incomplete chunk form the rightmost subtree; its root is
+		//paired with itself up to the level of the complete subtrees
+		randomx::merkleRoot(chunk.data(), pending, node, nullptr, scratch.data());
+		level = std::min(depth, (unsigned)ChunkLevels);
+		for (unsigned d = randomx::merkleDepth(pending); d < level; ++d) {
+			randomx::hashPair(node, node, node);
+		}
+	}
+	for (; level < depth; ++level) {
+		const bool subtree = (subtreeMask >> level) & 1;
+		if (subtree && partial) {
+			randomx::hashPair(subtrees[level], node, node);
+		}
+		else if (subtree) {
+			randomx::hashPair(subtrees[level], subtrees[level], node);
+			partial = true;
+		}
+		else if (partial) {
+			randomx::hashPair(node, node, node);
+		}
+	}
+	memcpy(root, partial ? node : subtrees[depth], sizeof(node));
+	return true;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "randomx.h"
+
+//Binary Merkle tree over RANDOMX_HASH_SIZE byte commitments. A parent node is the 32-byte
+//Blake2b hash of its two children; the last node of a level with an odd number of nodes is
+//paired with itself. The tree of a single commitment is the commitment itself.
+
+namespace randomx {
+
+	constexpr size_t MerkleNodeSize = RANDOMX_HASH_SIZE;
+
+	//number of levels above the leaves, which is also the number of nodes in an authentication path
+	unsigned merkleDepth(size_t count);
+
+	//bytes of scratch memory needed by merkleRoot for count leaves
+	size_t merkleScratchSize(size_t count);
+
+	//Stores the root of the tree of count > 0 leaves. If paths is not null, the authentication
+	//path of leaf i (the sibling on each level from the bottom up) is stored at
+	//paths + i * merkleDepth(count) * MerkleNodeSize.
+	void merkleRoot(const void* leaves, size_t count, void* root, void* paths, uint8_t* scratch);
+
+	bool merkleVerify(const void* leaf, size_t index, size_t count, const void* path, const void* root);
+}
+
+/* Global scope for C binding */
+class randomx_merkle_builder {
+public:
+	randomx_merkle_builder();
+	void add(const void* leaves, size_t count);
+	bool getRoot(void* root);
+	void reset();
+private:
+	//Leaves are collected into chunks of ChunkLeaves, whose subtrees are hashed with the
+	//multi-buffer kernel. The roots of the complete subtrees are kept by level like the
+	//digits of a binary counter, so the builder needs constant memory.
+	static constexpr size_t ChunkLevels = 8;
+	static constexpr size_t ChunkLeaves = (size_t)1 << ChunkLevels;
+	void addChunk(const uint8_t* leaves);
+	void pushSubtree(const uint8_t* node, unsigned level);
+	size_t count;
+	size_t pending;
+	uint64_t subtreeMask;
+	std::vector<uint8_t> chunk;
+	std::vector<uint8_t> scratch;
+	uint8_t subtrees[64][randomx::MerkleNodeSize];
+};
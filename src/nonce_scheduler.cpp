@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <algorithm>
+#include "nonce_scheduler.hpp"
+#include "allocator.hpp"
+
+randomx_nonce_scheduler::randomx_nonce_scheduler(unsigned threadCount, uint32_t batchSize)
+	: threadCount(threadCount), batchSize(batchSize) {
+	states = (ThreadState*)randomx::AlignedAllocator<randomx::CacheLineSize>::allocMemory(sizeof(ThreadState) * threadCount);
+	if (states == nullptr)
+		throw std::bad_alloc();
+	for (unsigned i = 0; i < threadCount; ++i) {
+		::new (&states[i]) ThreadState();
+		states[i].node = -1;
+	}
+	reset(0, 0);
+}
+
+randomx_nonce_scheduler::~randomx_nonce_scheduler() {
+	for (unsigned i = 0; i < threadCount; ++i) {
+		states[i].~ThreadState();
+	}
+	randomx::AlignedAllocator<randomx::CacheLineSize>::freeMemory(states, sizeof(ThreadState) * threadCount);
+}
+
+//Splits the nonces evenly between the threads. Must not be called while a thread is in next().
+void randomx_nonce_scheduler::reset(uint32_t firstNonce, uint32_t nonceCount) {
+	for (unsigned i = 0; i < threadCount; ++i) {
+		uint32_t begin = firstNonce + (uint32_t)((uint64_t)nonceCount * i / threadCount);
+		uint32_t end = firstNonce + (uint32_t)((uint64_t)nonceCount * (i + 1) / threadCount);
+		states[i].range.store(pack(begin, end));
+		states[i].next = states[i].batchEnd = 0;
+	}
+}
+
+void randomx_nonce_scheduler::setNode(unsigned thread, int node) {
+	states[thread].node = node;
+}
+
+bool randomx_nonce_scheduler::claimBatch(ThreadState& state) {
+	uint64_t range = state.range.load();
+	for (;;) {
+		uint32_t begin = rangeBegin(range);
+		uint32_t end = rangeEnd(range);
+		if (begin == end)
+			return false;
+		uint32_t count = std::min(batchSize, end - begin);
+		if (state.range.compare_exchange_weak(range, pack(begin + count, end))) {
+			state.next = begin;
+			state.batchEnd = begin + count;
+			return true;
+		}
+	}
+}
+
+//Takes the upper half of the largest remaining range, preferring threads on the same NUMA node.
+//A stolen nonce can't reappear in any range, so the compare-and-swap is not subject to ABA.
+bool randomx_nonce_scheduler::steal(unsigned thread) {
+	ThreadState& self = states[thread];
+	for (;;) {
+		int victim = -1;
+		uint32_t victimSize = 0;
+		bool victimLocal = false;
+		for (unsigned i = 0; i < threadCount; ++i) {
+			if (i == thread)
+				continue;
+			uint64_t range = states[i].range.load(std::memory_order_relaxed);
+			uint32_t size = rangeEnd(range) - rangeBegin(range);
+			if (size == 0)
+				continue;
+			bool local = self.node >= 0 && states[i].node == self.node;
+			if (victim < 0 || (local && !victimLocal) || (local == victimLocal && size > victimSize)) {
+				victim = i;
+				victimSize = size;
+				victimLocal = local;
+			}
+		}
+		if (victim < 0)
+			return false;
+		uint64_t range = states[victim].range.load();
+		uint32_t begin = rangeBegin(range);
+		uint32_t end = rangeEnd(range);
+		if (begin == end)
+			continue;
+		uint32_t middle = begin + (end - begin) / 2;
+		if (states[victim].range.compare_exchange_strong(range, pack(begin, middle))) {
+			self.range.store(pack(middle, end));
+			return true;
+		}
+	}
+}
+
+bool randomx_nonce_scheduler::next(unsigned thread, uint32_t& nonce) {
+	ThreadState& state = states[thread];
+	if (state.next == state.batchEnd) {
+		while (!claimBatch(state)) {
+			if (!steal(thread))
+				return false;
+		}
+	}
+	nonce = state.next++;
+	return true;
+}
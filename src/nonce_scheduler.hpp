@@ -0,0 +1,67 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include "common.hpp"
+
+/* Global scope for C binding */
+class randomx_nonce_scheduler {
+public:
+	randomx_nonce_scheduler(unsigned threadCount, uint32_t batchSize);
+	~randomx_nonce_scheduler();
+	void reset(uint32_t firstNonce, uint32_t nonceCount);
+	void setNode(unsigned thread, int node);
+	bool next(unsigned thread, uint32_t& nonce);
+private:
+	//Each thread owns a range of nonces [begin, end) packed in one 64-bit word, so the owner
+	//and the thieves update it with a single compare-and-swap. The owner takes batchSize
+	//nonces at a time and hands them out without touching shared memory.
+	struct alignas(randomx::CacheLineSize) ThreadState {
+		std::atomic<uint64_t> range;
+		uint32_t next;
+		uint32_t batchEnd;
+		int node;
+	};
+	static uint64_t pack(uint32_t begin, uint32_t end) {
+		return ((uint64_t)begin << 32) | end;
+	}
+	static uint32_t rangeBegin(uint64_t range) {
+		return (uint32_t)(range >> 32);
+	}
+	static uint32_t rangeEnd(uint64_t range) {
+		return (uint32_t)range;
+	}
+	bool claimBatch(ThreadState& state);
+	bool steal(unsigned thread);
+	ThreadState* states;
+	unsigned threadCount;
+	uint32_t batchSize;
+};
@@ -0,0 +1,259 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "program_scheduler.hpp"
+#include "program.hpp"
+#include "bytecode_machine.hpp"
+#include "reciprocal.h"
+
+namespace randomx {
+
+	//dependency resources tracked by the scheduler
+	constexpr uint32_t ResIntReg = 0;        //r0-r7
+	constexpr uint32_t ResFltReg = 8;        //f0-f3
+	constexpr uint32_t ResExpReg = 12;       //e0-e3
+	constexpr uint32_t ResRounding = 1 << 16; //fprc
+	constexpr uint32_t ResMemory = 1 << 17;   //scratchpad
+
+	constexpr int LoadLatency = 3;
+
+	struct ScheduledInstruction {
+		uint32_t reads;
+		uint32_t writes;
+		int latency;
+		bool barrier;
+	};
+
+	static uint32_t intReg(int reg) {
+		return 1U << (ResIntReg + reg);
+	}
+
+	static ScheduledInstruction integerOp(int dst, int src, bool sourceUsed, int latency) {
+		return { intReg(dst) | (sourceUsed ? intReg(src) : 0), intReg(dst), latency, false };
+	}
+
+	static ScheduledInstruction integerLoad(int dst, int src, int latency) {
+		return { intReg(dst) | (src != dst ? intReg(src) : 0) | ResMemory, intReg(dst), LoadLatency + latency, false };
+	}
+
+	//read and write sets match the register usage tracking of BytecodeMachine::compileInstruction
+	static ScheduledInstruction decode(Instruction& instr) {
+		const int dst = instr.dst % RegistersCount;
+		const int src = instr.src % RegistersCount;
+		const uint32_t fdst = 1U << (ResFltReg + dst % RegisterCountFlt);
+		const uint32_t edst = 1U << (ResExpReg + dst % RegisterCountFlt);
+
+		switch (instr.getType())
+		{
+			case InstructionType::IADD_RS:
+				return integerOp(dst, src, true, 1);
+			case InstructionType::IADD_M:
+				return integerLoad(dst, src, 1);
+			case InstructionType::ISUB_R:
+				return integerOp(dst, src, src != dst, 1);
+			case InstructionType::ISUB_M:
+				return integerLoad(dst, src, 1);
+			case InstructionType::IMUL_R:
+				return integerOp(dst, src, src != dst, 3);
+			case InstructionType::IMUL_M:
+				return integerLoad(dst, src, 3);
+			case InstructionType::IMULH_R:
+				return integerOp(dst, src, true, 5);
+			case InstructionType::IMULH_M:
+				return integerLoad(dst, src, 5);
+			case InstructionType::ISMULH_R:
+				return integerOp(dst, src, true, 5);
+			case InstructionType::ISMULH_M:
+				return integerLoad(dst, src, 5);
+			case InstructionType::IMUL_RCP:
+				if (isZeroOrPowerOf2(instr.getImm32()))
+					return { 0, 0, 1, false };
+				return integerOp(dst, src, false, 3);
+			case InstructionType::INEG_R:
+				return integerOp(dst, src, false, 1);
+			case InstructionType::IXOR_R:
+				return integerOp(dst, src, src != dst, 1);
+			case InstructionType::IXOR_M:
+				return integerLoad(dst, src, 1);
+			case InstructionType::IROR_R:
+			case InstructionType::IROL_R:
+				return integerOp(dst, src, src != dst, 1);
+			case InstructionType::ISWAP_R:
+				if (src == dst)
+					return { 0, 0, 1, false };
+				return { intReg(dst) | intReg(src), intReg(dst) | intReg(src), 1, false };
+			case InstructionType::FSWAP_R: {
+				const uint32_t reg = dst < RegisterCountFlt ? fdst : edst;
+				return { reg, reg, 2, false };
+			}
+			case InstructionType::FADD_R:
+				return { fdst | ResRounding, fdst, 4, false };
+			case InstructionType::FADD_M:
+				return { fdst | ResRounding | intReg(src) | ResMemory, fdst, LoadLatency + 8, false };
+			case InstructionType::FSUB_R:
+				return { fdst | ResRounding, fdst, 4, false };
+			case InstructionType::FSUB_M:
+				return { fdst | ResRounding | intReg(src) | ResMemory, fdst, LoadLatency + 8, false };
+			case InstructionType::FSCAL_R:
+				return { fdst, fdst, 2, false };
+			case InstructionType::FMUL_R:
+				return { edst | ResRounding, edst, 4, false };
+			case InstructionType::FDIV_M:
+				return { edst | ResRounding | intReg(src) | ResMemory, edst, LoadLatency + 4 + 22, false };
+			case InstructionType::FSQRT_R:
+				return { edst | ResRounding, edst, 22, false };
+			case InstructionType::CBRANCH:
+				return { 0, 0, 1, true };
+			case InstructionType::CFROUND:
+				return { intReg(src), ResRounding, 4, false };
+			case InstructionType::ISTORE:
+				return { intReg(dst) | intReg(src) | ResMemory, ResMemory, 1, false };
+			default:
+				return { 0, 0, 1, false };
+		}
+	}
+
+	static void scheduleBlock(const ScheduledInstruction* decoded, uint32_t begin, uint32_t end, uint32_t*& out) {
+		const uint32_t count = end - begin;
+		if (count <= 2) {
+			for (uint32_t i = begin; i < end; ++i)
+				*out++ = i;
+			return;
+		}
+		uint32_t predecessors[RANDOMX_PROGRAM_SIZE];
+		int priority[RANDOMX_PROGRAM_SIZE];
+		int readyTime[RANDOMX_PROGRAM_SIZE];
+		bool done[RANDOMX_PROGRAM_SIZE];
+		auto depends = [&](uint32_t i, uint32_t j) {
+			//true if instruction j must stay after instruction i
+			return (decoded[i].writes & (decoded[j].reads | decoded[j].writes)) || (decoded[i].reads & decoded[j].writes);
+		};
+		//priority is the length of the longest dependency chain to the end of the block
+		for (uint32_t j = end; j-- > begin; ) {
+			priority[j] = decoded[j].latency;
+			predecessors[j] = 0;
+			readyTime[j] = 0;
+			done[j] = false;
+			for (uint32_t k = j + 1; k < end; ++k) {
+				if (depends(j, k) && priority[k] + decoded[j].latency > priority[j])
+					priority[j] = priority[k] + decoded[j].latency;
+			}
+		}
+		for (uint32_t j = begin; j < end; ++j) {
+			for (uint32_t k = j + 1; k < end; ++k) {
+				if (depends(j, k))
+					predecessors[k]++;
+			}
+		}
+		//list scheduling with one instruction issued per cycle
+		int cycle = 0;
+		for (uint32_t n = 0; n < count; ++n) {
+			uint32_t best = end;
+			bool bestReady = false;
+			for (uint32_t j = begin; j < end; ++j) {
+				if (done[j] || predecessors[j] != 0)
+					continue;
+				const bool ready = readyTime[j] <= cycle;
+				if (best == end || (ready && !bestReady) || (ready == bestReady && (ready ? priority[j] > priority[best] : readyTime[j] < readyTime[best]))) {
+					best = j;
+					bestReady = ready;
+				}
+			}
+			done[best] = true;
+			*out++ = best;
+			if (readyTime[best] > cycle)
+				cycle = readyTime[best];
+			const int finish = cycle + decoded[best].latency;
+			for (uint32_t k = best + 1; k < end; ++k) {
+				if (!done[k] && depends(best, k)) {
+					predecessors[k]--;
+					if (finish > readyTime[k])
+						readyTime[k] = finish;
+				}
+			}
+			cycle++;
+		}
+	}
+
+	void scheduleProgram(Program& program, uint32_t (&order)[RANDOMX_PROGRAM_SIZE]) {
+		ScheduledInstruction decoded[RANDOMX_PROGRAM_SIZE];
+		int lastWriter[RegistersCount];
+		for (unsigned j = 0; j < RegistersCount; ++j)
+			lastWriter[j] = -1;
+		for (uint32_t i = 0; i < program.getSize(); ++i) {
+			Instruction& instr = program(i);
+			decoded[i] = decode(instr);
+			if (decoded[i].barrier) {
+				//the register write that determines the branch target must stay last before it
+				int target = lastWriter[instr.dst % RegistersCount];
+				if (target >= 0)
+					decoded[target].barrier = true;
+				for (unsigned j = 0; j < RegistersCount; ++j)
+					lastWriter[j] = i;
+			}
+			else {
+				for (unsigned j = 0; j < RegistersCount; ++j) {
+					if (decoded[i].writes & intReg(j))
+						lastWriter[j] = i;
+				}
+			}
+		}
+		uint32_t* out = order;
+		uint32_t begin = 0;
+		for (uint32_t i = 0; i < program.getSize(); ++i) {
+			if (decoded[i].barrier) {
+				scheduleBlock(decoded, begin, i, out);
+				*out++ = i;
+				begin = i + 1;
+			}
+		}
+		scheduleBlock(decoded, begin, program.getSize(), out);
+	}
+
+	void findBranchTargets(Program& program, bool (&targets)[RANDOMX_PROGRAM_SIZE]) {
+		int lastWriter[RegistersCount];
+		for (unsigned j = 0; j < RegistersCount; ++j)
+			lastWriter[j] = -1;
+		for (uint32_t i = 0; i < program.getSize(); ++i) {
+			Instruction& instr = program(i);
+			ScheduledInstruction decoded = decode(instr);
+			targets[i] = false;
+			if (decoded.barrier) {
+				targets[lastWriter[instr.dst % RegistersCount] + 1] = true;
+				for (unsigned j = 0; j < RegistersCount; ++j)
+					lastWriter[j] = i;
+			}
+			else {
+				for (unsigned j = 0; j < RegistersCount; ++j) {
+					if (decoded.writes & intReg(j))
+						lastWriter[j] = i;
+				}
+			}
+		}
+	}
+}
@@ -28,24 +28,84 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "randomx.h"
 #include "dataset.hpp"
+#include "epoch.hpp"
+#include "verifier.hpp"
+#include "vm_pool.hpp"
+#include "nonce_scheduler.hpp"
+#include "engine.hpp"
+#include "input_template.hpp"
+#include "scratchpad_arena.hpp"
+#include "autotune.hpp"
+#include "blake2_multi.hpp"
+#include "merkle.hpp"
 #include "vm_interpreted.hpp"
 #include "vm_interpreted_light.hpp"
+#include "vm_interpreted_lazy.hpp"
+#include "vm_interpreted_interleaved.hpp"
 #include "vm_compiled.hpp"
 #include "vm_compiled_light.hpp"
+#if defined(RANDOMX_COMPILER_X86)
+#include "vm_compiled_interleaved.hpp"
+#endif
 #include "blake2/blake2.h"
+#include "intrin_portable.h"
+#include "tracepoints.h"
+#include "aes_hash.hpp"
 #include "cpu.hpp"
+#include "thread_affinity.hpp"
+#include "virtual_memory.h"
 #include <cassert>
 #include <limits>
+#include <algorithm>
+#include <thread>
+#include <new>
 
-#if defined(__SSE__) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP > 0))
-#define USE_CSR_INTRINSICS
-#include <xmmintrin.h>
-#else
-#include <cfenv>
-#endif
+//constructs a virtual machine in the storage of an arena slot if provided
+template<class T>
+static randomx_vm *newVm(void *storage) {
+	static_assert(sizeof(T) <= randomx::ArenaVmSize, "ArenaVmSize is too small");
+	if (storage != nullptr) {
+		return ::new (storage) T();
+	}
+	return new T();
+}
+
+static void deleteVm(randomx_vm *vm) {
+	randomx_scratchpad_arena *arena = vm->arena;
+	if (arena != nullptr) {
+		int slot = vm->arenaSlot;
+		vm->~randomx_vm();
+		arena->release(slot);
+	}
+	else {
+		delete vm;
+	}
+}
+
+//the page allocations of the calling thread prefer a NUMA node while in scope (used on Windows)
+class AllocationNodeScope {
+public:
+	explicit AllocationNodeScope(int node) : previous(setAllocationNode(node)) {}
+	~AllocationNodeScope() {
+		setAllocationNode(previous);
+	}
+	AllocationNodeScope(const AllocationNodeScope&) = delete;
+	AllocationNodeScope& operator=(const AllocationNodeScope&) = delete;
+private:
+	int previous;
+};
 
 extern "C" {
 
+	static bool isDatasetAvx512Supported() {
+#if defined(RANDOMX_COMPILER_X86)
+		randomx::Cpu cpu;
+		return cpu.hasAvx512f() && cpu.hasAvx512dq();
+#else
+		return false;
+#endif
+	}
+
 	randomx_flags randomx_get_flags() {
 		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
 		randomx::Cpu cpu;
@@ -57,61 +117,140 @@ extern "C" {
 		if (HAVE_AES && cpu.hasAes()) {
 			flags |= RANDOMX_FLAG_HARD_AES;
 		}
+		if ((flags & RANDOMX_FLAG_HARD_AES) && aesVaesCompiled() && cpu.hasVaes()) {
+			flags |= RANDOMX_FLAG_VAES;
+		}
+		if ((flags & RANDOMX_FLAG_JIT) && isDatasetAvx512Supported()) {
+			flags |= RANDOMX_FLAG_DATASET_AVX512;
+		}
+		if (randomx_argon2_impl_avx512() != nullptr && cpu.hasAvx512f()) {
+			flags |= RANDOMX_FLAG_ARGON2_AVX512;
+		}
 		if (randomx_argon2_impl_avx2() != nullptr && cpu.hasAvx2()) {
 			flags |= RANDOMX_FLAG_ARGON2_AVX2;
 		}
 		if (randomx_argon2_impl_ssse3() != nullptr && cpu.hasSsse3()) {
 			flags |= RANDOMX_FLAG_ARGON2_SSSE3;
 		}
+		//NEON is a mandatory part of ARMv8-A
+		if (randomx_argon2_impl_neon() != nullptr) {
+			flags |= RANDOMX_FLAG_ARGON2_NEON;
+		}
 		return flags;
 	}
 
+	void randomx_get_parameters(randomx_parameters *params) {
+		assert(params != nullptr);
+		static const uint8_t frequencies[] = {
+			RANDOMX_FREQ_IADD_RS, RANDOMX_FREQ_IADD_M, RANDOMX_FREQ_ISUB_R, RANDOMX_FREQ_ISUB_M,
+			RANDOMX_FREQ_IMUL_R, RANDOMX_FREQ_IMUL_M, RANDOMX_FREQ_IMULH_R, RANDOMX_FREQ_IMULH_M,
+			RANDOMX_FREQ_ISMULH_R, RANDOMX_FREQ_ISMULH_M, RANDOMX_FREQ_IMUL_RCP, RANDOMX_FREQ_INEG_R,
+			RANDOMX_FREQ_IXOR_R, RANDOMX_FREQ_IXOR_M, RANDOMX_FREQ_IROR_R, RANDOMX_FREQ_IROL_R,
+			RANDOMX_FREQ_ISWAP_R, RANDOMX_FREQ_FSWAP_R, RANDOMX_FREQ_FADD_R, RANDOMX_FREQ_FADD_M,
+			RANDOMX_FREQ_FSUB_R, RANDOMX_FREQ_FSUB_M, RANDOMX_FREQ_FSCAL_R, RANDOMX_FREQ_FMUL_R,
+			RANDOMX_FREQ_FDIV_M, RANDOMX_FREQ_FSQRT_R, RANDOMX_FREQ_CBRANCH, RANDOMX_FREQ_CFROUND,
+			RANDOMX_FREQ_ISTORE, RANDOMX_FREQ_NOP
+		};
+		static_assert(sizeof(frequencies) == sizeof(params->instructionFrequencies), "Invalid number of instruction frequencies");
+		params->argonMemory = RANDOMX_ARGON_MEMORY;
+		params->argonIterations = RANDOMX_ARGON_ITERATIONS;
+		params->argonLanes = RANDOMX_ARGON_LANES;
+		params->argonSalt = RANDOMX_ARGON_SALT;
+		params->argonSaltSize = sizeof(RANDOMX_ARGON_SALT) - 1;
+		params->cacheAccesses = RANDOMX_CACHE_ACCESSES;
+		params->superscalarLatency = RANDOMX_SUPERSCALAR_LATENCY;
+		params->datasetBaseSize = RANDOMX_DATASET_BASE_SIZE;
+		params->datasetExtraSize = RANDOMX_DATASET_EXTRA_SIZE;
+		params->programSize = RANDOMX_PROGRAM_SIZE;
+		params->programIterations = RANDOMX_PROGRAM_ITERATIONS;
+		params->programCount = RANDOMX_PROGRAM_COUNT;
+		params->scratchpadL3 = RANDOMX_SCRATCHPAD_L3;
+		params->scratchpadL2 = RANDOMX_SCRATCHPAD_L2;
+		params->scratchpadL1 = RANDOMX_SCRATCHPAD_L1;
+		params->jumpBits = RANDOMX_JUMP_BITS;
+		params->jumpOffset = RANDOMX_JUMP_OFFSET;
+		memcpy(params->instructionFrequencies, frequencies, sizeof(frequencies));
+	}
+
+	int randomx_parameters_supported(const randomx_parameters *params) {
+		assert(params != nullptr);
+		randomx_parameters own;
+		randomx_get_parameters(&own);
+		if (params->argonSaltSize != own.argonSaltSize || (own.argonSaltSize > 0 && (params->argonSalt == nullptr || memcmp(params->argonSalt, own.argonSalt, own.argonSaltSize) != 0))) {
+			return 0;
+		}
+		return params->argonMemory == own.argonMemory
+			&& params->argonIterations == own.argonIterations
+			&& params->argonLanes == own.argonLanes
+			&& params->cacheAccesses == own.cacheAccesses
+			&& params->superscalarLatency == own.superscalarLatency
+			&& params->datasetBaseSize == own.datasetBaseSize
+			&& params->datasetExtraSize == own.datasetExtraSize
+			&& params->programSize == own.programSize
+			&& params->programIterations == own.programIterations
+			&& params->programCount == own.programCount
+			&& params->scratchpadL3 == own.scratchpadL3
+			&& params->scratchpadL2 == own.scratchpadL2
+			&& params->scratchpadL1 == own.scratchpadL1
+			&& params->jumpBits == own.jumpBits
+			&& params->jumpOffset == own.jumpOffset
+			&& memcmp(params->instructionFrequencies, own.instructionFrequencies, sizeof(own.instructionFrequencies)) == 0;
+	}
+
+	void randomx_set_allocator(const randomx_allocator *allocator) {
+		assert(allocator == nullptr || (allocator->alloc != nullptr && allocator->free != nullptr));
+		randomx::setCustomAllocator(allocator);
+	}
+
 	randomx_cache *randomx_alloc_cache(randomx_flags flags) {
 		randomx_cache *cache = nullptr;
 		auto impl = randomx::selectArgonImpl(flags);
 		if (impl == nullptr) {
 			return cache;
 		}
+		//the flag has no effect in interpreted mode
+		if ((flags & RANDOMX_FLAG_JIT) && (flags & RANDOMX_FLAG_DATASET_AVX512) && !isDatasetAvx512Supported()) {
+			return cache;
+		}
 
 		try {
 			cache = new randomx_cache();
 			cache->argonImpl = impl;
-			switch ((int)(flags & (RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES))) {
-				case RANDOMX_FLAG_DEFAULT:
-					cache->dealloc = &randomx::deallocCache<randomx::DefaultAllocator>;
-					cache->jit = nullptr;
-					cache->initialize = &randomx::initCache;
-					cache->datasetInit = &randomx::initDataset;
-					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize);
-					break;
-
-				case RANDOMX_FLAG_JIT:
-					cache->dealloc = &randomx::deallocCache<randomx::DefaultAllocator>;
-					cache->jit = new randomx::JitCompiler();
-					cache->initialize = &randomx::initCacheCompile;
-					cache->datasetInit = cache->jit->getDatasetInitFunc();
-					cache->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::CacheSize);
-					break;
-
-				case RANDOMX_FLAG_LARGE_PAGES:
-					cache->dealloc = &randomx::deallocCache<randomx::LargePageAllocator>;
-					cache->jit = nullptr;
-					cache->initialize = &randomx::initCache;
-					cache->datasetInit = &randomx::initDataset;
-					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize);
-					break;
-
-				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
-					cache->dealloc = &randomx::deallocCache<randomx::LargePageAllocator>;
-					cache->jit = new randomx::JitCompiler();
-					cache->initialize = &randomx::initCacheCompile;
-					cache->datasetInit = cache->jit->getDatasetInitFunc();
-					cache->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize);
-					break;
-
-				default:
-					UNREACHABLE;
+			if (randomx::hasCustomAllocator()) {
+				cache->dealloc = &randomx::deallocCache<randomx::CustomAllocator<RANDOMX_MEMORY_CACHE>>;
+				cache->allocMemory = &randomx::CustomAllocator<RANDOMX_MEMORY_CACHE>::allocMemory;
+				cache->freeMemory = &randomx::CustomAllocator<RANDOMX_MEMORY_CACHE>::freeMemory;
+			}
+			else if (flags & RANDOMX_FLAG_LARGE_PAGES) {
+				cache->dealloc = &randomx::deallocCache<randomx::LargePageAllocator>;
+				cache->allocMemory = &randomx::LargePageAllocator::allocMemory;
+				cache->freeMemory = &randomx::LargePageAllocator::freeMemory;
+			}
+			else {
+				cache->dealloc = &randomx::deallocCache<randomx::CacheAllocator>;
+				cache->allocMemory = &randomx::CacheAllocator::allocMemory;
+				cache->freeMemory = &randomx::CacheAllocator::freeMemory;
+			}
+			if (flags & RANDOMX_FLAG_JIT) {
+				cache->jit = new randomx::JitCompiler();
+				if (flags & RANDOMX_FLAG_JIT_SHARED_CODE) {
+					cache->jit->enableSharedCode((flags & RANDOMX_FLAG_SECURE) != 0);
+				}
+				cache->initialize = &randomx::initCacheCompile;
+				cache->datasetInit = cache->jit->getDatasetInitFunc();
+			}
+			else {
+				cache->jit = nullptr;
+				cache->initialize = &randomx::initCache;
+				cache->datasetInit = &randomx::initDataset;
+			}
+			cache->memory = (uint8_t*)cache->allocMemory(randomx::CacheSize, &cache->pageBacking);
+#if defined(RANDOMX_COMPILER_X86)
+			if ((flags & RANDOMX_FLAG_JIT) && (flags & RANDOMX_FLAG_DATASET_AVX512)) {
+				cache->jit->enableDatasetInitAvx512();
+				cache->datasetInit = &randomx::initDatasetAvx512;
 			}
+#endif
 		}
 		catch (std::exception &ex) {
 			if (cache != nullptr) {
@@ -127,15 +266,70 @@ extern "C" {
 		return cache;
 	}
 
+	//a drained cache gets its memory back before it is initialized with a new key
+	//(the allocators throw, so exceptions don't escape the C API)
+	static bool refillCache(randomx_cache *cache) {
+		if (!cache->isDrained())
+			return true;
+		try {
+			cache->memory = (uint8_t*)cache->allocMemory(randomx::CacheSize, &cache->pageBacking);
+		}
+		catch (std::exception &ex) {
+			cache->memory = nullptr;
+		}
+		if (cache->memory == nullptr) {
+			//the programs of the previous key are discarded, so the failure can be detected
+			cache->programs[0].setSize(0);
+			cache->cacheKey.clear();
+			return false;
+		}
+		return true;
+	}
+
 	void randomx_init_cache(randomx_cache *cache, const void *key, size_t keySize) {
 		assert(cache != nullptr);
 		assert(keySize == 0 || key != nullptr);
 		std::string cacheKey;
 		cacheKey.assign((const char *)key, keySize);
 		if (cache->cacheKey != cacheKey || !cache->isInitialized()) {
-			cache->initialize(cache, key, keySize);
+			if (!refillCache(cache))
+				return;
+			cache->initialize(cache, key, keySize, nullptr, 1);
+			cache->cacheKey = cacheKey;
+		}
+	}
+
+	void randomx_init_cache_parallel(randomx_cache *cache, const void *key, size_t keySize, unsigned threadCount) {
+		assert(cache != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		std::string cacheKey;
+		cacheKey.assign((const char *)key, keySize);
+		if (cache->cacheKey != cacheKey || !cache->isInitialized()) {
+			if (!refillCache(cache))
+				return;
+			cache->initialize(cache, key, keySize, nullptr, threadCount);
+			cache->cacheKey = cacheKey;
+		}
+	}
+
+	int randomx_init_cache_progress(randomx_cache *cache, const void *key, size_t keySize, randomx_progress_callback *progress, void *userData, randomx_cancel_token *cancel) {
+		assert(cache != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		randomx::InitProgress control = { progress, userData, cancel };
+		std::string cacheKey;
+		cacheKey.assign((const char *)key, keySize);
+		if (cache->cacheKey != cacheKey || !cache->isInitialized()) {
+			if (!refillCache(cache))
+				return 0;
+			if (!cache->initialize(cache, key, keySize, &control, 1))
+				return 0;
 			cache->cacheKey = cacheKey;
 		}
+		control.report(randomx::CacheInitUnits, randomx::CacheInitUnits);
+		return 1;
 	}
 
 	void randomx_release_cache(randomx_cache* cache) {
@@ -144,7 +338,104 @@ extern "C" {
 		delete cache;
 	}
 
+	int randomx_cache_save(randomx_cache *cache, const char *path) {
+		assert(cache != nullptr && cache->isInitialized());
+		assert(!cache->isDrained());
+		assert(path != nullptr);
+		return randomx::saveCacheFile(cache, path) ? 1 : 0;
+	}
+
+	int randomx_cache_load(randomx_cache *cache, const char *path) {
+		assert(cache != nullptr);
+		assert(path != nullptr);
+		if (!refillCache(cache))
+			return 0;
+		return randomx::loadCacheFile(cache, path) ? 1 : 0;
+	}
+
+	void randomx_cache_drain(randomx_cache *cache) {
+		assert(cache != nullptr);
+		if (!cache->isDrained()) {
+			cache->freeMemory(cache->memory, randomx::CacheSize);
+			cache->memory = nullptr;
+		}
+	}
+
+	randomx_scratchpad_arena *randomx_cache_drain_to_arena(randomx_cache *cache) {
+		assert(cache != nullptr);
+		randomx_scratchpad_arena *arena = nullptr;
+		if (cache->isDrained()) {
+			return arena;
+		}
+		try {
+			arena = new randomx_scratchpad_arena(cache->memory, randomx::CacheSize, cache->pageBacking, cache->freeMemory);
+			cache->memory = nullptr;
+		}
+		catch (std::exception &ex) {
+			arena = nullptr;
+		}
+		return arena;
+	}
+
+	int randomx_cache_is_drained(randomx_cache *cache) {
+		assert(cache != nullptr);
+		return cache->isDrained() ? 1 : 0;
+	}
+
+	int randomx_cache_set_item_cache(randomx_cache *cache, size_t size) {
+		assert(cache != nullptr);
+		randomx::SharedItemCache* itemCache = nullptr;
+		if (size > 0) {
+			try {
+				itemCache = new randomx::SharedItemCache(size);
+			}
+			catch (std::exception &ex) {
+				return 0;
+			}
+		}
+		delete cache->itemCache;
+		cache->itemCache = itemCache;
+		return 1;
+	}
+
+	int randomx_cache_set_result_cache(randomx_cache *cache, size_t size) {
+		assert(cache != nullptr);
+		randomx::SharedResultCache* resultCache = nullptr;
+		if (size > 0) {
+			try {
+				resultCache = new randomx::SharedResultCache(size);
+			}
+			catch (std::exception &ex) {
+				return 0;
+			}
+		}
+		delete cache->resultCache;
+		cache->resultCache = resultCache;
+		return 1;
+	}
+
+	int randomx_cache_set_aot_module(randomx_cache *cache, const randomx_aot_module *module) {
+		assert(cache != nullptr);
+		if (module == nullptr) {
+			cache->aotItem = nullptr;
+			return 1;
+		}
+		assert(module->initItem != nullptr);
+		if (!cache->isInitialized())
+			return 0;
+		uint8_t keyHash[sizeof(module->keyHash)];
+		uint8_t configHash[randomx::ConfigurationHashSize];
+		blake2b(keyHash, sizeof(keyHash), cache->cacheKey.data(), cache->cacheKey.size(), nullptr, 0);
+		randomx::hashConfiguration(configHash);
+		if (memcmp(keyHash, module->keyHash, sizeof(keyHash)) != 0 || memcmp(configHash, module->configurationHash, sizeof(configHash)) != 0)
+			return 0;
+		cache->aotItem = module->initItem;
+		return 1;
+	}
+
 	randomx_dataset *randomx_alloc_dataset(randomx_flags flags) {
+		//with NUMA copies, the dataset itself is the copy of node 0
+		AllocationNodeScope nodeScope((flags & RANDOMX_FLAG_NUMA) && randomx::getNumaNodeCount() > 1 ? (int)randomx::getNumaNodeId(0) : getAllocationNode());
 
 		//fail on 32-bit systems if DatasetSize is >= 4 GiB
 		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
@@ -155,13 +446,46 @@ extern "C" {
 
 		try {
 			dataset = new randomx_dataset();
-			if (flags & RANDOMX_FLAG_LARGE_PAGES) {
+			if (randomx::hasCustomAllocator()) {
+				dataset->dealloc = &randomx::deallocDataset<randomx::CustomAllocator<RANDOMX_MEMORY_DATASET>>;
+				dataset->memory = (uint8_t*)randomx::CustomAllocator<RANDOMX_MEMORY_DATASET>::allocMemory(randomx::DatasetSize, &dataset->pageBacking);
+			}
+			else if (flags & RANDOMX_FLAG_LARGE_PAGES_1GB) {
+				//try 1 GiB pages, then large pages, then transparent huge pages and standard pages
+				if ((dataset->memory = (uint8_t*)allocGigaPagesMemory(randomx::DatasetSize)) != nullptr) {
+					dataset->dealloc = &randomx::deallocDataset<randomx::GigaPageAllocator>;
+					dataset->pageBacking = RANDOMX_PAGES_1GB;
+				}
+				else if ((dataset->memory = (uint8_t*)allocLargePagesMemory(randomx::DatasetSize)) != nullptr) {
+					dataset->dealloc = &randomx::deallocDataset<randomx::LargePageAllocator>;
+					dataset->pageBacking = RANDOMX_PAGES_LARGE;
+				}
+				else if ((dataset->memory = (uint8_t*)allocTransparentHugePagesMemory(randomx::DatasetSize)) != nullptr) {
+					dataset->dealloc = &randomx::deallocDataset<randomx::LargePageAllocator>;
+					dataset->pageBacking = RANDOMX_PAGES_TRANSPARENT;
+				}
+				else {
+					dataset->dealloc = &randomx::deallocDataset<randomx::DefaultAllocator>;
+					dataset->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::DatasetSize, &dataset->pageBacking);
+				}
+			}
+			else if (flags & RANDOMX_FLAG_LARGE_PAGES) {
 				dataset->dealloc = &randomx::deallocDataset<randomx::LargePageAllocator>;
-				dataset->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::DatasetSize);
+				dataset->memory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::DatasetSize, &dataset->pageBacking);
 			}
 			else {
 				dataset->dealloc = &randomx::deallocDataset<randomx::DefaultAllocator>;
-				dataset->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::DatasetSize);
+				dataset->memory = (uint8_t*)randomx::DefaultAllocator::allocMemory(randomx::DatasetSize, &dataset->pageBacking);
+			}
+			switch (dataset->pageBacking) {
+				case RANDOMX_PAGES_1GB:
+					dataset->pageSize = (size_t)1 << 30;
+					break;
+				case RANDOMX_PAGES_LARGE:
+					dataset->pageSize = getLargePageSize();
+					break;
+				default:
+					dataset->pageSize = getPageSize();
 			}
 		}
 		catch (std::exception &ex) {
@@ -175,9 +499,76 @@ extern "C" {
 			dataset = nullptr;
 		}
 
+		if (dataset && (flags & RANDOMX_FLAG_NUMA)) {
+			const unsigned nodeCount = randomx::getNumaNodeCount();
+			if (nodeCount > 1) {
+				bindMemoryToNode(dataset->memory, randomx::DatasetSize, randomx::getNumaNodeId(0));
+				dataset->replicas[0] = dataset;
+				dataset->replicaCount = 1;
+				for (unsigned node = 1; node < nodeCount; ++node) {
+					AllocationNodeScope nodeScope(randomx::getNumaNodeId(node));
+					randomx_dataset *replica = randomx_alloc_dataset((randomx_flags)(flags & ~(RANDOMX_FLAG_NUMA | RANDOMX_FLAG_PREFAULT)));
+					if (replica == nullptr) {
+						randomx_release_dataset(dataset);
+						return nullptr;
+					}
+					bindMemoryToNode(replica->memory, randomx::DatasetSize, randomx::getNumaNodeId(node));
+					dataset->replicas[dataset->replicaCount++] = replica;
+				}
+			}
+		}
+		//the replicas are pre-faulted once, after they are bound to their nodes
+		if (dataset && (flags & RANDOMX_FLAG_PREFAULT)) {
+			randomx::prefaultDataset(dataset);
+		}
+
 		return dataset;
 	}
 
+	unsigned randomx_numa_node_count() {
+		return randomx::getNumaNodeCount();
+	}
+
+	uint64_t randomx_numa_node_cpu_mask(unsigned node) {
+		uint64_t mask = 0;
+		if (node < randomx::getNumaNodeCount()) {
+			for (unsigned cpu : randomx::getNumaNodeCpus(node)) {
+				if (cpu < 64)
+					mask |= 1ULL << cpu;
+			}
+		}
+		return mask;
+	}
+
+	unsigned randomx_thread_placement(randomx_placement policy, unsigned threadCount, unsigned *cpus, unsigned *capacities) {
+		assert(cpus != nullptr);
+		auto topology = randomx::getCpuTopology();
+		auto placement = randomx::placeThreads(topology, policy, threadCount);
+		for (size_t i = 0; i < placement.size(); ++i) {
+			cpus[i] = placement[i];
+			if (capacities != nullptr) {
+				capacities[i] = randomx::MaxCpuCapacity;
+				for (auto& info : topology) {
+					if (info.cpu == placement[i])
+						capacities[i] = info.capacity;
+				}
+			}
+		}
+		return (unsigned)placement.size();
+	}
+
+	unsigned randomx_cpu_core(unsigned cpu) {
+		for (auto& info : randomx::getCpuTopology()) {
+			if (info.cpu == cpu)
+				return info.core;
+		}
+		return cpu;
+	}
+
+	int randomx_set_thread_affinity(unsigned cpu) {
+		return randomx::setThreadAffinity(cpu) ? 1 : 0;
+	}
+
 	constexpr unsigned long DatasetItemCount = randomx::DatasetSize / RANDOMX_DATASET_ITEM_SIZE;
 
 	unsigned long randomx_dataset_item_count() {
@@ -187,235 +578,1494 @@ extern "C" {
 	void randomx_init_dataset(randomx_dataset *dataset, randomx_cache *cache, unsigned long startItem, unsigned long itemCount) {
 		assert(dataset != nullptr);
 		assert(cache != nullptr);
+		assert(!cache->isDrained());
 		assert(startItem < DatasetItemCount && itemCount <= DatasetItemCount);
 		assert(startItem + itemCount <= DatasetItemCount);
 		cache->datasetInit(cache, dataset->memory + startItem * randomx::CacheLineSize, startItem, startItem + itemCount);
+		RANDOMX_TRACE2(dataset_chunk, startItem, startItem + itemCount);
+		randomx::copyDatasetReplicas(dataset, startItem * randomx::CacheLineSize, itemCount * randomx::CacheLineSize, false);
 	}
 
-	void *randomx_get_dataset_memory(randomx_dataset *dataset) {
+	int randomx_init_dataset_progress(randomx_dataset *dataset, randomx_cache *cache, unsigned long startItem, unsigned long itemCount, randomx_progress_callback *progress, void *userData, randomx_cancel_token *cancel) {
 		assert(dataset != nullptr);
-		return dataset->memory;
+		assert(cache != nullptr);
+		assert(!cache->isDrained());
+		assert(startItem < DatasetItemCount && itemCount <= DatasetItemCount);
+		assert(startItem + itemCount <= DatasetItemCount);
+		randomx::InitProgress control = { progress, userData, cancel };
+		unsigned long done = 0;
+		while (done < itemCount) {
+			if (control.isCancelled())
+				return 0;
+			unsigned long count = std::min(itemCount - done, (unsigned long)randomx::DatasetInitChunkSize);
+			randomx_init_dataset(dataset, cache, startItem + done, count);
+			done += count;
+			control.report(done, itemCount);
+		}
+		return 1;
 	}
 
-	void randomx_release_dataset(randomx_dataset *dataset) {
+	int randomx_init_dataset_backend(randomx_dataset *dataset, randomx_cache *cache, const randomx_dataset_backend *backend, unsigned long startItem, unsigned long itemCount) {
 		assert(dataset != nullptr);
-		dataset->dealloc(dataset);
-		delete dataset;
+		assert(cache != nullptr && cache->isInitialized());
+		assert(!cache->isDrained());
+		assert(backend != nullptr && backend->initItems != nullptr);
+		assert(startItem < DatasetItemCount && itemCount <= DatasetItemCount);
+		assert(startItem + itemCount <= DatasetItemCount);
+		randomx_dataset_init_context context;
+		randomx::getDatasetInitContext(cache, &context);
+		if (!backend->initItems(backend->userData, &context, dataset->memory + startItem * randomx::CacheLineSize, startItem, itemCount)) {
+			randomx_init_dataset(dataset, cache, startItem, itemCount);
+			return 0;
+		}
+		randomx::copyDatasetReplicas(dataset, startItem * randomx::CacheLineSize, itemCount * randomx::CacheLineSize, false);
+		return 1;
 	}
 
-	randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset) {
-		assert(cache != nullptr || (flags & RANDOMX_FLAG_FULL_MEM));
-		assert(cache == nullptr || cache->isInitialized());
-		assert(dataset != nullptr || !(flags & RANDOMX_FLAG_FULL_MEM));
-
-		randomx_vm *vm = nullptr;
+	randomx_cancel_token *randomx_create_cancel_token() {
+		randomx_cancel_token *token = nullptr;
 
 		try {
-			switch ((int)(flags & (RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES))) {
-				case RANDOMX_FLAG_DEFAULT:
-					vm = new randomx::InterpretedLightVmDefault();
-					break;
-
-				case RANDOMX_FLAG_FULL_MEM:
-					vm = new randomx::InterpretedVmDefault();
-					break;
+			token = new randomx_cancel_token();
+		}
+		catch (std::exception &ex) {
+			token = nullptr;
+		}
 
-				case RANDOMX_FLAG_JIT:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmDefaultSecure();
-					}
-					else {
-						vm = new randomx::CompiledLightVmDefault();
-					}
-					break;
+		return token;
+	}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmDefaultSecure();
-					}
-					else {
-						vm = new randomx::CompiledVmDefault();
-					}
-					break;
+	void randomx_cancel(randomx_cancel_token *token) {
+		assert(token != nullptr);
+		token->cancelled.store(true);
+	}
 
-				case RANDOMX_FLAG_HARD_AES:
-					vm = new randomx::InterpretedLightVmHardAes();
-					break;
+	void randomx_destroy_cancel_token(randomx_cancel_token *token) {
+		delete token;
+	}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES:
-					vm = new randomx::InterpretedVmHardAes();
-					break;
+	void randomx_init_dataset_parallel(randomx_dataset *dataset, randomx_cache *cache, unsigned threadCount, uint64_t affinityMask) {
+		assert(dataset != nullptr);
+		assert(cache != nullptr);
+		assert(!cache->isDrained());
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+		randomx::initDatasetParallel(cache, dataset->memory, 0, DatasetItemCount, threadCount, affinityMask);
+		randomx::copyDatasetReplicas(dataset, 0, randomx::DatasetSize, true);
+	}
 
-				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmHardAesSecure();
-					}
-					else {
-						vm = new randomx::CompiledLightVmHardAes();
-					}
-					break;
+	void randomx_init_dataset_placed(randomx_dataset *dataset, randomx_cache *cache, randomx_placement policy, unsigned threadCount) {
+		assert(dataset != nullptr);
+		assert(cache != nullptr);
+		assert(!cache->isDrained());
+		if (policy == RANDOMX_PLACEMENT_NONE) {
+			randomx_init_dataset_parallel(dataset, cache, threadCount, 0);
+			return;
+		}
+		auto cpus = randomx::placeThreads(randomx::getCpuTopology(), policy, threadCount);
+		randomx::initDatasetParallel(cache, dataset->memory, 0, DatasetItemCount, cpus);
+		randomx::copyDatasetReplicas(dataset, 0, randomx::DatasetSize, true);
+	}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmHardAesSecure();
-					}
-					else {
-						vm = new randomx::CompiledVmHardAes();
-					}
-					break;
+	int randomx_dataset_save(randomx_dataset *dataset, const void *key, size_t keySize, const char *path) {
+		assert(dataset != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		assert(path != nullptr);
+		return randomx::saveDatasetFile(dataset->memory, key, keySize, path) ? 1 : 0;
+	}
 
-				case RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedLightVmLargePage();
-					break;
+	int randomx_dataset_import_chunk(randomx_dataset *dataset, uint64_t offset, const void *data, size_t size) {
+		assert(dataset != nullptr);
+		assert(size == 0 || data != nullptr);
+		if (offset > randomx::DatasetSize || size > randomx::DatasetSize - offset) {
+			return 0;
+		}
+		memcpy(dataset->memory + offset, data, size);
+		randomx::copyDatasetReplicas(dataset, offset, size, false);
+		return 1;
+	}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedVmLargePage();
-					break;
+	int randomx_dataset_verify(randomx_dataset *dataset, randomx_cache *cache, uint64_t sampleCount, const void *seed, size_t seedSize) {
+		assert(dataset != nullptr);
+		assert(cache != nullptr && cache->isInitialized());
+		assert(!cache->isDrained());
+		assert(seedSize == 0 || seed != nullptr);
+		return randomx::verifyDatasetSample(cache, dataset->memory, sampleCount, seed, seedSize) ? 1 : 0;
+	}
 
-				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmLargePageSecure();
-					}
-					else {
-						vm = new randomx::CompiledLightVmLargePage();
-					}
-					break;
+	static randomx_dataset *allocMappedDataset(uint8_t* (*map)(const char*, const void*, size_t), const char *name, const void *key, size_t keySize) {
+		//fail on 32-bit systems if DatasetSize is >= 4 GiB
+		if (randomx::DatasetSize > std::numeric_limits<size_t>::max()) {
+			return nullptr;
+		}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmLargePageSecure();
-					}
-					else {
-						vm = new randomx::CompiledVmLargePage();
-					}
-					break;
+		randomx_dataset *dataset = nullptr;
 
-				case RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedLightVmLargePageHardAes();
-					break;
+		try {
+			dataset = new randomx_dataset();
+			dataset->pageSize = getPageSize();
+			dataset->dealloc = &randomx::deallocMappedDataset;
+			dataset->memory = map(name, key, keySize);
+		}
+		catch (std::exception &ex) {
+			if (dataset != nullptr) {
+				randomx_release_dataset(dataset);
+				dataset = nullptr;
+			}
+		}
+		if (dataset && dataset->memory == nullptr) {
+			randomx_release_dataset(dataset);
+			dataset = nullptr;
+		}
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
-					vm = new randomx::InterpretedVmLargePageHardAes();
-					break;
+		return dataset;
+	}
+
+	randomx_dataset *randomx_dataset_map(const char *path, const void *key, size_t keySize) {
+		assert(path != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		return allocMappedDataset(&randomx::mapDatasetFile, path, key, keySize);
+	}
+
+	static uint8_t *createSharedDataset(const char *name, const void *, size_t) {
+		return randomx::createSharedDataset(name);
+	}
+
+	randomx_dataset *randomx_dataset_create_shared(const char *name) {
+		assert(name != nullptr);
+		return allocMappedDataset(&createSharedDataset, name, nullptr, 0);
+	}
+
+	void randomx_dataset_publish_shared(randomx_dataset *dataset, const void *key, size_t keySize) {
+		assert(dataset != nullptr);
+		assert(dataset->dealloc == &randomx::deallocMappedDataset);
+		assert(keySize == 0 || key != nullptr);
+		randomx::publishSharedDataset(dataset->memory, key, keySize);
+	}
+
+	randomx_dataset *randomx_dataset_attach_shared(const char *name, const void *key, size_t keySize) {
+		assert(name != nullptr);
+		assert(keySize == 0 || key != nullptr);
+		return allocMappedDataset(&randomx::attachSharedDataset, name, key, keySize);
+	}
+
+	uint32_t randomx_dataset_shared_generation(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		assert(dataset->dealloc == &randomx::deallocMappedDataset);
+		return randomx::getSharedDatasetGeneration(dataset->memory);
+	}
+
+	int randomx_dataset_remove_shared(const char *name) {
+		assert(name != nullptr);
+		return removeSharedMemory(name);
+	}
+
+	void *randomx_get_dataset_memory(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		return dataset->memory;
+	}
+
+	size_t randomx_dataset_page_size(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		return dataset->pageSize;
+	}
+
+	randomx_large_pages_result randomx_large_pages_status(int *systemError) {
+		return (randomx_large_pages_result)getLargePagesStatus(systemError);
+	}
+
+	randomx_page_backing randomx_dataset_page_backing(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		return dataset->pageBacking;
+	}
+
+	double randomx_dataset_prefault_time(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		return dataset->prefaultTime;
+	}
+
+	randomx_page_backing randomx_cache_page_backing(randomx_cache *cache) {
+		assert(cache != nullptr);
+		return cache->pageBacking;
+	}
+
+	randomx_page_backing randomx_vm_page_backing(randomx_vm *machine) {
+		assert(machine != nullptr);
+		return machine->pageBacking;
+	}
+
+	static size_t backingPageSize(randomx_page_backing backing) {
+		switch (backing) {
+			case RANDOMX_PAGES_LARGE:
+			case RANDOMX_PAGES_TRANSPARENT:
+				return getLargePageSize();
+			case RANDOMX_PAGES_1GB:
+				return (size_t)1 << 30;
+			default:
+				return getPageSize();
+		}
+	}
+
+	void randomx_get_memory_info(randomx_cache *cache, randomx_dataset *dataset, randomx_vm *machine, randomx_memory_info *info) {
+		assert(info != nullptr);
+		*info = {};
+		info->cachePageSize = info->datasetPageSize = info->scratchpadPageSize = getPageSize();
+		info->numaNode = -1;
+		if (cache != nullptr) {
+			info->cacheBytes = cache->isDrained() ? 0 : randomx::CacheSize;
+			info->cacheBacking = cache->pageBacking;
+			info->cachePageSize = backingPageSize(cache->pageBacking);
+			if (cache->jit != nullptr)
+				info->jitCodeBytes += cache->jit->getCodeSize();
+			if (cache->itemCache != nullptr)
+				info->itemTableBytes += cache->itemCache->getSize();
+			if (cache->resultCache != nullptr)
+				info->resultTableBytes = cache->resultCache->getSize();
+		}
+		if (dataset != nullptr) {
+			info->datasetCopies = std::max(dataset->replicaCount, 1u);
+			info->datasetBytes = randomx::DatasetSize * info->datasetCopies;
+			info->datasetBacking = dataset->pageBacking;
+			info->datasetPageSize = dataset->pageSize;
+		}
+		if (machine != nullptr) {
+			info->scratchpadBytes = randomx::ScratchpadSize * machine->getLaneCount();
+			info->scratchpadBacking = machine->pageBacking;
+			info->scratchpadPageSize = backingPageSize(machine->pageBacking);
+			info->jitCodeBytes += machine->getCodeSize();
+			info->itemTableBytes += machine->getItemTableSize();
+			info->numaNode = machine->numaNode;
+		}
+	}
+
+	void randomx_plan_memory_mode(uint64_t hashesPerKey, unsigned vmCount, size_t memoryLimit, randomx_memory_plan *plan) {
+		assert(plan != nullptr);
+		constexpr uint64_t itemsPerHash = (uint64_t)RANDOMX_PROGRAM_COUNT * RANDOMX_PROGRAM_ITERATIONS;
+		constexpr uint64_t minItemTable = 16 * 1024 * 1024;
+		constexpr uint64_t itemEntrySize = randomx::CacheLineSize + sizeof(uint32_t); //see InterpretedLazyVm
+		vmCount = std::max(vmCount, 1u);
+		if (memoryLimit == 0) {
+			memoryLimit = getAvailableMemory();
+			if (memoryLimit == 0)
+				memoryLimit = std::numeric_limits<size_t>::max();
+		}
+		*plan = {};
+		plan->flags = randomx_get_flags();
+		plan->initThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		const uint64_t lightMemory = randomx::CacheSize + (uint64_t)vmCount * randomx::ScratchpadSize;
+		//the cache is still needed while the dataset is built
+		const uint64_t fullMemory = randomx::DatasetSize + lightMemory;
+		const uint64_t lightItems = hashesPerKey > std::numeric_limits<uint64_t>::max() / itemsPerHash ? std::numeric_limits<uint64_t>::max() : hashesPerKey * itemsPerHash;
+		if (fullMemory <= memoryLimit && lightItems >= DatasetItemCount) {
+			plan->mode = RANDOMX_MODE_FULL;
+			plan->flags = (randomx_flags)(plan->flags | RANDOMX_FLAG_FULL_MEM);
+			plan->memoryBytes = (size_t)fullMemory;
+			plan->itemsPerKey = DatasetItemCount;
+		}
+		else if (!(plan->flags & RANDOMX_FLAG_JIT) && lightMemory + vmCount * minItemTable <= memoryLimit) {
+			//the table of a lazy virtual machine holds a power of 2 number of items
+			const uint64_t budget = (memoryLimit - lightMemory) / vmCount;
+			uint64_t items = 1;
+			while (2 * items * itemEntrySize <= budget && 2 * items <= DatasetItemCount)
+				items *= 2;
+			plan->mode = RANDOMX_MODE_LAZY;
+			plan->itemTableBytes = (size_t)(items * randomx::CacheLineSize);
+			plan->memoryBytes = (size_t)(lightMemory + vmCount * items * itemEntrySize);
+			//reads of uniformly distributed items hit a warm table with a probability of items / DatasetItemCount
+			plan->itemsPerKey = std::min(lightItems, (uint64_t)(lightItems * (1.0 - (double)items / DatasetItemCount)) + vmCount * items);
+		}
+		else {
+			plan->mode = RANDOMX_MODE_LIGHT;
+			plan->memoryBytes = (size_t)lightMemory;
+			plan->itemsPerKey = lightItems;
+		}
+		if (getFreeLargePagesMemory() >= plan->memoryBytes) {
+			plan->flags = (randomx_flags)(plan->flags | RANDOMX_FLAG_LARGE_PAGES);
+		}
+	}
+
+	int randomx_plan_init(const randomx_memory_plan *plan, const void *key, size_t keySize, randomx_cache **cache, randomx_dataset **dataset) {
+		assert(plan != nullptr);
+		assert(cache != nullptr && dataset != nullptr);
+		*dataset = nullptr;
+		*cache = randomx_alloc_cache(plan->flags);
+		if (*cache == nullptr) {
+			return 0;
+		}
+		if (plan->mode == RANDOMX_MODE_FULL) {
+			*dataset = randomx_alloc_dataset(plan->flags);
+			if (*dataset == nullptr) {
+				randomx_release_cache(*cache);
+				*cache = nullptr;
+				return 0;
+			}
+		}
+		randomx_init_cache_parallel(*cache, key, keySize, plan->initThreads);
+		if (*dataset != nullptr) {
+			randomx_init_dataset_parallel(*dataset, *cache, plan->initThreads, 0);
+			randomx_cache_drain(*cache);
+		}
+		return 1;
+	}
+
+	randomx_vm *randomx_plan_create_vm(const randomx_memory_plan *plan, randomx_cache *cache, randomx_dataset *dataset) {
+		assert(plan != nullptr);
+		if (plan->mode == RANDOMX_MODE_LAZY) {
+			return randomx_create_vm_lazy(plan->flags, cache, plan->itemTableBytes);
+		}
+		return randomx_create_vm(plan->flags, cache, dataset);
+	}
+
+	int randomx_autotune(randomx_cache *cache, randomx_dataset *dataset, unsigned hashCount, const char *path, randomx_tuning *tuning) {
+		assert(dataset != nullptr || (cache != nullptr && cache->isInitialized()));
+		assert(tuning != nullptr);
+		return randomx::autotune(cache, dataset, hashCount, path, tuning) ? 1 : 0;
+	}
+
+	void randomx_release_dataset(randomx_dataset *dataset) {
+		assert(dataset != nullptr);
+		for (unsigned node = 1; node < dataset->replicaCount; ++node) {
+			randomx_release_dataset(dataset->replicas[node]);
+		}
+		dataset->dealloc(dataset);
+		delete dataset;
+	}
+
+	//VAES replaces the 128-bit AES instructions, so it requires RANDOMX_FLAG_HARD_AES
+	static bool isVaesSupported(randomx_flags flags) {
+		return (flags & RANDOMX_FLAG_HARD_AES) && aesVaesCompiled() && randomx::Cpu().hasVaes();
+	}
+
+	static void enableVaes(randomx_vm *vm) {
+		for (int i = 0; i < vm->getLaneCount(); ++i) {
+			vm->getLane(i)->vaes = true;
+		}
+	}
+
+	//the vector permute AES replaces the table-based software AES, so it excludes RANDOMX_FLAG_HARD_AES
+	static bool isAesVpermSupported(randomx_flags flags) {
+#if defined(__aarch64__)
+		return !(flags & RANDOMX_FLAG_HARD_AES) && aesVpermCompiled();
+#else
+		return !(flags & RANDOMX_FLAG_HARD_AES) && aesVpermCompiled() && randomx::Cpu().hasSsse3();
+#endif
+	}
+
+	static void enableAesVperm(randomx_vm *vm) {
+		for (int i = 0; i < vm->getLaneCount(); ++i) {
+			vm->getLane(i)->aesVperm = true;
+		}
+	}
+
+	static void enablePrefetchMode(randomx_vm *vm, randomx_flags flags) {
+		if (flags & (RANDOMX_FLAG_PREFETCH_T0 | RANDOMX_FLAG_PREFETCH_SCRATCHPAD)) {
+			vm->setPrefetchMode((flags & RANDOMX_FLAG_PREFETCH_T0) != 0, (flags & RANDOMX_FLAG_PREFETCH_SCRATCHPAD) != 0);
+		}
+		if (flags & RANDOMX_FLAG_JIT_SCHEDULE) {
+			vm->setScheduling(true);
+		}
+	}
+
+	static randomx_vm *createVm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, randomx_scratchpad_arena *arena) {
+		assert(cache != nullptr || (flags & RANDOMX_FLAG_FULL_MEM));
+		assert(cache == nullptr || cache->isInitialized());
+		assert(dataset != nullptr || !(flags & RANDOMX_FLAG_FULL_MEM));
+
+		//light mode reads the cache memory
+		if (!(flags & RANDOMX_FLAG_FULL_MEM) && cache->isDrained()) {
+			return nullptr;
+		}
+
+		if ((flags & RANDOMX_FLAG_VAES) && !isVaesSupported(flags)) {
+			return nullptr;
+		}
+
+		if ((flags & RANDOMX_FLAG_AES_VPERM) && !isAesVpermSupported(flags)) {
+			return nullptr;
+		}
+
+		randomx_vm *vm = nullptr;
+		void *storage = nullptr;
+		int slot = -1;
+
+		if (arena != nullptr) {
+			slot = arena->acquire();
+			if (slot < 0) {
+				return nullptr;
+			}
+			storage = arena->getVmStorage(slot);
+		}
+
+		try {
+			switch ((int)(flags & (RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES))) {
+				case RANDOMX_FLAG_DEFAULT:
+					vm = newVm<randomx::InterpretedLightVmDefault>(storage);
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM:
+					vm = newVm<randomx::InterpretedVmDefault>(storage);
+					break;
+
+				case RANDOMX_FLAG_JIT:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledLightVmDefaultSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledLightVmDefault>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledVmDefaultSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledVmDefault>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_HARD_AES:
+					vm = newVm<randomx::InterpretedLightVmHardAes>(storage);
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES:
+					vm = newVm<randomx::InterpretedVmHardAes>(storage);
+					break;
+
+				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledLightVmHardAesSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledLightVmHardAes>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledVmHardAesSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledVmHardAes>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_LARGE_PAGES:
+					vm = newVm<randomx::InterpretedLightVmLargePage>(storage);
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_LARGE_PAGES:
+					vm = newVm<randomx::InterpretedVmLargePage>(storage);
+					break;
+
+				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledLightVmLargePageSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledLightVmLargePage>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledVmLargePageSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledVmLargePage>(storage);
+					}
+					break;
+
+				case RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					vm = newVm<randomx::InterpretedLightVmLargePageHardAes>(storage);
+					break;
+
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					vm = newVm<randomx::InterpretedVmLargePageHardAes>(storage);
+					break;
 
 				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
 					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledLightVmLargePageHardAesSecure();
+						vm = newVm<randomx::CompiledLightVmLargePageHardAesSecure>(storage);
 					}
 					else {
-						vm = new randomx::CompiledLightVmLargePageHardAes();
+						vm = newVm<randomx::CompiledLightVmLargePageHardAes>(storage);
 					}
 					break;
 
-				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
-					if (flags & RANDOMX_FLAG_SECURE) {
-						vm = new randomx::CompiledVmLargePageHardAesSecure();
-					}
-					else {
-						vm = new randomx::CompiledVmLargePageHardAes();
-					}
-					break;
+				case RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = newVm<randomx::CompiledVmLargePageHardAesSecure>(storage);
+					}
+					else {
+						vm = newVm<randomx::CompiledVmLargePageHardAes>(storage);
+					}
+					break;
+
+				default:
+					UNREACHABLE;
+			}
+
+			if (arena != nullptr) {
+				vm->arena = arena;
+				vm->arenaSlot = slot;
+			}
+
+			if(cache != nullptr) {
+				vm->setCache(cache);
+				vm->cacheKey = cache->cacheKey;
+				if (!(flags & RANDOMX_FLAG_FULL_MEM))
+					vm->lightCache = cache;
+			}
+
+			if(dataset != nullptr)
+				vm->setDataset(dataset);
+
+			if (flags & RANDOMX_FLAG_VAES) {
+				enableVaes(vm);
+			}
+
+			if (flags & RANDOMX_FLAG_AES_VPERM) {
+				enableAesVperm(vm);
+			}
+
+			enablePrefetchMode(vm, flags);
+
+			if (flags & RANDOMX_FLAG_JIT_SHARED_CODE) {
+				vm->enableSharedCode();
+			}
+
+			vm->allocate();
+		}
+		catch (std::exception &ex) {
+			if (vm != nullptr) {
+				deleteVm(vm);
+			}
+			else if (arena != nullptr) {
+				arena->release(slot);
+			}
+			vm = nullptr;
+		}
+
+		RANDOMX_TRACE2(vm_create, vm, (int)flags);
+		return vm;
+	}
+
+	randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset) {
+		return createVm(flags, cache, dataset, nullptr);
+	}
+
+	randomx_scratchpad_arena *randomx_alloc_scratchpad_arena(unsigned count, randomx_flags flags) {
+		return randomx_alloc_scratchpad_arena_layout(count, flags, RANDOMX_ARENA_PACKED);
+	}
+
+	randomx_scratchpad_arena *randomx_alloc_scratchpad_arena_layout(unsigned count, randomx_flags flags, randomx_arena_layout layout) {
+		randomx_scratchpad_arena *arena = nullptr;
+
+		try {
+			arena = new randomx_scratchpad_arena(count, (flags & RANDOMX_FLAG_LARGE_PAGES) != 0, layout == RANDOMX_ARENA_STAGGERED);
+		}
+		catch (std::exception &ex) {
+			arena = nullptr;
+		}
+
+		return arena;
+	}
+
+	randomx_vm *randomx_create_vm_arena(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, randomx_scratchpad_arena *arena) {
+		assert(arena != nullptr);
+		return createVm(flags, cache, dataset, arena);
+	}
+
+	void randomx_release_scratchpad_arena(randomx_scratchpad_arena *arena) {
+		assert(arena != nullptr);
+		delete arena;
+	}
+
+	randomx_vm *randomx_create_vm_on_node(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned node) {
+		if (node >= randomx::getNumaNodeCount()) {
+			return nullptr;
+		}
+
+		if (dataset != nullptr) {
+			dataset = randomx::getDatasetReplica(dataset, node);
+		}
+
+		randomx_vm *vm;
+		{
+			AllocationNodeScope nodeScope(randomx::getNumaNodeId(node));
+			vm = randomx_create_vm(flags, cache, dataset);
+		}
+
+		if (vm != nullptr) {
+			vm->numaNode = node;
+			bindMemoryToNode((void*)vm->getScratchpad(), randomx::ScratchpadSize, randomx::getNumaNodeId(node));
+		}
+
+		return vm;
+	}
+
+	randomx_vm *randomx_create_vm_lazy(randomx_flags flags, randomx_cache *cache, size_t itemCacheSize) {
+		assert(cache != nullptr && cache->isInitialized());
+
+		if (itemCacheSize < RANDOMX_DATASET_ITEM_SIZE || (flags & (RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT)) || cache->isDrained()) {
+			return nullptr;
+		}
+
+		if ((flags & RANDOMX_FLAG_VAES) && !isVaesSupported(flags)) {
+			return nullptr;
+		}
+
+		if ((flags & RANDOMX_FLAG_AES_VPERM) && !isAesVpermSupported(flags)) {
+			return nullptr;
+		}
+
+		randomx_vm *vm = nullptr;
+
+		try {
+			switch ((int)(flags & (RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES))) {
+				case RANDOMX_FLAG_DEFAULT:
+					vm = new randomx::InterpretedLazyVmDefault(itemCacheSize);
+					break;
+
+				case RANDOMX_FLAG_HARD_AES:
+					vm = new randomx::InterpretedLazyVmHardAes(itemCacheSize);
+					break;
+
+				case RANDOMX_FLAG_LARGE_PAGES:
+					vm = new randomx::InterpretedLazyVmLargePage(itemCacheSize);
+					break;
+
+				case RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					vm = new randomx::InterpretedLazyVmLargePageHardAes(itemCacheSize);
+					break;
+
+				default:
+					UNREACHABLE;
+			}
+
+			vm->setCache(cache);
+			vm->cacheKey = cache->cacheKey;
+			vm->lightCache = cache;
+
+			if (flags & RANDOMX_FLAG_VAES) {
+				enableVaes(vm);
+			}
+
+			if (flags & RANDOMX_FLAG_AES_VPERM) {
+				enableAesVperm(vm);
+			}
+
+			vm->allocate();
+		}
+		catch (std::exception &ex) {
+			delete vm;
+			vm = nullptr;
+		}
+
+		RANDOMX_TRACE2(vm_create, vm, (int)flags);
+		return vm;
+	}
+
+	randomx_vm *randomx_create_vm_interleaved(randomx_flags flags, randomx_dataset *dataset, unsigned lanes) {
+		assert(dataset != nullptr);
+
+		randomx_vm *vm = nullptr;
+
+		if (lanes < 2 || lanes > (unsigned)randomx::MaxInterleavedLanes) {
+			return nullptr;
+		}
+		if (!(flags & RANDOMX_FLAG_FULL_MEM)) {
+			return nullptr;
+		}
+#if !defined(RANDOMX_COMPILER_X86)
+		if (flags & RANDOMX_FLAG_JIT) {
+			return nullptr;
+		}
+#endif
+
+		if ((flags & RANDOMX_FLAG_VAES) && !isVaesSupported(flags)) {
+			return nullptr;
+		}
+
+		if ((flags & RANDOMX_FLAG_AES_VPERM) && !isAesVpermSupported(flags)) {
+			return nullptr;
+		}
+
+		try {
+			switch ((int)(flags & (RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES))) {
+				case RANDOMX_FLAG_DEFAULT:
+					vm = new randomx::InterpretedInterleavedVmDefault(lanes);
+					break;
+
+				case RANDOMX_FLAG_HARD_AES:
+					vm = new randomx::InterpretedInterleavedVmHardAes(lanes);
+					break;
+
+				case RANDOMX_FLAG_LARGE_PAGES:
+					vm = new randomx::InterpretedInterleavedVmLargePage(lanes);
+					break;
+
+				case RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					vm = new randomx::InterpretedInterleavedVmLargePageHardAes(lanes);
+					break;
+
+#if defined(RANDOMX_COMPILER_X86)
+				case RANDOMX_FLAG_JIT:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = new randomx::CompiledInterleavedVmDefaultSecure(lanes);
+					}
+					else {
+						vm = new randomx::CompiledInterleavedVmDefault(lanes);
+					}
+					break;
+
+				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = new randomx::CompiledInterleavedVmHardAesSecure(lanes);
+					}
+					else {
+						vm = new randomx::CompiledInterleavedVmHardAes(lanes);
+					}
+					break;
+
+				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_LARGE_PAGES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = new randomx::CompiledInterleavedVmLargePageSecure(lanes);
+					}
+					else {
+						vm = new randomx::CompiledInterleavedVmLargePage(lanes);
+					}
+					break;
+
+				case RANDOMX_FLAG_JIT | RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_LARGE_PAGES:
+					if (flags & RANDOMX_FLAG_SECURE) {
+						vm = new randomx::CompiledInterleavedVmLargePageHardAesSecure(lanes);
+					}
+					else {
+						vm = new randomx::CompiledInterleavedVmLargePageHardAes(lanes);
+					}
+					break;
+#endif
+
+				default:
+					UNREACHABLE;
+			}
+
+			vm->setDataset(dataset);
+
+			if (flags & RANDOMX_FLAG_VAES) {
+				enableVaes(vm);
+			}
+
+			if (flags & RANDOMX_FLAG_AES_VPERM) {
+				enableAesVperm(vm);
+			}
+
+			enablePrefetchMode(vm, flags);
+
+			if (flags & RANDOMX_FLAG_JIT_SHARED_CODE) {
+				vm->enableSharedCode();
+			}
+
+			vm->allocate();
+		}
+		catch (std::exception &ex) {
+			delete vm;
+			vm = nullptr;
+		}
+
+		RANDOMX_TRACE2(vm_create, vm, (int)flags);
+		return vm;
+	}
+
+	void randomx_vm_set_cache(randomx_vm *machine, randomx_cache* cache) {
+		assert(machine != nullptr);
+		assert(cache != nullptr && cache->isInitialized());
+		if (machine->cacheKey != cache->cacheKey || machine->getMemory() != cache->memory) {
+			machine->setCache(cache);
+			machine->cacheKey = cache->cacheKey;
+		}
+		if (machine->lightCache != nullptr)
+			machine->lightCache = cache;
+	}
+
+	int randomx_vm_enable_item_helper(randomx_vm *machine, int cpu) {
+		assert(machine != nullptr);
+		return machine->enableItemHelper(cpu) ? 1 : 0;
+	}
+
+	void randomx_vm_set_dataset(randomx_vm *machine, randomx_dataset *dataset) {
+		assert(machine != nullptr);
+		assert(dataset != nullptr);
+		machine->setDataset(randomx::getDatasetReplica(dataset, machine->numaNode));
+	}
+
+	randomx_epoch *randomx_create_epoch(randomx_flags flags, unsigned threadCount) {
+		randomx_epoch *epoch = nullptr;
+
+		try {
+			epoch = new randomx_epoch(flags, threadCount);
+		}
+		catch (std::exception &ex) {
+			epoch = nullptr;
+		}
+
+		return epoch;
+	}
+
+	int randomx_epoch_prepare(randomx_epoch *epoch, const void *key, size_t keySize) {
+		assert(epoch != nullptr);
+		assert(key != nullptr || keySize == 0);
+		return epoch->prepare(key, keySize) ? 1 : 0;
+	}
+
+	int randomx_epoch_switch(randomx_epoch *epoch, int wait) {
+		assert(epoch != nullptr);
+		return epoch->switchNext(wait != 0) ? 1 : 0;
+	}
+
+	randomx_cache *randomx_epoch_cache(randomx_epoch *epoch) {
+		assert(epoch != nullptr);
+		return epoch->getCache();
+	}
+
+	randomx_dataset *randomx_epoch_dataset(randomx_epoch *epoch) {
+		assert(epoch != nullptr);
+		return epoch->getDataset();
+	}
+
+	void randomx_epoch_sync_vm(randomx_epoch *epoch, randomx_vm *machine) {
+		assert(epoch != nullptr);
+		assert(machine != nullptr);
+		assert(epoch->getGeneration() != 0);
+		epoch->syncVm(machine);
+	}
+
+	void randomx_epoch_detach_vm(randomx_epoch *epoch, randomx_vm *machine) {
+		assert(epoch != nullptr);
+		assert(machine != nullptr);
+		epoch->detachVm(machine);
+	}
+
+	void randomx_release_epoch(randomx_epoch *epoch) {
+		assert(epoch != nullptr);
+		delete epoch;
+	}
+
+	randomx_verifier *randomx_create_verifier(randomx_flags flags, unsigned cacheCount, unsigned vmsPerCache) {
+		if (cacheCount == 0 || vmsPerCache == 0) {
+			return nullptr;
+		}
+
+		randomx_verifier *verifier = nullptr;
+
+		try {
+			verifier = new randomx_verifier(flags, cacheCount, vmsPerCache);
+		}
+		catch (std::exception &ex) {
+			verifier = nullptr;
+		}
+
+		return verifier;
+	}
+
+	int randomx_verifier_prepare_key(randomx_verifier *verifier, const void *key, size_t keySize) {
+		assert(verifier != nullptr);
+		assert(key != nullptr || keySize == 0);
+		return verifier->prepareKey(key, keySize) ? 1 : 0;
+	}
+
+	int randomx_verifier_calculate_hash(randomx_verifier *verifier, const void *key, size_t keySize, const void *input, size_t inputSize, void *output) {
+		assert(verifier != nullptr);
+		assert(key != nullptr || keySize == 0);
+		assert(inputSize == 0 || input != nullptr);
+		assert(output != nullptr);
+		return verifier->calculateHash(key, keySize, input, inputSize, output) ? 1 : 0;
+	}
+
+	void randomx_release_verifier(randomx_verifier *verifier) {
+		assert(verifier != nullptr);
+		delete verifier;
+	}
+
+	randomx_vm_pool *randomx_vm_pool_create(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned count) {
+		if (count == 0) {
+			return nullptr;
+		}
+
+		randomx_vm_pool *pool = nullptr;
+
+		try {
+			pool = new randomx_vm_pool(flags, cache, dataset, count);
+		}
+		catch (std::exception &ex) {
+			pool = nullptr;
+		}
+
+		return pool;
+	}
+
+	randomx_vm *randomx_vm_pool_acquire(randomx_vm_pool *pool, int wait) {
+		assert(pool != nullptr);
+		return pool->acquire(wait != 0);
+	}
+
+	void randomx_vm_pool_release(randomx_vm_pool *pool, randomx_vm *machine) {
+		assert(pool != nullptr);
+		assert(machine != nullptr);
+		pool->release(machine);
+	}
+
+	void randomx_vm_pool_set_cache(randomx_vm_pool *pool, randomx_cache *cache) {
+		assert(pool != nullptr);
+		assert(cache != nullptr && cache->isInitialized());
+		pool->setCache(cache);
+	}
+
+	void randomx_vm_pool_set_dataset(randomx_vm_pool *pool, randomx_dataset *dataset) {
+		assert(pool != nullptr);
+		assert(dataset != nullptr);
+		pool->setDataset(dataset);
+	}
+
+	void randomx_vm_pool_destroy(randomx_vm_pool *pool) {
+		assert(pool != nullptr);
+		delete pool;
+	}
+
+	randomx_nonce_scheduler *randomx_nonce_scheduler_create(unsigned threadCount, uint32_t batchSize) {
+		if (threadCount == 0 || batchSize == 0) {
+			return nullptr;
+		}
+
+		randomx_nonce_scheduler *scheduler = nullptr;
+
+		try {
+			scheduler = new randomx_nonce_scheduler(threadCount, batchSize);
+		}
+		catch (std::exception &ex) {
+			scheduler = nullptr;
+		}
+
+		return scheduler;
+	}
 
-				default:
-					UNREACHABLE;
-			}
+	void randomx_nonce_scheduler_reset(randomx_nonce_scheduler *scheduler, uint32_t firstNonce, uint32_t nonceCount) {
+		assert(scheduler != nullptr);
+		assert((uint64_t)firstNonce + nonceCount <= UINT32_MAX);
+		scheduler->reset(firstNonce, nonceCount);
+	}
 
-			if(cache != nullptr) {
-				vm->setCache(cache);
-				vm->cacheKey = cache->cacheKey;
-			}
+	void randomx_nonce_scheduler_set_vm(randomx_nonce_scheduler *scheduler, unsigned thread, randomx_vm *machine) {
+		assert(scheduler != nullptr);
+		assert(machine != nullptr);
+		scheduler->setNode(thread, machine->numaNode);
+	}
 
-			if(dataset != nullptr)
-				vm->setDataset(dataset);
+	int randomx_nonce_scheduler_next(randomx_nonce_scheduler *scheduler, unsigned thread, uint32_t *nonce) {
+		assert(scheduler != nullptr);
+		assert(nonce != nullptr);
+		return scheduler->next(thread, *nonce) ? 1 : 0;
+	}
 
-			vm->allocate();
+	void randomx_nonce_scheduler_destroy(randomx_nonce_scheduler *scheduler) {
+		delete scheduler;
+	}
+
+	randomx_engine *randomx_engine_create(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned threadCount) {
+		if (threadCount == 0) {
+			return nullptr;
+		}
+
+		randomx_engine *engine = nullptr;
+
+		try {
+			engine = new randomx_engine(flags, cache, dataset, threadCount);
 		}
 		catch (std::exception &ex) {
-			delete vm;
-			vm = nullptr;
+			engine = nullptr;
 		}
 
-		return vm;
+		return engine;
 	}
 
-	void randomx_vm_set_cache(randomx_vm *machine, randomx_cache* cache) {
-		assert(machine != nullptr);
-		assert(cache != nullptr && cache->isInitialized());
-		if (machine->cacheKey != cache->cacheKey || machine->getMemory() != cache->memory) {
-			machine->setCache(cache);
-			machine->cacheKey = cache->cacheKey;
+	int randomx_engine_submit(randomx_engine *engine, const void *input, size_t inputSize, randomx_hash_callback *callback, void *userData) {
+		assert(engine != nullptr);
+		assert(inputSize == 0 || input != nullptr);
+		assert(callback != nullptr);
+		try {
+			engine->submit(input, inputSize, callback, userData);
+		}
+		catch (std::exception &ex) {
+			return 0;
 		}
+		return 1;
 	}
 
-	void randomx_vm_set_dataset(randomx_vm *machine, randomx_dataset *dataset) {
-		assert(machine != nullptr);
-		assert(dataset != nullptr);
-		machine->setDataset(dataset);
+	int randomx_engine_set_autoscale(randomx_engine *engine, unsigned minThreads, unsigned intervalMs) {
+		assert(engine != nullptr);
+		try {
+			engine->setAutoscale(minThreads, intervalMs);
+		}
+		catch (std::exception &ex) {
+			return 0;
+		}
+		return 1;
+	}
+
+	void randomx_engine_get_stats(randomx_engine *engine, randomx_engine_stats *stats) {
+		assert(engine != nullptr);
+		assert(stats != nullptr);
+		engine->getStats(stats);
+	}
+
+	void randomx_engine_destroy(randomx_engine *engine) {
+		delete engine;
 	}
 
 	void randomx_destroy_vm(randomx_vm *machine) {
 		assert(machine != nullptr);
-		delete machine;
+		RANDOMX_TRACE1(vm_destroy, machine);
+		deleteVm(machine);
 	}
 
-	void randomx_calculate_hash(randomx_vm *machine, const void *input, size_t inputSize, void *output) {
+	int randomx_vm_get_stats(randomx_vm *machine, randomx_vm_stats *stats) {
 		assert(machine != nullptr);
-		assert(inputSize == 0 || input != nullptr);
-		assert(output != nullptr);
-
-#ifdef USE_CSR_INTRINSICS
-		const unsigned int fpstate = _mm_getcsr();
+		assert(stats != nullptr);
+		*stats = machine->stats;
+#ifdef RANDOMX_STATS
+		return 1;
 #else
-		fenv_t fpstate;
-		fegetenv(&fpstate);
+		return 0;
 #endif
+	}
 
-		alignas(16) uint64_t tempHash[8];
-		int blakeResult = blake2b(tempHash, sizeof(tempHash), input, inputSize, nullptr, 0);
-		assert(blakeResult == 0);
+	//absorbs the parts of a scatter-gather input as if they were one contiguous buffer
+	static void hashParts(void *out, const randomx_buffer *parts, size_t count) {
+		blake2b_state state;
+		blake2b_init(&state, 64);
+		for (size_t i = 0; i < count; ++i) {
+			assert(parts[i].size == 0 || parts[i].data != nullptr);
+			blake2b_update(&state, parts[i].data, parts[i].size);
+		}
+		blake2b_final(&state, out, 64);
+	}
+
+	//runs the program chain seeded by tempHash and outputs the final hash
+	static void calculateHash(randomx_vm *machine, uint64_t (&tempHash)[8], void *output) {
+		const rx_float_state fpstate = rx_save_float_state();
+
+		RANDOMX_TRACE1(hash_start, machine);
+		int blakeResult;
 		machine->initScratchpad(&tempHash);
 		machine->resetRoundingMode();
 		for (int chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
 			machine->run(&tempHash);
+			RANDOMX_STATS_PHASE(machine, chain);
 			blakeResult = blake2b(tempHash, sizeof(tempHash), machine->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
 			assert(blakeResult == 0);
 		}
 		machine->run(&tempHash);
 		machine->getFinalResult(output, RANDOMX_HASH_SIZE);
+		RANDOMX_TRACE1(hash_end, machine);
 
-#ifdef USE_CSR_INTRINSICS
-		_mm_setcsr(fpstate);
-#else
-		fesetenv(&fpstate);
-#endif
+		rx_restore_float_state(fpstate);
+	}
+
+	//the input digest seeds the first program, so it also identifies the result
+	static void calculateHashCached(randomx_vm *machine, uint64_t (&tempHash)[8], void *output) {
+		randomx::SharedResultCache* results = machine->lightCache != nullptr ? machine->lightCache->resultCache : nullptr;
+		if (results == nullptr) {
+			calculateHash(machine, tempHash, output);
+			return;
+		}
+		if (results->lookup(tempHash, output)) {
+			machine->stats.resultCacheHits++;
+			return;
+		}
+		alignas(16) uint64_t digest[8];
+		memcpy(digest, tempHash, sizeof(digest));
+		calculateHash(machine, tempHash, output);
+		results->insert(digest, output);
+		machine->stats.resultCacheMisses++;
+	}
+
+	void randomx_calculate_hash(randomx_vm *machine, const void *input, size_t inputSize, void *output) {
+		assert(machine != nullptr);
+		assert(inputSize == 0 || input != nullptr);
+		assert(output != nullptr);
+
+		alignas(16) uint64_t tempHash[8];
+		int blakeResult;
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			blakeResult = blake2b(tempHash, sizeof(tempHash), input, inputSize, nullptr, 0);
+		}
+		assert(blakeResult == 0);
+		calculateHashCached(machine, tempHash, output);
+	}
+
+	void randomx_calculate_hash_parts(randomx_vm *machine, const randomx_buffer *parts, size_t count, void *output) {
+		assert(machine != nullptr);
+		assert(count == 0 || parts != nullptr);
+		assert(output != nullptr);
+
+		alignas(16) uint64_t tempHash[8];
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			hashParts(tempHash, parts, count);
+		}
+		calculateHashCached(machine, tempHash, output);
 	}
 
 	void randomx_calculate_hash_first(randomx_vm* machine, const void* input, size_t inputSize) {
-		blake2b(machine->tempHash, sizeof(machine->tempHash), input, inputSize, nullptr, 0);
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			blake2b(machine->tempHash, sizeof(machine->tempHash), input, inputSize, nullptr, 0);
+		}
 		machine->initScratchpad(machine->tempHash);
 	}
 
-	void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output) {
+	void randomx_calculate_hash_first_parts(randomx_vm* machine, const randomx_buffer* parts, size_t count) {
+		assert(count == 0 || parts != nullptr);
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			hashParts(machine->tempHash, parts, count);
+		}
+		machine->initScratchpad(machine->tempHash);
+	}
+
+	//runs the program chain of the pending hash
+	static void runPrograms(randomx_vm* machine) {
+		RANDOMX_TRACE1(hash_start, machine);
 		machine->resetRoundingMode();
 		for (uint32_t chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
 			machine->run(machine->tempHash);
+			RANDOMX_STATS_PHASE(machine, chain);
 			blake2b(machine->tempHash, sizeof(machine->tempHash), machine->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
 		}
 		machine->run(machine->tempHash);
+	}
+
+	void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output) {
+		runPrograms(machine);
+
+		// Finish current hash and fill the scratchpad for the next hash at the same time.
+		// The first program of the next hash cannot be generated or compiled any earlier:
+		// its seed is the final state of the scratchpad generator, which is only known
+		// when hashAndFill returns.
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			blake2b(machine->tempHash, sizeof(machine->tempHash), nextInput, nextInputSize, nullptr, 0);
+		}
+		machine->hashAndFill(output, RANDOMX_HASH_SIZE, machine->tempHash);
+		RANDOMX_TRACE1(hash_end, machine);
+	}
 
-		// Finish current hash and fill the scratchpad for the next hash at the same time
-		blake2b(machine->tempHash, sizeof(machine->tempHash), nextInput, nextInputSize, nullptr, 0);
+	void randomx_calculate_hash_next_parts(randomx_vm* machine, const randomx_buffer* nextParts, size_t nextCount, void* output) {
+		assert(nextCount == 0 || nextParts != nullptr);
+		runPrograms(machine);
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			hashParts(machine->tempHash, nextParts, nextCount);
+		}
 		machine->hashAndFill(output, RANDOMX_HASH_SIZE, machine->tempHash);
+		RANDOMX_TRACE1(hash_end, machine);
 	}
 
 	void randomx_calculate_hash_last(randomx_vm* machine, void* output) {
+		runPrograms(machine);
+		machine->getFinalResult(output, RANDOMX_HASH_SIZE);
+		RANDOMX_TRACE1(hash_end, machine);
+	}
+
+	static void templateHashFirst(randomx_vm* machine, const randomx_input_template* inputTemplate, uint32_t nonce) {
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			inputTemplate->seed(nonce, machine->tempHash);
+		}
+		machine->initScratchpad(machine->tempHash);
+	}
+
+	static void templateHashNext(randomx_vm* machine, const randomx_input_template* inputTemplate, uint32_t nextNonce, void* output) {
+		runPrograms(machine);
+		{
+			RANDOMX_STATS_PHASE(machine, seed);
+			inputTemplate->seed(nextNonce, machine->tempHash);
+		}
+		machine->hashAndFill(output, RANDOMX_HASH_SIZE, machine->tempHash);
+		RANDOMX_TRACE1(hash_end, machine);
+	}
+
+	void randomx_calculate_hash_batch(randomx_vm* machine, const void* const* inputs, const size_t* inputSizes, size_t count, void* output) {
+		assert(machine != nullptr);
+		assert(count == 0 || (inputs != nullptr && inputSizes != nullptr && output != nullptr));
+
+		if (count == 0) {
+			return;
+		}
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		uint8_t* out = (uint8_t*)output;
+		randomx_calculate_hash_first(machine, inputs[0], inputSizes[0]);
+		for (size_t i = 1; i < count; ++i, out += RANDOMX_HASH_SIZE) {
+			randomx_calculate_hash_next(machine, inputs[i], inputSizes[i], out);
+		}
+		randomx_calculate_hash_last(machine, out);
+
+		rx_restore_float_state(fpstate);
+	}
+
+	//compares a hash with a target, both are 256-bit little-endian numbers
+	static bool hashMeetsTarget(const void *hash, const void *target) {
+		const uint8_t* h = (const uint8_t*)hash;
+		const uint8_t* t = (const uint8_t*)target;
+		for (int i = RANDOMX_HASH_SIZE / sizeof(uint64_t) - 1; i >= 0; --i) {
+			const uint64_t hw = load64(h + i * sizeof(uint64_t));
+			const uint64_t tw = load64(t + i * sizeof(uint64_t));
+			if (hw != tw) {
+				return hw < tw;
+			}
+		}
+		return true;
+	}
+
+	static size_t searchTemplate(randomx_vm *machine, const randomx_input_template *inputTemplate, uint32_t nonceStart, uint32_t count, const void *target, uint32_t *results) {
+		alignas(16) uint64_t hash[RANDOMX_HASH_SIZE / sizeof(uint64_t)];
+		size_t found = 0;
+		templateHashFirst(machine, inputTemplate, nonceStart);
+		for (uint32_t i = 1; i < count; ++i) {
+			templateHashNext(machine, inputTemplate, nonceStart + i, hash);
+			if (hashMeetsTarget(hash, target)) {
+				results[found++] = nonceStart + i - 1;
+			}
+		}
+		randomx_calculate_hash_last(machine, hash);
+		if (hashMeetsTarget(hash, target)) {
+			results[found++] = nonceStart + count - 1;
+		}
+		return found;
+	}
+
+	size_t randomx_search(randomx_vm *machine, void *blockTemplate, size_t size, size_t nonceOffset, uint32_t nonceStart, uint32_t count, const void *target, uint32_t *results) {
+		assert(machine != nullptr);
+		assert(blockTemplate != nullptr);
+		assert(nonceOffset + sizeof(uint32_t) <= size);
+		assert(target != nullptr);
+		assert(count == 0 || results != nullptr);
+
+		if (count == 0) {
+			return 0;
+		}
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		//the bytes before the nonce are only hashed once per search
+		const randomx_input_template inputTemplate(blockTemplate, size, nonceOffset);
+		size_t found = searchTemplate(machine, &inputTemplate, nonceStart, count, target, results);
+		store32((uint8_t*)blockTemplate + nonceOffset, nonceStart + count - 1);
+
+		rx_restore_float_state(fpstate);
+
+		return found;
+	}
+
+	randomx_input_template *randomx_create_input_template(const void *input, size_t size, size_t nonceOffset) {
+		assert(size == 0 || input != nullptr);
+
+		if (nonceOffset + sizeof(uint32_t) > size) {
+			return nullptr;
+		}
+
+		randomx_input_template *inputTemplate = nullptr;
+
+		try {
+			const uint8_t* bytes = (const uint8_t*)input;
+			inputTemplate = new randomx_input_template(std::vector<uint8_t>(bytes, bytes + size), nonceOffset);
+		}
+		catch (std::exception &ex) {
+			inputTemplate = nullptr;
+		}
+
+		return inputTemplate;
+	}
+
+	void randomx_destroy_input_template(randomx_input_template *inputTemplate) {
+		delete inputTemplate;
+	}
+
+	void randomx_calculate_hash_template_batch(randomx_vm *machine, const randomx_input_template *inputTemplate, uint32_t nonceStart, uint32_t count, void *output) {
+		assert(machine != nullptr);
+		assert(inputTemplate != nullptr);
+		assert(count == 0 || output != nullptr);
+
+		if (count == 0) {
+			return;
+		}
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		uint8_t* out = (uint8_t*)output;
+		templateHashFirst(machine, inputTemplate, nonceStart);
+		for (uint32_t i = 1; i < count; ++i, out += RANDOMX_HASH_SIZE) {
+			templateHashNext(machine, inputTemplate, nonceStart + i, out);
+		}
+		randomx_calculate_hash_last(machine, out);
+
+		rx_restore_float_state(fpstate);
+	}
+
+	size_t randomx_search_template(randomx_vm *machine, const randomx_input_template *inputTemplate, uint32_t nonceStart, uint32_t count, const void *target, uint32_t *results) {
+		assert(machine != nullptr);
+		assert(inputTemplate != nullptr);
+		assert(target != nullptr);
+		assert(count == 0 || results != nullptr);
+
+		if (count == 0) {
+			return 0;
+		}
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		size_t found = searchTemplate(machine, inputTemplate, nonceStart, count, target, results);
+
+		rx_restore_float_state(fpstate);
+
+		return found;
+	}
+
+	//hashes the register files of all lanes of an interleaved virtual machine
+	static void hashRegisterFiles(randomx_vm *machine, int laneCount, void *out, size_t outSize) {
+		const void *registerFiles[randomx::MaxInterleavedLanes];
+		for (int i = 0; i < laneCount; ++i) {
+			registerFiles[i] = machine->getLane(i)->getRegisterFile();
+		}
+		randomx::hashMulti(out, outSize, registerFiles, sizeof(randomx::RegisterFile), nullptr, 0, laneCount);
+	}
+
+	void randomx_calculate_hash_interleaved(randomx_vm* machine, const void* const* inputs, const size_t* inputSizes, void* output) {
+		assert(machine != nullptr);
+		assert(inputs != nullptr && inputSizes != nullptr);
+		assert(output != nullptr);
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		const int laneCount = machine->getLaneCount();
+		for (int i = 0; i < laneCount; ++i) {
+			randomx_vm* lane = machine->getLane(i);
+			assert(inputSizes[i] == 0 || inputs[i] != nullptr);
+			int blakeResult;
+			{
+				RANDOMX_STATS_PHASE(lane, seed);
+				blakeResult = blake2b(lane->tempHash, sizeof(lane->tempHash), inputs[i], inputSizes[i], nullptr, 0);
+			}
+			assert(blakeResult == 0);
+			lane->initScratchpad(lane->tempHash);
+		}
 		machine->resetRoundingMode();
 		for (int chain = 0; chain < RANDOMX_PROGRAM_COUNT - 1; ++chain) {
-			machine->run(machine->tempHash);
-			blake2b(machine->tempHash, sizeof(machine->tempHash), machine->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
+			machine->runLanes();
+			RANDOMX_STATS_PHASE(machine, chain);
+			uint64_t tempHashes[randomx::MaxInterleavedLanes][8];
+			hashRegisterFiles(machine, laneCount, tempHashes, sizeof(tempHashes[0]));
+			for (int i = 0; i < laneCount; ++i) {
+				memcpy(machine->getLane(i)->tempHash, tempHashes[i], sizeof(tempHashes[i]));
+			}
 		}
-		machine->run(machine->tempHash);
-		machine->getFinalResult(output, RANDOMX_HASH_SIZE);
+		machine->runLanes();
+		{
+			RANDOMX_STATS_PHASE(machine, finalResult);
+			RANDOMX_STATS_COUNT(machine, hashes, laneCount);
+			for (int i = 0; i < laneCount; ++i) {
+				machine->getLane(i)->hashScratchpad();
+			}
+			hashRegisterFiles(machine, laneCount, output, RANDOMX_HASH_SIZE);
+		}
+
+		rx_restore_float_state(fpstate);
+	}
+
+	void randomx_calculate_commitment_batch(const void* const* inputs, size_t inputSize, const void* hashes, size_t count, void* output) {
+		assert(count == 0 || inputs != nullptr);
+		assert(count == 0 || hashes != nullptr);
+		assert(count == 0 || output != nullptr);
+		constexpr size_t ChunkSize = 64;
+		const void* hashPtrs[ChunkSize];
+		for (size_t done = 0; done < count; done += ChunkSize) {
+			const size_t chunk = std::min(count - done, ChunkSize);
+			for (size_t i = 0; i < chunk; ++i) {
+				hashPtrs[i] = (const char*)hashes + (done + i) * RANDOMX_HASH_SIZE;
+			}
+			//the output of a chunk only overwrites the hashes of the same chunk, which are read first
+			randomx::hashMulti((char*)output + done * RANDOMX_HASH_SIZE, RANDOMX_HASH_SIZE, inputs + done, inputSize,
+				hashPtrs, RANDOMX_HASH_SIZE, chunk);
+		}
+	}
+
+	unsigned randomx_commitment_merkle_depth(size_t count) {
+		return randomx::merkleDepth(count);
+	}
+
+	int randomx_commitment_merkle_root(const void* commitments, size_t count, void* root, void* paths) {
+		assert(count == 0 || commitments != nullptr);
+		assert(root != nullptr);
+		if (count == 0) {
+			return 0;
+		}
+		try {
+			std::vector<uint8_t> scratch(randomx::merkleScratchSize(count));
+			randomx::merkleRoot(commitments, count, root, paths, scratch.data());
+		}
+		catch (std::exception &ex) {
+			return 0;
+		}
+		return 1;
+	}
+
+	int randomx_commitment_merkle_verify(const void* commitment, size_t index, size_t count, const void* path, const void* root) {
+		assert(commitment != nullptr);
+		assert(root != nullptr);
+		if (index >= count || (path == nullptr && count > 1)) {
+			return 0;
+		}
+		return randomx::merkleVerify(commitment, index, count, path, root);
+	}
+
+	randomx_merkle_builder *randomx_merkle_builder_create() {
+		randomx_merkle_builder *builder = nullptr;
+
+		try {
+			builder = new randomx_merkle_builder();
+		}
+		catch (std::exception &ex) {
+			builder = nullptr;
+		}
+
+		return builder;
+	}
+
+	void randomx_merkle_builder_add(randomx_merkle_builder *builder, const void *commitments, size_t count) {
+		assert(builder != nullptr);
+		assert(count == 0 || commitments != nullptr);
+		builder->add(commitments, count);
+	}
+
+	int randomx_merkle_builder_root(randomx_merkle_builder *builder, void *root) {
+		assert(builder != nullptr);
+		assert(root != nullptr);
+		return builder->getRoot(root);
+	}
+
+	void randomx_merkle_builder_reset(randomx_merkle_builder *builder) {
+		assert(builder != nullptr);
+		builder->reset();
+	}
+
+	void randomx_merkle_builder_destroy(randomx_merkle_builder *builder) {
+		delete builder;
 	}
 
 	void randomx_calculate_commitment(const void* input, size_t inputSize, const void* hash_in, void* com_out) {
@@ -428,4 +2078,76 @@ extern "C" {
 		blake2b_update(&state, hash_in, RANDOMX_HASH_SIZE);
 		blake2b_final(&state, com_out, RANDOMX_HASH_SIZE);
 	}
+
+	void randomx_calculate_commitment_parts(const randomx_buffer* parts, size_t count, const void* hash_in, void* com_out) {
+		assert(count == 0 || parts != nullptr);
+		assert(hash_in != nullptr);
+		assert(com_out != nullptr);
+		blake2b_state state;
+		blake2b_init(&state, RANDOMX_HASH_SIZE);
+		for (size_t i = 0; i < count; ++i) {
+			assert(parts[i].size == 0 || parts[i].data != nullptr);
+			blake2b_update(&state, parts[i].data, parts[i].size);
+		}
+		blake2b_update(&state, hash_in, RANDOMX_HASH_SIZE);
+		blake2b_final(&state, com_out, RANDOMX_HASH_SIZE);
+	}
+
+	//absorbs the input of the pending hash while it's still in cache; Blake2b keeps the last block
+	//buffered, so the caller doesn't need to keep the input until the commitment is finished
+	static void beginCommitment(randomx_vm *machine, const void *input, size_t inputSize) {
+		blake2b_init(&machine->commitmentState, RANDOMX_HASH_SIZE);
+		blake2b_update(&machine->commitmentState, input, inputSize);
+	}
+
+	static void finishCommitment(randomx_vm *machine, const void *hash, void *com_out) {
+		blake2b_update(&machine->commitmentState, hash, RANDOMX_HASH_SIZE);
+		blake2b_final(&machine->commitmentState, com_out, RANDOMX_HASH_SIZE);
+	}
+
+	void randomx_calculate_hash_and_commitment(randomx_vm *machine, const void *input, size_t inputSize, void *hash_out, void *com_out) {
+		assert(machine != nullptr);
+		assert(inputSize == 0 || input != nullptr);
+		assert(hash_out != nullptr && com_out != nullptr);
+		beginCommitment(machine, input, inputSize);
+		randomx_calculate_hash(machine, input, inputSize, hash_out);
+		finishCommitment(machine, hash_out, com_out);
+	}
+
+	void randomx_calculate_hash_and_commitment_first(randomx_vm *machine, const void *input, size_t inputSize) {
+		randomx_calculate_hash_first(machine, input, inputSize);
+		beginCommitment(machine, input, inputSize);
+	}
+
+	void randomx_calculate_hash_and_commitment_next(randomx_vm *machine, const void *nextInput, size_t nextInputSize, void *hash_out, void *com_out) {
+		randomx_calculate_hash_next(machine, nextInput, nextInputSize, hash_out);
+		finishCommitment(machine, hash_out, com_out);
+		beginCommitment(machine, nextInput, nextInputSize);
+	}
+
+	void randomx_calculate_hash_and_commitment_last(randomx_vm *machine, void *hash_out, void *com_out) {
+		randomx_calculate_hash_last(machine, hash_out);
+		finishCommitment(machine, hash_out, com_out);
+	}
+
+	void randomx_calculate_hash_and_commitment_batch(randomx_vm *machine, const void *const *inputs, const size_t *inputSizes, size_t count, void *hashes, void *commitments) {
+		assert(machine != nullptr);
+		assert(count == 0 || (inputs != nullptr && inputSizes != nullptr && hashes != nullptr && commitments != nullptr));
+
+		if (count == 0) {
+			return;
+		}
+
+		const rx_float_state fpstate = rx_save_float_state();
+
+		uint8_t* hashOut = (uint8_t*)hashes;
+		uint8_t* comOut = (uint8_t*)commitments;
+		randomx_calculate_hash_and_commitment_first(machine, inputs[0], inputSizes[0]);
+		for (size_t i = 1; i < count; ++i, hashOut += RANDOMX_HASH_SIZE, comOut += RANDOMX_HASH_SIZE) {
+			randomx_calculate_hash_and_commitment_next(machine, inputs[i], inputSizes[i], hashOut, comOut);
+		}
+		randomx_calculate_hash_and_commitment_last(machine, hashOut, comOut);
+
+		rx_restore_float_state(fpstate);
+	}
 }
@@ -48,12 +48,228 @@ typedef enum {
   RANDOMX_FLAG_SECURE = 16,
   RANDOMX_FLAG_ARGON2_SSSE3 = 32,
   RANDOMX_FLAG_ARGON2_AVX2 = 64,
-  RANDOMX_FLAG_ARGON2 = 96
+  RANDOMX_FLAG_ARGON2 = 1632,
+  RANDOMX_FLAG_NUMA = 128,
+  RANDOMX_FLAG_VAES = 256,
+  RANDOMX_FLAG_ARGON2_AVX512 = 512,
+  RANDOMX_FLAG_ARGON2_NEON = 1024,
+  RANDOMX_FLAG_DATASET_AVX512 = 2048,
+  RANDOMX_FLAG_AES_VPERM = 4096,
+  RANDOMX_FLAG_LARGE_PAGES_1GB = 8192,
+  RANDOMX_FLAG_PREFAULT = 16384,
+  RANDOMX_FLAG_PREFETCH_T0 = 32768,
+  RANDOMX_FLAG_PREFETCH_SCRATCHPAD = 65536,
+  RANDOMX_FLAG_JIT_SCHEDULE = 131072,
+  RANDOMX_FLAG_JIT_SHARED_CODE = 262144
 } randomx_flags;
 
+/* The kind of pages backing a memory allocation */
+typedef enum {
+  RANDOMX_PAGES_STANDARD = 0,
+  RANDOMX_PAGES_LARGE = 1,        /* explicitly reserved large pages */
+  RANDOMX_PAGES_TRANSPARENT = 2,  /* standard pages advised to use transparent huge pages */
+  RANDOMX_PAGES_1GB = 3,          /* 1 GiB pages (RANDOMX_FLAG_LARGE_PAGES_1GB) */
+  RANDOMX_PAGES_CUSTOM = 4        /* memory provided by the allocator set with randomx_set_allocator */
+} randomx_page_backing;
+
+/* Why the last large page allocation of a thread succeeded or failed (see randomx_large_pages_status) */
+typedef enum {
+  RANDOMX_LARGE_PAGES_NOT_TRIED = 0,    /* the thread didn't allocate large pages */
+  RANDOMX_LARGE_PAGES_OK = 1,
+  RANDOMX_LARGE_PAGES_UNSUPPORTED = 2,  /* the system doesn't support the page size */
+  RANDOMX_LARGE_PAGES_NO_PRIVILEGE = 3, /* Windows: the account lacks the "Lock pages in memory" right (SeLockMemoryPrivilege) */
+  RANDOMX_LARGE_PAGES_NOT_RESERVED = 4, /* Linux: no huge pages of the size are reserved (vm.nr_hugepages) */
+  RANDOMX_LARGE_PAGES_NO_MEMORY = 5,    /* not enough free large pages or contiguous physical memory, e.g. fragmentation */
+  RANDOMX_LARGE_PAGES_ERROR = 6         /* any other error, see the system error code */
+} randomx_large_pages_result;
+
+/* How worker threads are assigned to CPUs (see randomx_thread_placement) */
+typedef enum {
+  RANDOMX_PLACEMENT_NONE = 0,       /* no pinning */
+  RANDOMX_PLACEMENT_FAST_CORES = 1, /* only the fastest cores (P-cores, big cores) */
+  RANDOMX_PLACEMENT_ALL_CORES = 2,  /* all cores, the fastest first */
+  RANDOMX_PLACEMENT_SMT_PAIRS = 3   /* all cores, the SMT siblings of a core get consecutive threads */
+} randomx_placement;
+
+/* How the slots of a scratchpad arena are laid out (see randomx_alloc_scratchpad_arena_layout) */
+typedef enum {
+  RANDOMX_ARENA_PACKED = 0,    /* scratchpads at multiples of their size */
+  RANDOMX_ARENA_STAGGERED = 1  /* consecutive slots shifted against each other by RANDOMX_SCRATCHPAD_L1 */
+} randomx_arena_layout;
+
+/* What the memory requested from a custom allocator will be used for */
+typedef enum {
+  RANDOMX_MEMORY_CACHE = 0,
+  RANDOMX_MEMORY_DATASET = 1,
+  RANDOMX_MEMORY_SCRATCHPAD = 2,
+  RANDOMX_MEMORY_JIT = 3
+} randomx_memory_purpose;
+
+typedef struct randomx_allocator {
+  void *(*alloc)(size_t size, size_t alignment, randomx_memory_purpose purpose, void *userData);
+  void (*free)(void *ptr, size_t size, randomx_memory_purpose purpose, void *userData);
+  void *userData;
+} randomx_allocator;
+
+/* Per-phase cycle counts of a virtual machine (see randomx_vm_get_stats) */
+typedef struct randomx_vm_stats {
+  uint64_t hashes;
+  uint64_t programs;
+  uint64_t seedCycles;            /* Blake2b of the input */
+  uint64_t initScratchpadCycles;  /* filling the scratchpad with AesGenerator1R */
+  uint64_t generateProgramCycles; /* generating programs with AesGenerator4R */
+  uint64_t compileCycles;         /* compiling programs to machine code or bytecode */
+  uint64_t executeCycles;
+  uint64_t chainCycles;           /* Blake2b of the register file between programs */
+  uint64_t finalResultCycles;     /* AesHash1R of the scratchpad and the final Blake2b */
+  uint64_t resultCacheHits;       /* hashes taken from the result cache (counted in all builds) */
+  uint64_t resultCacheMisses;     /* hashes calculated and stored in the result cache (counted in all builds) */
+} randomx_vm_stats;
+
+/* Memory held by a cache, a dataset and a virtual machine (see randomx_get_memory_info) */
+typedef struct randomx_memory_info {
+  size_t cacheBytes;
+  size_t datasetBytes;                   /* including all NUMA copies */
+  size_t scratchpadBytes;                /* including all lanes of an interleaved virtual machine */
+  size_t jitCodeBytes;                   /* machine code buffers of the cache and the virtual machine */
+  size_t itemTableBytes;                 /* dataset item tables of a lazy virtual machine and of the cache */
+  size_t cachePageSize;
+  size_t datasetPageSize;
+  size_t scratchpadPageSize;
+  randomx_page_backing cacheBacking;
+  randomx_page_backing datasetBacking;
+  randomx_page_backing scratchpadBacking;
+  unsigned datasetCopies;                /* number of NUMA copies of the dataset, 1 if not replicated */
+  int numaNode;                          /* node of the virtual machine memory, -1 if not bound */
+  size_t resultTableBytes;               /* hash result table of the cache */
+} randomx_memory_info;
+
+/* How dataset items are obtained (see randomx_plan_memory_mode) */
+typedef enum {
+  RANDOMX_MODE_LIGHT = 0,                /* calculated from the cache for every read */
+  RANDOMX_MODE_LAZY = 1,                 /* calculated from the cache and kept in a table (randomx_create_vm_lazy) */
+  RANDOMX_MODE_FULL = 2                  /* read from the dataset */
+} randomx_memory_mode;
+
+/* Configuration recommended by randomx_plan_memory_mode */
+typedef struct randomx_memory_plan {
+  randomx_memory_mode mode;
+  randomx_flags flags;                   /* for randomx_alloc_cache, randomx_alloc_dataset and the virtual machines */
+  unsigned initThreads;                  /* for randomx_init_cache_parallel and randomx_init_dataset_parallel */
+  size_t itemTableBytes;                 /* dataset item table of each lazy virtual machine */
+  size_t memoryBytes;                    /* estimated peak memory of the cache, dataset and virtual machines */
+  uint64_t itemsPerKey;                  /* estimated number of dataset items calculated per key */
+} randomx_memory_plan;
+
+/* Fastest configuration measured by randomx_autotune */
+typedef struct randomx_tuning {
+  randomx_flags flags;                   /* for randomx_alloc_cache, randomx_alloc_dataset and the virtual machines */
+  uint32_t cpuSignature;                 /* processor family, model and stepping (CPUID leaf 1 on x86-64, 0 elsewhere) */
+  double hashSeconds;                    /* time of one hash with flags */
+  double argon2Seconds;                  /* estimated time of the Argon2 fill of the cache (single thread) */
+  int fromFile;                          /* 1 if the result was read from the tuning file */
+} randomx_tuning;
+
+/* RandomX parameters of the library build (see randomx_get_parameters and src/configuration.h) */
+typedef struct randomx_parameters {
+  uint32_t argonMemory;                  /* KiB */
+  uint32_t argonIterations;
+  uint32_t argonLanes;
+  const char *argonSalt;
+  size_t argonSaltSize;
+  uint32_t cacheAccesses;
+  uint32_t superscalarLatency;
+  uint64_t datasetBaseSize;
+  uint64_t datasetExtraSize;
+  uint32_t programSize;
+  uint32_t programIterations;
+  uint32_t programCount;
+  uint32_t scratchpadL3;
+  uint32_t scratchpadL2;
+  uint32_t scratchpadL1;
+  uint32_t jumpBits;
+  uint32_t jumpOffset;
+  uint8_t instructionFrequencies[30];    /* in the order of src/configuration.h, IADD_RS to NOP */
+} randomx_parameters;
+
 typedef struct randomx_dataset randomx_dataset;
 typedef struct randomx_cache randomx_cache;
 typedef struct randomx_vm randomx_vm;
+typedef struct randomx_epoch randomx_epoch;
+typedef struct randomx_scratchpad_arena randomx_scratchpad_arena;
+typedef struct randomx_verifier randomx_verifier;
+typedef struct randomx_vm_pool randomx_vm_pool;
+typedef struct randomx_cancel_token randomx_cancel_token;
+typedef struct randomx_nonce_scheduler randomx_nonce_scheduler;
+typedef struct randomx_engine randomx_engine;
+typedef struct randomx_input_template randomx_input_template;
+typedef struct randomx_merkle_builder randomx_merkle_builder;
+
+/* One segment of a scatter-gather input; the segments are hashed as if they were concatenated */
+typedef struct randomx_buffer {
+  const void *data;
+  size_t size;
+} randomx_buffer;
+
+/* Opcodes of the SuperscalarHash instructions passed to a dataset initialization backend */
+typedef enum {
+  RANDOMX_SUPERSCALAR_ISUB_R = 0,
+  RANDOMX_SUPERSCALAR_IXOR_R = 1,
+  RANDOMX_SUPERSCALAR_IADD_RS = 2,   /* imm is the shift */
+  RANDOMX_SUPERSCALAR_IMUL_R = 3,
+  RANDOMX_SUPERSCALAR_IROR_C = 4,    /* imm is the rotation */
+  RANDOMX_SUPERSCALAR_IADD_C = 5,    /* imm is the sign-extended immediate */
+  RANDOMX_SUPERSCALAR_IXOR_C = 6,    /* imm is the sign-extended immediate */
+  RANDOMX_SUPERSCALAR_IMULH_R = 11,
+  RANDOMX_SUPERSCALAR_ISMULH_R = 12,
+  RANDOMX_SUPERSCALAR_IMUL_RCP = 13, /* imm is the reciprocal */
+  RANDOMX_SUPERSCALAR_END = 14       /* ends a program, dst is its address register */
+} randomx_superscalar_opcode;
+
+typedef struct randomx_superscalar_instruction {
+  uint64_t imm;
+  uint8_t opcode;                    /* randomx_superscalar_opcode */
+  uint8_t dst;
+  uint8_t src;
+} randomx_superscalar_instruction;
+
+/* Everything a dataset initialization backend needs to calculate the dataset items of a cache */
+typedef struct randomx_dataset_init_context {
+  const void *cacheMemory;
+  size_t cacheSize;
+  const randomx_superscalar_instruction *programs; /* RANDOMX_CACHE_ACCESSES programs back to back */
+  size_t programsLength;                           /* number of instructions including the end markers */
+} randomx_dataset_init_context;
+
+/* Calculates dataset items on other hardware, e.g. a GPU (see randomx_init_dataset_backend) */
+typedef struct randomx_dataset_backend {
+  int (*initItems)(void *userData, const randomx_dataset_init_context *context, void *output, uint64_t startItem, uint64_t itemCount);
+  void *userData;
+} randomx_dataset_backend;
+
+/* Calculates one dataset item from the cache memory of the key it was compiled for */
+typedef void randomx_dataset_item_func(const void *cacheMemory, void *output, uint64_t itemNumber);
+
+/* SuperscalarHash of one key compiled ahead of time (see randomx_cache_set_aot_module) */
+typedef struct randomx_aot_module {
+  uint8_t keyHash[32];               /* Blake2b-256 of the key */
+  uint8_t configurationHash[32];     /* identifies the RandomX parameters the module was generated with */
+  randomx_dataset_item_func *initItem;
+} randomx_aot_module;
+
+/* Counters of a randomx_engine (see randomx_engine_get_stats) */
+typedef struct randomx_engine_stats {
+  uint64_t hashes;          /* completed hash calculations */
+  double hashrate;          /* hashes per second in the last autoscaling interval, 0 without autoscaling */
+  unsigned threadCount;
+  unsigned activeThreads;   /* threads that receive new requests */
+} randomx_engine_stats;
+
+/* Receives the RANDOMX_HASH_SIZE bytes of a hash calculated by a randomx_engine */
+typedef void randomx_hash_callback(void *userData, const void *hash);
+
+/* Reports that done out of total work units of an initialization have been completed */
+typedef void randomx_progress_callback(void *userData, uint64_t done, uint64_t total);
 
 
 #if defined(__cplusplus)
@@ -88,30 +304,81 @@ extern "C" {
  */
 RANDOMX_EXPORT randomx_flags randomx_get_flags(void);
 
+/**
+ * Returns the RandomX parameters the library was built with. The parameters are compile-time
+ * constants, so a process that serves several parameter sets needs one library build per set;
+ * randomx_parameters_supported can be used to select the right one.
+ *
+ * @param params is a pointer to the structure that receives the parameters. Must not be NULL.
+ *        The salt pointer stays valid for the lifetime of the library.
+*/
+RANDOMX_EXPORT void randomx_get_parameters(randomx_parameters *params);
+
+/**
+ * Checks whether the library calculates hashes with the given parameters.
+ *
+ * @param params is a pointer to the parameter set to check. Must not be NULL.
+ *
+ * @return 1 if all parameters (including the salt contents) are equal to those of the library
+ *         build, 0 otherwise.
+*/
+RANDOMX_EXPORT int randomx_parameters_supported(const randomx_parameters *params);
+
+/**
+ * Sets the allocator used for the memory of caches, datasets, scratchpads (including scratchpad
+ * arenas) and JIT compiled code. Must be called before any of these objects are created, and
+ * all objects must be released before the allocator is changed again.
+ * RANDOMX_FLAG_LARGE_PAGES and RANDOMX_FLAG_LARGE_PAGES_1GB have no effect on memory provided by
+ * the allocator and the page backing functions return RANDOMX_PAGES_CUSTOM.
+ *
+ * @param allocator is a pointer to the allocator callbacks, which are copied. alloc must return
+ *        memory of at least size bytes aligned to alignment or NULL on failure. Memory for
+ *        RANDOMX_MEMORY_JIT must consist of whole pages whose protection can be changed to
+ *        executable (e.g. pages allocated with mmap or VirtualAlloc). free receives the same
+ *        size and purpose. userData is passed to both callbacks.
+ *        NULL restores the default allocator.
+*/
+RANDOMX_EXPORT void randomx_set_allocator(const randomx_allocator *allocator);
+
 /**
  * Creates a randomx_cache structure and allocates memory for RandomX Cache.
  *
  * @param flags is any combination of these 2 flags (each flag can be set or not set):
- *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages (see randomx_cache_page_backing)
  *        RANDOMX_FLAG_JIT - create cache structure with JIT compilation support; this makes
  *                           subsequent Dataset initialization faster
- *        Optionally, one of these two flags may be selected:
+ *        Optionally, one of these four flags may be selected:
  *        RANDOMX_FLAG_ARGON2_SSSE3 - optimized Argon2 for CPUs with the SSSE3 instruction set
  *                                   makes subsequent cache initialization faster
  *        RANDOMX_FLAG_ARGON2_AVX2 - optimized Argon2 for CPUs with the AVX2 instruction set
  *                                   makes subsequent cache initialization faster
+ *        RANDOMX_FLAG_ARGON2_AVX512 - optimized Argon2 for CPUs with the AVX-512F instruction set
+ *                                     makes subsequent cache initialization faster
+ *        RANDOMX_FLAG_ARGON2_NEON - optimized Argon2 for ARM64 CPUs (NEON instruction set)
+ *                                   makes subsequent cache initialization faster
+ *        RANDOMX_FLAG_DATASET_AVX512 - compile SuperscalarHash for CPUs with AVX-512F and AVX-512DQ
+ *                                      to calculate 8 Dataset items at once; makes subsequent
+ *                                      Dataset initialization faster (ignored without RANDOMX_FLAG_JIT)
+ *        RANDOMX_FLAG_JIT_SHARED_CODE - place the SuperscalarHash code in a region of large pages
+ *                                       shared with the VMs of the same RANDOMX_FLAG_SECURE setting
+ *                                       (see randomx_create_vm). With RANDOMX_FLAG_SECURE, the
+ *                                       region is dual mapped.
  *
  * @return Pointer to an allocated randomx_cache structure.
  *         Returns NULL if:
  *         (1) memory allocation fails
  *         (2) the RANDOMX_FLAG_JIT is set and JIT compilation is not supported on the current platform
  *         (3) an invalid or unsupported RANDOMX_FLAG_ARGON2 value is set
+ *         (4) the RANDOMX_FLAG_JIT and RANDOMX_FLAG_DATASET_AVX512 are set and AVX-512 is not
+ *             supported by the current CPU
  */
 RANDOMX_EXPORT randomx_cache *randomx_alloc_cache(randomx_flags flags);
 
 /**
  * Initializes the cache memory and SuperscalarHash using the provided key value.
  * Does nothing if called again with the same key value.
+ * If the cache was drained and its memory cannot be allocated again, the cache is left
+ * uninitialized and randomx_cache_is_drained keeps returning 1.
  *
  * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
  * @param key is a pointer to memory which contains the key value. Must not be NULL.
@@ -119,6 +386,37 @@ RANDOMX_EXPORT randomx_cache *randomx_alloc_cache(randomx_flags flags);
 */
 RANDOMX_EXPORT void randomx_init_cache(randomx_cache *cache, const void *key, size_t keySize);
 
+/**
+ * Initializes the cache like randomx_init_cache, filling the Argon2 lanes of each slice
+ * in parallel. Only configurations with RANDOMX_ARGON_LANES > 1 use more than one thread.
+ * The result is the same as with randomx_init_cache, also when the memory of a drained cache
+ * cannot be allocated again.
+ *
+ * @param cache, key, keySize are the same as for randomx_init_cache.
+ * @param threadCount is the number of threads to use (at most RANDOMX_ARGON_LANES are used).
+ *        0 selects the number of hardware threads. The calling thread takes part in the work.
+*/
+RANDOMX_EXPORT void randomx_init_cache_parallel(randomx_cache *cache, const void *key, size_t keySize, unsigned threadCount);
+
+/**
+ * Initializes the cache like randomx_init_cache, reporting the progress and checking
+ * for cancellation after each Argon2 segment. There are
+ * RANDOMX_ARGON_ITERATIONS * RANDOMX_ARGON_LANES * 4 segments followed by one unit for
+ * the SuperscalarHash programs.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key value. Must not be NULL.
+ * @param keySize is the number of bytes of the key.
+ * @param progress is called from the calling thread after each work unit. Can be NULL.
+ * @param userData is passed to the progress callback.
+ * @param cancel is a cancellation token created with randomx_create_cancel_token. Can be NULL.
+ *
+ * @return 1 if the cache was initialized, 0 if the initialization was cancelled or the memory
+ *         of a drained cache cannot be allocated again.
+ *         A cancelled cache is left uninitialized and must be initialized again before use.
+*/
+RANDOMX_EXPORT int randomx_init_cache_progress(randomx_cache *cache, const void *key, size_t keySize, randomx_progress_callback *progress, void *userData, randomx_cancel_token *cancel);
+
 /**
  * Releases all memory occupied by the randomx_cache structure.
  *
@@ -126,17 +424,202 @@ RANDOMX_EXPORT void randomx_init_cache(randomx_cache *cache, const void *key, si
 */
 RANDOMX_EXPORT void randomx_release_cache(randomx_cache* cache);
 
+/**
+ * Saves an initialized cache, including its superscalar programs, to a file.
+ * The file is tagged with the RandomX configuration parameters and contains the cache key.
+ *
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+ * @param path is the path of the file to be created or overwritten. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the file could not be written.
+*/
+RANDOMX_EXPORT int randomx_cache_save(randomx_cache *cache, const char *path);
+
+/**
+ * Initializes a cache from a file saved by randomx_cache_save. The Argon2 memory is not
+ * recalculated. If the cache was allocated with RANDOMX_FLAG_JIT, the dataset initialization
+ * code is compiled again. The key of the loaded cache can be checked by calling
+ * randomx_init_cache with the expected key, which is a no-op if the keys match.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ * @param path is the path of the file. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the file doesn't exist, is corrupted or was saved with a different
+ *         file format version or RandomX configuration, or if the memory of a drained cache
+ *         cannot be allocated again. On failure, the cache is left uninitialized.
+*/
+RANDOMX_EXPORT int randomx_cache_load(randomx_cache *cache, const char *path);
+
+/**
+ * Releases the Argon2 memory of an initialized cache, for example after a dataset has been
+ * initialized in full mode. The cache keeps its key, superscalar programs and reciprocals,
+ * so randomx_init_cache with the same key remains a no-op and full-mode virtual machines can
+ * still be created with it. A drained cache cannot be used to initialize a dataset, to create
+ * light-mode virtual machines or to be saved. The memory is allocated again by the next
+ * randomx_init_cache with a different key or by randomx_cache_load.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_cache_drain(randomx_cache *cache);
+
+/**
+ * Drains a cache like randomx_cache_drain, but instead of releasing the Argon2 memory, hands
+ * it over to a new scratchpad arena (see randomx_alloc_scratchpad_arena). With the default
+ * configuration, the arena has room for 127 virtual machines. The memory is released when the
+ * arena is released; the cache allocates new memory if it is initialized with a different key.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ *
+ * @return Pointer to a scratchpad arena that must be released with randomx_release_scratchpad_arena.
+ *         Returns NULL if the cache is already drained or the arena cannot be created
+ *         (the cache is left unchanged in that case).
+*/
+RANDOMX_EXPORT randomx_scratchpad_arena *randomx_cache_drain_to_arena(randomx_cache *cache);
+
+/**
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ *
+ * @return 1 if the cache memory was released by randomx_cache_drain or randomx_cache_drain_to_arena
+ *         and has not been allocated again, otherwise 0.
+*/
+RANDOMX_EXPORT int randomx_cache_is_drained(randomx_cache *cache);
+
+/**
+ * Allocates a table of dataset items that is shared by all interpreted light-mode virtual
+ * machines (including lazy virtual machines) that use the cache. Before calculating a dataset
+ * item, a virtual machine looks it up in the table, and afterwards stores it there, so virtual
+ * machines hashing under the same key calculate each item only about once. The table is
+ * 4-way set-associative and lock-free. Its entries are invalidated when the cache is initialized
+ * with a new key. JIT compiled light-mode virtual machines don't use the table.
+ * Must not be called while virtual machines that use the cache are running.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ * @param size is the maximum size of the table in bytes (rounded down to a power of 2 number
+ *        of sets of 4 items with their tags). 0 removes the table.
+ *
+ * @return 1 on success, 0 if memory allocation fails (the previous table is kept in that case).
+*/
+RANDOMX_EXPORT int randomx_cache_set_item_cache(randomx_cache *cache, size_t size);
+
+/**
+ * Allocates a table of hash results that is shared by all light-mode virtual machines that use
+ * the cache. randomx_calculate_hash and randomx_calculate_hash_parts look up the Blake2b-512
+ * digest of the input, which they calculate anyway, and return the stored result without running
+ * the programs if the same input was hashed before under the same key. Verifiers that see the same
+ * input repeatedly (e.g. rebroadcast blocks or duplicate shares) calculate it only once.
+ * The table is 4-way set-associative and lock-free. Its entries are invalidated when the cache is
+ * initialized with a new key. The hits and misses are reported by randomx_vm_get_stats.
+ * Must not be called while virtual machines that use the cache are running.
+ *
+ * @param cache is a pointer to a previously allocated randomx_cache structure. Must not be NULL.
+ * @param size is the maximum size of the table in bytes (128 bytes per result, rounded down to
+ *        a power of 2 number of sets of 4 results). 0 removes the table.
+ *
+ * @return 1 on success, 0 if memory allocation fails (the previous table is kept in that case).
+*/
+RANDOMX_EXPORT int randomx_cache_set_result_cache(randomx_cache *cache, size_t size);
+
+/**
+ * Makes the cache calculate dataset items with a module compiled ahead of time instead of
+ * interpreting the SuperscalarHash programs, for platforms where JIT compilation is not allowed.
+ * The module is generated as C source by "randomx-codegen --genDatasetC --key <key>" and built
+ * into the application. It is used by interpreted light-mode virtual machines and by dataset
+ * initialization without RANDOMX_FLAG_JIT. It is removed when the cache is initialized with
+ * a new key or loaded from a file, so it must be set again after that.
+ * Must not be called while virtual machines that use the cache are running.
+ *
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+ * @param module is a pointer to the module, which must stay valid while it is used.
+ *        NULL removes the module.
+ *
+ * @return 1 on success, 0 if the module was generated for a different key or RandomX
+ *         configuration (the previous module is kept in that case).
+*/
+RANDOMX_EXPORT int randomx_cache_set_aot_module(randomx_cache *cache, const randomx_aot_module *module);
+
 /**
  * Creates a randomx_dataset structure and allocates memory for RandomX Dataset.
  *
- * @param flags is the initialization flags. Only one flag is supported (can be set or not set):
- *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages
+ * @param flags is the initialization flags. Only four flags are supported (each flag can be set or not set):
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages (see randomx_dataset_page_backing)
+ *        RANDOMX_FLAG_LARGE_PAGES_1GB - allocate memory in 1 GiB pages (Linux and Windows 10 1803 or newer).
+ *                                       On Linux, the memory past the last whole 1 GiB uses 2 MiB pages. If 1 GiB pages are not
+ *                                       available, falls back to large pages and then to standard pages.
+ *                                       Use randomx_dataset_page_size to check the result.
+ *        RANDOMX_FLAG_NUMA - allocate one copy of the dataset per NUMA node; the copies are
+ *                            filled by the dataset initialization functions and used by
+ *                            virtual machines created with randomx_create_vm_on_node.
+ *                            On Windows, large pages of each copy are allocated on its node.
+ *                            Has no effect on systems with a single NUMA node.
+ *        RANDOMX_FLAG_PREFAULT - touch every page of the dataset using all hardware threads, so
+ *                                the page faults don't slow down the dataset initialization.
+ *                                With RANDOMX_FLAG_NUMA, each copy is touched by the threads of its
+ *                                node. Use randomx_dataset_prefault_time to get the time spent.
  *
  * @return Pointer to an allocated randomx_dataset structure.
  *         NULL is returned if memory allocation fails.
+ *         If large pages were requested but not used, randomx_large_pages_status tells why.
  */
 RANDOMX_EXPORT randomx_dataset *randomx_alloc_dataset(randomx_flags flags);
 
+/**
+ * Gets the number of NUMA nodes of the system.
+ *
+ * @return the number of NUMA nodes (1 if the system is not NUMA or the topology is unknown).
+*/
+RANDOMX_EXPORT unsigned randomx_numa_node_count(void);
+
+/**
+ * Gets the CPUs that belong to a NUMA node.
+ *
+ * @param node is the NUMA node number (0 to randomx_numa_node_count() - 1). The nodes are
+ *        numbered in the order of the OS node IDs, without the gaps the IDs can have.
+ *
+ * @return a bitmask of the CPUs 0-63 of the node (suitable as the affinityMask of
+ *         randomx_init_dataset_parallel), 0 if the node doesn't exist or the topology is unknown.
+*/
+RANDOMX_EXPORT uint64_t randomx_numa_node_cpu_mask(unsigned node);
+
+/**
+ * Gets the CPUs that worker threads (dataset initialization or VM threads) should be
+ * pinned to. Each physical core gets a thread before its SMT siblings, faster cores come
+ * first and consecutive threads are spread over the last level cache domains (L3, CCX).
+ * With RANDOMX_PLACEMENT_SMT_PAIRS, all SMT siblings of a core get consecutive threads
+ * instead, so VMs created in the same order in a staggered scratchpad arena share a core
+ * with the VMs whose scratchpads are shifted against theirs.
+ * On hybrid CPUs, the threads on slow cores take less work if the work is claimed in
+ * small pieces (as in randomx_init_dataset_placed) or split by the capacities.
+ *
+ * @param policy is the placement policy.
+ * @param threadCount is the number of threads. 0 selects the number of CPUs covered by
+ *        the policy. If it's larger, the CPUs are reused in the same order.
+ * @param cpus is a pointer to an array of threadCount (or the number of logical CPUs if
+ *        threadCount is 0) elements that receives the CPU index for each thread. Must not be NULL.
+ * @param capacities is a pointer to an array of the same size that receives the relative
+ *        performance of each CPU (1024 for the fastest cores). Can be NULL.
+ *
+ * @return the number of threads placed, 0 for RANDOMX_PLACEMENT_NONE.
+*/
+RANDOMX_EXPORT unsigned randomx_thread_placement(randomx_placement policy, unsigned threadCount, unsigned *cpus, unsigned *capacities);
+
+/**
+ * Gets the physical core of a CPU. SMT siblings share the L1 and L2 caches of their core.
+ *
+ * @param cpu is the CPU index.
+ *
+ * @return the lowest CPU index of the SMT siblings of the CPU, or cpu if the topology is unknown.
+*/
+RANDOMX_EXPORT unsigned randomx_cpu_core(unsigned cpu);
+
+/**
+ * Pins the calling thread to a CPU.
+ *
+ * @param cpu is the CPU index (as returned by randomx_thread_placement).
+ *
+ * @return 1 on success, 0 if pinning failed or is not supported on this platform.
+*/
+RANDOMX_EXPORT int randomx_set_thread_affinity(unsigned cpu);
+
 /**
  * Gets the number of items contained in the dataset.
  *
@@ -158,118 +641,1221 @@ RANDOMX_EXPORT unsigned long randomx_dataset_item_count(void);
 RANDOMX_EXPORT void randomx_init_dataset(randomx_dataset *dataset, randomx_cache *cache, unsigned long startItem, unsigned long itemCount);
 
 /**
- * Returns a pointer to the internal memory buffer of the dataset structure. The size
- * of the internal memory buffer is randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE.
+ * Initializes dataset items like randomx_init_dataset, in chunks of 16384 items. The progress
+ * is reported in items after each chunk and the cancellation token is checked before each chunk.
+ * Several threads initializing different item ranges may share the same token.
  *
  * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a previously allocated and initialized randomx_cache structure. Must not be NULL.
+ * @param startItem is the item number where intialization should start.
+ * @param itemCount is the number of items that should be initialized.
+ * @param progress is called from the calling thread after each chunk. Can be NULL.
+ * @param userData is passed to the progress callback.
+ * @param cancel is a cancellation token created with randomx_create_cancel_token. Can be NULL.
  *
- * @return Pointer to the internal memory buffer of the dataset structure.
+ * @return 1 if all items were initialized, 0 if the initialization was cancelled
+ *         (the remaining items are not initialized).
 */
-RANDOMX_EXPORT void *randomx_get_dataset_memory(randomx_dataset *dataset);
+RANDOMX_EXPORT int randomx_init_dataset_progress(randomx_dataset *dataset, randomx_cache *cache, unsigned long startItem, unsigned long itemCount, randomx_progress_callback *progress, void *userData, randomx_cancel_token *cancel);
 
 /**
- * Releases all memory occupied by the randomx_dataset structure.
+ * Creates a token that cancels the initializations it is passed to.
  *
- * @param dataset is a pointer to a previously allocated randomx_dataset structure.
+ * @return Pointer to a new randomx_cancel_token or NULL if memory allocation fails.
 */
-RANDOMX_EXPORT void randomx_release_dataset(randomx_dataset *dataset);
+RANDOMX_EXPORT randomx_cancel_token *randomx_create_cancel_token(void);
 
 /**
- * Creates and initializes a RandomX virtual machine.
+ * Requests the cancellation of the initializations using the token. Can be called from any
+ * thread. The initializations return at the next check, the token stays cancelled.
  *
- * @param flags is any combination of these 5 flags (each flag can be set or not set):
- *        RANDOMX_FLAG_LARGE_PAGES - allocate scratchpad memory in large pages
- *        RANDOMX_FLAG_HARD_AES - virtual machine will use hardware accelerated AES
- *        RANDOMX_FLAG_FULL_MEM - virtual machine will use the full dataset
- *        RANDOMX_FLAG_JIT - virtual machine will use a JIT compiler
- *        RANDOMX_FLAG_SECURE - when combined with RANDOMX_FLAG_JIT, the JIT pages are never
- *                              writable and executable at the same time (W^X policy)
- *        The numeric values of the first 4 flags are ordered so that a higher value will provide
- *        faster hash calculation and a lower numeric value will provide higher portability.
- *        Using RANDOMX_FLAG_DEFAULT (all flags not set) works on all platforms, but is the slowest.
- * @param cache is a pointer to an initialized randomx_cache structure. Can be
- *        NULL if RANDOMX_FLAG_FULL_MEM is set.
- * @param dataset is a pointer to a randomx_dataset structure. Can be NULL
- *        if RANDOMX_FLAG_FULL_MEM is not set.
+ * @param token is a pointer to a randomx_cancel_token structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_cancel(randomx_cancel_token *token);
+
+/**
+ * Releases a cancellation token. The token must not be in use by any initialization.
  *
- * @return Pointer to an initialized randomx_vm structure.
- *         Returns NULL if:
- *         (1) Scratchpad memory allocation fails.
- *         (2) The requested initialization flags are not supported on the current platform.
- *         (3) cache parameter is NULL and RANDOMX_FLAG_FULL_MEM is not set
- *         (4) dataset parameter is NULL and RANDOMX_FLAG_FULL_MEM is set
+ * @param token is a pointer to a randomx_cancel_token structure.
 */
-RANDOMX_EXPORT randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset);
+RANDOMX_EXPORT void randomx_destroy_cancel_token(randomx_cancel_token *token);
 
 /**
- * Reinitializes a virtual machine with a new Cache. This function should be called anytime
- * the Cache is reinitialized with a new key. Does nothing if called with a Cache containing
- * the same key value as already set.
+ * Initializes all dataset items using several threads.
  *
- * @param machine is a pointer to a randomx_vm structure that was initialized
- *        without RANDOMX_FLAG_FULL_MEM. Must not be NULL.
- * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+ * The dataset is split into small chunks that the threads claim one by one, so faster
+ * threads take over more of the work. The calling thread takes part in the initialization.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a previously allocated and initialized randomx_cache structure. Must not be NULL.
+ * @param threadCount is the number of threads to use. 0 selects the number of hardware threads.
+ * @param affinityMask is a bitmask of CPUs the worker threads are pinned to in the order of
+ *        the set bits (wrapping around if there are more threads than set bits). 0 disables pinning.
 */
-RANDOMX_EXPORT void randomx_vm_set_cache(randomx_vm *machine, randomx_cache* cache);
+RANDOMX_EXPORT void randomx_init_dataset_parallel(randomx_dataset *dataset, randomx_cache *cache, unsigned threadCount, uint64_t affinityMask);
 
 /**
- * Reinitializes a virtual machine with a new Dataset.
+ * Initializes all dataset items like randomx_init_dataset_parallel, with the worker threads
+ * placed by randomx_thread_placement. The calling thread only waits for the workers.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a previously allocated and initialized randomx_cache structure. Must not be NULL.
+ * @param policy is the placement policy. RANDOMX_PLACEMENT_NONE runs unpinned threads.
+ * @param threadCount is the number of threads to use. 0 selects the number of CPUs covered by the policy.
+*/
+RANDOMX_EXPORT void randomx_init_dataset_placed(randomx_dataset *dataset, randomx_cache *cache, randomx_placement policy, unsigned threadCount);
+
+/**
+ * Initializes dataset items with a backend provided by the caller, e.g. one that offloads the
+ * work to a GPU. The backend's initItems callback receives the cache memory and the pre-decoded
+ * SuperscalarHash programs and must write itemCount items of RANDOMX_DATASET_ITEM_SIZE bytes,
+ * calculated as described in section 7.3 of doc/specs.md, to output. It returns 1 on success.
+ * If it returns 0, the items are initialized on the CPU by the calling thread instead.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL or drained.
+ * @param backend is a pointer to the backend. Must not be NULL.
+ * @param startItem is the item number where initialization should start.
+ * @param itemCount is the number of items that should be initialized.
+ *
+ * @return 1 if the backend initialized the items, 0 if they were initialized on the CPU.
+*/
+RANDOMX_EXPORT int randomx_init_dataset_backend(randomx_dataset *dataset, randomx_cache *cache, const randomx_dataset_backend *backend, unsigned long startItem, unsigned long itemCount);
+
+/**
+ * Saves an initialized dataset to a file that can be memory-mapped by randomx_dataset_map.
+ * The file is tagged with the key and the RandomX configuration parameters. If the file is
+ * placed on hugetlbfs, the mapped dataset will use large pages.
  *
- * @param machine is a pointer to a randomx_vm structure that was initialized
- *        with RANDOMX_FLAG_FULL_MEM. Must not be NULL.
  * @param dataset is a pointer to an initialized randomx_dataset structure. Must not be NULL.
+ * @param key is a pointer to the key the dataset was initialized with. Can be NULL if keySize is 0.
+ * @param keySize is the size of the key in bytes.
+ * @param path is the path of the file to be created or overwritten. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the file could not be created.
 */
-RANDOMX_EXPORT void randomx_vm_set_dataset(randomx_vm *machine, randomx_dataset *dataset);
+RANDOMX_EXPORT int randomx_dataset_save(randomx_dataset *dataset, const void *key, size_t keySize, const char *path);
 
 /**
- * Releases all memory occupied by the randomx_vm structure.
+ * Creates a read-only randomx_dataset structure backed by a file saved by randomx_dataset_save.
+ * Dataset pages are loaded on demand from the page cache. The dataset must not be passed to
+ * randomx_init_dataset. Release it with randomx_release_dataset.
  *
- * @param machine is a pointer to a previously created randomx_vm structure.
+ * @param path is the path of the file. Must not be NULL.
+ * @param key is a pointer to the expected key. Can be NULL if keySize is 0.
+ * @param keySize is the size of the key in bytes.
+ *
+ * @return Pointer to a mapped randomx_dataset structure.
+ *         NULL is returned if the file doesn't exist, cannot be mapped, or was saved
+ *         with a different key, file format version or RandomX configuration.
 */
-RANDOMX_EXPORT void randomx_destroy_vm(randomx_vm *machine);
+RANDOMX_EXPORT randomx_dataset *randomx_dataset_map(const char *path, const void *key, size_t keySize);
 
 /**
- * Calculates a RandomX hash value.
+ * Copies a chunk of dataset contents received from another node into a dataset, e.g. to
+ * avoid initializing the dataset on every node of a cluster. Chunks can be imported in any
+ * order and from several threads, as long as they don't overlap. Dataset replicas, if any,
+ * are updated too. The imported contents should be checked with randomx_dataset_verify.
  *
- * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
- * @param input is a pointer to memory to be hashed. Must not be NULL.
- * @param inputSize is the number of bytes to be hashed.
- * @param output is a pointer to memory where the hash will be stored. Must not
- *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param dataset is a pointer to a randomx_dataset structure. Must not be NULL and must
+ *        not have been created by randomx_dataset_map.
+ * @param offset is the byte offset of the chunk in the dataset.
+ * @param data is a pointer to the contents of the chunk. Can be NULL if size is 0.
+ * @param size is the size of the chunk in bytes.
+ *
+ * @return 1 on success, 0 if the chunk doesn't fit in the dataset.
 */
-RANDOMX_EXPORT void randomx_calculate_hash(randomx_vm *machine, const void *input, size_t inputSize, void *output);
+RANDOMX_EXPORT int randomx_dataset_import_chunk(randomx_dataset *dataset, uint64_t offset, const void *data, size_t size);
 
 /**
- * Set of functions used to calculate multiple RandomX hashes more efficiently.
- * randomx_calculate_hash_first will begin a hash calculation.
- * randomx_calculate_hash_next  will output the hash value of the previous input
- *                              and begin the calculation of the next hash.
- * randomx_calculate_hash_last  will output the hash value of the previous input.
+ * Recalculates a random sample of dataset items from the cache and compares them with the
+ * dataset contents. The items are selected by the seed, which should be chosen locally and
+ * kept secret from the node that provided the dataset, so it cannot predict which items
+ * are checked.
  *
- * WARNING: These functions may alter the floating point rounding mode of the calling thread.
+ * @param dataset is a pointer to a randomx_dataset structure. Must not be NULL.
+ * @param cache is a pointer to a randomx_cache structure initialized with the key of the
+ *        dataset. Must not be NULL or drained.
+ * @param sampleCount is the number of items to check. If it's at least
+ *        randomx_dataset_item_count(), every item is checked.
+ * @param seed is a pointer to the seed that selects the items. Can be NULL if seedSize is 0.
+ * @param seedSize is the size of the seed in bytes.
  *
- * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
- * @param input is a pointer to memory to be hashed. Must not be NULL.
- * @param inputSize is the number of bytes to be hashed.
- * @param nextInput is a pointer to memory to be hashed for the next hash. Must not be NULL.
- * @param nextInputSize is the number of bytes to be hashed for the next hash.
- * @param output is a pointer to memory where the hash will be stored. Must not
- *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @return 1 if all checked items are correct, 0 otherwise.
 */
-RANDOMX_EXPORT void randomx_calculate_hash_first(randomx_vm* machine, const void* input, size_t inputSize);
-RANDOMX_EXPORT void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output);
-RANDOMX_EXPORT void randomx_calculate_hash_last(randomx_vm* machine, void* output);
+RANDOMX_EXPORT int randomx_dataset_verify(randomx_dataset *dataset, randomx_cache *cache, uint64_t sampleCount, const void *seed, size_t seedSize);
 
 /**
- * Calculate a RandomX commitment from a RandomX hash and its input.
+ * Creates a randomx_dataset structure backed by named shared memory, so the dataset can be
+ * used by other processes. If the shared memory object doesn't exist, it is created. The
+ * dataset is marked as not ready until randomx_dataset_publish_shared is called.
+ * Initialize it with randomx_init_dataset or randomx_init_dataset_parallel.
  *
- * @param input is a pointer to memory that was hashed. Must not be NULL.
- * @param inputSize is the number of bytes in the input.
- * @param hash_in is the output from randomx_calculate_hash* (RANDOMX_HASH_SIZE bytes).
- * @param com_out is a pointer to memory where the commitment will be stored. Must not
- *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param name is the name of the shared memory object (on Linux it should start with '/'
+ *        and contain no other slashes). Must not be NULL.
+ *
+ * @return Pointer to a shared randomx_dataset structure.
+ *         NULL is returned if the shared memory object cannot be created or mapped.
 */
-RANDOMX_EXPORT void randomx_calculate_commitment(const void* input, size_t inputSize, const void* hash_in, void* com_out);
+RANDOMX_EXPORT randomx_dataset *randomx_dataset_create_shared(const char *name);
+
+/**
+ * Marks a shared dataset as ready for the key it was initialized with and increments
+ * its generation counter.
+ *
+ * @param dataset is a pointer to a randomx_dataset structure created by
+ *        randomx_dataset_create_shared and fully initialized. Must not be NULL.
+ * @param key is a pointer to the key the dataset was initialized with. Can be NULL if keySize is 0.
+ * @param keySize is the size of the key in bytes.
+*/
+RANDOMX_EXPORT void randomx_dataset_publish_shared(randomx_dataset *dataset, const void *key, size_t keySize);
+
+/**
+ * Creates a read-only randomx_dataset structure attached to a shared dataset published by
+ * another process. The dataset must not be passed to randomx_init_dataset. Release it with
+ * randomx_release_dataset.
+ *
+ * @param name is the name of the shared memory object. Must not be NULL.
+ * @param key is a pointer to the expected key. Can be NULL if keySize is 0.
+ * @param keySize is the size of the key in bytes.
+ *
+ * @return Pointer to an attached randomx_dataset structure.
+ *         NULL is returned if the shared memory object doesn't exist, the dataset is not
+ *         ready, or it was published with a different key or RandomX configuration.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_dataset_attach_shared(const char *name, const void *key, size_t keySize);
+
+/**
+ * Gets the generation counter of a shared dataset. The counter is odd while the creator
+ * reinitializes the dataset and changes on every publication, so processes that attached
+ * the dataset can detect that it was reinitialized with a new key.
+ *
+ * @param dataset is a pointer to a randomx_dataset structure created by
+ *        randomx_dataset_create_shared or randomx_dataset_attach_shared. Must not be NULL.
+ *
+ * @return the generation counter (0 if the dataset was never published).
+*/
+RANDOMX_EXPORT uint32_t randomx_dataset_shared_generation(randomx_dataset *dataset);
+
+/**
+ * Removes the name of a shared dataset. Processes that have the dataset mapped can keep
+ * using it; the memory is freed when the last of them releases it.
+ *
+ * @param name is the name of the shared memory object. Must not be NULL.
+ *
+ * @return 1 on success, 0 if the shared memory object doesn't exist.
+*/
+RANDOMX_EXPORT int randomx_dataset_remove_shared(const char *name);
+
+/**
+ * Returns a pointer to the internal memory buffer of the dataset structure. The size
+ * of the internal memory buffer is randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ *
+ * @return Pointer to the internal memory buffer of the dataset structure.
+*/
+RANDOMX_EXPORT void *randomx_get_dataset_memory(randomx_dataset *dataset);
+
+/**
+ * Returns the size of the pages backing the memory of the dataset structure, e.g. to check
+ * which page size was used by randomx_alloc_dataset with RANDOMX_FLAG_LARGE_PAGES_1GB.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ *
+ * @return The page size in bytes: 1073741824 for 1 GiB pages, the large page size of the system
+ *         (usually 2097152) for large pages or the standard page size otherwise (including
+ *         transparent huge pages, which the kernel may or may not provide).
+*/
+RANDOMX_EXPORT size_t randomx_dataset_page_size(randomx_dataset *dataset);
+
+/**
+ * Returns the outcome of the last attempt of the calling thread to allocate large pages or
+ * 1 GiB pages, e.g. by randomx_alloc_dataset, randomx_alloc_cache or randomx_create_vm with
+ * RANDOMX_FLAG_LARGE_PAGES. It tells a missing privilege apart from a lack of free memory,
+ * which is common when physical memory is fragmented after a long uptime.
+ *
+ * @param systemError is NULL or a pointer where the system error code of the failure will be
+ *        stored (GetLastError on Windows, errno elsewhere), 0 if there is none.
+ *
+ * @return The outcome of the last large page allocation.
+*/
+RANDOMX_EXPORT randomx_large_pages_result randomx_large_pages_status(int *systemError);
+
+/**
+ * Functions that return the kind of pages that were obtained for the memory of a dataset,
+ * a cache or a virtual machine scratchpad. If RANDOMX_FLAG_LARGE_PAGES was set but no large
+ * pages are reserved, the memory is allocated in standard pages advised to use transparent
+ * huge pages (Linux only) and RANDOMX_PAGES_TRANSPARENT is returned.
+ *
+ * @param dataset, cache, machine is a pointer to a previously created structure. Must not be NULL.
+ *
+ * @return One of RANDOMX_PAGES_STANDARD, RANDOMX_PAGES_LARGE, RANDOMX_PAGES_TRANSPARENT
+ *         RANDOMX_PAGES_1GB or RANDOMX_PAGES_CUSTOM.
+*/
+RANDOMX_EXPORT randomx_page_backing randomx_dataset_page_backing(randomx_dataset *dataset);
+RANDOMX_EXPORT randomx_page_backing randomx_cache_page_backing(randomx_cache *cache);
+RANDOMX_EXPORT randomx_page_backing randomx_vm_page_backing(randomx_vm *machine);
+
+/**
+ * Gets the memory held by a cache, a dataset and a virtual machine. The fields of the objects
+ * that are NULL are set to zero (page sizes to the standard page size). The page size of
+ * memory with RANDOMX_PAGES_TRANSPARENT is the large page size, but the kernel may back
+ * some pages with standard pages.
+ *
+ * @param cache is a pointer to a randomx_cache structure. Can be NULL.
+ * @param dataset is a pointer to a randomx_dataset structure. Can be NULL.
+ * @param machine is a pointer to a randomx_vm structure. Can be NULL.
+ * @param info is a pointer to the structure to be filled. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_get_memory_info(randomx_cache *cache, randomx_dataset *dataset, randomx_vm *machine, randomx_memory_info *info);
+
+/**
+ * Recommends how to obtain dataset items, given the memory of the host and how many hashes are
+ * expected per key. The costs are compared in dataset item calculations: building the dataset
+ * calculates every item once, while a light-mode hash calculates one item per program iteration.
+ * Full mode is selected if it is cheaper over the lifetime of a key and the dataset fits in
+ * memory. Otherwise light mode is selected, or lazy mode with the largest item tables that fit
+ * if the JIT compiler is not available (lazy virtual machines are always interpreted).
+ * The flags are based on randomx_get_flags. RANDOMX_FLAG_LARGE_PAGES is added if enough reserved
+ * large pages are free (detected on Linux only).
+ *
+ * @param hashesPerKey is the expected number of hashes calculated by all virtual machines before
+ *        the key changes.
+ * @param vmCount is the number of virtual machines that will be created (at least 1 is assumed).
+ * @param memoryLimit is the memory in bytes the configuration may use. 0 selects the physical
+ *        memory that is currently available (if it cannot be detected, memory is not limited).
+ * @param plan is a pointer to the structure that receives the recommendation. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_plan_memory_mode(uint64_t hashesPerKey, unsigned vmCount, size_t memoryLimit, randomx_memory_plan *plan);
+
+/**
+ * Allocates and initializes a cache and, in full mode, a dataset as recommended by a plan.
+ * In full mode the cache memory is released after the dataset is initialized (see
+ * randomx_cache_drain); initializing the cache with a new key allocates it again.
+ *
+ * @param plan is a pointer to a plan filled by randomx_plan_memory_mode. Must not be NULL.
+ * @param key, keySize are the same as for randomx_init_cache.
+ * @param cache receives the initialized cache. Must not be NULL.
+ * @param dataset receives the initialized dataset in full mode and NULL otherwise. Must not be NULL.
+ *
+ * @return 1 on success, 0 if memory allocation fails (nothing is allocated in that case).
+*/
+RANDOMX_EXPORT int randomx_plan_init(const randomx_memory_plan *plan, const void *key, size_t keySize, randomx_cache **cache, randomx_dataset **dataset);
+
+/**
+ * Creates a virtual machine as recommended by a plan (with randomx_create_vm or randomx_create_vm_lazy).
+ *
+ * @param plan is a pointer to a plan filled by randomx_plan_memory_mode. Must not be NULL.
+ * @param cache, dataset are the structures created by randomx_plan_init.
+ *
+ * @return Pointer to an initialized randomx_vm structure or NULL on failure.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_plan_create_vm(const randomx_memory_plan *plan, randomx_cache *cache, randomx_dataset *dataset);
+
+/**
+ * Measures which of the flags supported by the host are the fastest. Each Argon2 implementation
+ * enabled by randomx_get_flags fills a small part of the cache, then a few hashes are calculated
+ * with each alternative of the AES flags (RANDOMX_FLAG_VAES, RANDOMX_FLAG_AES_VPERM) and, with
+ * RANDOMX_FLAG_JIT, of the JIT options of the platform (RANDOMX_FLAG_PREFETCH_T0 and
+ * RANDOMX_FLAG_PREFETCH_SCRATCHPAD on x86-64, RANDOMX_FLAG_JIT_SCHEDULE on ARM64). Takes about
+ * a second in light mode. Each alternative hashes its own inputs, and the item and result caches
+ * of the cache are not used by the measurement, so it must not be called while virtual machines
+ * that use the cache are running.
+ *
+ * @param cache is a pointer to an initialized cache. Must not be NULL if dataset is NULL.
+ * @param dataset is a pointer to an initialized dataset to tune full mode virtual machines,
+ *        NULL to tune light mode virtual machines.
+ * @param hashCount is the number of hashes measured with each alternative, 0 for the default (8).
+ * @param path is the name of a file that keeps the result, NULL to always measure. If the file
+ *        was written on a CPU with the same signature and features, the result is read from it
+ *        and nothing is measured. Otherwise it's overwritten by the new result if possible.
+ * @param tuning is a pointer to the structure that receives the result. Must not be NULL.
+ *
+ * @return 1 on success, 0 if no virtual machine could be created.
+*/
+RANDOMX_EXPORT int randomx_autotune(randomx_cache *cache, randomx_dataset *dataset, unsigned hashCount, const char *path, randomx_tuning *tuning);
+
+/**
+ * Gets the time spent touching the pages of a dataset allocated with RANDOMX_FLAG_PREFAULT.
+ * Subtracting it from the total allocation and initialization time gives the time spent
+ * calculating the dataset items.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure. Must not be NULL.
+ *
+ * @return the time in seconds, 0 if the dataset was allocated without RANDOMX_FLAG_PREFAULT.
+*/
+RANDOMX_EXPORT double randomx_dataset_prefault_time(randomx_dataset *dataset);
+
+/**
+ * Releases all memory occupied by the randomx_dataset structure.
+ *
+ * @param dataset is a pointer to a previously allocated randomx_dataset structure.
+*/
+RANDOMX_EXPORT void randomx_release_dataset(randomx_dataset *dataset);
+
+/**
+ * Creates and initializes a RandomX virtual machine.
+ *
+ * @param flags is any combination of these 10 flags (each flag can be set or not set):
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate scratchpad memory in large pages
+ *        RANDOMX_FLAG_HARD_AES - virtual machine will use hardware accelerated AES
+ *        RANDOMX_FLAG_FULL_MEM - virtual machine will use the full dataset
+ *        RANDOMX_FLAG_JIT - virtual machine will use a JIT compiler
+ *        RANDOMX_FLAG_SECURE - when combined with RANDOMX_FLAG_JIT, the JIT pages are never
+ *                              writable and executable at the same time (W^X policy)
+ *        RANDOMX_FLAG_VAES - when combined with RANDOMX_FLAG_HARD_AES, the scratchpad and program
+ *                            generators and the scratchpad hash use 256-bit VAES instructions
+ *        RANDOMX_FLAG_AES_VPERM - without RANDOMX_FLAG_HARD_AES, the software AES is computed
+ *                                 with constant-time vector shuffles (SSSE3 or NEON) instead
+ *                                 of lookup tables
+ *        RANDOMX_FLAG_PREFETCH_T0 - the x86-64 JIT prefetches the next dataset item with
+ *                                   prefetcht0 instead of prefetchnta (full mode only)
+ *        RANDOMX_FLAG_PREFETCH_SCRATCHPAD - the x86-64 JIT also prefetches the cache line that
+ *                                           follows each scratchpad line read by the next loop
+ *                                           iteration
+ *        RANDOMX_FLAG_JIT_SCHEDULE - the ARM64 JIT reorders the instructions of each program so
+ *                                    that dependent instructions are further apart, which helps
+ *                                    in-order cores
+ *        RANDOMX_FLAG_JIT_SHARED_CODE - the x86-64 JIT code of the VM is placed in a 2 MiB region
+ *                                       of large pages shared with other VMs, which reduces iTLB
+ *                                       misses when many VMs run. With RANDOMX_FLAG_SECURE, the
+ *                                       region is dual mapped and needs reserved large pages.
+ *                                       Without them, the VM keeps its own code buffer.
+ *        The prefetch, scheduling and shared code flags don't change the calculated hash. They are
+ *        ignored without RANDOMX_FLAG_JIT and on other platforms.
+ *        The numeric values of the first 4 flags are ordered so that a higher value will provide
+ *        faster hash calculation and a lower numeric value will provide higher portability.
+ *        Using RANDOMX_FLAG_DEFAULT (all flags not set) works on all platforms, but is the slowest.
+ * @param cache is a pointer to an initialized randomx_cache structure. Can be
+ *        NULL if RANDOMX_FLAG_FULL_MEM is set.
+ * @param dataset is a pointer to a randomx_dataset structure. Can be NULL
+ *        if RANDOMX_FLAG_FULL_MEM is not set.
+ *
+ * @return Pointer to an initialized randomx_vm structure.
+ *         Returns NULL if:
+ *         (1) Scratchpad memory allocation fails.
+ *         (2) The requested initialization flags are not supported on the current platform.
+ *         (3) cache parameter is NULL and RANDOMX_FLAG_FULL_MEM is not set
+ *         (4) dataset parameter is NULL and RANDOMX_FLAG_FULL_MEM is set
+ *         (5) RANDOMX_FLAG_VAES is set without RANDOMX_FLAG_HARD_AES or VAES is not supported
+ *         (6) RANDOMX_FLAG_AES_VPERM is set with RANDOMX_FLAG_HARD_AES or SSSE3/NEON is not supported
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset);
+
+/**
+ * Creates a RandomX virtual machine whose memory is local to a NUMA node. The scratchpad is
+ * bound to the node and the virtual machine reads the node's copy of the dataset if it was
+ * allocated with RANDOMX_FLAG_NUMA. On Windows, a large page scratchpad is allocated on the
+ * node. The virtual machine should be used by a thread running on a CPU of the node
+ * (see randomx_numa_node_cpu_mask).
+ *
+ * @param flags, cache, dataset are the same as for randomx_create_vm.
+ * @param node is the NUMA node number (0 to randomx_numa_node_count() - 1).
+ *
+ * @return Pointer to an initialized randomx_vm structure.
+ *         Returns NULL in the same cases as randomx_create_vm or if the node doesn't exist.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm_on_node(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned node);
+
+/**
+ * Creates and initializes a RandomX virtual machine in lazy mode. Like a virtual machine
+ * created without RANDOMX_FLAG_FULL_MEM, it generates dataset items from the cache, but it keeps
+ * the generated items in a table, so items that are read again don't have to be recalculated.
+ * The hit rate of the table is proportional to its size, which allows a trade-off between the
+ * memory usage of light mode and the speed of full mode. The table is cleared whenever the
+ * virtual machine is reinitialized with a new Cache.
+ *
+ * @param flags is any combination of these 4 flags (each flag can be set or not set):
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate scratchpad memory and the item table in large pages
+ *        RANDOMX_FLAG_HARD_AES - virtual machine will use hardware accelerated AES
+ *        RANDOMX_FLAG_VAES - virtual machine will use 256-bit VAES instructions (see randomx_create_vm)
+ *        RANDOMX_FLAG_AES_VPERM - virtual machine will use the vector permute software AES
+ *                                 (see randomx_create_vm)
+ *        Lazy mode is only supported by the interpreter.
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+ * @param itemCacheSize is the maximum size of the item table in bytes. The table holds the largest
+ *        power of 2 of items that fit (plus 4 bytes per item for bookkeeping).
+ *
+ * @return Pointer to an initialized randomx_vm structure.
+ *         Returns NULL if:
+ *         (1) Scratchpad or item table memory allocation fails.
+ *         (2) The requested initialization flags are not supported.
+ *         (3) itemCacheSize is smaller than RANDOMX_DATASET_ITEM_SIZE
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm_lazy(randomx_flags flags, randomx_cache *cache, size_t itemCacheSize);
+
+/**
+ * Creates and initializes a RandomX virtual machine that calculates several hashes at once
+ * on a single thread. One loop iteration of each lane runs in turn, so the dataset reads of one
+ * lane overlap with the execution of the other lanes. With RANDOMX_FLAG_JIT, the programs of all
+ * lanes are compiled into one function; otherwise the lanes are interpreted round-robin.
+ * The machine can also be used with the single-hash API.
+ *
+ * @param flags is any combination of the flags accepted by randomx_create_vm.
+ *        RANDOMX_FLAG_FULL_MEM must be set.
+ * @param dataset is a pointer to a randomx_dataset structure. Must not be NULL.
+ * @param lanes is the number of hashes calculated at once (2 to 4).
+ *
+ * @return Pointer to an initialized randomx_vm structure.
+ *         Returns NULL if:
+ *         (1) Scratchpad memory allocation fails.
+ *         (2) The requested initialization flags are not supported on the current platform.
+ *         (3) RANDOMX_FLAG_JIT is set and interleaved compilation is not supported on the current
+ *             platform (only x86-64 is supported).
+ *         (4) lanes is out of range
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm_interleaved(randomx_flags flags, randomx_dataset *dataset, unsigned lanes);
+
+/**
+ * Reinitializes a virtual machine with a new Cache. This function should be called anytime
+ * the Cache is reinitialized with a new key. Does nothing if called with a Cache containing
+ * the same key value as already set.
+ *
+ * @param machine is a pointer to a randomx_vm structure that was initialized
+ *        without RANDOMX_FLAG_FULL_MEM. Must not be NULL.
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_set_cache(randomx_vm *machine, randomx_cache* cache);
+
+/**
+ * Starts a helper thread that computes the dataset item read in the next program iteration
+ * while the current iteration runs. The item is handed over to the virtual machine when it's
+ * read; if the helper hasn't started it yet, the virtual machine computes it itself.
+ * This hides most of the cost of the dataset item calculation if the helper thread runs on
+ * the SMT sibling of the thread that calculates the hashes. The thread is stopped when the
+ * virtual machine is destroyed. Calling this function again has no effect.
+ *
+ * @param machine is a pointer to a randomx_vm structure that was initialized without
+ *        RANDOMX_FLAG_FULL_MEM and RANDOMX_FLAG_JIT (including randomx_create_vm_lazy).
+ *        Must not be NULL.
+ * @param cpu is the index of the CPU the helper thread is pinned to, -1 to not pin it.
+ *
+ * @return 1 if the helper thread is running, 0 if the virtual machine doesn't support it
+ *         or the thread could not be created.
+*/
+RANDOMX_EXPORT int randomx_vm_enable_item_helper(randomx_vm *machine, int cpu);
+
+/**
+ * Reinitializes a virtual machine with a new Dataset.
+ *
+ * @param machine is a pointer to a randomx_vm structure that was initialized
+ *        with RANDOMX_FLAG_FULL_MEM. Must not be NULL.
+ * @param dataset is a pointer to an initialized randomx_dataset structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_set_dataset(randomx_vm *machine, randomx_dataset *dataset);
+
+/**
+ * Releases all memory occupied by the randomx_vm structure.
+ *
+ * @param machine is a pointer to a previously created randomx_vm structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_vm(randomx_vm *machine);
+
+/**
+ * Gets the number of hashes and programs processed by a virtual machine and the cycles
+ * spent in each phase of the hash calculation since the virtual machine was created.
+ * The counters are only collected if the library was compiled with RANDOMX_STATS defined,
+ * otherwise the instrumentation has no cost. Cycles are counted with the time stamp counter
+ * on x86, the virtual counter on ARMv8 and in nanoseconds on other platforms.
+ * For interleaved virtual machines, the seed, scratchpad and program phases of the other
+ * lanes are not included.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param stats is a pointer to the structure to be filled. Must not be NULL.
+ *
+ * @return 1 if the counters are collected, 0 if the library was built without RANDOMX_STATS
+ *         (the counters are all 0 in that case, except the result cache counters).
+*/
+RANDOMX_EXPORT int randomx_vm_get_stats(randomx_vm *machine, randomx_vm_stats *stats);
+
+/**
+ * Allocates a single region of memory for the scratchpads of up to count virtual machines.
+ * The page-aligned scratchpads are packed contiguously and followed by the virtual machine
+ * objects (including their register files), so many virtual machines use few large pages
+ * and their memory is accounted for at once.
+ *
+ * @param count is the number of virtual machines that can be created in the arena.
+ * @param flags is any combination of these 2 flags (each flag can be set or not set):
+ *        RANDOMX_FLAG_LARGE_PAGES - allocate memory in large pages
+ *        RANDOMX_FLAG_DEFAULT - all flags not set, use standard page size
+ *        Other flags are ignored.
+ *
+ * @return Pointer to an allocated randomx_scratchpad_arena structure.
+ *         Returns NULL if count is 0 or memory allocation fails.
+*/
+RANDOMX_EXPORT randomx_scratchpad_arena *randomx_alloc_scratchpad_arena(unsigned count, randomx_flags flags);
+
+/**
+ * Same as randomx_alloc_scratchpad_arena, with the given layout of the slots.
+ * Virtual machines on the SMT siblings of a core share its L1 and L2 caches. Their random
+ * accesses to the RANDOMX_SCRATCHPAD_L1 region at the start of the scratchpad are confined to
+ * the L2 sets indexed by that range of addresses, so scratchpads aligned to their size compete
+ * for the same part of the L2. RANDOMX_ARENA_STAGGERED shifts each slot by RANDOMX_SCRATCHPAD_L1
+ * against the previous one, so the L1 regions of consecutive slots fall on disjoint L2 sets
+ * (up to the L2 way size divided by RANDOMX_SCRATCHPAD_L1 slots, e.g. 4 with 64 KiB ways).
+ * The virtual machine objects are staggered as well. The effect requires large pages, with
+ * standard pages the set index bits above the page offset are chosen by the operating system.
+ * A new arena hands out its slots in increasing order, so VMs created one after another for threads placed with
+ * RANDOMX_PLACEMENT_SMT_PAIRS get consecutive slots on the same core.
+ *
+ * @param count, flags are the same as for randomx_alloc_scratchpad_arena.
+ * @param layout is the layout of the slots.
+ *
+ * @return Pointer to an allocated randomx_scratchpad_arena structure.
+ *         Returns NULL if count is 0 or memory allocation fails.
+*/
+RANDOMX_EXPORT randomx_scratchpad_arena *randomx_alloc_scratchpad_arena_layout(unsigned count, randomx_flags flags, randomx_arena_layout layout);
+
+/**
+ * Creates and initializes a RandomX virtual machine in a free slot of a scratchpad arena.
+ * No memory is allocated for the scratchpad. The slot is released by randomx_destroy_vm.
+ * Thread-safe with respect to the arena.
+ *
+ * @param flags, cache, dataset are the same as for randomx_create_vm.
+ *        RANDOMX_FLAG_LARGE_PAGES has no effect (see randomx_alloc_scratchpad_arena).
+ * @param arena is a pointer to a randomx_scratchpad_arena structure. Must not be NULL.
+ *
+ * @return Pointer to an initialized randomx_vm structure.
+ *         Returns NULL in the same cases as randomx_create_vm or if the arena has no free slot.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_create_vm_arena(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, randomx_scratchpad_arena *arena);
+
+/**
+ * Releases the memory of a scratchpad arena. All virtual machines created in the arena
+ * must be destroyed first.
+ *
+ * @param arena is a pointer to a previously allocated randomx_scratchpad_arena structure.
+*/
+RANDOMX_EXPORT void randomx_release_scratchpad_arena(randomx_scratchpad_arena *arena);
+
+/**
+ * Creates a randomx_epoch structure that holds two cache/dataset pairs: the current pair used
+ * by virtual machines and the next pair that is prepared in the background for a new key.
+ *
+ * @param flags is the flags passed to randomx_alloc_cache. If RANDOMX_FLAG_FULL_MEM is set, datasets
+ *        are allocated too, using RANDOMX_FLAG_LARGE_PAGES and RANDOMX_FLAG_NUMA if set.
+ * @param threadCount is the number of threads used to initialize datasets (0 selects the
+ *        number of hardware threads).
+ *
+ * @return Pointer to an allocated randomx_epoch structure.
+ *         Returns NULL if memory allocation fails or the flags are not supported.
+*/
+RANDOMX_EXPORT randomx_epoch *randomx_create_epoch(randomx_flags flags, unsigned threadCount);
+
+/**
+ * Starts preparing the next cache (and dataset) for a new key on a background thread
+ * with a lowered priority. Virtual machines can keep using the current pair in the meantime.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key value. Must not be NULL.
+ * @param keySize is the number of bytes of the key.
+ *
+ * @return 1 if the preparation was started, 0 if a preparation is already in progress
+ *         or the background thread cannot be created.
+*/
+RANDOMX_EXPORT int randomx_epoch_prepare(randomx_epoch *epoch, const void *key, size_t keySize);
+
+/**
+ * Makes the prepared cache/dataset pair current. Virtual machines follow on their next
+ * call to randomx_epoch_sync_vm. The pair that was current before is reused by the next
+ * preparation once all virtual machines have moved on.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure. Must not be NULL.
+ * @param wait if nonzero, waits for a preparation in progress to finish.
+ *
+ * @return 1 if the switch was made, 0 if no prepared pair is available.
+*/
+RANDOMX_EXPORT int randomx_epoch_switch(randomx_epoch *epoch, int wait);
+
+/**
+ * Gets the current cache of an epoch, e.g. to create virtual machines.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure. Must not be NULL.
+ *
+ * @return Pointer to the current randomx_cache structure, NULL before the first switch.
+*/
+RANDOMX_EXPORT randomx_cache *randomx_epoch_cache(randomx_epoch *epoch);
+
+/**
+ * Gets the current dataset of an epoch, e.g. to create virtual machines.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure. Must not be NULL.
+ *
+ * @return Pointer to the current randomx_dataset structure, NULL before the first switch
+ *         or if the epoch was created without RANDOMX_FLAG_FULL_MEM.
+*/
+RANDOMX_EXPORT randomx_dataset *randomx_epoch_dataset(randomx_epoch *epoch);
+
+/**
+ * Retargets a virtual machine to the current cache/dataset pair of an epoch. Should be called
+ * by the thread that owns the virtual machine before calculating hashes. If the virtual machine
+ * already uses the current pair, this is a single atomic load.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure after the first switch. Must not be NULL.
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_epoch_sync_vm(randomx_epoch *epoch, randomx_vm *machine);
+
+/**
+ * Stops tracking a virtual machine. Must be called before a virtual machine that was passed
+ * to randomx_epoch_sync_vm is destroyed.
+ *
+ * @param epoch is a pointer to a randomx_epoch structure. Must not be NULL.
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_epoch_detach_vm(randomx_epoch *epoch, randomx_vm *machine);
+
+/**
+ * Waits for a preparation in progress and releases all memory occupied by the randomx_epoch
+ * structure. All virtual machines must be detached first.
+ *
+ * @param epoch is a pointer to a previously created randomx_epoch structure.
+*/
+RANDOMX_EXPORT void randomx_release_epoch(randomx_epoch *epoch);
+
+/**
+ * Creates a pool of light-mode virtual machines for verifying hashes under several keys.
+ * The pool keeps up to cacheCount initialized caches, each with its own virtual machines, and
+ * reinitializes the least recently used cache when a hash is requested for a new key. Virtual
+ * machines stay bound to their cache, so requests for known keys never recompile code.
+ *
+ * @param flags is the flags passed to randomx_alloc_cache and randomx_create_vm.
+ *        RANDOMX_FLAG_FULL_MEM is ignored.
+ * @param cacheCount is the maximum number of keys kept initialized at once.
+ * @param vmsPerCache is the maximum number of virtual machines per key, i.e. the number of hashes
+ *        that can be calculated concurrently for one key. Virtual machines are created on demand.
+ *
+ * @return Pointer to a randomx_verifier structure.
+ *         Returns NULL if memory allocation fails or cacheCount or vmsPerCache is 0.
+*/
+RANDOMX_EXPORT randomx_verifier *randomx_create_verifier(randomx_flags flags, unsigned cacheCount, unsigned vmsPerCache);
+
+/**
+ * Initializes a cache of the pool for a key in advance, so the first hash for the key doesn't
+ * have to wait for the cache initialization. Thread-safe.
+ *
+ * @param verifier is a pointer to a randomx_verifier structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key value. Must not be NULL.
+ * @param keySize is the number of bytes of the key.
+ *
+ * @return 1 on success, 0 if cache memory allocation fails.
+*/
+RANDOMX_EXPORT int randomx_verifier_prepare_key(randomx_verifier *verifier, const void *key, size_t keySize);
+
+/**
+ * Calculates a RandomX hash value using an idle virtual machine of the pool bound to the key.
+ * Waits if the key is being initialized by another thread or all its virtual machines are busy.
+ * Thread-safe.
+ *
+ * @param verifier is a pointer to a randomx_verifier structure. Must not be NULL.
+ * @param key is a pointer to memory which contains the key value. Must not be NULL.
+ * @param keySize is the number of bytes of the key.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param output is a pointer to memory where the hash will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ *
+ * @return 1 on success, 0 if cache or virtual machine memory allocation fails.
+*/
+RANDOMX_EXPORT int randomx_verifier_calculate_hash(randomx_verifier *verifier, const void *key, size_t keySize, const void *input, size_t inputSize, void *output);
+
+/**
+ * Releases all memory occupied by the randomx_verifier structure. No hash calculations
+ * may be in progress.
+ *
+ * @param verifier is a pointer to a previously created randomx_verifier structure.
+*/
+RANDOMX_EXPORT void randomx_release_verifier(randomx_verifier *verifier);
+
+/**
+ * Creates a pool of virtual machines that are kept allocated between uses, so services with
+ * a varying number of concurrent hashes don't have to create and destroy virtual machines.
+ * Scratchpads and JIT code buffers are reused and a virtual machine is only rebound when
+ * the cache or dataset of the pool was changed since it was last acquired.
+ *
+ * @param flags, cache, dataset are passed to randomx_create_vm (see there).
+ * @param count is the number of virtual machines of the pool. All of them are created upfront.
+ *
+ * @return Pointer to a randomx_vm_pool structure.
+ *         Returns NULL if count is 0 or any of the virtual machines cannot be created.
+*/
+RANDOMX_EXPORT randomx_vm_pool *randomx_vm_pool_create(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned count);
+
+/**
+ * Takes an idle virtual machine from the pool. Thread-safe.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ * @param wait if nonzero, waits until a virtual machine is released if all of them are in use.
+ *
+ * @return Pointer to a virtual machine bound to the current cache and dataset of the pool.
+ *         NULL if wait is 0 and all virtual machines are in use.
+*/
+RANDOMX_EXPORT randomx_vm *randomx_vm_pool_acquire(randomx_vm_pool *pool, int wait);
+
+/**
+ * Returns a virtual machine to the pool. Thread-safe.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ * @param machine is a virtual machine acquired from the same pool. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_pool_release(randomx_vm_pool *pool, randomx_vm *machine);
+
+/**
+ * Changes the cache or the dataset used by the pool. Idle virtual machines are rebound when they
+ * are acquired next time, virtual machines in use keep the previous cache or dataset until they
+ * are released. Thread-safe.
+ *
+ * @param pool is a pointer to a randomx_vm_pool structure. Must not be NULL.
+ * @param cache is a pointer to an initialized randomx_cache structure. Must not be NULL.
+ * @param dataset is a pointer to an initialized randomx_dataset structure. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_vm_pool_set_cache(randomx_vm_pool *pool, randomx_cache *cache);
+RANDOMX_EXPORT void randomx_vm_pool_set_dataset(randomx_vm_pool *pool, randomx_dataset *dataset);
+
+/**
+ * Destroys all virtual machines of the pool and releases the pool. All virtual machines
+ * must be released first.
+ *
+ * @param pool is a pointer to a previously created randomx_vm_pool structure.
+*/
+RANDOMX_EXPORT void randomx_vm_pool_destroy(randomx_vm_pool *pool);
+
+/**
+ * Creates a scheduler that distributes a range of nonces between mining threads. Each thread
+ * starts with an equal share and takes batchSize nonces at a time from it, so threads don't
+ * contend for a shared counter. A thread that runs out of nonces steals half of the largest
+ * remaining share, preferring threads whose virtual machine is on the same NUMA node.
+ *
+ * @param threadCount is the number of threads that call randomx_nonce_scheduler_next.
+ * @param batchSize is the number of nonces a thread takes from its share at once.
+ *
+ * @return Pointer to a randomx_nonce_scheduler structure with an empty range of nonces.
+ *         Returns NULL if memory allocation fails or threadCount or batchSize is 0.
+*/
+RANDOMX_EXPORT randomx_nonce_scheduler *randomx_nonce_scheduler_create(unsigned threadCount, uint32_t batchSize);
+
+/**
+ * Sets the range of nonces to be distributed and splits it evenly between the threads.
+ * Must not be called while any thread is in randomx_nonce_scheduler_next.
+ *
+ * @param scheduler is a pointer to a randomx_nonce_scheduler structure. Must not be NULL.
+ * @param firstNonce is the first nonce of the range.
+ * @param nonceCount is the number of nonces. firstNonce + nonceCount must not exceed 2^32 - 1.
+*/
+RANDOMX_EXPORT void randomx_nonce_scheduler_reset(randomx_nonce_scheduler *scheduler, uint32_t firstNonce, uint32_t nonceCount);
+
+/**
+ * Tells the scheduler the virtual machine used by a thread. The NUMA node of a virtual machine
+ * created with randomx_create_vm_on_node is used to steal nonces from the same node first.
+ *
+ * @param scheduler is a pointer to a randomx_nonce_scheduler structure. Must not be NULL.
+ * @param thread is the index of the thread (0 to threadCount - 1).
+ * @param machine is a pointer to the virtual machine of the thread. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_nonce_scheduler_set_vm(randomx_nonce_scheduler *scheduler, unsigned thread, randomx_vm *machine);
+
+/**
+ * Gets the next nonce of a thread. Each thread index must be used by one thread at a time.
+ *
+ * @param scheduler is a pointer to a randomx_nonce_scheduler structure. Must not be NULL.
+ * @param thread is the index of the thread (0 to threadCount - 1).
+ * @param nonce is a pointer where the nonce will be stored. Must not be NULL.
+ *
+ * @return 1 if a nonce was stored, 0 if all nonces of the range have been handed out.
+*/
+RANDOMX_EXPORT int randomx_nonce_scheduler_next(randomx_nonce_scheduler *scheduler, unsigned thread, uint32_t *nonce);
+
+/**
+ * Releases the scheduler.
+ *
+ * @param scheduler is a pointer to a previously created randomx_nonce_scheduler structure.
+*/
+RANDOMX_EXPORT void randomx_nonce_scheduler_destroy(randomx_nonce_scheduler *scheduler);
+
+/**
+ * Creates an engine that calculates hashes asynchronously on its own threads. Each thread owns
+ * a virtual machine and a lock-free queue of requests. When requests are queued up, a thread
+ * calculates them with randomx_calculate_hash_first/next/last.
+ *
+ * @param flags is the flags passed to randomx_create_vm.
+ * @param cache is the cache passed to randomx_create_vm. Must stay valid until the engine is destroyed.
+ * @param dataset is the dataset passed to randomx_create_vm. Must stay valid until the engine is destroyed.
+ * @param threadCount is the number of threads and virtual machines.
+ *
+ * @return Pointer to a randomx_engine structure.
+ *         Returns NULL if threadCount is 0, virtual machine creation fails or threads
+ *         cannot be started.
+*/
+RANDOMX_EXPORT randomx_engine *randomx_engine_create(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset, unsigned threadCount);
+
+/**
+ * Submits a hash calculation. The input is copied, so it can be reused as soon as the function
+ * returns. Thread-safe and does not wait for the calculation.
+ *
+ * @param engine is a pointer to a randomx_engine structure. Must not be NULL.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param callback is called with the hash from a thread of the engine. Must not be NULL.
+ *        The hash is only valid during the call. Callbacks should not block, because
+ *        they delay the other requests of the thread.
+ * @param userData is passed to the callback.
+ *
+ * @return 1 on success, 0 if memory allocation fails.
+*/
+RANDOMX_EXPORT int randomx_engine_submit(randomx_engine *engine, const void *input, size_t inputSize, randomx_hash_callback *callback, void *userData);
+
+/**
+ * Adapts the number of threads that receive new requests to the memory bandwidth. Past a
+ * host-specific number of threads, dataset reads saturate the memory bandwidth and more threads
+ * lower the total hashrate. The engine measures the hashrate in every interval and tries one
+ * thread more or less every few intervals, keeping the count if the hashrate improves. When
+ * the hashrate drops, e.g. because other processes or a dataset initialization compete for the
+ * bandwidth, it tries fewer threads right away. Intervals in which threads run out of requests
+ * don't change the count. Threads that stop receiving requests finish their queued ones.
+ * Must not be called concurrently with itself or randomx_engine_destroy.
+ *
+ * @param engine is a pointer to a randomx_engine structure. Must not be NULL.
+ * @param minThreads is the minimum number of threads. Must be between 1 and the thread count
+ *        of the engine.
+ * @param intervalMs is the measurement interval in milliseconds. It should cover many hashes
+ *        of all threads. 0 disables autoscaling and makes all threads receive requests again.
+ *
+ * @return 1 on success, 0 if the controller thread cannot be started (autoscaling is disabled
+ *         in that case).
+*/
+RANDOMX_EXPORT int randomx_engine_set_autoscale(randomx_engine *engine, unsigned minThreads, unsigned intervalMs);
+
+/**
+ * Reads the counters of an engine. Thread-safe.
+ *
+ * @param engine is a pointer to a randomx_engine structure. Must not be NULL.
+ * @param stats is a pointer to the structure that receives the counters. Must not be NULL.
+*/
+RANDOMX_EXPORT void randomx_engine_get_stats(randomx_engine *engine, randomx_engine_stats *stats);
+
+/**
+ * Waits until all submitted hashes have been calculated and their callbacks have returned,
+ * then stops the threads and releases the engine. No submissions may be made concurrently.
+ *
+ * @param engine is a pointer to a previously created randomx_engine structure.
+*/
+RANDOMX_EXPORT void randomx_engine_destroy(randomx_engine *engine);
+
+/**
+ * Calculates a RandomX hash value.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param output is a pointer to memory where the hash will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash(randomx_vm *machine, const void *input, size_t inputSize, void *output);
+
+/**
+ * Same as randomx_calculate_hash, but the input is given as count segments which are
+ * hashed in order as if they were one contiguous buffer, so they don't need to be copied.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param parts is an array of count input segments. Must not be NULL if count > 0.
+ * @param count is the number of segments.
+ * @param output is a pointer to memory where the hash will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_parts(randomx_vm *machine, const randomx_buffer *parts, size_t count, void *output);
+
+/**
+ * Set of functions used to calculate multiple RandomX hashes more efficiently.
+ * randomx_calculate_hash_first will begin a hash calculation.
+ * randomx_calculate_hash_next  will output the hash value of the previous input
+ *                              and begin the calculation of the next hash.
+ * randomx_calculate_hash_last  will output the hash value of the previous input.
+ *
+ * WARNING: These functions may alter the floating point rounding mode of the calling thread.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param nextInput is a pointer to memory to be hashed for the next hash. Must not be NULL.
+ * @param nextInputSize is the number of bytes to be hashed for the next hash.
+ * @param output is a pointer to memory where the hash will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_first(randomx_vm* machine, const void* input, size_t inputSize);
+RANDOMX_EXPORT void randomx_calculate_hash_next(randomx_vm* machine, const void* nextInput, size_t nextInputSize, void* output);
+RANDOMX_EXPORT void randomx_calculate_hash_last(randomx_vm* machine, void* output);
+
+/**
+ * Scatter-gather variants of randomx_calculate_hash_first/next. The segments are hashed
+ * in order as if they were one contiguous buffer and may be released as soon as the call
+ * returns. They can be mixed freely with the contiguous functions of the same pipeline.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_first_parts(randomx_vm* machine, const randomx_buffer* parts, size_t count);
+RANDOMX_EXPORT void randomx_calculate_hash_next_parts(randomx_vm* machine, const randomx_buffer* nextParts, size_t nextCount, void* output);
+
+/**
+ * Calculates RandomX hashes of several independent inputs using a single call.
+ * Internally uses the randomx_calculate_hash_first/next/last pipeline, so the scratchpad
+ * of each input is filled while the hash of the previous input is being finalized.
+ * The floating point environment of the calling thread is saved and restored once per batch.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputs is an array of count pointers to memory to be hashed. Must not be NULL.
+ * @param inputSizes is an array of count sizes of the respective inputs. Must not be NULL.
+ * @param count is the number of inputs.
+ * @param output is a pointer to memory where the hashes will be stored. Must not
+ *        be NULL and at least count * RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        The hash of inputs[i] is stored at offset i * RANDOMX_HASH_SIZE.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_batch(randomx_vm* machine, const void* const* inputs, const size_t* inputSizes, size_t count, void* output);
+
+/**
+ * Searches a range of nonces for hashes that meet a target. The hashes are calculated using
+ * the randomx_calculate_hash_first/next/last pipeline, so only the matching nonces leave the library.
+ * The bytes of the block template before the nonce are only hashed once per search.
+ * The floating point environment of the calling thread is saved and restored once per search.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param blockTemplate is a pointer to the input to be hashed. Must not be NULL. The nonce field
+ *        is overwritten and holds the last nonce of the range when the function returns.
+ * @param size is the number of bytes to be hashed.
+ * @param nonceOffset is the offset of the 32-bit little-endian nonce in the block template.
+ *        nonceOffset + 4 must not be larger than size.
+ * @param nonceStart is the first nonce of the range. The nonce wraps around after 0xFFFFFFFF.
+ * @param count is the number of nonces to search.
+ * @param target is a pointer to a 256-bit little-endian number (RANDOMX_HASH_SIZE bytes).
+ *        A hash, read as a 256-bit little-endian number, matches if it's less than or equal
+ *        to the target. Must not be NULL.
+ * @param results is a pointer to memory where the matching nonces will be stored in ascending
+ *        order of the range. Must not be NULL and room for at least count nonces must be available.
+ *
+ * @return The number of matching nonces.
+*/
+RANDOMX_EXPORT size_t randomx_search(randomx_vm *machine, void *blockTemplate, size_t size, size_t nonceOffset, uint32_t nonceStart, uint32_t count, const void *target, uint32_t *results);
+
+/**
+ * Creates a template of inputs that differ only in a 32-bit little-endian nonce field.
+ * The Blake2b state after the bytes before the nonce is calculated once, so hashing an input
+ * of the template only compresses the Blake2b blocks from the one containing the nonce onwards.
+ *
+ * @param input is a pointer to the input. Must not be NULL. The input is copied.
+ * @param size is the number of bytes of the input.
+ * @param nonceOffset is the offset of the nonce in the input.
+ *
+ * @return Pointer to a randomx_input_template structure.
+ *         Returns NULL if:
+ *         (1) nonceOffset + 4 is larger than size
+ *         (2) Memory allocation fails.
+*/
+RANDOMX_EXPORT randomx_input_template *randomx_create_input_template(const void *input, size_t size, size_t nonceOffset);
+
+/**
+ * Releases an input template. NULL is ignored.
+ *
+ * @param inputTemplate is a pointer to a previously created randomx_input_template structure.
+*/
+RANDOMX_EXPORT void randomx_destroy_input_template(randomx_input_template *inputTemplate);
+
+/**
+ * Calculates the RandomX hashes of a range of nonces of an input template, like
+ * randomx_calculate_hash_batch. A template can be used by several threads at once.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputTemplate is a pointer to a randomx_input_template structure. Must not be NULL.
+ * @param nonceStart is the first nonce of the range. The nonce wraps around after 0xFFFFFFFF.
+ * @param count is the number of nonces.
+ * @param output is a pointer to memory where the hashes will be stored. Must not be NULL and
+ *        at least count * RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        The hash of nonce nonceStart + i is stored at offset i * RANDOMX_HASH_SIZE.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_template_batch(randomx_vm *machine, const randomx_input_template *inputTemplate, uint32_t nonceStart, uint32_t count, void *output);
+
+/**
+ * Same as randomx_search, but hashes the nonces of an input template.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputTemplate is a pointer to a randomx_input_template structure. Must not be NULL.
+ * @param nonceStart is the first nonce of the range. The nonce wraps around after 0xFFFFFFFF.
+ * @param count is the number of nonces to search.
+ * @param target is a pointer to a 256-bit little-endian number (RANDOMX_HASH_SIZE bytes). Must not be NULL.
+ * @param results is a pointer to memory where the matching nonces will be stored. Must not be NULL
+ *        and room for at least count nonces must be available.
+ *
+ * @return The number of matching nonces.
+*/
+RANDOMX_EXPORT size_t randomx_search_template(randomx_vm *machine, const randomx_input_template *inputTemplate, uint32_t nonceStart, uint32_t count, const void *target, uint32_t *results);
+
+/**
+ * Calculates one RandomX hash per lane of a virtual machine created by randomx_create_vm_interleaved.
+ * For other virtual machines, this is equivalent to randomx_calculate_hash.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputs is an array of pointers to memory to be hashed, one per lane. Must not be NULL.
+ * @param inputSizes is an array of sizes of the respective inputs. Must not be NULL.
+ * @param output is a pointer to memory where the hashes will be stored. Must not be NULL and
+ *        at least lanes * RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        The hash of inputs[i] is stored at offset i * RANDOMX_HASH_SIZE.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_interleaved(randomx_vm* machine, const void* const* inputs, const size_t* inputSizes, void* output);
+
+/**
+ * Calculate a RandomX commitment from a RandomX hash and its input.
+ *
+ * @param input is a pointer to memory that was hashed. Must not be NULL.
+ * @param inputSize is the number of bytes in the input.
+ * @param hash_in is the output from randomx_calculate_hash* (RANDOMX_HASH_SIZE bytes).
+ * @param com_out is a pointer to memory where the commitment will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+*/
+RANDOMX_EXPORT void randomx_calculate_commitment(const void* input, size_t inputSize, const void* hash_in, void* com_out);
+
+/**
+ * Same as randomx_calculate_commitment, but the input is given as count segments
+ * which are hashed in order as if they were one contiguous buffer.
+*/
+RANDOMX_EXPORT void randomx_calculate_commitment_parts(const randomx_buffer* parts, size_t count, const void* hash_in, void* com_out);
+
+/**
+ * Calculates RandomX commitments of several hashes with inputs of equal size. Several commitments
+ * are calculated in parallel using AVX2 or AVX-512 if supported by the CPU.
+ *
+ * @param inputs is an array of count pointers to memory that was hashed. Must not be NULL.
+ * @param inputSize is the number of bytes in each input.
+ * @param hashes is a pointer to count consecutive outputs of randomx_calculate_hash*
+ *        (count * RANDOMX_HASH_SIZE bytes), e.g. the output of randomx_calculate_hash_batch.
+ * @param count is the number of commitments.
+ * @param output is a pointer to memory where the commitments will be stored. Must not
+ *        be NULL and at least count * RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        Can be the same as hashes.
+*/
+RANDOMX_EXPORT void randomx_calculate_commitment_batch(const void* const* inputs, size_t inputSize, const void* hashes, size_t count, void* output);
+
+/**
+ * Returns the number of levels of the Merkle tree of count commitments above the leaves,
+ * which is the number of nodes in an authentication path (0 for a single commitment).
+*/
+RANDOMX_EXPORT unsigned randomx_commitment_merkle_depth(size_t count);
+
+/**
+ * Calculates the root of a binary Merkle tree over count commitments. A parent node is the
+ * Blake2b hash (RANDOMX_HASH_SIZE bytes) of its two children concatenated; the last node of
+ * a level with an odd number of nodes is paired with itself. The nodes of each level are
+ * hashed in parallel using AVX2 or AVX-512 if supported by the CPU.
+ * Because of the pairing rule, the root doesn't commit to count; protocols that need it
+ * should commit to it separately.
+ *
+ * @param commitments is a pointer to count consecutive commitments (count * RANDOMX_HASH_SIZE bytes).
+ * @param count is the number of commitments. Must be at least 1.
+ * @param root is a pointer to memory where the root will be stored. Must not be NULL and
+ *        at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param paths is NULL or a pointer to memory where the authentication paths of all commitments
+ *        will be stored: count * randomx_commitment_merkle_depth(count) * RANDOMX_HASH_SIZE bytes.
+ *        The path of commitment i starts at offset i * depth * RANDOMX_HASH_SIZE and lists
+ *        the sibling node on each level from the leaves up.
+ *
+ * @return 1 on success, 0 if count is 0 or memory allocation failed.
+*/
+RANDOMX_EXPORT int randomx_commitment_merkle_root(const void* commitments, size_t count, void* root, void* paths);
+
+/**
+ * Checks an authentication path produced by randomx_commitment_merkle_root.
+ *
+ * @param commitment is a pointer to the commitment (RANDOMX_HASH_SIZE bytes).
+ * @param index is the position of the commitment in the tree.
+ * @param count is the number of commitments in the tree.
+ * @param path is a pointer to randomx_commitment_merkle_depth(count) * RANDOMX_HASH_SIZE bytes.
+ * @param root is a pointer to the expected root (RANDOMX_HASH_SIZE bytes).
+ *
+ * @return 1 if the path leads from the commitment to the root, 0 otherwise.
+*/
+RANDOMX_EXPORT int randomx_commitment_merkle_verify(const void* commitment, size_t index, size_t count, const void* path, const void* root);
+
+/**
+ * Creates a builder that calculates the same Merkle root as randomx_commitment_merkle_root
+ * incrementally, in constant memory, while the commitments are produced. Commitments are
+ * hashed in chunks of 256 with the multi-buffer kernel.
+ *
+ * @return Pointer to the builder or NULL if memory allocation failed.
+*/
+RANDOMX_EXPORT randomx_merkle_builder *randomx_merkle_builder_create(void);
+
+/**
+ * Appends count consecutive commitments (count * RANDOMX_HASH_SIZE bytes) to the tree.
+*/
+RANDOMX_EXPORT void randomx_merkle_builder_add(randomx_merkle_builder *builder, const void *commitments, size_t count);
+
+/**
+ * Stores the root of the commitments added so far. More commitments can be added afterwards.
+ *
+ * @return 1 on success, 0 if no commitments were added.
+*/
+RANDOMX_EXPORT int randomx_merkle_builder_root(randomx_merkle_builder *builder, void *root);
+
+/**
+ * Removes all commitments from the builder.
+*/
+RANDOMX_EXPORT void randomx_merkle_builder_reset(randomx_merkle_builder *builder);
+
+/**
+ * Releases a builder created by randomx_merkle_builder_create.
+*/
+RANDOMX_EXPORT void randomx_merkle_builder_destroy(randomx_merkle_builder *builder);
+
+/**
+ * Calculates a RandomX hash value and its commitment in one call. The input is absorbed
+ * for the commitment while it's being hashed, so it's only read once and the result is
+ * the same as randomx_calculate_hash followed by randomx_calculate_commitment.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param hash_out is a pointer to memory where the hash will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param com_out is a pointer to memory where the commitment will be stored. Must not
+ *        be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        Can be the same as hash_out.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_and_commitment(randomx_vm *machine, const void *input, size_t inputSize, void *hash_out, void *com_out);
+
+/**
+ * Pipelined variants of randomx_calculate_hash_and_commitment that work like
+ * randomx_calculate_hash_first/next/last. Each input only needs to stay valid until
+ * the call that passes it returns.
+ *
+ * WARNING: These functions may alter the floating point rounding mode of the calling thread.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param input is a pointer to memory to be hashed. Must not be NULL.
+ * @param inputSize is the number of bytes to be hashed.
+ * @param nextInput is a pointer to memory to be hashed for the next hash. Must not be NULL.
+ * @param nextInputSize is the number of bytes to be hashed for the next hash.
+ * @param hash_out is a pointer to memory where the hash of the previous input will be stored.
+ *        Must not be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param com_out is a pointer to memory where the commitment of the previous input will be stored.
+ *        Must not be NULL and at least RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        Can be the same as hash_out.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_and_commitment_first(randomx_vm *machine, const void *input, size_t inputSize);
+RANDOMX_EXPORT void randomx_calculate_hash_and_commitment_next(randomx_vm *machine, const void *nextInput, size_t nextInputSize, void *hash_out, void *com_out);
+RANDOMX_EXPORT void randomx_calculate_hash_and_commitment_last(randomx_vm *machine, void *hash_out, void *com_out);
+
+/**
+ * Calculates RandomX hashes and commitments of several independent inputs using a single call.
+ * Internally uses the randomx_calculate_hash_and_commitment_first/next/last pipeline.
+ * The floating point environment of the calling thread is saved and restored once per batch.
+ *
+ * @param machine is a pointer to a randomx_vm structure. Must not be NULL.
+ * @param inputs is an array of count pointers to memory to be hashed. Must not be NULL.
+ * @param inputSizes is an array of count sizes of the respective inputs. Must not be NULL.
+ * @param count is the number of inputs.
+ * @param hashes is a pointer to memory where the hashes will be stored. Must not
+ *        be NULL and at least count * RANDOMX_HASH_SIZE bytes must be available for writing.
+ * @param commitments is a pointer to memory where the commitments will be stored. Must not
+ *        be NULL and at least count * RANDOMX_HASH_SIZE bytes must be available for writing.
+ *        Can be the same as hashes. The results of inputs[i] are stored at offset i * RANDOMX_HASH_SIZE.
+*/
+RANDOMX_EXPORT void randomx_calculate_hash_and_commitment_batch(randomx_vm *machine, const void *const *inputs, const size_t *inputSizes, size_t count, void *hashes, void *commitments);
 
 #if defined(__cplusplus)
 }
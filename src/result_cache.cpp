@@ -0,0 +1,120 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <cstring>
+#include "result_cache.hpp"
+#include "allocator.hpp"
+#include "common.hpp"
+
+namespace randomx {
+
+	static_assert(RANDOMX_HASH_SIZE == SharedResultCache::ResultWords * sizeof(uint64_t), "Invalid result size");
+
+	SharedResultCache::SharedResultCache(size_t size) : generation(0) {
+		const size_t setSize = Ways * sizeof(Slot);
+		setCount = 1;
+		while (setCount < (1U << 31) && 2 * (uint64_t)setCount * setSize <= size)
+			setCount *= 2;
+		const size_t slotCount = (size_t)setCount * Ways;
+		memorySize = slotCount * sizeof(Slot);
+		slots = (Slot*)AlignedAllocator<CacheLineSize>::allocMemory(memorySize);
+		for (size_t i = 0; i < slotCount; ++i) {
+			new (&slots[i].sequence) std::atomic<uint64_t>(0);
+			new (&slots[i].generation) std::atomic<uint64_t>(0);
+			for (unsigned q = 0; q < DigestWords; ++q) {
+				new (&slots[i].digest[q]) std::atomic<uint64_t>(0);
+			}
+			for (unsigned q = 0; q < ResultWords; ++q) {
+				new (&slots[i].result[q]) std::atomic<uint64_t>(0);
+			}
+		}
+	}
+
+	SharedResultCache::~SharedResultCache() {
+		AlignedAllocator<CacheLineSize>::freeMemory(slots, memorySize);
+	}
+
+	bool SharedResultCache::lookup(const uint64_t (&digest)[DigestWords], void* out) const {
+		const uint64_t tag = generation.load(std::memory_order_relaxed) + 1ULL;
+		const size_t first = (size_t)(digest[0] & (setCount - 1)) * Ways;
+		uint64_t words[ResultWords];
+		for (size_t i = first; i < first + Ways; ++i) {
+			const Slot& slot = slots[i];
+			uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if ((sequence & 1) != 0 || slot.generation.load(std::memory_order_relaxed) != tag)
+				continue;
+			bool match = true;
+			for (unsigned q = 0; q < DigestWords && match; ++q) {
+				match = slot.digest[q].load(std::memory_order_relaxed) == digest[q];
+			}
+			if (!match)
+				continue;
+			for (unsigned q = 0; q < ResultWords; ++q) {
+				words[q] = slot.result[q].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			//the copy is valid only if no writer has touched the slot meanwhile
+			if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+				memcpy(out, words, sizeof(words));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void SharedResultCache::insert(const uint64_t (&digest)[DigestWords], const void* result) {
+		const uint64_t tag = generation.load(std::memory_order_relaxed) + 1ULL;
+		const size_t first = (size_t)(digest[0] & (setCount - 1)) * Ways;
+		//prefer an empty slot or a slot of an old generation, otherwise replace a slot picked by the digest
+		size_t victim = first + (digest[1] & (Ways - 1));
+		for (size_t i = first; i < first + Ways; ++i) {
+			if (slots[i].generation.load(std::memory_order_relaxed) != tag) {
+				victim = i;
+				break;
+			}
+		}
+		Slot& slot = slots[victim];
+		uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		if ((sequence & 1) != 0 || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+			return; //another thread is writing the slot
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.generation.store(tag, std::memory_order_relaxed);
+		for (unsigned q = 0; q < DigestWords; ++q) {
+			slot.digest[q].store(digest[q], std::memory_order_relaxed);
+		}
+		uint64_t words[ResultWords];
+		memcpy(words, result, sizeof(words));
+		for (unsigned q = 0; q < ResultWords; ++q) {
+			slot.result[q].store(words[q], std::memory_order_relaxed);
+		}
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace randomx {
+
+	//Hash results shared by the light-mode virtual machines of one cache, looked up by the
+	//Blake2b-512 digest of the input that seeds the first program, so a lookup adds no hashing.
+	//The slots are guarded by sequence numbers like the slots of SharedItemCache, and the tags
+	//include a generation that is changed when the cache is initialized with a new key.
+	class SharedResultCache {
+	public:
+		static constexpr unsigned Ways = 4;
+		static constexpr unsigned DigestWords = 8;
+		static constexpr unsigned ResultWords = 4;
+		SharedResultCache(size_t size);
+		~SharedResultCache();
+		bool lookup(const uint64_t (&digest)[DigestWords], void* out) const;
+		void insert(const uint64_t (&digest)[DigestWords], const void* result);
+		void invalidate() {
+			generation.fetch_add(1, std::memory_order_relaxed);
+		}
+		size_t getSize() const {
+			return memorySize;
+		}
+	private:
+		struct Slot {
+			std::atomic<uint64_t> sequence;
+			std::atomic<uint64_t> generation; //generation + 1, 0 if the slot is empty
+			std::atomic<uint64_t> digest[DigestWords];
+			std::atomic<uint64_t> result[ResultWords];
+			uint64_t padding[2];
+		};
+		uint32_t setCount; //power of 2
+		size_t memorySize;
+		Slot* slots;
+		std::atomic<uint32_t> generation;
+	};
+
+}
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include "scratchpad_arena.hpp"
+#include "common.hpp"
+#include "virtual_memory.h"
+#include "allocator.hpp"
+
+//all scratchpads are packed at the start of the arena, followed by the virtual machine objects
+randomx_scratchpad_arena::randomx_scratchpad_arena(unsigned count, bool largePages, bool staggered) : count(count) {
+	constexpr size_t arenaAlign = 2 * 1024 * 1024;
+	if (staggered) {
+		scratchpadStride += randomx::ArenaScratchpadStagger;
+		vmStride += randomx::ArenaVmStagger;
+	}
+	const size_t slotSize = scratchpadStride + vmStride;
+	if (count == 0 || count > SIZE_MAX / slotSize - 1) {
+		throw std::bad_alloc();
+	}
+	size = alignSize(count * slotSize, arenaAlign);
+	if (randomx::hasCustomAllocator()) {
+		memory = (uint8_t*)randomx::CustomAllocator<RANDOMX_MEMORY_SCRATCHPAD>::allocMemory(size, &pageBacking);
+	}
+	else if (largePages) {
+		memory = (uint8_t*)allocLargePagesMemory(size);
+		pageBacking = RANDOMX_PAGES_LARGE;
+		if (memory == nullptr) {
+			memory = (uint8_t*)allocTransparentHugePagesMemory(size);
+			pageBacking = RANDOMX_PAGES_TRANSPARENT;
+		}
+	}
+	else {
+		memory = (uint8_t*)allocMemoryPages(size);
+		pageBacking = RANDOMX_PAGES_STANDARD;
+	}
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	freeSlots.reserve(count);
+	for (unsigned i = count; i > 0; --i) {
+		freeSlots.push_back(i - 1);
+	}
+}
+
+randomx_scratchpad_arena::randomx_scratchpad_arena(uint8_t* memory, size_t size, randomx_page_backing backing, randomx::MemoryFreeFunc* freeMemory)
+	: memory(memory), size(size), pageBacking(backing), freeMemory(freeMemory) {
+	count = size / (randomx::ScratchpadSize + randomx::ArenaVmSize);
+	if (count == 0) {
+		throw std::bad_alloc();
+	}
+	freeSlots.reserve(count);
+	for (unsigned i = count; i > 0; --i) {
+		freeSlots.push_back(i - 1);
+	}
+}
+
+randomx_scratchpad_arena::~randomx_scratchpad_arena() {
+	if (freeMemory != nullptr)
+		freeMemory(memory, size);
+	else if (pageBacking == RANDOMX_PAGES_CUSTOM)
+		randomx::CustomAllocator<RANDOMX_MEMORY_SCRATCHPAD>::freeMemory(memory, size);
+	else
+		freePagedMemory(memory, size);
+}
+
+int randomx_scratchpad_arena::acquire() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (freeSlots.empty()) {
+		return -1;
+	}
+	int slot = freeSlots.back();
+	freeSlots.pop_back();
+	return slot;
+}
+
+void randomx_scratchpad_arena::release(int slot) {
+	std::lock_guard<std::mutex> lock(mutex);
+	freeSlots.push_back(slot);
+}
+
+uint8_t* randomx_scratchpad_arena::getScratchpad(int slot) const {
+	return memory + (size_t)slot * scratchpadStride;
+}
+
+void* randomx_scratchpad_arena::getVmStorage(int slot) const {
+	return memory + (size_t)count * scratchpadStride + (size_t)slot * vmStride;
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include "randomx.h"
+#include "common.hpp"
+
+namespace randomx {
+
+	//space reserved for one virtual machine object next to the scratchpads
+	constexpr size_t ArenaVmSize = 16 * 1024;
+
+	//shifts between consecutive slots of a staggered arena
+	constexpr size_t ArenaScratchpadStagger = RANDOMX_SCRATCHPAD_L1;
+	constexpr size_t ArenaVmStagger = 1024;
+
+}
+
+/* Global scope for C binding */
+class randomx_scratchpad_arena {
+public:
+	randomx_scratchpad_arena(unsigned count, bool largePages, bool staggered);
+	//takes ownership of memory allocated elsewhere, e.g. the memory of a drained cache
+	randomx_scratchpad_arena(uint8_t* memory, size_t size, randomx_page_backing backing, randomx::MemoryFreeFunc* freeMemory);
+	~randomx_scratchpad_arena();
+	int acquire();
+	void release(int slot);
+	uint8_t* getScratchpad(int slot) const;
+	void* getVmStorage(int slot) const;
+	randomx_page_backing getPageBacking() const {
+		return pageBacking;
+	}
+private:
+	uint8_t* memory;
+	size_t size;
+	unsigned count;
+	size_t scratchpadStride = randomx::ScratchpadSize;
+	size_t vmStride = randomx::ArenaVmSize;
+	randomx_page_backing pageBacking;
+	randomx::MemoryFreeFunc* freeMemory = nullptr;
+	std::vector<int> freeSlots;
+	std::mutex mutex;
+};
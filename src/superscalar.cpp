@@ -35,9 +35,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdexcept>
 #include <iomanip>
 #include "superscalar.hpp"
+#include "superscalar_group.hpp"
 #include "intrin_portable.h"
 #include "reciprocal.h"
 #include "common.hpp"
+#include "cpu.hpp"
 
 namespace randomx {
 
@@ -329,7 +331,25 @@ namespace randomx {
 	const SuperscalarInstructionInfo* slot_9[] = { &SuperscalarInstructionInfo::IXOR_C9, &SuperscalarInstructionInfo::IADD_C9 };
 	const SuperscalarInstructionInfo* slot_10   = &SuperscalarInstructionInfo::IMUL_RCP;
 
-	static bool selectRegister(std::vector<int>& availableRegisters, Blake2Generator& gen, int& reg) {
+	//fixed-capacity list of candidate registers, avoids a heap allocation per register selection
+	class RegisterList {
+	public:
+		void push_back(int reg) {
+			regs_[size_++] = reg;
+		}
+		size_t size() const {
+			return size_;
+		}
+		int operator[](size_t index) const {
+			return regs_[index];
+		}
+	private:
+		int regs_[8];
+		size_t size_ = 0;
+	};
+
+	template<class List>
+	static bool selectRegister(List& availableRegisters, Blake2Generator& gen, int& reg) {
 		int index;
 		if (availableRegisters.size() == 0)
 			return false;
@@ -492,10 +512,11 @@ namespace randomx {
 			}
 		}
 
+		template<class List>
 		bool selectDestination(int cycle, bool allowChainedMul, RegisterInfo (&registers)[8], Blake2Generator& gen) {
 			/*if (allowChainedMultiplication && opGroup_ == SuperscalarInstructionType::IMUL_R)
 				std::cout << "Selecting destination with chained MUL enabled" << std::endl;*/
-			std::vector<int> availableRegisters;
+			List availableRegisters;
 			//Conditions for the destination register:
 			// * value must be ready at the required cycle
 			// * cannot be the same as the source register unless the instruction allows it
@@ -513,8 +534,9 @@ namespace randomx {
 			return selectRegister(availableRegisters, gen, dst_);
 		}
 
+		template<class List>
 		bool selectSource(int cycle, RegisterInfo(&registers)[8], Blake2Generator& gen) {
-			std::vector<int> availableRegisters;
+			List availableRegisters;
 			//all registers that are ready at the cycle
 			for (unsigned i = 0; i < 8; ++i) {
 				if (registers[i].latency <= cycle)
@@ -583,8 +605,13 @@ namespace randomx {
 	constexpr int LOOK_FORWARD_CYCLES = 4;
 	constexpr int MAX_THROWAWAY_COUNT = 256;
 
+	//ports in use per cycle, one array element per port
+	using PortMap = ExecutionPort::type[CYCLE_MAP_SIZE][3];
+	//ports in use per cycle as a bitset of ExecutionPort values
+	using PortBitmap = uint8_t[CYCLE_MAP_SIZE];
+
 	template<bool commit>
-	static int scheduleUop(ExecutionPort::type uop, ExecutionPort::type(&portBusy)[CYCLE_MAP_SIZE][3], int cycle) {
+	static int scheduleUop(ExecutionPort::type uop, PortMap& portBusy, int cycle) {
 		//The scheduling here is done optimistically by checking port availability in order P5 -> P0 -> P1 to not overload
 		//port P1 (multiplication) by instructions that can go to any port.
 		for (; cycle < CYCLE_MAP_SIZE; ++cycle) {
@@ -613,8 +640,25 @@ namespace randomx {
 		return -1;
 	}
 
+	//same port selection as above, but each cycle is checked with a single mask operation
 	template<bool commit>
-	static int scheduleMop(const MacroOp& mop, ExecutionPort::type(&portBusy)[CYCLE_MAP_SIZE][3], int cycle, int depCycle) {
+	static int scheduleUop(ExecutionPort::type uop, PortBitmap& portBusy, int cycle) {
+		for (; cycle < CYCLE_MAP_SIZE; ++cycle) {
+			const int freePorts = uop & ~portBusy[cycle];
+			if (freePorts != 0) {
+				if (commit) {
+					const int port = (freePorts & ExecutionPort::P5) ? ExecutionPort::P5 : ((freePorts & ExecutionPort::P0) ? ExecutionPort::P0 : ExecutionPort::P1);
+					if (trace) std::cout << "; " << (port == ExecutionPort::P5 ? "P5" : (port == ExecutionPort::P0 ? "P0" : "P1")) << " at cycle " << cycle << std::endl;
+					portBusy[cycle] |= port;
+				}
+				return cycle;
+			}
+		}
+		return -1;
+	}
+
+	template<bool commit, class Ports>
+	static int scheduleMop(const MacroOp& mop, Ports& portBusy, int cycle, int depCycle) {
 		//if this macro-op depends on the previous one, increase the starting cycle if needed
 		//this handles an explicit dependency chain in IMUL_RCP
 		if (mop.isDependent()) {
@@ -650,9 +694,10 @@ namespace randomx {
 		return -1;
 	}
 
-	void generateSuperscalar(SuperscalarProgram& prog, Blake2Generator& gen) {
+	template<class Ports, class List>
+	static void generate(SuperscalarProgram& prog, Blake2Generator& gen) {
 
-		ExecutionPort::type portBusy[CYCLE_MAP_SIZE][3];
+		Ports portBusy;
 		memset(portBusy, 0, sizeof(portBusy));
 		RegisterInfo registers[8];
 
@@ -712,7 +757,7 @@ namespace randomx {
 				if (macroOpIndex == currentInstruction.getInfo().getSrcOp()) {
 					int forward;
 					//if no suitable operand is ready, look up to LOOK_FORWARD_CYCLES forward
-					for (forward = 0; forward < LOOK_FORWARD_CYCLES && !currentInstruction.selectSource(scheduleCycle, registers, gen); ++forward) {
+					for (forward = 0; forward < LOOK_FORWARD_CYCLES && !currentInstruction.selectSource<List>(scheduleCycle, registers, gen); ++forward) {
 						if (trace) std::cout << "; src STALL at cycle " << cycle << std::endl;
 						++scheduleCycle;
 						++cycle;
@@ -736,7 +781,7 @@ namespace randomx {
 				//find a destination register that will be ready when this instruction executes
 				if (macroOpIndex == currentInstruction.getInfo().getDstOp()) {
 					int forward;
-					for (forward = 0; forward < LOOK_FORWARD_CYCLES && !currentInstruction.selectDestination(scheduleCycle, throwAwayCount > 0, registers, gen); ++forward) {
+					for (forward = 0; forward < LOOK_FORWARD_CYCLES && !currentInstruction.selectDestination<List>(scheduleCycle, throwAwayCount > 0, registers, gen); ++forward) {
 						if (trace) std::cout << "; dst STALL at cycle " << cycle << std::endl;
 						++scheduleCycle;
 						++cycle;
@@ -853,6 +898,14 @@ namespace randomx {
 		}*/
 	}
 
+	void generateSuperscalar(SuperscalarProgram& prog, Blake2Generator& gen) {
+		generate<PortBitmap, RegisterList>(prog, gen);
+	}
+
+	void generateSuperscalarReference(SuperscalarProgram& prog, Blake2Generator& gen) {
+		generate<PortMap, std::vector<int>>(prog, gen);
+	}
+
 	void executeSuperscalar(int_reg_t(&r)[8], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals) {
 		for (unsigned j = 0; j < prog.getSize(); ++j) {
 			Instruction& instr = prog(j);
@@ -900,4 +953,180 @@ namespace randomx {
 			}
 		}
 	}
+
+	void compileSuperscalar(SuperscalarProgram& prog, const std::vector<uint64_t>& reciprocals, std::vector<SuperscalarByteCode>& bytecode) {
+		for (unsigned j = 0; j < prog.getSize(); ++j) {
+			Instruction& instr = prog(j);
+			SuperscalarByteCode ibc;
+			auto type = (SuperscalarInstructionType)instr.opcode;
+			ibc.dst = instr.dst;
+			ibc.src = instr.src;
+			switch (type)
+			{
+			case SuperscalarInstructionType::IADD_RS:
+				ibc.imm = instr.getModShift();
+				break;
+			case SuperscalarInstructionType::IROR_C:
+				ibc.imm = instr.getImm32();
+				break;
+			case SuperscalarInstructionType::IADD_C8:
+			case SuperscalarInstructionType::IADD_C9:
+				type = SuperscalarInstructionType::IADD_C7;
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				break;
+			case SuperscalarInstructionType::IXOR_C8:
+			case SuperscalarInstructionType::IXOR_C9:
+				type = SuperscalarInstructionType::IXOR_C7;
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				break;
+			case SuperscalarInstructionType::IADD_C7:
+			case SuperscalarInstructionType::IXOR_C7:
+				ibc.imm = signExtend2sCompl(instr.getImm32());
+				break;
+			case SuperscalarInstructionType::IMUL_RCP:
+				ibc.imm = reciprocals[instr.getImm32()];
+				break;
+			default:
+				ibc.imm = 0;
+				break;
+			}
+			ibc.type = (uint8_t)type;
+			bytecode.push_back(ibc);
+		}
+		SuperscalarByteCode end;
+		end.imm = 0;
+		end.type = (uint8_t)SuperscalarInstructionType::COUNT;
+		end.dst = end.src = (uint8_t)prog.getAddressRegister();
+		bytecode.push_back(end);
+	}
+
+	const SuperscalarByteCode* executeSuperscalarBytecode(int_reg_t(&r)[8], const SuperscalarByteCode* code) {
+		//dispatch uses a tree of conditional branches rather than a jump table: the same instruction
+		//stream is executed for every dataset item, which the branch history predicts well
+		for (;; ++code) {
+			const SuperscalarByteCode ibc = *code;
+			const unsigned type = ibc.type;
+			if (type < (unsigned)SuperscalarInstructionType::IROR_C) {
+				if (type & 2) {
+					if (type == (unsigned)SuperscalarInstructionType::IMUL_R)
+						r[ibc.dst] *= r[ibc.src];
+					else //IADD_RS
+						r[ibc.dst] += r[ibc.src] << ibc.imm;
+				}
+				else {
+					if (type == (unsigned)SuperscalarInstructionType::IXOR_R)
+						r[ibc.dst] ^= r[ibc.src];
+					else //ISUB_R
+						r[ibc.dst] -= r[ibc.src];
+				}
+			}
+			else if (type <= (unsigned)SuperscalarInstructionType::IXOR_C7) {
+				if (type == (unsigned)SuperscalarInstructionType::IROR_C)
+					r[ibc.dst] = rotr(r[ibc.dst], (uint32_t)ibc.imm);
+				else if (type == (unsigned)SuperscalarInstructionType::IADD_C7)
+					r[ibc.dst] += ibc.imm;
+				else //IXOR_C7
+					r[ibc.dst] ^= ibc.imm;
+			}
+			else if (type < (unsigned)SuperscalarInstructionType::IMUL_RCP) {
+				if (type == (unsigned)SuperscalarInstructionType::IMULH_R)
+					r[ibc.dst] = mulh(r[ibc.dst], r[ibc.src]);
+				else //ISMULH_R
+					r[ibc.dst] = smulh(r[ibc.dst], r[ibc.src]);
+			}
+			else if (type == (unsigned)SuperscalarInstructionType::IMUL_RCP) {
+				r[ibc.dst] *= ibc.imm;
+			}
+			else {
+				//COUNT marks the end of the program
+				return code;
+			}
+		}
+	}
+
+	void executeSuperscalarGroup(int_reg_t(&r)[8][SuperscalarGroupSize], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals) {
+		//each instruction is decoded once and applied to all register files, the register files are
+		//independent, so the inner loops have no dependencies between iterations
+		for (unsigned j = 0; j < prog.getSize(); ++j) {
+			Instruction& instr = prog(j);
+			int_reg_t (&dst)[SuperscalarGroupSize] = r[instr.dst];
+			int_reg_t (&src)[SuperscalarGroupSize] = r[instr.src];
+			switch ((SuperscalarInstructionType)instr.opcode)
+			{
+			case SuperscalarInstructionType::ISUB_R:
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] -= src[k];
+				break;
+			case SuperscalarInstructionType::IXOR_R:
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] ^= src[k];
+				break;
+			case SuperscalarInstructionType::IADD_RS: {
+				const unsigned shift = instr.getModShift();
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] += src[k] << shift;
+			} break;
+			case SuperscalarInstructionType::IMUL_R:
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] *= src[k];
+				break;
+			case SuperscalarInstructionType::IROR_C: {
+				const unsigned count = instr.getImm32();
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] = rotr(dst[k], count);
+			} break;
+			case SuperscalarInstructionType::IADD_C7:
+			case SuperscalarInstructionType::IADD_C8:
+			case SuperscalarInstructionType::IADD_C9: {
+				const uint64_t imm = signExtend2sCompl(instr.getImm32());
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] += imm;
+			} break;
+			case SuperscalarInstructionType::IXOR_C7:
+			case SuperscalarInstructionType::IXOR_C8:
+			case SuperscalarInstructionType::IXOR_C9: {
+				const uint64_t imm = signExtend2sCompl(instr.getImm32());
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] ^= imm;
+			} break;
+			case SuperscalarInstructionType::IMULH_R:
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] = mulh(dst[k], src[k]);
+				break;
+			case SuperscalarInstructionType::ISMULH_R:
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] = smulh(dst[k], src[k]);
+				break;
+			case SuperscalarInstructionType::IMUL_RCP: {
+				const uint64_t rcp = reciprocals != nullptr ? (*reciprocals)[instr.getImm32()] : randomx_reciprocal(instr.getImm32());
+				for (int k = 0; k < SuperscalarGroupSize; ++k)
+					dst[k] *= rcp;
+			} break;
+			default:
+				UNREACHABLE;
+			}
+		}
+	}
+
+	static const SuperscalarByteCode* executeGroupPortable(int_reg_t(&r)[8][SuperscalarGroupSize], const SuperscalarByteCode* code) {
+		return executeBytecodeGroup(r, code);
+	}
+
+	SuperscalarGroupFunc* superscalarGroupPortable() {
+		return &executeGroupPortable;
+	}
+
+	static SuperscalarGroupFunc* selectSuperscalarGroup() {
+		Cpu cpu;
+		if (superscalarGroupAvx512() != nullptr && cpu.hasAvx512f() && cpu.hasAvx512dq())
+			return superscalarGroupAvx512();
+		if (superscalarGroupAvx2() != nullptr && cpu.hasAvx2())
+			return superscalarGroupAvx2();
+		return superscalarGroupPortable();
+	}
+
+	const SuperscalarByteCode* executeSuperscalarBytecodeGroup(int_reg_t(&r)[8][SuperscalarGroupSize], const SuperscalarByteCode* code) {
+		static SuperscalarGroupFunc* const func = selectSuperscalarGroup();
+		return func(r, code);
+	}
 }
@@ -56,5 +56,26 @@ namespace randomx {
 	};
 
 	void generateSuperscalar(SuperscalarProgram& prog, Blake2Generator& gen);
+	//the original generator, kept to validate and benchmark generateSuperscalar (the output is identical)
+	void generateSuperscalarReference(SuperscalarProgram& prog, Blake2Generator& gen);
 	void executeSuperscalar(uint64_t(&r)[8], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals = nullptr);
+
+	//appends the bytecode of a program, reciprocals are resolved from the table
+	void compileSuperscalar(SuperscalarProgram& prog, const std::vector<uint64_t>& reciprocals, std::vector<SuperscalarByteCode>& bytecode);
+	//executes one program, returns a pointer to its end marker
+	const SuperscalarByteCode* executeSuperscalarBytecode(uint64_t(&r)[8], const SuperscalarByteCode* code);
+
+	//number of register files executed at once by executeSuperscalarGroup
+	constexpr int SuperscalarGroupSize = 8;
+	//r[i][k] is register i of the k-th register file
+	void executeSuperscalarGroup(uint64_t(&r)[8][SuperscalarGroupSize], SuperscalarProgram& prog, std::vector<uint64_t> *reciprocals = nullptr);
+
+	typedef const SuperscalarByteCode* (SuperscalarGroupFunc)(uint64_t(&r)[8][SuperscalarGroupSize], const SuperscalarByteCode* code);
+	//executes one bytecode program for a group of register files, returns a pointer to its end marker;
+	//uses the widest variant supported by the build and the CPU
+	const SuperscalarByteCode* executeSuperscalarBytecodeGroup(uint64_t(&r)[8][SuperscalarGroupSize], const SuperscalarByteCode* code);
+	//the variants of executeSuperscalarBytecodeGroup, NULL if not compiled in
+	SuperscalarGroupFunc* superscalarGroupPortable();
+	SuperscalarGroupFunc* superscalarGroupAvx2();
+	SuperscalarGroupFunc* superscalarGroupAvx512();
 }
\ No newline at end of file
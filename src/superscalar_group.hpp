@@ -0,0 +1,129 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "superscalar.hpp"
+#if !defined(__SIZEOF_INT128__)
+#include "intrin_portable.h"
+#endif
+
+//The body of executeSuperscalarBytecodeGroup. It's compiled once by superscalar.cpp for the
+//baseline instruction set and once by each of superscalar_avx2.cpp and superscalar_avx512.cpp.
+//Everything here has internal linkage and only uses the pre-decoded bytecode, so the linker
+//never merges a copy compiled for a newer instruction set into the baseline code.
+
+namespace randomx {
+	namespace {
+
+		inline uint64_t groupRotr(uint64_t x, unsigned c) {
+			return (x >> (c & 63)) | (x << ((64 - c) & 63));
+		}
+
+#if defined(__SIZEOF_INT128__)
+		inline uint64_t groupMulh(uint64_t a, uint64_t b) {
+			return (uint64_t)(((unsigned __int128)a * b) >> 64);
+		}
+
+		inline int64_t groupSmulh(int64_t a, int64_t b) {
+			return (int64_t)(((__int128)a * b) >> 64);
+		}
+#else
+		inline uint64_t groupMulh(uint64_t a, uint64_t b) {
+			return mulh(a, b);
+		}
+
+		inline int64_t groupSmulh(int64_t a, int64_t b) {
+			return smulh(a, b);
+		}
+#endif
+
+		inline const SuperscalarByteCode* executeBytecodeGroup(uint64_t(&r)[8][SuperscalarGroupSize], const SuperscalarByteCode* code) {
+			//each instruction is applied to all register files; the inner loops have no dependencies
+			//between iterations, so the compiler vectorizes them for the target instruction set
+			for (;; ++code) {
+				const SuperscalarByteCode ibc = *code;
+				uint64_t (&dst)[SuperscalarGroupSize] = r[ibc.dst];
+				uint64_t (&src)[SuperscalarGroupSize] = r[ibc.src];
+				switch ((SuperscalarInstructionType)ibc.type)
+				{
+				case SuperscalarInstructionType::ISUB_R:
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] -= src[k];
+					break;
+				case SuperscalarInstructionType::IXOR_R:
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] ^= src[k];
+					break;
+				case SuperscalarInstructionType::IADD_RS: {
+					const unsigned shift = (unsigned)ibc.imm;
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] += src[k] << shift;
+				} break;
+				case SuperscalarInstructionType::IMUL_R:
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] *= src[k];
+					break;
+				case SuperscalarInstructionType::IROR_C: {
+					const unsigned count = (unsigned)ibc.imm;
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] = groupRotr(dst[k], count);
+				} break;
+				case SuperscalarInstructionType::IADD_C7: {
+					const uint64_t imm = ibc.imm;
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] += imm;
+				} break;
+				case SuperscalarInstructionType::IXOR_C7: {
+					const uint64_t imm = ibc.imm;
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] ^= imm;
+				} break;
+				case SuperscalarInstructionType::IMULH_R:
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] = groupMulh(dst[k], src[k]);
+					break;
+				case SuperscalarInstructionType::ISMULH_R:
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] = groupSmulh(dst[k], src[k]);
+					break;
+				case SuperscalarInstructionType::IMUL_RCP: {
+					const uint64_t rcp = ibc.imm;
+					for (int k = 0; k < SuperscalarGroupSize; ++k)
+						dst[k] *= rcp;
+				} break;
+				default:
+					//COUNT marks the end of the program
+					return code;
+				}
+			}
+		}
+
+	}
+}
@@ -34,6 +34,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace randomx {
 
+	//SuperscalarHash instruction with pre-decoded operands. The programs of a cache are stored
+	//back to back, each one followed by an end marker that holds the address register in dst.
+	struct SuperscalarByteCode {
+		uint64_t imm; //sign-extended immediate, reciprocal (IMUL_RCP), shift (IADD_RS) or rotation (IROR_C)
+		uint8_t type; //SuperscalarInstructionType, COUNT marks the end of a program
+		uint8_t dst;
+		uint8_t src;
+	};
+
 	class SuperscalarProgram {
 	public:
 		Instruction& operator()(int pc) {
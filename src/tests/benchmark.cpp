@@ -34,6 +34,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <sstream>
+#include <functional>
+#include <algorithm>
 #include "stopwatch.hpp"
 #include "utility.hpp"
 #include "../randomx.h"
@@ -46,6 +50,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <versionhelpers.h>
 #endif
 #include "affinity.hpp"
+#include "perf_counters.hpp"
+#include "latency_histogram.hpp"
+#include "soak_monitor.hpp"
 
 const uint8_t blockTemplate_[] = {
 		0x07, 0x07, 0xf7, 0xa4, 0xf0, 0xd6, 0x05, 0xb3, 0x03, 0x26, 0x08, 0x16, 0xba, 0x3f, 0x10, 0x90, 0x2e, 0x1a, 0x14,
@@ -72,7 +79,7 @@ public:
 private:
 	static void print(std::atomic<uint64_t>& hash, std::ostream& os) {
 		auto h = hash.load();
-		outputHex(std::cout, (char*)&h, sizeof(h));
+		outputHex(os, (char*)&h, sizeof(h));
 	}
 	std::atomic<uint64_t> hash[4];
 };
@@ -86,17 +93,38 @@ void printUsage(const char* executable) {
 	std::cout << "  --jit         JIT compiled mode (default: interpreter)" << std::endl;
 	std::cout << "  --secure      W^X policy for JIT pages (default: off)" << std::endl;
 	std::cout << "  --largePages  use large pages (default: small pages)" << std::endl;
+	std::cout << "  --1gbPages    use 1 GiB pages for the dataset if available (default: off)" << std::endl;
+	std::cout << "  --prefault    touch all dataset pages before initialization (default: off)" << std::endl;
+	std::cout << "  --numa        one dataset copy per NUMA node, VMs use the copy of the node of their CPU (default: off)" << std::endl;
 	std::cout << "  --softAes     use software AES (default: hardware AES)" << std::endl;
 	std::cout << "  --threads T   use T threads (default: 1)" << std::endl;
 	std::cout << "  --affinity A  thread affinity bitmask (default: 0)" << std::endl;
+	std::cout << "  --placement P place the threads by CPU topology: 'fast' (fastest cores only), 'all' or 'pairs' (SMT siblings consecutively) (ignored with --affinity)" << std::endl;
+	std::cout << "  --stagger     allocate the scratchpads in one arena, shifted against each other to use different L2 sets" << std::endl;
 	std::cout << "  --init Q      initialize dataset with Q threads (default: 1)" << std::endl;
+	std::cout << "  --initSweep   measure the dataset initialization with 1 to Q threads and several thread placements" << std::endl;
 	std::cout << "  --nonces N    run N nonces (default: 1000)" << std::endl;
 	std::cout << "  --seed S      seed for cache initialization (default: 0)" << std::endl;
 	std::cout << "  --ssse3       use optimized Argon2 for SSSE3 CPUs" << std::endl;
 	std::cout << "  --avx2        use optimized Argon2 for AVX2 CPUs" << std::endl;
+	std::cout << "  --avx512      use optimized Argon2 for AVX-512 CPUs" << std::endl;
+	std::cout << "  --neon        use optimized Argon2 for ARM64 CPUs" << std::endl;
+	std::cout << "  --vaes        use VAES for the scratchpad and program generators" << std::endl;
+	std::cout << "  --vperm       use constant-time vector permute AES (requires --softAes)" << std::endl;
+	std::cout << "  --avx512ds    use AVX-512 to initialize the dataset (requires --jit)" << std::endl;
+	std::cout << "  --prefetchT0  prefetch dataset items with prefetcht0 (default: prefetchnta, requires --jit)" << std::endl;
+	std::cout << "  --prefetchSp  also prefetch the cache line after each scratchpad line (requires --jit)" << std::endl;
+	std::cout << "  --schedule    reorder program instructions for in-order cores (ARM64, requires --jit)" << std::endl;
+	std::cout << "  --sharedCode  place the JIT code of all VMs in shared 2 MiB large pages (requires --jit)" << std::endl;
 	std::cout << "  --auto        select the best options for the current CPU" << std::endl;
 	std::cout << "  --noBatch     calculate hashes one by one (default: batch)" << std::endl;
 	std::cout << "  --commit      calculate commitments instead of hashes (default: hashes)" << std::endl;
+	std::cout << "  --interleave L calculate L hashes at once per thread (default: 1)" << std::endl;
+	std::cout << "  --lazy M      keep up to M MiB of dataset items per VM in verification mode (default: 0)" << std::endl;
+	std::cout << "  --perf        print hardware performance counters per hash (default: off)" << std::endl;
+	std::cout << "  --soak S      hash for S seconds and report the hashrate, frequency, power and temperature per interval" << std::endl;
+	std::cout << "  --interval I  soak report interval in seconds (default: 10)" << std::endl;
+	std::cout << "  --json        print the results as JSON to stdout and everything else to stderr" << std::endl;
 }
 
 struct MemoryException : public std::exception {
@@ -112,10 +140,16 @@ struct DatasetAllocException : public MemoryException {
 	}
 };
 
-using MineFunc = void(randomx_vm * vm, std::atomic<uint32_t> & atomicNonce, AtomicHash & result, uint32_t noncesCount, int thread, int cpuid);
+using MineFunc = void(randomx_vm * vm, randomx_nonce_scheduler * scheduler, AtomicHash & result, int thread, int cpuid, LatencyHistogram* latencies, SoakThread* soak);
+
+using LatencyClock = std::chrono::steady_clock;
+
+inline uint64_t elapsedNs(LatencyClock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(LatencyClock::now() - start).count();
+}
 
 template<bool batch, bool commit>
-void mine(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result, uint32_t noncesCount, int thread, int cpuid = -1) {
+void mine(randomx_vm* vm, randomx_nonce_scheduler* scheduler, AtomicHash& result, int thread, int cpuid, LatencyHistogram* latencies, SoakThread* soak) {
 	if (cpuid >= 0) {
 		int rc = set_thread_affinity(cpuid);
 		if (rc) {
@@ -126,33 +160,489 @@ void mine(randomx_vm* vm, std::atomic<uint32_t>& atomicNonce, AtomicHash& result
 	uint8_t blockTemplate[sizeof(blockTemplate_)];
 	memcpy(blockTemplate, blockTemplate_, sizeof(blockTemplate));
 	void* noncePtr = blockTemplate + 39;
-	auto nonce = atomicNonce.fetch_add(1);
+	uint32_t nonce;
+	bool more = randomx_nonce_scheduler_next(scheduler, thread, &nonce);
 
-	if (batch) {
+	if (batch && more) {
 		store32(noncePtr, nonce);
-		randomx_calculate_hash_first(vm, blockTemplate, sizeof(blockTemplate));
+		(commit ? randomx_calculate_hash_and_commitment_first : randomx_calculate_hash_first)(vm, blockTemplate, sizeof(blockTemplate));
 	}
 
-	while (nonce < noncesCount) {
+	while (more) {
 		if (batch) {
-			nonce = atomicNonce.fetch_add(1);
+			more = randomx_nonce_scheduler_next(scheduler, thread, &nonce);
 		}
 		store32(noncePtr, nonce);
-		(batch ? randomx_calculate_hash_next : randomx_calculate_hash)(vm, blockTemplate, sizeof(blockTemplate), &hash);
+		LatencyClock::time_point start;
+		if (latencies != nullptr)
+			start = LatencyClock::now();
 		if (commit) {
-			randomx_calculate_commitment(blockTemplate, sizeof(blockTemplate), &hash, &hash);
+			(batch ? randomx_calculate_hash_and_commitment_next : randomx_calculate_hash_and_commitment)(vm, blockTemplate, sizeof(blockTemplate), &hash, &hash);
 		}
+		else {
+			(batch ? randomx_calculate_hash_next : randomx_calculate_hash)(vm, blockTemplate, sizeof(blockTemplate), &hash);
+		}
+		if (latencies != nullptr)
+			latencies->record(elapsedNs(start));
 		result.xorWith(hash);
+		if (soak != nullptr) {
+			soak->addHashes(1);
+			if (soak->isStopped())
+				break;
+		}
 		if (!batch) {
-			nonce = atomicNonce.fetch_add(1);
+			more = randomx_nonce_scheduler_next(scheduler, thread, &nonce);
+		}
+	}
+}
+
+template<int lanes>
+void mineInterleaved(randomx_vm* vm, randomx_nonce_scheduler* scheduler, AtomicHash& result, int thread, int cpuid, LatencyHistogram* latencies, SoakThread* soak) {
+	if (cpuid >= 0) {
+		int rc = set_thread_affinity(cpuid);
+		if (rc) {
+			std::cerr << "Failed to set thread affinity for thread " << thread << " (error=" << rc << ")" << std::endl;
+		}
+	}
+	uint64_t hashes[lanes][RANDOMX_HASH_SIZE / sizeof(uint64_t)];
+	uint8_t blockTemplates[lanes][sizeof(blockTemplate_)];
+	const void* inputs[lanes];
+	size_t inputSizes[lanes];
+	for (int i = 0; i < lanes; ++i) {
+		memcpy(blockTemplates[i], blockTemplate_, sizeof(blockTemplate_));
+		inputs[i] = blockTemplates[i];
+		inputSizes[i] = sizeof(blockTemplate_);
+	}
+
+	for (;;) {
+		int count = 0;
+		uint32_t nonce;
+		while (count < lanes && randomx_nonce_scheduler_next(scheduler, thread, &nonce)) {
+			store32(blockTemplates[count] + 39, nonce);
+			count++;
+		}
+		if (count == 0)
+			break;
+		LatencyClock::time_point start;
+		if (latencies != nullptr)
+			start = LatencyClock::now();
+		randomx_calculate_hash_interleaved(vm, inputs, inputSizes, &hashes);
+		uint64_t latency = latencies != nullptr ? elapsedNs(start) : 0;
+		//all lanes finish at the same time, unused lanes hash stale inputs
+		for (int i = 0; i < count; ++i) {
+			result.xorWith(hashes[i]);
+			if (latencies != nullptr)
+				latencies->record(latency);
+		}
+		if (soak != nullptr) {
+			soak->addHashes(count);
+			if (soak->isStopped())
+				break;
+		}
+	}
+}
+
+struct SoakSample {
+	double time;                     //end of the interval in seconds
+	std::vector<double> hashRates;   //per thread
+	std::vector<double> frequencies; //per thread in GHz, 0 if not available
+	double power;                    //package power in W, negative if not available
+	double temperature;              //package temperature in degrees Celsius, negative if not available
+	double total() const {
+		double sum = 0;
+		for (double rate : hashRates)
+			sum += rate;
+		return sum;
+	}
+};
+
+void printSoakValue(std::ostream& os, double value, int precision, const char* unit) {
+	std::ostringstream text;
+	if (value >= 0)
+		text << std::fixed << std::setprecision(precision) << value << " " << unit;
+	else
+		text << "n/a";
+	os << std::setw(12) << text.str();
+}
+
+//samples the threads at the end of each interval until the duration has elapsed, then stops them
+std::vector<SoakSample> runSoakMonitor(std::vector<SoakThread>& threads, int seconds, int interval, std::atomic<bool>& stop) {
+	PackageSensors sensors;
+	std::vector<SoakSample> samples;
+	std::vector<uint64_t> lastHashes(threads.size(), 0), lastCycles(threads.size(), 0), lastNs(threads.size(), 0);
+	uint64_t lastEnergy = 0;
+	bool energy = sensors.readEnergy(lastEnergy);
+	auto start = std::chrono::steady_clock::now();
+	double lastTime = 0;
+	std::cout << "      time    hashrate   frequency       power temperature | per thread: hashrate, frequency" << std::endl;
+	while (lastTime < seconds) {
+		double end = std::min(lastTime + interval, (double)seconds);
+		std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(end)));
+		double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		SoakSample sample;
+		sample.time = time;
+		double frequencySum = 0;
+		int frequencyCount = 0;
+		for (unsigned i = 0; i < threads.size(); ++i) {
+			uint64_t hashes = threads[i].getHashes();
+			sample.hashRates.push_back((hashes - lastHashes[i]) / (time - lastTime));
+			lastHashes[i] = hashes;
+			uint64_t cycles, ns;
+			double frequency = -1;
+			if (threads[i].readClock(cycles, ns) && ns > lastNs[i]) {
+				frequency = (double)(cycles - lastCycles[i]) / (ns - lastNs[i]);
+				lastCycles[i] = cycles;
+				lastNs[i] = ns;
+				frequencySum += frequency;
+				frequencyCount++;
+			}
+			sample.frequencies.push_back(frequency);
+		}
+		sample.power = -1;
+		uint64_t energyNow;
+		if (energy && sensors.readEnergy(energyNow)) {
+			uint64_t used = energyNow >= lastEnergy ? energyNow - lastEnergy : energyNow + sensors.getEnergyRange() - lastEnergy;
+			sample.power = used / 1e6 / (time - lastTime);
+			lastEnergy = energyNow;
+		}
+		if (!sensors.readTemperature(sample.temperature))
+			sample.temperature = -1;
+		std::cout << std::setw(8) << std::fixed << std::setprecision(1) << time << " s";
+		std::cout.copyfmt(std::ios(nullptr));
+		printSoakValue(std::cout, sample.total(), 1, "H/s");
+		printSoakValue(std::cout, frequencyCount > 0 ? frequencySum / frequencyCount : -1, 2, "GHz");
+		printSoakValue(std::cout, sample.power, 1, "W");
+		printSoakValue(std::cout, sample.temperature, 1, "C");
+		std::cout << " |";
+		for (unsigned i = 0; i < threads.size(); ++i) {
+			printSoakValue(std::cout, sample.hashRates[i], 1, "H/s");
+			printSoakValue(std::cout, sample.frequencies[i], 2, "GHz");
+		}
+		std::cout << std::endl;
+		samples.push_back(sample);
+		lastTime = time;
+	}
+	stop = true;
+	return samples;
+}
+
+void printSoakSummary(const std::vector<SoakSample>& samples) {
+	if (samples.empty())
+		return;
+	double first = samples.front().total(), last = samples.back().total();
+	double minimum = first, maximum = first;
+	for (auto& sample : samples) {
+		minimum = std::min(minimum, sample.total());
+		maximum = std::max(maximum, sample.total());
+	}
+	std::cout << "Soak hashrate: first interval " << first << " H/s, last interval " << last << " H/s";
+	if (first > 0)
+		std::cout << " (" << std::showpos << 100 * (last - first) / first << std::noshowpos << "%)";
+	std::cout << ", min " << minimum << " H/s, max " << maximum << " H/s" << std::endl;
+}
+
+void printSoakJson(std::ostream& os, int seconds, int interval, const std::vector<SoakSample>& samples) {
+	os << "  \"soak\": {" << std::endl;
+	os << "    \"duration\": " << seconds << "," << std::endl;
+	os << "    \"interval\": " << interval << "," << std::endl;
+	os << "    \"samples\": [" << std::endl;
+	auto value = [&os](double x) -> std::ostream& {
+		if (x >= 0)
+			os << x;
+		else
+			os << "null";
+		return os;
+	};
+	for (unsigned i = 0; i < samples.size(); ++i) {
+		auto& sample = samples[i];
+		os << "      { \"time\": " << sample.time << ", \"hashesPerSecond\": " << sample.total() << ", \"powerW\": ";
+		value(sample.power) << ", \"temperatureC\": ";
+		value(sample.temperature) << ", \"threads\": [";
+		for (unsigned t = 0; t < sample.hashRates.size(); ++t) {
+			os << (t > 0 ? ", " : "") << "{ \"hashesPerSecond\": " << sample.hashRates[t] << ", \"ghz\": ";
+			value(sample.frequencies[t]) << " }";
 		}
+		os << "] }" << (i + 1 < samples.size() ? "," : "") << std::endl;
+	}
+	os << "    ]" << std::endl;
+	os << "  }," << std::endl;
+}
+
+//explains why the memory of the calling thread's last large page allocation isn't in large pages
+void printLargePagesFallback(const char* what) {
+	int error;
+	const char* reason;
+	switch (randomx_large_pages_status(&error)) {
+		case RANDOMX_LARGE_PAGES_UNSUPPORTED:
+			reason = "not supported by the system";
+			break;
+		case RANDOMX_LARGE_PAGES_NO_PRIVILEGE:
+			reason = "missing privilege (\"Lock pages in memory\" on Windows)";
+			break;
+		case RANDOMX_LARGE_PAGES_NOT_RESERVED:
+			reason = "no huge pages reserved (vm.nr_hugepages)";
+			break;
+		case RANDOMX_LARGE_PAGES_NO_MEMORY:
+			reason = "not enough free large pages or physical memory is fragmented";
+			break;
+		default:
+			reason = "allocation failed";
 	}
+	std::cout << "WARNING: " << what << " is not in large pages: " << reason << " (error " << error << ")" << std::endl;
+}
+
+const char* pageBackingName(randomx_page_backing backing) {
+	switch (backing) {
+		case RANDOMX_PAGES_LARGE:
+			return "large";
+		case RANDOMX_PAGES_TRANSPARENT:
+			return "transparent";
+		case RANDOMX_PAGES_1GB:
+			return "1gb";
+		case RANDOMX_PAGES_CUSTOM:
+			return "custom";
+		default:
+			return "standard";
+	}
+}
+
+void printFlagsJson(std::ostream& os, randomx_flags flags) {
+	static const struct {
+		randomx_flags flag;
+		const char* name;
+	} names[] = {
+		{ RANDOMX_FLAG_LARGE_PAGES, "LARGE_PAGES" },
+		{ RANDOMX_FLAG_HARD_AES, "HARD_AES" },
+		{ RANDOMX_FLAG_FULL_MEM, "FULL_MEM" },
+		{ RANDOMX_FLAG_JIT, "JIT" },
+		{ RANDOMX_FLAG_SECURE, "SECURE" },
+		{ RANDOMX_FLAG_ARGON2_SSSE3, "ARGON2_SSSE3" },
+		{ RANDOMX_FLAG_ARGON2_AVX2, "ARGON2_AVX2" },
+		{ RANDOMX_FLAG_NUMA, "NUMA" },
+		{ RANDOMX_FLAG_VAES, "VAES" },
+		{ RANDOMX_FLAG_ARGON2_AVX512, "ARGON2_AVX512" },
+		{ RANDOMX_FLAG_ARGON2_NEON, "ARGON2_NEON" },
+		{ RANDOMX_FLAG_DATASET_AVX512, "DATASET_AVX512" },
+		{ RANDOMX_FLAG_AES_VPERM, "AES_VPERM" },
+		{ RANDOMX_FLAG_LARGE_PAGES_1GB, "LARGE_PAGES_1GB" },
+		{ RANDOMX_FLAG_PREFAULT, "PREFAULT" },
+		{ RANDOMX_FLAG_PREFETCH_T0, "PREFETCH_T0" },
+		{ RANDOMX_FLAG_PREFETCH_SCRATCHPAD, "PREFETCH_SCRATCHPAD" },
+		{ RANDOMX_FLAG_JIT_SCHEDULE, "JIT_SCHEDULE" },
+		{ RANDOMX_FLAG_JIT_SHARED_CODE, "JIT_SHARED_CODE" },
+	};
+	os << "[";
+	bool first = true;
+	for (auto& entry : names) {
+		if (flags & entry.flag) {
+			os << (first ? "" : ", ") << "\"" << entry.name << "\"";
+			first = false;
+		}
+	}
+	os << "]";
+}
+
+void printLatencyJson(std::ostream& os, const LatencyHistogram& latencies) {
+	os << "{ \"hashes\": " << latencies.getCount();
+	os << ", \"minNs\": " << latencies.getMin();
+	os << ", \"meanNs\": " << (uint64_t)latencies.getMean();
+	os << ", \"p50Ns\": " << latencies.getPercentile(50);
+	os << ", \"p90Ns\": " << latencies.getPercentile(90);
+	os << ", \"p99Ns\": " << latencies.getPercentile(99);
+	os << ", \"p999Ns\": " << latencies.getPercentile(99.9);
+	os << ", \"maxNs\": " << latencies.getMax();
+	os << ", \"histogram\": [";
+	bool first = true;
+	latencies.forEachBucket([&](uint64_t lowest, uint64_t highest, uint64_t count) {
+		os << (first ? "" : ", ") << "[" << lowest << ", " << highest << ", " << count << "]";
+		first = false;
+	});
+	os << "] }";
+}
+
+void printPerfCounters(const PerfTotals& totals, uint32_t hashCount) {
+	std::cout << "Performance counters per hash:" << std::endl;
+	for (int i = 0; i < PerfCounters::EventCount; ++i) {
+		std::cout << "  " << std::left << std::setw(15) << PerfCounters::eventName(i);
+		if (totals.isAvailable(i))
+			std::cout << std::fixed << std::setprecision(1) << (double)totals.getValue(i) / hashCount << std::endl;
+		else
+			std::cout << "n/a" << std::endl;
+		std::cout.copyfmt(std::ios(nullptr));
+	}
+	if (totals.isAvailable(PerfCounters::Cycles) && totals.isAvailable(PerfCounters::Instructions) && totals.getValue(PerfCounters::Cycles) != 0) {
+		std::cout << "  IPC            " << (double)totals.getValue(PerfCounters::Instructions) / totals.getValue(PerfCounters::Cycles) << std::endl;
+	}
+}
+
+//nonces a thread takes from its share of the nonce range at a time
+constexpr uint32_t NonceBatchSize = 16;
+
+int nodeOfCpu(unsigned cpu) {
+	for (unsigned node = 0; node < randomx_numa_node_count(); ++node) {
+		if (cpu < 64 && (randomx_numa_node_cpu_mask(node) & (1ULL << cpu)))
+			return node;
+	}
+	return 0;
+}
+
+enum class InitPlacement {
+	Compact,
+	Scatter,
+	PerNode,
+};
+
+const char* placementName(InitPlacement placement) {
+	switch (placement) {
+		case InitPlacement::Compact:
+			return "compact";
+		case InitPlacement::Scatter:
+			return "scatter";
+		default:
+			return "numa";
+	}
+}
+
+//CPUs of the first threadCount threads for the given placement
+std::vector<int> placeThreads(InitPlacement placement, unsigned threadCount, unsigned cpuCount) {
+	std::vector<int> cpus;
+	if (placement == InitPlacement::PerNode) {
+		std::vector<std::vector<int>> nodeCpus;
+		for (unsigned node = 0; node < randomx_numa_node_count(); ++node) {
+			uint64_t mask = randomx_numa_node_cpu_mask(node);
+			std::vector<int> list;
+			for (unsigned i = 0; i < 64; ++i) {
+				if (mask & (1ULL << i))
+					list.push_back(i);
+			}
+			if (!list.empty())
+				nodeCpus.push_back(list);
+		}
+		//threads are dealt to the nodes in turn and fill each node in order
+		for (unsigned i = 0; i < threadCount; ++i) {
+			auto& list = nodeCpus[i % nodeCpus.size()];
+			cpus.push_back(list[(i / nodeCpus.size()) % list.size()]);
+		}
+	}
+	else {
+		for (unsigned i = 0; i < threadCount; ++i) {
+			if (placement == InitPlacement::Compact)
+				cpus.push_back(i % cpuCount);
+			else
+				cpus.push_back((uint64_t)i * cpuCount / threadCount);
+		}
+	}
+	return cpus;
+}
+
+void runInParallel(const std::vector<int>& cpus, const std::function<void(unsigned)>& func) {
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < cpus.size(); ++i) {
+		workers.push_back(std::thread([&, i]() {
+			int rc = set_thread_affinity(cpus[i]);
+			if (rc) {
+				std::cerr << "Failed to set thread affinity for thread " << i << " (error=" << rc << ")" << std::endl;
+			}
+			func(i);
+		}));
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+//measures the dataset initialization for an increasing number of threads and several thread placements
+void runInitSweep(randomx_flags flags, const void* seed, size_t seedSize, unsigned maxThreads) {
+	const unsigned cpuCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 64u);
+	const unsigned long itemCount = randomx_dataset_item_count();
+	const unsigned long chunkItems = 16384;
+	const size_t pageSize = 4096;
+	//the sweep touches the pages itself to measure the page faults separately
+	flags = (randomx_flags)(flags & ~RANDOMX_FLAG_PREFAULT);
+	if (maxThreads <= 1) {
+		maxThreads = cpuCount;
+	}
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+	std::vector<InitPlacement> placements = { InitPlacement::Compact, InitPlacement::Scatter };
+	if (randomx_numa_node_count() > 1) {
+		placements.push_back(InitPlacement::PerNode);
+	}
+
+	Stopwatch sw(true);
+	randomx_cache* cache = randomx_alloc_cache((randomx_flags)(flags & ~RANDOMX_FLAG_NUMA));
+	if (cache == nullptr) {
+		throw CacheAllocException();
+	}
+	randomx_init_cache(cache, seed, seedSize);
+	double cacheTime = sw.getElapsed();
+	std::cout << "Argon2 cache initialized in " << cacheTime << " s (single-threaded)" << std::endl;
+	std::cout << "Dataset: " << itemCount << " items, " << cpuCount << " hardware threads, " << randomx_numa_node_count() << " NUMA node(s)" << std::endl;
+	std::cout << "placement threads   alloc [s]   fault [s]    init [s]  items/s/thread  efficiency" << std::endl;
+
+	for (auto placement : placements) {
+		double singleThreadRate = 0;
+		for (auto threads : threadCounts) {
+			auto cpus = placeThreads(placement, threads, cpuCount);
+			randomx_flags datasetFlags = flags;
+			if (placement == InitPlacement::PerNode)
+				datasetFlags |= RANDOMX_FLAG_NUMA;
+			else
+				datasetFlags = (randomx_flags)(datasetFlags & ~RANDOMX_FLAG_NUMA);
+			sw.restart();
+			randomx_dataset* dataset = randomx_alloc_dataset(datasetFlags);
+			if (dataset == nullptr) {
+				randomx_release_cache(cache);
+				throw DatasetAllocException();
+			}
+			double allocTime = sw.getElapsed();
+
+			//each thread writes to one byte per page of its share of the dataset
+			uint8_t* memory = (uint8_t*)randomx_get_dataset_memory(dataset);
+			const size_t pageCount = (randomx::DatasetSize + pageSize - 1) / pageSize;
+			sw.restart();
+			runInParallel(cpus, [&](unsigned thread) {
+				size_t first = pageCount * thread / threads;
+				size_t last = pageCount * (thread + 1) / threads;
+				for (size_t page = first; page < last; ++page) {
+					memory[page * pageSize] = 0;
+				}
+			});
+			double faultTime = sw.getElapsed();
+
+			std::atomic<unsigned long> nextItem(0);
+			sw.restart();
+			runInParallel(cpus, [&](unsigned) {
+				for (;;) {
+					unsigned long startItem = nextItem.fetch_add(chunkItems);
+					if (startItem >= itemCount)
+						break;
+					randomx_init_dataset(dataset, cache, startItem, std::min(chunkItems, itemCount - startItem));
+				}
+			});
+			double initTime = sw.getElapsed();
+			randomx_release_dataset(dataset);
+
+			double threadRate = itemCount / initTime / threads;
+			if (threads == 1)
+				singleThreadRate = threadRate;
+			std::cout << std::left << std::setw(9) << placementName(placement) << std::right << std::setw(8) << threads;
+			std::cout << std::fixed << std::setprecision(3) << std::setw(12) << allocTime << std::setw(12) << faultTime << std::setw(12) << initTime;
+			std::cout << std::setprecision(0) << std::setw(16) << threadRate;
+			std::cout << std::setprecision(1) << std::setw(11) << 100 * threadRate / singleThreadRate << "%" << std::endl;
+			std::cout.copyfmt(std::ios(nullptr));
+		}
+	}
+	randomx_release_cache(cache);
 }
 
 int main(int argc, char** argv) {
-	bool softAes, miningMode, verificationMode, help, largePages, jit, secure, commit;
-	bool ssse3, avx2, autoFlags, noBatch;
-	int noncesCount, threadCount, initThreadCount;
+	bool softAes, miningMode, verificationMode, help, largePages, gigaPages, prefault, numa, jit, secure, commit, perf, json, initSweep;
+	bool ssse3, avx2, avx512, neon, vaes, vperm, avx512ds, autoFlags, noBatch, prefetchT0, prefetchSp, schedule, sharedCode, stagger;
+	int noncesCount, threadCount, initThreadCount, interleave, lazyMiB, soakSeconds, soakInterval;
 	uint64_t threadAffinity;
 	int32_t seedValue;
 	char seed[4];
@@ -162,10 +652,23 @@ int main(int argc, char** argv) {
 	readOption("--verify", argc, argv, verificationMode);
 	readIntOption("--threads", argc, argv, threadCount, 1);
 	readUInt64Option("--affinity", argc, argv, threadAffinity, 0);
+	const char* placementOption = readStringOption("--placement", argc, argv);
+	randomx_placement placement = RANDOMX_PLACEMENT_NONE;
+	if (placementOption != nullptr && threadAffinity == 0) {
+		if (strcmp(placementOption, "fast") == 0)
+			placement = RANDOMX_PLACEMENT_FAST_CORES;
+		else if (strcmp(placementOption, "all") == 0)
+			placement = RANDOMX_PLACEMENT_ALL_CORES;
+		else if (strcmp(placementOption, "pairs") == 0)
+			placement = RANDOMX_PLACEMENT_SMT_PAIRS;
+	}
 	readIntOption("--nonces", argc, argv, noncesCount, 1000);
 	readIntOption("--init", argc, argv, initThreadCount, 1);
 	readIntOption("--seed", argc, argv, seedValue, 0);
 	readOption("--largePages", argc, argv, largePages);
+	readOption("--1gbPages", argc, argv, gigaPages);
+	readOption("--prefault", argc, argv, prefault);
+	readOption("--numa", argc, argv, numa);
 	if (!largePages) {
 		readOption("--largepages", argc, argv, largePages);
 	}
@@ -174,9 +677,32 @@ int main(int argc, char** argv) {
 	readOption("--secure", argc, argv, secure);
 	readOption("--ssse3", argc, argv, ssse3);
 	readOption("--avx2", argc, argv, avx2);
+	readOption("--avx512", argc, argv, avx512);
+	readOption("--neon", argc, argv, neon);
+	readOption("--vaes", argc, argv, vaes);
+	readOption("--vperm", argc, argv, vperm);
+	readOption("--avx512ds", argc, argv, avx512ds);
+	readOption("--prefetchT0", argc, argv, prefetchT0);
+	readOption("--prefetchSp", argc, argv, prefetchSp);
+	readOption("--schedule", argc, argv, schedule);
+	readOption("--sharedCode", argc, argv, sharedCode);
+	readOption("--stagger", argc, argv, stagger);
 	readOption("--auto", argc, argv, autoFlags);
 	readOption("--noBatch", argc, argv, noBatch);
 	readOption("--commit", argc, argv, commit);
+	readIntOption("--interleave", argc, argv, interleave, 1);
+	readIntOption("--lazy", argc, argv, lazyMiB, 0);
+	readOption("--perf", argc, argv, perf);
+	readIntOption("--soak", argc, argv, soakSeconds, 0);
+	readIntOption("--interval", argc, argv, soakInterval, 10);
+	readOption("--json", argc, argv, json);
+	readOption("--initSweep", argc, argv, initSweep);
+
+	//the JSON document is the only output on stdout
+	std::ostream jsonOut(std::cout.rdbuf());
+	if (json) {
+		std::cout.rdbuf(std::cerr.rdbuf());
+	}
 
 	store32(&seed, seedValue);
 
@@ -187,15 +713,34 @@ int main(int argc, char** argv) {
 		return 0;
 	}
 
+	if (initSweep) {
+		miningMode = true;
+	}
+
 	if (!miningMode && !verificationMode) {
 		std::cout << "Please select either the fast mode (--mine) or the slow mode (--verify)" << std::endl;
 		std::cout << "Run '" << argv[0] << " --help' to see all supported options" << std::endl;
 		return 0;
 	}
 
-	std::atomic<uint32_t> atomicNonce(0);
+	if (interleave != 1 && (!miningMode || commit)) {
+		std::cout << "Interleaved mode requires --mine and doesn't support --commit" << std::endl;
+		return 0;
+	}
+
+	if (lazyMiB != 0 && (!verificationMode || jit)) {
+		std::cout << "Lazy mode requires --verify and doesn't support --jit" << std::endl;
+		return 0;
+	}
+
+	if (soakSeconds < 0 || soakInterval <= 0) {
+		std::cout << "Invalid soak duration or interval" << std::endl;
+		return 0;
+	}
+
 	AtomicHash result;
 	std::vector<randomx_vm*> vms;
+	randomx_scratchpad_arena* arena = nullptr;
 	std::vector<std::thread> threads;
 	randomx_dataset* dataset;
 	randomx_cache* cache;
@@ -213,20 +758,56 @@ int main(int argc, char** argv) {
 		if (avx2) {
 			flags |= RANDOMX_FLAG_ARGON2_AVX2;
 		}
+		if (avx512) {
+			flags |= RANDOMX_FLAG_ARGON2_AVX512;
+		}
+		if (neon) {
+			flags |= RANDOMX_FLAG_ARGON2_NEON;
+		}
 		if (!softAes) {
 			flags |= RANDOMX_FLAG_HARD_AES;
 		}
+		if (vaes) {
+			flags |= RANDOMX_FLAG_VAES;
+		}
+		if (vperm) {
+			flags |= RANDOMX_FLAG_AES_VPERM;
+		}
 		if (jit) {
 			flags |= RANDOMX_FLAG_JIT;
 #ifdef RANDOMX_FORCE_SECURE
 			flags |= RANDOMX_FLAG_SECURE;
 #endif
 		}
+		if (avx512ds) {
+			flags |= RANDOMX_FLAG_DATASET_AVX512;
+		}
 	}
 
 	if (largePages) {
 		flags |= RANDOMX_FLAG_LARGE_PAGES;
 	}
+	if (gigaPages) {
+		flags |= RANDOMX_FLAG_LARGE_PAGES_1GB;
+	}
+	if (prefault) {
+		flags |= RANDOMX_FLAG_PREFAULT;
+	}
+	if (prefetchT0) {
+		flags |= RANDOMX_FLAG_PREFETCH_T0;
+	}
+	if (prefetchSp) {
+		flags |= RANDOMX_FLAG_PREFETCH_SCRATCHPAD;
+	}
+	if (schedule) {
+		flags |= RANDOMX_FLAG_JIT_SCHEDULE;
+	}
+	if (sharedCode) {
+		flags |= RANDOMX_FLAG_JIT_SHARED_CODE;
+	}
+	if (numa) {
+		flags |= RANDOMX_FLAG_NUMA;
+	}
 	if (miningMode) {
 		flags |= RANDOMX_FLAG_FULL_MEM;
 	}
@@ -236,7 +817,13 @@ int main(int argc, char** argv) {
 	}
 #endif
 
-	if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
+	if (flags & RANDOMX_FLAG_ARGON2_NEON) {
+		std::cout << " - Argon2 implementation: NEON" << std::endl;
+	}
+	else if (flags & RANDOMX_FLAG_ARGON2_AVX512) {
+		std::cout << " - Argon2 implementation: AVX-512" << std::endl;
+	}
+	else if (flags & RANDOMX_FLAG_ARGON2_AVX2) {
 		std::cout << " - Argon2 implementation: AVX2" << std::endl;
 	}
 	else if (flags & RANDOMX_FLAG_ARGON2_SSSE3) {
@@ -258,6 +845,21 @@ int main(int argc, char** argv) {
 		if (flags & RANDOMX_FLAG_SECURE) {
 			std::cout << "(secure)";
 		}
+		if (flags & RANDOMX_FLAG_DATASET_AVX512) {
+			std::cout << "(AVX-512 dataset initialization)";
+		}
+		if (flags & RANDOMX_FLAG_PREFETCH_T0) {
+			std::cout << "(prefetcht0)";
+		}
+		if (flags & RANDOMX_FLAG_PREFETCH_SCRATCHPAD) {
+			std::cout << "(scratchpad prefetch)";
+		}
+		if (flags & RANDOMX_FLAG_JIT_SCHEDULE) {
+			std::cout << "(scheduled)";
+		}
+		if (flags & RANDOMX_FLAG_JIT_SHARED_CODE) {
+			std::cout << "(shared code)";
+		}
 		std::cout << std::endl;
 	}
 	else {
@@ -265,10 +867,14 @@ int main(int argc, char** argv) {
 	}
 
 	if (flags & RANDOMX_FLAG_HARD_AES) {
-		std::cout << " - hardware AES mode" << std::endl;
+		std::cout << " - hardware AES mode" << ((flags & RANDOMX_FLAG_VAES) ? " (VAES)" : "") << std::endl;
 	}
 	else {
-		std::cout << " - software AES mode" << std::endl;
+		std::cout << " - software AES mode" << ((flags & RANDOMX_FLAG_AES_VPERM) ? " (vector permute)" : "") << std::endl;
+	}
+
+	if ((flags & RANDOMX_FLAG_NUMA) && miningMode) {
+		std::cout << " - NUMA mode (" << randomx_numa_node_count() << " node(s))" << std::endl;
 	}
 
 	if (flags & RANDOMX_FLAG_LARGE_PAGES) {
@@ -281,6 +887,12 @@ int main(int argc, char** argv) {
 	if (threadAffinity) {
 		std::cout << " - thread affinity (" << mask_to_string(threadAffinity) << ")" << std::endl;
 	}
+	std::vector<unsigned> placementCpus;
+	if (placement != RANDOMX_PLACEMENT_NONE) {
+		placementCpus.resize(threadCount);
+		randomx_thread_placement(placement, threadCount, placementCpus.data(), nullptr);
+		std::cout << " - thread placement (" << placementOption << " cores)" << std::endl;
+	}
 
 	MineFunc* func;
 
@@ -294,19 +906,36 @@ int main(int argc, char** argv) {
 		}
 	}
 	else {
+		std::cout << " - batch mode" << std::endl;
 		if (commit) {
-			//TODO: support batch mode with commitments
 			std::cout << " - hash commitments" << std::endl;
-			func = &mine<false, true>;
+			func = &mine<true, true>;
 		}
 		else {
-			std::cout << " - batch mode" << std::endl;
 			func = &mine<true, false>;
 		}
 	}
 
+	if (interleave == 2) {
+		func = &mineInterleaved<2>;
+	}
+	else if (interleave == 3) {
+		func = &mineInterleaved<3>;
+	}
+	else if (interleave == 4) {
+		func = &mineInterleaved<4>;
+	}
+	if (interleave != 1) {
+		std::cout << " - interleaved mode (" << interleave << " lanes)" << std::endl;
+	}
+	if (lazyMiB != 0) {
+		std::cout << " - lazy mode (" << lazyMiB << " MiB item table)" << std::endl;
+	}
+
 	std::cout << "Initializing";
-	if (miningMode)
+	if (initSweep)
+		std::cout << " sweep";
+	else if (miningMode)
 		std::cout << " (" << initThreadCount << " thread" << (initThreadCount > 1 ? "s)" : ")");
 	std::cout << " ..." << std::endl;
 
@@ -321,43 +950,92 @@ int main(int argc, char** argv) {
 			std::cout << "WARNING: You are using the interpreter mode. Use --jit for optimal performance." << std::endl;
 		}
 
+		if (initSweep) {
+			runInitSweep(flags, &seed, sizeof(seed), initThreadCount);
+			return 0;
+		}
+
 		Stopwatch sw(true);
 		cache = randomx_alloc_cache(flags);
 		if (cache == nullptr) {
 			throw CacheAllocException();
 		}
-		randomx_init_cache(cache, &seed, sizeof(seed));
+		randomx_init_cache_parallel(cache, &seed, sizeof(seed), initThreadCount);
+		double cacheInitTime = sw.getElapsed();
+		randomx_page_backing cacheBacking = randomx_cache_page_backing(cache);
+		if (largePages && cacheBacking != RANDOMX_PAGES_LARGE) {
+			printLargePagesFallback("Cache");
+		}
+		randomx_page_backing datasetBacking = RANDOMX_PAGES_STANDARD;
+		size_t datasetPageSize = 0;
+		double prefaultTime = 0;
 		if (miningMode) {
 			dataset = randomx_alloc_dataset(flags);
 			if (dataset == nullptr) {
 				throw DatasetAllocException();
 			}
-			uint32_t datasetItemCount = randomx_dataset_item_count();
-			if (initThreadCount > 1) {
-				auto perThread = datasetItemCount / initThreadCount;
-				auto remainder = datasetItemCount % initThreadCount;
-				uint32_t startItem = 0;
-				for (int i = 0; i < initThreadCount; ++i) {
-					auto count = perThread + (i == initThreadCount - 1 ? remainder : 0);
-					threads.push_back(std::thread(&randomx_init_dataset, dataset, cache, startItem, count));
-					startItem += count;
-				}
-				for (unsigned i = 0; i < threads.size(); ++i) {
-					threads[i].join();
-				}
+			if (gigaPages) {
+				std::cout << "Dataset page size: " << randomx_dataset_page_size(dataset) / 1024 << " KiB" << std::endl;
 			}
-			else {
-				randomx_init_dataset(dataset, cache, 0, datasetItemCount);
+			datasetBacking = randomx_dataset_page_backing(dataset);
+			if (largePages && datasetBacking != RANDOMX_PAGES_LARGE && datasetBacking != RANDOMX_PAGES_1GB) {
+				printLargePagesFallback("Dataset");
 			}
+			datasetPageSize = randomx_dataset_page_size(dataset);
+			prefaultTime = randomx_dataset_prefault_time(dataset);
+			if (prefault) {
+				std::cout << "Dataset pages pre-faulted in " << prefaultTime << " s" << std::endl;
+			}
+			if (placement != RANDOMX_PLACEMENT_NONE)
+				randomx_init_dataset_placed(dataset, cache, placement, initThreadCount);
+			else
+				randomx_init_dataset_parallel(dataset, cache, initThreadCount, threadAffinity);
 			randomx_release_cache(cache);
 			cache = nullptr;
-			threads.clear();
 		}
-		std::cout << "Memory initialized in " << sw.getElapsed() << " s" << std::endl;
+		double memoryInitTime = sw.getElapsed();
+		std::cout << "Memory initialized in " << memoryInitTime << " s" << std::endl;
 		std::cout << "Initializing " << threadCount << " virtual machine(s) ..." << std::endl;
+		if (stagger && interleave == 1 && lazyMiB == 0 && !(numa && miningMode)) {
+			arena = randomx_alloc_scratchpad_arena_layout(threadCount, flags, RANDOMX_ARENA_STAGGERED);
+			if (arena == nullptr) {
+				throw std::runtime_error("Cannot allocate the scratchpad arena");
+			}
+			std::cout << " - staggered scratchpads" << std::endl;
+		}
 		for (int i = 0; i < threadCount; ++i) {
-			randomx_vm *vm = randomx_create_vm(flags, cache, dataset);
+			randomx_vm *vm;
+			if (interleave != 1) {
+				vm = randomx_create_vm_interleaved(flags, dataset, interleave);
+				if (vm == nullptr) {
+					throw std::runtime_error("Cannot create interleaved VM. Supported with 2 to 4 lanes (--jit only on x86-64)");
+				}
+			}
+			else if (lazyMiB != 0) {
+				vm = randomx_create_vm_lazy(flags, cache, (size_t)lazyMiB * 1024 * 1024);
+			}
+			else if (numa && miningMode) {
+				//threads without affinity are spread over the nodes, but may migrate
+				unsigned node = i % randomx_numa_node_count();
+				if (threadAffinity)
+					node = nodeOfCpu(cpuid_from_mask(threadAffinity, i));
+				else if (!placementCpus.empty())
+					node = nodeOfCpu(placementCpus[i]);
+				vm = randomx_create_vm_on_node(flags, cache, dataset, node);
+			}
+			else if (arena != nullptr) {
+				vm = randomx_create_vm_arena(flags, cache, dataset, arena);
+			}
+			else {
+				vm = randomx_create_vm(flags, cache, dataset);
+			}
 			if (vm == nullptr) {
+				if ((flags & RANDOMX_FLAG_VAES)) {
+					throw std::runtime_error("Cannot create VM with the selected options. Try without --vaes");
+				}
+				if ((flags & RANDOMX_FLAG_AES_VPERM)) {
+					throw std::runtime_error("Cannot create VM with the selected options. Try without --vperm");
+				}
 				if ((flags & RANDOMX_FLAG_HARD_AES)) {
 					throw std::runtime_error("Cannot create VM with the selected options. Try using --softAes");
 				}
@@ -368,39 +1046,137 @@ int main(int argc, char** argv) {
 			}
 			vms.push_back(vm);
 		}
-		std::cout << "Running benchmark (" << noncesCount << " nonces) ..." << std::endl;
+		randomx_nonce_scheduler* scheduler = randomx_nonce_scheduler_create(vms.size(), NonceBatchSize);
+		if (scheduler == nullptr) {
+			throw std::runtime_error("Cannot create nonce scheduler");
+		}
+		for (unsigned i = 0; i < vms.size(); ++i) {
+			randomx_nonce_scheduler_set_vm(scheduler, i, vms[i]);
+		}
+		const bool soak = soakSeconds > 0;
+		//a soak run is stopped by the monitor long before it runs out of nonces
+		randomx_nonce_scheduler_reset(scheduler, 0, soak ? UINT32_MAX : noncesCount);
+		PerfTotals perfTotals;
+		std::vector<LatencyHistogram> latencies(json ? vms.size() : 0);
+		std::atomic<bool> soakStop(false);
+		std::vector<SoakThread> soakThreads(soak ? vms.size() : 0);
+		std::vector<SoakSample> soakSamples;
+		//counts the events of the calling thread while it runs the hashing loop
+		auto worker = [&](randomx_vm* vm, int thread, int cpuid) {
+			LatencyHistogram* threadLatencies = json ? &latencies[thread] : nullptr;
+			SoakThread* threadSoak = soak ? &soakThreads[thread] : nullptr;
+			if (threadSoak != nullptr)
+				threadSoak->start(&soakStop);
+			if (!perf) {
+				func(vm, scheduler, result, thread, cpuid, threadLatencies, threadSoak);
+				return;
+			}
+			PerfCounters counters;
+			counters.start();
+			func(vm, scheduler, result, thread, cpuid, threadLatencies, threadSoak);
+			counters.stop();
+			perfTotals.add(counters);
+		};
+		if (soak)
+			std::cout << "Running soak benchmark (" << soakSeconds << " s, " << soakInterval << " s interval) ..." << std::endl;
+		else
+			std::cout << "Running benchmark (" << noncesCount << " nonces) ..." << std::endl;
 		sw.restart();
-		if (threadCount > 1) {
+		if (threadCount > 1 || soak) {
 			for (unsigned i = 0; i < vms.size(); ++i) {
 				int cpuid = -1;
 				if (threadAffinity)
 					cpuid = cpuid_from_mask(threadAffinity, i);
-				threads.push_back(std::thread(func, vms[i], std::ref(atomicNonce), std::ref(result), noncesCount, i, cpuid));
+				else if (!placementCpus.empty())
+					cpuid = placementCpus[i];
+				threads.push_back(std::thread(worker, vms[i], i, cpuid));
 			}
+			if (soak)
+				soakSamples = runSoakMonitor(soakThreads, soakSeconds, soakInterval, soakStop);
 			for (unsigned i = 0; i < threads.size(); ++i) {
 				threads[i].join();
 			}
 		}
 		else {
-			func(vms[0], std::ref(atomicNonce), std::ref(result), noncesCount, 0, -1);
+			worker(vms[0], 0, -1);
 		}
 
 		double elapsed = sw.getElapsed();
+		uint64_t hashCount = noncesCount;
+		if (soak) {
+			hashCount = 0;
+			for (auto& thread : soakThreads)
+				hashCount += thread.getHashes();
+		}
+		randomx_nonce_scheduler_destroy(scheduler);
+		randomx_page_backing vmBacking = randomx_vm_page_backing(vms[0]);
 		for (unsigned i = 0; i < vms.size(); ++i)
 			randomx_destroy_vm(vms[i]);
+		if (arena != nullptr)
+			randomx_release_scratchpad_arena(arena);
 		if (miningMode)
 			randomx_release_dataset(dataset);
 		else
 			randomx_release_cache(cache);
 		std::cout << "Calculated result: ";
 		result.print(std::cout);
-		if (noncesCount == 1000 && seedValue == 0 && !commit)
+		if (noncesCount == 1000 && seedValue == 0 && !commit && !soak)
 			std::cout << "Reference result:  10b649a3f15c7c7f88277812f2e74b337a0f20ce909af09199cccb960771cfa1" << std::endl;
 		if (!miningMode) {
-			std::cout << "Performance: " << 1000 * elapsed / noncesCount << " ms per hash" << std::endl;
+			std::cout << "Performance: " << 1000 * elapsed / hashCount << " ms per hash" << std::endl;
 		}
 		else {
-			std::cout << "Performance: " << noncesCount / elapsed << " hashes per second" << std::endl;
+			std::cout << "Performance: " << hashCount / elapsed << " hashes per second" << std::endl;
+		}
+		if (soak) {
+			printSoakSummary(soakSamples);
+		}
+		if (perf) {
+			printPerfCounters(perfTotals, hashCount);
+		}
+		if (json) {
+			std::ostringstream resultHex;
+			result.print(resultHex);
+			std::string resultString = resultHex.str();
+			resultString.erase(resultString.find_last_not_of('\n') + 1);
+			jsonOut << "{" << std::endl;
+			jsonOut << "  \"version\": \"1.2.1\"," << std::endl;
+			jsonOut << "  \"mode\": \"" << (miningMode ? "mine" : "verify") << "\"," << std::endl;
+			jsonOut << "  \"flags\": " << (int)flags << "," << std::endl;
+			jsonOut << "  \"flagNames\": ";
+			printFlagsJson(jsonOut, flags);
+			jsonOut << "," << std::endl;
+			jsonOut << "  \"threads\": " << threadCount << "," << std::endl;
+			jsonOut << "  \"initThreads\": " << initThreadCount << "," << std::endl;
+			jsonOut << "  \"affinity\": \"0x" << std::hex << threadAffinity << std::dec << "\"," << std::endl;
+			jsonOut << "  \"nonces\": " << noncesCount << "," << std::endl;
+			jsonOut << "  \"seed\": " << seedValue << "," << std::endl;
+			jsonOut << "  \"batch\": " << (!noBatch && interleave == 1 ? "true" : "false") << "," << std::endl;
+			jsonOut << "  \"commit\": " << (commit ? "true" : "false") << "," << std::endl;
+			jsonOut << "  \"interleave\": " << interleave << "," << std::endl;
+			jsonOut << "  \"lazyMiB\": " << lazyMiB << "," << std::endl;
+			jsonOut << "  \"cachePages\": \"" << pageBackingName(cacheBacking) << "\"," << std::endl;
+			if (miningMode) {
+				jsonOut << "  \"datasetPages\": \"" << pageBackingName(datasetBacking) << "\"," << std::endl;
+				jsonOut << "  \"datasetPageSize\": " << datasetPageSize << "," << std::endl;
+				jsonOut << "  \"datasetPrefaultTime\": " << prefaultTime << "," << std::endl;
+				jsonOut << "  \"datasetInitTime\": " << memoryInitTime - cacheInitTime << "," << std::endl;
+			}
+			jsonOut << "  \"scratchpadPages\": \"" << pageBackingName(vmBacking) << "\"," << std::endl;
+			jsonOut << "  \"cacheInitTime\": " << cacheInitTime << "," << std::endl;
+			jsonOut << "  \"elapsed\": " << elapsed << "," << std::endl;
+			jsonOut << "  \"hashesPerSecond\": " << hashCount / elapsed << "," << std::endl;
+			if (soak)
+				printSoakJson(jsonOut, soakSeconds, soakInterval, soakSamples);
+			jsonOut << "  \"result\": \"" << resultString << "\"," << std::endl;
+			jsonOut << "  \"latency\": [" << std::endl;
+			for (unsigned i = 0; i < latencies.size(); ++i) {
+				jsonOut << "    ";
+				printLatencyJson(jsonOut, latencies[i]);
+				jsonOut << (i + 1 < latencies.size() ? "," : "") << std::endl;
+			}
+			jsonOut << "  ]" << std::endl;
+			jsonOut << "}" << std::endl;
 		}
 	}
 	catch (MemoryException& e) {
@@ -33,6 +33,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../aes_hash.hpp"
 #include "../blake2/blake2.h"
 #include "../program.hpp"
+#include "../dataset.hpp"
+#include <vector>
 
 const uint8_t seed[32] = { 191, 182, 222, 175, 249, 89, 134, 104, 241, 68, 191, 62, 162, 166, 61, 64, 123, 191, 227, 193, 118, 60, 188, 53, 223, 133, 175, 24, 123, 230, 55, 74 };
 
@@ -73,6 +75,20 @@ void generateNative(uint32_t nonce) {
 	std::cout << prog << std::endl;
 }
 
+void generateDatasetC(const std::vector<char>& key, const char* name) {
+	randomx::SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES];
+	randomx::Blake2Generator gen(key.data(), key.size());
+	for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+		randomx::generateSuperscalar(programs[i], gen);
+	}
+	uint8_t keyHash[32], configHash[randomx::ConfigurationHashSize];
+	blake2b(keyHash, sizeof(keyHash), key.data(), key.size(), nullptr, 0);
+	randomx::hashConfiguration(configHash);
+	randomx::AssemblyGeneratorX86 asmX86;
+	asmX86.generateDatasetC(programs, keyHash, configHash, name);
+	asmX86.printCode(std::cout);
+}
+
 void printUsage(const char* executable) {
 	std::cout << "Usage: " << executable << " [OPTIONS]" << std::endl;
 	std::cout << "Supported options:" << std::endl;
@@ -81,10 +97,14 @@ void printUsage(const char* executable) {
 	std::cout << "  --genAsm          generate x86-64 asm code for nonce N" << std::endl;
 	std::cout << "  --genNative       generate RandomX code for nonce N" << std::endl;
 	std::cout << "  --genSuperscalar  generate superscalar program for nonce N" << std::endl;
+	std::cout << "  --genDatasetC     generate a C module calculating dataset items for a key" << std::endl;
+	std::cout << "  --key K           key of the module as text" << std::endl;
+	std::cout << "  --keyHex H        key of the module in hexadecimal" << std::endl;
+	std::cout << "  --name N          name of the module variable (default: randomx_aot_dataset)" << std::endl;
 }
 
 int main(int argc, char** argv) {
-	bool softAes, genAsm, genNative, genSuperscalar;
+	bool softAes, genAsm, genNative, genSuperscalar, genDatasetC;
 	int nonce;
 
 	readOption("--softAes", argc, argv, softAes);
@@ -92,6 +112,32 @@ int main(int argc, char** argv) {
 	readIntOption("--nonce", argc, argv, nonce, 1000);
 	readOption("--genNative", argc, argv, genNative);
 	readOption("--genSuperscalar", argc, argv, genSuperscalar);
+	readOption("--genDatasetC", argc, argv, genDatasetC);
+	const char* keyOption = readStringOption("--key", argc, argv);
+	const char* keyHexOption = readStringOption("--keyHex", argc, argv);
+	const char* nameOption = readStringOption("--name", argc, argv);
+
+	if (genDatasetC) {
+		std::vector<char> key;
+		if (keyHexOption != nullptr) {
+			size_t length = strlen(keyHexOption);
+			if (length % 2 != 0) {
+				std::cout << "Invalid hexadecimal key" << std::endl;
+				return 1;
+			}
+			key.resize(length / 2);
+			hex2bin(keyHexOption, (int)length, key.data());
+		}
+		else if (keyOption != nullptr) {
+			key.assign(keyOption, keyOption + strlen(keyOption));
+		}
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+		generateDatasetC(key, nameOption != nullptr ? nameOption : "randomx_aot_dataset");
+		return 0;
+	}
 
 	if (genSuperscalar) {
 		randomx::SuperscalarProgram p;
@@ -1,5 +1,5 @@
 #include "../aes_hash.hpp"
-#include "../jit_compiler_x86.hpp"
+#include "../jit_compiler.hpp"
 #include "../program.hpp"
 #include "utility.hpp"
 #include "stopwatch.hpp"
@@ -18,7 +18,7 @@ int main(int argc, char** argv) {
 	randomx::ProgramConfiguration config;
 
 	randomx::Program program;
-	randomx::JitCompilerX86 jit;
+	randomx::JitCompiler jit;
 
 	std::cout << "Compiling " << count << " programs..." << std::endl;
 
@@ -37,7 +37,17 @@ int main(int argc, char** argv) {
 		jit.generateProgram(program, config);
 	}
 
-	std::cout << "Elapsed: " << sw.getElapsed() << " s" << std::endl;
+	double elapsed = sw.getElapsed();
+	std::cout << "Elapsed: " << elapsed << " s (" << elapsed * 1e6 / count << " us per program)" << std::endl;
+
+	//generateProgram already includes one flush, so repeat only the flush of the last program
+	sw.restart();
+	for (int i = 0; i < count; ++i) {
+		jit.flushProgram();
+	}
+	double flush = sw.getElapsed();
+	std::cout << "Instruction cache flush: " << flush * 1e6 / count << " us per program, ";
+	std::cout << "code generation: " << (elapsed - flush) * 1e6 / count << " us per program" << std::endl;
 
 	dump((const char*)jit.getProgramFunc(), jit.getCodeSize(), "program.bin");
 	return 0;
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+//Log-linear histogram of latencies in nanoseconds (similar to HdrHistogram).
+//Values are recorded with a relative error of at most 1/32.
+class LatencyHistogram {
+public:
+	LatencyHistogram() : buckets(BucketCount, 0), count(0), sum(0), min(UINT64_MAX), max(0) {
+	}
+	void record(uint64_t value) {
+		buckets[indexOf(value)]++;
+		count++;
+		sum += value;
+		min = std::min(min, value);
+		max = std::max(max, value);
+	}
+	uint64_t getCount() const {
+		return count;
+	}
+	uint64_t getMin() const {
+		return count != 0 ? min : 0;
+	}
+	uint64_t getMax() const {
+		return max;
+	}
+	double getMean() const {
+		return count != 0 ? (double)sum / count : 0;
+	}
+	//the highest value of the bucket that contains the percentile
+	uint64_t getPercentile(double percentile) const {
+		uint64_t rank = (uint64_t)(percentile / 100 * count + 0.5);
+		rank = std::max(rank, (uint64_t)1);
+		uint64_t seen = 0;
+		for (int i = 0; i < BucketCount; ++i) {
+			seen += buckets[i];
+			if (seen >= rank)
+				return std::min(highestOf(i), max);
+		}
+		return max;
+	}
+	//calls f(lowestValue, highestValue, count) for each non-empty bucket
+	template<class F>
+	void forEachBucket(F f) const {
+		for (int i = 0; i < BucketCount; ++i) {
+			if (buckets[i] != 0)
+				f(lowestOf(i), highestOf(i), buckets[i]);
+		}
+	}
+private:
+	static constexpr int SubBucketBits = 6;
+	static constexpr int HalfCount = 1 << (SubBucketBits - 1);
+	static constexpr int BucketCount = (64 - SubBucketBits + 1) * HalfCount + HalfCount;
+
+	static int log2(uint64_t value) {
+		int result = 0;
+		while (value >>= 1)
+			result++;
+		return result;
+	}
+	//values below 2^SubBucketBits have their own bucket, each following power of 2 is split into HalfCount buckets
+	static int indexOf(uint64_t value) {
+		if (value < 2 * HalfCount)
+			return (int)value;
+		int shift = log2(value) - SubBucketBits + 1;
+		return shift * HalfCount + (int)(value >> shift);
+	}
+	static uint64_t lowestOf(int index) {
+		if (index < 2 * HalfCount)
+			return index;
+		int shift = index / HalfCount - 1;
+		return (uint64_t)(index - shift * HalfCount) << shift;
+	}
+	static uint64_t highestOf(int index) {
+		if (index < 2 * HalfCount)
+			return index;
+		int shift = index / HalfCount - 1;
+		return lowestOf(index) + ((uint64_t)1 << shift) - 1;
+	}
+	std::vector<uint64_t> buckets;
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+};
@@ -0,0 +1,280 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include "stopwatch.hpp"
+#include "utility.hpp"
+#include "../common.hpp"
+#include "../intrin_portable.h"
+#include "../aes_hash.hpp"
+#include "../blake2/blake2.h"
+#include "../blake2_generator.hpp"
+#include "../superscalar.hpp"
+#include "../reciprocal.h"
+#include "../program.hpp"
+#include "../cpu.hpp"
+#include "../argon2.h"
+#include "../argon2_core.h"
+#include "../dataset.hpp"
+#include "../jit_compiler.hpp"
+
+struct Kernel {
+	std::string name;
+	size_t bytesPerOp; //0 if throughput in bytes is not meaningful
+	std::function<void()> run;
+};
+
+static double minTime;
+static std::string filter;
+
+static bool isSelected(const std::string& name) {
+	return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+//runs the kernel until at least minTime seconds are spent (after one warmup call)
+static void measure(const Kernel& kernel) {
+	if (!isSelected(kernel.name))
+		return;
+	kernel.run();
+	uint64_t ops = 0;
+	uint64_t batch = 1;
+	Stopwatch sw(true);
+	double elapsed;
+	for (;;) {
+		for (uint64_t i = 0; i < batch; ++i)
+			kernel.run();
+		ops += batch;
+		elapsed = sw.getElapsed();
+		if (elapsed >= minTime)
+			break;
+		if (elapsed < minTime / 8)
+			batch *= 2;
+	}
+	double ns = elapsed * 1e9 / ops;
+	std::cout << std::left << std::setw(48) << kernel.name << std::right << std::fixed;
+	std::cout << std::setw(14) << std::setprecision(1) << ns << " ns/op";
+	if (kernel.bytesPerOp != 0)
+		std::cout << std::setw(10) << std::setprecision(2) << kernel.bytesPerOp / ns << " GB/s";
+	std::cout << std::endl;
+	std::cout.copyfmt(std::ios(nullptr));
+}
+
+static void printUsage(const char* executable) {
+	std::cout << "Usage: " << executable << " [OPTIONS]" << std::endl;
+	std::cout << "Supported options:" << std::endl;
+	std::cout << "  --help        shows this message" << std::endl;
+	std::cout << "  --time T      run each kernel for at least T milliseconds (default: 500)" << std::endl;
+	std::cout << "  --filter S    only run kernels whose name contains S" << std::endl;
+	std::cout << "  --largePages  allocate the Argon2 memory in large pages" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	bool help, largePages;
+	int timeMs;
+	readOption("--help", argc, argv, help);
+	readOption("--largePages", argc, argv, largePages);
+	readIntOption("--time", argc, argv, timeMs, 500);
+	filter = "";
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--filter")
+			filter = argv[i + 1];
+	}
+	if (help) {
+		printUsage(argv[0]);
+		return 0;
+	}
+	minTime = timeMs / 1000.0;
+
+	randomx::Cpu cpu;
+	const bool hardAes = HAVE_AES && cpu.hasAes();
+	const bool vaes = hardAes && aesVaesCompiled() && cpu.hasVaes();
+	const bool vperm = aesVpermCompiled();
+
+	alignas(64) uint8_t state[64] = { 1, 2, 3, 4 };
+	alignas(64) uint64_t hash[8] = {};
+	std::vector<uint8_t> scratchpadMemory(randomx::ScratchpadSize + 64);
+	uint8_t* scratchpad = (uint8_t*)(((uintptr_t)scratchpadMemory.data() + 63) & ~(uintptr_t)63);
+	alignas(64) randomx::Program program;
+	std::vector<Kernel> kernels;
+
+	//AES generators and hash of the scratchpad (AesGenerator1R, AesGenerator4R, AesHash1R)
+	kernels.push_back({ "fillAes1Rx4 (soft)", randomx::ScratchpadSize, [&]() { fillAes1Rx4<true>(state, randomx::ScratchpadSize, scratchpad); } });
+	if (vperm)
+		kernels.push_back({ "fillAes1Rx4 (vperm)", randomx::ScratchpadSize, [&]() { fillAes1Rx4Vperm(state, randomx::ScratchpadSize, scratchpad); } });
+	if (hardAes)
+		kernels.push_back({ "fillAes1Rx4 (hard)", randomx::ScratchpadSize, [&]() { fillAes1Rx4<false>(state, randomx::ScratchpadSize, scratchpad); } });
+	if (vaes)
+		kernels.push_back({ "fillAes1Rx4 (VAES)", randomx::ScratchpadSize, [&]() { fillAes1Rx4Vaes(state, randomx::ScratchpadSize, scratchpad); } });
+	kernels.push_back({ "hashAes1Rx4 (soft)", randomx::ScratchpadSize, [&]() { hashAes1Rx4<true>(scratchpad, randomx::ScratchpadSize, hash); } });
+	if (vperm)
+		kernels.push_back({ "hashAes1Rx4 (vperm)", randomx::ScratchpadSize, [&]() { hashAes1Rx4Vperm(scratchpad, randomx::ScratchpadSize, hash); } });
+	if (hardAes)
+		kernels.push_back({ "hashAes1Rx4 (hard)", randomx::ScratchpadSize, [&]() { hashAes1Rx4<false>(scratchpad, randomx::ScratchpadSize, hash); } });
+	if (vaes)
+		kernels.push_back({ "hashAes1Rx4 (VAES)", randomx::ScratchpadSize, [&]() { hashAes1Rx4Vaes(scratchpad, randomx::ScratchpadSize, hash); } });
+	kernels.push_back({ "hashAndFillAes1Rx4 (soft)", randomx::ScratchpadSize, [&]() { hashAndFillAes1Rx4<true>(scratchpad, randomx::ScratchpadSize, hash, state); } });
+	if (vperm)
+		kernels.push_back({ "hashAndFillAes1Rx4 (vperm)", randomx::ScratchpadSize, [&]() { hashAndFillAes1Rx4Vperm(scratchpad, randomx::ScratchpadSize, hash, state); } });
+	if (hardAes)
+		kernels.push_back({ "hashAndFillAes1Rx4 (hard)", randomx::ScratchpadSize, [&]() { hashAndFillAes1Rx4<false>(scratchpad, randomx::ScratchpadSize, hash, state); } });
+	if (vaes)
+		kernels.push_back({ "hashAndFillAes1Rx4 (VAES)", randomx::ScratchpadSize, [&]() { hashAndFillAes1Rx4Vaes(scratchpad, randomx::ScratchpadSize, hash, state); } });
+	kernels.push_back({ "fillAes4Rx4 (soft)", sizeof(program), [&]() { fillAes4Rx4<true>(state, sizeof(program), &program); } });
+	if (hardAes)
+		kernels.push_back({ "fillAes4Rx4 (hard)", sizeof(program), [&]() { fillAes4Rx4<false>(state, sizeof(program), &program); } });
+
+	//Blake2b of a block header, of the register file and of a 64-byte seed
+	uint8_t input[256] = { 5 };
+	kernels.push_back({ "blake2b (76 bytes)", 76, [&]() { blake2b(hash, sizeof(hash), input, 76, nullptr, 0); } });
+	kernels.push_back({ "blake2b (256 bytes)", 256, [&]() { blake2b(hash, sizeof(hash), input, 256, nullptr, 0); } });
+
+	//Argon2d fill of the cache with each implementation supported by the build and the CPU
+	struct ArgonImpl {
+		const char* name;
+		randomx_argon2_impl* impl;
+	};
+	std::vector<ArgonImpl> argonImpls = { { "reference", &randomx_argon2_fill_segment_ref } };
+	if (randomx_argon2_impl_ssse3() != nullptr && cpu.hasSsse3())
+		argonImpls.push_back({ "SSSE3", randomx_argon2_impl_ssse3() });
+	if (randomx_argon2_impl_avx2() != nullptr && cpu.hasAvx2())
+		argonImpls.push_back({ "AVX2", randomx_argon2_impl_avx2() });
+	if (randomx_argon2_impl_avx512() != nullptr && cpu.hasAvx512f())
+		argonImpls.push_back({ "AVX-512", randomx_argon2_impl_avx512() });
+	if (randomx_argon2_impl_neon() != nullptr)
+		argonImpls.push_back({ "NEON", randomx_argon2_impl_neon() });
+	auto argonName = [](const ArgonImpl& argon) {
+		return std::string("randomx_argon2_fill_memory_blocks (") + argon.name + ")";
+	};
+	//the memory is only allocated if one of the kernels is selected
+	bool argonSelected = false;
+	for (auto& argon : argonImpls)
+		argonSelected = argonSelected || isSelected(argonName(argon));
+	uint8_t* cacheMemory = nullptr;
+	argon2_instance_t instance = {};
+	if (argonSelected) {
+		if (largePages)
+			cacheMemory = (uint8_t*)randomx::LargePageAllocator::allocMemory(randomx::CacheSize);
+		else
+			cacheMemory = (uint8_t*)randomx::CacheAllocator::allocMemory(randomx::CacheSize);
+		instance.version = ARGON2_VERSION_NUMBER;
+		instance.memory = (block*)cacheMemory;
+		instance.passes = RANDOMX_ARGON_ITERATIONS;
+		instance.memory_blocks = RANDOMX_ARGON_MEMORY;
+		instance.segment_length = RANDOMX_ARGON_MEMORY / (RANDOMX_ARGON_LANES * ARGON2_SYNC_POINTS);
+		instance.lane_length = instance.segment_length * ARGON2_SYNC_POINTS;
+		instance.lanes = RANDOMX_ARGON_LANES;
+		instance.threads = 1;
+		instance.type = Argon2_d;
+		if (cacheMemory != nullptr)
+			memset(cacheMemory, 0, randomx::CacheSize);
+	}
+	for (auto& argon : argonImpls) {
+		if (cacheMemory == nullptr)
+			break;
+		kernels.push_back({ argonName(argon), randomx::CacheSize, [&instance, argon]() {
+			instance.impl = argon.impl;
+			randomx_argon2_fill_memory_blocks(&instance);
+		} });
+	}
+
+	//SuperscalarHash program generation and interpretation
+	randomx::Blake2Generator gen(state, sizeof(state));
+	randomx::SuperscalarProgram superscalar;
+	kernels.push_back({ "generateSuperscalar", 0, [&]() { randomx::generateSuperscalar(superscalar, gen); } });
+	std::vector<uint64_t> reciprocals;
+	randomx::SuperscalarProgram superscalarExec;
+	randomx::generateSuperscalar(superscalarExec, gen);
+	uint64_t registers[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	kernels.push_back({ "executeSuperscalar", 0, [&]() { randomx::executeSuperscalar(registers, superscalarExec); } });
+	//the same program for a group of register files with each variant supported by the build and the CPU
+	randomx::SuperscalarProgram groupProgram = superscalarExec;
+	for (unsigned j = 0; j < groupProgram.getSize(); ++j) {
+		auto& instr = groupProgram(j);
+		if ((randomx::SuperscalarInstructionType)instr.opcode == randomx::SuperscalarInstructionType::IMUL_RCP) {
+			reciprocals.push_back(randomx_reciprocal(instr.getImm32()));
+			instr.setImm32(reciprocals.size() - 1);
+		}
+	}
+	std::vector<randomx::SuperscalarByteCode> superscalarBytecode;
+	randomx::compileSuperscalar(groupProgram, reciprocals, superscalarBytecode);
+	struct GroupImpl {
+		const char* name;
+		randomx::SuperscalarGroupFunc* func;
+	};
+	std::vector<GroupImpl> groupImpls = { { "portable", randomx::superscalarGroupPortable() } };
+	if (randomx::superscalarGroupAvx2() != nullptr && cpu.hasAvx2())
+		groupImpls.push_back({ "AVX2", randomx::superscalarGroupAvx2() });
+	if (randomx::superscalarGroupAvx512() != nullptr && cpu.hasAvx512f() && cpu.hasAvx512dq())
+		groupImpls.push_back({ "AVX-512", randomx::superscalarGroupAvx512() });
+	static uint64_t groupRegisters[8][randomx::SuperscalarGroupSize];
+	for (auto& group : groupImpls) {
+		kernels.push_back({ std::string("executeSuperscalarBytecodeGroup (") + group.name + ")", 0, [&superscalarBytecode, group]() {
+			group.func(groupRegisters, superscalarBytecode.data());
+		} });
+	}
+
+#if RANDOMX_HAVE_COMPILER
+	//compilation of a RandomX program to machine code
+	randomx::JitCompiler jit;
+	jit.enableAll();
+	//programs and configurations are generated up front so that only the compiler is measured
+	const int programCount = 16;
+	std::vector<randomx::Program> programs(programCount);
+	std::vector<randomx::ProgramConfiguration> configs(programCount);
+	for (int i = 0; i < programCount; ++i) {
+		fillAes4Rx4<true>(state, sizeof(randomx::Program), &programs[i]);
+		auto addressRegisters = programs[i].getEntropy(12);
+		configs[i].readReg0 = 0 + (addressRegisters & 1);
+		addressRegisters >>= 1;
+		configs[i].readReg1 = 2 + (addressRegisters & 1);
+		addressRegisters >>= 1;
+		configs[i].readReg2 = 4 + (addressRegisters & 1);
+		addressRegisters >>= 1;
+		configs[i].readReg3 = 6 + (addressRegisters & 1);
+	}
+	int programIndex = 0;
+	kernels.push_back({ "JitCompiler::generateProgram", 0, [&]() {
+		jit.generateProgram(programs[programIndex], configs[programIndex]);
+		programIndex = (programIndex + 1) % programCount;
+	} });
+#endif
+
+	std::cout << "RandomX microbenchmark" << std::endl;
+	for (auto& kernel : kernels) {
+		measure(kernel);
+	}
+	if (cacheMemory != nullptr && largePages)
+		randomx::LargePageAllocator::freeMemory(cacheMemory, randomx::CacheSize);
+	else if (cacheMemory != nullptr)
+		randomx::CacheAllocator::freeMemory(cacheMemory, randomx::CacheSize);
+	return 0;
+}
@@ -73,9 +73,149 @@ bool has(randomx::Instruction& instr, uint32_t prop) {
 	return (instr.opcode & prop) != 0;
 }
 
+//Approximate microarchitecture parameters used by --predict. All of them can be overridden
+//on the command line, the built-in values are only a starting point.
+struct MachineProfile {
+	const char* name;
+	double frequency;       //sustained all-core clock in GHz
+	int executionPorts;
+	int memoryPorts;
+	int pipeline;           //branch misprediction penalty in cycles
+	int cores;              //cores per socket
+	int sockets;
+	double l2Size;          //MiB per core
+	double l3Size;          //MiB per socket
+	int l2Latency;          //cycles
+	int l3Latency;          //cycles
+	double dramLatency;     //ns
+	double dramBandwidth;   //GB/s per socket
+	double aesThroughput;   //128-bit AES rounds per cycle
+};
+
+static const MachineProfile profiles[] = {
+	{ "generic",       3.0, 4, 2, 14,  8, 1, 0.5,   16, 12, 40,  80,  40, 2 },
+	{ "zen2-server",   3.0, 4, 2, 16, 64, 1, 0.5,  256, 12, 39, 110, 150, 2 },
+	{ "zen3-server",   3.2, 4, 3, 16, 64, 1, 0.5,  256, 12, 46, 105, 170, 2 },
+	{ "zen4-server",   3.4, 4, 3, 16, 96, 1, 1.0,  384, 14, 50, 110, 400, 2 },
+	{ "skylake-sp",    2.5, 4, 2, 16, 28, 2, 1.0, 38.5, 14, 70,  90, 120, 1 },
+	{ "icelake-sp",    2.8, 4, 2, 17, 40, 2, 1.25,  60, 14, 80, 100, 200, 2 },
+};
+
+//number of loads and stores per iteration outside of the program: 8 dataset loads,
+//16 scratchpad loads and 16 scratchpad stores
+constexpr int LoopLoads = 24;
+constexpr int LoopStores = 16;
+constexpr double BlakeCyclesPerByte = 3.5;
+
+struct HashPrediction {
+	double iterationCycles;
+	double datasetStall;
+	double hashCycles;
+	double coreHashrate;
+	double socketHashrate;
+	double bandwidthLimit;
+};
+
+static HashPrediction predictHashrate(const MachineProfile& m, double programCycles) {
+	HashPrediction r;
+	const double scratchpadMiB = randomx::ScratchpadSize / 1048576.0;
+	const double dramCycles = m.dramLatency * m.frequency;
+	//latency of the two random scratchpad lines read at the start of each iteration
+	double scratchpadLatency;
+	bool scratchpadInDram = false;
+	if (m.l2Size >= scratchpadMiB)
+		scratchpadLatency = m.l2Latency;
+	else if (m.l3Size / m.cores >= scratchpadMiB)
+		scratchpadLatency = m.l3Latency;
+	else {
+		scratchpadLatency = dramCycles;
+		scratchpadInDram = true;
+	}
+	r.iterationCycles = programCycles + scratchpadLatency + (double)LoopLoads / m.memoryPorts + (double)LoopStores / m.memoryPorts;
+	//the dataset item is prefetched one iteration ahead
+	r.datasetStall = std::max(0.0, dramCycles - r.iterationCycles);
+	const double executeCycles = (double)RANDOMX_PROGRAM_COUNT * RANDOMX_PROGRAM_ITERATIONS * (r.iterationCycles + r.datasetStall);
+	//AesGenerator1R fill and AesHash1R use 4 rounds per 64 bytes each, AesGenerator4R 16 rounds per 64 bytes
+	const double aesRounds = 2.0 * 4 * randomx::ScratchpadSize / 64 + 16.0 * RANDOMX_PROGRAM_COUNT * sizeof(randomx::Program) / 64;
+	const double blakeCycles = BlakeCyclesPerByte * (RANDOMX_PROGRAM_COUNT + 1) * sizeof(randomx::RegisterFile);
+	r.hashCycles = executeCycles + aesRounds / m.aesThroughput + blakeCycles;
+	r.coreHashrate = m.frequency * 1e9 / r.hashCycles;
+	double bytesPerHash = 64.0 * RANDOMX_PROGRAM_COUNT * RANDOMX_PROGRAM_ITERATIONS;
+	if (scratchpadInDram) {
+		//the fill, the final hash and the reads and writes of every iteration
+		bytesPerHash += 2.0 * randomx::ScratchpadSize + 4.0 * 64 * RANDOMX_PROGRAM_COUNT * RANDOMX_PROGRAM_ITERATIONS;
+	}
+	r.bandwidthLimit = m.dramBandwidth * 1e9 / bytesPerHash;
+	r.socketHashrate = std::min(r.coreHashrate * m.cores, r.bandwidthLimit);
+	return r;
+}
+
+static void readProfileOptions(int argc, char** argv, MachineProfile& m) {
+	readFloatOption("--frequency", argc, argv, m.frequency, m.frequency);
+	readIntOption("--executionPorts", argc, argv, m.executionPorts, m.executionPorts);
+	readIntOption("--memoryPorts", argc, argv, m.memoryPorts, m.memoryPorts);
+	readIntOption("--pipeline", argc, argv, m.pipeline, m.pipeline);
+	readIntOption("--cores", argc, argv, m.cores, m.cores);
+	readIntOption("--sockets", argc, argv, m.sockets, m.sockets);
+	readFloatOption("--l2Size", argc, argv, m.l2Size, m.l2Size);
+	readFloatOption("--l3Size", argc, argv, m.l3Size, m.l3Size);
+	readIntOption("--l2Latency", argc, argv, m.l2Latency, m.l2Latency);
+	readIntOption("--l3Latency", argc, argv, m.l3Latency, m.l3Latency);
+	readFloatOption("--dramLatency", argc, argv, m.dramLatency, m.dramLatency);
+	readFloatOption("--dramBandwidth", argc, argv, m.dramBandwidth, m.dramBandwidth);
+	readFloatOption("--aesThroughput", argc, argv, m.aesThroughput, m.aesThroughput);
+}
+
+static int predict(int argc, char** argv, int nonces, int seed, bool reorder, bool speculate) {
+	const char* profileName = "all";
+	for (int i = 0; i < argc - 1; ++i) {
+		if (strcmp(argv[i], "--profile") == 0)
+			profileName = argv[i + 1];
+	}
+	bool all = strcmp(profileName, "all") == 0, found = all;
+	for (auto& profile : profiles) {
+		found = found || strcmp(profileName, profile.name) == 0;
+	}
+	if (!found) {
+		std::cout << "Unknown profile " << profileName << ", available:";
+		for (auto& profile : profiles)
+			std::cout << " " << profile.name;
+		std::cout << std::endl;
+		return 1;
+	}
+	std::cout << std::left << std::setw(14) << "profile" << std::right << std::setw(10) << "prog cyc" << std::setw(10) << "iter cyc";
+	std::cout << std::setw(10) << "DS stall" << std::setw(12) << "hash cyc" << std::setw(10) << "H/s core";
+	std::cout << std::setw(12) << "H/s socket" << std::setw(12) << "BW limit" << std::setw(12) << "H/s total" << std::endl;
+	for (auto& profile : profiles) {
+		if (!all && strcmp(profileName, profile.name) != 0)
+			continue;
+		MachineProfile m = profile;
+		readProfileOptions(argc, argv, m);
+		randomx::Program p, original;
+		double programCycles = 0.0;
+		for (int i = 0; i < nonces; ++i) {
+			generate(original, i ^ seed);
+			memcpy(&p, &original, sizeof(p));
+			analyze(p);
+			programCycles += reorder
+				? executeOutOfOrder(p, original, false, m.executionPorts, m.memoryPorts, speculate, m.pipeline)
+				: executeInOrder(p, original, false, m.executionPorts, m.memoryPorts, speculate, m.pipeline);
+		}
+		programCycles /= nonces;
+		HashPrediction r = predictHashrate(m, programCycles);
+		std::cout << std::left << std::setw(14) << m.name << std::right << std::fixed << std::setprecision(1);
+		std::cout << std::setw(10) << programCycles << std::setw(10) << r.iterationCycles << std::setw(10) << r.datasetStall;
+		std::cout << std::setprecision(0) << std::setw(12) << r.hashCycles << std::setw(10) << r.coreHashrate;
+		std::cout << std::setw(12) << r.socketHashrate << std::setw(12) << r.bandwidthLimit << std::setw(12) << r.socketHashrate * m.sockets << std::endl;
+		std::cout.copyfmt(std::ios(nullptr));
+	}
+	return 0;
+}
+
 int main(int argc, char** argv) {
 	int nonces, seed, executionPorts, memoryPorts, pipeline;
-	bool print, reorder, speculate;
+	bool print, reorder, speculate, prediction;
+	readOption("--predict", argc, argv, prediction);
 	readOption("--print", argc, argv, print);
 	readOption("--reorder", argc, argv, reorder);
 	readOption("--speculate", argc, argv, speculate);
@@ -84,6 +224,14 @@ int main(int argc, char** argv) {
 	readIntOption("--executionPorts", argc, argv, executionPorts, 4);
 	readIntOption("--memoryPorts", argc, argv, memoryPorts, 2);
 	readIntOption("--pipeline", argc, argv, pipeline, 3);
+	if (prediction) {
+		//modern server cores execute out of order with branch prediction
+		readIntOption("--nonces", argc, argv, nonces, 100);
+		bool inOrder, noSpeculate;
+		readOption("--inOrder", argc, argv, inOrder);
+		readOption("--noSpeculate", argc, argv, noSpeculate);
+		return predict(argc, argv, nonces, seed, !inOrder, !noSpeculate);
+	}
 	randomx::Program p, original;
 	double totalCycles = 0.0;
 	double jumpCount = 0;
@@ -0,0 +1,287 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//Performance regression test: runs fixed workloads, compares the throughput with
+//a baseline file recorded earlier on the same host and fails on regressions.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include "stopwatch.hpp"
+#include "utility.hpp"
+#include "../randomx.h"
+
+struct Workload {
+	std::string name;
+	std::function<uint64_t()> run; //returns the number of operations performed
+	bool fullMem;
+};
+
+struct BaselineEntry {
+	double opsPerSec;
+	double tolerance; //negative if the default tolerance applies
+};
+
+static randomx_flags clearFlags(randomx_flags flags, int mask) {
+	return (randomx_flags)(flags & ~mask);
+}
+
+static double minTime;
+static int repeatCount;
+
+//runs the workload repeatCount times for at least minTime seconds each (after one
+//warmup call) and returns the median throughput
+static double measure(const Workload& workload) {
+	workload.run();
+	std::vector<double> samples;
+	for (int i = 0; i < repeatCount; ++i) {
+		uint64_t ops = 0;
+		Stopwatch sw(true);
+		double elapsed;
+		do {
+			ops += workload.run();
+			elapsed = sw.getElapsed();
+		} while (elapsed < minTime);
+		samples.push_back(ops / elapsed);
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+//baseline format: one workload per line, "name<TAB>ops/s[<TAB>tolerance %]", '#' starts a comment
+static bool readBaseline(const char* path, std::map<std::string, BaselineEntry>& baseline) {
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+		std::istringstream fields(line);
+		std::string name, value, tolerance;
+		if (!std::getline(fields, name, '\t') || !std::getline(fields, value, '\t'))
+			continue;
+		BaselineEntry entry = { atof(value.c_str()), -1.0 };
+		if (std::getline(fields, tolerance, '\t'))
+			entry.tolerance = atof(tolerance.c_str());
+		baseline[name] = entry;
+	}
+	return true;
+}
+
+static bool writeBaseline(const char* path, const std::vector<std::pair<std::string, double>>& results, const std::map<std::string, BaselineEntry>& baseline) {
+	std::ofstream file(path);
+	if (!file.is_open())
+		return false;
+	file << "# randomx-perf-tests baseline (only valid for the host it was recorded on)" << std::endl;
+	file << "# name<TAB>ops/s[<TAB>tolerance %]" << std::endl;
+	file << std::fixed << std::setprecision(3);
+	for (auto& result : results) {
+		file << result.first << '\t' << result.second;
+		auto it = baseline.find(result.first);
+		if (it != baseline.end() && it->second.tolerance >= 0)
+			file << '\t' << it->second.tolerance;
+		file << std::endl;
+	}
+	return file.good();
+}
+
+static void printUsage(const char* executable) {
+	std::cout << "Usage: " << executable << " [OPTIONS]" << std::endl;
+	std::cout << "Supported options:" << std::endl;
+	std::cout << "  --help          shows this message" << std::endl;
+	std::cout << "  --baseline F    compare the results with the baseline file F" << std::endl;
+	std::cout << "  --save F        write the results to the baseline file F (keeps the tolerances of --baseline)" << std::endl;
+	std::cout << "  --tolerance P   allowed slowdown in percent for workloads without their own tolerance (default: 5)" << std::endl;
+	std::cout << "  --time T        run each sample for at least T milliseconds (default: 1000)" << std::endl;
+	std::cout << "  --repeat N      number of samples per workload, the median is used (default: 5)" << std::endl;
+	std::cout << "  --filter S      only run workloads whose name contains S" << std::endl;
+	std::cout << "  --noFull        skip the workloads that need the full dataset" << std::endl;
+	std::cout << "Exit status: 0 if no workload is slower than its baseline, 1 on regressions, 2 on errors." << std::endl;
+}
+
+int main(int argc, char** argv) {
+	bool help, noFull;
+	int timeMs;
+	double defaultTolerance;
+	readOption("--help", argc, argv, help);
+	readOption("--noFull", argc, argv, noFull);
+	readIntOption("--time", argc, argv, timeMs, 1000);
+	readIntOption("--repeat", argc, argv, repeatCount, 5);
+	readFloatOption("--tolerance", argc, argv, defaultTolerance, 5.0);
+	const char* baselinePath = readStringOption("--baseline", argc, argv);
+	const char* savePath = readStringOption("--save", argc, argv);
+	const char* filterOption = readStringOption("--filter", argc, argv);
+	const std::string filter = filterOption != nullptr ? filterOption : "";
+	if (help) {
+		printUsage(argv[0]);
+		return 0;
+	}
+	minTime = timeMs / 1000.0;
+
+	std::map<std::string, BaselineEntry> baseline;
+	if (baselinePath != nullptr && !readBaseline(baselinePath, baseline)) {
+		std::cerr << "Cannot read the baseline file " << baselinePath << std::endl;
+		return 2;
+	}
+
+	const char key[] = "RandomX performance test key";
+	const randomx_flags flags = randomx_get_flags();
+	const randomx_flags cacheFlags = clearFlags(flags, RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_SECURE);
+	const int softAes = RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_VAES | RANDOMX_FLAG_AES_VPERM;
+	randomx_cache* cache = randomx_alloc_cache(cacheFlags);
+	randomx_cache* interpretedCache = randomx_alloc_cache(clearFlags(cacheFlags, RANDOMX_FLAG_JIT));
+	randomx_cache* initCache = randomx_alloc_cache(cacheFlags);
+	randomx_dataset* dataset = noFull ? nullptr : randomx_alloc_dataset(flags);
+	if (cache == nullptr || interpretedCache == nullptr || initCache == nullptr || (!noFull && dataset == nullptr)) {
+		std::cerr << "Memory allocation failed" << std::endl;
+		return 2;
+	}
+	randomx_init_cache(cache, key, sizeof(key) - 1);
+	randomx_init_cache(interpretedCache, key, sizeof(key) - 1);
+
+	std::vector<randomx_vm*> machines;
+	std::vector<Workload> workloads;
+	uint8_t input[76] = { 0x07, 0x07, 0xf7, 0xa4 };
+	uint8_t hash[RANDOMX_HASH_SIZE];
+	uint32_t nonce = 0;
+
+	//the key alternates because randomx_init_cache skips the initialization for an unchanged key
+	workloads.push_back({ "cache init", [&]() {
+		const char initKey[] = { 'k', (char)(nonce++ & 1) };
+		randomx_init_cache(initCache, initKey, sizeof(initKey));
+		return 1;
+	}, false });
+	if (dataset != nullptr) {
+		workloads.push_back({ "dataset init (1 thread, items)", [&]() {
+			const unsigned long items = 16384;
+			randomx_init_dataset(dataset, cache, 0, items);
+			return items;
+		}, false });
+	}
+
+	struct VmKind {
+		const char* name;
+		randomx_flags flags;
+	};
+	const VmKind kinds[] = {
+		{ "hash (interpreted, light)", clearFlags(flags, RANDOMX_FLAG_JIT | RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_SECURE) },
+		{ "hash (compiled, light)", clearFlags(flags | RANDOMX_FLAG_JIT, RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_SECURE) },
+		{ "hash (interpreted, full)", clearFlags(flags | RANDOMX_FLAG_FULL_MEM, RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE) },
+		{ "hash (compiled, full)", clearFlags(flags | RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT, RANDOMX_FLAG_SECURE) },
+		{ "hash (compiled, full, secure)", flags | RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE },
+		{ "hash (compiled, full, soft AES)", clearFlags(flags | RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT, RANDOMX_FLAG_SECURE | softAes) },
+	};
+	for (auto& kind : kinds) {
+		const bool fullMem = (kind.flags & RANDOMX_FLAG_FULL_MEM) != 0;
+		if (fullMem && dataset == nullptr)
+			continue;
+		if (!filter.empty() && std::string(kind.name).find(filter) == std::string::npos)
+			continue;
+		randomx_cache* vmCache = (kind.flags & RANDOMX_FLAG_JIT) ? cache : interpretedCache;
+		randomx_vm* vm = randomx_create_vm(kind.flags, fullMem ? nullptr : vmCache, dataset);
+		if (vm == nullptr) {
+			std::cout << std::left << std::setw(40) << kind.name << " not supported" << std::endl;
+			continue;
+		}
+		machines.push_back(vm);
+		const uint64_t batch = (kind.flags & RANDOMX_FLAG_FULL_MEM) ? 16 : 1;
+		workloads.push_back({ kind.name, [&input, &hash, &nonce, vm, batch]() {
+			for (uint64_t i = 0; i < batch; ++i) {
+				memcpy(input + 39, &nonce, sizeof(nonce));
+				nonce++;
+				randomx_calculate_hash(vm, input, sizeof(input), hash);
+			}
+			return batch;
+		}, fullMem });
+	}
+	workloads.push_back({ "commitment", [&]() {
+		const uint64_t batch = 256;
+		for (uint64_t i = 0; i < batch; ++i) {
+			memcpy(input + 39, &nonce, sizeof(nonce));
+			nonce++;
+			randomx_calculate_commitment(input, sizeof(input), hash, hash);
+		}
+		return batch;
+	}, false });
+
+	std::vector<std::pair<std::string, double>> results;
+	bool datasetReady = false;
+	int regressions = 0;
+	for (auto& workload : workloads) {
+		if (!filter.empty() && workload.name.find(filter) == std::string::npos)
+			continue;
+		if (workload.fullMem && !datasetReady) {
+			randomx_init_dataset_parallel(dataset, cache, 0, 0);
+			datasetReady = true;
+		}
+		double opsPerSec = measure(workload);
+		results.push_back(std::make_pair(workload.name, opsPerSec));
+		std::cout << std::left << std::setw(40) << workload.name << std::right << std::fixed;
+		std::cout << std::setw(14) << std::setprecision(3) << opsPerSec << " ops/s";
+		auto it = baseline.find(workload.name);
+		if (it != baseline.end() && it->second.opsPerSec > 0) {
+			double tolerance = it->second.tolerance >= 0 ? it->second.tolerance : defaultTolerance;
+			double change = (opsPerSec / it->second.opsPerSec - 1.0) * 100.0;
+			std::cout << std::showpos << std::setw(10) << std::setprecision(1) << change << "%" << std::noshowpos;
+			if (change < -tolerance) {
+				std::cout << "  REGRESSION (tolerance " << std::setprecision(1) << tolerance << "%)";
+				regressions++;
+			}
+		}
+		else if (baselinePath != nullptr) {
+			std::cout << "  (no baseline)";
+		}
+		std::cout << std::endl;
+		std::cout.copyfmt(std::ios(nullptr));
+	}
+
+	for (auto vm : machines)
+		randomx_destroy_vm(vm);
+	if (dataset != nullptr)
+		randomx_release_dataset(dataset);
+	randomx_release_cache(interpretedCache);
+	randomx_release_cache(initCache);
+	randomx_release_cache(cache);
+
+	if (savePath != nullptr && !writeBaseline(savePath, results, baseline)) {
+		std::cerr << "Cannot write the baseline file " << savePath << std::endl;
+		return 2;
+	}
+	if (regressions > 0) {
+		std::cout << regressions << " workload(s) slower than the baseline" << std::endl;
+		return 1;
+	}
+	return 0;
+}
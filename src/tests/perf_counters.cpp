@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "perf_counters.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#elif defined(_WIN32)
+#include <windows.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+const char* PerfCounters::eventName(int event) {
+	static const char* names[EventCount] = {
+		"cycles", "instructions", "L1D misses", "LLC reads", "LLC misses", "dTLB misses", "branch misses"
+	};
+	return names[event];
+}
+
+#if defined(__linux__)
+
+#define CACHE_EVENT(cache, op, result) \
+	(PERF_COUNT_HW_CACHE_##cache | (PERF_COUNT_HW_CACHE_OP_##op << 8) | (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+static int openEvent(uint32_t type, uint64_t config) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = type;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters() {
+	//there is no generic L2 miss event; the LLC read accesses are counted instead (the reads that missed L2)
+	fds[Cycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	fds[Instructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	fds[L1dMisses] = openEvent(PERF_TYPE_HW_CACHE, CACHE_EVENT(L1D, READ, MISS));
+	fds[LlcReads] = openEvent(PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, ACCESS));
+	fds[LlcMisses] = openEvent(PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, MISS));
+	fds[DtlbMisses] = openEvent(PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, READ, MISS));
+	fds[BranchMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	for (int i = 0; i < EventCount; ++i) {
+		available[i] = fds[i] >= 0;
+		values[i] = 0;
+	}
+}
+
+PerfCounters::~PerfCounters() {
+	for (int i = 0; i < EventCount; ++i) {
+		if (fds[i] >= 0)
+			close(fds[i]);
+	}
+}
+
+void PerfCounters::start() {
+	for (int i = 0; i < EventCount; ++i) {
+		if (fds[i] >= 0) {
+			ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void PerfCounters::stop() {
+	for (int i = 0; i < EventCount; ++i) {
+		if (fds[i] < 0)
+			continue;
+		ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t data[3]; //value, time enabled, time running
+		if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+			available[i] = false;
+			continue;
+		}
+		//scale the value if the counter was multiplexed with other events
+		values[i] = data[2] < data[1] ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+	}
+}
+
+#else
+
+static bool readCycles(uint64_t& cycles) {
+#if defined(_WIN32)
+	ULONG64 value;
+	if (!QueryThreadCycleTime(GetCurrentThread(), &value))
+		return false;
+	cycles = value;
+	return true;
+#elif defined(__x86_64__) || defined(__i386__)
+	cycles = __rdtsc();
+	return true;
+#else
+	return false;
+#endif
+}
+
+PerfCounters::PerfCounters() : startCycles(0) {
+	for (int i = 0; i < EventCount; ++i) {
+		available[i] = false;
+		values[i] = 0;
+	}
+	available[Cycles] = readCycles(startCycles);
+}
+
+PerfCounters::~PerfCounters() {
+}
+
+void PerfCounters::start() {
+	readCycles(startCycles);
+}
+
+void PerfCounters::stop() {
+	uint64_t cycles;
+	if (available[Cycles] && readCycles(cycles)) {
+		values[Cycles] = cycles - startCycles;
+	}
+}
+
+#endif
+
+PerfTotals::PerfTotals() {
+	for (int i = 0; i < PerfCounters::EventCount; ++i) {
+		available[i].store(true);
+		values[i].store(0);
+	}
+}
+
+void PerfTotals::add(const PerfCounters& counters) {
+	for (int i = 0; i < PerfCounters::EventCount; ++i) {
+		if (counters.isAvailable(i))
+			values[i].fetch_add(counters.getValue(i));
+		else
+			available[i].store(false);
+	}
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+//Hardware performance counters of the calling thread. On Linux, perf_event counters are used.
+//On other systems, only cycles are available (if supported).
+class PerfCounters {
+public:
+	enum Event {
+		Cycles,
+		Instructions,
+		L1dMisses,
+		LlcReads,
+		LlcMisses,
+		DtlbMisses,
+		BranchMisses,
+		EventCount
+	};
+	static const char* eventName(int event);
+	PerfCounters();
+	~PerfCounters();
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	void start();
+	void stop();
+	bool isAvailable(int event) const {
+		return available[event];
+	}
+	uint64_t getValue(int event) const {
+		return values[event];
+	}
+private:
+	bool available[EventCount];
+	uint64_t values[EventCount];
+#if defined(__linux__)
+	int fds[EventCount];
+#else
+	uint64_t startCycles;
+#endif
+};
+
+//sums the counters of several threads
+class PerfTotals {
+public:
+	PerfTotals();
+	void add(const PerfCounters& counters);
+	bool isAvailable(int event) const {
+		return available[event].load();
+	}
+	uint64_t getValue(int event) const {
+		return values[event].load();
+	}
+private:
+	std::atomic<bool> available[PerfCounters::EventCount];
+	std::atomic<uint64_t> values[PerfCounters::EventCount];
+};
@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include "../program.hpp"
+#include "../bytecode_machine.hpp"
+
+//Composition of a RandomX program that affects its execution time
+struct ProgramFeatures {
+	int branches;   //CBRANCH
+	int fdiv;       //FDIV_M
+	int fsqrt;      //FSQRT_R
+	int l3Accesses; //loads and stores addressing the whole scratchpad
+
+	void add(const ProgramFeatures& other) {
+		branches += other.branches;
+		fdiv += other.fdiv;
+		fsqrt += other.fsqrt;
+		l3Accesses += other.l3Accesses;
+	}
+};
+
+inline ProgramFeatures getProgramFeatures(randomx::Program& program) {
+	using namespace randomx;
+	ProgramFeatures features = { 0, 0, 0, 0 };
+	for (unsigned i = 0; i < program.getSize(); ++i) {
+		Instruction& instr = program(i);
+		const int opcode = instr.opcode;
+		const bool sameReg = instr.src % RegistersCount == instr.dst % RegistersCount;
+		bool integerLoad = (opcode >= ceil_IADD_RS && opcode < ceil_IADD_M)
+			|| (opcode >= ceil_ISUB_R && opcode < ceil_ISUB_M)
+			|| (opcode >= ceil_IMUL_R && opcode < ceil_IMUL_M)
+			|| (opcode >= ceil_IMULH_R && opcode < ceil_IMULH_M)
+			|| (opcode >= ceil_ISMULH_R && opcode < ceil_ISMULH_M)
+			|| (opcode >= ceil_IXOR_R && opcode < ceil_IXOR_M);
+		if (integerLoad && sameReg)
+			features.l3Accesses++;
+		else if (opcode >= ceil_FMUL_R && opcode < ceil_FDIV_M)
+			features.fdiv++;
+		else if (opcode >= ceil_FDIV_M && opcode < ceil_FSQRT_R)
+			features.fsqrt++;
+		else if (opcode >= ceil_FSQRT_R && opcode < ceil_CBRANCH)
+			features.branches++;
+		else if (opcode >= ceil_CFROUND && opcode < ceil_ISTORE && instr.getModCond() >= StoreL3Condition)
+			features.l3Accesses++;
+	}
+	return features;
+}
+
+//Writes a CSV trace with one line per program and one per hash (program -1)
+//with the execution time in nanoseconds and the program features (summed for a hash).
+class ProgramTrace {
+public:
+	bool open(const char* path) {
+		file.open(path);
+		if (!file.is_open())
+			return false;
+		file << "hash,program,time_ns,branches,fdiv,fsqrt,l3_accesses" << std::endl;
+		return true;
+	}
+	bool isOpen() const {
+		return file.is_open();
+	}
+	void recordProgram(uint64_t hash, int program, uint64_t ns, const ProgramFeatures& features) {
+		file << hash << ',' << program << ',' << ns << ',' << features.branches << ',' << features.fdiv << ',';
+		file << features.fsqrt << ',' << features.l3Accesses << '\n';
+	}
+	void recordHash(uint64_t hash, uint64_t ns, const ProgramFeatures& features) {
+		recordProgram(hash, -1, ns, features);
+	}
+private:
+	std::ofstream file;
+};
@@ -0,0 +1,10 @@
+/* RISC-V - test if the V extension is present */
+
+.text
+.global main
+
+main:
+    vsetivli x0, 2, e64, m1, ta, ma
+    vfadd.vv v0, v0, v1
+    li x10, 0
+    ret
@@ -0,0 +1,10 @@
+/* RISC-V - test if the Zkne and Zknd extensions are present */
+
+.text
+.global main
+
+main:
+    aes64esm x6, x6, x7
+    aes64dsm x6, x6, x7
+    li x10, 0
+    ret
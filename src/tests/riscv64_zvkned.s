@@ -0,0 +1,10 @@
+/* RISC-V - test if the V and Zvkned extensions are present */
+
+.text
+.global main
+
+main:
+    vsetivli x0, 4, e32, m1, ta, ma
+    vaesem.vv v0, v1
+    li x10, 0
+    ret
@@ -5,6 +5,41 @@
 #include "../dataset.hpp"
 #include "../vm_compiled.hpp"
 #include "../blake2/blake2.h"
+#include "program_trace.hpp"
+
+static uint64_t elapsedNs(const Stopwatch& sw) {
+	return (uint64_t)(sw.getElapsed() * 1e9);
+}
+
+static ProgramFeatures currentProgramFeatures(randomx_vm* vm) {
+	randomx::Program program = vm->getProgram();
+	return getProgramFeatures(program);
+}
+
+//same as randomx_calculate_hash, but each program is timed and recorded in the trace
+static void calculateHashTraced(randomx_vm* vm, const void* input, size_t inputSize, void* output, uint64_t index, ProgramTrace& trace) {
+	alignas(16) uint64_t tempHash[8];
+	ProgramFeatures total = { 0, 0, 0, 0 };
+	Stopwatch hashTime(true);
+	blake2b(tempHash, sizeof(tempHash), input, inputSize, nullptr, 0);
+	vm->initScratchpad(&tempHash);
+	vm->resetRoundingMode();
+	for (int chain = 0; chain < RANDOMX_PROGRAM_COUNT; ++chain) {
+		Stopwatch programTime(true);
+		vm->run(&tempHash);
+		programTime.stop();
+		hashTime.stop();
+		ProgramFeatures features = currentProgramFeatures(vm);
+		trace.recordProgram(index, chain, elapsedNs(programTime), features);
+		total.add(features);
+		hashTime.start();
+		if (chain < RANDOMX_PROGRAM_COUNT - 1)
+			blake2b(tempHash, sizeof(tempHash), vm->getRegisterFile(), sizeof(randomx::RegisterFile), nullptr, 0);
+	}
+	vm->getFinalResult(output, RANDOMX_HASH_SIZE);
+	hashTime.stop();
+	trace.recordHash(index, elapsedNs(hashTime), total);
+}
 
 struct Outlier {
 	Outlier(int idx, double rtime) : index(idx), runtime(rtime) {}
@@ -39,6 +74,13 @@ int main(int argc, char** argv) {
 	readFloatOption("--offset", argc, argv, offset, 0);
 	readIntOption("--seed", argc, argv, seed, 0);
 	readOption("--largePages", argc, argv, largePages);
+	const char* tracePath = readStringOption("--trace", argc, argv);
+
+	ProgramTrace trace;
+	if (tracePath != nullptr && !trace.open(tracePath)) {
+		std::cout << "Cannot create the trace file " << tracePath << std::endl;
+		return 1;
+	}
 
 	if (!verify) {
 		flags = (randomx_flags)(flags | RANDOMX_FLAG_FULL_MEM);
@@ -50,6 +92,8 @@ int main(int argc, char** argv) {
 
 	std::cout << " - histogram offset: " << offset << std::endl;
 	std::cout << " - histogram bin size: " << binSize << std::endl;
+	if (tracePath != nullptr)
+		std::cout << " - trace: " << tracePath << std::endl;
 
 	if (jit) {
 		flags = (randomx_flags)(flags | RANDOMX_FLAG_JIT);
@@ -127,11 +171,15 @@ int main(int argc, char** argv) {
 
 	for (int i = 0; i < totalCount; ++i) {
 		sw.restart();
-		if (verify)
+		if (verify && trace.isOpen())
+			calculateHashTraced(vm, &i, sizeof i, &hash, i, trace);
+		else if (verify)
 			randomx_calculate_hash(vm, &i, sizeof i, &hash);
 		else
 			vm->run(&hash);
 		double elapsed = sw.getElapsed();
+		if (!verify && trace.isOpen())
+			trace.recordProgram(i, 0, (uint64_t)(elapsed * 1e9), currentProgramFeatures(vm));
 		//std::cout << "Elapsed: " << elapsed << std::endl;
 		totalRuntime += elapsed;
 		if (elapsed > maxRuntime)
@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "soak_monitor.hpp"
+#include <fstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+static int openEvent(uint32_t type, uint64_t config) {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = type;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static bool readEvent(int fd, uint64_t& value) {
+	return fd >= 0 && read(fd, &value, sizeof(value)) == sizeof(value);
+}
+#endif
+
+SoakThread::SoakThread() : hashes(0), stop(nullptr), cyclesFd(-1), clockFd(-1) {
+}
+
+SoakThread::~SoakThread() {
+#if defined(__linux__)
+	if (cyclesFd >= 0)
+		close(cyclesFd);
+	if (clockFd >= 0)
+		close(clockFd);
+#endif
+}
+
+void SoakThread::start(const std::atomic<bool>* stopFlag) {
+	stop = stopFlag;
+#if defined(__linux__)
+	cyclesFd = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	clockFd = openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+#endif
+}
+
+bool SoakThread::readClock(uint64_t& cycles, uint64_t& runningNs) const {
+#if defined(__linux__)
+	return readEvent(cyclesFd, cycles) && readEvent(clockFd, runningNs);
+#else
+	return false;
+#endif
+}
+
+template<typename T>
+static bool readValue(const std::string& path, T& value) {
+	std::ifstream file(path);
+	return (bool)(file >> value);
+}
+
+PackageSensors::PackageSensors() : energyRange(0) {
+#if defined(__linux__)
+	//package 0 of the Intel or AMD RAPL interface
+	const char* domains[] = { "/sys/class/powercap/intel-rapl:0/", "/sys/class/powercap/amd-rapl:0/" };
+	for (auto domain : domains) {
+		uint64_t energy;
+		if (readValue(std::string(domain) + "energy_uj", energy)) {
+			energyPath = std::string(domain) + "energy_uj";
+			readValue(std::string(domain) + "max_energy_range_uj", energyRange);
+			break;
+		}
+	}
+	//the package sensor if there is one, otherwise the first thermal zone
+	for (int zone = 0; zone < 64; ++zone) {
+		std::string base = "/sys/class/thermal/thermal_zone" + std::to_string(zone) + "/";
+		std::string type;
+		if (!readValue(base + "type", type))
+			break;
+		if (temperaturePath.empty() || type == "x86_pkg_temp") {
+			temperaturePath = base + "temp";
+			if (type == "x86_pkg_temp")
+				break;
+		}
+	}
+	//AMD CPUs report the temperature through the k10temp hwmon driver
+	for (int hwmon = 0; hwmon < 64 && temperaturePath.empty(); ++hwmon) {
+		std::string base = "/sys/class/hwmon/hwmon" + std::to_string(hwmon) + "/";
+		std::string name;
+		if (!readValue(base + "name", name))
+			break;
+		if (name == "k10temp" || name == "coretemp")
+			temperaturePath = base + "temp1_input";
+	}
+#endif
+}
+
+bool PackageSensors::readEnergy(uint64_t& microjoules) const {
+	return !energyPath.empty() && readValue(energyPath, microjoules);
+}
+
+bool PackageSensors::readTemperature(double& celsius) const {
+	int64_t millidegrees;
+	if (temperaturePath.empty() || !readValue(temperaturePath, millidegrees))
+		return false;
+	celsius = millidegrees / 1000.0;
+	return true;
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+//Hash count and clock of one benchmark thread, sampled by the soak monitor while the thread runs.
+//On Linux, the effective frequency is the number of core cycles divided by the time the thread
+//was running (perf_event); on other systems it's not available.
+class SoakThread {
+public:
+	SoakThread();
+	~SoakThread();
+	SoakThread(const SoakThread&) = delete;
+	SoakThread& operator=(const SoakThread&) = delete;
+	//opens the counters of the calling thread
+	void start(const std::atomic<bool>* stopFlag);
+	void addHashes(uint64_t count) {
+		hashes.fetch_add(count, std::memory_order_relaxed);
+	}
+	bool isStopped() const {
+		return stop->load(std::memory_order_relaxed);
+	}
+	uint64_t getHashes() const {
+		return hashes.load(std::memory_order_relaxed);
+	}
+	//cycles and running time in ns since start, false if not available
+	bool readClock(uint64_t& cycles, uint64_t& runningNs) const;
+private:
+	std::atomic<uint64_t> hashes;
+	const std::atomic<bool>* stop;
+	int cyclesFd, clockFd;
+	char padding[64];
+};
+
+//Package power and temperature where the OS exposes them
+//(Linux: powercap RAPL energy counter and thermal zones or hwmon sensors).
+class PackageSensors {
+public:
+	PackageSensors();
+	//cumulative energy in microjoules, false if not available
+	bool readEnergy(uint64_t& microjoules) const;
+	//range of the energy counter, it wraps around to 0
+	uint64_t getEnergyRange() const {
+		return energyRange;
+	}
+	//degrees Celsius, false if not available
+	bool readTemperature(double& celsius) const;
+private:
+	std::string energyPath;
+	std::string temperaturePath;
+	uint64_t energyRange;
+};
@@ -4,8 +4,57 @@
 #include <unordered_set>
 #include "../superscalar.hpp"
 #include "../common.hpp"
+#include "../reciprocal.h"
+#include "stopwatch.hpp"
+#include "utility.hpp"
 
-int main() {
+using GeneratorFunc = void(randomx::SuperscalarProgram&, randomx::Blake2Generator&);
+using ReciprocalFunc = uint64_t(uint32_t);
+
+//cache initialization work after the Argon2 fill: the programs and the reciprocals of IMUL_RCP
+template<GeneratorFunc generator, ReciprocalFunc reciprocal>
+static double generatePrograms(uint32_t keyCount, uint64_t& checksum) {
+	randomx::SuperscalarProgram prog;
+	Stopwatch sw(true);
+	for (uint32_t key = 0; key < keyCount; ++key) {
+		randomx::Blake2Generator gen(&key, sizeof(key));
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			generator(prog, gen);
+			for (unsigned j = 0; j < prog.getSize(); ++j) {
+				auto& instr = prog(j);
+				checksum += instr.opcode + instr.dst * 8 + instr.src;
+				if ((randomx::SuperscalarInstructionType)instr.opcode == randomx::SuperscalarInstructionType::IMUL_RCP) {
+					checksum ^= reciprocal(instr.getImm32());
+				}
+			}
+		}
+	}
+	sw.stop();
+	return sw.getElapsed() * 1000 / keyCount;
+}
+
+static int benchmarkGenerators(uint32_t keyCount) {
+	uint64_t checksumReference = 0, checksumFast = 0;
+	double msReference = generatePrograms<randomx::generateSuperscalarReference, randomx_reciprocal>(keyCount, checksumReference);
+	double msFast = generatePrograms<randomx::generateSuperscalar, randomx_reciprocal_fast>(keyCount, checksumFast);
+	std::cout << "Superscalar programs of " << keyCount << " keys" << std::endl;
+	std::cout << "Reference generator: " << msReference << " ms per key" << std::endl;
+	std::cout << "Fast generator:      " << msFast << " ms per key (" << msReference / msFast << "x)" << std::endl;
+	if (checksumReference != checksumFast) {
+		std::cout << "ERROR: the generators produced different programs" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	bool bench;
+	int keyCount;
+	readOption("--bench", argc, argv, bench);
+	readIntOption("--keys", argc, argv, keyCount, 100);
+	if (bench) {
+		return benchmarkGenerators(keyCount);
+	}
 	std::cout << "THIS PROGRAM REQUIRES MORE THAN 16 GB OF RAM TO COMPLETE" << std::endl;
 	std::vector<uint64_t> dummy;
 	constexpr uint64_t superscalarMul0 = 6364136223846793005ULL;
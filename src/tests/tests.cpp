@@ -3,10 +3,16 @@
 #endif
 
 #include <cassert>
+#include <cmath>
 #include <iomanip>
+#include <thread>
+#include <vector>
+#include <algorithm>
 #include "utility.hpp"
 #include "../bytecode_machine.hpp"
 #include "../dataset.hpp"
+#include "../scratchpad_arena.hpp"
+#include "../virtual_machine.hpp"
 #include "../blake2/endian.h"
 #include "../blake2/blake2.h"
 #include "../blake2_generator.hpp"
@@ -14,7 +20,14 @@
 #include "../reciprocal.h"
 #include "../intrin_portable.h"
 #include "../jit_compiler.hpp"
+#include "../hasher.hpp"
+#include "../program_scheduler.hpp"
 #include "../aes_hash.hpp"
+#include "../cpu.hpp"
+#include "../virtual_memory.h"
+#include "../thread_affinity.hpp"
+#include "../assembly_generator_x86.hpp"
+#include "../engine.hpp"
 
 randomx_cache* cache;
 randomx_vm* vm = nullptr;
@@ -51,6 +64,37 @@ void calcHexHash(const char(&key)[K], const char(&hex)[H], void* output) {
 	randomx_calculate_hash(vm, input, sizeof(input), output);
 }
 
+//dataset initialization backend that only uses the context, as an accelerator would (doc/specs.md 7.3)
+static int contextBackend(void* userData, const randomx_dataset_init_context* context, void* output, uint64_t startItem, uint64_t itemCount) {
+	const uint64_t mul0 = 6364136223846793005ULL;
+	const uint64_t add[8] = { 0, 9298411001130361340ULL, 12065312585734608966ULL, 9306329213124626780ULL,
+		5281919268842080866ULL, 10536153434571861004ULL, 3398623926847679864ULL, 9549104520008361294ULL };
+	const uint8_t* cacheMemory = (const uint8_t*)context->cacheMemory;
+	const uint64_t lineMask = context->cacheSize / RANDOMX_DATASET_ITEM_SIZE - 1;
+	for (uint64_t n = 0; n < itemCount; ++n) {
+		const uint64_t itemNumber = startItem + n;
+		uint64_t r[8];
+		r[0] = (itemNumber + 1) * mul0;
+		for (int q = 1; q < 8; ++q)
+			r[q] = r[0] ^ add[q];
+		uint64_t registerValue = itemNumber;
+		auto code = (const randomx::SuperscalarByteCode*)context->programs;
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			const uint8_t* mixBlock = cacheMemory + (registerValue & lineMask) * RANDOMX_DATASET_ITEM_SIZE;
+			code = randomx::executeSuperscalarBytecode(r, code);
+			assert(code->type == RANDOMX_SUPERSCALAR_END);
+			for (int q = 0; q < 8; ++q)
+				r[q] ^= load64(mixBlock + 8 * q);
+			registerValue = r[code->dst];
+			++code;
+		}
+		assert(code == (const randomx::SuperscalarByteCode*)context->programs + context->programsLength);
+		memcpy((uint8_t*)output + n * RANDOMX_DATASET_ITEM_SIZE, r, sizeof(r));
+	}
+	++*(int*)userData;
+	return 1;
+}
+
 int testNo = 0;
 int skipped = 0;
 
@@ -113,6 +157,114 @@ int main() {
 		}
 	});
 
+	runTest("SuperscalarHash reference generator", true, []() {
+		randomx::SuperscalarProgram fast, reference;
+		for (uint32_t k = 0; k < 16; ++k) {
+			randomx::Blake2Generator genFast(&k, sizeof(k));
+			randomx::Blake2Generator genReference(&k, sizeof(k));
+			for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+				randomx::generateSuperscalar(fast, genFast);
+				randomx::generateSuperscalarReference(reference, genReference);
+				assert(fast.getSize() == reference.getSize());
+				assert(memcmp(fast.programBuffer, reference.programBuffer, sizeof(randomx::Instruction) * fast.getSize()) == 0);
+				assert(fast.getAddressRegister() == reference.getAddressRegister());
+				assert(fast.codeSize == reference.codeSize && fast.macroOps == reference.macroOps);
+				assert(fast.decodeCycles == reference.decodeCycles && fast.mulCount == reference.mulCount);
+				assert(fast.cpuLatency == reference.cpuLatency && fast.asicLatency == reference.asicLatency);
+				assert(memcmp(fast.cpuLatencies, reference.cpuLatencies, sizeof(fast.cpuLatencies)) == 0);
+				assert(memcmp(fast.asicLatencies, reference.asicLatencies, sizeof(fast.asicLatencies)) == 0);
+			}
+		}
+	});
+
+	runTest("SuperscalarHash bytecode", true, []() {
+		std::vector<uint64_t> reciprocals;
+		std::vector<randomx::SuperscalarByteCode> bytecode;
+		randomx::SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES];
+		randomx::Blake2Generator gen("bytecode", 8);
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			randomx::generateSuperscalar(programs[i], gen);
+			for (unsigned j = 0; j < programs[i].getSize(); ++j) {
+				auto& instr = programs[i](j);
+				if ((randomx::SuperscalarInstructionType)instr.opcode == randomx::SuperscalarInstructionType::IMUL_RCP) {
+					uint64_t rcp = randomx_reciprocal(instr.getImm32());
+					instr.setImm32(reciprocals.size());
+					reciprocals.push_back(rcp);
+				}
+			}
+			randomx::compileSuperscalar(programs[i], reciprocals, bytecode);
+		}
+		uint64_t r1[8], r2[8];
+		for (int q = 0; q < 8; ++q)
+			r1[q] = r2[q] = 0x9e3779b97f4a7c15ULL * (q + 1);
+		const randomx::SuperscalarByteCode* code = bytecode.data();
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			randomx::executeSuperscalar(r1, programs[i], &reciprocals);
+			code = randomx::executeSuperscalarBytecode(r2, code);
+			assert(memcmp(r1, r2, sizeof(r1)) == 0);
+			assert(code->dst == programs[i].getAddressRegister());
+			++code;
+		}
+		assert(code == bytecode.data() + bytecode.size());
+	});
+
+	runTest("SuperscalarHash group variants", true, []() {
+		std::vector<uint64_t> reciprocals;
+		std::vector<randomx::SuperscalarByteCode> bytecode;
+		randomx::SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES];
+		randomx::Blake2Generator gen("group", 5);
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			randomx::generateSuperscalar(programs[i], gen);
+			for (unsigned j = 0; j < programs[i].getSize(); ++j) {
+				auto& instr = programs[i](j);
+				if ((randomx::SuperscalarInstructionType)instr.opcode == randomx::SuperscalarInstructionType::IMUL_RCP) {
+					uint64_t rcp = randomx_reciprocal(instr.getImm32());
+					instr.setImm32(reciprocals.size());
+					reciprocals.push_back(rcp);
+				}
+			}
+			randomx::compileSuperscalar(programs[i], reciprocals, bytecode);
+		}
+		randomx::Cpu cpu;
+		randomx::SuperscalarGroupFunc* variants[] = { randomx::superscalarGroupPortable(), cpu.hasAvx2() ? randomx::superscalarGroupAvx2() : nullptr,
+			cpu.hasAvx512f() && cpu.hasAvx512dq() ? randomx::superscalarGroupAvx512() : nullptr, &randomx::executeSuperscalarBytecodeGroup };
+		for (auto variant : variants) {
+			if (variant == nullptr)
+				continue;
+			uint64_t r1[8][randomx::SuperscalarGroupSize], r2[8][randomx::SuperscalarGroupSize];
+			for (int q = 0; q < 8; ++q)
+				for (int k = 0; k < randomx::SuperscalarGroupSize; ++k)
+					r1[q][k] = r2[q][k] = 0x9e3779b97f4a7c15ULL * (q + 1) + k;
+			const randomx::SuperscalarByteCode* code = bytecode.data();
+			for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+				randomx::executeSuperscalarGroup(r1, programs[i], &reciprocals);
+				code = variant(r2, code);
+				assert(memcmp(r1, r2, sizeof(r1)) == 0);
+				assert(code->dst == programs[i].getAddressRegister());
+				++code;
+			}
+			assert(code == bytecode.data() + bytecode.size());
+		}
+	});
+
+	runTest("Instruction decode table", true, []() {
+		const int ceilings[] = { randomx::ceil_IADD_RS, randomx::ceil_IADD_M, randomx::ceil_ISUB_R, randomx::ceil_ISUB_M,
+			randomx::ceil_IMUL_R, randomx::ceil_IMUL_M, randomx::ceil_IMULH_R, randomx::ceil_IMULH_M, randomx::ceil_ISMULH_R,
+			randomx::ceil_ISMULH_M, randomx::ceil_IMUL_RCP, randomx::ceil_INEG_R, randomx::ceil_IXOR_R, randomx::ceil_IXOR_M,
+			randomx::ceil_IROR_R, randomx::ceil_IROL_R, randomx::ceil_ISWAP_R, randomx::ceil_FSWAP_R, randomx::ceil_FADD_R,
+			randomx::ceil_FADD_M, randomx::ceil_FSUB_R, randomx::ceil_FSUB_M, randomx::ceil_FSCAL_R, randomx::ceil_FMUL_R,
+			randomx::ceil_FDIV_M, randomx::ceil_FSQRT_R, randomx::ceil_CBRANCH, randomx::ceil_CFROUND, randomx::ceil_ISTORE,
+			randomx::ceil_NOP };
+		randomx::Instruction instr;
+		int type = 0;
+		for (int opcode = 0; opcode < 256; ++opcode) {
+			while (opcode >= ceilings[type])
+				++type;
+			instr.opcode = opcode;
+			assert(instr.getType() == (randomx::InstructionType)type);
+		}
+	});
+
 	runTest("randomx_reciprocal", true, []() {
 		assert(randomx_reciprocal(3) == 12297829382473034410U);
 		assert(randomx_reciprocal(13) == 11351842506898185609U);
@@ -146,6 +298,29 @@ int main() {
 		assert(datasetItem[0] == 0x145a5091f7853099);
 	});
 
+	runTest("Dataset initialization (interpreter, item groups)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		constexpr uint64_t firstItem = 10000000 - 3;
+		uint64_t expected[randomx::DatasetItemGroupSize][8];
+		for (unsigned k = 0; k < randomx::DatasetItemGroupSize; ++k)
+			randomx::initDatasetItem(cache, (uint8_t*)&expected[k], firstItem + k);
+		assert(expected[3][0] == 0x7943a1f6186ffb72);
+		for (unsigned count = 1; count <= randomx::DatasetItemGroupSize; ++count) {
+			uint64_t items[randomx::DatasetItemGroupSize + 1][8];
+			memset(items, 0xcc, sizeof(items));
+			randomx::initDatasetItems(cache, (uint8_t*)&items, firstItem, count);
+			assert(memcmp(items, expected, count * sizeof(items[0])) == 0);
+			assert(items[count][0] == 0xcccccccccccccccc);
+		}
+		uint64_t dataset[11][8];
+		randomx::initDataset(cache, (uint8_t*)&dataset, firstItem, firstItem + 11);
+		assert(memcmp(dataset, expected, sizeof(expected)) == 0);
+		for (unsigned k = randomx::DatasetItemGroupSize; k < 11; ++k) {
+			randomx::initDatasetItem(cache, (uint8_t*)&expected[0], firstItem + k);
+			assert(memcmp(dataset[k], expected[0], sizeof(expected[0])) == 0);
+		}
+	});
+
 	runTest("Dataset initialization (compiler)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
 		initCache("test key 000");
 		randomx::JitCompiler jit;
@@ -167,6 +342,122 @@ int main() {
 		assert(datasetItem[0] == 0x145a5091f7853099);
 	});
 
+	runTest("Dataset initialization (compiler, item range)", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		randomx::JitCompiler jit;
+		jit.generateSuperscalarHash(cache->programs, cache->reciprocalCache);
+		jit.generateDatasetInitCode();
+#ifdef RANDOMX_FORCE_SECURE
+		jit.enableExecution();
+#else
+		jit.enableAll();
+#endif
+		//odd item counts exercise the last item of JIT loops that calculate several items at once
+		constexpr uint32_t startItem = 9999997;
+		constexpr uint32_t itemCount = 37;
+		uint8_t expected[itemCount * randomx::CacheLineSize];
+		uint8_t actual[itemCount * randomx::CacheLineSize];
+		randomx::initDataset(cache, expected, startItem, startItem + itemCount);
+		for (uint32_t count = 1; count <= itemCount; count += 6) {
+			memset(actual, 0, sizeof(actual));
+			jit.getDatasetInitFunc()(cache, actual, startItem, startItem + count);
+			assert(memcmp(expected, actual, count * randomx::CacheLineSize) == 0);
+		}
+		assert(load64(actual + 3 * randomx::CacheLineSize) == 0x7943a1f6186ffb72);
+	});
+
+	runTest("Dataset initialization (AVX-512)", randomx_get_flags() & RANDOMX_FLAG_DATASET_AVX512, []() {
+		initCache("test key 000");
+		randomx_cache* vcache = randomx_alloc_cache(RANDOMX_FLAG_JIT | RANDOMX_FLAG_DATASET_AVX512);
+		assert(vcache != nullptr);
+		randomx_init_cache(vcache, "test key 000", 12);
+		//the start and the item count are not multiples of 8
+		constexpr uint32_t startItem = 9999997;
+		constexpr uint32_t itemCount = 1027;
+		std::vector<uint8_t> expected(itemCount * randomx::CacheLineSize);
+		std::vector<uint8_t> actual(itemCount * randomx::CacheLineSize);
+		randomx::initDataset(cache, expected.data(), startItem, startItem + itemCount);
+		vcache->datasetInit(vcache, actual.data(), startItem, startItem + itemCount);
+		assert(expected == actual);
+		assert(load64(actual.data() + 3 * randomx::CacheLineSize) == 0x7943a1f6186ffb72);
+		randomx_release_cache(vcache);
+	});
+
+	runTest("Dataset initialization (parallel)", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		constexpr uint32_t startItem = 10000000;
+		constexpr uint32_t itemCount = 40000;
+		std::vector<uint8_t> expected(itemCount * randomx::CacheLineSize);
+		std::vector<uint8_t> actual(itemCount * randomx::CacheLineSize);
+		randomx::initDataset(cache, expected.data(), startItem, startItem + itemCount);
+		randomx::initDatasetParallel(cache, actual.data(), startItem, startItem + itemCount, 3, 0);
+		assert(expected == actual);
+		assert(load64(actual.data()) == 0x7943a1f6186ffb72);
+	});
+
+	runTest("Cache file", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char path[] = "randomx-cache-test.bin";
+		initCache("test key 000");
+		assert(randomx_cache_save(cache, path));
+		randomx_flags flags[] = { RANDOMX_FLAG_DEFAULT, RANDOMX_FLAG_JIT };
+		for (int i = 0; i < (RANDOMX_HAVE_COMPILER ? 2 : 1); ++i) {
+			randomx_cache* loaded = randomx_alloc_cache(flags[i]);
+			assert(loaded != nullptr);
+			assert(randomx_cache_load(loaded, path));
+			assert(loaded->isInitialized());
+			assert(loaded->cacheKey == cache->cacheKey);
+			assert(memcmp(loaded->memory, cache->memory, randomx::CacheSize) == 0);
+			uint64_t datasetItem[8];
+			loaded->datasetInit(loaded, (uint8_t*)&datasetItem, 10000000, 10000001);
+			assert(datasetItem[0] == 0x7943a1f6186ffb72);
+			randomx_release_cache(loaded);
+		}
+		remove(path);
+		randomx_cache* loaded = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		assert(!randomx_cache_load(loaded, path));
+		assert(!loaded->isInitialized());
+		randomx_release_cache(loaded);
+	});
+
+	runTest("AOT dataset module", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		static uint64_t calls;
+		randomx_aot_module module;
+		module.initItem = [](const void* cacheMemory, void* output, uint64_t itemNumber) {
+			assert(cacheMemory == cache->memory);
+			uint64_t item[8] = { itemNumber };
+			memcpy(output, item, sizeof(item));
+			calls++;
+		};
+		initCache("test key 000");
+		blake2b(module.keyHash, sizeof(module.keyHash), "test key 001", 12, nullptr, 0);
+		randomx::hashConfiguration(module.configurationHash);
+		assert(!randomx_cache_set_aot_module(cache, &module));
+		blake2b(module.keyHash, sizeof(module.keyHash), "test key 000", 12, nullptr, 0);
+		module.configurationHash[0] ^= 1;
+		assert(!randomx_cache_set_aot_module(cache, &module));
+		module.configurationHash[0] ^= 1;
+		assert(randomx_cache_set_aot_module(cache, &module));
+		uint64_t datasetItem[8];
+		randomx::initDatasetItem(cache, (uint8_t*)&datasetItem, 10000000);
+		assert(datasetItem[0] == 10000000 && calls == 1);
+		assert(randomx_cache_set_aot_module(cache, nullptr));
+		randomx::initDatasetItem(cache, (uint8_t*)&datasetItem, 10000000);
+		assert(datasetItem[0] == 0x7943a1f6186ffb72 && calls == 1);
+		//the generated module hashes the same key and configuration
+		randomx::SuperscalarProgram programs[RANDOMX_CACHE_ACCESSES];
+		randomx::Blake2Generator gen("test key 000", 12);
+		for (int i = 0; i < RANDOMX_CACHE_ACCESSES; ++i) {
+			randomx::generateSuperscalar(programs[i], gen);
+		}
+		randomx::AssemblyGeneratorX86 asmX86;
+		asmX86.generateDatasetC(programs, module.keyHash, module.configurationHash, "test_module");
+		std::stringstream source;
+		asmX86.printCode(source);
+		std::string code = source.str();
+		assert(code.find("randomx_aot_module test_module = {\n\t{\n\t\t0x3a, 0x68, 0xd9, 0x93,") != std::string::npos);
+		assert(code.find("r8 = (itemNumber + 1) * 0x5851f42d4c957f2dULL;") != std::string::npos);
+	});
+
 	runTest("AesGenerator1R", true, []() {
 		char state[64] = { 0 };
 		hex2bin("6c19536eb2de31b6c0065f7f116e86f960d8af0c57210a6584c3237b9d064dc7", 64, state);
@@ -1059,6 +1350,30 @@ int main() {
 		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
 	});
 
+	if (cache != nullptr)
+		randomx_release_cache(cache);
+	cache = randomx_alloc_cache(RANDOMX_FLAG_ARGON2_AVX512);
+
+	runTest("Cache initialization: AVX512", (flags & RANDOMX_FLAG_ARGON2_AVX512) && RANDOMX_ARGON_ITERATIONS == 3 && RANDOMX_ARGON_LANES == 1 && RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		uint64_t* cacheMemory = (uint64_t*)cache->memory;
+		assert(cacheMemory[0] == 0x191e0e1d23c02186);
+		assert(cacheMemory[1568413] == 0xf1b62fe6210bf8b1);
+		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
+	});
+
+	if (cache != nullptr)
+		randomx_release_cache(cache);
+	cache = randomx_alloc_cache(RANDOMX_FLAG_ARGON2_NEON);
+
+	runTest("Cache initialization: NEON", (flags & RANDOMX_FLAG_ARGON2_NEON) && RANDOMX_ARGON_ITERATIONS == 3 && RANDOMX_ARGON_LANES == 1 && RANDOMX_ARGON_MEMORY == 262144 && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		initCache("test key 000");
+		uint64_t* cacheMemory = (uint64_t*)cache->memory;
+		assert(cacheMemory[0] == 0x191e0e1d23c02186);
+		assert(cacheMemory[1568413] == 0xf1b62fe6210bf8b1);
+		assert(cacheMemory[33554431] == 0x1f47f056d05cd99b);
+	});
+
 	if (cache != nullptr)
 		randomx_release_cache(cache);
 	cache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
@@ -1082,6 +1397,50 @@ int main() {
 		assert(equalsHex(hash3, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
 	});
 
+	runTest("Hash batch API test", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		char hashes[3 * RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		const char input1[] = "This is a test";
+		const char input2[] = "Lorem ipsum dolor sit amet";
+		const char input3[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const void* inputs[] = { input1, input2, input3 };
+		const size_t inputSizes[] = { sizeof(input1) - 1, sizeof(input2) - 1, sizeof(input3) - 1 };
+
+		rx_set_rounding_mode(RoundToNearest);
+		randomx_calculate_hash_batch(vm, inputs, inputSizes, 3, hashes);
+		assert(rx_get_rounding_mode() == RoundToNearest);
+
+		assert(equalsHex(hashes + 0 * RANDOMX_HASH_SIZE, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		assert(equalsHex(hashes + 1 * RANDOMX_HASH_SIZE, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		assert(equalsHex(hashes + 2 * RANDOMX_HASH_SIZE, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+
+		randomx_calculate_hash_batch(vm, inputs + 1, inputSizes + 1, 1, hashes);
+		assert(equalsHex(hashes, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+	});
+
+	runTest("Scatter-gather input", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		char hash1[RANDOMX_HASH_SIZE];
+		char hash2[RANDOMX_HASH_SIZE];
+		char hash3[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const randomx_buffer parts[] = { { input, 7 }, { nullptr, 0 }, { input + 7, 40 }, { input + 47, sizeof(input) - 48 } };
+		const randomx_buffer lorem[] = { { "Lorem ipsum ", 12 }, { "dolor sit amet", 14 } };
+
+		randomx_calculate_hash_parts(vm, parts, 4, &hash1);
+		assert(equalsHex(hash1, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+
+		randomx_calculate_hash_first_parts(vm, lorem, 2);
+		randomx_calculate_hash_next_parts(vm, parts, 4, &hash1);
+		randomx_calculate_hash_last(vm, &hash2);
+		assert(equalsHex(hash1, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		assert(equalsHex(hash2, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+
+		randomx_calculate_commitment(input, sizeof(input) - 1, hash2, &hash3);
+		randomx_calculate_commitment_parts(parts, 4, hash2, &hash1);
+		assert(memcmp(hash1, hash3, RANDOMX_HASH_SIZE) == 0);
+	});
+
 	runTest("Preserve rounding mode", RANDOMX_FREQ_CFROUND > 0, []() {
 		rx_set_rounding_mode(RoundToNearest);
 		char hash[RANDOMX_HASH_SIZE];
@@ -1090,6 +1449,437 @@ int main() {
 		assert(rx_get_rounding_mode() == RoundToNearest);
 	});
 
+	runTest("Rounding mode emulation", true, []() {
+		uint64_t state = 0x9e3779b97f4a7c15;
+		auto randomDouble = [&state](int exponentRange) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			uint64_t exponent = 1023 - exponentRange / 2 + (state >> 52) % exponentRange;
+			uint64_t bits = (state & 0x800fffffffffffff) | (exponent << 52);
+			double x;
+			memcpy(&x, &bits, sizeof(x));
+			return x;
+		};
+		for (int i = 0; i < 100000; ++i) {
+			int exponentRange = (i & 1) ? 128 : 4;
+			double a = randomDouble(exponentRange);
+			double b = randomDouble(exponentRange);
+			for (uint32_t mode = 0; mode < 4; ++mode) {
+				volatile double ops[2] = { a, b };
+				double expected[5][2], emulated[5][2];
+				rx_vec_f128 va = rx_set1_vec_f128(0), vb = va;
+				rx_set_rounding_mode(mode);
+				memcpy(&va, (const void*)&ops[0], sizeof(double));
+				memcpy(&vb, (const void*)&ops[1], sizeof(double));
+				rx_store_vec_f128(expected[0], rx_add_vec_f128(va, vb));
+				rx_store_vec_f128(expected[1], rx_sub_vec_f128(va, vb));
+				rx_store_vec_f128(expected[2], rx_mul_vec_f128(va, vb));
+				rx_store_vec_f128(expected[3], rx_div_vec_f128(va, vb));
+				rx_store_vec_f128(expected[4], rx_sqrt_vec_f128(rx_and_vec_f128(va, rx_set1_vec_f128(0x7fffffffffffffff))));
+				rx_set_rounding_mode(RoundToNearest);
+				emulated[0][0] = rx_add_rounded(a, b, mode);
+				emulated[1][0] = rx_sub_rounded(a, b, mode);
+				emulated[2][0] = rx_mul_rounded(a, b, mode);
+				emulated[3][0] = rx_div_rounded(a, b, mode);
+				emulated[4][0] = rx_sqrt_rounded(std::fabs(a), mode);
+				for (int j = 0; j < 5; ++j) {
+					assert(memcmp(&expected[j][0], &emulated[j][0], sizeof(double)) == 0);
+				}
+			}
+		}
+	});
+
+	runTest("Threaded bytecode dispatch", RANDOMX_THREADED_BYTECODE, []() {
+		randomx::Program program;
+		randomx::ProgramConfiguration config;
+		randomx::BytecodeMachine decoder;
+		randomx::NativeRegisterFile regs[2];
+		randomx::InstructionByteCode bytecode[2][RANDOMX_PROGRAM_SIZE];
+		std::vector<uint8_t> scratchpads[2];
+		char seed[64] = { 0 };
+		config.eMask[0] = 0x3a00000000000000;
+		config.eMask[1] = 0x3e00000000000000;
+		for (int i = 0; i < 50; ++i) {
+			seed[0] = (char)i;
+			fillAes1Rx4<true>(seed, sizeof(program), &program);
+			scratchpads[0].resize(RANDOMX_SCRATCHPAD_L3);
+			fillAes1Rx4<true>(seed, scratchpads[0].size(), scratchpads[0].data());
+			scratchpads[1] = scratchpads[0];
+			for (int v = 0; v < 2; ++v) {
+				auto& nreg = regs[v];
+				for (unsigned j = 0; j < randomx::RegistersCount; ++j)
+					nreg.r[j] = load64(&scratchpads[v][8 * j]);
+				for (unsigned j = 0; j < randomx::RegisterCountFlt; ++j) {
+					nreg.f[j] = rx_cvt_packed_int_vec_f128(&scratchpads[v][64 + 8 * j]);
+					nreg.e[j] = rx_set_vec_f128(0x3ff8000000000000 + j, 0x4004000000000000 + j);
+					nreg.a[j] = rx_set_vec_f128(0x3ff0000000000000 + j, 0x3ff1000000000000 + j);
+				}
+				decoder.compileProgram(program, bytecode[v], nreg);
+				rx_set_rounding_mode(RoundToNearest);
+				if (v == 0)
+					randomx::BytecodeMachine::executeBytecodeSwitch(bytecode[v], scratchpads[v].data(), config);
+				else
+					randomx::BytecodeMachine::executeBytecode(bytecode[v], scratchpads[v].data(), config);
+			}
+			assert(memcmp(&regs[0], &regs[1], sizeof(regs[0])) == 0);
+			assert(scratchpads[0] == scratchpads[1]);
+		}
+		rx_set_rounding_mode(RoundToNearest);
+	});
+
+	runTest("Program scheduler", true, []() {
+		//a scheduled program must give the same result as the original one,
+		//including the CBRANCH targets
+		randomx::Program program, scheduled;
+		randomx::ProgramConfiguration config;
+		randomx::BytecodeMachine decoder;
+		randomx::NativeRegisterFile regs[2];
+		randomx::InstructionByteCode bytecode[2][RANDOMX_PROGRAM_SIZE];
+		std::vector<uint8_t> scratchpads[2];
+		uint32_t order[RANDOMX_PROGRAM_SIZE];
+		char seed[64] = { 0 };
+		bool reordered = false;
+		config.eMask[0] = 0x3a00000000000000;
+		config.eMask[1] = 0x3e00000000000000;
+		for (int i = 0; i < 50; ++i) {
+			seed[0] = (char)i;
+			fillAes1Rx4<true>(seed, sizeof(program), &program);
+			scheduled = program;
+			randomx::scheduleProgram(program, order);
+			std::vector<bool> seen(RANDOMX_PROGRAM_SIZE);
+			for (unsigned j = 0; j < RANDOMX_PROGRAM_SIZE; ++j) {
+				assert(!seen[order[j]]);
+				seen[order[j]] = true;
+				scheduled(j) = program(order[j]);
+				reordered = reordered || order[j] != j;
+			}
+			scratchpads[0].resize(RANDOMX_SCRATCHPAD_L3);
+			fillAes1Rx4<true>(seed, scratchpads[0].size(), scratchpads[0].data());
+			scratchpads[1] = scratchpads[0];
+			for (int v = 0; v < 2; ++v) {
+				auto& nreg = regs[v];
+				for (unsigned j = 0; j < randomx::RegistersCount; ++j)
+					nreg.r[j] = load64(&scratchpads[v][8 * j]);
+				for (unsigned j = 0; j < randomx::RegisterCountFlt; ++j) {
+					nreg.f[j] = rx_cvt_packed_int_vec_f128(&scratchpads[v][64 + 8 * j]);
+					nreg.e[j] = rx_set_vec_f128(0x3ff8000000000000 + j, 0x4004000000000000 + j);
+					nreg.a[j] = rx_set_vec_f128(0x3ff0000000000000 + j, 0x3ff1000000000000 + j);
+				}
+				decoder.compileProgram(v == 0 ? program : scheduled, bytecode[v], nreg);
+				rx_set_rounding_mode(RoundToNearest);
+				for (int k = 0; k < 16; ++k)
+					randomx::BytecodeMachine::executeBytecode(bytecode[v], scratchpads[v].data(), config);
+			}
+			assert(memcmp(&regs[0], &regs[1], sizeof(regs[0])) == 0);
+			assert(scratchpads[0] == scratchpads[1]);
+		}
+		assert(reordered);
+		rx_set_rounding_mode(RoundToNearest);
+	});
+
+	runTest("Dual-mapped secure JIT", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx::JitCompiler jit;
+		if (jit.enableDualMapping()) {
+			assert((void*)jit.getProgramFunc() != (void*)jit.getCode());
+		}
+		randomx_cache* secureCache = randomx_alloc_cache(RANDOMX_FLAG_JIT);
+		randomx_init_cache(secureCache, "test key 000", 12);
+		randomx_vm* machine = randomx_create_vm(RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE, secureCache, nullptr);
+		assert(machine != nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		for (int i = 0; i < 2; ++i) {
+			randomx_calculate_hash(machine, "Lorem ipsum dolor sit amet", 26, hash);
+			assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		}
+		randomx_destroy_vm(machine);
+		randomx_release_cache(secureCache);
+	});
+
+	runTest("Shared JIT code region", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+#if defined(_M_X64) || defined(__x86_64__)
+		//the code buffers of two compilers are carved from the same region
+		randomx::JitCompiler jits[2];
+		if (jits[0].enableSharedCode(false) && jits[1].enableSharedCode(false)) {
+			size_t distance = jits[0].getCode() > jits[1].getCode() ? jits[0].getCode() - jits[1].getCode() : jits[1].getCode() - jits[0].getCode();
+			assert(distance >= jits[0].getCodeSize() && distance < randomx::CodeRegionSize);
+			assert(!jits[0].enableSharedCode(true));
+		}
+#endif
+		randomx_cache* sharedCache = randomx_alloc_cache((randomx_flags)(RANDOMX_FLAG_JIT | RANDOMX_FLAG_JIT_SHARED_CODE));
+		assert(sharedCache != nullptr);
+		randomx_init_cache(sharedCache, "test key 000", 12);
+		const randomx_flags vmFlags[2] = { (randomx_flags)(RANDOMX_FLAG_JIT | RANDOMX_FLAG_JIT_SHARED_CODE),
+			(randomx_flags)(RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE | RANDOMX_FLAG_JIT_SHARED_CODE) };
+		for (auto flags : vmFlags) {
+			randomx_vm* machines[3];
+			for (auto& machine : machines) {
+				machine = randomx_create_vm(flags, sharedCache, nullptr);
+				assert(machine != nullptr);
+			}
+			char hash[RANDOMX_HASH_SIZE];
+			for (auto machine : machines) {
+				randomx_calculate_hash(machine, "Lorem ipsum dolor sit amet", 26, hash);
+				assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+			}
+			for (auto machine : machines) {
+				randomx_destroy_vm(machine);
+			}
+		}
+		randomx_release_cache(sharedCache);
+	});
+
+	runTest("Dataset 1 GiB pages", true, []() {
+		constexpr size_t gigaPage = (size_t)1 << 30;
+		const size_t size = gigaPage + 3 * 1024 * 1024;
+		uint8_t* mem = (uint8_t*)allocGigaPagesMemory(size);
+		if (mem != nullptr) {
+			assert((uintptr_t)mem % gigaPage == 0);
+			mem[0] = mem[size - 1] = 1;
+			freeGigaPagesMemory(mem, size);
+		}
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_LARGE_PAGES_1GB);
+		assert(dataset != nullptr);
+		size_t pageSize = randomx_dataset_page_size(dataset);
+		assert(pageSize == gigaPage || pageSize == getLargePageSize() || pageSize == getPageSize());
+		uint8_t* datasetMemory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		datasetMemory[0] = datasetMemory[randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE - 1] = 1;
+		randomx_release_dataset(dataset);
+		dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		assert(randomx_dataset_page_size(dataset) == getPageSize());
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Dataset pre-faulting", true, []() {
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_PREFAULT);
+		assert(dataset != nullptr);
+		assert(randomx_dataset_prefault_time(dataset) > 0);
+		uint8_t* datasetMemory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		assert(datasetMemory[0] == 0 && datasetMemory[randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE - 1] == 0);
+		randomx_release_dataset(dataset);
+		dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		assert(randomx_dataset_prefault_time(dataset) == 0);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Transparent huge pages fallback", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const size_t size = 4 * 1024 * 1024 + 100;
+		uint8_t* mem = (uint8_t*)allocTransparentHugePagesMemory(size);
+		if (mem != nullptr) {
+			assert((uintptr_t)mem % (2 * 1024 * 1024) == 0);
+			mem[0] = mem[size - 1] = 1;
+			freePagedMemory(mem, size);
+		}
+		randomx_cache* thpCache = randomx_alloc_cache(RANDOMX_FLAG_LARGE_PAGES);
+		if (thpCache == nullptr) {
+			assert(mem == nullptr);
+			return;
+		}
+		randomx_page_backing backing = randomx_cache_page_backing(thpCache);
+		assert(backing == RANDOMX_PAGES_LARGE || backing == RANDOMX_PAGES_TRANSPARENT);
+		randomx_init_cache(thpCache, "test key 000", 12);
+		randomx_vm* thpVm = randomx_create_vm(RANDOMX_FLAG_LARGE_PAGES, thpCache, nullptr);
+		assert(thpVm != nullptr);
+		assert(randomx_vm_page_backing(thpVm) == RANDOMX_PAGES_LARGE || randomx_vm_page_backing(thpVm) == RANDOMX_PAGES_TRANSPARENT);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(thpVm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_destroy_vm(thpVm);
+		randomx_release_cache(thpCache);
+		randomx_cache* plainCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		assert(randomx_cache_page_backing(plainCache) == RANDOMX_PAGES_STANDARD);
+		randomx_release_cache(plainCache);
+	});
+
+	runTest("Large pages status", true, []() {
+		int error = -1;
+		const size_t size = 4 * 1024 * 1024;
+		void* mem = allocLargePagesMemory(size);
+		randomx_large_pages_result result = randomx_large_pages_status(&error);
+		if (mem != nullptr) {
+			assert(result == RANDOMX_LARGE_PAGES_OK && error == 0);
+			freePagedMemory(mem, size);
+		}
+		else {
+			assert(result > RANDOMX_LARGE_PAGES_OK && result <= RANDOMX_LARGE_PAGES_ERROR);
+		}
+		//the status is per thread
+		std::thread([]() {
+			assert(randomx_large_pages_status(nullptr) == RANDOMX_LARGE_PAGES_NOT_TRIED);
+		}).join();
+		int previous = setAllocationNode(0);
+		assert(previous == -1 && getAllocationNode() == 0);
+		mem = allocMemoryPages(size);
+		assert(mem != nullptr);
+		freePagedMemory(mem, size);
+		setAllocationNode(previous);
+		assert(getAllocationNode() == -1);
+	});
+
+	runTest("Custom allocator", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		static int live[4], total[4];
+		randomx_allocator counting;
+		counting.alloc = [](size_t size, size_t alignment, randomx_memory_purpose purpose, void*) -> void* {
+			assert(alignment <= 4096 && (alignment & (alignment - 1)) == 0);
+			live[purpose]++;
+			total[purpose]++;
+			return allocMemoryPages(size);
+		};
+		counting.free = [](void* ptr, size_t size, randomx_memory_purpose purpose, void*) {
+			live[purpose]--;
+			freePagedMemory(ptr, size);
+		};
+		counting.userData = nullptr;
+		randomx_set_allocator(&counting);
+		randomx_flags jitFlags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_cache* customCache = randomx_alloc_cache(jitFlags | RANDOMX_FLAG_LARGE_PAGES);
+		assert(customCache != nullptr);
+		assert(randomx_cache_page_backing(customCache) == RANDOMX_PAGES_CUSTOM);
+		randomx_init_cache(customCache, "test key 000", 12);
+		randomx_vm* customVm = randomx_create_vm(jitFlags, customCache, nullptr);
+		assert(customVm != nullptr);
+		assert(randomx_vm_page_backing(customVm) == RANDOMX_PAGES_CUSTOM);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(customVm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		assert(total[RANDOMX_MEMORY_CACHE] == 1 && total[RANDOMX_MEMORY_SCRATCHPAD] == 1);
+		assert(RANDOMX_HAVE_COMPILER == 0 || total[RANDOMX_MEMORY_JIT] >= 2);
+		randomx_destroy_vm(customVm);
+		randomx_release_cache(customCache);
+		randomx_set_allocator(nullptr);
+		for (int i = 0; i < 4; ++i) {
+			assert(live[i] == 0);
+		}
+		randomx_cache* plainCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		assert(randomx_cache_page_backing(plainCache) == RANDOMX_PAGES_STANDARD);
+		randomx_release_cache(plainCache);
+		assert(total[RANDOMX_MEMORY_CACHE] == 1);
+	});
+
+	runTest("Scratchpad arena", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		assert(randomx_alloc_scratchpad_arena(0, RANDOMX_FLAG_DEFAULT) == nullptr);
+		randomx_scratchpad_arena* arena = randomx_alloc_scratchpad_arena(2, RANDOMX_FLAG_DEFAULT);
+		assert(arena != nullptr);
+		randomx_cache* arenaCache = randomx_alloc_cache(RANDOMX_FLAG_JIT);
+		randomx_init_cache(arenaCache, "test key 000", 12);
+		randomx_flags jitFlags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_vm* first = randomx_create_vm_arena(RANDOMX_FLAG_DEFAULT, arenaCache, nullptr, arena);
+		randomx_vm* second = randomx_create_vm_arena(jitFlags, arenaCache, nullptr, arena);
+		assert(first != nullptr && second != nullptr);
+		auto distance = (const uint8_t*)second->getScratchpad() - (const uint8_t*)first->getScratchpad();
+		assert(distance == randomx::ScratchpadSize || distance == -randomx::ScratchpadSize);
+		assert(randomx_create_vm_arena(RANDOMX_FLAG_DEFAULT, arenaCache, nullptr, arena) == nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(first, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_calculate_hash(second, "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua", 65, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_destroy_vm(first);
+		first = randomx_create_vm_arena(jitFlags, arenaCache, nullptr, arena);
+		assert(first != nullptr);
+		randomx_calculate_hash(first, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_destroy_vm(first);
+		randomx_destroy_vm(second);
+		randomx_release_scratchpad_arena(arena);
+		//staggered slots
+		arena = randomx_alloc_scratchpad_arena_layout(3, RANDOMX_FLAG_DEFAULT, RANDOMX_ARENA_STAGGERED);
+		assert(arena != nullptr);
+		randomx_vm* vms[3];
+		for (int i = 0; i < 3; ++i) {
+			vms[i] = randomx_create_vm_arena(jitFlags, arenaCache, nullptr, arena);
+			assert(vms[i] != nullptr);
+		}
+		for (int i = 1; i < 3; ++i) {
+			distance = (const uint8_t*)vms[i]->getScratchpad() - (const uint8_t*)vms[i - 1]->getScratchpad();
+			assert(distance == randomx::ScratchpadSize + RANDOMX_SCRATCHPAD_L1);
+			assert((uint8_t*)vms[i] - (uint8_t*)vms[i - 1] == randomx::ArenaVmSize + randomx::ArenaVmStagger);
+		}
+		randomx_calculate_hash(vms[2], "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		for (int i = 0; i < 3; ++i)
+			randomx_destroy_vm(vms[i]);
+		randomx_release_scratchpad_arena(arena);
+		randomx_release_cache(arenaCache);
+	});
+
+	runTest("Parallel cache initialization", true, []() {
+		randomx_cache* serialCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		randomx_cache* parallelCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		randomx_init_cache(serialCache, "test key 000", 12);
+		randomx_init_cache_parallel(parallelCache, "test key 000", 12, 4);
+		assert(memcmp(serialCache->memory, parallelCache->memory, randomx::CacheSize) == 0);
+		assert(parallelCache->reciprocalCache == serialCache->reciprocalCache);
+		randomx_release_cache(parallelCache);
+		randomx_release_cache(serialCache);
+	});
+
+	runTest("Cache drain", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_cache* drainCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		randomx_init_cache(drainCache, "test key 001", 12);
+		assert(!randomx_cache_is_drained(drainCache));
+		randomx_scratchpad_arena* arena = randomx_cache_drain_to_arena(drainCache);
+		assert(arena != nullptr);
+		assert(randomx_cache_is_drained(drainCache));
+		assert(randomx_cache_drain_to_arena(drainCache) == nullptr);
+		assert(randomx_create_vm(RANDOMX_FLAG_DEFAULT, drainCache, nullptr) == nullptr);
+		randomx_init_cache(drainCache, "test key 001", 12);
+		assert(randomx_cache_is_drained(drainCache));
+		randomx_init_cache(drainCache, "test key 000", 12);
+		assert(!randomx_cache_is_drained(drainCache));
+		randomx_vm* vms[128];
+		unsigned vmCount = 0;
+		while (vmCount < 128 && (vms[vmCount] = randomx_create_vm_arena(RANDOMX_FLAG_DEFAULT, drainCache, nullptr, arena)) != nullptr) {
+			vmCount++;
+		}
+		assert(vmCount == randomx::CacheSize / (randomx::ScratchpadSize + randomx::ArenaVmSize));
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(vms[vmCount - 1], "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		for (unsigned i = 0; i < vmCount; ++i) {
+			randomx_destroy_vm(vms[i]);
+		}
+		randomx_release_scratchpad_arena(arena);
+		randomx_cache_drain(drainCache);
+		assert(randomx_cache_is_drained(drainCache));
+		randomx_cache_drain(drainCache);
+		randomx_init_cache(drainCache, "test key 001", 12);
+		randomx_init_cache(drainCache, "test key 000", 12);
+		randomx_vm* vm = randomx_create_vm(RANDOMX_FLAG_DEFAULT, drainCache, nullptr);
+		assert(vm != nullptr);
+		randomx_calculate_hash(vm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_destroy_vm(vm);
+		randomx_release_cache(drainCache);
+	});
+
+	runTest("Shared SuperscalarHash code", RANDOMX_HAVE_COMPILER && stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_cache* jitCache = randomx_alloc_cache(RANDOMX_FLAG_JIT);
+		randomx_cache* plainCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		randomx_init_cache(jitCache, "test key 000", 12);
+		randomx_init_cache(plainCache, "test key 000", 12);
+		randomx_flags flags[] = { RANDOMX_FLAG_JIT, RANDOMX_FLAG_JIT | RANDOMX_FLAG_SECURE };
+		for (randomx_flags f : flags) {
+			randomx_vm* first = randomx_create_vm(f, jitCache, nullptr);
+			randomx_vm* second = randomx_create_vm(f, jitCache, nullptr);
+			assert(first != nullptr && second != nullptr);
+			char hash[RANDOMX_HASH_SIZE];
+			for (randomx_cache* c : { jitCache, plainCache, jitCache }) {
+				randomx_vm_set_cache(first, c);
+				randomx_calculate_hash(first, "Lorem ipsum dolor sit amet", 26, hash);
+				assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+				randomx_calculate_hash(second, "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua", 65, hash);
+				assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+			}
+			randomx_destroy_vm(second);
+			randomx_destroy_vm(first);
+		}
+		randomx_release_cache(plainCache);
+		randomx_release_cache(jitCache);
+	});
+
 	if (RANDOMX_HAVE_COMPILER) {
 		randomx_destroy_vm(vm);
 		vm = nullptr;
@@ -1100,12 +1890,1216 @@ int main() {
 #endif
 	}
 
+	runTest("Interleaved VM test", RANDOMX_HAVE_INTERLEAVED, []() {
+		//the dataset is not initialized, the interleaved VM must produce the same results as the reference VM
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		randomx_vm* reference = randomx_create_vm(RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT, nullptr, dataset);
+		assert(reference != nullptr);
+		const char input1[] = "This is a test";
+		const char input2[] = "Lorem ipsum dolor sit amet";
+		const char input3[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const char input4[] = "test key 000";
+		const void* inputs[] = { input1, input2, input3, input4 };
+		const size_t inputSizes[] = { sizeof(input1) - 1, sizeof(input2) - 1, sizeof(input3) - 1, sizeof(input4) - 1 };
+		char expected[4 * RANDOMX_HASH_SIZE];
+		char hashes[4 * RANDOMX_HASH_SIZE];
+		for (int i = 0; i < 4; ++i) {
+			randomx_calculate_hash(reference, inputs[i], inputSizes[i], expected + i * RANDOMX_HASH_SIZE);
+		}
+
+		assert(randomx_create_vm_interleaved(RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT, dataset, 1) == nullptr);
+		assert(randomx_create_vm_interleaved(RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT, dataset, 5) == nullptr);
+		assert(randomx_create_vm_interleaved(RANDOMX_FLAG_JIT, dataset, 2) == nullptr);
+
+		for (unsigned lanes = 2; lanes <= 4; ++lanes) {
+			randomx_flags flags = RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT;
+			if (lanes == 3) {
+				flags |= RANDOMX_FLAG_SECURE;
+			}
+			randomx_vm* machine = randomx_create_vm_interleaved(flags, dataset, lanes);
+			assert(machine != nullptr);
+			rx_set_rounding_mode(RoundToNearest);
+			randomx_calculate_hash_interleaved(machine, inputs, inputSizes, hashes);
+			assert(rx_get_rounding_mode() == RoundToNearest);
+			assert(memcmp(hashes, expected, lanes * RANDOMX_HASH_SIZE) == 0);
+			randomx_calculate_hash_interleaved(machine, inputs + 4 - lanes, inputSizes + 4 - lanes, hashes);
+			assert(memcmp(hashes, expected + (4 - lanes) * RANDOMX_HASH_SIZE, lanes * RANDOMX_HASH_SIZE) == 0);
+			randomx_calculate_hash(machine, input2, sizeof(input2) - 1, hashes);
+			assert(memcmp(hashes, expected + RANDOMX_HASH_SIZE, RANDOMX_HASH_SIZE) == 0);
+			randomx_destroy_vm(machine);
+		}
+
+		randomx_destroy_vm(reference);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("JIT prefetch modes", RANDOMX_HAVE_COMPILER, []() {
+		//the prefetch hints must not change the result
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		const randomx_flags base = RANDOMX_FLAG_FULL_MEM | RANDOMX_FLAG_JIT;
+		randomx_vm* reference = randomx_create_vm(base, nullptr, dataset);
+		assert(reference != nullptr);
+		const char input[] = "This is a test";
+		char expected[RANDOMX_HASH_SIZE], hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(reference, input, sizeof(input) - 1, expected);
+		const randomx_flags modes[] = { RANDOMX_FLAG_PREFETCH_T0, RANDOMX_FLAG_PREFETCH_SCRATCHPAD, RANDOMX_FLAG_PREFETCH_T0 | RANDOMX_FLAG_PREFETCH_SCRATCHPAD };
+		for (auto mode : modes) {
+			randomx_vm* machine = randomx_create_vm(base | mode, nullptr, dataset);
+			assert(machine != nullptr);
+			randomx_calculate_hash(machine, input, sizeof(input) - 1, hash);
+			assert(memcmp(hash, expected, sizeof(hash)) == 0);
+			randomx_destroy_vm(machine);
+#if RANDOMX_HAVE_INTERLEAVED
+			machine = randomx_create_vm_interleaved(base | mode, dataset, 2);
+			assert(machine != nullptr);
+			randomx_calculate_hash(machine, input, sizeof(input) - 1, hash);
+			assert(memcmp(hash, expected, sizeof(hash)) == 0);
+			randomx_destroy_vm(machine);
+#endif
+		}
+		randomx_destroy_vm(reference);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("JIT branch alignment", RANDOMX_HAVE_COMPILER, []() {
+		//padding the CBRANCH code must not change the result
+		const char key[] = "test key 000";
+		const char input[] = "This is a test";
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_cache* jitCache = randomx_alloc_cache(RANDOMX_FLAG_JIT);
+		assert(jitCache != nullptr);
+		randomx_init_cache(jitCache, key, sizeof(key) - 1);
+		randomx_vm* machine = randomx_create_vm(RANDOMX_FLAG_JIT, jitCache, nullptr);
+		assert(machine != nullptr);
+		for (int enabled = 0; enabled < 2; ++enabled) {
+			machine->setBranchAlignment(enabled != 0);
+			randomx_calculate_hash(machine, input, sizeof(input) - 1, hash);
+			assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		}
+		randomx_destroy_vm(machine);
+		randomx_release_cache(jitCache);
+#if defined(_M_X64) || defined(__x86_64__)
+		//with alignment enabled, no fused test/jz pair may cross or end on a 32-byte boundary
+		randomx::JitCompilerX86 compiler;
+		randomx::Program program;
+		randomx::ProgramConfiguration config;
+		char seed[64] = { 0 };
+		int crossing[2] = { 0, 0 };
+		config.eMask[0] = 0x3a00000000000000;
+		config.eMask[1] = 0x3e00000000000000;
+		for (int enabled = 0; enabled < 2; ++enabled) {
+			compiler.setBranchAlignment(enabled != 0);
+			for (int i = 0; i < 20; ++i) {
+				seed[0] = (char)i;
+				fillAes1Rx4<true>(seed, sizeof(program), &program);
+				compiler.generateProgram(program, config);
+				const uint8_t* code = compiler.getCode();
+				const size_t size = compiler.getCodeSize();
+				for (size_t pos = 0; pos + 9 < size; ++pos) {
+					if (code[pos] == 0x49 && code[pos + 1] == 0xf7 && (code[pos + 2] & 0xf8) == 0xc0 && code[pos + 7] == 0x0f && code[pos + 8] == 0x84) {
+						if ((pos & 31) + 13 >= 32)
+							crossing[enabled]++;
+					}
+				}
+			}
+		}
+		assert(crossing[0] > 0);
+		assert(crossing[1] == 0);
+#endif
+	});
+
+	runTest("JIT AVX-512 loop load", RANDOMX_HAVE_COMPILER && randomx::Cpu().hasAvx512vl(), []() {
+#if defined(_M_X64) || defined(__x86_64__)
+		//both versions of the loop load must produce the same register file and scratchpad
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		randomx::JitCompilerX86 compilers[2];
+		randomx::Program program;
+		randomx::ProgramConfiguration config;
+		randomx::RegisterFile regs[2];
+		std::vector<uint8_t> scratchpads[2];
+		char seed[64] = { 0 };
+		config.eMask[0] = 0x3a00000000000000;
+		config.eMask[1] = 0x3e00000000000000;
+		config.readReg0 = 0;
+		config.readReg1 = 3;
+		config.readReg2 = 4;
+		config.readReg3 = 7;
+		for (int i = 0; i < 10; ++i) {
+			seed[0] = (char)i;
+			fillAes1Rx4<true>(seed, sizeof(program), &program);
+			scratchpads[0].resize(RANDOMX_SCRATCHPAD_L3);
+			fillAes1Rx4<true>(seed, scratchpads[0].size(), scratchpads[0].data());
+			scratchpads[1] = scratchpads[0];
+			for (int v = 0; v < 2; ++v) {
+				randomx::Program copy = program;
+				compilers[v].enableAll();
+				compilers[v].setAvx512Loop(v != 0);
+				compilers[v].generateProgram(copy, config);
+				memset(&regs[v], 0, sizeof(regs[v]));
+				for (unsigned j = 0; j < randomx::RegisterCountFlt; ++j) {
+					regs[v].a[j].lo = 1.0 + j;
+					regs[v].a[j].hi = 1.5 + j;
+				}
+				randomx::MemoryRegisters mem;
+				mem.mx = 0x12345678 + i;
+				mem.ma = 0x76543210 - i;
+				mem.memory = (uint8_t*)randomx_get_dataset_memory(dataset);
+				rx_set_rounding_mode(RoundToNearest);
+				compilers[v].getProgramFunc()(regs[v], mem, scratchpads[v].data(), 256);
+			}
+			rx_set_rounding_mode(RoundToNearest);
+			assert(memcmp(&regs[0], &regs[1], sizeof(regs[0])) == 0);
+			assert(scratchpads[0] == scratchpads[1]);
+		}
+		randomx_release_dataset(dataset);
+#endif
+	});
+
+	runTest("JIT encoding templates", RANDOMX_HAVE_COMPILER, []() {
+#if defined(_M_X64) || defined(__x86_64__)
+		//code emitted from the templates must be identical to the code emitted by the instruction handlers
+		randomx::JitCompilerX86 compilers[2];
+		randomx::Program program;
+		randomx::ProgramConfiguration config;
+		char seed[64] = { 0 };
+		config.eMask[0] = 0x3a00000000000000;
+		config.eMask[1] = 0x3e00000000000000;
+		for (int i = 0; i < 100; ++i) {
+			seed[0] = (char)i;
+			seed[1] = (char)(i >> 8);
+			fillAes1Rx4<true>(seed, sizeof(program), &program);
+			randomx::Program copies[2] = { program, program };
+			for (int v = 0; v < 2; ++v) {
+				compilers[v].setBranchAlignment(i % 2 != 0);
+				compilers[v].setTemplateEmission(v != 0);
+				compilers[v].generateProgram(copies[v], config);
+			}
+			assert(memcmp(compilers[0].getCode(), compilers[1].getCode(), compilers[0].getCodeSize()) == 0);
+			assert(memcmp(&copies[0], &copies[1], sizeof(program)) == 0);
+		}
+#endif
+	});
+
+	runTest("Interleaved interpreter test", true, []() {
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		randomx_vm* reference = randomx_create_vm(RANDOMX_FLAG_FULL_MEM, nullptr, dataset);
+		assert(reference != nullptr);
+		const char input1[] = "This is a test";
+		const char input2[] = "Lorem ipsum dolor sit amet";
+		const char input3[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const void* inputs[] = { input1, input2, input3 };
+		const size_t inputSizes[] = { sizeof(input1) - 1, sizeof(input2) - 1, sizeof(input3) - 1 };
+		char expected[3 * RANDOMX_HASH_SIZE];
+		char hashes[3 * RANDOMX_HASH_SIZE];
+		for (int i = 0; i < 3; ++i) {
+			randomx_calculate_hash(reference, inputs[i], inputSizes[i], expected + i * RANDOMX_HASH_SIZE);
+		}
+
+		for (unsigned lanes = 2; lanes <= 3; ++lanes) {
+			randomx_vm* machine = randomx_create_vm_interleaved(RANDOMX_FLAG_FULL_MEM, dataset, lanes);
+			assert(machine != nullptr);
+			rx_set_rounding_mode(RoundToNearest);
+			randomx_calculate_hash_interleaved(machine, inputs, inputSizes, hashes);
+			assert(rx_get_rounding_mode() == RoundToNearest);
+			assert(memcmp(hashes, expected, lanes * RANDOMX_HASH_SIZE) == 0);
+			randomx_calculate_hash(machine, input2, sizeof(input2) - 1, hashes);
+			assert(memcmp(hashes, expected + RANDOMX_HASH_SIZE, RANDOMX_HASH_SIZE) == 0);
+			randomx_destroy_vm(machine);
+		}
+
+		randomx_destroy_vm(reference);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Dataset file", true, []() {
+		const char path[] = "randomx-dataset-test.bin";
+		const char key[] = "test key 000";
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		uint8_t* memory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		const size_t datasetSize = randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE;
+		for (size_t i = 0; i < datasetSize; i += 4096) {
+			store64(memory + i, i);
+		}
+		assert(randomx_dataset_save(dataset, key, sizeof(key) - 1, path));
+		assert(randomx_dataset_map(path, key, sizeof(key) - 2) == nullptr);
+		randomx_dataset* mapped = randomx_dataset_map(path, key, sizeof(key) - 1);
+		assert(mapped != nullptr);
+		assert(memcmp(randomx_get_dataset_memory(mapped), memory, datasetSize) == 0);
+		randomx_release_dataset(mapped);
+		randomx_release_dataset(dataset);
+		remove(path);
+		assert(randomx_dataset_map(path, key, sizeof(key) - 1) == nullptr);
+	});
+
+	runTest("Shared dataset", true, []() {
+		const char name[] = "/randomx-dataset-test";
+		const char key[] = "test key 000";
+		randomx_dataset_remove_shared(name);
+		randomx_dataset* dataset = randomx_dataset_create_shared(name);
+		assert(dataset != nullptr);
+		assert(randomx_dataset_shared_generation(dataset) == 1);
+		uint8_t* memory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		const size_t datasetSize = randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE;
+		for (size_t i = 0; i < datasetSize; i += datasetSize / 16) {
+			store64(memory + i, i);
+		}
+		assert(randomx_dataset_attach_shared(name, key, sizeof(key) - 1) == nullptr);
+		randomx_dataset_publish_shared(dataset, key, sizeof(key) - 1);
+		assert(randomx_dataset_shared_generation(dataset) == 2);
+		assert(randomx_dataset_attach_shared(name, key, sizeof(key) - 2) == nullptr);
+		randomx_dataset* attached = randomx_dataset_attach_shared(name, key, sizeof(key) - 1);
+		assert(attached != nullptr);
+		assert(randomx_dataset_shared_generation(attached) == 2);
+		uint8_t* attachedMemory = (uint8_t*)randomx_get_dataset_memory(attached);
+		for (size_t i = 0; i < datasetSize; i += datasetSize / 16) {
+			assert(load64(attachedMemory + i) == i);
+		}
+		randomx_release_dataset(attached);
+		randomx_release_dataset(dataset);
+		assert(randomx_dataset_remove_shared(name));
+		assert(randomx_dataset_attach_shared(name, key, sizeof(key) - 1) == nullptr);
+	});
+
+	runTest("NUMA dataset", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const unsigned nodeCount = randomx_numa_node_count();
+		assert(nodeCount >= 1);
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_NUMA);
+		assert(dataset != nullptr);
+		assert(dataset->replicaCount == (nodeCount > 1 ? nodeCount : 0));
+		initCache("test key 000");
+		randomx_init_dataset(dataset, cache, 10000000, 1);
+		for (unsigned node = 0; node < dataset->replicaCount; ++node) {
+			uint64_t* datasetItem = (uint64_t*)(dataset->replicas[node]->memory + 10000000 * (size_t)randomx::CacheLineSize);
+			assert(datasetItem[0] == 0x7943a1f6186ffb72);
+		}
+		randomx_vm* nodeVm = randomx_create_vm_on_node(RANDOMX_FLAG_FULL_MEM, nullptr, dataset, nodeCount - 1);
+		assert(nodeVm != nullptr);
+		randomx_vm_set_dataset(nodeVm, dataset);
+		randomx_destroy_vm(nodeVm);
+		assert(randomx_create_vm_on_node(RANDOMX_FLAG_FULL_MEM, nullptr, dataset, nodeCount) == nullptr);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Dataset initialization backend", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		initCache("test key 000");
+		int calls = 0;
+		randomx_dataset_backend backend = { &contextBackend, &calls };
+		assert(randomx_init_dataset_backend(dataset, cache, &backend, 10000000 - 5, 11) == 1);
+		assert(calls == 1);
+		uint8_t* memory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		assert(load64(memory + 10000000 * (uint64_t)RANDOMX_DATASET_ITEM_SIZE) == 0x7943a1f6186ffb72);
+		uint8_t expected[11 * RANDOMX_DATASET_ITEM_SIZE];
+		for (int i = 0; i < 11; ++i)
+			randomx::initDatasetItem(cache, expected + i * RANDOMX_DATASET_ITEM_SIZE, 10000000 - 5 + i);
+		assert(memcmp(memory + (10000000 - 5) * (uint64_t)RANDOMX_DATASET_ITEM_SIZE, expected, sizeof(expected)) == 0);
+		//a failing backend falls back to the CPU
+		backend.initItems = [](void*, const randomx_dataset_init_context*, void*, uint64_t, uint64_t) { return 0; };
+		assert(randomx_init_dataset_backend(dataset, cache, &backend, 20000000, 3) == 0);
+		randomx::initDatasetItem(cache, expected, 20000002);
+		assert(memcmp(memory + 20000002 * (uint64_t)RANDOMX_DATASET_ITEM_SIZE, expected, RANDOMX_DATASET_ITEM_SIZE) == 0);
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Dataset import", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		assert(dataset != nullptr);
+		initCache("test key 000");
+		const uint32_t itemCount = randomx_dataset_item_count();
+		const uint64_t datasetSize = itemCount * (uint64_t)RANDOMX_DATASET_ITEM_SIZE;
+		//import only the items selected by the seed, the rest of the dataset stays zero
+		const char seed[] = "verification seed";
+		uint8_t seedHash[32];
+		blake2b(seedHash, sizeof(seedHash), seed, sizeof(seed) - 1, nullptr, 0);
+		randomx::Blake2Generator gen(seedHash, sizeof(seedHash));
+		const unsigned sampleCount = 16;
+		uint8_t item[RANDOMX_DATASET_ITEM_SIZE];
+		uint32_t itemNumber;
+		for (unsigned i = 0; i < sampleCount; ++i) {
+			itemNumber = gen.getUInt32() % itemCount;
+			randomx::initDatasetItem(cache, item, itemNumber);
+			assert(randomx_dataset_import_chunk(dataset, itemNumber * (uint64_t)RANDOMX_DATASET_ITEM_SIZE, item, sizeof(item)));
+		}
+		assert(randomx_dataset_verify(dataset, cache, sampleCount, seed, sizeof(seed) - 1));
+		assert(!randomx_dataset_verify(dataset, cache, sampleCount, "another seed", 12));
+		item[0] ^= 1;
+		assert(randomx_dataset_import_chunk(dataset, itemNumber * (uint64_t)RANDOMX_DATASET_ITEM_SIZE, item, sizeof(item)));
+		assert(!randomx_dataset_verify(dataset, cache, sampleCount, seed, sizeof(seed) - 1));
+		assert(randomx_dataset_import_chunk(dataset, datasetSize, item, 0));
+		assert(!randomx_dataset_import_chunk(dataset, datasetSize - sizeof(item) / 2, item, sizeof(item)));
+		assert(!randomx_dataset_import_chunk(dataset, datasetSize + 1, item, 0));
+		randomx_release_dataset(dataset);
+	});
+
+	runTest("Thread placement", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		//two P-cores with SMT (CPUs 0-3) and four E-cores in their own cache domain (CPUs 4-7)
+		std::vector<randomx::LogicalCpu> hybrid;
+		for (unsigned cpu = 0; cpu < 8; ++cpu) {
+			bool pcore = cpu < 4;
+			hybrid.push_back({ cpu, pcore ? cpu & ~1u : cpu, pcore ? 0u : 4u, 0, pcore ? randomx::MaxCpuCapacity : randomx::MaxCpuCapacity / 2 });
+		}
+		assert(randomx::placeThreads(hybrid, RANDOMX_PLACEMENT_FAST_CORES, 0) == std::vector<unsigned>({ 0, 2, 1, 3 }));
+		assert(randomx::placeThreads(hybrid, RANDOMX_PLACEMENT_FAST_CORES, 6) == std::vector<unsigned>({ 0, 2, 1, 3, 0, 2 }));
+		assert(randomx::placeThreads(hybrid, RANDOMX_PLACEMENT_ALL_CORES, 0) == std::vector<unsigned>({ 0, 2, 4, 5, 6, 7, 1, 3 }));
+		assert(randomx::placeThreads(hybrid, RANDOMX_PLACEMENT_NONE, 4).empty());
+		//two cache domains of four cores, consecutive threads alternate between them
+		std::vector<randomx::LogicalCpu> ccx;
+		for (unsigned cpu = 0; cpu < 8; ++cpu) {
+			ccx.push_back({ cpu, cpu, cpu & ~3u, 0, randomx::MaxCpuCapacity });
+		}
+		assert(randomx::placeThreads(ccx, RANDOMX_PLACEMENT_ALL_CORES, 0) == std::vector<unsigned>({ 0, 4, 1, 5, 2, 6, 3, 7 }));
+		//the SMT siblings of a core are consecutive, the cores in the usual order
+		assert(randomx::placeThreads(hybrid, RANDOMX_PLACEMENT_SMT_PAIRS, 0) == std::vector<unsigned>({ 0, 1, 2, 3, 4, 5, 6, 7 }));
+		std::vector<randomx::LogicalCpu> smt;
+		for (unsigned cpu = 0; cpu < 8; ++cpu) {
+			smt.push_back({ cpu, cpu & 3, (cpu & 3) & ~1u, 0, randomx::MaxCpuCapacity });
+		}
+		assert(randomx::placeThreads(smt, RANDOMX_PLACEMENT_ALL_CORES, 0) == std::vector<unsigned>({ 0, 2, 1, 3, 4, 6, 5, 7 }));
+		assert(randomx::placeThreads(smt, RANDOMX_PLACEMENT_SMT_PAIRS, 6) == std::vector<unsigned>({ 0, 4, 2, 6, 1, 5 }));
+
+		auto topology = randomx::getCpuTopology();
+		assert(!topology.empty());
+		unsigned maxCapacity = 0;
+		for (auto& info : topology) {
+			assert(info.capacity <= randomx::MaxCpuCapacity);
+			maxCapacity = std::max(maxCapacity, info.capacity);
+		}
+		assert(maxCapacity == randomx::MaxCpuCapacity);
+		std::vector<unsigned> cpus(topology.size()), capacities(topology.size());
+		unsigned count = randomx_thread_placement(RANDOMX_PLACEMENT_ALL_CORES, 0, cpus.data(), capacities.data());
+		assert(count == topology.size());
+		assert(capacities[0] == randomx::MaxCpuCapacity);
+
+		//placed initialization of a few chunks gives the same items
+		initCache("test key 000");
+		const uint32_t itemCount = 3 * randomx::DatasetInitChunkSize + 8;
+		std::vector<uint8_t> expected(itemCount * randomx::CacheLineSize), items(itemCount * randomx::CacheLineSize);
+		cache->datasetInit(cache, expected.data(), 0, itemCount);
+		randomx::initDatasetParallel(cache, items.data(), 0, itemCount, randomx::placeThreads(topology, RANDOMX_PLACEMENT_ALL_CORES, 3));
+		assert(items == expected);
+	});
+
+	runTest("Epoch rekey", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key0[] = "test key 000";
+		const char key1[] = "test key 001";
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_epoch* epoch = randomx_create_epoch(RANDOMX_FLAG_DEFAULT, 1);
+		assert(epoch != nullptr);
+		assert(randomx_epoch_cache(epoch) == nullptr);
+		assert(!randomx_epoch_switch(epoch, 0));
+		assert(randomx_epoch_prepare(epoch, key0, sizeof(key0) - 1));
+		assert(randomx_epoch_switch(epoch, 1));
+		randomx_vm* epochVm = randomx_create_vm(RANDOMX_FLAG_DEFAULT, randomx_epoch_cache(epoch), nullptr);
+		assert(epochVm != nullptr);
+		randomx_epoch_sync_vm(epoch, epochVm);
+		assert(randomx_epoch_prepare(epoch, key1, sizeof(key1) - 1));
+		randomx_calculate_hash(epochVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		assert(randomx_epoch_switch(epoch, 1));
+		randomx_epoch_sync_vm(epoch, epochVm);
+		randomx_calculate_hash(epochVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		assert(randomx_epoch_prepare(epoch, key0, sizeof(key0) - 1));
+		assert(randomx_epoch_switch(epoch, 1));
+		randomx_epoch_sync_vm(epoch, epochVm);
+		randomx_calculate_hash(epochVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_epoch_detach_vm(epoch, epochVm);
+		randomx_destroy_vm(epochVm);
+		randomx_release_epoch(epoch);
+	});
+
+	runTest("Shared item cache", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx::SharedItemCache table(64 * 1024);
+		alignas(16) uint64_t item[8] = { 1, 2, 3, 4, 5, 6, 7, 8 }, copy[8];
+		assert(!table.lookup(12345, (uint8_t*)copy));
+		table.insert(12345, (const uint8_t*)item);
+		assert(table.lookup(12345, (uint8_t*)copy) && memcmp(item, copy, sizeof(item)) == 0);
+		table.invalidate();
+		assert(!table.lookup(12345, (uint8_t*)copy));
+		randomx_cache* sharedCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		assert(randomx_cache_set_item_cache(sharedCache, 16 * 1024 * 1024));
+		randomx_init_cache(sharedCache, "test key 000", 12);
+		randomx_vm* first = randomx_create_vm(RANDOMX_FLAG_DEFAULT, sharedCache, nullptr);
+		randomx_vm* second = randomx_create_vm(RANDOMX_FLAG_DEFAULT, sharedCache, nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		for (randomx_vm* vm : { first, second }) {
+			randomx_calculate_hash(vm, "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua", 65, hash);
+			assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		}
+		randomx_init_cache(sharedCache, "test key 001", 12);
+		randomx_vm_set_cache(second, sharedCache);
+		randomx_calculate_hash(second, "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua", 65, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		randomx_memory_info info;
+		randomx_get_memory_info(sharedCache, nullptr, nullptr, &info);
+		assert(info.itemTableBytes > 8 * 1024 * 1024 && info.itemTableBytes <= 16 * 1024 * 1024);
+		randomx_destroy_vm(first);
+		randomx_destroy_vm(second);
+		assert(randomx_cache_set_item_cache(sharedCache, 0));
+		randomx_release_cache(sharedCache);
+	});
+
+	runTest("Shared result cache", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		randomx_cache* sharedCache = randomx_alloc_cache(RANDOMX_FLAG_DEFAULT);
+		assert(randomx_cache_set_result_cache(sharedCache, 64 * 1024));
+		randomx_init_cache(sharedCache, "test key 000", 12);
+		randomx_vm* first = randomx_create_vm(RANDOMX_FLAG_DEFAULT, sharedCache, nullptr);
+		randomx_vm* second = randomx_create_vm(RANDOMX_FLAG_DEFAULT, sharedCache, nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_vm_stats stats;
+		randomx_calculate_hash(first, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		//the same input hashed by another VM or split into parts is a hit
+		const randomx_buffer parts[2] = { { input, 10 }, { input + 10, sizeof(input) - 11 } };
+		memset(hash, 0, sizeof(hash));
+		randomx_calculate_hash_parts(second, parts, 2, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_vm_get_stats(first, &stats);
+		assert(stats.resultCacheHits == 0 && stats.resultCacheMisses == 1);
+		randomx_vm_get_stats(second, &stats);
+		assert(stats.resultCacheHits == 1 && stats.resultCacheMisses == 0);
+		//a new key invalidates the results
+		randomx_init_cache(sharedCache, "test key 001", 12);
+		randomx_vm_set_cache(second, sharedCache);
+		randomx_calculate_hash(second, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		randomx_vm_get_stats(second, &stats);
+		assert(stats.resultCacheHits == 1 && stats.resultCacheMisses == 1);
+		randomx_memory_info info;
+		randomx_get_memory_info(sharedCache, nullptr, nullptr, &info);
+		assert(info.resultTableBytes > 32 * 1024 && info.resultTableBytes <= 64 * 1024);
+		randomx_destroy_vm(first);
+		randomx_destroy_vm(second);
+		assert(randomx_cache_set_result_cache(sharedCache, 0));
+		randomx_release_cache(sharedCache);
+	});
+
+	runTest("Lazy VM test", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		assert(randomx_create_vm_lazy(RANDOMX_FLAG_DEFAULT, cache, RANDOMX_DATASET_ITEM_SIZE - 1) == nullptr);
+		assert(randomx_create_vm_lazy(RANDOMX_FLAG_FULL_MEM, cache, 1024 * 1024) == nullptr);
+		randomx_vm* lazyVm = randomx_create_vm_lazy(RANDOMX_FLAG_DEFAULT, cache, 1024 * 1024);
+		assert(lazyVm != nullptr);
+		for (int i = 0; i < 2; ++i) {
+			randomx_calculate_hash(lazyVm, input, sizeof(input) - 1, hash);
+			assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		}
+		initCache("test key 001");
+		randomx_vm_set_cache(lazyVm, cache);
+		randomx_calculate_hash(lazyVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		randomx_destroy_vm(lazyVm);
+	});
+
+	runTest("Dataset item helper thread", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		randomx_vm* lightVm = randomx_create_vm(RANDOMX_FLAG_DEFAULT, cache, nullptr);
+		randomx_vm* lazyVm = randomx_create_vm_lazy(RANDOMX_FLAG_DEFAULT, cache, 64 * 1024);
+		assert(randomx_vm_enable_item_helper(lightVm, -1));
+		assert(randomx_vm_enable_item_helper(lazyVm, -1));
+		assert(randomx_vm_enable_item_helper(lightVm, -1));
+		for (int i = 0; i < 2; ++i) {
+			randomx_calculate_hash(lightVm, input, sizeof(input) - 1, hash);
+			assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+			randomx_calculate_hash(lazyVm, input, sizeof(input) - 1, hash);
+			assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		}
+		initCache("test key 001");
+		randomx_vm_set_cache(lightVm, cache);
+		randomx_calculate_hash(lightVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		randomx_destroy_vm(lightVm);
+		randomx_destroy_vm(lazyVm);
+	});
+
+	runTest("Autotune", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		const char path[] = "randomx-autotune-test.txt";
+		char hash[RANDOMX_HASH_SIZE];
+		remove(path);
+		initCache("test key 000");
+		randomx_tuning tuning, stored;
+		assert(randomx_autotune(cache, nullptr, 1, path, &tuning));
+		assert(!tuning.fromFile && tuning.hashSeconds > 0 && tuning.argon2Seconds > 0);
+		assert(!(tuning.flags & RANDOMX_FLAG_FULL_MEM));
+		randomx_vm* tunedVm = randomx_create_vm(tuning.flags, cache, nullptr);
+		assert(tunedVm != nullptr);
+		randomx_calculate_hash(tunedVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_destroy_vm(tunedVm);
+		//the second call reads the result
+		assert(randomx_autotune(cache, nullptr, 1, path, &stored));
+		assert(stored.fromFile && stored.flags == tuning.flags && stored.cpuSignature == tuning.cpuSignature);
+		remove(path);
+	});
+
+	runTest("Autotune with a result cache", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		assert(randomx_cache_set_result_cache(cache, 1024 * 1024));
+		randomx_tuning tuning;
+		assert(randomx_autotune(cache, nullptr, 1, nullptr, &tuning));
+		//a hash taken from the result cache takes well under a microsecond
+		assert(tuning.hashSeconds > 1e-4);
+		//the result cache is attached again after the measurement
+		randomx_vm* tunedVm = randomx_create_vm(tuning.flags, cache, nullptr);
+		assert(tunedVm != nullptr);
+		randomx_calculate_hash(tunedVm, input, sizeof(input) - 1, hash);
+		randomx_calculate_hash(tunedVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_vm_stats stats;
+		randomx_vm_get_stats(tunedVm, &stats);
+		assert(stats.resultCacheMisses == 1 && stats.resultCacheHits == 1);
+		randomx_destroy_vm(tunedVm);
+		assert(randomx_cache_set_result_cache(cache, 0));
+	});
+
+	runTest("Verifier pool", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char key0[] = "test key 000";
+		const char key1[] = "test key 001";
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		assert(randomx_create_verifier(RANDOMX_FLAG_DEFAULT, 0, 1) == nullptr);
+		randomx_verifier* verifier = randomx_create_verifier(RANDOMX_FLAG_DEFAULT, 1, 2);
+		assert(verifier != nullptr);
+		assert(randomx_verifier_prepare_key(verifier, key0, sizeof(key0) - 1));
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 3; ++t) {
+			threads.push_back(std::thread([&]() {
+				char hash[RANDOMX_HASH_SIZE];
+				assert(randomx_verifier_calculate_hash(verifier, key0, sizeof(key0) - 1, input, sizeof(input) - 1, hash));
+				assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+				assert(randomx_verifier_calculate_hash(verifier, key1, sizeof(key1) - 1, input, sizeof(input) - 1, hash));
+				assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+			}));
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		randomx_release_verifier(verifier);
+	});
+
+	runTest("Virtual machine statistics", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_cache* statsCache = randomx_alloc_cache(flags);
+		randomx_init_cache(statsCache, "test key 000", 12);
+		randomx_vm* statsVm = randomx_create_vm(flags, statsCache, nullptr);
+		randomx_vm_stats stats;
+		randomx_vm_get_stats(statsVm, &stats);
+		assert(stats.hashes == 0 && stats.programs == 0);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(statsVm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		if (randomx_vm_get_stats(statsVm, &stats)) {
+			assert(stats.hashes == 1 && stats.programs == RANDOMX_PROGRAM_COUNT);
+			assert(stats.seedCycles > 0 && stats.initScratchpadCycles > 0 && stats.generateProgramCycles > 0);
+			assert(stats.compileCycles > 0 && stats.executeCycles > 0 && stats.chainCycles > 0);
+			assert(stats.finalResultCycles > 0);
+		}
+		else {
+			assert(stats.hashes == 0 && stats.executeCycles == 0);
+		}
+		randomx_destroy_vm(statsVm);
+		randomx_release_cache(statsCache);
+	});
+
+	runTest("Virtual machine pool", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_cache* cache0 = randomx_alloc_cache(flags);
+		randomx_cache* cache1 = randomx_alloc_cache(flags);
+		randomx_init_cache(cache0, "test key 000", 12);
+		randomx_init_cache(cache1, "test key 001", 12);
+		assert(randomx_vm_pool_create(flags, cache0, nullptr, 0) == nullptr);
+		randomx_vm_pool* pool = randomx_vm_pool_create(flags, cache0, nullptr, 2);
+		assert(pool != nullptr);
+		randomx_vm* first = randomx_vm_pool_acquire(pool, 0);
+		randomx_vm* second = randomx_vm_pool_acquire(pool, 0);
+		assert(first != nullptr && second != nullptr && first != second);
+		assert(randomx_vm_pool_acquire(pool, 0) == nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(first, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_vm_pool_set_cache(pool, cache1);
+		randomx_vm_pool_release(pool, first);
+		randomx_vm* again = randomx_vm_pool_acquire(pool, 0);
+		assert(again == first);
+		randomx_calculate_hash(again, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+		std::thread waiter([&]() {
+			randomx_vm* vm = randomx_vm_pool_acquire(pool, 1);
+			char threadHash[RANDOMX_HASH_SIZE];
+			randomx_calculate_hash(vm, input, sizeof(input) - 1, threadHash);
+			assert(equalsHex(threadHash, "e9ff4503201c0c2cca26d285c93ae883f9b1d30c9eb240b820756f2d5a7905fc"));
+			randomx_vm_pool_release(pool, vm);
+		});
+		randomx_vm_pool_release(pool, second);
+		waiter.join();
+		randomx_vm_pool_release(pool, again);
+		randomx_vm_pool_destroy(pool);
+		randomx_release_cache(cache0);
+		randomx_release_cache(cache1);
+	});
+
+	runTest("Initialization progress and cancellation", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		struct Progress {
+			uint64_t calls, done, total;
+			uint64_t cancelAt;
+			randomx_cancel_token* token;
+		};
+		randomx_progress_callback* callback = [](void* userData, uint64_t done, uint64_t total) {
+			auto progress = (Progress*)userData;
+			assert(done > progress->done && done <= total);
+			progress->calls++;
+			progress->done = done;
+			progress->total = total;
+			if (progress->calls == progress->cancelAt)
+				randomx_cancel(progress->token);
+		};
+		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_cache* progressCache = randomx_alloc_cache(flags);
+		randomx_cancel_token* token = randomx_create_cancel_token();
+		assert(token != nullptr);
+		Progress progress = { 0, 0, 0, 2, token };
+		assert(randomx_init_cache_progress(progressCache, "test key 000", 12, callback, &progress, token) == 0);
+		assert(progress.calls == 2 && progress.done < progress.total);
+		randomx_destroy_cancel_token(token);
+		progress = { 0, 0, 0, 0, nullptr };
+		assert(randomx_init_cache_progress(progressCache, "test key 000", 12, callback, &progress, nullptr) == 1);
+		assert(progress.calls == RANDOMX_ARGON_ITERATIONS * RANDOMX_ARGON_LANES * 4 + 1 && progress.done == progress.total);
+		randomx_vm* progressVm = randomx_create_vm(flags, progressCache, nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(progressVm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_destroy_vm(progressVm);
+
+		const unsigned long itemCount = 40000;
+		randomx_dataset* dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		uint8_t* datasetMemory = (uint8_t*)randomx_get_dataset_memory(dataset);
+		randomx_init_dataset(dataset, progressCache, 100, itemCount);
+		std::vector<uint8_t> expected(datasetMemory + 100 * RANDOMX_DATASET_ITEM_SIZE, datasetMemory + (100 + itemCount) * RANDOMX_DATASET_ITEM_SIZE);
+		memset(datasetMemory, 0, (100 + itemCount) * RANDOMX_DATASET_ITEM_SIZE);
+		token = randomx_create_cancel_token();
+		progress = { 0, 0, 0, 1, token };
+		assert(randomx_init_dataset_progress(dataset, progressCache, 100, itemCount, callback, &progress, token) == 0);
+		assert(progress.calls == 1 && progress.done == 16384 && progress.total == itemCount);
+		randomx_destroy_cancel_token(token);
+		progress = { 0, 0, 0, 0, nullptr };
+		assert(randomx_init_dataset_progress(dataset, progressCache, 100, itemCount, callback, &progress, nullptr) == 1);
+		assert(progress.calls == 3 && progress.done == itemCount);
+		assert(memcmp(expected.data(), datasetMemory + 100 * RANDOMX_DATASET_ITEM_SIZE, expected.size()) == 0);
+		randomx_release_dataset(dataset);
+		randomx_release_cache(progressCache);
+	});
+
+	runTest("Static dispatch hasher", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx::CachePtr hasherCache = randomx::makeCache(RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT, "test key 000", 12);
+		randomx::Hasher<randomx::InterpretedLightVmDefault> interpreted(hasherCache.get());
+		randomx::Hasher<randomx::InterpretedLightVmDefault> hasher(std::move(interpreted));
+		char hash[RANDOMX_HASH_SIZE];
+		hasher.hash("This is a test", 14, hash);
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		const void* inputs[] = { "This is a test", "Lorem ipsum dolor sit amet" };
+		const size_t inputSizes[] = { 14, 26 };
+		char hashes[2 * RANDOMX_HASH_SIZE];
+		hasher.hashBatch(inputs, inputSizes, 2, hashes);
+		assert(equalsHex(hashes, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+		assert(equalsHex(hashes + RANDOMX_HASH_SIZE, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+#if RANDOMX_HAVE_COMPILER
+		randomx::Hasher<randomx::CompiledLightVmDefault> compiled(hasherCache.get());
+		compiled.hash("Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+#endif
+	});
+
+	runTest("Parameter set", true, []() {
+		randomx_parameters params;
+		randomx_get_parameters(&params);
+		assert(params.argonMemory == RANDOMX_ARGON_MEMORY && params.programSize == RANDOMX_PROGRAM_SIZE);
+		assert(params.datasetBaseSize == RANDOMX_DATASET_BASE_SIZE && params.scratchpadL3 == RANDOMX_SCRATCHPAD_L3);
+		assert(params.argonSaltSize == sizeof(RANDOMX_ARGON_SALT) - 1);
+		unsigned frequencySum = 0;
+		for (auto freq : params.instructionFrequencies)
+			frequencySum += freq;
+		assert(frequencySum == 256);
+		assert(randomx_parameters_supported(&params));
+		randomx_parameters other = params;
+		char salt[] = RANDOMX_ARGON_SALT;
+		other.argonSalt = salt;
+		assert(randomx_parameters_supported(&other));
+		salt[0] ^= 1;
+		assert(!randomx_parameters_supported(&other));
+		other = params;
+		other.programIterations /= 2;
+		assert(!randomx_parameters_supported(&other));
+		other = params;
+		other.instructionFrequencies[0]--;
+		other.instructionFrequencies[29]++;
+		assert(!randomx_parameters_supported(&other));
+	});
+
+	runTest("Memory information", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_memory_info info;
+		randomx_get_memory_info(nullptr, nullptr, nullptr, &info);
+		assert(info.cacheBytes == 0 && info.datasetBytes == 0 && info.scratchpadBytes == 0 && info.jitCodeBytes == 0);
+		assert(info.numaNode == -1 && info.cachePageSize != 0);
+		randomx_cache* infoCache = randomx_alloc_cache(flags);
+		randomx_init_cache(infoCache, "test key 000", 12);
+		randomx_vm* infoVm = randomx_create_vm(flags, infoCache, nullptr);
+		randomx_get_memory_info(infoCache, nullptr, infoVm, &info);
+		assert(info.cacheBytes == RANDOMX_ARGON_MEMORY * 1024);
+		assert(info.scratchpadBytes == RANDOMX_SCRATCHPAD_L3);
+		assert(info.cacheBacking == randomx_cache_page_backing(infoCache));
+		assert(info.scratchpadBacking == randomx_vm_page_backing(infoVm));
+		assert((info.jitCodeBytes != 0) == (RANDOMX_HAVE_COMPILER != 0));
+		assert(info.itemTableBytes == 0 && info.datasetCopies == 0);
+		randomx_destroy_vm(infoVm);
+		randomx_vm* lazyVm = randomx_create_vm_lazy(RANDOMX_FLAG_DEFAULT, infoCache, 1024 * 1024);
+		randomx_get_memory_info(nullptr, nullptr, lazyVm, &info);
+		assert(info.itemTableBytes >= 1024 * 1024 && info.jitCodeBytes == 0);
+		randomx_destroy_vm(lazyVm);
+		randomx_release_cache(infoCache);
+		randomx_dataset* infoDataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+		randomx_get_memory_info(nullptr, infoDataset, nullptr, &info);
+		assert(info.datasetBytes == (size_t)randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE);
+		assert(info.datasetCopies == 1 && info.datasetPageSize == randomx_dataset_page_size(infoDataset));
+		randomx_release_dataset(infoDataset);
+	});
+
+	runTest("Memory mode planner", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		const uint64_t breakEven = randomx_dataset_item_count() / (RANDOMX_PROGRAM_COUNT * RANDOMX_PROGRAM_ITERATIONS) + 1;
+		randomx_memory_plan plan;
+		randomx_plan_memory_mode(breakEven, 4, std::numeric_limits<size_t>::max(), &plan);
+		assert(plan.mode == RANDOMX_MODE_FULL && (plan.flags & RANDOMX_FLAG_FULL_MEM));
+		assert(plan.itemsPerKey == randomx_dataset_item_count() && plan.memoryBytes > randomx::DatasetSize);
+		assert(plan.initThreads >= 1);
+		randomx_plan_memory_mode(breakEven - 1, 4, std::numeric_limits<size_t>::max(), &plan);
+		assert(plan.mode != RANDOMX_MODE_FULL && !(plan.flags & RANDOMX_FLAG_FULL_MEM));
+		randomx_plan_memory_mode(breakEven * 100, 4, 1024 * 1024 * 1024, &plan);
+		assert(plan.mode != RANDOMX_MODE_FULL && plan.memoryBytes <= 1024 * 1024 * 1024);
+		assert(plan.mode == ((plan.flags & RANDOMX_FLAG_JIT) ? RANDOMX_MODE_LIGHT : RANDOMX_MODE_LAZY));
+		randomx_plan_memory_mode(10, 1, 512 * 1024 * 1024, &plan);
+		randomx_cache* planCache;
+		randomx_dataset* planDataset;
+		assert(randomx_plan_init(&plan, "test key 000", 12, &planCache, &planDataset));
+		assert(planDataset == nullptr);
+		randomx_vm* vm = randomx_plan_create_vm(&plan, planCache, planDataset);
+		assert(vm != nullptr);
+		char hash[RANDOMX_HASH_SIZE];
+		randomx_calculate_hash(vm, "Lorem ipsum dolor sit amet", 26, hash);
+		assert(equalsHex(hash, "300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969"));
+		randomx_destroy_vm(vm);
+		randomx_release_cache(planCache);
+	});
+
+	runTest("Nonce scheduler", true, []() {
+		assert(randomx_nonce_scheduler_create(0, 16) == nullptr);
+		const unsigned threadCount = 4;
+		const uint32_t firstNonce = 1000, nonceCount = 10007;
+		randomx_nonce_scheduler* scheduler = randomx_nonce_scheduler_create(threadCount, 16);
+		assert(scheduler != nullptr);
+		uint32_t nonce;
+		assert(randomx_nonce_scheduler_next(scheduler, 0, &nonce) == 0);
+		//a single thread gets all nonces by stealing the shares of the others
+		std::vector<uint8_t> seen(nonceCount);
+		randomx_nonce_scheduler_reset(scheduler, firstNonce, nonceCount);
+		while (randomx_nonce_scheduler_next(scheduler, 2, &nonce)) {
+			assert(nonce >= firstNonce && nonce < firstNonce + nonceCount && !seen[nonce - firstNonce]);
+			seen[nonce - firstNonce] = 1;
+		}
+		assert(std::count(seen.begin(), seen.end(), 1) == nonceCount);
+		std::vector<std::vector<uint32_t>> nonces(threadCount);
+		randomx_nonce_scheduler_reset(scheduler, firstNonce, nonceCount);
+		std::vector<std::thread> threads;
+		for (unsigned i = 0; i < threadCount; ++i) {
+			threads.emplace_back([&, i]() {
+				uint32_t threadNonce;
+				while (randomx_nonce_scheduler_next(scheduler, i, &threadNonce))
+					nonces[i].push_back(threadNonce);
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		std::fill(seen.begin(), seen.end(), 0);
+		for (auto& list : nonces) {
+			for (auto threadNonce : list) {
+				assert(!seen[threadNonce - firstNonce]);
+				seen[threadNonce - firstNonce] = 1;
+			}
+		}
+		assert(std::count(seen.begin(), seen.end(), 1) == nonceCount);
+		randomx_nonce_scheduler_destroy(scheduler);
+	});
+
+	runTest("Asynchronous hash engine", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		randomx_flags flags = RANDOMX_HAVE_COMPILER ? RANDOMX_FLAG_JIT : RANDOMX_FLAG_DEFAULT;
+		randomx_cache* engineCache = randomx_alloc_cache(flags);
+		randomx_init_cache(engineCache, "test key 000", 12);
+		assert(randomx_engine_create(flags, engineCache, nullptr, 0) == nullptr);
+		randomx_engine* engine = randomx_engine_create(flags, engineCache, nullptr, 2);
+		assert(engine != nullptr);
+		struct Expected {
+			char hash[RANDOMX_HASH_SIZE];
+			std::atomic<int>* completed;
+		};
+		std::atomic<int> completed(0);
+		Expected lorem, sed;
+		hex2bin((char*)"300a0adb47603dedb42228ccb2b211104f4da45af709cd7547cd049e9489c969", 2 * RANDOMX_HASH_SIZE, lorem.hash);
+		hex2bin((char*)"c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8", 2 * RANDOMX_HASH_SIZE, sed.hash);
+		lorem.completed = sed.completed = &completed;
+		randomx_hash_callback* callback = [](void* userData, const void* hash) {
+			auto expected = (Expected*)userData;
+			assert(memcmp(hash, expected->hash, RANDOMX_HASH_SIZE) == 0);
+			expected->completed->fetch_add(1);
+		};
+		const int requestsPerThread = 8;
+		std::vector<std::thread> producers;
+		for (int i = 0; i < 2; ++i) {
+			producers.emplace_back([&]() {
+				for (int j = 0; j < requestsPerThread; ++j) {
+					char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+					if (j % 2 == 0)
+						assert(randomx_engine_submit(engine, "Lorem ipsum dolor sit amet", 26, callback, &lorem) == 1);
+					else
+						assert(randomx_engine_submit(engine, input, sizeof(input) - 1, callback, &sed) == 1);
+					memset(input, 0, sizeof(input)); //the input is copied
+				}
+			});
+		}
+		for (auto& producer : producers)
+			producer.join();
+		randomx_engine_stats stats;
+		randomx_engine_get_stats(engine, &stats);
+		assert(stats.threadCount == 2 && stats.activeThreads == 2);
+		assert(randomx_engine_set_autoscale(engine, 1, 5));
+		for (int j = 0; j < 4 * requestsPerThread; ++j)
+			assert(randomx_engine_submit(engine, "Lorem ipsum dolor sit amet", 26, callback, &lorem) == 1);
+		randomx_engine_get_stats(engine, &stats);
+		assert(stats.activeThreads >= 1 && stats.activeThreads <= 2);
+		assert(randomx_engine_set_autoscale(engine, 2, 0));
+		randomx_engine_get_stats(engine, &stats);
+		assert(stats.activeThreads == 2 && stats.hashrate == 0);
+		randomx_engine_destroy(engine);
+		assert(completed == 6 * requestsPerThread);
+		randomx_release_cache(engineCache);
+	});
+
+	runTest("Engine thread autoscaling", true, []() {
+		//the hashrate grows up to knee threads and falls after that
+		unsigned knee = 5;
+		auto hashrate = [&](unsigned threads) {
+			return threads <= knee ? 100.0 * threads : 100.0 * knee - 30.0 * (threads - knee);
+		};
+		randomx::ThreadAutoscaler autoscaler(1, 12, 12);
+		auto run = [&](unsigned intervals) {
+			unsigned atKnee = 0;
+			for (unsigned i = 0; i < intervals; ++i) {
+				unsigned threads = autoscaler.update(hashrate(autoscaler.getThreads()), true);
+				assert(threads >= 1 && threads <= 12);
+				if (i >= intervals / 2 && threads == knee)
+					atKnee++;
+			}
+			return atKnee;
+		};
+		assert(run(200) > 70);
+		//other processes take bandwidth
+		knee = 3;
+		assert(run(200) > 70);
+		knee = 8;
+		assert(run(400) > 140);
+		//requests are the limit, a probe in progress is undone
+		autoscaler.update(10, false);
+		autoscaler.update(10, false);
+		unsigned threads = autoscaler.getThreads();
+		for (int i = 0; i < 20; ++i)
+			assert(autoscaler.update(10, false) == threads);
+	});
+
 	runTest("Commitment test", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
 		char hash[RANDOMX_HASH_SIZE];
 		calcStringCommitment("test key 000", "This is a test", &hash);
 		assert(equalsHex(hash, "d53ccf348b75291b7be76f0a7ac8208bbced734b912f6fca60539ab6f86be919"));
 	});
 
+	runTest("Commitment batch", true, []() {
+		constexpr size_t count = 13;
+		const size_t inputSizes[] = { 0, 76, 96, 100, 224, 300 };
+		uint8_t data[count][300];
+		uint8_t hashes[count][RANDOMX_HASH_SIZE];
+		uint8_t expected[count][RANDOMX_HASH_SIZE];
+		uint8_t output[count][RANDOMX_HASH_SIZE];
+		const void* inputs[count];
+		const void* hashPtrs[count];
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t j = 0; j < sizeof(data[i]); ++j)
+				data[i][j] = (uint8_t)(i * 31 + j);
+			for (size_t j = 0; j < RANDOMX_HASH_SIZE; ++j)
+				hashes[i][j] = (uint8_t)(i * 7 + j * 3);
+			inputs[i] = data[i];
+			hashPtrs[i] = hashes[i];
+		}
+		randomx::Cpu cpu;
+		blake2b_compress_multi* kernels[] = {
+			cpu.hasAvx2() ? blake2b_compress_4way_avx2() : nullptr,
+			cpu.hasAvx512f() ? blake2b_compress_8way_avx512() : nullptr
+		};
+		const unsigned lanes[] = { 4, 8 };
+		for (size_t inputSize : inputSizes) {
+			for (size_t i = 0; i < count; ++i) {
+				randomx_calculate_commitment(inputs[i], inputSize, hashes[i], expected[i]);
+			}
+			randomx_calculate_commitment_batch(inputs, inputSize, hashes, count, output);
+			assert(memcmp(output, expected, sizeof(output)) == 0);
+			for (int k = 0; k < 2; ++k) {
+				if (kernels[k] == nullptr)
+					continue;
+				memset(output, 0, sizeof(output));
+				blake2b_multi(output, RANDOMX_HASH_SIZE, inputs, inputSize, hashPtrs, RANDOMX_HASH_SIZE, count, kernels[k], lanes[k]);
+				assert(memcmp(output, expected, sizeof(output)) == 0);
+			}
+		}
+	});
+
+	runTest("Commitment Merkle tree", true, []() {
+		const size_t counts[] = { 1, 2, 3, 5, 8, 13, 256, 257, 600, 1000 };
+		const size_t pieces[] = { 1, 7, 100, 300 };
+		constexpr size_t maxCount = 1000;
+		std::vector<uint8_t> leaves(maxCount * RANDOMX_HASH_SIZE);
+		for (size_t i = 0; i < leaves.size(); ++i)
+			leaves[i] = (uint8_t)(i * 13 + i / 97);
+		randomx_merkle_builder* builder = randomx_merkle_builder_create();
+		assert(builder != nullptr);
+		uint8_t root[RANDOMX_HASH_SIZE];
+		assert(randomx_commitment_merkle_root(leaves.data(), 0, root, nullptr) == 0);
+		assert(randomx_merkle_builder_root(builder, root) == 0);
+		for (size_t count : counts) {
+			//scalar reference: pair the nodes of each level, the odd last node with itself
+			std::vector<uint8_t> level(leaves.begin(), leaves.begin() + count * RANDOMX_HASH_SIZE);
+			unsigned depth = 0;
+			while (level.size() > RANDOMX_HASH_SIZE) {
+				const size_t nodes = level.size() / RANDOMX_HASH_SIZE;
+				std::vector<uint8_t> next((nodes + 1) / 2 * RANDOMX_HASH_SIZE);
+				for (size_t i = 0; i < nodes; i += 2) {
+					uint8_t pair[2 * RANDOMX_HASH_SIZE];
+					memcpy(pair, &level[i * RANDOMX_HASH_SIZE], RANDOMX_HASH_SIZE);
+					memcpy(pair + RANDOMX_HASH_SIZE, &level[std::min(i + 1, nodes - 1) * RANDOMX_HASH_SIZE], RANDOMX_HASH_SIZE);
+					blake2b(&next[i / 2 * RANDOMX_HASH_SIZE], RANDOMX_HASH_SIZE, pair, sizeof(pair), nullptr, 0);
+				}
+				level.swap(next);
+				depth++;
+			}
+			assert(randomx_commitment_merkle_depth(count) == depth);
+			std::vector<uint8_t> paths(count * depth * RANDOMX_HASH_SIZE);
+			assert(randomx_commitment_merkle_root(leaves.data(), count, root, paths.data()) == 1);
+			assert(memcmp(root, level.data(), RANDOMX_HASH_SIZE) == 0);
+			for (size_t i = 0; i < count; ++i) {
+				const uint8_t* path = paths.data() + i * depth * RANDOMX_HASH_SIZE;
+				assert(randomx_commitment_merkle_verify(&leaves[i * RANDOMX_HASH_SIZE], i, count, path, root) == 1);
+				uint8_t forged[RANDOMX_HASH_SIZE];
+				memcpy(forged, &leaves[i * RANDOMX_HASH_SIZE], sizeof(forged));
+				forged[0] ^= 1;
+				assert(randomx_commitment_merkle_verify(forged, i, count, path, root) == 0);
+			}
+			for (size_t piece : pieces) {
+				randomx_merkle_builder_reset(builder);
+				for (size_t done = 0; done < count; done += piece)
+					randomx_merkle_builder_add(builder, &leaves[done * RANDOMX_HASH_SIZE], std::min(piece, count - done));
+				memset(root, 0, sizeof(root));
+				assert(randomx_merkle_builder_root(builder, root) == 1);
+				assert(memcmp(root, level.data(), RANDOMX_HASH_SIZE) == 0);
+			}
+		}
+		randomx_merkle_builder_destroy(builder);
+	});
+
+	runTest("Hash and commitment", stringsEqual(RANDOMX_ARGON_SALT, "RandomX\x03"), []() {
+		char hash[RANDOMX_HASH_SIZE];
+		char commitment[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		const char input[] = "This is a test";
+		randomx_calculate_hash_and_commitment(vm, input, sizeof(input) - 1, &hash, &commitment);
+		assert(equalsHex(commitment, "d53ccf348b75291b7be76f0a7ac8208bbced734b912f6fca60539ab6f86be919"));
+		assert(equalsHex(hash, "639183aae1bf4c9a35884cb46b09cad9175f04efd7684e7262a0ac1c2f0b4e3f"));
+
+		//inputs shorter and longer than one Blake2b block, the last one also checks aliased outputs
+		constexpr size_t count = 3;
+		const size_t inputSizes[count] = { 0, 76, 300 };
+		uint8_t data[count][300];
+		const void* inputs[count];
+		uint8_t expectedHashes[count][RANDOMX_HASH_SIZE], expectedCommitments[count][RANDOMX_HASH_SIZE];
+		uint8_t hashes[count][RANDOMX_HASH_SIZE], commitments[count][RANDOMX_HASH_SIZE];
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t j = 0; j < sizeof(data[i]); ++j)
+				data[i][j] = (uint8_t)(i * 31 + j);
+			inputs[i] = data[i];
+			randomx_calculate_hash(vm, inputs[i], inputSizes[i], expectedHashes[i]);
+			randomx_calculate_commitment(inputs[i], inputSizes[i], expectedHashes[i], expectedCommitments[i]);
+		}
+		randomx_calculate_hash_and_commitment_batch(vm, inputs, inputSizes, count, hashes, commitments);
+		assert(memcmp(hashes, expectedHashes, sizeof(hashes)) == 0);
+		assert(memcmp(commitments, expectedCommitments, sizeof(commitments)) == 0);
+		randomx_calculate_hash_and_commitment_batch(vm, inputs, inputSizes, count, commitments, commitments);
+		assert(memcmp(commitments, expectedCommitments, sizeof(commitments)) == 0);
+	});
+
+	runTest("Nonce search", true, []() {
+		constexpr uint32_t count = 4;
+		constexpr uint32_t nonceStart = 0xfffffffe; //the range wraps around
+		constexpr size_t nonceOffset = 39;
+		uint8_t blockTemplate[76];
+		for (size_t i = 0; i < sizeof(blockTemplate); ++i)
+			blockTemplate[i] = (uint8_t)(i * 7);
+		uint8_t hashes[count][RANDOMX_HASH_SIZE];
+		for (uint32_t i = 0; i < count; ++i) {
+			store32(blockTemplate + nonceOffset, nonceStart + i);
+			randomx_calculate_hash(vm, blockTemplate, sizeof(blockTemplate), hashes[i]);
+		}
+		uint32_t results[count];
+		uint8_t target[RANDOMX_HASH_SIZE];
+
+		memset(target, 0xff, sizeof(target));
+		assert(randomx_search(vm, blockTemplate, sizeof(blockTemplate), nonceOffset, nonceStart, count, target, results) == count);
+		for (uint32_t i = 0; i < count; ++i)
+			assert(results[i] == nonceStart + i);
+		assert(load32(blockTemplate + nonceOffset) == nonceStart + count - 1);
+
+		memset(target, 0, sizeof(target));
+		assert(randomx_search(vm, blockTemplate, sizeof(blockTemplate), nonceOffset, nonceStart, count, target, results) == 0);
+
+		//a target equal to the hash of the third nonce matches only the lower hashes and itself
+		memcpy(target, hashes[2], sizeof(target));
+		size_t expected = 0;
+		uint32_t expectedNonces[count];
+		for (uint32_t i = 0; i < count; ++i) {
+			int cmp = 0;
+			for (int j = RANDOMX_HASH_SIZE - 1; j >= 0 && cmp == 0; --j)
+				cmp = (int)hashes[i][j] - (int)target[j];
+			if (cmp <= 0)
+				expectedNonces[expected++] = nonceStart + i;
+		}
+		assert(randomx_search(vm, blockTemplate, sizeof(blockTemplate), nonceOffset, nonceStart, count, target, results) == expected);
+		assert(memcmp(results, expectedNonces, expected * sizeof(uint32_t)) == 0);
+	});
+
+	runTest("Input template", true, []() {
+		constexpr uint32_t count = 3;
+		constexpr uint32_t nonceStart = 1000;
+		uint8_t input[300];
+		for (size_t i = 0; i < sizeof(input); ++i)
+			input[i] = (uint8_t)(i * 13);
+		assert(randomx_create_input_template(input, sizeof(input), sizeof(input) - 3) == nullptr);
+		//the nonce in the first block, at a block boundary and in the last block
+		const size_t nonceOffsets[] = { 0, 256, sizeof(input) - 4 };
+		for (size_t nonceOffset : nonceOffsets) {
+			uint8_t expected[count][RANDOMX_HASH_SIZE];
+			uint8_t hashes[count][RANDOMX_HASH_SIZE];
+			uint8_t copy[sizeof(input)];
+			memcpy(copy, input, sizeof(input));
+			for (uint32_t i = 0; i < count; ++i) {
+				store32(copy + nonceOffset, nonceStart + i);
+				randomx_calculate_hash(vm, copy, sizeof(copy), expected[i]);
+			}
+			randomx_input_template* inputTemplate = randomx_create_input_template(input, sizeof(input), nonceOffset);
+			assert(inputTemplate != nullptr);
+			randomx_calculate_hash_template_batch(vm, inputTemplate, nonceStart, count, hashes);
+			assert(memcmp(hashes, expected, sizeof(hashes)) == 0);
+			uint32_t results[count];
+			uint8_t target[RANDOMX_HASH_SIZE];
+			memset(target, 0xff, sizeof(target));
+			assert(randomx_search_template(vm, inputTemplate, nonceStart, count, target, results) == count);
+			assert(results[0] == nonceStart && results[count - 1] == nonceStart + count - 1);
+			randomx_destroy_input_template(inputTemplate);
+		}
+	});
+
+	runTest("VAES generators and hash", HAVE_AES && aesVaesCompiled() && randomx::Cpu().hasVaes(), []() {
+		constexpr size_t bufferSize = 64 * 1024;
+		std::vector<uint8_t> expected(bufferSize), output(bufferSize);
+		alignas(16) uint8_t stateExpected[64], stateOutput[64];
+		alignas(16) uint8_t hashExpected[64], hashOutput[64];
+		for (size_t i = 0; i < sizeof(stateExpected); ++i)
+			stateExpected[i] = stateOutput[i] = (uint8_t)(i * 13 + 5);
+		fillAes1Rx4<false>(stateExpected, bufferSize, expected.data());
+		fillAes1Rx4Vaes(stateOutput, bufferSize, output.data());
+		assert(expected == output);
+		assert(memcmp(stateExpected, stateOutput, sizeof(stateExpected)) == 0);
+		fillAes4Rx4<false>(stateExpected, bufferSize, expected.data());
+		fillAes4Rx4Vaes(stateOutput, bufferSize, output.data());
+		assert(expected == output);
+		hashAes1Rx4<false>(expected.data(), bufferSize, hashExpected);
+		hashAes1Rx4Vaes(output.data(), bufferSize, hashOutput);
+		assert(memcmp(hashExpected, hashOutput, sizeof(hashExpected)) == 0);
+		hashAndFillAes1Rx4<false>(expected.data(), bufferSize, hashExpected, stateExpected);
+		hashAndFillAes1Rx4Vaes(output.data(), bufferSize, hashOutput, stateOutput);
+		assert(expected == output);
+		assert(memcmp(stateExpected, stateOutput, sizeof(stateExpected)) == 0);
+		assert(memcmp(hashExpected, hashOutput, sizeof(hashExpected)) == 0);
+
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		assert(randomx_create_vm(RANDOMX_FLAG_VAES, cache, nullptr) == nullptr);
+		randomx_vm* vaesVm = randomx_create_vm(RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_VAES, cache, nullptr);
+		assert(vaesVm != nullptr);
+		randomx_calculate_hash(vaesVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_destroy_vm(vaesVm);
+	});
+
+#if defined(__aarch64__)
+	const bool hasAesVperm = aesVpermCompiled();
+#else
+	const bool hasAesVperm = aesVpermCompiled() && randomx::Cpu().hasSsse3();
+#endif
+
+	runTest("Vector permute soft AES", hasAesVperm, []() {
+		constexpr size_t bufferSize = 64 * 1024;
+		std::vector<uint8_t> expected(bufferSize), output(bufferSize);
+		alignas(16) uint8_t stateExpected[64], stateOutput[64];
+		alignas(16) uint8_t hashExpected[64], hashOutput[64];
+		for (size_t i = 0; i < sizeof(stateExpected); ++i)
+			stateExpected[i] = stateOutput[i] = (uint8_t)(i * 29 + 3);
+		fillAes1Rx4<true>(stateExpected, bufferSize, expected.data());
+		fillAes1Rx4Vperm(stateOutput, bufferSize, output.data());
+		assert(expected == output);
+		assert(memcmp(stateExpected, stateOutput, sizeof(stateExpected)) == 0);
+		fillAes4Rx4<true>(stateExpected, bufferSize, expected.data());
+		fillAes4Rx4Vperm(stateOutput, bufferSize, output.data());
+		assert(expected == output);
+		hashAes1Rx4<true>(expected.data(), bufferSize, hashExpected);
+		hashAes1Rx4Vperm(output.data(), bufferSize, hashOutput);
+		assert(memcmp(hashExpected, hashOutput, sizeof(hashExpected)) == 0);
+		hashAndFillAes1Rx4<true>(expected.data(), bufferSize, hashExpected, stateExpected);
+		hashAndFillAes1Rx4Vperm(output.data(), bufferSize, hashOutput, stateOutput);
+		assert(expected == output);
+		assert(memcmp(stateExpected, stateOutput, sizeof(stateExpected)) == 0);
+		assert(memcmp(hashExpected, hashOutput, sizeof(hashExpected)) == 0);
+
+		const char input[] = "sed do eiusmod tempor incididunt ut labore et dolore magna aliqua";
+		char hash[RANDOMX_HASH_SIZE];
+		initCache("test key 000");
+		assert(randomx_create_vm(RANDOMX_FLAG_HARD_AES | RANDOMX_FLAG_AES_VPERM, cache, nullptr) == nullptr);
+		randomx_vm* vpermVm = randomx_create_vm(RANDOMX_FLAG_AES_VPERM, cache, nullptr);
+		assert(vpermVm != nullptr);
+		randomx_calculate_hash(vpermVm, input, sizeof(input) - 1, hash);
+		assert(equalsHex(hash, "c36d4ed4191e617309867ed66a443be4075014e2b061bcdaf9ce7b721d2b77a8"));
+		randomx_destroy_vm(vpermVm);
+	});
+
 	randomx_destroy_vm(vm);
 	vm = nullptr;
 
@@ -115,6 +115,14 @@ inline void readFloatOption(const char* option, int argc, char** argv, double& o
 	out = defaultValue;
 }
 
+inline const char* readStringOption(const char* option, int argc, char** argv) {
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (strcmp(argv[i], option) == 0)
+			return argv[i + 1];
+	}
+	return nullptr;
+}
+
 inline void readInt(int argc, char** argv, int& out, int defaultValue) {
 	for (int i = 0; i < argc; ++i) {
 		if (*argv[i] != '-' && (out = atoi(argv[i])) > 0) {
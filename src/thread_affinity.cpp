@@ -0,0 +1,292 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#include <windows.h>
+#else
+#ifdef __APPLE__
+#include <mach/thread_act.h>
+#include <mach/thread_policy.h>
+#endif
+#include <pthread.h>
+#include <sys/resource.h>
+#endif
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include "thread_affinity.hpp"
+
+namespace randomx {
+
+	bool setThreadAffinity(unsigned cpu) {
+#if defined(__APPLE__)
+		thread_affinity_policy_data_t policy = { static_cast<integer_t>(cpu) };
+		thread_port_t machThread = pthread_mach_thread_np(pthread_self());
+		return thread_policy_set(machThread, THREAD_AFFINITY_POLICY, (thread_policy_t)&policy, 1) == KERN_SUCCESS;
+#elif defined(_WIN32) || defined(__CYGWIN__)
+		return SetThreadAffinityMask(GetCurrentThread(), 1ULL << cpu) != 0;
+#elif !defined(__OpenBSD__) && !defined(__FreeBSD__) && !defined(__ANDROID__) && !defined(__NetBSD__)
+		cpu_set_t cs;
+		CPU_ZERO(&cs);
+		CPU_SET(cpu, &cs);
+		return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cs) == 0;
+#else
+		return false;
+#endif
+	}
+
+	unsigned cpuFromMask(uint64_t mask, unsigned index) {
+		unsigned count = 0;
+		for (uint64_t m = mask; m != 0; m &= m - 1) {
+			++count;
+		}
+		index %= count;
+		for (unsigned cpu = 0; cpu < 64; ++cpu) {
+			if ((mask >> cpu) & 1) {
+				if (index == 0)
+					return cpu;
+				--index;
+			}
+		}
+		return 0;
+	}
+
+	bool setThreadLowPriority() {
+#if defined(_WIN32) || defined(__CYGWIN__)
+		return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL) != 0;
+#elif defined(__linux__)
+		//on Linux, the nice value is per thread and is inherited by threads created later
+		return setpriority(PRIO_PROCESS, 0, 10) == 0;
+#else
+		return false;
+#endif
+	}
+
+#if defined(__linux__)
+	//parses lists like "0-3,8,10-11" used by sysfs
+	static std::vector<unsigned> readSysfsList(const std::string& path) {
+		std::vector<unsigned> list;
+		std::ifstream file(path);
+		std::string item;
+		while (std::getline(file, item, ',')) {
+			unsigned first, last;
+			char dash;
+			std::istringstream range(item);
+			if (!(range >> first))
+				break;
+			last = first;
+			if (range >> dash >> last && dash != '-')
+				break;
+			for (unsigned i = first; i <= last; ++i) {
+				list.push_back(i);
+			}
+		}
+		return list;
+	}
+
+	//the online nodes can have gaps, e.g. "0,2" when a node has no memory
+	static std::vector<unsigned> getNumaNodeIds() {
+		auto nodes = readSysfsList("/sys/devices/system/node/online");
+		if (nodes.size() > MaxNumaNodes)
+			nodes.resize(MaxNumaNodes);
+		return nodes;
+	}
+#endif
+
+	unsigned getNumaNodeCount() {
+		unsigned count = 1;
+#if defined(__linux__)
+		auto nodes = getNumaNodeIds();
+		if (!nodes.empty()) {
+			count = (unsigned)nodes.size();
+		}
+#elif defined(_WIN32) || defined(__CYGWIN__)
+		ULONG highestNode;
+		if (GetNumaHighestNodeNumber(&highestNode)) {
+			count = highestNode + 1;
+		}
+#endif
+		return count < MaxNumaNodes ? count : MaxNumaNodes;
+	}
+
+	unsigned getNumaNodeId(unsigned node) {
+#if defined(__linux__)
+		auto nodes = getNumaNodeIds();
+		if (node < nodes.size())
+			return nodes[node];
+#endif
+		return node;
+	}
+
+	std::vector<unsigned> getNumaNodeCpus(unsigned node) {
+		std::vector<unsigned> cpus;
+#if defined(__linux__)
+		auto nodes = getNumaNodeIds();
+		if (node < nodes.size())
+			cpus = readSysfsList("/sys/devices/system/node/node" + std::to_string(nodes[node]) + "/cpulist");
+#elif defined(_WIN32) || defined(__CYGWIN__)
+		ULONGLONG mask;
+		if (GetNumaNodeProcessorMask((UCHAR)node, &mask)) {
+			for (unsigned cpu = 0; cpu < 64; ++cpu) {
+				if ((mask >> cpu) & 1)
+					cpus.push_back(cpu);
+			}
+		}
+#endif
+		return cpus;
+	}
+
+#if defined(__linux__)
+	static unsigned readSysfsNumber(const std::string& path, unsigned defaultValue) {
+		std::ifstream file(path);
+		unsigned value;
+		if (file >> value)
+			return value;
+		return defaultValue;
+	}
+#endif
+
+	std::vector<LogicalCpu> getCpuTopology() {
+		std::vector<LogicalCpu> topology;
+#if defined(__linux__)
+		const std::string sysfs = "/sys/devices/system/cpu/cpu";
+		//Intel hybrid CPUs list the E-cores here, their capacity is an estimate
+		//unless the kernel reports cpu_capacity
+		auto atomCpus = readSysfsList("/sys/devices/cpu_atom/cpus");
+		unsigned maxFrequency = 0;
+		std::vector<unsigned> frequencies;
+		for (unsigned cpu : readSysfsList("/sys/devices/system/cpu/online")) {
+			const std::string dir = sysfs + std::to_string(cpu);
+			LogicalCpu info = { cpu, cpu, 0, 0, 0 };
+			auto siblings = readSysfsList(dir + "/topology/thread_siblings_list");
+			if (!siblings.empty())
+				info.core = siblings.front();
+			unsigned cacheLevel = 0;
+			for (unsigned index = 0;; ++index) {
+				const std::string cache = dir + "/cache/index" + std::to_string(index);
+				unsigned level = readSysfsNumber(cache + "/level", 0);
+				if (level == 0)
+					break;
+				auto shared = readSysfsList(cache + "/shared_cpu_list");
+				if (level > cacheLevel && !shared.empty()) {
+					cacheLevel = level;
+					info.cacheDomain = shared.front();
+				}
+			}
+			info.capacity = readSysfsNumber(dir + "/cpu_capacity", 0);
+			if (info.capacity == 0 && std::find(atomCpus.begin(), atomCpus.end(), cpu) != atomCpus.end())
+				info.capacity = MaxCpuCapacity / 2;
+			frequencies.push_back(readSysfsNumber(dir + "/cpufreq/cpuinfo_max_freq", 0));
+			maxFrequency = std::max(maxFrequency, frequencies.back());
+			topology.push_back(info);
+		}
+		unsigned maxCapacity = 0;
+		for (size_t i = 0; i < topology.size(); ++i) {
+			//without other information, assume that the capacity scales with the maximum frequency
+			if (topology[i].capacity == 0)
+				topology[i].capacity = maxFrequency != 0 && frequencies[i] != 0 ? (unsigned)((uint64_t)MaxCpuCapacity * frequencies[i] / maxFrequency) : MaxCpuCapacity;
+			maxCapacity = std::max(maxCapacity, topology[i].capacity);
+		}
+		for (auto& info : topology) {
+			info.capacity = (unsigned)((uint64_t)info.capacity * MaxCpuCapacity / maxCapacity);
+		}
+		for (unsigned node = 0; node < getNumaNodeCount(); ++node) {
+			for (unsigned cpu : getNumaNodeCpus(node)) {
+				for (auto& info : topology) {
+					if (info.cpu == cpu)
+						info.node = node;
+				}
+			}
+		}
+#endif
+		if (topology.empty()) {
+			unsigned count = std::max(std::thread::hardware_concurrency(), 1u);
+			for (unsigned cpu = 0; cpu < count; ++cpu) {
+				topology.push_back({ cpu, cpu, 0, 0, MaxCpuCapacity });
+			}
+		}
+		return topology;
+	}
+
+	std::vector<unsigned> placeThreads(const std::vector<LogicalCpu>& topology, randomx_placement policy, unsigned threadCount) {
+		std::vector<unsigned> cpus;
+		if (policy == RANDOMX_PLACEMENT_NONE || topology.empty())
+			return cpus;
+		struct Candidate {
+			unsigned cpu, core, capacity, smtRank, domainRank;
+		};
+		std::vector<Candidate> candidates;
+		unsigned maxCapacity = 0;
+		for (auto& info : topology) {
+			maxCapacity = std::max(maxCapacity, info.capacity);
+		}
+		for (auto& info : topology) {
+			if (policy == RANDOMX_PLACEMENT_FAST_CORES && info.capacity < maxCapacity)
+				continue;
+			//the n-th SMT sibling of its core and the core is the n-th of its cache domain
+			unsigned smtRank = 0, domainRank = 0;
+			for (auto& other : topology) {
+				if (other.cpu < info.cpu && other.core == info.core)
+					smtRank++;
+				if (other.cpu < info.core && other.core == other.cpu && other.cacheDomain == info.cacheDomain && other.node == info.node)
+					domainRank++;
+			}
+			candidates.push_back({ info.cpu, info.core, info.capacity, smtRank, domainRank });
+		}
+		//one thread per physical core before SMT siblings, faster cores first, consecutive
+		//threads on different cache domains to spread the memory traffic
+		std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+			if (a.smtRank != b.smtRank)
+				return a.smtRank < b.smtRank;
+			if (a.capacity != b.capacity)
+				return a.capacity > b.capacity;
+			return a.domainRank < b.domainRank;
+		});
+		if (policy == RANDOMX_PLACEMENT_SMT_PAIRS) {
+			//the siblings follow the first thread of their core
+			std::vector<Candidate> paired;
+			for (auto& first : candidates) {
+				if (first.smtRank != 0)
+					break;
+				for (auto& sibling : candidates) {
+					if (sibling.core == first.core)
+						paired.push_back(sibling);
+				}
+			}
+			candidates.swap(paired);
+		}
+		if (threadCount == 0)
+			threadCount = (unsigned)candidates.size();
+		for (unsigned i = 0; i < threadCount; ++i) {
+			cpus.push_back(candidates[i % candidates.size()].cpu);
+		}
+		return cpus;
+	}
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "common.hpp"
+#include "randomx.h"
+
+namespace randomx {
+
+	//Pins the calling thread to the CPU with the given index. Returns false if not supported or on failure.
+	bool setThreadAffinity(unsigned cpu);
+
+	//Returns the index of the (index mod N)-th set bit of mask, where N is the number of set bits. Mask must not be zero.
+	unsigned cpuFromMask(uint64_t mask, unsigned index);
+
+	//Lowers the scheduling priority of the calling thread. Returns false if not supported or on failure.
+	bool setThreadLowPriority();
+
+	//Returns the number of NUMA nodes (at most MaxNumaNodes). Returns 1 if NUMA is not supported.
+	//The nodes are indexed from 0 to count - 1, also if the node IDs of the OS have gaps.
+	unsigned getNumaNodeCount();
+
+	//Returns the OS ID of the NUMA node with the given index (for bindMemoryToNode and setAllocationNode).
+	unsigned getNumaNodeId(unsigned node);
+
+	//Returns the CPUs of the NUMA node with the given index. Returns an empty list if the node doesn't exist or NUMA is not supported.
+	std::vector<unsigned> getNumaNodeCpus(unsigned node);
+
+	constexpr unsigned MaxCpuCapacity = 1024;
+
+	struct LogicalCpu {
+		unsigned cpu;         //OS index
+		unsigned core;        //lowest OS index of the SMT siblings sharing the physical core
+		unsigned cacheDomain; //lowest OS index of the CPUs sharing the last level cache (L3, CCX)
+		unsigned node;        //NUMA node
+		unsigned capacity;    //relative performance, MaxCpuCapacity for the fastest cores
+	};
+
+	//Returns the online logical CPUs in the order of their OS indices. Where the topology
+	//is unknown, each CPU is a separate core with MaxCpuCapacity in a single cache domain.
+	std::vector<LogicalCpu> getCpuTopology();
+
+	//Returns the CPUs for threadCount threads (0 selects the number of CPUs covered
+	//by the policy) in the order the threads should be pinned to them.
+	std::vector<unsigned> placeThreads(const std::vector<LogicalCpu>& topology, randomx_placement policy, unsigned threadCount);
+}
@@ -0,0 +1,45 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+/* Static tracepoints of the "randomx" USDT provider at the boundaries of cache and dataset
+   initialization, virtual machine lifetime and hash calculation, for use with eBPF tools
+   such as bpftrace. They are compiled in only if RANDOMX_TRACEPOINTS is defined, which
+   requires sys/sdt.h. Each enabled probe is a single NOP until a tracer attaches to it. */
+
+#if defined(RANDOMX_TRACEPOINTS)
+#include <sys/sdt.h>
+#define RANDOMX_TRACE1(name, a) DTRACE_PROBE1(randomx, name, a)
+#define RANDOMX_TRACE2(name, a, b) DTRACE_PROBE2(randomx, name, a, b)
+#define RANDOMX_TRACE3(name, a, b, c) DTRACE_PROBE3(randomx, name, a, b, c)
+#else
+#define RANDOMX_TRACE1(name, a)
+#define RANDOMX_TRACE2(name, a, b)
+#define RANDOMX_TRACE3(name, a, b, c)
+#endif
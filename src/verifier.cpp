@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "verifier.hpp"
+
+randomx_verifier::randomx_verifier(randomx_flags flags, unsigned cacheCount, unsigned vmsPerCache)
+	: flags((randomx_flags)(flags & ~RANDOMX_FLAG_FULL_MEM)), vmsPerCache(vmsPerCache), entries(cacheCount) {
+}
+
+randomx_verifier::~randomx_verifier() {
+	for (auto& entry : entries) {
+		for (auto vm : entry.idleVms) {
+			randomx_destroy_vm(vm);
+		}
+		if (entry.cache != nullptr) {
+			randomx_release_cache(entry.cache);
+		}
+	}
+}
+
+//Returns the entry with the given key. If there is none, the least recently used entry without
+//users is reinitialized with the key. Returns nullptr if the cache cannot be allocated.
+randomx_verifier::Entry* randomx_verifier::acquireEntry(const std::string& key, std::unique_lock<std::mutex>& lock) {
+	for (;;) {
+		Entry* found = nullptr;
+		Entry* victim = nullptr;
+		for (auto& entry : entries) {
+			if ((entry.ready || entry.initializing) && entry.key == key) {
+				found = &entry;
+				break;
+			}
+			if (!entry.initializing && entry.users == 0 && (victim == nullptr || entry.lastUse < victim->lastUse)) {
+				victim = &entry;
+			}
+		}
+		if (found != nullptr && found->ready) {
+			found->lastUse = ++useCounter;
+			return found;
+		}
+		if (found != nullptr || victim == nullptr) {
+			//another thread is initializing the key or all entries are in use
+			changed.wait(lock);
+			continue;
+		}
+		victim->key = key;
+		victim->ready = false;
+		victim->initializing = true;
+		victim->lastUse = ++useCounter;
+		lock.unlock();
+		if (victim->cache == nullptr) {
+			victim->cache = randomx_alloc_cache(flags);
+		}
+		if (victim->cache != nullptr) {
+			randomx_init_cache(victim->cache, key.data(), key.size());
+			for (auto vm : victim->idleVms) {
+				randomx_vm_set_cache(vm, victim->cache);
+			}
+		}
+		lock.lock();
+		victim->initializing = false;
+		victim->ready = victim->cache != nullptr;
+		changed.notify_all();
+		if (!victim->ready) {
+			return nullptr;
+		}
+	}
+}
+
+//Returns an idle virtual machine of the entry, creating one if the limit allows it.
+//Returns nullptr if the virtual machine cannot be created.
+randomx_vm* randomx_verifier::acquireVm(Entry* entry, std::unique_lock<std::mutex>& lock) {
+	entry->users++; //prevents reinitialization while waiting
+	while (entry->idleVms.empty() && entry->vmCount >= vmsPerCache) {
+		changed.wait(lock);
+	}
+	if (!entry->idleVms.empty()) {
+		randomx_vm* vm = entry->idleVms.back();
+		entry->idleVms.pop_back();
+		return vm;
+	}
+	entry->vmCount++;
+	lock.unlock();
+	randomx_vm* vm = randomx_create_vm(flags, entry->cache, nullptr);
+	lock.lock();
+	if (vm == nullptr) {
+		entry->vmCount--;
+		entry->users--;
+		changed.notify_all();
+	}
+	return vm;
+}
+
+void randomx_verifier::releaseVm(Entry* entry, randomx_vm* vm) {
+	std::lock_guard<std::mutex> lock(mutex);
+	entry->idleVms.push_back(vm);
+	entry->users--;
+	changed.notify_all();
+}
+
+bool randomx_verifier::prepareKey(const void* key, size_t keySize) {
+	std::unique_lock<std::mutex> lock(mutex);
+	return acquireEntry(std::string((const char*)key, keySize), lock) != nullptr;
+}
+
+bool randomx_verifier::calculateHash(const void* key, size_t keySize, const void* input, size_t inputSize, void* output) {
+	Entry* entry;
+	randomx_vm* vm;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		entry = acquireEntry(std::string((const char*)key, keySize), lock);
+		if (entry == nullptr)
+			return false;
+		vm = acquireVm(entry, lock);
+		if (vm == nullptr)
+			return false;
+	}
+	randomx_calculate_hash(vm, input, inputSize, output);
+	releaseVm(entry, vm);
+	return true;
+}
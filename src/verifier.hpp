@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "randomx.h"
+
+/* Global scope for C binding */
+class randomx_verifier {
+public:
+	randomx_verifier(randomx_flags flags, unsigned cacheCount, unsigned vmsPerCache);
+	~randomx_verifier();
+	bool prepareKey(const void* key, size_t keySize);
+	bool calculateHash(const void* key, size_t keySize, const void* input, size_t inputSize, void* output);
+private:
+	struct Entry {
+		std::string key;
+		randomx_cache* cache = nullptr;
+		std::vector<randomx_vm*> idleVms;
+		unsigned vmCount = 0;  //number of virtual machines created for the entry
+		unsigned users = 0;    //number of threads using or waiting for a virtual machine
+		bool initializing = false;
+		bool ready = false;    //the cache is initialized with the key
+		uint64_t lastUse = 0;
+	};
+	Entry* acquireEntry(const std::string& key, std::unique_lock<std::mutex>& lock);
+	randomx_vm* acquireVm(Entry* entry, std::unique_lock<std::mutex>& lock);
+	void releaseVm(Entry* entry, randomx_vm* vm);
+	randomx_flags flags;
+	unsigned vmsPerCache;
+	uint64_t useCounter = 0;
+	std::vector<Entry> entries;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
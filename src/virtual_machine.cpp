@@ -35,6 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "blake2/blake2.h"
 #include "intrin_portable.h"
 #include "allocator.hpp"
+#include "scratchpad_arena.hpp"
 
 randomx_vm::~randomx_vm() {
 
@@ -99,7 +100,12 @@ namespace randomx {
 
 	template<class Allocator, bool softAes>
 	VmBase<Allocator, softAes>::~VmBase() {
-		Allocator::freeMemory(scratchpad, ScratchpadSize);
+		if (arena != nullptr)
+			return;
+		if (pageBacking == RANDOMX_PAGES_CUSTOM)
+			CustomAllocator<RANDOMX_MEMORY_SCRATCHPAD>::freeMemory(scratchpad, ScratchpadSize);
+		else
+			Allocator::freeMemory(scratchpad, ScratchpadSize);
 	}
 
 	template<class Allocator, bool softAes>
@@ -111,29 +117,71 @@ namespace randomx {
 			tmp = rx_aesenc_vec_i128(tmp, tmp);
 			rx_store_vec_i128((rx_vec_i128*)&aesDummy, tmp);
 		}
-		scratchpad = (uint8_t*)Allocator::allocMemory(ScratchpadSize);
+		if (arena != nullptr) {
+			scratchpad = arena->getScratchpad(arenaSlot);
+			pageBacking = arena->getPageBacking();
+		}
+		else if (hasCustomAllocator()) {
+			scratchpad = (uint8_t*)CustomAllocator<RANDOMX_MEMORY_SCRATCHPAD>::allocMemory(ScratchpadSize, &pageBacking);
+		}
+		else {
+			scratchpad = (uint8_t*)Allocator::allocMemory(ScratchpadSize, &pageBacking);
+		}
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::getFinalResult(void* out, size_t outSize) {
-		hashAes1Rx4<softAes>(scratchpad, ScratchpadSize, &reg.a);
+		RANDOMX_STATS_PHASE(this, finalResult);
+		RANDOMX_STATS_COUNT(this, hashes, 1);
+		hashScratchpad();
 		blake2b(out, outSize, &reg, sizeof(RegisterFile), nullptr, 0);
 	}
 
+	template<class Allocator, bool softAes>
+	void VmBase<Allocator, softAes>::hashScratchpad() {
+		if (!softAes && vaes)
+			hashAes1Rx4Vaes(scratchpad, ScratchpadSize, &reg.a);
+		else if (softAes && aesVperm)
+			hashAes1Rx4Vperm(scratchpad, ScratchpadSize, &reg.a);
+		else
+			hashAes1Rx4<softAes>(scratchpad, ScratchpadSize, &reg.a);
+	}
+
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::hashAndFill(void* out, size_t outSize, uint64_t *fill_state) {
-		hashAndFillAes1Rx4<softAes>((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
+		//the scratchpad fill for the next hash is counted as part of the final result
+		RANDOMX_STATS_PHASE(this, finalResult);
+		RANDOMX_STATS_COUNT(this, hashes, 1);
+		if (!softAes && vaes)
+			hashAndFillAes1Rx4Vaes((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
+		else if (softAes && aesVperm)
+			hashAndFillAes1Rx4Vperm((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
+		else
+			hashAndFillAes1Rx4<softAes>((void*) getScratchpad(), ScratchpadSize, &reg.a, fill_state);
 		blake2b(out, outSize, &reg, sizeof(RegisterFile), nullptr, 0);
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::initScratchpad(void* seed) {
-		fillAes1Rx4<softAes>(seed, ScratchpadSize, scratchpad);
+		RANDOMX_STATS_PHASE(this, initScratchpad);
+		if (!softAes && vaes)
+			fillAes1Rx4Vaes(seed, ScratchpadSize, scratchpad);
+		else if (softAes && aesVperm)
+			fillAes1Rx4Vperm(seed, ScratchpadSize, scratchpad);
+		else
+			fillAes1Rx4<softAes>(seed, ScratchpadSize, scratchpad);
 	}
 
 	template<class Allocator, bool softAes>
 	void VmBase<Allocator, softAes>::generateProgram(void* seed) {
-		fillAes4Rx4<softAes>(seed, sizeof(program), &program);
+		RANDOMX_STATS_PHASE(this, generateProgram);
+		RANDOMX_STATS_COUNT(this, programs, 1);
+		if (!softAes && vaes)
+			fillAes4Rx4Vaes(seed, sizeof(program), &program);
+		else if (softAes && aesVperm)
+			fillAes4Rx4Vperm(seed, sizeof(program), &program);
+		else
+			fillAes4Rx4<softAes>(seed, sizeof(program), &program);
 	}
 
 	template class VmBase<AlignedAllocator<CacheLineSize>, false>;
@@ -31,6 +31,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstdint>
 #include "common.hpp"
 #include "program.hpp"
+#include "vm_stats.hpp"
+#include "blake2/blake2.h"
 
 /* Global namespace for C binding */
 class randomx_vm {
@@ -38,12 +40,33 @@ public:
 	virtual ~randomx_vm() = 0;
 	virtual void allocate() = 0;
 	virtual void getFinalResult(void* out, size_t outSize) = 0;
+	virtual void hashScratchpad() = 0;
 	virtual void hashAndFill(void* out, size_t outSize, uint64_t *fill_state) = 0;
 	virtual void setDataset(randomx_dataset* dataset) { }
 	virtual void setCache(randomx_cache* cache) { }
+	virtual void setPrefetchMode(bool datasetT0, bool scratchpadNextLine) { }
+	virtual void setScheduling(bool enabled) { }
+	virtual void setBranchAlignment(bool enabled) { }
+	virtual bool enableSharedCode() { return false; }
+	virtual bool enableItemHelper(int cpu) { return false; }
 	virtual void initScratchpad(void* seed) = 0;
 	virtual void run(void* seed) = 0;
-	void resetRoundingMode();
+	virtual void runLanes() {
+		run(tempHash);
+	}
+	virtual int getLaneCount() const {
+		return 1;
+	}
+	virtual randomx_vm* getLane(int index) {
+		return this;
+	}
+	virtual size_t getCodeSize() {
+		return 0;
+	}
+	virtual size_t getItemTableSize() const {
+		return 0;
+	}
+	virtual void resetRoundingMode();
 	randomx::RegisterFile *getRegisterFile() {
 		return &reg;
 	}
@@ -71,7 +94,18 @@ protected:
 	uint64_t datasetOffset;
 public:
 	std::string cacheKey;
+	randomx_cache* lightCache = nullptr; //the cache of a light-mode VM, provides the result table
+	int numaNode = -1;
+	int epochSlot = -1;
+	uint32_t epochGeneration = 0;
+	bool vaes = false;
+	bool aesVperm = false;
+	randomx_scratchpad_arena* arena = nullptr; //the scratchpad and this object are stored in the arena
+	int arenaSlot = -1;
+	randomx_page_backing pageBacking = RANDOMX_PAGES_STANDARD; //of the scratchpad
+	randomx_vm_stats stats = {};
 	alignas(16) uint64_t tempHash[8]; //8 64-bit values used to store intermediate data
+	blake2b_state commitmentState; //input of the pending hash absorbed for its commitment
 };
 
 namespace randomx {
@@ -83,6 +117,7 @@ namespace randomx {
 		void allocate() override;
 		void initScratchpad(void* seed) override;
 		void getFinalResult(void* out, size_t outSize) override;
+		void hashScratchpad() override;
 		void hashAndFill(void* out, size_t outSize, uint64_t *fill_state) override;
 	protected:
 		void generateProgram(void* seed);
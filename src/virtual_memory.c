@@ -43,7 +43,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <stdio.h>
+#include <string.h>
+#endif
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
@@ -53,7 +61,42 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PAGE_EXECUTE_READWRITE (PROT_READ | PROT_WRITE | PROT_EXEC)
 #endif
 
+#include <stdint.h>
 #include "virtual_memory.h"
+#include "randomx.h"
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/* NUMA node preferred by the allocations of the calling thread, -1 for none */
+static THREAD_LOCAL int allocationNode = -1;
+/* outcome of the last large page allocation of the calling thread */
+static THREAD_LOCAL randomx_large_pages_result largePagesResult = RANDOMX_LARGE_PAGES_NOT_TRIED;
+static THREAD_LOCAL int largePagesError = 0;
+
+static void setLargePagesStatus(randomx_large_pages_result result, int error) {
+	largePagesResult = result;
+	largePagesError = error;
+}
+
+int getLargePagesStatus(int* systemError) {
+	if (systemError != NULL)
+		*systemError = largePagesError;
+	return largePagesResult;
+}
+
+int getAllocationNode(void) {
+	return allocationNode;
+}
+
+int setAllocationNode(int node) {
+	int previous = allocationNode;
+	allocationNode = node;
+	return previous;
+}
 
 #if defined(USE_PTHREAD_JIT_WP) && defined(MAC_OS_VERSION_11_0) \
 	&& MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_VERSION_11_0
@@ -122,14 +165,87 @@ out:
 	}
 	return error;
 }
+
+/* Records why a large page allocation failed */
+static void failLargePages(DWORD error) {
+	switch (error) {
+		case ERROR_NOT_ALL_ASSIGNED:     /* the account doesn't have SeLockMemoryPrivilege */
+		case ERROR_PRIVILEGE_NOT_HELD:
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_NO_PRIVILEGE, error);
+			break;
+		case ERROR_NO_SYSTEM_RESOURCES:  /* not enough contiguous physical memory */
+		case ERROR_NOT_ENOUGH_MEMORY:
+		case ERROR_COMMITMENT_LIMIT:
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_NO_MEMORY, error);
+			break;
+		default:
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_ERROR, error);
+	}
+}
+
+static int enableLockMemoryPrivilege(void) {
+	char *errfunc;
+	DWORD error = setPrivilege("SeLockMemoryPrivilege", 1, &errfunc);
+	if (error) {
+		failLargePages(error);
+		return 0;
+	}
+	return 1;
+}
+
+/* Reserves and commits memory on the preferred node of the calling thread, if any */
+static void* virtualAllocNode(size_t bytes, DWORD type) {
+	if (allocationNode >= 0)
+		return VirtualAllocExNuma(GetCurrentProcess(), NULL, bytes, type | MEM_RESERVE, PAGE_READWRITE, (DWORD)allocationNode);
+	return VirtualAlloc(NULL, bytes, type, PAGE_READWRITE);
+}
 #else
 #define Fail(func)	do  {*errfunc = func; return errno;} while(0)
 #endif
 
+#if defined(__linux__)
+/* Returns the number of pages of a huge page pool in sysfs, -1 if the page size isn't supported */
+static long readHugePagesCount(const char* pool) {
+	char path[128];
+	long count = -1;
+	FILE* file;
+	snprintf(path, sizeof(path), "/sys/kernel/mm/hugepages/%s/nr_hugepages", pool);
+	file = fopen(path, "r");
+	if (file != NULL) {
+		if (fscanf(file, "%ld", &count) != 1)
+			count = -1;
+		fclose(file);
+	}
+	return count;
+}
+
+/* Records why mmap of huge pages from the given pool failed */
+static void failHugePages(int error, const char* pool) {
+	if (error == EPERM || error == EACCES) {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_NO_PRIVILEGE, error);
+	}
+	else if (error == ENOMEM) {
+		long count = readHugePagesCount(pool);
+		if (count < 0)
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, error);
+		else if (count == 0)
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_NOT_RESERVED, error);
+		else
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_NO_MEMORY, error);
+	}
+	else if (error == EINVAL) {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, error);
+	}
+	else {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_ERROR, error);
+	}
+}
+#endif
+
 void* allocMemoryPages(size_t bytes) {
 	void* mem;
 #if defined(_WIN32) || defined(__CYGWIN__)
-	mem = VirtualAlloc(NULL, bytes, MEM_COMMIT, PAGE_READWRITE);
+	mem = virtualAllocNode(bytes, MEM_COMMIT);
 #else
 	#if defined(__NetBSD__)
 		#define RESERVED_FLAGS PROT_MPROTECT(PROT_EXEC)
@@ -198,23 +314,44 @@ void setPagesRX(void* ptr, size_t bytes) {
 #endif
 }
 
+/* Toggles the write protection of MAP_JIT memory for the calling thread without a system call
+ * and without flushing the instruction cache. Returns 1 on success or 0 if the platform has no
+ * per-thread JIT write protection, in which case the caller must change the page protection. */
+int setJitWriteProtect(int enable) {
+#if defined(USE_PTHREAD_JIT_WP) && defined(MAC_OS_VERSION_11_0) \
+	&& MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_VERSION_11_0
+	if (__builtin_available(macOS 11.0, *)) {
+		pthread_jit_write_protect_np(enable);
+		return 1;
+	}
+#endif
+	(void)enable;
+	return 0;
+}
+
 void setPagesRWX(void* ptr, size_t bytes) {
 	char *errfunc;
 	pageProtect(ptr, bytes, PAGE_EXECUTE_READWRITE, &errfunc);
 }
 
+/* Allocates reserved large pages, on the preferred node of the calling thread on Windows.
+ * The reason of a failure is available from getLargePagesStatus. */
 void* allocLargePagesMemory(size_t bytes) {
 	void* mem;
-	char *errfunc;
 #if defined(_WIN32) || defined(__CYGWIN__)
-	if (setPrivilege("SeLockMemoryPrivilege", 1, &errfunc))
+	size_t pageMinimum;
+	if (!enableLockMemoryPrivilege())
 		return NULL;
-	size_t pageMinimum = GetLargePageMinimum();
+	pageMinimum = GetLargePageMinimum();
 	if (!pageMinimum) {
-		errfunc = "No large pages";
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, 0);
 		return NULL;
 	}
-	mem = VirtualAlloc(NULL, alignSize(bytes, pageMinimum), MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+	mem = virtualAllocNode(alignSize(bytes, pageMinimum), MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES);
+	if (mem == NULL)
+		failLargePages(GetLastError());
+	else
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_OK, 0);
 #else
 #ifdef __APPLE__
 	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
@@ -222,11 +359,23 @@ void* allocLargePagesMemory(size_t bytes) {
 	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_ALIGNED_SUPER, -1, 0);
 #elif defined(__OpenBSD__) || defined(__NetBSD__)
 	mem = MAP_FAILED; // OpenBSD does not support huge pages
+	errno = EINVAL;
 #else
 	mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
 #endif
-	if (mem == MAP_FAILED)
+	if (mem == MAP_FAILED) {
+#if defined(__linux__)
+		char pool[64];
+		snprintf(pool, sizeof(pool), "hugepages-%lukB", (unsigned long)(getLargePageSize() / 1024));
+		failHugePages(errno, pool);
+#else
+		setLargePagesStatus(errno == EINVAL ? RANDOMX_LARGE_PAGES_UNSUPPORTED : RANDOMX_LARGE_PAGES_ERROR, errno);
+#endif
 		mem = NULL;
+	}
+	else {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_OK, 0);
+	}
 #endif
 	return mem;
 }
@@ -238,3 +387,416 @@ void freePagedMemory(void* ptr, size_t bytes) {
 	munmap(ptr, bytes);
 #endif
 }
+
+/* Allocates standard pages aligned to 2 MiB and asks the kernel to back them with transparent
+ * huge pages. This needs no reserved huge pages, but the kernel may still use standard pages.
+ * Returns NULL if transparent huge pages are not supported or disabled. */
+void* allocTransparentHugePagesMemory(size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	const size_t align = (size_t)2 << 20;
+	size_t reserveBytes, mappedBytes;
+	uint8_t* reserve;
+	uint8_t* mem;
+	char mode[64];
+	FILE* enabled = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+	if (enabled == NULL)
+		return NULL;
+	mode[0] = 0;
+	if (fgets(mode, sizeof(mode), enabled) == NULL || strstr(mode, "[never]") != NULL) {
+		fclose(enabled);
+		return NULL;
+	}
+	fclose(enabled);
+	mappedBytes = alignSize(bytes, getPageSize());
+	reserveBytes = mappedBytes + align;
+	reserve = (uint8_t*)mmap(NULL, reserveBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (reserve == MAP_FAILED)
+		return NULL;
+	mem = (uint8_t*)alignSize((uintptr_t)reserve, align);
+	if (mem != reserve)
+		munmap(reserve, mem - reserve);
+	munmap(mem + mappedBytes, reserve + reserveBytes - (mem + mappedBytes));
+	if (madvise(mem, bytes, MADV_HUGEPAGE) != 0) {
+		munmap(mem, bytes);
+		return NULL;
+	}
+	return mem;
+#else
+	return NULL;
+#endif
+}
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+#define GIGA_PAGE_SIZE ((size_t)1 << 30)
+#define GIGA_PAGE_TAIL_SIZE ((size_t)2 << 20)
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+/* Allocates whole 1 GiB pages for as much of the memory as possible. The rest (e.g. the last
+ * 32 MiB of the dataset) uses 2 MiB pages, or standard pages if there are no free 2 MiB pages,
+ * so the memory doesn't have to be rounded up to the next 1 GiB.
+ * On Windows, the pages are allocated with VirtualAlloc2 (Windows 10 1803 and newer) on the
+ * preferred node of the calling thread and the size is rounded up to the large page size.
+ * Returns NULL if 1 GiB pages are not available, see getLargePagesStatus for the reason. */
+void* allocGigaPagesMemory(size_t bytes) {
+#if (defined(_WIN32) || defined(__CYGWIN__)) && defined(MEM_EXTENDED_PARAMETER_NONPAGED_HUGE)
+	typedef PVOID (WINAPI *VirtualAlloc2Func)(HANDLE, PVOID, SIZE_T, ULONG, ULONG, MEM_EXTENDED_PARAMETER*, ULONG);
+	HMODULE kernelbase = GetModuleHandleA("kernelbase.dll");
+	VirtualAlloc2Func virtualAlloc2 = kernelbase != NULL ? (VirtualAlloc2Func)(void*)GetProcAddress(kernelbase, "VirtualAlloc2") : NULL;
+	MEM_EXTENDED_PARAMETER params[2];
+	ULONG paramCount = 1;
+	size_t pageMinimum;
+	void* mem;
+	if (virtualAlloc2 == NULL || (pageMinimum = GetLargePageMinimum()) == 0) {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, 0);
+		return NULL;
+	}
+	if (!enableLockMemoryPrivilege())
+		return NULL;
+	ZeroMemory(params, sizeof(params));
+	params[0].Type = MemExtendedParameterAttributeFlags;
+	params[0].ULong64 = MEM_EXTENDED_PARAMETER_NONPAGED_HUGE;
+	if (allocationNode >= 0) {
+		params[1].Type = MemExtendedParameterNumaNode;
+		params[1].ULong = (DWORD)allocationNode;
+		paramCount = 2;
+	}
+	mem = virtualAlloc2(GetCurrentProcess(), NULL, alignSize(bytes, pageMinimum), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, params, paramCount);
+	if (mem == NULL)
+		failLargePages(GetLastError());
+	else
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_OK, 0);
+	return mem;
+#elif defined(__linux__) && defined(MAP_HUGETLB)
+	size_t headBytes = bytes / GIGA_PAGE_SIZE * GIGA_PAGE_SIZE;
+	size_t tailBytes = bytes - headBytes;
+	size_t reserveBytes;
+	uint8_t* reserve;
+	uint8_t* mem;
+	if (headBytes == 0) {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, 0);
+		return NULL;
+	}
+	if (tailBytes != 0)
+		tailBytes = alignSize(tailBytes, GIGA_PAGE_TAIL_SIZE);
+	/* reserve address space so the mapping can be aligned to 1 GiB */
+	reserveBytes = headBytes + tailBytes + GIGA_PAGE_SIZE;
+	reserve = (uint8_t*)mmap(NULL, reserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (reserve == MAP_FAILED) {
+		setLargePagesStatus(RANDOMX_LARGE_PAGES_ERROR, errno);
+		return NULL;
+	}
+	mem = (uint8_t*)alignSize((uintptr_t)reserve, GIGA_PAGE_SIZE);
+	if (mmap(mem, headBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB | MAP_HUGE_1GB | MAP_POPULATE, -1, 0) == MAP_FAILED) {
+		failHugePages(errno, "hugepages-1048576kB");
+		munmap(reserve, reserveBytes);
+		return NULL;
+	}
+	if (tailBytes != 0) {
+		if (mmap(mem + headBytes, tailBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB | MAP_HUGE_2MB | MAP_POPULATE, -1, 0) == MAP_FAILED &&
+			mmap(mem + headBytes, tailBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+			setLargePagesStatus(RANDOMX_LARGE_PAGES_ERROR, errno);
+			munmap(reserve, reserveBytes);
+			return NULL;
+		}
+	}
+	if (mem != reserve)
+		munmap(reserve, mem - reserve);
+	if (reserve + reserveBytes != mem + headBytes + tailBytes)
+		munmap(mem + headBytes + tailBytes, reserve + reserveBytes - (mem + headBytes + tailBytes));
+	setLargePagesStatus(RANDOMX_LARGE_PAGES_OK, 0);
+	return mem;
+#else
+	setLargePagesStatus(RANDOMX_LARGE_PAGES_UNSUPPORTED, 0);
+	return NULL;
+#endif
+}
+
+void freeGigaPagesMemory(void* ptr, size_t bytes) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	(void)bytes;
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(__linux__) && defined(MAP_HUGETLB)
+	size_t headBytes = bytes / GIGA_PAGE_SIZE * GIGA_PAGE_SIZE;
+	size_t tailBytes = bytes - headBytes;
+	if (tailBytes != 0)
+		tailBytes = alignSize(tailBytes, GIGA_PAGE_TAIL_SIZE);
+	munmap(ptr, headBytes + tailBytes);
+#endif
+}
+
+size_t getPageSize(void) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/* The size of the pages allocated by allocLargePagesMemory */
+#if defined(__linux__)
+/* Returns the value of a /proc/meminfo line matching format or 0 if there is no such line */
+static size_t readMeminfo(const char* format) {
+	size_t value = 0;
+	char line[128];
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo != NULL) {
+		while (fgets(line, sizeof(line), meminfo) != NULL) {
+			unsigned long number;
+			if (sscanf(line, format, &number) == 1) {
+				value = number;
+				break;
+			}
+		}
+		fclose(meminfo);
+	}
+	return value;
+}
+#endif
+
+size_t getLargePageSize(void) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	return GetLargePageMinimum();
+#elif defined(__linux__)
+	size_t size = readMeminfo("Hugepagesize: %lu kB") * 1024;
+	return size != 0 ? size : (size_t)2 << 20;
+#else
+	return (size_t)2 << 20;
+#endif
+}
+
+/* Physical memory that can be allocated without swapping, 0 if unknown */
+size_t getAvailableMemory(void) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status))
+		return 0;
+	return status.ullAvailPhys > SIZE_MAX ? SIZE_MAX : (size_t)status.ullAvailPhys;
+#elif defined(__linux__)
+	size_t kiB = readMeminfo("MemAvailable: %lu kB");
+	return kiB > SIZE_MAX / 1024 ? SIZE_MAX : kiB * 1024;
+#else
+	return 0;
+#endif
+}
+
+/* Memory in reserved large pages that are not in use, 0 if unknown */
+size_t getFreeLargePagesMemory(void) {
+#if defined(__linux__)
+	return readMeminfo("HugePages_Free: %lu") * getLargePageSize();
+#else
+	return 0;
+#endif
+}
+
+#if (defined(_WIN32) || defined(__CYGWIN__)) && !defined(FILE_MAP_LARGE_PAGES)
+#define FILE_MAP_LARGE_PAGES 0x20000000
+#endif
+
+static void* dualMapPages(size_t bytes, void** execView, int largePages) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE mapping;
+	ULARGE_INTEGER size;
+	DWORD protect = PAGE_EXECUTE_READWRITE | SEC_COMMIT;
+	DWORD largeAccess = 0;
+	char *errfunc;
+	if (largePages) {
+		if (setPrivilege("SeLockMemoryPrivilege", 1, &errfunc))
+			return NULL;
+		protect |= SEC_LARGE_PAGES;
+		largeAccess = FILE_MAP_LARGE_PAGES;
+	}
+	size.QuadPart = bytes;
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, protect, size.HighPart, size.LowPart, NULL);
+	if (mapping == NULL)
+		return NULL;
+	mem = MapViewOfFile(mapping, FILE_MAP_WRITE | largeAccess, 0, 0, bytes);
+	*execView = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_EXECUTE | largeAccess, 0, 0, bytes);
+	CloseHandle(mapping); /* the views keep the mapping alive */
+	if (mem == NULL || *execView == NULL) {
+		if (mem != NULL)
+			UnmapViewOfFile(mem);
+		if (*execView != NULL)
+			UnmapViewOfFile(*execView);
+		return NULL;
+	}
+#elif (defined(__linux__) && defined(SYS_memfd_create)) || defined(__FreeBSD__)
+	int fd;
+#if defined(__linux__)
+	const unsigned mfdCloexec = 1, mfdHugetlb = 4, mfdExec = 0x10; /* MFD_CLOEXEC, MFD_HUGETLB, MFD_EXEC */
+	const unsigned mfdFlags = mfdCloexec | (largePages ? mfdHugetlb : 0);
+	fd = syscall(SYS_memfd_create, "randomx-jit", mfdFlags | mfdExec);
+	if (fd < 0 && errno == EINVAL) /* kernels older than 6.3 don't know MFD_EXEC */
+		fd = syscall(SYS_memfd_create, "randomx-jit", mfdFlags);
+#else
+	if (largePages)
+		return NULL;
+	fd = shm_open(SHM_ANON, O_RDWR | O_CLOEXEC, 0600);
+#endif
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, bytes) != 0) {
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, bytes, PAGE_READWRITE, MAP_SHARED, fd, 0);
+	*execView = mmap(NULL, bytes, PAGE_EXECUTE_READ, MAP_SHARED, fd, 0);
+	close(fd); /* the mappings keep the file alive */
+	if (mem == MAP_FAILED || *execView == MAP_FAILED) {
+		if (mem != MAP_FAILED)
+			munmap(mem, bytes);
+		if (*execView != MAP_FAILED)
+			munmap(*execView, bytes);
+		return NULL;
+	}
+#else
+	/* macOS already switches MAP_JIT pages per thread without a system call */
+	(void)bytes;
+	(void)execView;
+	(void)largePages;
+	mem = NULL;
+#endif
+	return mem;
+}
+
+/* Maps the same pages twice: the returned view is writable and *execView is
+ * executable, so JIT code can be rewritten without changing page protection.
+ * Returns NULL when the platform cannot provide such a mapping. */
+void* allocDualMappedPages(size_t bytes, void** execView) {
+	return dualMapPages(bytes, execView, 0);
+}
+
+/* Like allocDualMappedPages, but the pages are reserved large pages. bytes must be
+ * a multiple of the large page size. Returns NULL if no large pages are available. */
+void* allocDualMappedLargePages(size_t bytes, void** execView) {
+	return dualMapPages(bytes, execView, 1);
+}
+
+void freeDualMappedPages(void* ptr, void* execView, size_t bytes) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	UnmapViewOfFile(ptr);
+	UnmapViewOfFile(execView);
+#else
+	munmap(ptr, bytes);
+	munmap(execView, bytes);
+#endif
+}
+
+void* mapFileMemory(const char* path, size_t bytes, int writable) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE file, mapping;
+	LARGE_INTEGER size;
+	file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, NULL,
+		writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	if (!writable && (!GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart != bytes)) {
+		CloseHandle(file);
+		return NULL;
+	}
+	size.QuadPart = bytes;
+	mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, size.HighPart, size.LowPart, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+		return NULL;
+	mem = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, bytes);
+	CloseHandle(mapping);
+#else
+	struct stat st;
+	int fd = open(path, writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+	if (fd < 0)
+		return NULL;
+	if (writable ? ftruncate(fd, bytes) != 0 : (fstat(fd, &st) != 0 || (size_t)st.st_size != bytes)) {
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, bytes, writable ? PAGE_READWRITE : PAGE_READONLY, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		mem = NULL;
+#endif
+	return mem;
+}
+
+void unmapFileMemory(void* ptr, size_t bytes) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	UnmapViewOfFile(ptr);
+#else
+	munmap(ptr, bytes);
+#endif
+}
+
+void* mapSharedMemory(const char* name, size_t bytes, int create) {
+	void* mem;
+#if defined(_WIN32) || defined(__CYGWIN__)
+	HANDLE mapping;
+	MEMORY_BASIC_INFORMATION info;
+	ULARGE_INTEGER size;
+	size.QuadPart = bytes;
+	if (create)
+		mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, name);
+	else
+		mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (mapping == NULL)
+		return NULL;
+	mem = MapViewOfFile(mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, create ? bytes : 0);
+	CloseHandle(mapping); /* the view keeps the mapping alive */
+	if (mem != NULL && !create && (VirtualQuery(mem, &info, sizeof(info)) == 0 || info.RegionSize < bytes)) {
+		UnmapViewOfFile(mem);
+		mem = NULL;
+	}
+#else
+	struct stat st;
+	int fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+	if (fd < 0)
+		return NULL;
+	if (create ? ftruncate(fd, bytes) != 0 : (fstat(fd, &st) != 0 || (size_t)st.st_size != bytes)) {
+		close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, bytes, create ? PAGE_READWRITE : PAGE_READONLY, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED)
+		mem = NULL;
+#endif
+	return mem;
+}
+
+int removeSharedMemory(const char* name) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+	/* the mapping is destroyed when the last process unmaps it */
+	return 1;
+#else
+	return shm_unlink(name) == 0;
+#endif
+}
+
+int bindMemoryToNode(void* ptr, size_t bytes, unsigned node) {
+#if defined(__linux__) && defined(SYS_mbind)
+	const int mpolBind = 2;            /* MPOL_BIND */
+	const unsigned mpolMoveFlag = 2;   /* MPOL_MF_MOVE */
+	unsigned long nodeMask[4] = { 0 };
+	uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)ptr + pageSize - 1) & ~(pageSize - 1); /* only whole pages can be bound */
+	uintptr_t end = ((uintptr_t)ptr + bytes) & ~(pageSize - 1);
+	if (node >= sizeof(nodeMask) * 8 || end <= start)
+		return 0;
+	nodeMask[node / (sizeof(unsigned long) * 8)] = 1UL << (node % (sizeof(unsigned long) * 8));
+	return syscall(SYS_mbind, (void*)start, end - start, mpolBind, nodeMask, sizeof(nodeMask) * 8, mpolMoveFlag) == 0;
+#else
+	return 0;
+#endif
+}
@@ -40,8 +40,27 @@ void* allocMemoryPages(size_t);
 void setPagesRW(void*, size_t);
 void setPagesRX(void*, size_t);
 void setPagesRWX(void*, size_t);
+int setJitWriteProtect(int);
 void* allocLargePagesMemory(size_t);
+void* allocTransparentHugePagesMemory(size_t);
 void freePagedMemory(void*, size_t);
+void* allocGigaPagesMemory(size_t);
+void freeGigaPagesMemory(void*, size_t);
+size_t getPageSize(void);
+size_t getLargePageSize(void);
+size_t getAvailableMemory(void);
+size_t getFreeLargePagesMemory(void);
+void* allocDualMappedPages(size_t bytes, void** execView);
+void* allocDualMappedLargePages(size_t bytes, void** execView);
+void freeDualMappedPages(void* ptr, void* execView, size_t bytes);
+void* mapFileMemory(const char* path, size_t bytes, int writable);
+void unmapFileMemory(void*, size_t);
+void* mapSharedMemory(const char* name, size_t bytes, int create);
+int removeSharedMemory(const char* name);
+int bindMemoryToNode(void* ptr, size_t bytes, unsigned node);
+int getAllocationNode(void);
+int setAllocationNode(int node);
+int getLargePagesStatus(int* systemError);
 
 #ifdef __cplusplus
 }
@@ -39,6 +39,9 @@ namespace randomx {
 		if (!secureJit) {
 			compiler.enableAll(); //make JIT buffer both writable and executable
 		}
+		else {
+			compiler.enableDualMapping(); //W^X without changing page protection on every compilation
+		}
 	}
 
 	template<class Allocator, bool softAes, bool secureJit>
@@ -50,12 +53,15 @@ namespace randomx {
 	void CompiledVm<Allocator, softAes, secureJit>::run(void* seed) {
 		VmBase<Allocator, softAes>::generateProgram(seed);
 		randomx_vm::initialize();
-		if (secureJit) {
-			compiler.enableWriting();
-		}
-		compiler.generateProgram(program, config);
-		if (secureJit) {
-			compiler.enableExecution();
+		{
+			RANDOMX_STATS_PHASE(this, compile);
+			if (secureJit) {
+				compiler.enableWriting();
+			}
+			compiler.generateProgram(program, config);
+			if (secureJit) {
+				compiler.enableExecution();
+			}
 		}
 		mem.memory = datasetPtr->memory + datasetOffset;
 		execute();
@@ -63,6 +69,7 @@ namespace randomx {
 
 	template<class Allocator, bool softAes, bool secureJit>
 	void CompiledVm<Allocator, softAes, secureJit>::execute() {
+		RANDOMX_STATS_PHASE(this, execute);
 #ifdef __aarch64__
 		memcpy(reg.f, config.eMask, sizeof(config.eMask));
 #endif
@@ -52,6 +52,21 @@ namespace randomx {
 		CompiledVm();
 		void setDataset(randomx_dataset* dataset) override;
 		void run(void* seed) override;
+		void setPrefetchMode(bool datasetT0, bool scratchpadNextLine) override {
+			compiler.setPrefetchMode(datasetT0, scratchpadNextLine);
+		}
+		void setScheduling(bool enabled) override {
+			compiler.setScheduling(enabled);
+		}
+		void setBranchAlignment(bool enabled) override {
+			compiler.setBranchAlignment(enabled);
+		}
+		bool enableSharedCode() override {
+			return compiler.enableSharedCode(secureJit);
+		}
+		size_t getCodeSize() override {
+			return compiler.getCodeSize();
+		}
 
 		using VmBase<Allocator, softAes>::mem;
 		using VmBase<Allocator, softAes>::program;
@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "vm_compiled_interleaved.hpp"
+#include "intrin_portable.h"
+
+namespace randomx {
+
+	static_assert(sizeof(InterleavedLane) == 32, "Invalid alignment of struct randomx::InterleavedLane");
+
+	template<class Allocator, bool softAes>
+	void InterleavedLaneVm<Allocator, softAes>::setDataset(randomx_dataset* dataset) {
+		datasetPtr = dataset;
+	}
+
+	template<class Allocator, bool softAes>
+	void InterleavedLaneVm<Allocator, softAes>::run(void* seed) {
+		VmBase<Allocator, softAes>::generateProgram(seed);
+		randomx_vm::initialize();
+		mem.memory = datasetPtr->memory + datasetOffset;
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	CompiledInterleavedVm<Allocator, softAes, secureJit>::CompiledInterleavedVm(int laneCount) : laneCount(laneCount) {
+		if (!secureJit) {
+			interleavedCompiler.enableAll();
+		}
+		else {
+			interleavedCompiler.enableDualMapping(); //W^X without changing page protection on every compilation
+		}
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1] = new InterleavedLaneVm<Allocator, softAes>();
+		}
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	CompiledInterleavedVm<Allocator, softAes, secureJit>::~CompiledInterleavedVm() {
+		for (auto lane : lanes) {
+			delete lane;
+		}
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	void CompiledInterleavedVm<Allocator, softAes, secureJit>::allocate() {
+		CompiledVm<Allocator, softAes, secureJit>::allocate();
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1]->allocate();
+		}
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	void CompiledInterleavedVm<Allocator, softAes, secureJit>::setDataset(randomx_dataset* dataset) {
+		datasetPtr = dataset;
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1]->setDataset(dataset);
+		}
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	void CompiledInterleavedVm<Allocator, softAes, secureJit>::resetRoundingMode() {
+		randomx_vm::resetRoundingMode();
+		for (int i = 0; i < laneCount; ++i) {
+			laneState[i].mxcsr = rx_mxcsr_default;
+		}
+	}
+
+	template<class Allocator, bool softAes, bool secureJit>
+	void CompiledInterleavedVm<Allocator, softAes, secureJit>::runLanes() {
+		Program* programs[MaxInterleavedLanes];
+		ProgramConfiguration* configs[MaxInterleavedLanes];
+		VmBase<Allocator, softAes>::generateProgram(tempHash);
+		randomx_vm::initialize();
+		mem.memory = datasetPtr->memory + datasetOffset;
+		programs[0] = &program;
+		configs[0] = &config;
+		laneState[0].reg = &reg;
+		laneState[0].mem = &mem;
+		laneState[0].scratchpad = scratchpad;
+		for (int i = 1; i < laneCount; ++i) {
+			auto lane = lanes[i - 1];
+			lane->run(lane->tempHash);
+			programs[i] = &lane->program;
+			configs[i] = &lane->config;
+			laneState[i].reg = &lane->reg;
+			laneState[i].mem = &lane->mem;
+			laneState[i].scratchpad = lane->scratchpad;
+		}
+		{
+			RANDOMX_STATS_PHASE(this, compile);
+			if (secureJit) {
+				interleavedCompiler.enableWriting();
+			}
+			interleavedCompiler.generateProgramInterleaved(programs, configs, laneCount);
+			if (secureJit) {
+				interleavedCompiler.enableExecution();
+			}
+		}
+		RANDOMX_STATS_PHASE(this, execute);
+		interleavedCompiler.getInterleavedProgramFunc()(laneState, RANDOMX_PROGRAM_ITERATIONS);
+	}
+
+	template class CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, false, false>;
+	template class CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, true, false>;
+	template class CompiledInterleavedVm<LargePageAllocator, false, false>;
+	template class CompiledInterleavedVm<LargePageAllocator, true, false>;
+	template class CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, false, true>;
+	template class CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, true, true>;
+	template class CompiledInterleavedVm<LargePageAllocator, false, true>;
+	template class CompiledInterleavedVm<LargePageAllocator, true, true>;
+}
@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <new>
+#include <cstdint>
+#include "vm_compiled.hpp"
+
+namespace randomx {
+
+	template<class Allocator, bool softAes, bool secureJit>
+	class CompiledInterleavedVm;
+
+	//Holds the program, registers and scratchpad of one additional lane of a CompiledInterleavedVm.
+	//The lane doesn't execute on its own: run() only prepares the program for the next interleaved run.
+	template<class Allocator, bool softAes>
+	class InterleavedLaneVm : public VmBase<Allocator, softAes> {
+	public:
+		void* operator new(size_t size) {
+			void* ptr = AlignedAllocator<CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(InterleavedLaneVm));
+		}
+		void setDataset(randomx_dataset* dataset) override;
+		void run(void* seed) override;
+
+		using VmBase<Allocator, softAes>::mem;
+		using VmBase<Allocator, softAes>::datasetPtr;
+		using VmBase<Allocator, softAes>::datasetOffset;
+
+		template<class, bool, bool>
+		friend class CompiledInterleavedVm;
+	};
+
+	//Executes the programs of several hashes in lockstep on one thread. Each lane runs one loop iteration
+	//and then yields to the next lane, so the dataset read issued by one lane is in flight while the other
+	//lanes execute. Lane 0 is the VM itself, so the single-hash API keeps working.
+	template<class Allocator, bool softAes, bool secureJit>
+	class CompiledInterleavedVm : public CompiledVm<Allocator, softAes, secureJit> {
+	public:
+		void* operator new(size_t size) {
+			void* ptr = AlignedAllocator<CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(CompiledInterleavedVm));
+		}
+		CompiledInterleavedVm(int laneCount);
+		~CompiledInterleavedVm() override;
+		void allocate() override;
+		void setDataset(randomx_dataset* dataset) override;
+		void resetRoundingMode() override;
+		void runLanes() override;
+		int getLaneCount() const override {
+			return laneCount;
+		}
+		randomx_vm* getLane(int index) override {
+			if (index == 0)
+				return this;
+			return lanes[index - 1];
+		}
+		size_t getCodeSize() override {
+			return CompiledVm<Allocator, softAes, secureJit>::getCodeSize() + interleavedCompiler.getCodeSize();
+		}
+		bool enableSharedCode() override {
+			bool lane0 = CompiledVm<Allocator, softAes, secureJit>::enableSharedCode();
+			return interleavedCompiler.enableSharedCode(secureJit) && lane0;
+		}
+
+		using CompiledVm<Allocator, softAes, secureJit>::mem;
+		using CompiledVm<Allocator, softAes, secureJit>::program;
+		using CompiledVm<Allocator, softAes, secureJit>::config;
+		using CompiledVm<Allocator, softAes, secureJit>::reg;
+		using CompiledVm<Allocator, softAes, secureJit>::scratchpad;
+		using CompiledVm<Allocator, softAes, secureJit>::tempHash;
+		using CompiledVm<Allocator, softAes, secureJit>::datasetPtr;
+		using CompiledVm<Allocator, softAes, secureJit>::datasetOffset;
+	private:
+		JitCompiler interleavedCompiler;
+		InterleavedLaneVm<Allocator, softAes>* lanes[MaxInterleavedLanes - 1] = {};
+		InterleavedLane laneState[MaxInterleavedLanes];
+		int laneCount;
+	};
+
+	using CompiledInterleavedVmDefault = CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, true, false>;
+	using CompiledInterleavedVmHardAes = CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, false, false>;
+	using CompiledInterleavedVmLargePage = CompiledInterleavedVm<LargePageAllocator, true, false>;
+	using CompiledInterleavedVmLargePageHardAes = CompiledInterleavedVm<LargePageAllocator, false, false>;
+	using CompiledInterleavedVmDefaultSecure = CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, true, true>;
+	using CompiledInterleavedVmHardAesSecure = CompiledInterleavedVm<AlignedAllocator<CacheLineSize>, false, true>;
+	using CompiledInterleavedVmLargePageSecure = CompiledInterleavedVm<LargePageAllocator, true, true>;
+	using CompiledInterleavedVmLargePageHardAesSecure = CompiledInterleavedVm<LargePageAllocator, false, true>;
+}
@@ -29,13 +29,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vm_compiled_light.hpp"
 #include "common.hpp"
 #include <stdexcept>
+#include <cassert>
 
 namespace randomx {
 
 	template<class Allocator, bool softAes, bool secureJit>
 	void CompiledLightVm<Allocator, softAes, secureJit>::setCache(randomx_cache* cache) {
+		assert(!cache->isDrained());
 		cachePtr = cache;
 		mem.memory = cache->memory;
+		//reuse the SuperscalarHash code compiled by the cache if possible
+		if (cache->jit != nullptr && compiler.useSuperscalarHash(*cache->jit)) {
+			return;
+		}
 		if (secureJit) {
 			compiler.enableWriting();
 		}
@@ -49,12 +55,15 @@ namespace randomx {
 	void CompiledLightVm<Allocator, softAes, secureJit>::run(void* seed) {
 		VmBase<Allocator, softAes>::generateProgram(seed);
 		randomx_vm::initialize();
-		if (secureJit) {
-			compiler.enableWriting();
-		}
-		compiler.generateProgramLight(program, config, datasetOffset);
-		if (secureJit) {
-			compiler.enableExecution();
+		{
+			RANDOMX_STATS_PHASE(this, compile);
+			if (secureJit) {
+				compiler.enableWriting();
+			}
+			compiler.generateProgramLight(program, config, datasetOffset);
+			if (secureJit) {
+				compiler.enableExecution();
+			}
 		}
 		CompiledVm<Allocator, softAes, secureJit>::execute();
 	}
@@ -45,6 +45,10 @@ namespace randomx {
 		mem.memory = dataset->memory;
 	}
 
+	//The program is decoded right after it's generated. Decoding can't be moved ahead into a
+	//second bytecode buffer: the seed of each program is the hash of the registers after the
+	//previous one, and the seed of the first program of the next hash is only known when
+	//hashAndFill returns. Decoding takes about 0.4% of a hash in fast mode.
 	template<class Allocator, bool softAes>
 	void InterpretedVm<Allocator, softAes>::run(void* seed) {
 		VmBase<Allocator, softAes>::generateProgram(seed);
@@ -54,54 +58,72 @@ namespace randomx {
 
 	template<class Allocator, bool softAes>
 	void InterpretedVm<Allocator, softAes>::execute() {
+		{
+			RANDOMX_STATS_PHASE(this, compile);
+			beginExecution();
+		}
+		RANDOMX_STATS_PHASE(this, execute);
+
+		for(unsigned ic = 0; ic < RANDOMX_PROGRAM_ITERATIONS; ++ic) {
+			executeIteration();
+		}
+
+		endExecution();
+	}
 
-		NativeRegisterFile nreg;
+	template<class Allocator, bool softAes>
+	void InterpretedVm<Allocator, softAes>::beginExecution() {
+		nreg = NativeRegisterFile();
 
 		for(unsigned i = 0; i < RegisterCountFlt; ++i)
 			nreg.a[i] = rx_load_vec_f128(&reg.a[i].lo);
 
 		compileProgram(program, bytecode, nreg);
 
-		uint32_t spAddr0 = mem.mx;
-		uint32_t spAddr1 = mem.ma;
+		spAddr0 = mem.mx;
+		spAddr1 = mem.ma;
+	}
 
-		for(unsigned ic = 0; ic < RANDOMX_PROGRAM_ITERATIONS; ++ic) {
-			uint64_t spMix = nreg.r[config.readReg0] ^ nreg.r[config.readReg1];
-			spAddr0 ^= spMix;
-			spAddr0 &= ScratchpadL3Mask64;
-			spAddr1 ^= spMix >> 32;
-			spAddr1 &= ScratchpadL3Mask64;
-			
-			for (unsigned i = 0; i < RegistersCount; ++i)
-				nreg.r[i] ^= load64(scratchpad + spAddr0 + 8 * i);
+	template<class Allocator, bool softAes>
+	void InterpretedVm<Allocator, softAes>::executeIteration() {
+		uint64_t spMix = nreg.r[config.readReg0] ^ nreg.r[config.readReg1];
+		spAddr0 ^= spMix;
+		spAddr0 &= ScratchpadL3Mask64;
+		spAddr1 ^= spMix >> 32;
+		spAddr1 &= ScratchpadL3Mask64;
 
-			for (unsigned i = 0; i < RegisterCountFlt; ++i)
-				nreg.f[i] = rx_cvt_packed_int_vec_f128(scratchpad + spAddr1 + 8 * i);
+		for (unsigned i = 0; i < RegistersCount; ++i)
+			nreg.r[i] ^= load64(scratchpad + spAddr0 + 8 * i);
 
-			for (unsigned i = 0; i < RegisterCountFlt; ++i)
-				nreg.e[i] = maskRegisterExponentMantissa(config, rx_cvt_packed_int_vec_f128(scratchpad + spAddr1 + 8 * (RegisterCountFlt + i)));
+		for (unsigned i = 0; i < RegisterCountFlt; ++i)
+			nreg.f[i] = rx_cvt_packed_int_vec_f128(scratchpad + spAddr1 + 8 * i);
 
-			executeBytecode(bytecode, scratchpad, config);
+		for (unsigned i = 0; i < RegisterCountFlt; ++i)
+			nreg.e[i] = maskRegisterExponentMantissa(config, rx_cvt_packed_int_vec_f128(scratchpad + spAddr1 + 8 * (RegisterCountFlt + i)));
 
-			mem.mx ^= nreg.r[config.readReg2] ^ nreg.r[config.readReg3];
-			mem.mx &= CacheLineAlignMask;
-			datasetPrefetch(datasetOffset + mem.mx);
-			datasetRead(datasetOffset + mem.ma, nreg.r);
-			std::swap(mem.mx, mem.ma);
+		executeBytecode(bytecode, scratchpad, config);
 
-			for (unsigned i = 0; i < RegistersCount; ++i)
-				store64(scratchpad + spAddr1 + 8 * i, nreg.r[i]);
+		mem.mx ^= nreg.r[config.readReg2] ^ nreg.r[config.readReg3];
+		mem.mx &= CacheLineAlignMask;
+		datasetPrefetch(datasetOffset + mem.mx);
+		datasetRead(datasetOffset + mem.ma, nreg.r);
+		std::swap(mem.mx, mem.ma);
+
+		for (unsigned i = 0; i < RegistersCount; ++i)
+			store64(scratchpad + spAddr1 + 8 * i, nreg.r[i]);
 
-			for (unsigned i = 0; i < RegisterCountFlt; ++i)
-				nreg.f[i] = rx_xor_vec_f128(nreg.f[i], nreg.e[i]);
+		for (unsigned i = 0; i < RegisterCountFlt; ++i)
+			nreg.f[i] = rx_xor_vec_f128(nreg.f[i], nreg.e[i]);
 
-			for (unsigned i = 0; i < RegisterCountFlt; ++i)
-				rx_store_vec_f128((double*)(scratchpad + spAddr0 + 16 * i), nreg.f[i]);
+		for (unsigned i = 0; i < RegisterCountFlt; ++i)
+			rx_store_vec_f128((double*)(scratchpad + spAddr0 + 16 * i), nreg.f[i]);
 
-			spAddr0 = 0;
-			spAddr1 = 0;
-		}
+		spAddr0 = 0;
+		spAddr1 = 0;
+	}
 
+	template<class Allocator, bool softAes>
+	void InterpretedVm<Allocator, softAes>::endExecution() {
 		for (unsigned i = 0; i < RegistersCount; ++i)
 			store64(&reg.r[i], nreg.r[i]);
 
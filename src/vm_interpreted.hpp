@@ -38,6 +38,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace randomx {
 
+	template<class Allocator, bool softAes>
+	class InterpretedInterleavedVm;
+
 	template<class Allocator, bool softAes>
 	class InterpretedVm : public VmBase<Allocator, softAes>, public BytecodeMachine {
 	public:
@@ -64,8 +67,16 @@ namespace randomx {
 		virtual void datasetPrefetch(uint64_t blockNumber);
 	private:
 		void execute();
+		void beginExecution();
+		void executeIteration();
+		void endExecution();
 
 		InstructionByteCode bytecode[RANDOMX_PROGRAM_SIZE];
+		NativeRegisterFile nreg;
+		uint32_t spAddr0, spAddr1;
+
+		template<class, bool>
+		friend class InterpretedInterleavedVm;
 	};
 
 	using InterpretedVmDefault = InterpretedVm<AlignedAllocator<CacheLineSize>, true>;
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "vm_interpreted_interleaved.hpp"
+#include "intrin_portable.h"
+
+namespace randomx {
+
+	template<class Allocator, bool softAes>
+	InterpretedInterleavedVm<Allocator, softAes>::InterpretedInterleavedVm(int laneCount) : laneCount(laneCount) {
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1] = new InterpretedVm<Allocator, softAes>();
+		}
+	}
+
+	template<class Allocator, bool softAes>
+	InterpretedInterleavedVm<Allocator, softAes>::~InterpretedInterleavedVm() {
+		for (auto lane : lanes) {
+			delete lane;
+		}
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedInterleavedVm<Allocator, softAes>::allocate() {
+		InterpretedVm<Allocator, softAes>::allocate();
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1]->allocate();
+		}
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedInterleavedVm<Allocator, softAes>::setDataset(randomx_dataset* dataset) {
+		InterpretedVm<Allocator, softAes>::setDataset(dataset);
+		for (int i = 1; i < laneCount; ++i) {
+			lanes[i - 1]->setDataset(dataset);
+		}
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedInterleavedVm<Allocator, softAes>::resetRoundingMode() {
+		randomx_vm::resetRoundingMode();
+		const uint32_t defaultMode = rx_get_rounding_mode();
+		for (int i = 0; i < laneCount; ++i) {
+			roundingMode[i] = defaultMode;
+		}
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedInterleavedVm<Allocator, softAes>::runLanes() {
+		InterpretedVm<Allocator, softAes>* vms[MaxInterleavedLanes];
+		vms[0] = this;
+		for (int i = 1; i < laneCount; ++i) {
+			vms[i] = lanes[i - 1];
+		}
+		{
+			RANDOMX_STATS_PHASE(this, compile);
+			for (int i = 0; i < laneCount; ++i) {
+				vms[i]->VmBase<Allocator, softAes>::generateProgram(vms[i]->tempHash);
+				vms[i]->randomx_vm::initialize();
+				vms[i]->beginExecution();
+			}
+		}
+		RANDOMX_STATS_PHASE(this, execute);
+		//CFROUND changes the global floating point state, so each lane keeps its own rounding mode
+		for (unsigned ic = 0; ic < RANDOMX_PROGRAM_ITERATIONS; ++ic) {
+			for (int i = 0; i < laneCount; ++i) {
+				rx_set_rounding_mode(roundingMode[i]);
+				vms[i]->executeIteration();
+				roundingMode[i] = rx_get_rounding_mode();
+			}
+		}
+		for (int i = 0; i < laneCount; ++i) {
+			vms[i]->endExecution();
+		}
+	}
+
+	template class InterpretedInterleavedVm<AlignedAllocator<CacheLineSize>, false>;
+	template class InterpretedInterleavedVm<AlignedAllocator<CacheLineSize>, true>;
+	template class InterpretedInterleavedVm<LargePageAllocator, false>;
+	template class InterpretedInterleavedVm<LargePageAllocator, true>;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <new>
+#include <cstdint>
+#include "vm_interpreted.hpp"
+
+namespace randomx {
+
+	//Interprets the programs of several hashes in lockstep on one thread. Each lane runs one loop iteration
+	//and then yields to the next lane, so the dataset prefetch issued by one lane has a full iteration of
+	//every other lane to complete before it is read. Lane 0 is the VM itself, so the single-hash API keeps working.
+	template<class Allocator, bool softAes>
+	class InterpretedInterleavedVm : public InterpretedVm<Allocator, softAes> {
+	public:
+		void* operator new(size_t size) {
+			void* ptr = AlignedAllocator<CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(InterpretedInterleavedVm));
+		}
+		InterpretedInterleavedVm(int laneCount);
+		~InterpretedInterleavedVm() override;
+		void allocate() override;
+		void setDataset(randomx_dataset* dataset) override;
+		void resetRoundingMode() override;
+		void runLanes() override;
+		int getLaneCount() const override {
+			return laneCount;
+		}
+		randomx_vm* getLane(int index) override {
+			if (index == 0)
+				return this;
+			return lanes[index - 1];
+		}
+
+	private:
+		InterpretedVm<Allocator, softAes>* lanes[MaxInterleavedLanes - 1] = {};
+		uint32_t roundingMode[MaxInterleavedLanes];
+		int laneCount;
+	};
+
+	using InterpretedInterleavedVmDefault = InterpretedInterleavedVm<AlignedAllocator<CacheLineSize>, true>;
+	using InterpretedInterleavedVmHardAes = InterpretedInterleavedVm<AlignedAllocator<CacheLineSize>, false>;
+	using InterpretedInterleavedVmLargePage = InterpretedInterleavedVm<LargePageAllocator, true>;
+	using InterpretedInterleavedVmLargePageHardAes = InterpretedInterleavedVm<LargePageAllocator, false>;
+}
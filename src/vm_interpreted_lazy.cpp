@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include "vm_interpreted_lazy.hpp"
+#include "dataset.hpp"
+
+namespace randomx {
+
+	constexpr uint32_t MaxItemCount = DatasetSize / CacheLineSize;
+
+	template<class Allocator, bool softAes>
+	InterpretedLazyVm<Allocator, softAes>::InterpretedLazyVm(size_t itemCacheSize) {
+		itemCount = 1;
+		while (itemCount < MaxItemCount && 2 * itemCount * (uint64_t)CacheLineSize <= itemCacheSize)
+			itemCount *= 2;
+	}
+
+	template<class Allocator, bool softAes>
+	InterpretedLazyVm<Allocator, softAes>::~InterpretedLazyVm() {
+		if (items != nullptr)
+			Allocator::freeMemory(items, tableSize());
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLazyVm<Allocator, softAes>::allocate() {
+		InterpretedLightVm<Allocator, softAes>::allocate();
+		items = (uint8_t*)Allocator::allocMemory(tableSize());
+		tags = (uint32_t*)(items + itemCount * CacheLineSize);
+		memset(tags, 0, itemCount * sizeof(uint32_t));
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLazyVm<Allocator, softAes>::setCache(randomx_cache* cache) {
+		InterpretedLightVm<Allocator, softAes>::setCache(cache);
+		if (tags != nullptr)
+			memset(tags, 0, itemCount * sizeof(uint32_t));
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLazyVm<Allocator, softAes>::datasetRead(uint64_t address, int_reg_t(&r)[8]) {
+		uint32_t itemNumber = address / CacheLineSize;
+		uint32_t index = itemNumber & (itemCount - 1);
+		int_reg_t* rl = (int_reg_t*)(items + index * CacheLineSize);
+
+		if (tags[index] != itemNumber + 1) {
+			computeItem((uint8_t*)rl, itemNumber);
+			tags[index] = itemNumber + 1;
+		}
+
+		for (unsigned q = 0; q < 8; ++q)
+			r[q] ^= rl[q];
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLazyVm<Allocator, softAes>::datasetPrefetch(uint64_t address) {
+		uint32_t itemNumber = address / CacheLineSize;
+		if (helper != nullptr && tags[itemNumber & (itemCount - 1)] != itemNumber + 1)
+			helper->post(cachePtr, itemNumber);
+	}
+
+	template class InterpretedLazyVm<AlignedAllocator<CacheLineSize>, false>;
+	template class InterpretedLazyVm<AlignedAllocator<CacheLineSize>, true>;
+	template class InterpretedLazyVm<LargePageAllocator, false>;
+	template class InterpretedLazyVm<LargePageAllocator, true>;
+}
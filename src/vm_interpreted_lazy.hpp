@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <new>
+#include "vm_interpreted_light.hpp"
+
+namespace randomx {
+
+	//Light mode virtual machine that keeps recently generated dataset items in a direct-mapped table
+	template<class Allocator, bool softAes>
+	class InterpretedLazyVm : public InterpretedLightVm<Allocator, softAes> {
+	public:
+		using VmBase<Allocator, softAes>::cachePtr;
+		using InterpretedLightVm<Allocator, softAes>::helper;
+		using InterpretedLightVm<Allocator, softAes>::computeItem;
+		void* operator new(size_t size) {
+			void* ptr = AlignedAllocator<CacheLineSize>::allocMemory(size);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void operator delete(void* ptr) {
+			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(InterpretedLazyVm));
+		}
+		InterpretedLazyVm(size_t itemCacheSize);
+		~InterpretedLazyVm() override;
+		void allocate() override;
+		void setCache(randomx_cache* cache) override;
+		size_t getItemTableSize() const override {
+			return tableSize();
+		}
+	protected:
+		void datasetRead(uint64_t address, int_reg_t(&r)[8]) override;
+		void datasetPrefetch(uint64_t address) override;
+	private:
+		size_t tableSize() const {
+			return itemCount * (CacheLineSize + sizeof(uint32_t));
+		}
+		uint8_t* items = nullptr;
+		uint32_t* tags = nullptr; //item number + 1 of each table entry, 0 if the entry is empty
+		uint32_t itemCount;       //power of 2
+	};
+
+	using InterpretedLazyVmDefault = InterpretedLazyVm<AlignedAllocator<CacheLineSize>, true>;
+	using InterpretedLazyVmHardAes = InterpretedLazyVm<AlignedAllocator<CacheLineSize>, false>;
+	using InterpretedLazyVmLargePage = InterpretedLazyVm<LargePageAllocator, true>;
+	using InterpretedLazyVmLargePageHardAes = InterpretedLazyVm<LargePageAllocator, false>;
+}
@@ -28,11 +28,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "vm_interpreted_light.hpp"
 #include "dataset.hpp"
+#include <cassert>
+#include <system_error>
 
 namespace randomx {
 
+	template<class Allocator, bool softAes>
+	InterpretedLightVm<Allocator, softAes>::~InterpretedLightVm() {
+		delete helper;
+	}
+
 	template<class Allocator, bool softAes>
 	void InterpretedLightVm<Allocator, softAes>::setCache(randomx_cache* cache) {
+		assert(!cache->isDrained());
 		cachePtr = cache;
 		mem.memory = cache->memory;
 	}
@@ -42,12 +50,48 @@ namespace randomx {
 		uint32_t itemNumber = address / CacheLineSize;
 		int_reg_t rl[8];
 		
-		initDatasetItem(cachePtr, (uint8_t*)rl, itemNumber);
+		computeItem((uint8_t*)rl, itemNumber);
 
 		for (unsigned q = 0; q < 8; ++q)
 			r[q] ^= rl[q];
 	}
 
+	template<class Allocator, bool softAes>
+	void InterpretedLightVm<Allocator, softAes>::computeItem(uint8_t* out, uint32_t itemNumber) {
+		if (helper != nullptr)
+			helper->read(cachePtr, out, itemNumber);
+		else
+			readDatasetItem(cachePtr, out, itemNumber);
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLightVm<Allocator, softAes>::datasetPrefetch(uint64_t address) {
+		if (helper != nullptr)
+			helper->post(cachePtr, address / CacheLineSize);
+	}
+
+	template<class Allocator, bool softAes>
+	void InterpretedLightVm<Allocator, softAes>::run(void* seed) {
+		InterpretedVm<Allocator, softAes>::run(seed);
+		//the item posted in the last iteration is not read; the helper must not touch
+		//the cache after the program has finished (it can be released or reinitialized)
+		if (helper != nullptr)
+			helper->drain();
+	}
+
+	template<class Allocator, bool softAes>
+	bool InterpretedLightVm<Allocator, softAes>::enableItemHelper(int cpu) {
+		if (helper != nullptr)
+			return true;
+		try {
+			helper = new ItemHelper(cpu);
+		}
+		catch (std::system_error&) {
+			return false;
+		}
+		return true;
+	}
+
 	template class InterpretedLightVm<AlignedAllocator<CacheLineSize>, false>;
 	template class InterpretedLightVm<AlignedAllocator<CacheLineSize>, true>;
 	template class InterpretedLightVm<LargePageAllocator, false>;
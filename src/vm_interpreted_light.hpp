@@ -30,6 +30,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <new>
 #include "vm_interpreted.hpp"
+#include "item_helper.hpp"
 
 namespace randomx {
 
@@ -47,11 +48,16 @@ namespace randomx {
 		void operator delete(void* ptr) {
 			AlignedAllocator<CacheLineSize>::freeMemory(ptr, sizeof(InterpretedLightVm));
 		}
+		~InterpretedLightVm() override;
 		void setDataset(randomx_dataset* dataset) override { }
 		void setCache(randomx_cache* cache) override;
+		bool enableItemHelper(int cpu) override;
+		void run(void* seed) override;
 	protected:
 		void datasetRead(uint64_t address, int_reg_t(&r)[8]) override;
-		void datasetPrefetch(uint64_t address) override { }
+		void datasetPrefetch(uint64_t address) override;
+		void computeItem(uint8_t* out, uint32_t itemNumber);
+		ItemHelper* helper = nullptr;
 	};
 
 	using InterpretedLightVmDefault = InterpretedLightVm<AlignedAllocator<CacheLineSize>, true>;
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <new>
+#include <cassert>
+#include "vm_pool.hpp"
+
+randomx_vm_pool::randomx_vm_pool(randomx_flags flags, randomx_cache* cache, randomx_dataset* dataset, unsigned count)
+	: cache(cache), dataset(dataset) {
+	slots.reserve(count);
+	idleSlots.reserve(count);
+	for (unsigned i = 0; i < count; ++i) {
+		randomx_vm* vm = randomx_create_vm(flags, cache, dataset);
+		if (vm == nullptr) {
+			for (auto& slot : slots) {
+				randomx_destroy_vm(slot.vm);
+			}
+			throw std::bad_alloc();
+		}
+		slots.push_back({ vm, 0 });
+		idleSlots.push_back(i);
+	}
+}
+
+randomx_vm_pool::~randomx_vm_pool() {
+	for (auto& slot : slots) {
+		randomx_destroy_vm(slot.vm);
+	}
+}
+
+//Returns an idle virtual machine bound to the current cache and dataset. Virtual machines
+//are only rebound if the cache or the dataset was changed since their last use.
+randomx_vm* randomx_vm_pool::acquire(bool wait) {
+	Slot* slot;
+	uint32_t current;
+	randomx_cache* currentCache;
+	randomx_dataset* currentDataset;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (idleSlots.empty()) {
+			if (!wait)
+				return nullptr;
+			released.wait(lock);
+		}
+		slot = &slots[idleSlots.back()];
+		idleSlots.pop_back();
+		current = generation;
+		currentCache = cache;
+		currentDataset = dataset;
+	}
+	if (slot->generation != current) {
+		if (currentCache != nullptr)
+			randomx_vm_set_cache(slot->vm, currentCache);
+		if (currentDataset != nullptr)
+			randomx_vm_set_dataset(slot->vm, currentDataset);
+		slot->generation = current;
+	}
+	return slot->vm;
+}
+
+void randomx_vm_pool::release(randomx_vm* vm) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (unsigned i = 0; i < slots.size(); ++i) {
+		if (slots[i].vm == vm) {
+			idleSlots.push_back(i);
+			released.notify_one();
+			return;
+		}
+	}
+	assert(false); //the virtual machine doesn't belong to the pool
+}
+
+void randomx_vm_pool::setCache(randomx_cache* newCache) {
+	std::lock_guard<std::mutex> lock(mutex);
+	cache = newCache;
+	generation++;
+}
+
+void randomx_vm_pool::setDataset(randomx_dataset* newDataset) {
+	std::lock_guard<std::mutex> lock(mutex);
+	dataset = newDataset;
+	generation++;
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2018-2019, tevador <tevador@gmail.com>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+	* Redistributions of source code must retain the above copyright
+	  notice, this list of conditions and the following disclaimer.
+	* Redistributions in binary form must reproduce the above copyright
+	  notice, this list of conditions and the following disclaimer in the
+	  documentation and/or other materials provided with the distribution.
+	* Neither the name of the copyright holder nor the
+	  names of its contributors may be used to endorse or promote products
+	  derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "randomx.h"
+
+#if defined(RANDOMX_STATS)
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#elif !defined(__aarch64__)
+#include <chrono>
+#endif
+#endif
+
+namespace randomx {
+
+#if defined(RANDOMX_STATS)
+	//TSC on x86, the virtual counter on ARMv8 and nanoseconds elsewhere
+	inline uint64_t readCycleCounter() {
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t value;
+		asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+		return value;
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	//adds the cycles spent in the enclosing scope to a counter
+	class PhaseTimer {
+	public:
+		explicit PhaseTimer(uint64_t& counter) : counter(counter), start(readCycleCounter()) { }
+		~PhaseTimer() {
+			counter += readCycleCounter() - start;
+		}
+	private:
+		uint64_t& counter;
+		uint64_t start;
+	};
+
+#define RANDOMX_STATS_PHASE(machine, phase) randomx::PhaseTimer phaseTimer((machine)->stats.phase##Cycles)
+#define RANDOMX_STATS_COUNT(machine, counter, value) ((machine)->stats.counter += (value))
+#else
+#define RANDOMX_STATS_PHASE(machine, phase)
+#define RANDOMX_STATS_COUNT(machine, counter, value)
+#endif
+
+}